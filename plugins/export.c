@@ -26,11 +26,17 @@
 #endif
 
 #include <ctype.h>
+#include <errno.h>
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
 
 #include "geanyplugin.h"
 
 
+GeanyPlugin		*geany_plugin;
 GeanyData		*geany_data;
 GeanyFunctions	*geany_functions;
 
@@ -132,10 +138,10 @@ static gchar* get_tex_rgb(gint rgb_colour)
 }
 
 
-/* convert a style number (0..127) into a string representation (aa, ab, .., ba, bb, .., zy, zz) */
-static gchar *get_tex_style(gint style)
+/* convert a style number (0..127) into a string representation (aa, ab, .., ba, bb, .., zy, zz);
+ * buf must hold at least 4 bytes (no static buffer so it is usable from the worker thread) */
+static gchar *get_tex_style(gint style, gchar *buf)
 {
-	static gchar buf[4];
 	int i = 0;
 
 	do
@@ -271,18 +277,79 @@ static void on_menu_create_html_activate(GtkMenuItem *menuitem, gpointer user_da
 }
 
 
-static void write_data(const gchar *filename, const gchar *data)
+/* how much formatted output is collected before it is written to the file */
+#define EXPORT_CHUNK_SIZE 65536
+
+/* everything the worker thread needs to format and write the export; it only
+ * works on this snapshot and never touches Scintilla or the document */
+typedef struct
 {
-	gint error_nr = utils_write_file(filename, data);
-	gchar *utf8_filename = utils_get_utf8_from_locale(filename);
+	gchar *filename;		/* destination, in locale encoding */
+	gchar *utf8_filename;	/* destination, for the status message */
+	guchar *styled;			/* interleaved character/style byte pairs */
+	gint doc_len;
+	gint style_mask;
+	gboolean insert_line_numbers;
+	gint line_number_max_width;
+	gint tab_width;
+	gchar *header;			/* template part before the content, placeholders resolved */
+	gchar *footer;			/* template part after the content */
+	gint error;				/* errno of a failed write, 0 on success */
+} ExportJob;
+
+
+static void export_job_free(ExportJob *job)
+{
+	g_free(job->filename);
+	g_free(job->utf8_filename);
+	g_free(job->styled);
+	g_free(job->header);
+	g_free(job->footer);
+	g_free(job);
+}
 
-	if (error_nr == 0)
-		ui_set_statusbar(TRUE, _("Document successfully exported as '%s'."), utf8_filename);
-	else
-		ui_set_statusbar(TRUE, _("File '%s' could not be written (%s)."),
-			utf8_filename, g_strerror(error_nr));
 
-	g_free(utf8_filename);
+/* fetches the whole document with the style byte of each character in one
+ * message instead of two round trips per character */
+static guchar *get_styled_text(ScintillaObject *sci, gint doc_len)
+{
+	struct Sci_TextRange tr;
+	guchar *buffer = g_malloc((gsize) doc_len * 2 + 2);
+
+	tr.chrg.cpMin = 0;
+	tr.chrg.cpMax = doc_len;
+	tr.lpstrText = (gchar*) buffer;
+	scintilla_send_message(sci, SCI_GETSTYLEDTEXT, 0, (sptr_t) &tr);
+	return buffer;
+}
+
+
+/* writes the collected chunk out and resets it; remembers the first error */
+static void export_flush_chunk(FILE *fp, GString *chunk, ExportJob *job)
+{
+	if (job->error == 0 && chunk->len > 0 &&
+		fwrite(chunk->str, 1, chunk->len, fp) != chunk->len)
+		job->error = errno;
+	g_string_truncate(chunk, 0);
+}
+
+
+/* delivered on the main thread when an export finished or was cancelled */
+static void export_done(gpointer result, gpointer user_data, gboolean cancelled)
+{
+	ExportJob *job = result;
+
+	ui_progress_bar_stop();
+	if (! cancelled)
+	{
+		if (job->error == 0)
+			ui_set_statusbar(TRUE, _("Document successfully exported as '%s'."),
+				job->utf8_filename);
+		else
+			ui_set_statusbar(TRUE, _("File '%s' could not be written (%s)."),
+				job->utf8_filename, g_strerror(job->error));
+	}
+	export_job_free(job);
 }
 
 
@@ -361,51 +428,46 @@ static gint get_line_number_width(GeanyDocument *doc)
 }
 
 
-static void write_latex_file(GeanyDocument *doc, const gchar *filename,
-	gboolean use_zoom, gboolean insert_line_numbers)
+/* formats and writes the LaTeX export from the styled snapshot; runs in a
+ * worker thread */
+static gpointer export_latex_worker(gpointer data, gint *cancelled)
 {
-	GeanyEditor *editor = doc->editor;
-	ScintillaObject *sci = doc->editor->sci;
-	gint i, doc_len, style = -1, old_style = 0, column = 0;
-	gint k, line_number, line_number_width, line_number_max_width = 0, pad;
-	gchar c, c_next, *tmp, *date;
-	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
-	gint styles[STYLE_MAX + 1][MAX_TYPES];
-	gboolean block_open = FALSE;
+	ExportJob *job = data;
+	FILE *fp;
 	GString *body;
-	GString *cmds;
-	GString *latex;
-	gint style_max = pow(2, scintilla_send_message(sci, SCI_GETSTYLEBITS, 0, 0));
+	gint i, style = -1, old_style = 0, column = 0;
+	gint k, line_number = 1, line_number_width, pad;
+	gchar c, c_next, texbuf[4];
+	gboolean block_open = FALSE;
 
-	/* first read all styles from Scintilla */
-	for (i = 0; i < style_max; i++)
+	fp = g_fopen(job->filename, "wb");
+	if (fp == NULL)
 	{
-		styles[i][FORE] = scintilla_send_message(sci, SCI_STYLEGETFORE, i, 0);
-		styles[i][BACK] = scintilla_send_message(sci, SCI_STYLEGETBACK, i, 0);
-		styles[i][BOLD] = scintilla_send_message(sci, SCI_STYLEGETBOLD, i, 0);
-		styles[i][ITALIC] = scintilla_send_message(sci, SCI_STYLEGETITALIC, i, 0);
-		styles[i][USED] = 0;
+		job->error = errno;
+		return job;
 	}
+	body = g_string_sized_new(EXPORT_CHUNK_SIZE + 1024);
+	g_string_append(body, job->header);
 
-	if (insert_line_numbers)
-		line_number_max_width = get_line_number_width(doc);
-
-	/* read the document and write the LaTeX code */
-	body = g_string_new("");
-	doc_len = sci_get_length(sci);
-	for (i = 0; i < doc_len; i++)
+	for (i = 0; i < job->doc_len; i++)
 	{
-		style = sci_get_style_at(sci, i);
-		c = sci_get_char_at(sci, i);
-		c_next = sci_get_char_at(sci, i + 1);
+		if (body->len >= EXPORT_CHUNK_SIZE)
+		{
+			export_flush_chunk(fp, body, job);
+			if (job->error != 0 || g_atomic_int_get(cancelled))
+				break;
+		}
+
+		style = job->styled[2 * i + 1] & job->style_mask;
+		c = (gchar) job->styled[2 * i];
+		c_next = (i + 1 < job->doc_len) ? (gchar) job->styled[2 * (i + 1)] : 0;
 
 		/* line numbers */
-		if (insert_line_numbers && column == 0)
+		if (job->insert_line_numbers && column == 0)
 		{
-			line_number = sci_get_line_from_position(sci, i) + 1;
 			line_number_width = get_line_numbers_arity(line_number);
 			/* padding */
-			pad = line_number_max_width - line_number_width;
+			pad = job->line_number_max_width - line_number_width;
 			for (k = 0; k < pad; k++)
 			{
 				g_string_append(body, " ");
@@ -416,17 +478,13 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 		if (style != old_style || ! block_open)
 		{
 			old_style = style;
-			styles[style][USED] = 1;
 			if (block_open)
 			{
 				g_string_append(body, "}\n");
 				block_open = FALSE;
 			}
-			if (i < doc_len)
-			{
-				g_string_append_printf(body, "\\style%s{", get_tex_style(style));
-				block_open = TRUE;
-			}
+			g_string_append_printf(body, "\\style%s{", get_tex_style(style, texbuf));
+			block_open = TRUE;
 		}
 		/* escape the current character if necessary else just add it */
 		switch (c)
@@ -443,13 +501,13 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 					block_open = FALSE;
 				}
 				g_string_append(body, " \\\\\n");
+				line_number++;
 				column = -1;
 				break;
 			}
 			case '\t':
 			{
-				gint tab_width = sci_get_tab_width(editor->sci);
-				gint tab_stop = tab_width - (column % tab_width);
+				gint tab_stop = job->tab_width - (column % job->tab_width);
 
 				column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
 				g_string_append_printf(body, "\\hspace*{%dem}", tab_stop);
@@ -513,6 +571,53 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 		block_open = FALSE;
 	}
 
+	g_string_append(body, job->footer);
+	export_flush_chunk(fp, body, job);
+	g_string_free(body, TRUE);
+	fclose(fp);
+	/* don't leave a truncated file behind when the export was aborted */
+	if (job->error != 0 || g_atomic_int_get(cancelled))
+		g_unlink(job->filename);
+	return job;
+}
+
+
+static void write_latex_file(GeanyDocument *doc, const gchar *filename,
+	gboolean use_zoom, gboolean insert_line_numbers)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	gint i;
+	gchar *tmp, *date, *content, texbuf[4];
+	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
+	gint styles[STYLE_MAX + 1][MAX_TYPES];
+	GString *cmds;
+	GString *latex;
+	gint style_max = pow(2, scintilla_send_message(sci, SCI_GETSTYLEBITS, 0, 0));
+	ExportJob *job = g_new0(ExportJob, 1);
+
+	/* snapshot the document; the worker thread must not touch Scintilla */
+	job->doc_len = sci_get_length(sci);
+	job->styled = get_styled_text(sci, job->doc_len);
+	job->style_mask = style_max - 1;
+	job->tab_width = sci_get_tab_width(sci);
+	job->insert_line_numbers = insert_line_numbers;
+	if (insert_line_numbers)
+		job->line_number_max_width = get_line_number_width(doc);
+	job->filename = g_strdup(filename);
+	job->utf8_filename = utils_get_utf8_from_locale(filename);
+
+	/* first read all styles from Scintilla */
+	for (i = 0; i < style_max; i++)
+	{
+		styles[i][FORE] = scintilla_send_message(sci, SCI_STYLEGETFORE, i, 0);
+		styles[i][BACK] = scintilla_send_message(sci, SCI_STYLEGETBACK, i, 0);
+		styles[i][BOLD] = scintilla_send_message(sci, SCI_STYLEGETBOLD, i, 0);
+		styles[i][ITALIC] = scintilla_send_message(sci, SCI_STYLEGETITALIC, i, 0);
+		styles[i][USED] = 0;
+	}
+	/* mark every style occurring in the document as used */
+	for (i = 0; i < job->doc_len; i++)
+		styles[job->styled[2 * i + 1] & job->style_mask][USED] = 1;
 	/* force writing of style 0 (used at least for line breaks) */
 	styles[0][USED] = 1;
 
@@ -523,7 +628,7 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 		if (styles[i][USED])
 		{
 			g_string_append_printf(cmds,
-				"\\newcommand{\\style%s}[1]{\\noindent{", get_tex_style(i));
+				"\\newcommand{\\style%s}[1]{\\noindent{", get_tex_style(i, texbuf));
 			if (styles[i][BOLD])
 				g_string_append(cmds, "\\textbf{");
 			if (styles[i][ITALIC])
@@ -546,80 +651,66 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 	}
 
 	date = get_date(DATE_TYPE_DEFAULT);
-	/* write all */
+	/* resolve all placeholders but the content, which the worker streams
+	 * between the two template halves */
 	latex = g_string_new(TEMPLATE_LATEX);
-	utils_string_replace_all(latex, "{export_content}", body->str);
 	utils_string_replace_all(latex, "{export_styles}", cmds->str);
 	utils_string_replace_all(latex, "{export_date}", date);
 	utils_string_replace_all(latex, "{export_filename}", DOC_FILENAME(doc));
 
-	write_data(filename, latex->str);
+	content = strstr(latex->str, "{export_content}");
+	job->footer = g_strdup(content + strlen("{export_content}"));
+	g_string_truncate(latex, content - latex->str);
+	job->header = g_string_free(latex, FALSE);
 
-	g_string_free(body, TRUE);
 	g_string_free(cmds, TRUE);
-	g_string_free(latex, TRUE);
 	g_free(date);
+
+	ui_progress_bar_start(_("Exporting..."));
+	plugin_work_queue_push(geany_plugin, 0, export_latex_worker, export_done, job);
 }
 
 
-static void write_html_file(GeanyDocument *doc, const gchar *filename,
-	gboolean use_zoom, gboolean insert_line_numbers)
+/* formats and writes the HTML export from the styled snapshot; runs in a
+ * worker thread */
+static gpointer export_html_worker(gpointer data, gint *cancelled)
 {
-	GeanyEditor *editor = doc->editor;
-	ScintillaObject *sci = doc->editor->sci;
-	gint i, doc_len, style = -1, old_style = 0, column = 0;
-	gint k, line_number, line_number_width, line_number_max_width = 0, pad;
-	gchar c, c_next, *date, *doc_filename;
-	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
-	gint styles[STYLE_MAX + 1][MAX_TYPES];
-	gboolean span_open = FALSE;
-	const gchar *font_name;
-	gint font_size;
-	PangoFontDescription *font_desc;
+	ExportJob *job = data;
+	FILE *fp;
 	GString *body;
-	GString *css;
-	GString *html;
-	gint style_max = pow(2, scintilla_send_message(sci, SCI_GETSTYLEBITS, 0, 0));
+	gint i, style = -1, old_style = 0, column = 0;
+	gint k, line_number = 1, line_number_width, pad;
+	gchar c, c_next;
+	gboolean span_open = FALSE;
 
-	/* first read all styles from Scintilla */
-	for (i = 0; i < style_max; i++)
+	fp = g_fopen(job->filename, "wb");
+	if (fp == NULL)
 	{
-		styles[i][FORE] = ROTATE_RGB(scintilla_send_message(sci, SCI_STYLEGETFORE, i, 0));
-		styles[i][BACK] = ROTATE_RGB(scintilla_send_message(sci, SCI_STYLEGETBACK, i, 0));
-		styles[i][BOLD] = scintilla_send_message(sci, SCI_STYLEGETBOLD, i, 0);
-		styles[i][ITALIC] = scintilla_send_message(sci, SCI_STYLEGETITALIC, i, 0);
-		styles[i][USED] = 0;
+		job->error = errno;
+		return job;
 	}
+	body = g_string_sized_new(EXPORT_CHUNK_SIZE + 1024);
+	g_string_append(body, job->header);
 
-	/* read Geany's font and font size */
-	font_desc = pango_font_description_from_string(geany->interface_prefs->editor_font);
-	font_name = pango_font_description_get_family(font_desc);
-	/*font_size = pango_font_description_get_size(font_desc) / PANGO_SCALE;*/
-	/* take the zoom level also into account */
-	font_size = scintilla_send_message(sci, SCI_STYLEGETSIZE, 0, 0);
-	if (use_zoom)
-		font_size += scintilla_send_message(sci, SCI_GETZOOM, 0, 0);
-
-	if (insert_line_numbers)
-		line_number_max_width = get_line_number_width(doc);
-
-	/* read the document and write the HTML body */
-	body = g_string_new("");
-	doc_len = sci_get_length(sci);
-	for (i = 0; i < doc_len; i++)
+	for (i = 0; i < job->doc_len; i++)
 	{
-		style = sci_get_style_at(sci, i);
-		c = sci_get_char_at(sci, i);
-		/* sci_get_char_at() takes care of index boundaries and return 0 if i is too high */
-		c_next = sci_get_char_at(sci, i + 1);
+		if (body->len >= EXPORT_CHUNK_SIZE)
+		{
+			export_flush_chunk(fp, body, job);
+			if (job->error != 0 || g_atomic_int_get(cancelled))
+				break;
+		}
+
+		style = job->styled[2 * i + 1] & job->style_mask;
+		c = (gchar) job->styled[2 * i];
+		c_next = (i + 1 < job->doc_len) ? (gchar) job->styled[2 * (i + 1)] : 0;
 
 		/* line numbers */
-		if (insert_line_numbers && column == 0)
+		if (job->insert_line_numbers && column == 0)
 		{
-			line_number = sci_get_line_from_position(sci, i) + 1;
 			line_number_width = get_line_numbers_arity(line_number);
 			/* padding */
-			pad = line_number_max_width - line_number_width;
+			pad = job->line_number_max_width - line_number_width;
 			for (k = 0; k < pad; k++)
 			{
 				g_string_append(body, "&nbsp;");
@@ -630,16 +721,12 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 		if ((style != old_style || ! span_open) && ! isspace(c))
 		{
 			old_style = style;
-			styles[style][USED] = 1;
 			if (span_open)
 			{
 				g_string_append(body, "</span>");
 			}
-			if (i < doc_len)
-			{
-				g_string_append_printf(body, "<span class=\"style_%d\">", style);
-				span_open = TRUE;
-			}
+			g_string_append_printf(body, "<span class=\"style_%d\">", style);
+			span_open = TRUE;
 		}
 		/* escape the current character if necessary else just add it */
 		switch (c)
@@ -656,14 +743,14 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 					span_open = FALSE;
 				}
 				g_string_append(body, "<br />\n");
+				line_number++;
 				column = -1;
 				break;
 			}
 			case '\t':
 			{
 				gint j;
-				gint tab_width = sci_get_tab_width(editor->sci);
-				gint tab_stop = tab_width - (column % tab_width);
+				gint tab_stop = job->tab_width - (column % job->tab_width);
 
 				column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
 				for (j = 0; j < tab_stop; j++)
@@ -702,6 +789,70 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 		span_open = FALSE;
 	}
 
+	g_string_append(body, job->footer);
+	export_flush_chunk(fp, body, job);
+	g_string_free(body, TRUE);
+	fclose(fp);
+	/* don't leave a truncated file behind when the export was aborted */
+	if (job->error != 0 || g_atomic_int_get(cancelled))
+		g_unlink(job->filename);
+	return job;
+}
+
+
+static void write_html_file(GeanyDocument *doc, const gchar *filename,
+	gboolean use_zoom, gboolean insert_line_numbers)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	gint i;
+	gchar *date, *doc_filename, *content;
+	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
+	gint styles[STYLE_MAX + 1][MAX_TYPES];
+	const gchar *font_name;
+	gint font_size;
+	PangoFontDescription *font_desc;
+	GString *css;
+	GString *html;
+	gint style_max = pow(2, scintilla_send_message(sci, SCI_GETSTYLEBITS, 0, 0));
+	ExportJob *job = g_new0(ExportJob, 1);
+
+	/* snapshot the document; the worker thread must not touch Scintilla */
+	job->doc_len = sci_get_length(sci);
+	job->styled = get_styled_text(sci, job->doc_len);
+	job->style_mask = style_max - 1;
+	job->tab_width = sci_get_tab_width(sci);
+	job->insert_line_numbers = insert_line_numbers;
+	if (insert_line_numbers)
+		job->line_number_max_width = get_line_number_width(doc);
+	job->filename = g_strdup(filename);
+	job->utf8_filename = utils_get_utf8_from_locale(filename);
+
+	/* first read all styles from Scintilla */
+	for (i = 0; i < style_max; i++)
+	{
+		styles[i][FORE] = ROTATE_RGB(scintilla_send_message(sci, SCI_STYLEGETFORE, i, 0));
+		styles[i][BACK] = ROTATE_RGB(scintilla_send_message(sci, SCI_STYLEGETBACK, i, 0));
+		styles[i][BOLD] = scintilla_send_message(sci, SCI_STYLEGETBOLD, i, 0);
+		styles[i][ITALIC] = scintilla_send_message(sci, SCI_STYLEGETITALIC, i, 0);
+		styles[i][USED] = 0;
+	}
+	/* mark every style with a printable character as used; spans are only
+	 * opened on non-space characters */
+	for (i = 0; i < job->doc_len; i++)
+	{
+		if (! isspace((gchar) job->styled[2 * i]))
+			styles[job->styled[2 * i + 1] & job->style_mask][USED] = 1;
+	}
+
+	/* read Geany's font and font size */
+	font_desc = pango_font_description_from_string(geany->interface_prefs->editor_font);
+	font_name = pango_font_description_get_family(font_desc);
+	/*font_size = pango_font_description_get_size(font_desc) / PANGO_SCALE;*/
+	/* take the zoom level also into account */
+	font_size = scintilla_send_message(sci, SCI_STYLEGETSIZE, 0, 0);
+	if (use_zoom)
+		font_size += scintilla_send_message(sci, SCI_GETZOOM, 0, 0);
+
 	/* write used styles in the header */
 	css = g_string_new("");
 	g_string_append_printf(css,
@@ -722,21 +873,25 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 
 	date = get_date(DATE_TYPE_HTML);
 	doc_filename = g_markup_escape_text(DOC_FILENAME(doc), -1);
-	/* write all */
+	/* resolve all placeholders but the content, which the worker streams
+	 * between the two template halves */
 	html = g_string_new(TEMPLATE_HTML);
 	utils_string_replace_all(html, "{export_date}", date);
-	utils_string_replace_all(html, "{export_content}", body->str);
 	utils_string_replace_all(html, "{export_styles}", css->str);
 	utils_string_replace_all(html, "{export_filename}", doc_filename);
 
-	write_data(filename, html->str);
+	content = strstr(html->str, "{export_content}");
+	job->footer = g_strdup(content + strlen("{export_content}"));
+	g_string_truncate(html, content - html->str);
+	job->header = g_string_free(html, FALSE);
 
 	pango_font_description_free(font_desc);
-	g_string_free(body, TRUE);
 	g_string_free(css, TRUE);
-	g_string_free(html, TRUE);
 	g_free(doc_filename);
 	g_free(date);
+
+	ui_progress_bar_start(_("Exporting..."));
+	plugin_work_queue_push(geany_plugin, 0, export_html_worker, export_done, job);
 }
 
 
@@ -182,13 +182,12 @@ static gboolean check_filtered(const gchar *base_name)
 }
 
 
-/* name is in locale encoding */
-static void add_item(const gchar *name)
+/* name is in locale encoding; dir was determined when the directory was enumerated */
+static void add_item(const gchar *name, gboolean dir)
 {
 	GtkTreeIter iter;
 	gchar *fname, *utf8_name, *utf8_fullname;
 	const gchar *sep;
-	gboolean dir;
 
 	if (G_UNLIKELY(EMPTY(name)))
 		return;
@@ -196,7 +195,6 @@ static void add_item(const gchar *name)
 	/* root directory doesn't need separator */
 	sep = (utils_str_equal(current_dir, "/")) ? "" : G_DIR_SEPARATOR_S;
 	fname = g_strconcat(current_dir, sep, name, NULL);
-	dir = g_file_test(fname, G_FILE_TEST_IS_DIR);
 	utf8_fullname = utils_get_locale_from_utf8(fname);
 	utf8_name = utils_get_utf8_from_locale(name);
 	g_free(fname);
@@ -270,17 +268,174 @@ static void clear(void)
 }
 
 
+/* number of rows inserted into the store per main loop iteration */
+#define REFRESH_FILL_BATCH_SIZE 500
+
+typedef struct
+{
+	gchar *name;	/* in locale encoding */
+	gboolean dir;
+} RefreshEntry;
+
+/* a directory listing in flight; dir is the directory it was requested for so
+ * stale results can be dropped after navigating away */
+typedef struct
+{
+	gchar *dir;			/* in locale encoding */
+	GPtrArray *entries;	/* of RefreshEntry, sorted directories-first once enumerated */
+	guint fill_pos;		/* next entry to insert into the store */
+	guint task_id;		/* work queue id, to tell stale results from the current one */
+} RefreshJob;
+
+static guint refresh_task_id = 0;
+static guint refresh_fill_idle_id = 0;
+static RefreshJob *refresh_fill_job = NULL;
+
+
+static void refresh_job_free(RefreshJob *job)
+{
+	guint i;
+
+	for (i = 0; i < job->entries->len; i++)
+	{
+		RefreshEntry *entry = g_ptr_array_index(job->entries, i);
+
+		g_free(entry->name);
+		g_free(entry);
+	}
+	g_ptr_array_free(job->entries, TRUE);
+	g_free(job->dir);
+	g_free(job);
+}
+
+
+/* stop any enumeration or store fill still running for a previous directory */
+static void refresh_cancel(void)
+{
+	if (refresh_task_id > 0)
+	{
+		plugin_work_queue_cancel(geany_plugin, refresh_task_id);
+		refresh_task_id = 0;
+	}
+	if (refresh_fill_idle_id > 0)
+	{
+		g_source_remove(refresh_fill_idle_id);
+		refresh_fill_idle_id = 0;
+	}
+	if (refresh_fill_job != NULL)
+	{
+		refresh_job_free(refresh_fill_job);
+		refresh_fill_job = NULL;
+	}
+}
+
+
+static gint refresh_entry_compare(gconstpointer a, gconstpointer b)
+{
+	const RefreshEntry *ea = *(const RefreshEntry**) a;
+	const RefreshEntry *eb = *(const RefreshEntry**) b;
+
+	/* directories first, as in the old synchronous fill */
+	if (ea->dir != eb->dir)
+		return ea->dir ? -1 : 1;
+	return utils_str_casecmp(ea->name, eb->name);
+}
+
+
+/* runs in a worker thread; does the enumeration and the per-entry stat which
+ * stall for seconds on slow (network) file systems */
+static gpointer refresh_worker(gpointer data, gint *cancelled)
+{
+	RefreshJob *job = data;
+	GDir *dir;
+	const gchar *name;
+	/* root directory doesn't need separator */
+	const gchar *sep = (utils_str_equal(job->dir, "/")) ? "" : G_DIR_SEPARATOR_S;
+
+	dir = g_dir_open(job->dir, 0, NULL);
+	if (dir == NULL)
+		return job;
+
+	foreach_dir(name, dir)
+	{
+		RefreshEntry *entry;
+		gchar *fname;
+
+		if (g_atomic_int_get(cancelled))
+			break;
+
+		fname = g_strconcat(job->dir, sep, name, NULL);
+		entry = g_new(RefreshEntry, 1);
+		entry->name = g_strdup(name);
+		entry->dir = g_file_test(fname, G_FILE_TEST_IS_DIR);
+		g_free(fname);
+		g_ptr_array_add(job->entries, entry);
+	}
+	g_dir_close(dir);
+
+	g_ptr_array_sort(job->entries, refresh_entry_compare);
+	return job;
+}
+
+
+/* inserts a batch of entries per main loop iteration so huge directories don't
+ * stall the UI while the store fills */
+static gboolean refresh_fill_batch(gpointer data)
+{
+	RefreshJob *job = data;
+	guint end = MIN(job->fill_pos + REFRESH_FILL_BATCH_SIZE, job->entries->len);
+
+	for (; job->fill_pos < end; job->fill_pos++)
+	{
+		RefreshEntry *entry = g_ptr_array_index(job->entries, job->fill_pos);
+
+		add_item(entry->name, entry->dir);
+	}
+	if (job->fill_pos < job->entries->len)
+		return TRUE;
+
+	gtk_entry_completion_set_model(entry_completion, GTK_TREE_MODEL(file_store));
+	refresh_fill_idle_id = 0;
+	refresh_fill_job = NULL;
+	refresh_job_free(job);
+	return FALSE;
+}
+
+
+/* delivered on the main thread once the worker finished or was cancelled */
+static void refresh_done(gpointer result, gpointer user_data, gboolean cancelled)
+{
+	RefreshJob *job = result;
+
+	if (job->task_id == refresh_task_id)
+		refresh_task_id = 0;
+	/* drop stale results if the user navigated away while enumerating */
+	if (cancelled || ! utils_str_equal(job->dir, current_dir))
+	{
+		refresh_job_free(job);
+		return;
+	}
+
+	/* only now replace the old listing, so it stays usable during the load */
+	clear();
+	add_top_level_entry();	/* ".." item */
+
+	refresh_fill_job = job;
+	refresh_fill_idle_id = plugin_idle_add(geany_plugin, refresh_fill_batch, job);
+}
+
+
 /* recreate the tree model from current_dir. */
 static void refresh(void)
 {
 	gchar *utf8_dir;
-	GSList *list, *node;
+	RefreshJob *job;
 
 	/* don't clear when the new path doesn't exist */
 	if (! g_file_test(current_dir, G_FILE_TEST_EXISTS))
 		return;
 
-	clear();
+	refresh_cancel();
 
 	utf8_dir = utils_get_utf8_from_locale(current_dir);
 	gtk_entry_set_text(GTK_ENTRY(path_entry), utf8_dir);
@@ -288,22 +443,12 @@ static void refresh(void)
 	ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(path_combo), utf8_dir, 0);
 	g_free(utf8_dir);
 
-	add_top_level_entry();	/* ".." item */
-
-	list = utils_get_file_list(current_dir, NULL, NULL);
-	if (list != NULL)
-	{
-		/* free filenames as we go through the list */
-		foreach_slist(node, list)
-		{
-			gchar *fname = node->data;
-
-			add_item(fname);
-			g_free(fname);
-		}
-		g_slist_free(list);
-	}
-	gtk_entry_completion_set_model(entry_completion, GTK_TREE_MODEL(file_store));
+	job = g_new0(RefreshJob, 1);
+	job->dir = g_strdup(current_dir);
+	job->entries = g_ptr_array_new();
+	refresh_task_id = plugin_work_queue_push(geany_plugin, 0,
+		refresh_worker, refresh_done, job);
+	job->task_id = refresh_task_id;
 }
 
 
@@ -1285,6 +1430,7 @@ GtkWidget *plugin_configure(GtkDialog *dialog)
 
 void plugin_cleanup(void)
 {
+	refresh_cancel();
 	save_settings();
 
 	g_free(config_file);
@@ -34,6 +34,10 @@
 	geany_functions->p_plugin->plugin_idle_add
 #define plugin_builder_connect_signals \
 	geany_functions->p_plugin->plugin_builder_connect_signals
+#define plugin_work_queue_push \
+	geany_functions->p_plugin->plugin_work_queue_push
+#define plugin_work_queue_cancel \
+	geany_functions->p_plugin->plugin_work_queue_cancel
 #define document_new_file \
 	geany_functions->p_document->document_new_file
 #define document_get_current \
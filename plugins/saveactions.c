@@ -27,6 +27,8 @@
 #include "geanyplugin.h"
 #include "gtkcompat.h"
 
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <glib/gstdio.h>
@@ -47,7 +49,8 @@ enum
 {
 	NOTEBOOK_PAGE_AUTOSAVE = 0,
 	NOTEBOOK_PAGE_INSTANTSAVE,
-	NOTEBOOK_PAGE_BACKUPCOPY
+	NOTEBOOK_PAGE_BACKUPCOPY,
+	NOTEBOOK_PAGE_DELTASAVE
 };
 
 static struct
@@ -56,6 +59,7 @@ static struct
 	GtkWidget *checkbox_enable_autosave_losing_focus;
 	GtkWidget *checkbox_enable_instantsave;
 	GtkWidget *checkbox_enable_backupcopy;
+	GtkWidget *checkbox_enable_deltasave;
 
 	GtkWidget *autosave_interval_spin;
 	GtkWidget *autosave_print_msg_checkbox;
@@ -75,6 +79,7 @@ static gboolean enable_autosave;
 static gboolean enable_autosave_losing_focus;
 static gboolean enable_instantsave;
 static gboolean enable_backupcopy;
+static gboolean enable_deltasave;
 
 static gint autosave_interval;
 static gboolean autosave_print_msg;
@@ -87,6 +92,9 @@ static gchar *backupcopy_backup_dir; /* path to an existing directory in locale
 static gchar *backupcopy_time_fmt;
 static gint backupcopy_dir_levels;
 
+static gchar *deltasave_dir; /* directory holding the journals, in locale encoding */
+static GHashTable *deltasave_journals = NULL; /* doc id -> DeltaJournal */
+
 static gchar *config_file;
 
 
@@ -244,6 +252,286 @@ static void backupcopy_document_save_cb(GObject *obj, GeanyDocument *doc, gpoint
 }
 
 
+/* Differential Save: instead of rewriting the whole file on every autosave
+ * trigger, Scintilla's modification notifications are appended to a compact
+ * per-document journal below the plugin config dir. The journal is discarded
+ * on every real save and replayed on the next open if Geany crashed before
+ * one happened. */
+
+/* once the journal grows beyond this, it is compacted to one snapshot record */
+#define DELTASAVE_COMPACT_SIZE (1024 * 1024)
+
+typedef struct
+{
+	gchar *path;	/* journal file, in locale encoding */
+	FILE *fp;
+	gsize size;
+} DeltaJournal;
+
+
+static gchar *deltasave_get_journal_path(GeanyDocument *doc)
+{
+	gchar *name = g_uri_escape_string(doc->file_name, NULL, TRUE);
+	gchar *path = g_strconcat(deltasave_dir, G_DIR_SEPARATOR_S, name, ".journal", NULL);
+
+	g_free(name);
+	return path;
+}
+
+
+static void deltasave_journal_free(DeltaJournal *journal)
+{
+	if (journal->fp != NULL)
+		fclose(journal->fp);
+	g_free(journal->path);
+	g_free(journal);
+}
+
+
+/* removes the journal of doc from disk, e.g. after a real save made it obsolete */
+static void deltasave_discard(GeanyDocument *doc)
+{
+	DeltaJournal *journal = g_hash_table_lookup(deltasave_journals,
+		GUINT_TO_POINTER(doc->id));
+
+	if (journal != NULL)
+	{
+		g_unlink(journal->path);
+		g_hash_table_remove(deltasave_journals, GUINT_TO_POINTER(doc->id));
+	}
+}
+
+
+static DeltaJournal *deltasave_get_journal(GeanyDocument *doc)
+{
+	DeltaJournal *journal = g_hash_table_lookup(deltasave_journals,
+		GUINT_TO_POINTER(doc->id));
+
+	if (journal == NULL)
+	{
+		journal = g_new0(DeltaJournal, 1);
+		journal->path = deltasave_get_journal_path(doc);
+		journal->fp = g_fopen(journal->path, "wb");
+		if (journal->fp == NULL)
+		{
+			ui_set_statusbar(FALSE, _("Differential Save: Journal could not be written (%s)."),
+				g_strerror(errno));
+			deltasave_journal_free(journal);
+			return NULL;
+		}
+		g_hash_table_insert(deltasave_journals, GUINT_TO_POINTER(doc->id), journal);
+	}
+	return journal;
+}
+
+
+/* appends one record and flushes it so it survives a crash; data may be NULL
+ * for records without a payload (deletions) */
+static void deltasave_append(DeltaJournal *journal, const gchar *header,
+		const gchar *data, gsize len)
+{
+	fputs(header, journal->fp);
+	journal->size += strlen(header);
+	if (data != NULL)
+	{
+		fwrite(data, 1, len, journal->fp);
+		fputc('\n', journal->fp);
+		journal->size += len + 1;
+	}
+	fflush(journal->fp);
+}
+
+
+/* replaces the journal contents with a single snapshot of the whole document */
+static void deltasave_compact(GeanyDocument *doc, DeltaJournal *journal)
+{
+	gchar *text = sci_get_contents(doc->editor->sci, sci_get_length(doc->editor->sci) + 1);
+	gchar header[32];
+
+	fclose(journal->fp);
+	journal->fp = g_fopen(journal->path, "wb");
+	journal->size = 0;
+	if (journal->fp == NULL)
+	{
+		g_hash_table_remove(deltasave_journals, GUINT_TO_POINTER(doc->id));
+		g_free(text);
+		return;
+	}
+	g_snprintf(header, sizeof(header), "S %lu\n", (gulong) strlen(text));
+	deltasave_append(journal, header, text, strlen(text));
+	g_free(text);
+}
+
+
+static gboolean deltasave_editor_notify_cb(GObject *object, GeanyEditor *editor,
+		SCNotification *nt, gpointer data)
+{
+	GeanyDocument *doc = editor->document;
+	DeltaJournal *journal;
+	gchar header[48];
+
+	if (! enable_deltasave || doc->file_name == NULL || nt->nmhdr.code != SCN_MODIFIED)
+		return FALSE;
+	/* undo collection is disabled while a file is loaded or reloaded; those
+	 * buffer changes must not be journalled */
+	if (! scintilla_send_message(editor->sci, SCI_GETUNDOCOLLECTION, 0, 0))
+		return FALSE;
+
+	if (nt->modificationType & SC_MOD_INSERTTEXT)
+	{
+		journal = deltasave_get_journal(doc);
+		if (journal == NULL)
+			return FALSE;
+		g_snprintf(header, sizeof(header), "I %ld %ld\n",
+			(glong) nt->position, (glong) nt->length);
+		deltasave_append(journal, header, nt->text, nt->length);
+	}
+	else if (nt->modificationType & SC_MOD_DELETETEXT)
+	{
+		journal = deltasave_get_journal(doc);
+		if (journal == NULL)
+			return FALSE;
+		g_snprintf(header, sizeof(header), "D %ld %ld\n",
+			(glong) nt->position, (glong) nt->length);
+		deltasave_append(journal, header, NULL, 0);
+	}
+	else
+		return FALSE;
+
+	/* long editing sessions: fold the accumulated deltas into one snapshot */
+	if (journal->size > DELTASAVE_COMPACT_SIZE &&
+		journal->size > (gsize) sci_get_length(editor->sci))
+		deltasave_compact(doc, journal);
+
+	return FALSE;
+}
+
+
+/* replays a journal left over from a crashed session onto the freshly loaded
+ * document; returns FALSE when the journal was unreadable or malformed */
+static gboolean deltasave_replay(GeanyDocument *doc, const gchar *path)
+{
+	gchar *contents = NULL;
+	gsize length = 0;
+	const gchar *p, *end;
+	gboolean success = TRUE;
+
+	if (! g_file_get_contents(path, &contents, &length, NULL))
+		return FALSE;
+
+	sci_start_undo_action(doc->editor->sci);
+	p = contents;
+	end = contents + length;
+	while (p < end && success)
+	{
+		gchar type;
+		glong pos, len;
+		const gchar *eol = memchr(p, '\n', end - p);
+		gchar *text;
+
+		if (eol == NULL)
+			break;
+		switch (*p)
+		{
+			case 'S':
+				success = (sscanf(p, "%c %ld", &type, &len) == 2 &&
+					eol + 1 + len <= end);
+				if (success)
+				{
+					text = g_strndup(eol + 1, len);
+					sci_set_text(doc->editor->sci, text);
+					g_free(text);
+					p = eol + 1 + len + 1;	/* payload plus trailing newline */
+				}
+				break;
+			case 'I':
+				success = (sscanf(p, "%c %ld %ld", &type, &pos, &len) == 3 &&
+					eol + 1 + len <= end);
+				if (success)
+				{
+					text = g_strndup(eol + 1, len);
+					sci_insert_text(doc->editor->sci, pos, text);
+					g_free(text);
+					p = eol + 1 + len + 1;
+				}
+				break;
+			case 'D':
+				success = (sscanf(p, "%c %ld %ld", &type, &pos, &len) == 3);
+				if (success)
+				{
+					scintilla_send_message(doc->editor->sci, SCI_DELETERANGE, pos, len);
+					p = eol + 1;
+				}
+				break;
+			default:
+				success = FALSE;
+		}
+	}
+	sci_end_undo_action(doc->editor->sci);
+	g_free(contents);
+	return success;
+}
+
+
+static void deltasave_document_open_cb(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	gchar *path;
+
+	if (! enable_deltasave || doc->file_name == NULL)
+		return;
+
+	path = deltasave_get_journal_path(doc);
+	if (g_file_test(path, G_FILE_TEST_IS_REGULAR))
+	{
+		if (dialogs_show_question(
+			_("A differential save journal with unsaved changes for \"%s\" was found. "
+			  "This usually means Geany quit unexpectedly.\n"
+			  "Do you want to restore the unsaved changes?"), doc->file_name) &&
+			deltasave_replay(doc, path))
+		{
+			/* re-journal the restored state so another crash before the next
+			 * save doesn't lose it again */
+			DeltaJournal *journal;
+
+			g_unlink(path);
+			journal = deltasave_get_journal(doc);
+			if (journal != NULL)
+				deltasave_compact(doc, journal);
+		}
+		else
+			g_unlink(path);	/* declined or unreadable: don't offer it again */
+	}
+	g_free(path);
+}
+
+
+/* batch opens (session restore, multi-file open) announce all documents in one
+ * signal; check them for leftover journals in a single pass */
+static void deltasave_documents_opened_cb(GObject *obj, GPtrArray *docs, gpointer user_data)
+{
+	guint i;
+
+	if (! enable_deltasave)
+		return;
+
+	for (i = 0; i < docs->len; i++)
+		deltasave_document_open_cb(obj, g_ptr_array_index(docs, i), user_data);
+}
+
+
+static void deltasave_document_save_cb(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	/* the file on disk is current again, the deltas are obsolete */
+	deltasave_discard(doc);
+}
+
+
+static void deltasave_document_close_cb(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	deltasave_discard(doc);
+}
+
+
 static void instantsave_document_new_cb(GObject *obj, GeanyDocument *doc, gpointer user_data)
 {
     if (enable_instantsave && doc->file_name == NULL)
@@ -316,15 +604,49 @@ static gboolean on_document_focus_out(GObject *object, GeanyEditor *editor,
 }
 
 
+static gboolean auto_save(gpointer data);
+
+/* Re-arms the sleeping autosave timer as soon as a document becomes dirty */
+static gboolean autosave_editor_notify_cb(GObject *object, GeanyEditor *editor,
+		SCNotification *nt, gpointer data)
+{
+	if (nt->nmhdr.code == SCN_SAVEPOINTLEFT && enable_autosave && autosave_src_id == 0)
+		autosave_src_id = g_timeout_add(autosave_interval * 1000, (GSourceFunc) auto_save, NULL);
+
+	return FALSE;
+}
+
+
 PluginCallback plugin_callbacks[] =
 {
 	{ "document-new", (GCallback) &instantsave_document_new_cb, FALSE, NULL },
 	{ "document-save", (GCallback) &backupcopy_document_save_cb, FALSE, NULL },
 	{ "editor-notify", (GCallback) &on_document_focus_out, FALSE, NULL },
+	{ "document-open", (GCallback) &deltasave_document_open_cb, FALSE, NULL },
+	{ "documents-opened", (GCallback) &deltasave_documents_opened_cb, FALSE, NULL },
+	{ "document-save", (GCallback) &deltasave_document_save_cb, FALSE, NULL },
+	/* a reload restores the on-disk state, making the deltas obsolete too */
+	{ "document-reload", (GCallback) &deltasave_document_save_cb, FALSE, NULL },
+	{ "document-close", (GCallback) &deltasave_document_close_cb, FALSE, NULL },
+	{ "editor-notify", (GCallback) &deltasave_editor_notify_cb, FALSE, NULL },
+	{ "editor-notify", (GCallback) &autosave_editor_notify_cb, FALSE, NULL },
 	{ NULL, NULL, FALSE, NULL }
 };
 
 
+static gboolean any_document_changed(void)
+{
+	guint i;
+
+	foreach_document(i)
+	{
+		if (documents[i]->changed)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
 static gboolean auto_save(gpointer data)
 {
 	GeanyDocument *doc;
@@ -332,8 +654,13 @@ static gboolean auto_save(gpointer data)
 	gint i, max = gtk_notebook_get_n_pages(GTK_NOTEBOOK(geany->main_widgets->notebook));
 	gint saved_files = 0;
 
-	if (cur_doc == NULL)
-		return TRUE;
+	if (cur_doc == NULL || ! any_document_changed())
+	{
+		/* nothing to save: let the timer sleep until a document is modified
+		 * again, see autosave_editor_notify_cb() */
+		autosave_src_id = 0;
+		return FALSE;
+	}
 
 	if (autosave_save_all)
 	{
@@ -363,14 +690,22 @@ static gboolean auto_save(gpointer data)
 }
 
 
+/* (Re)arms the autosave timer, but only while there is something to save: the
+ * timer stops itself once every document is unchanged (see auto_save()) and is
+ * re-armed from the save point notification when a document becomes dirty
+ * again, so an idle Geany causes no periodic wakeups. */
 static void autosave_set_timeout(void)
 {
 	if (! enable_autosave)
 		return;
 
 	if (autosave_src_id != 0)
+	{
 		g_source_remove(autosave_src_id);
-	autosave_src_id = g_timeout_add(autosave_interval * 1000, (GSourceFunc) auto_save, NULL);
+		autosave_src_id = 0;
+	}
+	if (any_document_changed())
+		autosave_src_id = g_timeout_add(autosave_interval * 1000, (GSourceFunc) auto_save, NULL);
 }
 
 
@@ -392,6 +727,14 @@ void plugin_init(GeanyData *data)
 		config, "saveactions", "enable_instantsave", FALSE);
 	enable_backupcopy = utils_get_setting_boolean(
 		config, "saveactions", "enable_backupcopy", FALSE);
+	enable_deltasave = utils_get_setting_boolean(
+		config, "saveactions", "enable_deltasave", FALSE);
+
+	deltasave_dir = g_strconcat(geany->app->configdir, G_DIR_SEPARATOR_S, "plugins",
+		G_DIR_SEPARATOR_S, "saveactions", G_DIR_SEPARATOR_S, "journals", NULL);
+	utils_mkdir(deltasave_dir, TRUE);
+	deltasave_journals = g_hash_table_new_full(NULL, NULL, NULL,
+		(GDestroyNotify) deltasave_journal_free);
 
 	instantsave_default_ft = utils_get_setting_string(config, "instantsave", "default_ft",
 		filetypes[GEANY_FILETYPES_NONE]->name);
@@ -470,6 +813,8 @@ static void configure_response_cb(GtkDialog *dialog, gint response, G_GNUC_UNUSE
 			GTK_TOGGLE_BUTTON(pref_widgets.checkbox_enable_instantsave));
 		enable_backupcopy = gtk_toggle_button_get_active(
 			GTK_TOGGLE_BUTTON(pref_widgets.checkbox_enable_backupcopy));
+		enable_deltasave = gtk_toggle_button_get_active(
+			GTK_TOGGLE_BUTTON(pref_widgets.checkbox_enable_deltasave));
 
 		autosave_interval = gtk_spin_button_get_value_as_int(
 			GTK_SPIN_BUTTON(pref_widgets.autosave_interval_spin));
@@ -494,6 +839,7 @@ static void configure_response_cb(GtkDialog *dialog, gint response, G_GNUC_UNUSE
 		g_key_file_set_boolean(config, "saveactions", "enable_autosave_losing_focus", enable_autosave_losing_focus);
 		g_key_file_set_boolean(config, "saveactions", "enable_instantsave", enable_instantsave);
 		g_key_file_set_boolean(config, "saveactions", "enable_backupcopy", enable_backupcopy);
+		g_key_file_set_boolean(config, "saveactions", "enable_deltasave", enable_deltasave);
 
 		g_key_file_set_boolean(config, "autosave", "print_messages", autosave_print_msg);
 		g_key_file_set_boolean(config, "autosave", "save_all", autosave_save_all);
@@ -763,6 +1109,32 @@ GtkWidget *plugin_configure(GtkDialog *dialog)
 		gtk_box_pack_start(GTK_BOX(inner_vbox), hbox, FALSE, FALSE, 7);
 	}
 
+	/*
+	 * Differential Save
+	 */
+	{
+		notebook_vbox = gtk_vbox_new(FALSE, 2);
+		inner_vbox = gtk_vbox_new(FALSE, 5);
+		gtk_container_set_border_width(GTK_CONTAINER(inner_vbox), 5);
+		gtk_box_pack_start(GTK_BOX(notebook_vbox), inner_vbox, TRUE, TRUE, 5);
+		gtk_notebook_insert_page(GTK_NOTEBOOK(notebook),
+			notebook_vbox, gtk_label_new(_("Differential Save")), NOTEBOOK_PAGE_DELTASAVE);
+
+		checkbox_enable = gtk_check_button_new_with_mnemonic(_("_Enable"));
+		pref_widgets.checkbox_enable_deltasave = checkbox_enable;
+		gtk_button_set_focus_on_click(GTK_BUTTON(checkbox_enable), FALSE);
+		gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checkbox_enable), enable_deltasave);
+		gtk_box_pack_start(GTK_BOX(inner_vbox), checkbox_enable, FALSE, FALSE, 6);
+
+		label = gtk_label_new(
+			_("Records all buffer modifications in a journal inside the plugin "
+			  "configuration directory instead of rewriting the whole file, and "
+			  "offers to restore unsaved changes after a crash."));
+		gtk_label_set_line_wrap(GTK_LABEL(label), TRUE);
+		gtk_misc_set_alignment(GTK_MISC(label), 0, 0.5);
+		gtk_box_pack_start(GTK_BOX(inner_vbox), label, FALSE, FALSE, 0);
+	}
+
 	/* manually emit the toggled signal of the enable checkboxes to update the widget sensitivity */
 	g_signal_emit_by_name(pref_widgets.checkbox_enable_autosave, "toggled");
 	g_signal_emit_by_name(pref_widgets.checkbox_enable_instantsave, "toggled");
@@ -775,11 +1147,26 @@ GtkWidget *plugin_configure(GtkDialog *dialog)
 }
 
 
+static gboolean deltasave_remove_journal_file(gpointer key, gpointer value, gpointer data)
+{
+	DeltaJournal *journal = value;
+
+	g_unlink(journal->path);
+	return TRUE;
+}
+
+
 void plugin_cleanup(void)
 {
 	if (autosave_src_id != 0)
 		g_source_remove(autosave_src_id);
 
+	/* with the plugin unloaded nobody invalidates the journals on save any
+	 * more, so drop them instead of risking a stale replay on the next open */
+	g_hash_table_foreach_remove(deltasave_journals, deltasave_remove_journal_file, NULL);
+	g_hash_table_destroy(deltasave_journals);
+	g_free(deltasave_dir);
+
 	g_free(instantsave_default_ft);
 
 	g_free(backupcopy_backup_dir);
@@ -73,12 +73,13 @@ typedef struct EditWindow
 {
 	GeanyEditor		*editor;	/* original editor for split view */
 	ScintillaObject	*sci;		/* new editor widget */
+	GeanyFiletype	*file_type;	/* filetype the widget is currently styled for */
 	GtkWidget		*vbox;
 	GtkWidget		*name_label;
 }
 EditWindow;
 
-static EditWindow edit_window = {NULL, NULL, NULL, NULL};
+static EditWindow edit_window = {NULL, NULL, NULL, NULL, NULL};
 
 
 static void on_unsplit(GtkMenuItem *menuitem, gpointer user_data);
@@ -105,6 +106,483 @@ static void set_line_numbers(ScintillaObject * sci, gboolean set)
 }
 
 
+/* --- Compare mode -------------------------------------------------------
+ * Locks the split view to a different document and shows a line diff: lines
+ * without a counterpart in the other document get a coloured band in the
+ * marker margin, and both views scroll together through an alignment map.
+ * Line hashes are maintained incrementally from the document modification
+ * journal and the diff itself runs on the worker queue, so large documents
+ * are never re-read or re-diffed from scratch after a change. */
+
+enum
+{
+	/* markers 0/1 are used by the editor, the high numbers below the fold
+	 * markers are free */
+	MARKER_COMPARE_MINE = 20,	/* line has no counterpart in the split document */
+	MARKER_COMPARE_THEIRS = 21	/* line has no counterpart in the current document */
+};
+
+typedef struct CompareSide
+{
+	GeanyDocument	*doc;
+	GArray			*hashes;			/* one guint32 per line, EOL excluded */
+	gboolean		pending;			/* modified since the last rehash */
+	gint			pending_min_pos;	/* lowest modified byte position */
+	gint			pending_del_len;	/* bytes deleted since the last rehash */
+}
+CompareSide;
+
+static struct
+{
+	gboolean	active;
+	CompareSide	mine;		/* document shown in the main notebook */
+	CompareSide	theirs;		/* document shown in the split view */
+	GArray		*align;		/* per line of mine: counterpart line in theirs or -1 */
+	GArray		*align_rev;	/* the reverse mapping */
+	guint		journal_id;
+	guint		task_id;
+	guint		generation;	/* bumped whenever the hashes change */
+	guint		drain_idle_id;
+	gboolean	syncing;	/* re-entrancy guard for the scroll lock */
+	gboolean	toggle_guard;
+	GtkWidget	*toggle;
+}
+compare = {FALSE};
+
+typedef struct CompareJob
+{
+	guint	generation;
+	GArray	*a;	/* snapshots of the line hashes */
+	GArray	*b;
+}
+CompareJob;
+
+typedef struct CompareResult
+{
+	guint	generation;
+	GArray	*align;
+	guint8	*matched_b;	/* one flag per line of b */
+	guint	nb;
+}
+CompareResult;
+
+/* line counts in both tables while scanning the middle of the documents;
+ * lines unique on both sides anchor the alignment (Heckel's algorithm) */
+typedef struct CompareSymbol
+{
+	gint	ca, cb;
+	gint	la, lb;
+}
+CompareSymbol;
+
+
+/* (re)compute the line hashes of @a side from @a from_line to the end */
+static void compare_side_rehash(CompareSide *side, gint from_line)
+{
+	ScintillaObject *sci = side->doc->editor->sci;
+	const gchar *chars = (const gchar *) scintilla_send_message(sci,
+		SCI_GETCHARACTERPOINTER, 0, 0);
+	const gchar *p, *end = chars + sci_get_length(sci);
+	guint32 hash = 5381;
+
+	from_line = MIN(from_line, (gint) side->hashes->len);
+	g_array_set_size(side->hashes, from_line);
+	p = chars + sci_get_position_from_line(sci, from_line);
+	for (; p < end; p++)
+	{
+		if (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] != '\n')))
+		{
+			g_array_append_val(side->hashes, hash);
+			hash = 5381;
+		}
+		else if (*p != '\r')
+			hash = (hash << 5) + hash + (guchar) *p;
+	}
+	/* the line after the last EOL, possibly empty, as Scintilla counts it */
+	g_array_append_val(side->hashes, hash);
+}
+
+
+static void compare_side_init(CompareSide *side, GeanyDocument *doc)
+{
+	side->doc = doc;
+	side->hashes = g_array_new(FALSE, FALSE, sizeof(guint32));
+	side->pending = TRUE;
+	side->pending_min_pos = 0;
+	side->pending_del_len = 0;
+}
+
+
+static void compare_side_free(CompareSide *side)
+{
+	if (side->hashes != NULL)
+		g_array_free(side->hashes, TRUE);
+	side->hashes = NULL;
+	side->doc = NULL;
+}
+
+
+static gpointer compare_worker(gpointer user_data, gint *cancelled)
+{
+	CompareJob *job = user_data;
+	const guint32 *a = (const guint32 *) job->a->data;
+	const guint32 *b = (const guint32 *) job->b->data;
+	gint na = job->a->len, nb = job->b->len;
+	CompareResult *result = g_new0(CompareResult, 1);
+	GArray *align = g_array_sized_new(FALSE, FALSE, sizeof(gint), na);
+	guint8 *matched_b = g_malloc0(MAX(nb, 1));
+	GHashTable *table;
+	gint head = 0, tail = 0, i, j;
+
+	result->generation = job->generation;
+	g_array_set_size(align, na);
+	memset(align->data, 0xff, (gsize) na * sizeof(gint));	/* all -1 */
+
+	/* common head and tail */
+	while (head < na && head < nb && a[head] == b[head])
+	{
+		g_array_index(align, gint, head) = head;
+		matched_b[head] = 1;
+		head++;
+	}
+	while (tail < na - head && tail < nb - head && a[na - 1 - tail] == b[nb - 1 - tail])
+	{
+		g_array_index(align, gint, na - 1 - tail) = nb - 1 - tail;
+		matched_b[nb - 1 - tail] = 1;
+		tail++;
+	}
+
+	table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	for (i = head; i < na - tail; i++)
+	{
+		CompareSymbol *sym = g_hash_table_lookup(table, GUINT_TO_POINTER(a[i]));
+
+		if (sym == NULL)
+		{
+			sym = g_new0(CompareSymbol, 1);
+			g_hash_table_insert(table, GUINT_TO_POINTER(a[i]), sym);
+		}
+		sym->ca++;
+		sym->la = i;
+		if ((i & 0x3fff) == 0 && g_atomic_int_get(cancelled))
+			goto out;
+	}
+	for (j = head; j < nb - tail; j++)
+	{
+		CompareSymbol *sym = g_hash_table_lookup(table, GUINT_TO_POINTER(b[j]));
+
+		if (sym != NULL)
+		{
+			sym->cb++;
+			sym->lb = j;
+		}
+		if ((j & 0x3fff) == 0 && g_atomic_int_get(cancelled))
+			goto out;
+	}
+	/* anchor on lines unique in both documents */
+	for (i = head; i < na - tail; i++)
+	{
+		CompareSymbol *sym = g_hash_table_lookup(table, GUINT_TO_POINTER(a[i]));
+
+		if (sym->ca == 1 && sym->cb == 1)
+		{
+			g_array_index(align, gint, i) = sym->lb;
+			matched_b[sym->lb] = 1;
+		}
+	}
+	/* grow matched runs downwards, then upwards, from the anchors */
+	for (i = head; i < na - tail - 1; i++)
+	{
+		j = g_array_index(align, gint, i);
+		if (j >= 0 && j + 1 < nb - tail && g_array_index(align, gint, i + 1) < 0 &&
+			! matched_b[j + 1] && a[i + 1] == b[j + 1])
+		{
+			g_array_index(align, gint, i + 1) = j + 1;
+			matched_b[j + 1] = 1;
+		}
+	}
+	for (i = na - tail - 1; i > head; i--)
+	{
+		j = g_array_index(align, gint, i);
+		if (j > head && g_array_index(align, gint, i - 1) < 0 &&
+			! matched_b[j - 1] && a[i - 1] == b[j - 1])
+		{
+			g_array_index(align, gint, i - 1) = j - 1;
+			matched_b[j - 1] = 1;
+		}
+	}
+out:
+	g_hash_table_destroy(table);
+	result->align = align;
+	result->matched_b = matched_b;
+	result->nb = nb;
+	return result;
+}
+
+
+/* map a document line through the alignment: exact for matched lines, offset
+ * from the nearest preceding matched line otherwise */
+static gint compare_map_line(GArray *map, gint line)
+{
+	gint i;
+
+	if (map == NULL || map->len == 0)
+		return line;
+	line = MIN(line, (gint) map->len - 1);
+	for (i = line; i >= 0; i--)
+	{
+		gint target = g_array_index(map, gint, i);
+
+		if (target >= 0)
+			return target + (line - i);
+	}
+	return line;
+}
+
+
+static void compare_sync_scroll(ScintillaObject *from, ScintillaObject *to, GArray *map)
+{
+	gint line, target;
+
+	if (compare.syncing)
+		return;
+	compare.syncing = TRUE;
+	line = scintilla_send_message(from, SCI_DOCLINEFROMVISIBLE,
+		scintilla_send_message(from, SCI_GETFIRSTVISIBLELINE, 0, 0), 0);
+	target = compare_map_line(map, line);
+	scintilla_send_message(to, SCI_SETFIRSTVISIBLELINE,
+		scintilla_send_message(to, SCI_VISIBLEFROMDOCLINE, target, 0), 0);
+	compare.syncing = FALSE;
+}
+
+
+static void compare_task_done(gpointer result_p, gpointer user_data, gboolean cancelled)
+{
+	CompareResult *result = result_p;
+	CompareJob *job = user_data;
+	gboolean applied = FALSE;
+
+	g_array_free(job->a, TRUE);
+	g_array_free(job->b, TRUE);
+	g_free(job);
+
+	if (result != NULL && ! cancelled && compare.active &&
+		result->generation == compare.generation)
+	{
+		ScintillaObject *mine_sci = compare.mine.doc->editor->sci;
+		ScintillaObject *theirs_sci = compare.theirs.doc->editor->sci;
+		guint i;
+
+		compare.task_id = 0;
+		if (compare.align != NULL)
+			g_array_free(compare.align, TRUE);
+		if (compare.align_rev != NULL)
+			g_array_free(compare.align_rev, TRUE);
+		compare.align = result->align;
+		compare.align_rev = g_array_sized_new(FALSE, FALSE, sizeof(gint), result->nb);
+		g_array_set_size(compare.align_rev, result->nb);
+		memset(compare.align_rev->data, 0xff, (gsize) result->nb * sizeof(gint));
+
+		scintilla_send_message(mine_sci, SCI_MARKERDELETEALL, MARKER_COMPARE_MINE, 0);
+		for (i = 0; i < compare.align->len; i++)
+		{
+			gint target = g_array_index(compare.align, gint, i);
+
+			if (target < 0)
+				scintilla_send_message(mine_sci, SCI_MARKERADD, i, MARKER_COMPARE_MINE);
+			else
+				g_array_index(compare.align_rev, gint, target) = i;
+		}
+		scintilla_send_message(theirs_sci, SCI_MARKERDELETEALL, MARKER_COMPARE_THEIRS, 0);
+		for (i = 0; i < result->nb; i++)
+		{
+			if (! result->matched_b[i])
+				scintilla_send_message(theirs_sci, SCI_MARKERADD, i, MARKER_COMPARE_THEIRS);
+		}
+		compare_sync_scroll(mine_sci, edit_window.sci, compare.align);
+		applied = TRUE;
+	}
+	if (result != NULL)
+	{
+		if (! applied)
+			g_array_free(result->align, TRUE);
+		g_free(result->matched_b);
+		g_free(result);
+	}
+}
+
+
+/* rehash what changed since the last run and queue a new diff */
+static void compare_schedule(void)
+{
+	CompareSide *sides[2] = { &compare.mine, &compare.theirs };
+	CompareJob *job;
+	gint s;
+
+	for (s = 0; s < 2; s++)
+	{
+		CompareSide *side = sides[s];
+
+		if (side->pending)
+		{
+			/* journalled positions may have been shifted by later edits;
+			 * the lowest recorded position minus everything deleted since is
+			 * a safe lower bound for the first stale line */
+			gint pos = MAX(0, side->pending_min_pos - side->pending_del_len);
+
+			compare_side_rehash(side,
+				sci_get_line_from_position(side->doc->editor->sci, pos));
+			side->pending = FALSE;
+			side->pending_del_len = 0;
+		}
+	}
+	compare.generation++;
+	if (compare.task_id != 0)
+		plugin_work_queue_cancel(geany_plugin, compare.task_id);
+	job = g_new0(CompareJob, 1);
+	job->generation = compare.generation;
+	job->a = g_array_sized_new(FALSE, FALSE, sizeof(guint32), compare.mine.hashes->len);
+	g_array_append_vals(job->a, compare.mine.hashes->data, compare.mine.hashes->len);
+	job->b = g_array_sized_new(FALSE, FALSE, sizeof(guint32), compare.theirs.hashes->len);
+	g_array_append_vals(job->b, compare.theirs.hashes->data, compare.theirs.hashes->len);
+	compare.task_id = plugin_work_queue_push(geany_plugin, 0,
+		compare_worker, compare_task_done, job);
+}
+
+
+static void compare_journal_record(const GeanyDocModification *mod, gpointer user_data)
+{
+	CompareSide *side = NULL;
+
+	if (compare.mine.doc != NULL && mod->doc_id == compare.mine.doc->id)
+		side = &compare.mine;
+	else if (compare.theirs.doc != NULL && mod->doc_id == compare.theirs.doc->id)
+		side = &compare.theirs;
+	if (side == NULL)
+		return;
+	if (! side->pending || mod->position < side->pending_min_pos)
+		side->pending_min_pos = mod->position;
+	if (mod->modification_type & SC_MOD_DELETETEXT)
+		side->pending_del_len += mod->length;
+	side->pending = TRUE;
+}
+
+
+static gboolean compare_drain_idle(gpointer data)
+{
+	compare.drain_idle_id = 0;
+	if (! compare.active)
+		return FALSE;
+	if (! plugin_doc_journal_read(geany_plugin, compare.journal_id,
+			compare_journal_record, NULL))
+	{
+		/* lagged past the journal cap, rebuild both sides from scratch */
+		compare.mine.pending = TRUE;
+		compare.mine.pending_min_pos = 0;
+		compare.mine.pending_del_len = 0;
+		compare.theirs.pending = TRUE;
+		compare.theirs.pending_min_pos = 0;
+		compare.theirs.pending_del_len = 0;
+	}
+	if (compare.mine.pending || compare.theirs.pending)
+		compare_schedule();
+	return FALSE;
+}
+
+
+static void compare_define_markers(ScintillaObject *sci)
+{
+	scintilla_send_message(sci, SCI_MARKERDEFINE, MARKER_COMPARE_MINE, SC_MARK_LEFTRECT);
+	scintilla_send_message(sci, SCI_MARKERSETBACK, MARKER_COMPARE_MINE, 0x5050d0);
+	scintilla_send_message(sci, SCI_MARKERDEFINE, MARKER_COMPARE_THEIRS, SC_MARK_LEFTRECT);
+	scintilla_send_message(sci, SCI_MARKERSETBACK, MARKER_COMPARE_THEIRS, 0x50c050);
+}
+
+
+static void compare_disable(void)
+{
+	if (! compare.active)
+		return;
+	compare.active = FALSE;
+	if (compare.task_id != 0)
+	{
+		plugin_work_queue_cancel(geany_plugin, compare.task_id);
+		compare.task_id = 0;
+	}
+	if (compare.drain_idle_id != 0)
+	{
+		g_source_remove(compare.drain_idle_id);
+		compare.drain_idle_id = 0;
+	}
+	plugin_doc_journal_unsubscribe(geany_plugin, compare.journal_id);
+	if (DOC_VALID(compare.mine.doc))
+		scintilla_send_message(compare.mine.doc->editor->sci,
+			SCI_MARKERDELETEALL, MARKER_COMPARE_MINE, 0);
+	if (DOC_VALID(compare.theirs.doc))
+		scintilla_send_message(compare.theirs.doc->editor->sci,
+			SCI_MARKERDELETEALL, MARKER_COMPARE_THEIRS, 0);
+	compare_side_free(&compare.mine);
+	compare_side_free(&compare.theirs);
+	if (compare.align != NULL)
+		g_array_free(compare.align, TRUE);
+	compare.align = NULL;
+	if (compare.align_rev != NULL)
+		g_array_free(compare.align_rev, TRUE);
+	compare.align_rev = NULL;
+	if (edit_window.sci != NULL)
+		gtk_widget_set_can_focus(GTK_WIDGET(edit_window.sci), TRUE);
+	if (compare.toggle != NULL)
+	{
+		compare.toggle_guard = TRUE;
+		gtk_toggle_tool_button_set_active(GTK_TOGGLE_TOOL_BUTTON(compare.toggle), FALSE);
+		compare.toggle_guard = FALSE;
+	}
+}
+
+
+static gboolean compare_enable(void)
+{
+	GeanyDocument *mine = document_get_current();
+	GeanyDocument *theirs = edit_window.editor != NULL ? edit_window.editor->document : NULL;
+
+	if (mine == NULL || theirs == NULL || mine == theirs)
+	{
+		ui_set_statusbar(FALSE,
+			_("Select a different document in the split view to compare with."));
+		return FALSE;
+	}
+	compare_side_init(&compare.mine, mine);
+	compare_side_init(&compare.theirs, theirs);
+	compare_define_markers(mine->editor->sci);
+	compare_define_markers(theirs->editor->sci);
+	compare_define_markers(edit_window.sci);
+	compare.journal_id = plugin_doc_journal_subscribe(geany_plugin);
+	/* the split view only follows in compare mode, it takes no input */
+	gtk_widget_set_can_focus(GTK_WIDGET(edit_window.sci), FALSE);
+	compare.active = TRUE;
+	compare_schedule();
+	return TRUE;
+}
+
+
+static void on_compare_toggled(GtkToggleToolButton *button, gpointer user_data)
+{
+	if (compare.toggle_guard)
+		return;
+	if (gtk_toggle_tool_button_get_active(button))
+	{
+		if (! compare_enable())
+		{
+			compare.toggle_guard = TRUE;
+			gtk_toggle_tool_button_set_active(button, FALSE);
+			compare.toggle_guard = FALSE;
+		}
+	}
+	else
+		compare_disable();
+}
+
+
 static void on_sci_notify(ScintillaObject *sci, gint param,
 		SCNotification *nt, gpointer data)
 {
@@ -135,21 +613,56 @@ static void on_sci_notify(ScintillaObject *sci, gint param,
 			}
 			break;
 
+		case SCN_UPDATEUI:
+			/* the split view drives the main view while comparing */
+			if (compare.active && (nt->updated & SC_UPDATE_V_SCROLL))
+				compare_sync_scroll(sci, compare.mine.doc->editor->sci, compare.align_rev);
+			break;
+
 		default: break;
 	}
 }
 
 
+static gboolean on_editor_notify(GObject *obj, GeanyEditor *editor,
+		SCNotification *nt, gpointer data)
+{
+	if (! compare.active)
+		return FALSE;
+	if (nt->nmhdr.code == SCN_MODIFIED &&
+		(nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) &&
+		(editor->document == compare.mine.doc || editor->document == compare.theirs.doc))
+	{
+		/* drain the modification journal and re-diff from an idle handler so
+		 * a burst of changes is picked up in one go */
+		if (compare.drain_idle_id == 0)
+			compare.drain_idle_id = plugin_idle_add(geany_plugin, compare_drain_idle, NULL);
+	}
+	else if (nt->nmhdr.code == SCN_UPDATEUI && (nt->updated & SC_UPDATE_V_SCROLL) &&
+		editor->document == compare.mine.doc)
+		compare_sync_scroll(editor->sci, edit_window.sci, compare.align);
+	return FALSE;
+}
+
+
 static void sync_to_current(ScintillaObject *sci, ScintillaObject *current)
 {
 	gpointer sdoc;
 	gint pos;
 
-	/* set the new sci widget to view the existing Scintilla document */
+	/* point the split widget at the same Scintilla document: text, styling,
+	 * fold levels and markers are all shared then, only viewport state
+	 * (scrolling, caret, fold contraction) is per view */
 	sdoc = (gpointer) scintilla_send_message(current, SCI_GETDOCPOINTER, 0, 0);
 	scintilla_send_message(sci, SCI_SETDOCPOINTER, 0, (sptr_t) sdoc);
 
-	highlighting_set_styles(sci, edit_window.editor->document->file_type);
+	/* the style definitions are per widget; only reload them when the
+	 * filetype actually changed */
+	if (edit_window.file_type != edit_window.editor->document->file_type)
+	{
+		edit_window.file_type = edit_window.editor->document->file_type;
+		highlighting_set_styles(sci, edit_window.file_type);
+	}
 	pos = sci_get_current_position(current);
 	sci_set_current_position(sci, pos, TRUE);
 
@@ -165,24 +678,30 @@ static void sync_to_current(ScintillaObject *sci, ScintillaObject *current)
 
 static void set_editor(EditWindow *editwin, GeanyEditor *editor)
 {
-	editwin->editor = editor;
+	/* re-pointing the split view ends a comparison against the old document */
+	if (compare.active && editor->document != compare.theirs.doc)
+		compare_disable();
 
-	/* first destroy any widget, otherwise its signals will have an
-	 * invalid document as user_data */
-	if (editwin->sci != NULL)
-		gtk_widget_destroy(GTK_WIDGET(editwin->sci));
+	editwin->editor = editor;
 
-	editwin->sci = editor_create_widget(editor);
-	gtk_widget_show(GTK_WIDGET(editwin->sci));
-	gtk_box_pack_start(GTK_BOX(editwin->vbox), GTK_WIDGET(editwin->sci), TRUE, TRUE, 0);
+	/* the widget is created once and then re-pointed at the current document;
+	 * editor_create_widget() doesn't connect any editor-bound signals for
+	 * split widgets, so it is safe to keep it across document switches and we
+	 * don't rebuild the view (and its caches) on every switch */
+	if (editwin->sci == NULL)
+	{
+		editwin->sci = editor_create_widget(editor);
+		gtk_widget_show(GTK_WIDGET(editwin->sci));
+		gtk_box_pack_start(GTK_BOX(editwin->vbox), GTK_WIDGET(editwin->sci), TRUE, TRUE, 0);
+
+		scintilla_send_message(editwin->sci, SCI_USEPOPUP, 1, 0);
+		/* for margin events */
+		g_signal_connect(editwin->sci, "sci-notify",
+				G_CALLBACK(on_sci_notify), NULL);
+	}
 
 	sync_to_current(editwin->sci, editor->sci);
 
-	scintilla_send_message(editwin->sci, SCI_USEPOPUP, 1, 0);
-	/* for margin events */
-	g_signal_connect(editwin->sci, "sci-notify",
-			G_CALLBACK(on_sci_notify), NULL);
-
 	gtk_label_set_text(GTK_LABEL(editwin->name_label), DOC_FILENAME(editor->document));
 }
 
@@ -278,6 +797,14 @@ static GtkWidget *create_toolbar(void)
 	gtk_menu_tool_button_set_menu(GTK_MENU_TOOL_BUTTON(tool_item), item);
 	g_signal_connect(item, "show", G_CALLBACK(on_doc_menu_show), NULL);
 
+	tool_item = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_FIND_AND_REPLACE);
+	item = (GtkWidget*)tool_item;
+	gtk_widget_set_tooltip_text(item, _("Compare the document in this view "
+		"with the current document"));
+	gtk_container_add(GTK_CONTAINER(toolbar), item);
+	g_signal_connect(item, "toggled", G_CALLBACK(on_compare_toggled), NULL);
+	compare.toggle = item;
+
 	tool_item = gtk_tool_item_new();
 	gtk_tool_item_set_expand(tool_item, TRUE);
 	gtk_container_add(GTK_CONTAINER(toolbar), GTK_WIDGET(tool_item));
@@ -360,12 +887,16 @@ static void on_unsplit(GtkMenuItem *menuitem, gpointer user_data)
 
 	g_return_if_fail(edit_window.editor);
 
+	compare_disable();
+
 	g_object_ref(notebook);
 	gtk_container_remove(GTK_CONTAINER(pane), notebook);
 
 	gtk_widget_destroy(pane);
 	edit_window.editor = NULL;
 	edit_window.sci = NULL;
+	compare.toggle = NULL;
+	edit_window.file_type = NULL;
 
 	gtk_container_add(GTK_CONTAINER(parent), notebook);
 	g_object_unref(notebook);
@@ -454,6 +985,8 @@ static gboolean do_select_current(gpointer data)
 
 static void on_document_close(GObject *obj, GeanyDocument *doc, gpointer user_data)
 {
+	if (compare.active && (doc == compare.mine.doc || doc == compare.theirs.doc))
+		compare_disable();
 	if (doc->editor == edit_window.editor)
 	{
 		/* select current or unsplit in IDLE time, so the tab has changed */
@@ -479,11 +1012,22 @@ static void on_document_filetype_set(GObject *obj, GeanyDocument *doc,
 }
 
 
+static void on_document_activate(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	/* the comparison is bound to the document that was current when it was
+	 * started; switching tabs ends it */
+	if (compare.active && doc != compare.mine.doc)
+		compare_disable();
+}
+
+
 PluginCallback plugin_callbacks[] =
 {
 	{ "document-close", (GCallback) &on_document_close, FALSE, NULL },
 	{ "document-save", (GCallback) &on_document_save, FALSE, NULL },
 	{ "document-filetype-set", (GCallback) &on_document_filetype_set, FALSE, NULL },
+	{ "document-activate", (GCallback) &on_document_activate, FALSE, NULL },
+	{ "editor-notify", (GCallback) &on_editor_notify, FALSE, NULL },
 	{ NULL, NULL, FALSE, NULL }
 };
 
@@ -0,0 +1,230 @@
+// Scintilla source code edit control
+/** @file BenchDocument.cxx
+ ** Headless benchmark driver for the document layer. Exercises CellBuffer
+ ** and Document directly - sequential and random insertion, find, a
+ ** find-and-replace sweep, undo, and per-lexer styling throughput - over
+ ** synthetic documents of configurable size, without any GUI toolkit.
+ **
+ ** Usage: bench_document [sizeMB ...]      (default sizes: 1 16 64)
+ **
+ ** Output is machine readable, one tab-separated record per line:
+ **   <workload> <detail> <bytes> <seconds> <rate>
+ ** where rate is MB/s for throughput workloads and operations/s otherwise.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "LexerModule.h"
+#include "Catalogue.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+static double TimeNow() {
+	return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+}
+
+static void Record(const char *workload, const char *detail, size_t bytes,
+	double seconds, double rate) {
+	printf("%s\t%s\t%lu\t%.6f\t%.1f\n", workload, detail,
+		static_cast<unsigned long>(bytes), seconds, rate);
+}
+
+static double MBPerSec(size_t bytes, double seconds) {
+	return (seconds > 0.0) ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
+}
+
+// Deterministic C-like source so the lexers have realistic work to do and
+// the find workloads have a predictable number of matches.
+static std::string SyntheticSource(size_t targetBytes) {
+	std::string text;
+	text.reserve(targetBytes + 256);
+	unsigned int serial = 0;
+	while (text.length() < targetBytes) {
+		char chunk[256];
+		sprintf(chunk,
+			"/* block %u */\n"
+			"static int count_%u(const char *s, int limit) {\n"
+			"\tint count = 0;\n"
+			"\twhile (*s && count < limit) {\n"
+			"\t\tcount += (*s++ == '%c') ? 2 : 1;\n"
+			"\t}\n"
+			"\treturn count;\n"
+			"}\n",
+			serial, serial, static_cast<char>('a' + (serial % 26)));
+		serial++;
+		text += chunk;
+	}
+	text.resize(targetBytes);
+	return text;
+}
+
+static void BenchSequentialInsert(const std::string &text) {
+	Document doc;
+	doc.SetUndoCollection(false);
+	const size_t chunk = 4096;
+	const double start = TimeNow();
+	for (size_t pos = 0; pos < text.length(); pos += chunk) {
+		const size_t len = std::min(chunk, text.length() - pos);
+		doc.InsertString(doc.Length(), text.c_str() + pos, static_cast<int>(len));
+	}
+	const double seconds = TimeNow() - start;
+	Record("insert", "sequential", text.length(), seconds,
+		MBPerSec(text.length(), seconds));
+}
+
+static void BenchRandomInsert(const std::string &text) {
+	Document doc;
+	doc.SetUndoCollection(false);
+	doc.InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	const int inserts = 2000;
+	const char *fragment = "int inserted_variable = 42;\n";
+	const int lenFragment = static_cast<int>(strlen(fragment));
+	unsigned int seed = 42;
+	const double start = TimeNow();
+	for (int i = 0; i < inserts; i++) {
+		seed = seed * 1103515245 + 12345;
+		const int pos = static_cast<int>(seed % (doc.Length() + 1));
+		doc.InsertString(pos, fragment, lenFragment);
+	}
+	const double seconds = TimeNow() - start;
+	Record("insert", "random", text.length(), seconds,
+		(seconds > 0.0) ? inserts / seconds : 0.0);
+}
+
+static void BenchFind(const std::string &text, bool caseSensitive) {
+	Document doc;
+	doc.SetUndoCollection(false);
+	doc.InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	CaseFolderTable *pcf = new CaseFolderTable();
+	pcf->StandardASCII();
+	doc.SetCaseFolder(pcf);	// document takes ownership
+	// matches nothing so the whole document is scanned
+	const char *needle = "no_such_identifier_anywhere";
+	int lengthFound = static_cast<int>(strlen(needle));
+	const double start = TimeNow();
+	const long found = doc.FindText(0, doc.Length(), needle, caseSensitive,
+		false, false, false, 0, &lengthFound);
+	const double seconds = TimeNow() - start;
+	if (found != -1)
+		fprintf(stderr, "bench_document: unexpected match in find workload\n");
+	Record("find", caseSensitive ? "case_sensitive" : "case_insensitive",
+		text.length(), seconds, MBPerSec(text.length(), seconds));
+}
+
+static void BenchReplaceAll(const std::string &text) {
+	Document doc;
+	doc.InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	// every synthetic block contains several occurrences
+	const char *needle = "count";
+	const char *replacement = "counter";
+	const int lenNeedle = static_cast<int>(strlen(needle));
+	const int lenReplacement = static_cast<int>(strlen(replacement));
+	int replacements = 0;
+	const double start = TimeNow();
+	{
+		UndoGroup ug(&doc);
+		int pos = 0;
+		for (;;) {
+			int lengthFound = lenNeedle;
+			const long found = doc.FindText(pos, doc.Length(), needle, true,
+				false, false, false, 0, &lengthFound);
+			if (found < 0)
+				break;
+			doc.DeleteChars(static_cast<int>(found), lengthFound);
+			doc.InsertString(static_cast<int>(found), replacement, lenReplacement);
+			pos = static_cast<int>(found) + lenReplacement;
+			replacements++;
+		}
+	}
+	double seconds = TimeNow() - start;
+	Record("replace_all", "forward", text.length(), seconds,
+		(seconds > 0.0) ? replacements / seconds : 0.0);
+
+	const double startUndo = TimeNow();
+	int steps;
+	do {
+		steps = doc.Undo();
+	} while (doc.CanUndo() && steps > 0);
+	seconds = TimeNow() - startUndo;
+	Record("replace_all", "undo", text.length(), seconds,
+		(seconds > 0.0) ? replacements / seconds : 0.0);
+}
+
+static void BenchLexer(const std::string &text, const char *lexerName) {
+	const LexerModule *module = Catalogue::Find(lexerName);
+	if (module == NULL) {
+		fprintf(stderr, "bench_document: no lexer \"%s\"\n", lexerName);
+		return;
+	}
+	ILexer *instance = module->Create();
+	if (instance == NULL)
+		return;
+	Document doc;
+	doc.SetUndoCollection(false);
+	doc.InsertString(0, text.c_str(), static_cast<int>(text.length()));
+	instance->WordListSet(0,
+		"int char void const static return while for if else struct");
+	const double start = TimeNow();
+	instance->Lex(0, doc.Length(), 0, &doc);
+	const double seconds = TimeNow() - start;
+	instance->Release();
+	Record("lex", lexerName, text.length(), seconds,
+		MBPerSec(text.length(), seconds));
+}
+
+int main(int argc, char **argv) {
+	std::vector<size_t> sizesMB;
+	for (int i = 1; i < argc; i++) {
+		const long mb = atol(argv[i]);
+		if (mb <= 0) {
+			fprintf(stderr, "Usage: %s [sizeMB ...]\n", argv[0]);
+			return 1;
+		}
+		sizesMB.push_back(static_cast<size_t>(mb));
+	}
+	if (sizesMB.empty()) {
+		sizesMB.push_back(1);
+		sizesMB.push_back(16);
+		sizesMB.push_back(64);
+	}
+
+	printf("# workload\tdetail\tbytes\tseconds\trate\n");
+	for (size_t i = 0; i < sizesMB.size(); i++) {
+		const std::string text = SyntheticSource(sizesMB[i] * 1024 * 1024);
+		BenchSequentialInsert(text);
+		BenchRandomInsert(text);
+		BenchFind(text, true);
+		BenchFind(text, false);
+		BenchReplaceAll(text);
+		BenchLexer(text, "cpp");
+		BenchLexer(text, "python");
+		BenchLexer(text, "hypertext");
+		BenchLexer(text, "perl");
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+// Scintilla source code edit control
+/** @file PlatHeadless.cxx
+ ** Minimal Platform implementation for headless tools that exercise the
+ ** document layer (Document, CellBuffer, lexers) without any GUI toolkit.
+ ** Only the utility and diagnostic entry points referenced by those
+ ** translation units are provided.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+#include "Platform.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+ElapsedTime::ElapsedTime() {
+	struct timeval curTime;
+	gettimeofday(&curTime, NULL);
+	bigBit = curTime.tv_sec;
+	littleBit = curTime.tv_usec;
+}
+
+double ElapsedTime::Duration(bool reset) {
+	struct timeval curTime;
+	gettimeofday(&curTime, NULL);
+	long endBigBit = curTime.tv_sec;
+	long endLittleBit = curTime.tv_usec;
+	double result = 1000000.0 * (endBigBit - bigBit);
+	result += endLittleBit - littleBit;
+	result /= 1000000.0;
+	if (reset) {
+		bigBit = endBigBit;
+		littleBit = endLittleBit;
+	}
+	return result;
+}
+
+void Platform::DebugDisplay(const char *s) {
+	fprintf(stderr, "%s", s);
+}
+
+void Platform::DebugPrintf(const char *format, ...) {
+	char buffer[2000];
+	va_list pArguments;
+	va_start(pArguments, format);
+	vsprintf(buffer, format, pArguments);
+	va_end(pArguments);
+	Platform::DebugDisplay(buffer);
+}
+
+void Platform::Assert(const char *c, const char *file, int line) {
+	fprintf(stderr, "Assertion [%s] failed at %s %d\r\n", c, file, line);
+	abort();
+}
+
+bool Platform::IsDBCSLeadByte(int, char) {
+	return false;
+}
+
+long Platform::SendScintilla(WindowID, unsigned int, unsigned long, long) {
+	return 0;
+}
+
+long Platform::SendScintillaPointer(WindowID, unsigned int, unsigned long, void *) {
+	return 0;
+}
+
+int Platform::Minimum(int a, int b) {
+	if (a < b)
+		return a;
+	else
+		return b;
+}
+
+int Platform::Maximum(int a, int b) {
+	if (a > b)
+		return a;
+	else
+		return b;
+}
+
+int Platform::Clamp(int val, int minVal, int maxVal) {
+	if (val > maxVal)
+		val = maxVal;
+	if (val < minVal)
+		val = minVal;
+	return val;
+}
@@ -163,7 +163,13 @@ static void FontMutexUnlock() {
 class FontHandle {
 	XYPOSITION width[128];
 	encodingType et;
+	// Cache of measured advance arrays for recently measured segments keyed by
+	// the segment bytes.  Lines are broken into the same segments on every
+	// layout, so repeated keywords, indentation runs and operators skip Pango
+	// shaping entirely.
+	std::map<std::string, std::vector<XYPOSITION> > segmentWidths;
 public:
+	enum { maxCachedSegmentLength = 64, maxCachedSegments = 256 };
 	int ascent;
 	PangoFontDescription *pfd;
 	int characterSet;
@@ -187,6 +193,7 @@ public:
 		for (int i=0; i<=127; i++) {
 			width[i] = 0;
 		}
+		segmentWidths.clear();
 	}
 	XYPOSITION CharWidth(unsigned char ch, encodingType et_) const {
 		XYPOSITION w = 0;
@@ -207,6 +214,33 @@ public:
 			FontMutexUnlock();
 		}
 	}
+	bool SegmentWidths(const char *s, int len, encodingType et_, XYPOSITION *positions) {
+		bool found = false;
+		FontMutexLock();
+		if (et == et_) {
+			std::map<std::string, std::vector<XYPOSITION> >::const_iterator it =
+				segmentWidths.find(std::string(s, len));
+			if (it != segmentWidths.end()) {
+				for (int i=0; i<len; i++) {
+					positions[i] = it->second[i];
+				}
+				found = true;
+			}
+		}
+		FontMutexUnlock();
+		return found;
+	}
+	void SetSegmentWidths(const char *s, int len, encodingType et_, const XYPOSITION *positions) {
+		FontMutexLock();
+		if (et != et_) {
+			ResetWidths(et_);
+		}
+		if (segmentWidths.size() >= static_cast<size_t>(maxCachedSegments)) {
+			segmentWidths.clear();
+		}
+		segmentWidths[std::string(s, len)] = std::vector<XYPOSITION>(positions, positions + len);
+		FontMutexUnlock();
+	}
 };
 
 // X has a 16 bit coordinate space, so stop drawing here to avoid wrapping
@@ -382,9 +416,12 @@ class SurfaceImpl : public Surface {
 	bool createdGC;
 	PangoContext *pcontext;
 	PangoLayout *layout;
+	std::string textInLayout;
+	PangoFontDescription *pfdInLayout;
 	Converter conv;
 	int characterSet;
 	void SetConverter(int characterSet_);
+	void LayoutSetText(PangoFontDescription *pfd, const char *text, size_t len);
 public:
 	SurfaceImpl();
 	virtual ~SurfaceImpl();
@@ -495,7 +532,7 @@ SurfaceImpl::SurfaceImpl() : et(singleByte),
 context(0),
 psurf(0),
 x(0), y(0), inited(false), createdGC(false)
-, pcontext(0), layout(0), characterSet(-1) {
+, pcontext(0), layout(0), pfdInLayout(0), characterSet(-1) {
 }
 
 SurfaceImpl::~SurfaceImpl() {
@@ -515,6 +552,8 @@ void SurfaceImpl::Release() {
 	if (layout)
 		g_object_unref(layout);
 	layout = 0;
+	textInLayout.clear();
+	pfdInLayout = 0;
 	if (pcontext)
 		g_object_unref(pcontext);
 	pcontext = 0;
@@ -903,6 +942,21 @@ static size_t MultiByteLenFromIconv(const Converter &conv, const char *s, size_t
 	return 1;
 }
 
+// Set the layout's text and font, skipping the calls when the layout already
+// holds the same segment in the same font.  Setting either discards the
+// layout's shaped glyphs, so this lets repeated segments - the same keyword,
+// indentation run or operator drawn many times per paint - reuse the shaping
+// done for the first occurrence.
+void SurfaceImpl::LayoutSetText(PangoFontDescription *pfd, const char *text, size_t len) {
+	if ((pfd == pfdInLayout) && (textInLayout.length() == len) &&
+			(memcmp(textInLayout.data(), text, len) == 0))
+		return;
+	pango_layout_set_text(layout, text, static_cast<int>(len));
+	pango_layout_set_font_description(layout, pfd);
+	textInLayout.assign(text, len);
+	pfdInLayout = pfd;
+}
+
 void SurfaceImpl::DrawTextBase(PRectangle rc, Font &font_, XYPOSITION ybase, const char *s, int len,
                                  ColourDesired fore) {
 	PenColour(fore);
@@ -911,16 +965,15 @@ void SurfaceImpl::DrawTextBase(PRectangle rc, Font &font_, XYPOSITION ybase, con
 		if (PFont(font_)->pfd) {
 			std::string utfForm;
 			if (et == UTF8) {
-				pango_layout_set_text(layout, s, len);
+				LayoutSetText(PFont(font_)->pfd, s, len);
 			} else {
 				SetConverter(PFont(font_)->characterSet);
 				utfForm = UTF8FromIconv(conv, s, len);
 				if (utfForm.empty()) {	// iconv failed so treat as Latin1
 					utfForm = UTF8FromLatin1(s, len);
 				}
-				pango_layout_set_text(layout, utfForm.c_str(), utfForm.length());
+				LayoutSetText(PFont(font_)->pfd, utfForm.c_str(), utfForm.length());
 			}
-			pango_layout_set_font_description(layout, PFont(font_)->pfd);
 			pango_cairo_update_layout(context, layout);
 #ifdef PANGO_VERSION
 			PangoLayoutLine *pll = pango_layout_get_line_readonly(layout,0);
@@ -1002,11 +1055,14 @@ void SurfaceImpl::MeasureWidths(Font &font_, const char *s, int len, XYPOSITION
 					return;
 				}
 			}
-			pango_layout_set_font_description(layout, PFont(font_)->pfd);
+			if ((len > 1) && (len <= FontHandle::maxCachedSegmentLength) &&
+					PFont(font_)->SegmentWidths(s, len, et, positions)) {
+				return;
+			}
 			if (et == UTF8) {
 				// Simple and direct as UTF-8 is native Pango encoding
 				int i = 0;
-				pango_layout_set_text(layout, s, len);
+				LayoutSetText(PFont(font_)->pfd, s, len);
 				ClusterIterator iti(layout, lenPositions);
 				while (!iti.finished) {
 					iti.Next();
@@ -1031,7 +1087,7 @@ void SurfaceImpl::MeasureWidths(Font &font_, const char *s, int len, XYPOSITION
 						// Loop through UTF-8 and DBCS forms, taking account of different
 						// character byte lengths.
 						Converter convMeasure("UCS-2", CharacterSetID(characterSet), false);
-						pango_layout_set_text(layout, utfForm.c_str(), strlen(utfForm.c_str()));
+						LayoutSetText(PFont(font_)->pfd, utfForm.c_str(), strlen(utfForm.c_str()));
 						int i = 0;
 						int clusterStart = 0;
 						ClusterIterator iti(layout, strlen(utfForm.c_str()));
@@ -1062,7 +1118,7 @@ void SurfaceImpl::MeasureWidths(Font &font_, const char *s, int len, XYPOSITION
 					if (utfForm.empty()) {
 						utfForm = UTF8FromLatin1(s, len);
 					}
-					pango_layout_set_text(layout, utfForm.c_str(), utfForm.length());
+					LayoutSetText(PFont(font_)->pfd, utfForm.c_str(), utfForm.length());
 					int i = 0;
 					int clusterStart = 0;
 					// Each 8-bit input character may take 1 or 2 bytes in UTF-8
@@ -1097,6 +1153,8 @@ void SurfaceImpl::MeasureWidths(Font &font_, const char *s, int len, XYPOSITION
 			}
 			if (len == 1) {
 				PFont(font_)->SetCharWidth(*s, positions[0], et);
+			} else if (len <= FontHandle::maxCachedSegmentLength) {
+				PFont(font_)->SetSegmentWidths(s, len, et, positions);
 			}
 			return;
 		}
@@ -1112,17 +1170,16 @@ XYPOSITION SurfaceImpl::WidthText(Font &font_, const char *s, int len) {
 	if (font_.GetID()) {
 		if (PFont(font_)->pfd) {
 			std::string utfForm;
-			pango_layout_set_font_description(layout, PFont(font_)->pfd);
 			PangoRectangle pos;
 			if (et == UTF8) {
-				pango_layout_set_text(layout, s, len);
+				LayoutSetText(PFont(font_)->pfd, s, len);
 			} else {
 				SetConverter(PFont(font_)->characterSet);
 				utfForm = UTF8FromIconv(conv, s, len);
 				if (utfForm.empty()) {	// iconv failed so treat as Latin1
 					utfForm = UTF8FromLatin1(s, len);
 				}
-				pango_layout_set_text(layout, utfForm.c_str(), utfForm.length());
+				LayoutSetText(PFont(font_)->pfd, utfForm.c_str(), utfForm.length());
 			}
 #ifdef PANGO_VERSION
 			PangoLayoutLine *pangoLine = pango_layout_get_line_readonly(layout,0);
@@ -1426,6 +1483,7 @@ class ListBoxX : public ListBox {
 	WindowID frame;
 	WindowID list;
 	WindowID scroller;
+	GtkListStore *store;
 	void *pixhash;
 	GtkCellRenderer* pixbuf_renderer;
 	RGBAImageSet images;
@@ -1436,7 +1494,7 @@ public:
 	CallBackAction doubleClickAction;
 	void *doubleClickActionData;
 
-	ListBoxX() : widCached(0), frame(0), list(0), scroller(0), pixhash(NULL), pixbuf_renderer(0),
+	ListBoxX() : widCached(0), frame(0), list(0), scroller(0), store(0), pixhash(NULL), pixbuf_renderer(0),
 		desiredVisibleRows(5), maxItemCharacters(0),
 		aveCharWidth(1), doubleClickAction(NULL), doubleClickActionData(NULL) {
 	}
@@ -1592,8 +1650,7 @@ void ListBoxX::Create(Window &, int, Point, int, bool, int) {
 	gtk_widget_show(PWidget(scroller));
 
 	/* Tree and its model */
-	GtkListStore *store =
-		gtk_list_store_new(N_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING);
+	store = gtk_list_store_new(N_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING);
 
 	list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
 	g_signal_connect(G_OBJECT(list), "style-set", G_CALLBACK(StyleSet), NULL);
@@ -1758,8 +1815,7 @@ int ListBoxX::CaretFromEdge() {
 }
 
 void ListBoxX::Clear() {
-	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(list));
-	gtk_list_store_clear(GTK_LIST_STORE(model));
+	gtk_list_store_clear(store);
 	maxItemCharacters = 0;
 }
 
@@ -1790,8 +1846,6 @@ void ListBoxX::Append(char *s, int type) {
 		             , (gconstpointer) GINT_TO_POINTER(type)));
 	}
 	GtkTreeIter iter;
-	GtkListStore *store =
-		GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(list)));
 	gtk_list_store_append(GTK_LIST_STORE(store), &iter);
 	if (list_image) {
 		if (NULL == list_image->pixbuf)
@@ -1979,6 +2033,11 @@ void ListBoxX::ClearRegisteredImages() {
 }
 
 void ListBoxX::SetList(const char *listText, char separator, char typesep) {
+	// Detach the model from the view while filling so each appended row
+	// doesn't emit a signal causing the visible list to be re-laid out;
+	// the view processes the whole list once when it is reattached.
+	g_object_ref(store);
+	gtk_tree_view_set_model(GTK_TREE_VIEW(list), NULL);
 	Clear();
 	int count = strlen(listText) + 1;
 	std::vector<char> words(listText, listText+count);
@@ -2002,6 +2061,8 @@ void ListBoxX::SetList(const char *listText, char separator, char typesep) {
 			*numword = '\0';
 		Append(startword, numword?atoi(numword + 1):-1);
 	}
+	gtk_tree_view_set_model(GTK_TREE_VIEW(list), GTK_TREE_MODEL(store));
+	g_object_unref(store);
 }
 
 Menu::Menu() : mid(0) {}
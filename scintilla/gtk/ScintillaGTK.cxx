@@ -155,12 +155,23 @@ class ScintillaGTK : public ScintillaBase {
 	Window wPreedit;
 	Window wPreeditDraw;
 	GtkIMContext *im_context;
+	// Whether the input method may hold or later produce uncommitted state (dead
+	// key, preedit), in which case every key must be filtered through it. Starts
+	// true; only a commit arriving synchronously from the filter call clears it,
+	// as that proves the input method resolved the key in-process, see CommitThis.
+	bool imComposePossible;
+	// Whether a gtk_im_context_filter_keypress call is on the stack, used to
+	// distinguish synchronous commits from asynchronous ones (IM daemons)
+	bool imFilterInProgress;
 
 	// Wheel mouse support
 	unsigned int linesPerScroll;
 	GTimeVal lastWheelMouseTime;
 	gint lastWheelMouseDirection;
 	gint wheelMouseIntensity;
+	// Fractional line and column remainders carried between smooth scroll events
+	gdouble smoothScrollY;
+	gdouble smoothScrollX;
 
 #if GTK_CHECK_VERSION(3,0,0)
 	cairo_rectangle_list_t *rgnUpdate;
@@ -169,6 +180,16 @@ class ScintillaGTK : public ScintillaBase {
 #endif
 	bool repaintFullWindow;
 
+	// Pixels saved from under the carets while the blink overlay shows them,
+	// in text window coordinates; empty whenever the overlay does not own the
+	// caret pixels on screen
+	struct CaretSave {
+		cairo_surface_t *surface;
+		PRectangle rc;
+		CaretSave() : surface(0) {}
+	};
+	std::vector<CaretSave> caretSaves;
+
 	// Private so ScintillaGTK objects can not be copied
 	ScintillaGTK(const ScintillaGTK &);
 	ScintillaGTK &operator=(const ScintillaGTK &);
@@ -207,6 +228,8 @@ private:
 	virtual bool HaveMouseCapture();
 	virtual bool PaintContains(PRectangle rc);
 	void FullPaint();
+	void CaretOverlayDrop();
+	virtual bool BlinkCaret();
 	virtual PRectangle GetClientRectangle() const;
 	virtual void ScrollText(int linesToMove);
 	virtual void SetVerticalScrollPos();
@@ -233,10 +256,57 @@ private:
 	void ReceivedSelection(GtkSelectionData *selection_data);
 	void ReceivedDrop(GtkSelectionData *selection_data);
 	static void GetSelection(GtkSelectionData *selection_data, guint info, SelectionText *selected);
-	void StoreOnClipboard(SelectionText *clipText);
+	// Deferred clipboard copy: for a plain stream selection, Copy() stores only
+	// the selected range and the text is materialized when a clipboard consumer
+	// first requests it, or just before the next document modification, so
+	// copying a large selection does not duplicate it up front.
+	struct ClipboardData {
+		ScintillaGTK *sci;	// non-NULL while the range is not yet materialized
+		int startPos;
+		int endPos;
+		SelectionText text;
+		ClipboardData() : sci(0), startPos(0), endPos(0) {}
+	};
+	class ClipboardWatcher : public DocWatcher {
+	public:
+		ScintillaGTK *sci;
+		ClipboardWatcher() : sci(0) {}
+		virtual void NotifyModifyAttempt(Document *, void *) {}
+		virtual void NotifySavePoint(Document *, void *, bool) {}
+		virtual void NotifyModified(Document *, DocModification mh, void *) {
+			// capture the deferred clipboard range before the text changes
+			if (mh.modificationType & (SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE))
+				sci->ClipboardMaterialize();
+		}
+		virtual void NotifyDeleted(Document *, void *) {}
+		virtual void NotifyStyleNeeded(Document *, void *, int) {}
+		virtual void NotifyLexerChanged(Document *, void *) {}
+		virtual void NotifyErrorOccurred(Document *, void *, int) {}
+	};
+	ClipboardData *pendingClipboard;
+	ClipboardWatcher clipWatcher;
+	void ClipboardMaterialize();
+	virtual void SetDocPointer(Document *document);
+	void StoreOnClipboard(ClipboardData *clipData);
 	static void ClipboardGetSelection(GtkClipboard* clip, GtkSelectionData *selection_data, guint info, void *data);
 	static void ClipboardClearSelection(GtkClipboard* clip, void *data);
 
+	// Incremental paste: a very large stream paste is inserted in chunks from
+	// an idle handler inside one undo transaction, so the start of the text
+	// appears immediately and the UI stays responsive during the rest.
+	std::string pasteChunks;	// text still to insert, in document encoding
+	size_t pasteChunkOffset;
+	bool pasteUndoOpen;
+	guint pasteIdleID;
+	// Document position the next chunk is inserted at, kept in step with other
+	// modifications through NotifyModified; -1 before the first chunk went in
+	int pastePosition;
+	void StartIncrementalPaste(const char *text, size_t len);
+	bool IncrementalPasteChunk();
+	void FinishIncrementalPaste(bool insertRemainder);
+	static gboolean IncrementalPasteIdle(ScintillaGTK *sciThis);
+	virtual void NotifyModified(Document *document, DocModification mh, void *userData);
+
 	void UnclaimSelection(GdkEventSelection *selection_event);
 	void Resize(int width, int height);
 
@@ -385,12 +455,19 @@ ScintillaGTK::ScintillaGTK(_ScintillaObject *sci_) :
 		evbtn(0), capturedMouse(false), dragWasDropped(false),
 		lastKey(0), rectangularSelectionModifier(SCMOD_CTRL), parentClass(0),
 		im_context(NULL),
+		imComposePossible(true),
+		imFilterInProgress(false),
 		lastWheelMouseDirection(0),
 		wheelMouseIntensity(0),
+		smoothScrollY(0), smoothScrollX(0),
+		pendingClipboard(0),
+		pasteChunkOffset(0), pasteUndoOpen(false), pasteIdleID(0), pastePosition(-1),
 		rgnUpdate(0),
 		repaintFullWindow(false) {
 	sci = sci_;
 	wMain = GTK_WIDGET(sci);
+	clipWatcher.sci = this;
+	pdoc->AddWatcher(&clipWatcher, 0);
 
 #if PLAT_GTK_WIN32
 	rectangularSelectionModifier = SCMOD_ALT;
@@ -420,6 +497,11 @@ ScintillaGTK::ScintillaGTK(_ScintillaObject *sci_) :
 }
 
 ScintillaGTK::~ScintillaGTK() {
+	// drop the remainder of a paste still trickling in and close its undo group
+	FinishIncrementalPaste(false);
+	// any clipboard range still deferred must outlive this view
+	ClipboardMaterialize();
+	pdoc->RemoveWatcher(&clipWatcher, 0);
 	g_idle_remove_by_data(this);
 	if (evbtn) {
 		gdk_event_free(reinterpret_cast<GdkEvent *>(evbtn));
@@ -875,6 +957,7 @@ void ScintillaGTK::Finalise() {
 	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
 		FineTickerCancel(tr);
 	}
+	CaretOverlayDrop();
 	ScintillaBase::Finalise();
 }
 
@@ -1172,6 +1255,101 @@ void ScintillaGTK::FullPaint() {
 	wText.InvalidateAll();
 }
 
+// Forgets the pixels saved from under the carets. Called whenever something
+// else may paint the text window or move its contents, as a regular paint
+// renders the true caret state and scrolling shifts the saved area.
+void ScintillaGTK::CaretOverlayDrop() {
+	for (size_t i = 0; i < caretSaves.size(); i++) {
+		if (caretSaves[i].surface)
+			cairo_surface_destroy(caretSaves[i].surface);
+	}
+	caretSaves.clear();
+}
+
+// Blinks the carets by drawing them directly on the text window and putting
+// the saved pixels back on the next tick, so an idle editor does not run the
+// invalidate -> expose -> Paint cycle (with its line layout lookups) twice a
+// second. Returns false when the overlay cannot represent the current caret
+// state; the caller then falls back to invalidating as usual, which also
+// resynchronises the overlay for the next blink period.
+bool ScintillaGTK::BlinkCaret() {
+	if (paintState != notPainting || posDrag.IsValid())
+		return false;
+	if ((vs.caretStyle != CARETSTYLE_LINE) || (vs.caretWidth <= 0) || inOverstrike ||
+			view.imeCaretBlockOverride || view.LinesOverlap())
+		return false;
+	if (!IS_WIDGET_MAPPED(PWidget(wMain)) || !PWindow(wText))
+		return false;
+
+	cairo_t *crWindow = gdk_cairo_create(PWindow(wText));
+	if (!crWindow)
+		return false;
+
+	bool overlayUsable = true;
+	if (caret.on) {
+		// Showing: save the pixels under each blinking caret, then draw it.
+		// A non empty save list would mean the previous hide never happened,
+		// so the screen state is unknown and the overlay must stand down.
+		overlayUsable = caretSaves.empty();
+		const PRectangle rcClient = GetClientRectangle();
+		for (size_t r = 0; overlayUsable && r < sel.Count(); r++) {
+			if ((r != sel.Main()) && !view.additionalCaretsBlink)
+				continue;	// stays drawn by the regular paint
+			const Point pt = LocationFromPosition(sel.Range(r).caret);
+			const XYPOSITION caretWidthOffset = (pt.x > 0) ? 0.51f : 0.0f;
+			PRectangle rcCaret;
+			rcCaret.left = static_cast<XYPOSITION>(RoundXYPosition(pt.x - caretWidthOffset));
+			rcCaret.right = rcCaret.left + vs.caretWidth;
+			rcCaret.top = pt.y;
+			rcCaret.bottom = pt.y + vs.lineHeight;
+			if (!rcClient.Contains(rcCaret)) {
+				overlayUsable = false;	// partially visible carets keep the repaint path
+				break;
+			}
+			CaretSave save;
+			save.rc = rcCaret;
+			save.surface = cairo_surface_create_similar(cairo_get_target(crWindow),
+				CAIRO_CONTENT_COLOR, rcCaret.Width(), rcCaret.Height());
+			if (cairo_surface_status(save.surface) != CAIRO_STATUS_SUCCESS) {
+				cairo_surface_destroy(save.surface);
+				overlayUsable = false;
+				break;
+			}
+			cairo_t *crSave = cairo_create(save.surface);
+			cairo_set_source_surface(crSave, cairo_get_target(crWindow),
+				-rcCaret.left, -rcCaret.top);
+			cairo_paint(crSave);
+			cairo_destroy(crSave);
+			caretSaves.push_back(save);
+
+			const ColourDesired colour =
+				(r == sel.Main()) ? vs.caretcolour : vs.additionalCaretColour;
+			cairo_set_source_rgb(crWindow, colour.GetRed() / 255.0,
+				colour.GetGreen() / 255.0, colour.GetBlue() / 255.0);
+			cairo_rectangle(crWindow, rcCaret.left, rcCaret.top,
+				rcCaret.Width(), rcCaret.Height());
+			cairo_fill(crWindow);
+		}
+		if (!overlayUsable)
+			CaretOverlayDrop();
+	} else {
+		// Hiding: put the saved pixels back. With nothing saved a paint has
+		// rendered the caret in the meantime, so it must be erased by the
+		// regular invalidation instead.
+		overlayUsable = !caretSaves.empty();
+		for (size_t i = 0; overlayUsable && i < caretSaves.size(); i++) {
+			cairo_set_source_surface(crWindow, caretSaves[i].surface,
+				caretSaves[i].rc.left, caretSaves[i].rc.top);
+			cairo_rectangle(crWindow, caretSaves[i].rc.left, caretSaves[i].rc.top,
+				caretSaves[i].rc.Width(), caretSaves[i].rc.Height());
+			cairo_fill(crWindow);
+		}
+		CaretOverlayDrop();
+	}
+	cairo_destroy(crWindow);
+	return overlayUsable;
+}
+
 PRectangle ScintillaGTK::GetClientRectangle() const {
 	Window &win = const_cast<Window &>(wMain);
 	PRectangle rc = win.GetClientPosition();
@@ -1192,11 +1370,15 @@ void ScintillaGTK::ScrollText(int linesToMove) {
 	//Platform::DebugPrintf("ScintillaGTK::ScrollText %d %d %0d,%0d %0d,%0d\n", linesToMove, diff,
 	//	rc.left, rc.top, rc.right, rc.bottom);
 	GtkWidget *wi = PWidget(wText);
+	CaretOverlayDrop();
 	NotifyUpdateUI();
 
 	if (IS_WIDGET_REALIZED(wi)) {
 		gdk_window_scroll(WindowFromWidget(wi), 0, -diff);
-		gdk_window_process_updates(WindowFromWidget(wi), FALSE);
+		// The exposed strip is left in the update area rather than painted
+		// synchronously here: consecutive scrolls within one main loop
+		// iteration then accumulate their strips and are painted together
+		// once per frame instead of forcing a repaint per scroll event.
 	}
 }
 
@@ -1442,16 +1624,52 @@ int ScintillaGTK::KeyDefault(int key, int modifiers) {
 }
 
 void ScintillaGTK::CopyToClipboard(const SelectionText &selectedText) {
-	SelectionText *clipText = new SelectionText();
-	clipText->Copy(selectedText);
-	StoreOnClipboard(clipText);
+	ClipboardData *clipData = new ClipboardData();
+	clipData->text.Copy(selectedText);
+	StoreOnClipboard(clipData);
+}
+
+// Builds the text for a deferred clipboard range from the document. Called at
+// most once per copy: when a clipboard consumer first requests the data, when
+// the document is about to change, or when this view goes away.
+void ScintillaGTK::ClipboardMaterialize() {
+	if (!pendingClipboard)
+		return;
+	ClipboardData *clipData = pendingClipboard;
+	pendingClipboard = 0;
+	clipData->sci = 0;
+	std::string text = RangeText(clipData->startPos, clipData->endPos);
+	clipData->text.Copy(text, pdoc->dbcsCodePage,
+		vs.styles[STYLE_DEFAULT].characterSet, false, false);
+}
+
+void ScintillaGTK::SetDocPointer(Document *document) {
+	// a paste still trickling in belongs to the current document: complete it
+	FinishIncrementalPaste(true);
+	// the deferred range and the watcher both refer to the current document
+	ClipboardMaterialize();
+	pdoc->RemoveWatcher(&clipWatcher, 0);
+	ScintillaBase::SetDocPointer(document);
+	pdoc->AddWatcher(&clipWatcher, 0);
 }
 
 void ScintillaGTK::Copy() {
 	if (!sel.Empty()) {
-		SelectionText *clipText = new SelectionText();
-		CopySelectionRange(clipText);
-		StoreOnClipboard(clipText);
+		ClipboardData *clipData = new ClipboardData();
+		if ((sel.Count() == 1) && (sel.selType == Selection::selStream) &&
+			(sel.RangeMain().Start().VirtualSpace() == 0) &&
+			(sel.RangeMain().End().VirtualSpace() == 0)) {
+			// Plain stream selection: store only the range, the text is
+			// materialized when a consumer asks for it. Rectangular and
+			// multiple selections are materialized up front since their
+			// per-line segments and virtual space only exist as text.
+			clipData->sci = this;
+			clipData->startPos = sel.RangeMain().Start().Position();
+			clipData->endPos = sel.RangeMain().End().Position();
+		} else {
+			CopySelectionRange(&clipData->text);
+		}
+		StoreOnClipboard(clipData);
 #if PLAT_GTK_WIN32
 		if (sel.IsRectangular()) {
 			::OpenClipboard(NULL);
@@ -1616,8 +1834,18 @@ void ScintillaGTK::ReceivedSelection(GtkSelectionData *selection_data) {
 					ClearSelection(multiPasteMode == SC_MULTIPASTE_EACH);
 				}
 
-				InsertPasteShape(selText.Data(), selText.Length(),
-					selText.rectangular ? pasteRectangular : pasteStream);
+				// A huge plain stream paste is inserted incrementally so the
+				// UI does not freeze for its duration; StartIncrementalPaste
+				// keeps the undo group open until the last chunk is in.
+				const size_t incrementalPasteThreshold = 0x100000;
+				if (!selText.rectangular && (sel.Count() == 1) &&
+				        (selText.Length() >= incrementalPasteThreshold) &&
+				        ((pdoc->dbcsCodePage == 0) || IsUnicodeMode())) {
+					StartIncrementalPaste(selText.Data(), selText.Length());
+				} else {
+					InsertPasteShape(selText.Data(), selText.Length(),
+						selText.rectangular ? pasteRectangular : pasteStream);
+				}
 				EnsureCaretVisible();
 			}
 		}
@@ -1629,6 +1857,132 @@ void ScintillaGTK::ReceivedSelection(GtkSelectionData *selection_data) {
 	}
 }
 
+void ScintillaGTK::StartIncrementalPaste(const char *text, size_t len) {
+	// a paste may arrive while a previous one is still trickling in
+	FinishIncrementalPaste(true);
+	pasteChunks.assign(text, len);
+	pasteChunkOffset = 0;
+	pastePosition = -1;
+	pdoc->BeginUndoAction();
+	pasteUndoOpen = true;
+	// insert the first chunk right away so the start of the text shows immediately
+	if (IncrementalPasteChunk()) {
+		pasteIdleID = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+			reinterpret_cast<GSourceFunc>(IncrementalPasteIdle), this, NULL);
+	} else {
+		FinishIncrementalPaste(false);
+	}
+}
+
+// Inserts the next chunk at the tracked insertion point, preferring to break
+// after a line end and never inside a UTF-8 sequence. Returns true while text
+// remains to insert.
+bool ScintillaGTK::IncrementalPasteChunk() {
+	const size_t pasteChunkGoal = 0x40000;
+	size_t end = pasteChunkOffset + pasteChunkGoal;
+	if (end >= pasteChunks.length()) {
+		end = pasteChunks.length();
+	} else {
+		const size_t nl = pasteChunks.rfind('\n', end);
+		if ((nl != std::string::npos) && (nl >= pasteChunkOffset)) {
+			end = nl + 1;
+		} else if (IsUnicodeMode()) {
+			while ((end > pasteChunkOffset) &&
+			        ((pasteChunks[end] & 0xC0) == 0x80))
+				end--;
+		}
+	}
+	if (end > pasteChunkOffset) {
+		if (pastePosition < 0) {
+			// first chunk: insert like a normal paste, then anchor the
+			// insertion point for the rest at the resulting caret
+			InsertPasteShape(pasteChunks.c_str() + pasteChunkOffset,
+				static_cast<int>(end - pasteChunkOffset), pasteStream);
+			pastePosition = sel.MainCaret();
+		} else {
+			// later chunks continue at the tracked document position, not at
+			// the caret, which may have been moved by the container meanwhile
+			const int lengthInserted = pdoc->InsertString(pastePosition,
+				pasteChunks.c_str() + pasteChunkOffset,
+				static_cast<int>(end - pasteChunkOffset));
+			pastePosition += lengthInserted;
+			SetEmptySelection(pastePosition);
+		}
+		pasteChunkOffset = end;
+	}
+	return pasteChunkOffset < pasteChunks.length();
+}
+
+// Ends an incremental paste, optionally inserting what is left in one go
+// (document switch), and closes the undo transaction opened for it.
+void ScintillaGTK::FinishIncrementalPaste(bool insertRemainder) {
+	if (pasteIdleID) {
+		g_source_remove(pasteIdleID);
+		pasteIdleID = 0;
+	}
+	if (insertRemainder && (pasteChunkOffset < pasteChunks.length())) {
+		if (pastePosition >= 0) {
+			const int lengthInserted = pdoc->InsertString(pastePosition,
+				pasteChunks.c_str() + pasteChunkOffset,
+				static_cast<int>(pasteChunks.length() - pasteChunkOffset));
+			SetEmptySelection(pastePosition + lengthInserted);
+		} else {
+			InsertPasteShape(pasteChunks.c_str() + pasteChunkOffset,
+				static_cast<int>(pasteChunks.length() - pasteChunkOffset), pasteStream);
+		}
+	}
+	pasteChunks.clear();
+	pasteChunkOffset = 0;
+	pastePosition = -1;
+	if (pasteUndoOpen) {
+		pdoc->EndUndoAction();
+		pasteUndoOpen = false;
+	}
+}
+
+gboolean ScintillaGTK::IncrementalPasteIdle(ScintillaGTK *sciThis) {
+#ifndef GDK_VERSION_3_6
+	gdk_threads_enter();
+#endif
+	gboolean more = FALSE;
+	try {
+		more = sciThis->IncrementalPasteChunk();
+		sciThis->EnsureCaretVisible();
+		sciThis->Redraw();
+		if (!more) {
+			// returning FALSE removes the source, so forget its ID first
+			sciThis->pasteIdleID = 0;
+			sciThis->FinishIncrementalPaste(false);
+		}
+	} catch (...) {
+		sciThis->errorStatus = SC_STATUS_FAILURE;
+	}
+#ifndef GDK_VERSION_3_6
+	gdk_threads_leave();
+#endif
+	return more;
+}
+
+void ScintillaGTK::NotifyModified(Document *document, DocModification mh, void *userData) {
+	// Shift the incremental paste insertion point along with modifications made
+	// before it (another view on the document, container messages), so the
+	// remaining chunks keep extending the already pasted text. The paste's own
+	// chunks arrive exactly at pastePosition and are accounted for by the
+	// insertion code itself, hence the strict comparisons.
+	if (pasteUndoOpen && (pastePosition >= 0) && (document == pdoc)) {
+		if (mh.modificationType & SC_MOD_INSERTTEXT) {
+			if (mh.position < pastePosition)
+				pastePosition += mh.length;
+		} else if (mh.modificationType & SC_MOD_DELETETEXT) {
+			if (mh.position + mh.length <= pastePosition)
+				pastePosition -= mh.length;
+			else if (mh.position < pastePosition)
+				pastePosition = mh.position;
+		}
+	}
+	Editor::NotifyModified(document, mh, userData);
+}
+
 void ScintillaGTK::ReceivedDrop(GtkSelectionData *selection_data) {
 	dragWasDropped = true;
 	if (TypeOfGSD(selection_data) == atomUriList || TypeOfGSD(selection_data) == atomDROPFILES_DND) {
@@ -1704,25 +2058,37 @@ void ScintillaGTK::GetSelection(GtkSelectionData *selection_data, guint info, Se
 #endif
 }
 
-void ScintillaGTK::StoreOnClipboard(SelectionText *clipText) {
+void ScintillaGTK::StoreOnClipboard(ClipboardData *clipData) {
 	GtkClipboard *clipBoard =
 		gtk_widget_get_clipboard(GTK_WIDGET(PWidget(wMain)), atomClipboard);
-	if (clipBoard == NULL) // Occurs if widget isn't in a toplevel
+	if (clipBoard == NULL) { // Occurs if widget isn't in a toplevel
+		delete clipData;
 		return;
+	}
 
+	// replacing the previous contents clears any older deferred range first
 	if (gtk_clipboard_set_with_data(clipBoard, clipboardCopyTargets, nClipboardCopyTargets,
-				    ClipboardGetSelection, ClipboardClearSelection, clipText)) {
+				    ClipboardGetSelection, ClipboardClearSelection, clipData)) {
 		gtk_clipboard_set_can_store(clipBoard, clipboardCopyTargets, nClipboardCopyTargets);
+		if (clipData->sci)
+			clipData->sci->pendingClipboard = clipData;
+	} else {
+		delete clipData;
 	}
 }
 
 void ScintillaGTK::ClipboardGetSelection(GtkClipboard *, GtkSelectionData *selection_data, guint info, void *data) {
-	GetSelection(selection_data, info, static_cast<SelectionText*>(data));
+	ClipboardData *clipData = static_cast<ClipboardData *>(data);
+	if (clipData->sci)
+		clipData->sci->ClipboardMaterialize();
+	GetSelection(selection_data, info, &clipData->text);
 }
 
 void ScintillaGTK::ClipboardClearSelection(GtkClipboard *, void *data) {
-	SelectionText *obj = static_cast<SelectionText*>(data);
-	delete obj;
+	ClipboardData *clipData = static_cast<ClipboardData *>(data);
+	if (clipData->sci && clipData->sci->pendingClipboard == clipData)
+		clipData->sci->pendingClipboard = 0;
+	delete clipData;
 }
 
 void ScintillaGTK::UnclaimSelection(GdkEventSelection *selection_event) {
@@ -1835,6 +2201,12 @@ gint ScintillaGTK::PressThis(GdkEventButton *event) {
 		if (event->type != GDK_BUTTON_PRESS)
 			return FALSE;
 
+		// While an incremental paste is trickling in, a click would move the
+		// caret and middle-click paste would edit inside the pasted text, so
+		// mouse input is ignored until the paste completes.
+		if (pasteIdleID)
+			return TRUE;
+
 		if (evbtn) {
 			gdk_event_free(reinterpret_cast<GdkEvent *>(evbtn));
 			evbtn = 0;
@@ -1999,9 +2371,35 @@ gint ScintillaGTK::ScrollEvent(GtkWidget *widget, GdkEventScroll *event) {
 		}
 
 #if GTK_CHECK_VERSION(3,4,0)
-		// Smooth scrolling not supported
 		if (event->direction == GDK_SCROLL_SMOOTH) {
-			return FALSE;
+			// Data zoom not supported on the smooth path either
+			if (event->state & GDK_CONTROL_MASK) {
+				return FALSE;
+			}
+			// Smooth scroll devices (touchpads, high-rate wheels) report
+			// fractional deltas at high frequency; accumulate them and scroll
+			// by whole lines and columns as each boundary is crossed so no
+			// movement is lost between events.
+			gdouble dx = 0;
+			gdouble dy = 0;
+			gdk_event_get_scroll_deltas(reinterpret_cast<GdkEvent *>(event), &dx, &dy);
+			int lines = sciThis->linesPerScroll;
+			if (lines == 0)
+				lines = 4;
+			sciThis->smoothScrollY += dy * lines;
+			sciThis->smoothScrollX += dx * lines;
+			const int linesToScroll = static_cast<int>(sciThis->smoothScrollY);
+			const int columnsToScroll = static_cast<int>(sciThis->smoothScrollX);
+			sciThis->smoothScrollY -= linesToScroll;
+			sciThis->smoothScrollX -= columnsToScroll;
+			if (linesToScroll) {
+				sciThis->ScrollTo(sciThis->topLine + linesToScroll);
+			}
+			if (columnsToScroll) {
+				sciThis->HorizontalScrollTo(sciThis->xOffset +
+					columnsToScroll * static_cast<int>(sciThis->vs.aveCharWidth));
+			}
+			return TRUE;
 		}
 #endif
 
@@ -2209,9 +2607,41 @@ gboolean ScintillaGTK::KeyThis(GdkEventKey *event) {
 	try {
 		//fprintf(stderr, "SC-key: %d %x [%s]\n",
 		//	event->keyval, event->state, (event->length > 0) ? event->string : "empty");
+		// While an incremental paste is trickling in, typing would land inside
+		// the pasted text and be swallowed into its single undo action, so
+		// keys are ignored until the paste completes.
+		if (pasteIdleID)
+			return 1;
+		// Fast path for plain printable ASCII typing: when the input method cannot
+		// be holding uncommitted state, insert the character directly instead of
+		// routing it through the IM context only to have it committed straight back.
+		// ASCII is represented identically in every supported character set, so the
+		// locale conversion done for committed text is not needed here.
+		if (!imComposePossible &&
+			(event->state & gtk_accelerator_get_default_mod_mask() & ~GDK_SHIFT_MASK) == 0 &&
+			event->keyval >= 0x20 && event->keyval < 0x7F &&
+			kmap.Find(event->keyval,
+				(event->state & GDK_SHIFT_MASK) ? SCI_SHIFT : SCI_NORM) == 0) {
+			char ch[2] = { static_cast<char>(event->keyval), '\0' };
+			view.imeCaretBlockOverride = false;
+			AddCharUTF(ch, 1);
+			ShowCaretAtCurrentPosition();
+			return 1;
+		}
+		// Assume the IM may have swallowed the key as the start of a compose or
+		// preedit sequence; only a commit arriving synchronously from the filter
+		// call below (simple input methods resolving the key in-process) clears
+		// the assumption in CommitThis. Neither a commit delivered later by an
+		// IM daemon (ibus, fcitx) nor the filter declining the key proves
+		// anything about the next one: a daemon passes keys through while
+		// disabled but can be switched to composing without the widget noticing.
+		imComposePossible = true;
+		imFilterInProgress = true;
 		if (gtk_im_context_filter_keypress(im_context, event)) {
+			imFilterInProgress = false;
 			return 1;
 		}
+		imFilterInProgress = false;
 		if (!event->keyval) {
 			return true;
 		}
@@ -2353,6 +2783,15 @@ bool ScintillaGTK::KoreanIME() {
 void ScintillaGTK::CommitThis(char *utfVal) {
 	try {
 		//~ fprintf(stderr, "Commit '%s'\n", utfVal);
+		// Drop input method commits arriving while an incremental paste is
+		// trickling in, like raw key and mouse input is dropped then
+		if (pasteIdleID)
+			return;
+		// A synchronous commit means the input method resolved the filtered key
+		// immediately and holds no state, so the next plain key may bypass it.
+		// An asynchronous commit says nothing about future keys.
+		if (imFilterInProgress)
+			imComposePossible = false;
 		if (pdoc->TentativeActive()) {
 			pdoc->TentativeUndo();
 		}
@@ -2535,6 +2974,7 @@ void ScintillaGTK::Destroy(GObject *object) {
 
 gboolean ScintillaGTK::DrawTextThis(cairo_t *cr) {
 	try {
+		CaretOverlayDrop();
 		paintState = painting;
 		repaintFullWindow = false;
 
@@ -2618,6 +3058,7 @@ gboolean ScintillaGTK::DrawMain(GtkWidget *widget, cairo_t *cr) {
 
 gboolean ScintillaGTK::ExposeTextThis(GtkWidget * /*widget*/, GdkEventExpose *ose) {
 	try {
+		CaretOverlayDrop();
 		paintState = painting;
 
 		rcPaint.left = ose->area.x;
@@ -3013,9 +3454,9 @@ GType scintilla_get_type() {
 
 void ScintillaGTK::ClassInit(OBJECT_CLASS* object_class, GtkWidgetClass *widget_class, GtkContainerClass *container_class) {
 	Platform_Initialise();
-#ifdef SCI_LEXER
-	Scintilla_LinkLexers();
-#endif
+	// Lexer registration is not forced here: Catalogue::Find links the lexers on
+	// the first lookup, so sessions pay for the catalogue only once a lexer is
+	// actually selected.
 	atomClipboard = gdk_atom_intern("CLIPBOARD", FALSE);
 	atomUTF8 = gdk_atom_intern("UTF8_STRING", FALSE);
 	atomString = GDK_SELECTION_TYPE_STRING;
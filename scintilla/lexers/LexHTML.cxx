@@ -600,13 +600,21 @@ static void ColouriseHyperTextDoc(unsigned int startPos, int length, int initSty
 	}
 	// String can be heredoc, must find a delimiter first. Reread from beginning of line containing the string, to get the correct lineState
 	if (isPHPStringState(state)) {
-		while (startPos > 0 && (isPHPStringState(state) || !isLineEnd(styler[startPos - 1]))) {
-			startPos--;
-			length++;
-			state = styler.StyleAt(startPos);
+		// Walk back a line at a time rather than a byte at a time: the rewind target
+		// is the start of the first line whose initial character is outside the
+		// string, so only line-start styles need to be inspected. This keeps
+		// restyles inside a large heredoc from re-reading the whole string body.
+		int stringLine = styler.GetLine(startPos);
+		while (stringLine > 0 && isPHPStringState(styler.StyleAt(styler.LineStart(stringLine)))) {
+			stringLine--;
 		}
+		const int stringLineStart = styler.LineStart(stringLine);
+		length += startPos - stringLineStart;
+		startPos = stringLineStart;
 		if (startPos == 0)
 			state = SCE_H_DEFAULT;
+		else
+			state = styler.StyleAt(startPos);
 	}
 	styler.StartAt(startPos);
 
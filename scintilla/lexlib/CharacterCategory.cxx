@@ -3278,6 +3278,18 @@ const int maxUnicode = 0x10ffff;
 const int maskCategory = 0x1F;
 const int nRanges = ELEMENTS(catRanges);
 
+// Direct lookup table for the Basic Latin through Arabic blocks which cover
+// most text seen in practice, filled from catRanges on first use.
+const int maxLatin = 0xfff;
+unsigned char categoryLatin[maxLatin + 1];
+bool initialisedCategoryLatin = false;
+
+CharacterCategory SearchCharacterCategory(int character) {
+	const int baseValue = character * (maskCategory+1) + maskCategory;
+	const int *placeAfter = std::lower_bound(catRanges, catRanges+nRanges, baseValue);
+	return static_cast<CharacterCategory>(*(placeAfter-1) & maskCategory);
+}
+
 }
 
 // Each element in catRanges is the start of a range of Unicode characters in
@@ -3287,16 +3299,21 @@ const int nRanges = ELEMENTS(catRanges);
 // Initial version has 3249 entries and adds about 13K to the executable.
 // The array is in ascending order so can be searched using binary search.
 // Therefore the average call takes log2(3249) = 12 comparisons.
-// For speed, it may be useful to make a linear table for the common values,
-// possibly for 0..0xff for most Western European text or 0..0xfff for most
-// alphabetic languages.
+// Characters up to maxLatin are the common case and answered from a direct
+// table instead, built lazily with the binary search on the first call.
 
 CharacterCategory CategoriseCharacter(int character) {
 	if (character < 0 || character > maxUnicode)
 		return ccCn;
-	const int baseValue = character * (maskCategory+1) + maskCategory;
-	const int *placeAfter = std::lower_bound(catRanges, catRanges+nRanges, baseValue);
-	return static_cast<CharacterCategory>(*(placeAfter-1) & maskCategory);
+	if (character <= maxLatin) {
+		if (!initialisedCategoryLatin) {
+			for (int ch = 0; ch <= maxLatin; ch++)
+				categoryLatin[ch] = static_cast<unsigned char>(SearchCharacterCategory(ch));
+			initialisedCategoryLatin = true;
+		}
+		return static_cast<CharacterCategory>(categoryLatin[character]);
+	}
+	return SearchCharacterCategory(character);
 }
 
 #ifdef SCI_NAMESPACE
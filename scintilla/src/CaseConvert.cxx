@@ -389,9 +389,22 @@ class CaseConverter : public ICaseConverter {
 	// The parallel arrays
 	std::vector<int> characters;
 	std::vector<ConversionString> conversions;
+	// Bulk path for runs of ASCII characters, precomputed by FinishedAdding.
+	// asciiKind describes the shape of the table's ASCII mappings: the usual
+	// conversions shift letters by 0x20, which can be applied to a machine
+	// word of bytes at once; asciiTo covers any other single byte mapping and
+	// asciiSimple is false for characters converting to more than one byte.
+	enum AsciiKind { asciiIdentity, asciiToUpper, asciiToLower, asciiOther };
+	AsciiKind asciiKind;
+	char asciiTo[128];
+	bool asciiSimple[128];
 
 public:
-	CaseConverter() {
+	CaseConverter() : asciiKind(asciiIdentity) {
+		for (int ch=0; ch<128; ch++) {
+			asciiTo[ch] = static_cast<char>(ch);
+			asciiSimple[ch] = true;
+		}
 	}
 	bool Initialised() const {
 		return characters.size() > 0;
@@ -408,12 +421,63 @@ public:
 		else
 			return 0;
 	}
+	// Converts a run of ASCII bytes in one pass, a machine word at a time
+	// where the conversion is a plain letter shift. Returns the number of
+	// bytes converted, stopping early at a non-ASCII byte or at a character
+	// whose conversion is longer than one byte.
+	size_t CaseConvertASCII(char *converted, const char *mixed, size_t len) const {
+		size_t pos = 0;
+		if (asciiKind == asciiToUpper || asciiKind == asciiToLower) {
+			const size_t wordSize = sizeof(size_t);
+			const size_t ones = ~static_cast<size_t>(0) / 0xff;
+			const size_t highs = ones * 0x80;
+			const size_t first = (asciiKind == asciiToUpper) ? 'a' : 'A';
+			while (pos + wordSize <= len) {
+				size_t w;
+				memcpy(&w, mixed + pos, wordSize);
+				if (w & highs)
+					break;	// non-ASCII byte somewhere in the word
+				// set the high bit of each byte holding a convertible letter;
+				// no carry crosses byte lanes as every byte is below 0x80
+				const size_t ge = w + ones * (0x80 - first);
+				const size_t gt = w + ones * (0x80 - (first + 26));
+				const size_t letters = (ge & ~gt) & highs;
+				w ^= letters >> 2;	// 0x80>>2 == 0x20: flip the case bit
+				memcpy(converted + pos, &w, wordSize);
+				pos += wordSize;
+			}
+		}
+		while (pos < len) {
+			const unsigned char ch = static_cast<unsigned char>(mixed[pos]);
+			if (ch >= 0x80 || !asciiSimple[ch])
+				break;
+			converted[pos] = asciiTo[ch];
+			pos++;
+		}
+		return pos;
+	}
 	size_t CaseConvertString(char *converted, size_t sizeConverted, const char *mixed, size_t lenMixed) {
 		size_t lenConverted = 0;
 		size_t mixedPos = 0;
 		unsigned char bytes[UTF8MaxBytes + 1];
 		while (mixedPos < lenMixed) {
 			const unsigned char leadByte = static_cast<unsigned char>(mixed[mixedPos]);
+			if (UTF8IsAscii(leadByte)) {
+				// Bulk convert as much of the ASCII run as the output allows;
+				// ASCII converts byte for byte so input and output lengths match
+				const size_t space = sizeConverted - lenConverted;
+				const size_t maxRun = std::min(lenMixed - mixedPos, space);
+				const size_t lenRun = CaseConvertASCII(converted + lenConverted,
+					mixed + mixedPos, maxRun);
+				lenConverted += lenRun;
+				mixedPos += lenRun;
+				if (lenConverted >= sizeConverted)
+					return 0;
+				if (lenRun)
+					continue;
+				// an ASCII character with a multi-byte conversion:
+				// fall through to the generic path
+			}
 			const char *caseConverted = 0;
 			size_t lenMixedChar = 1;
 			if (UTF8IsAscii(leadByte)) {
@@ -461,6 +525,46 @@ public:
 		}
 		// Empty the original calculated data completely
 		CharacterToConversion().swap(characterToConversion);
+		PrecomputeASCII();
+	}
+
+private:
+	void PrecomputeASCII() {
+		bool allSimple = true;
+		for (int ch=0; ch<128; ch++) {
+			const char *conv = Find(ch);
+			asciiTo[ch] = static_cast<char>(ch);
+			asciiSimple[ch] = true;
+			if (conv) {
+				if (conv[0] && !conv[1]) {
+					asciiTo[ch] = conv[0];
+				} else {
+					asciiSimple[ch] = false;
+					allSimple = false;
+				}
+			}
+		}
+		asciiKind = asciiOther;
+		if (allSimple) {
+			bool isIdentity = true;
+			bool isUpper = true;
+			bool isLower = true;
+			for (int ch=0; ch<128; ch++) {
+				const char toUpper = (ch >= 'a' && ch <= 'z') ?
+					static_cast<char>(ch - 0x20) : static_cast<char>(ch);
+				const char toLower = (ch >= 'A' && ch <= 'Z') ?
+					static_cast<char>(ch + 0x20) : static_cast<char>(ch);
+				isIdentity = isIdentity && (asciiTo[ch] == static_cast<char>(ch));
+				isUpper = isUpper && (asciiTo[ch] == toUpper);
+				isLower = isLower && (asciiTo[ch] == toLower);
+			}
+			if (isIdentity)
+				asciiKind = asciiIdentity;
+			else if (isUpper)
+				asciiKind = asciiToUpper;
+			else if (isLower)
+				asciiKind = asciiToLower;
+		}
 	}
 };
 
@@ -64,6 +64,9 @@ void Catalogue::AddLexerModule(LexerModule *plm) {
 
 // Force a reference to all of the Scintilla lexers so that the linker will
 // not remove the code of the lexers.
+// Called lazily from Catalogue::Find rather than at startup: each LexerModule
+// is only a factory stub, so until a lexer is looked up the catalogue costs
+// nothing beyond the static module objects themselves.
 int Scintilla_LinkLexers() {
 
 	static int initialised = 0;
@@ -11,6 +11,7 @@
 #include <stdarg.h>
 
 #include <algorithm>
+#include <vector>
 
 #include "Platform.h"
 
@@ -34,6 +35,9 @@ LineVector::~LineVector() {
 
 void LineVector::Init() {
 	starts.DeleteAll();
+	longestLine = 0;
+	longestLineLength = 0;
+	longestLineValid = false;
 	if (perLine) {
 		perLine->Init();
 	}
@@ -43,12 +47,47 @@ void LineVector::SetPerLine(PerLine *pl) {
 	perLine = pl;
 }
 
+void LineVector::RecalculateLongestLine() {
+	longestLine = 0;
+	longestLineLength = 0;
+	const int lineCount = Lines();
+	int startNext = starts.PositionFromPartition(0);
+	for (int line = 0; line < lineCount; line++) {
+		const int start = startNext;
+		startNext = starts.PositionFromPartition(line + 1);
+		if (startNext - start > longestLineLength) {
+			longestLine = line;
+			longestLineLength = startNext - start;
+		}
+	}
+	longestLineValid = true;
+}
+
 void LineVector::InsertText(int line, int delta) {
 	starts.InsertText(line, delta);
+	if (longestLineValid) {
+		if (line == longestLine) {
+			if (delta >= 0)
+				longestLineLength += delta;
+			else	// may no longer be the longest so rescan on next query
+				longestLineValid = false;
+		} else if (LineLength(line) > longestLineLength) {
+			longestLine = line;
+			longestLineLength = LineLength(line);
+		}
+	}
 }
 
 void LineVector::InsertLine(int line, int position, bool lineStart) {
 	starts.InsertPartition(line, position);
+	if (longestLineValid) {
+		if (longestLine == line - 1) {
+			// the longest line has been split so rescan on next query
+			longestLineValid = false;
+		} else if (longestLine >= line) {
+			longestLine++;
+		}
+	}
 	if (perLine) {
 		if ((line > 0) && lineStart)
 			line--;
@@ -56,12 +95,44 @@ void LineVector::InsertLine(int line, int position, bool lineStart) {
 	}
 }
 
+// Insert a run of consecutive lines in one go.  Semantically the same as
+// calling InsertLine once per position but builds the partition array with a
+// single bulk insertion, which avoids rebalancing it once per line when a
+// file load inserts the whole document at one point.
+void LineVector::InsertLines(int line, const int *positions, int lines, bool lineStart) {
+	starts.InsertPartitions(line, positions, lines);
+	// any of the new lines may now be the longest
+	longestLineValid = false;
+	if (perLine) {
+		if ((line > 0) && lineStart)
+			line--;
+		for (int l = 0; l < lines; l++)
+			perLine->InsertLine(line + l);
+	}
+}
+
 void LineVector::SetLineStart(int line, int position) {
 	starts.SetPartitionStartPosition(line, position);
+	// moves the boundary between two lines so either may become the longest
+	longestLineValid = false;
 }
 
 void LineVector::RemoveLine(int line) {
 	starts.RemovePartition(line);
+	if (longestLineValid) {
+		if (line == longestLine) {
+			longestLineValid = false;
+		} else {
+			if (line < longestLine)
+				longestLine--;
+			// the removed line was merged into its predecessor which may
+			// now be the longest
+			if ((line > 0) && (LineLength(line - 1) > longestLineLength)) {
+				longestLine = line - 1;
+				longestLineLength = LineLength(line - 1);
+			}
+		}
+	}
 	if (perLine) {
 		perLine->RemoveLine(line);
 	}
@@ -71,11 +142,91 @@ int LineVector::LineFromPosition(int pos) const {
 	return starts.PartitionFromPosition(pos);
 }
 
+// Simple byte-oriented LZSS compression used to shrink the text runs held in the
+// undo history. Each group is a control byte followed by eight items, LSB first:
+// a clear bit is a literal byte, a set bit is a two byte reference with a 12 bit
+// offset (1..4095) and a 4 bit length (3..18) into the already decoded output.
+
+static const int lzMinMatch = 3;
+static const int lzMaxMatch = 18;
+static const int lzWindow = 4095;
+
+// Returns the compressed length or -1 if the output does not fit in lenDstMax.
+static int CompressRun(const char *src, int lenSrc, char *dst, int lenDstMax) {
+	int hashTable[4096];
+	for (int i = 0; i < 4096; i++)
+		hashTable[i] = -1;
+	int posSrc = 0;
+	int posDst = 0;
+	while (posSrc < lenSrc) {
+		if (posDst >= lenDstMax)
+			return -1;
+		const int posFlags = posDst++;
+		unsigned char flags = 0;
+		for (int bit = 0; (bit < 8) && (posSrc < lenSrc); bit++) {
+			bool matched = false;
+			if (posSrc + lzMinMatch <= lenSrc) {
+				const unsigned int hash = ((static_cast<unsigned char>(src[posSrc]) << 7) ^
+					(static_cast<unsigned char>(src[posSrc + 1]) << 4) ^
+					static_cast<unsigned char>(src[posSrc + 2])) & 4095;
+				const int posMatch = hashTable[hash];
+				hashTable[hash] = posSrc;
+				if ((posMatch >= 0) && ((posSrc - posMatch) <= lzWindow)) {
+					const int lenLimit = Platform::Minimum(lzMaxMatch, lenSrc - posSrc);
+					int lenMatch = 0;
+					while ((lenMatch < lenLimit) &&
+						(src[posMatch + lenMatch] == src[posSrc + lenMatch]))
+						lenMatch++;
+					if (lenMatch >= lzMinMatch) {
+						if (posDst + 2 > lenDstMax)
+							return -1;
+						const int offset = posSrc - posMatch;
+						dst[posDst++] = static_cast<char>(offset & 0xff);
+						dst[posDst++] = static_cast<char>(((offset >> 8) << 4) | (lenMatch - lzMinMatch));
+						flags = static_cast<unsigned char>(flags | (1 << bit));
+						posSrc += lenMatch;
+						matched = true;
+					}
+				}
+			}
+			if (!matched) {
+				if (posDst >= lenDstMax)
+					return -1;
+				dst[posDst++] = src[posSrc++];
+			}
+		}
+		dst[posFlags] = static_cast<char>(flags);
+	}
+	return posDst;
+}
+
+static void DecompressRun(const char *src, char *dst, int lenDst) {
+	int posSrc = 0;
+	int posDst = 0;
+	while (posDst < lenDst) {
+		const unsigned char flags = static_cast<unsigned char>(src[posSrc++]);
+		for (int bit = 0; (bit < 8) && (posDst < lenDst); bit++) {
+			if (flags & (1 << bit)) {
+				const unsigned char b0 = static_cast<unsigned char>(src[posSrc]);
+				const unsigned char b1 = static_cast<unsigned char>(src[posSrc + 1]);
+				posSrc += 2;
+				const int offset = b0 | ((b1 >> 4) << 8);
+				const int lenMatch = (b1 & 0xf) + lzMinMatch;
+				for (int i = 0; i < lenMatch; i++, posDst++)
+					dst[posDst] = dst[posDst - offset];
+			} else {
+				dst[posDst++] = src[posSrc++];
+			}
+		}
+	}
+}
+
 Action::Action() {
 	at = startAction;
 	position = 0;
 	data = 0;
 	lenData = 0;
+	lenDataCompressed = 0;
 	mayCoalesce = false;
 }
 
@@ -93,12 +244,39 @@ void Action::Create(actionType at_, int position_, const char *data_, int lenDat
 		memcpy(data, data_, lenData_);
 	}
 	lenData = lenData_;
+	lenDataCompressed = 0;
 	mayCoalesce = mayCoalesce_;
 }
 
 void Action::Destroy() {
 	delete []data;
 	data = 0;
+	lenDataCompressed = 0;
+}
+
+void Action::Compress() {
+	// Only worthwhile for larger runs; very short runs rarely shrink
+	if (!data || lenDataCompressed || (lenData < 64))
+		return;
+	char *compressed = new char[lenData - 1];
+	const int lenCompressed = CompressRun(data, lenData, compressed, lenData - 1);
+	if (lenCompressed > 0) {
+		delete []data;
+		data = new char[lenCompressed];
+		memcpy(data, compressed, lenCompressed);
+		lenDataCompressed = lenCompressed;
+	}
+	delete []compressed;
+}
+
+void Action::Decompress() {
+	if (!lenDataCompressed)
+		return;
+	char *raw = new char[lenData];
+	DecompressRun(data, raw, lenData);
+	delete []data;
+	data = raw;
+	lenDataCompressed = 0;
 }
 
 void Action::Grab(Action *source) {
@@ -108,6 +286,7 @@ void Action::Grab(Action *source) {
 	at = source->at;
 	data = source->data;
 	lenData = source->lenData;
+	lenDataCompressed = source->lenDataCompressed;
 	mayCoalesce = source->mayCoalesce;
 
 	// Ownership of source data transferred to this
@@ -115,6 +294,7 @@ void Action::Grab(Action *source) {
 	source->at = startAction;
 	source->data = 0;
 	source->lenData = 0;
+	source->lenDataCompressed = 0;
 	source->mayCoalesce = true;
 }
 
@@ -242,9 +422,19 @@ const char *UndoHistory::AppendAction(actionType at, int position, const char *d
 	currentAction++;
 	actions[currentAction].Create(startAction);
 	maxAction = currentAction;
+	// The action just stored must stay verbatim as its data pointer is returned,
+	// but the one before it is now cold so its text can be compressed. This keeps
+	// the memory held by bulk operations like a large replace-all bounded.
+	if (actionWithData >= 2)
+		actions[actionWithData - 1].Compress();
 	return actions[actionWithData].data;
 }
 
+void UndoHistory::DecompressRange(int actFirst, int actLast) {
+	for (int act = actFirst; act <= actLast; act++)
+		actions[act].Decompress();
+}
+
 void UndoHistory::BeginUndoAction() {
 	EnsureUndoRoom();
 	if (undoSequenceDepth == 0) {
@@ -308,10 +498,13 @@ int UndoHistory::TentativeSteps() {
 	// Drop any trailing startAction
 	if (actions[currentAction].at == startAction && currentAction > 0)
 		currentAction--;
-	if (tentativePoint >= 0)
+	if (tentativePoint >= 0) {
+		// The steps about to be retrieved need their text verbatim
+		DecompressRange(tentativePoint + 1, currentAction);
 		return currentAction - tentativePoint;
-	else
+	} else {
 		return -1;
+	}
 }
 
 bool UndoHistory::CanUndo() const {
@@ -328,6 +521,8 @@ int UndoHistory::StartUndo() {
 	while (actions[act].at != startAction && act > 0) {
 		act--;
 	}
+	// The steps about to be retrieved need their text verbatim
+	DecompressRange(act + 1, currentAction);
 	return currentAction - act;
 }
 
@@ -353,6 +548,8 @@ int UndoHistory::StartRedo() {
 	while (actions[act].at != startAction && act < maxAction) {
 		act++;
 	}
+	// The steps about to be retrieved need their text verbatim
+	DecompressRange(currentAction, act - 1);
 	return act - currentAction;
 }
 
@@ -364,6 +561,141 @@ void UndoHistory::CompletedRedoStep() {
 	currentAction++;
 }
 
+// The serialized form is a header of {version, maxAction, currentAction} followed
+// by each action as {at, position, lenData, lenDataCompressed, mayCoalesce byte,
+// data}. Compressed runs are stored still compressed. Integers use the host's
+// native representation: the container keys the serialized history by buffer
+// content and treats it as a local cache, not an interchange format.
+
+static const int undoSerializeVersion = 1;
+
+static void SerializeInt(char *&p, int value) {
+	memcpy(p, &value, sizeof(int));
+	p += sizeof(int);
+}
+
+static bool DeserializeInt(const char *&p, const char *end, int *value) {
+	if ((end - p) < static_cast<int>(sizeof(int)))
+		return false;
+	memcpy(value, p, sizeof(int));
+	p += sizeof(int);
+	return true;
+}
+
+int UndoHistory::SerializedLength() const {
+	int len = 3 * static_cast<int>(sizeof(int));
+	for (int act = 0; act <= maxAction; act++) {
+		const Action &action = actions[act];
+		len += 4 * static_cast<int>(sizeof(int)) + 1;
+		if (action.data)
+			len += action.lenDataCompressed ? action.lenDataCompressed : action.lenData;
+	}
+	return len;
+}
+
+void UndoHistory::Serialize(char *buf) const {
+	char *p = buf;
+	SerializeInt(p, undoSerializeVersion);
+	SerializeInt(p, maxAction);
+	SerializeInt(p, currentAction);
+	for (int act = 0; act <= maxAction; act++) {
+		const Action &action = actions[act];
+		SerializeInt(p, action.at);
+		SerializeInt(p, action.position);
+		SerializeInt(p, action.data ? action.lenData : 0);
+		SerializeInt(p, action.lenDataCompressed);
+		*p++ = action.mayCoalesce ? 1 : 0;
+		if (action.data) {
+			const int stored = action.lenDataCompressed ? action.lenDataCompressed : action.lenData;
+			memcpy(p, action.data, stored);
+			p += stored;
+		}
+	}
+}
+
+bool UndoHistory::Deserialize(const char *buf, int len, int *undoSteps) {
+	const char *end = buf + len;
+	const char *p = buf;
+	int version, maxActionNew, currentActionNew;
+
+	if (!DeserializeInt(p, end, &version) || (version != undoSerializeVersion))
+		return false;
+	if (!DeserializeInt(p, end, &maxActionNew) || (maxActionNew < 0))
+		return false;
+	if (!DeserializeInt(p, end, &currentActionNew) ||
+		(currentActionNew < 0) || (currentActionNew > maxActionNew))
+		return false;
+
+	// Validate the whole stream before touching the current history so a
+	// truncated or corrupt file leaves the history untouched.
+	const char *pActions = p;
+	for (int act = 0; act <= maxActionNew; act++) {
+		int at, position, lenData, lenDataCompressed;
+		if (!DeserializeInt(p, end, &at) ||
+			(at < insertAction) || (at > containerAction))
+			return false;
+		if (!DeserializeInt(p, end, &position))
+			return false;
+		if (!DeserializeInt(p, end, &lenData) || (lenData < 0))
+			return false;
+		if (!DeserializeInt(p, end, &lenDataCompressed) ||
+			(lenDataCompressed < 0) || (lenDataCompressed > lenData))
+			return false;
+		if ((end - p) < 1)
+			return false;
+		p++;
+		const int stored = lenDataCompressed ? lenDataCompressed : lenData;
+		if ((end - p) < stored)
+			return false;
+		p += stored;
+	}
+
+	Action *actionsNew = new Action[maxActionNew + 3];
+	p = pActions;
+	for (int act = 0; act <= maxActionNew; act++) {
+		Action &action = actionsNew[act];
+		int value;
+		DeserializeInt(p, end, &value);
+		action.at = static_cast<actionType>(value);
+		DeserializeInt(p, end, &action.position);
+		DeserializeInt(p, end, &action.lenData);
+		DeserializeInt(p, end, &action.lenDataCompressed);
+		action.mayCoalesce = *p++ != 0;
+		const int stored = action.lenDataCompressed ? action.lenDataCompressed : action.lenData;
+		if (stored > 0) {
+			action.data = new char[stored];
+			memcpy(action.data, p, stored);
+			p += stored;
+		}
+	}
+
+	delete []actions;
+	actions = actionsNew;
+	lenActions = maxActionNew + 3;
+	maxAction = maxActionNew;
+	currentAction = currentActionNew;
+	undoSequenceDepth = 0;
+	// The container restores onto a buffer identical to the serialized state
+	savePoint = currentAction;
+	tentativePoint = -1;
+
+	// Count the undo steps now available: each maximal run of non-start
+	// actions at or below currentAction is one step.
+	int steps = 0;
+	bool inRun = false;
+	for (int act = 0; act <= currentAction; act++) {
+		if (actions[act].at == startAction)
+			inRun = false;
+		else {
+			if (!inRun)
+				steps++;
+			inRun = true;
+		}
+	}
+	*undoSteps = steps;
+	return true;
+}
+
 CellBuffer::CellBuffer() {
 	readOnly = false;
 	utf8LineEnds = 0;
@@ -446,18 +778,22 @@ bool CellBuffer::SetStyleAt(int position, char styleValue) {
 }
 
 bool CellBuffer::SetStyleFor(int position, int lengthStyle, char styleValue) {
-	bool changed = false;
 	PLATFORM_ASSERT(lengthStyle == 0 ||
 		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
-	while (lengthStyle--) {
-		char curVal = style.ValueAt(position);
-		if (curVal != styleValue) {
-			style.SetValueAt(position, styleValue);
-			changed = true;
-		}
-		position++;
-	}
-	return changed;
+	if (lengthStyle <= 0)
+		return false;
+	// Work on the contiguous range directly rather than calling
+	// ValueAt/SetValueAt per byte: scan for the first differing byte and
+	// fill from there in one block.  Styling passes apply runs over the
+	// whole document so this is a hot path.
+	char *range = style.RangePointer(position, lengthStyle);
+	int lengthSame = 0;
+	while ((lengthSame < lengthStyle) && (range[lengthSame] == styleValue))
+		lengthSame++;
+	if (lengthSame == lengthStyle)
+		return false;
+	memset(range + lengthSame, styleValue, lengthStyle - lengthSame);
+	return true;
 }
 
 // The char* returned is to an allocation owned by the undo history
@@ -511,6 +847,14 @@ int CellBuffer::LineStart(int line) const {
 		return lv.LineStart(line);
 }
 
+int CellBuffer::LongestLine() {
+	return lv.LongestLine();
+}
+
+int CellBuffer::LongestLineLength() {
+	return lv.LongestLineLength();
+}
+
 bool CellBuffer::IsReadOnly() const {
 	return readOnly;
 }
@@ -549,6 +893,10 @@ void CellBuffer::InsertLine(int line, int position, bool lineStart) {
 	lv.InsertLine(line, position, lineStart);
 }
 
+void CellBuffer::InsertLines(int line, const int *positions, int lines, bool lineStart) {
+	lv.InsertLines(line, positions, lines, lineStart);
+}
+
 void CellBuffer::RemoveLine(int line) {
 	lv.RemoveLine(line);
 }
@@ -628,28 +976,71 @@ void CellBuffer::BasicInsertString(int position, const char *s, int insertLength
 		RemoveLine(lineInsert);
 	}
 	unsigned char ch = ' ';
-	for (int i = 0; i < insertLength; i++) {
-		ch = s[i];
-		if (ch == '\r') {
-			InsertLine(lineInsert, (position + i) + 1, atLineStart);
-			lineInsert++;
-		} else if (ch == '\n') {
-			if (chPrev == '\r') {
-				// Patch up what was end of line
-				lv.SetLineStart(lineInsert - 1, (position + i) + 1);
+	if (!utf8LineEnds) {
+		// Fast path for the common case where only \r, \n and \r\n can form line ends:
+		// let memchr skip over the text between line ends instead of examining
+		// every byte, and collect the new line starts first so they can be added
+		// with a single bulk partition insertion instead of one rebalancing
+		// insert per line.  Semantics are identical to the general loop below.
+		std::vector<int> lineStarts;
+		const char *eolSearch = s;
+		const char *eolEnd = s + insertLength;
+		for (;;) {
+			const char *cr = static_cast<const char *>(
+				memchr(eolSearch, '\r', eolEnd - eolSearch));
+			const char *lf = static_cast<const char *>(
+				memchr(eolSearch, '\n', (cr ? cr : eolEnd) - eolSearch));
+			const char *found = lf ? lf : cr;
+			if (!found)
+				break;
+			const int i = static_cast<int>(found - s);
+			if (*found == '\r') {
+				lineStarts.push_back((position + i) + 1);
 			} else {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
+				const unsigned char chBefore = (i > 0) ?
+					static_cast<unsigned char>(s[i - 1]) : chPrev;
+				if (chBefore == '\r') {
+					// Patch up what was end of line
+					if (!lineStarts.empty())
+						lineStarts.back() = (position + i) + 1;
+					else
+						lv.SetLineStart(lineInsert - 1, (position + i) + 1);
+				} else {
+					lineStarts.push_back((position + i) + 1);
+				}
 			}
-		} else if (utf8LineEnds) {
-			unsigned char back3[3] = {chBeforePrev, chPrev, ch};
-			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
+			eolSearch = found + 1;
+		}
+		if (!lineStarts.empty()) {
+			InsertLines(lineInsert, &lineStarts[0],
+				static_cast<int>(lineStarts.size()), atLineStart);
+			lineInsert += static_cast<int>(lineStarts.size());
+		}
+		ch = static_cast<unsigned char>(s[insertLength - 1]);
+	} else {
+		for (int i = 0; i < insertLength; i++) {
+			ch = s[i];
+			if (ch == '\r') {
 				InsertLine(lineInsert, (position + i) + 1, atLineStart);
 				lineInsert++;
+			} else if (ch == '\n') {
+				if (chPrev == '\r') {
+					// Patch up what was end of line
+					lv.SetLineStart(lineInsert - 1, (position + i) + 1);
+				} else {
+					InsertLine(lineInsert, (position + i) + 1, atLineStart);
+					lineInsert++;
+				}
+			} else {
+				unsigned char back3[3] = {chBeforePrev, chPrev, ch};
+				if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
+					InsertLine(lineInsert, (position + i) + 1, atLineStart);
+					lineInsert++;
+				}
 			}
+			chBeforePrev = chPrev;
+			chPrev = ch;
 		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
 	}
 	// Joining two lines where last insertion is cr and following substance starts with lf
 	if (chAfter == '\n') {
@@ -707,29 +1098,62 @@ void CellBuffer::BasicDeleteChars(int position, int deleteLength) {
 		}
 
 		unsigned char ch = chNext;
-		for (int i = 0; i < deleteLength; i++) {
-			chNext = substance.ValueAt(position + i + 1);
-			if (ch == '\r') {
-				if (chNext != '\n') {
-					RemoveLine(lineRemove);
-				}
-			} else if (ch == '\n') {
-				if (ignoreNL) {
-					ignoreNL = false; 	// Further \n are real deletions
+		if (!utf8LineEnds) {
+			// Fast path for the common case where only \r, \n and \r\n can form line
+			// ends: scan a contiguous pointer to the removed range with memchr instead
+			// of examining every byte.  Semantics are identical to the general loop
+			// below.  The gap is moved to position for the deletion anyway so getting
+			// the range pointer does not cost extra.
+			const char *data = substance.RangePointer(position, deleteLength);
+			const char *eolSearch = data;
+			const char *eolEnd = data + deleteLength;
+			for (;;) {
+				const char *cr = static_cast<const char *>(
+					memchr(eolSearch, '\r', eolEnd - eolSearch));
+				const char *lf = static_cast<const char *>(
+					memchr(eolSearch, '\n', (cr ? cr : eolEnd) - eolSearch));
+				const char *found = lf ? lf : cr;
+				if (!found)
+					break;
+				if (*found == '\r') {
+					const unsigned char chFollow = (found + 1 < eolEnd) ?
+						static_cast<unsigned char>(found[1]) :
+						static_cast<unsigned char>(substance.ValueAt(position + deleteLength));
+					if (chFollow != '\n') {
+						RemoveLine(lineRemove);
+					}
 				} else {
-					RemoveLine(lineRemove);
+					if (ignoreNL) {
+						ignoreNL = false; 	// Further \n are real deletions
+					} else {
+						RemoveLine(lineRemove);
+					}
 				}
-			} else if (utf8LineEnds) {
-				if (!UTF8IsAscii(ch)) {
+				eolSearch = found + 1;
+			}
+		} else {
+			for (int i = 0; i < deleteLength; i++) {
+				chNext = substance.ValueAt(position + i + 1);
+				if (ch == '\r') {
+					if (chNext != '\n') {
+						RemoveLine(lineRemove);
+					}
+				} else if (ch == '\n') {
+					if (ignoreNL) {
+						ignoreNL = false; 	// Further \n are real deletions
+					} else {
+						RemoveLine(lineRemove);
+					}
+				} else if (!UTF8IsAscii(ch)) {
 					unsigned char next3[3] = {ch, chNext,
 						static_cast<unsigned char>(substance.ValueAt(position + i + 2))};
 					if (UTF8IsSeparator(next3) || UTF8IsNEL(next3)) {
 						RemoveLine(lineRemove);
 					}
 				}
-			}
 
-			ch = chNext;
+				ch = chNext;
+			}
 		}
 		// May have to fix up end if last deletion causes cr to be next to lf
 		// or removes one of a crlf pair
@@ -815,3 +1239,23 @@ void CellBuffer::PerformRedoStep() {
 	uh.CompletedRedoStep();
 }
 
+int CellBuffer::SerializedUndoLength() const {
+	return uh.SerializedLength();
+}
+
+void CellBuffer::SerializeUndo(char *buf) const {
+	uh.Serialize(buf);
+}
+
+// Returns the number of undo steps available after restoring, or -1 if the
+// serialized form was rejected. The caller is responsible for only restoring
+// a history serialized against identical buffer contents.
+int CellBuffer::DeserializeUndo(const char *buf, int len) {
+	int undoSteps = 0;
+	if (!collectingUndo)
+		return -1;
+	if (!uh.Deserialize(buf, len, &undoSteps))
+		return -1;
+	return undoSteps;
+}
+
@@ -28,6 +28,15 @@ class LineVector {
 
 	Partitioning starts;
 	PerLine *perLine;
+	// Longest line (in bytes) maintained incrementally at edit time so scroll
+	// width candidates can be found without scanning every line.  When an edit
+	// shortens the longest line the index is invalidated and recalculated by
+	// the next query.
+	int longestLine;
+	int longestLineLength;
+	bool longestLineValid;
+
+	void RecalculateLongestLine();
 
 public:
 
@@ -38,6 +47,7 @@ public:
 
 	void InsertText(int line, int delta);
 	void InsertLine(int line, int position, bool lineStart);
+	void InsertLines(int line, const int *positions, int lines, bool lineStart);
 	void SetLineStart(int line, int position);
 	void RemoveLine(int line);
 	int Lines() const {
@@ -47,6 +57,19 @@ public:
 	int LineStart(int line) const {
 		return starts.PositionFromPartition(line);
 	}
+	int LineLength(int line) const {
+		return starts.PositionFromPartition(line + 1) - starts.PositionFromPartition(line);
+	}
+	int LongestLine() {
+		if (!longestLineValid)
+			RecalculateLongestLine();
+		return longestLine;
+	}
+	int LongestLineLength() {
+		if (!longestLineValid)
+			RecalculateLongestLine();
+		return longestLineLength;
+	}
 
 	int MarkValue(int line);
 	int AddMark(int line, int marker);
@@ -76,6 +99,8 @@ public:
 	int position;
 	char *data;
 	int lenData;
+	/// When non-zero, data holds this many compressed bytes standing for lenData original bytes
+	int lenDataCompressed;
 	bool mayCoalesce;
 
 	Action();
@@ -83,6 +108,8 @@ public:
 	void Create(actionType at_, int position_=0, const char *data_=0, int lenData_=0, bool mayCoalesce_=true);
 	void Destroy();
 	void Grab(Action *source);
+	void Compress();
+	void Decompress();
 };
 
 /**
@@ -98,6 +125,7 @@ class UndoHistory {
 	int tentativePoint;
 
 	void EnsureUndoRoom();
+	void DecompressRange(int actFirst, int actLast);
 
 	// Private so UndoHistory objects can not be copied
 	UndoHistory(const UndoHistory &);
@@ -134,6 +162,12 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void CompletedRedoStep();
+
+	/// Serialization of the whole history so the container can persist it
+	/// across sessions. Compressed action data is stored as-is.
+	int SerializedLength() const;
+	void Serialize(char *buf) const;
+	bool Deserialize(const char *buf, int len, int *undoSteps);
 };
 
 /**
@@ -181,7 +215,10 @@ public:
 	int Lines() const;
 	int LineStart(int line) const;
 	int LineFromPosition(int pos) const { return lv.LineFromPosition(pos); }
+	int LongestLine();
+	int LongestLineLength();
 	void InsertLine(int line, int position, bool lineStart);
+	void InsertLines(int line, const int *positions, int lines, bool lineStart);
 	void RemoveLine(int line);
 	const char *InsertString(int position, const char *s, int insertLength, bool &startSequence);
 
@@ -222,6 +259,10 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void PerformRedoStep();
+
+	int SerializedUndoLength() const;
+	void SerializeUndo(char *buf) const;
+	int DeserializeUndo(const char *buf, int len);
 };
 
 #ifdef SCI_NAMESPACE
@@ -113,8 +113,29 @@ void ContractionState::InsertLine(int lineDoc) {
 }
 
 void ContractionState::InsertLines(int lineDoc, int lineCount) {
-	for (int l = 0; l < lineCount; l++) {
-		InsertLine(lineDoc + l);
+	if (OneToOne()) {
+		linesInDocument += lineCount;
+	} else if (lineCount > 0) {
+		// Insert the whole range at once: one run fill per map and a single
+		// length adjustment of the display partitioning, rather than
+		// re-splitting the runs for every line.
+		int position = lineDoc;
+		int fillLength = lineCount;
+		visible->InsertSpace(lineDoc, lineCount);
+		visible->FillRange(position, 1, fillLength);
+		position = lineDoc;
+		fillLength = lineCount;
+		expanded->InsertSpace(lineDoc, lineCount);
+		expanded->FillRange(position, 1, fillLength);
+		position = lineDoc;
+		fillLength = lineCount;
+		heights->InsertSpace(lineDoc, lineCount);
+		heights->FillRange(position, 1, fillLength);
+		const int lineDisplay = DisplayFromDoc(lineDoc);
+		for (int l = 0; l < lineCount; l++) {
+			displayLines->InsertPartition(lineDoc + l, lineDisplay + l);
+		}
+		displayLines->InsertText(lineDoc + lineCount - 1, lineCount);
 	}
 	Check();
 }
@@ -134,8 +155,21 @@ void ContractionState::DeleteLine(int lineDoc) {
 }
 
 void ContractionState::DeleteLines(int lineDoc, int lineCount) {
-	for (int l = 0; l < lineCount; l++) {
-		DeleteLine(lineDoc);
+	if (OneToOne()) {
+		linesInDocument -= lineCount;
+	} else if (lineCount > 0) {
+		// Remove the display lengths of the visible lines while the maps are
+		// still intact, then delete the whole range from each map in one go.
+		for (int l = 0; l < lineCount; l++) {
+			if (GetVisible(lineDoc + l))
+				displayLines->InsertText(lineDoc + l, -heights->ValueAt(lineDoc + l));
+		}
+		for (int l = 0; l < lineCount; l++) {
+			displayLines->RemovePartition(lineDoc);
+		}
+		visible->DeleteRange(lineDoc, lineCount);
+		expanded->DeleteRange(lineDoc, lineCount);
+		heights->DeleteRange(lineDoc, lineCount);
 	}
 	Check();
 }
@@ -158,13 +192,25 @@ bool ContractionState::SetVisible(int lineDocStart, int lineDocEnd, bool isVisib
 		int delta = 0;
 		Check();
 		if ((lineDocStart <= lineDocEnd) && (lineDocStart >= 0) && (lineDocEnd < LinesInDoc())) {
-			for (int line = lineDocStart; line <= lineDocEnd; line++) {
-				if (GetVisible(line) != isVisible) {
-					int difference = isVisible ? heights->ValueAt(line) : -heights->ValueAt(line);
-					visible->SetValueAt(line, isVisible ? 1 : 0);
-					displayLines->InsertText(line, difference);
-					delta += difference;
+			// Walk runs of identical visibility so each run needs a single
+			// fill of the visibility map instead of a search and split per
+			// line; only the display partition lengths are touched per line.
+			int line = lineDocStart;
+			while (line <= lineDocEnd) {
+				int runEnd = visible->EndRun(line);
+				if (runEnd > lineDocEnd + 1)
+					runEnd = lineDocEnd + 1;
+				if ((visible->ValueAt(line) == 1) != isVisible) {
+					for (int l = line; l < runEnd; l++) {
+						const int difference = isVisible ? heights->ValueAt(l) : -heights->ValueAt(l);
+						displayLines->InsertText(l, difference);
+						delta += difference;
+					}
+					int position = line;
+					int fillLength = runEnd - line;
+					visible->FillRange(position, isVisible ? 1 : 0, fillLength);
 				}
+				line = runEnd;
 			}
 		} else {
 			return false;
@@ -96,11 +96,18 @@ Document::Document() {
 	dbcsCodePage = 0;
 	lineEndBitSet = SC_LINE_END_TYPE_DEFAULT;
 	endStyled = 0;
+	styleReconvergeTo = 0;
+	styleOutputChanged = false;
+	styleNonLevelChanged = false;
+	styleLevelShiftUniform = false;
+	styleLevelShift = 0;
 	styleClock = 0;
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
+	plainLineCached = -1;
 	insertionSet = false;
+	durationStyleOneLine = 0.00001;
 	tabInChars = 8;
 	indentInChars = 0;
 	actualIndentInChars = 8;
@@ -157,6 +164,7 @@ int Document::LineEndTypesSupported() const {
 bool Document::SetDBCSCodePage(int dbcsCodePage_) {
 	if (dbcsCodePage != dbcsCodePage_) {
 		dbcsCodePage = dbcsCodePage_;
+		plainLineCached = -1;
 		SetCaseFolder(NULL);
 		cb.SetLineEndTypes(lineEndBitSet & LineEndTypesSupported());
 		return true;
@@ -281,6 +289,15 @@ int Document::MarkerNext(int lineStart, int mask) const {
 	return static_cast<LineMarkers *>(perLineData[ldMarkers])->MarkerNext(lineStart, mask);
 }
 
+int Document::MarkerPrevious(int lineStart, int mask) const {
+	return static_cast<LineMarkers *>(perLineData[ldMarkers])->MarkerPrevious(lineStart, mask);
+}
+
+int Document::MarkersInRange(int lineStart, int lineEnd, int mask, int *lines, int maxLines) const {
+	return static_cast<LineMarkers *>(perLineData[ldMarkers])->MarkersInRange(
+		lineStart, lineEnd, mask, lines, maxLines);
+}
+
 int Document::AddMark(int line, int markerNum) {
 	if (line >= 0 && line <= LinesTotal()) {
 		int prev = static_cast<LineMarkers *>(perLineData[ldMarkers])->
@@ -320,11 +337,8 @@ void Document::DeleteMarkFromHandle(int markerHandle) {
 }
 
 void Document::DeleteAllMarks(int markerNum) {
-	bool someChanges = false;
-	for (int line = 0; line < LinesTotal(); line++) {
-		if (static_cast<LineMarkers *>(perLineData[ldMarkers])->DeleteMark(line, markerNum, true))
-			someChanges = true;
-	}
+	const bool someChanges =
+		static_cast<LineMarkers *>(perLineData[ldMarkers])->DeleteMarkAll(markerNum);
 	if (someChanges) {
 		DocModification mh(SC_MOD_CHANGEMARKER, 0, 0, 0, 0);
 		mh.line = -1;
@@ -410,6 +424,20 @@ int Document::VCHomePosition(int position) const {
 int SCI_METHOD Document::SetLevel(int line, int level) {
 	int prev = static_cast<LineLevels *>(perLineData[ldLevels])->SetLevel(line, level, LinesTotal());
 	if (prev != level) {
+		styleOutputChanged = true;
+		if ((prev & ~SC_FOLDLEVELNUMBERMASK) == (level & ~SC_FOLDLEVELNUMBERMASK)) {
+			// Only the nesting depth moved: track whether every such change in the
+			// current styling chunk moves by the same amount
+			const int delta = (level & SC_FOLDLEVELNUMBERMASK) - (prev & SC_FOLDLEVELNUMBERMASK);
+			if (styleLevelShift == 0) {
+				styleLevelShift = delta;
+				styleLevelShiftUniform = true;
+			} else if (delta != styleLevelShift) {
+				styleLevelShiftUniform = false;
+			}
+		} else {
+			styleNonLevelChanged = true;
+		}
 		DocModification mh(SC_MOD_CHANGEFOLD | SC_MOD_CHANGEMARKER,
 		                   LineStart(line), 0, 0, 0, line);
 		mh.foldLevelNow = level;
@@ -427,6 +455,22 @@ void Document::ClearLevels() {
 	static_cast<LineLevels *>(perLineData[ldLevels])->ClearLevels();
 }
 
+bool Document::ShiftLevels(int lineFirst, int lineLast, int shift) {
+	// Check the whole range first so the levels are left untouched when any
+	// shifted depth would leave the valid range
+	for (int line = lineFirst; line <= lineLast; line++) {
+		const int number = GetLevel(line) & SC_FOLDLEVELNUMBERMASK;
+		if ((number + shift < SC_FOLDLEVELBASE) || (number + shift > SC_FOLDLEVELNUMBERMASK))
+			return false;
+	}
+	for (int line = lineFirst; line <= lineLast; line++) {
+		const int level = GetLevel(line);
+		SetLevel(line, (level & ~SC_FOLDLEVELNUMBERMASK) |
+			((level & SC_FOLDLEVELNUMBERMASK) + shift));
+	}
+	return true;
+}
+
 static bool IsSubordinate(int levelStart, int levelTry) {
 	if (levelTry & SC_FOLDLEVELWHITEFLAG)
 		return true;
@@ -930,8 +974,15 @@ EncodingFamily Document::CodePageFamily() const {
 }
 
 void Document::ModifiedAt(int pos) {
-	if (endStyled > pos)
+	plainLineCached = -1;
+	if (endStyled > pos) {
+		// The style bytes and per-line data beyond the change are still the lexer's
+		// output for the unchanged tail of the text, so remember how far styling had
+		// got: EnsureStyledTo can stop relexing once it re-converges with them.
+		if (endStyled > styleReconvergeTo)
+			styleReconvergeTo = endStyled;
 		endStyled = pos;
+	}
 }
 
 void Document::CheckReadOnly() {
@@ -1282,10 +1333,39 @@ int Document::GetLineIndentPosition(int line) const {
 	return pos;
 }
 
+// Determine whether every character on the line occupies one byte and one
+// column, so that column <-> position conversions reduce to byte arithmetic.
+// The verdict is remembered in plainLineCached until the next modification,
+// making repeated column queries on the caret line O(1).
+bool Document::LineIsPlain(int line) {
+	if (line == plainLineCached)
+		return true;
+	const int lineStart = LineStart(line);
+	const int lineEnd = LineEnd(line);
+	if (dbcsCodePage) {
+		for (int i = lineStart; i < lineEnd; i++) {
+			const unsigned char ch = static_cast<unsigned char>(cb.CharAt(i));
+			if ((ch == '\t') || (ch >= 0x80))
+				return false;
+		}
+	} else {
+		for (int i = lineStart; i < lineEnd; i++) {
+			if (cb.CharAt(i) == '\t')
+				return false;
+		}
+	}
+	plainLineCached = line;
+	return true;
+}
+
 int Document::GetColumn(int pos) {
 	int column = 0;
 	int line = LineFromPosition(pos);
 	if ((line >= 0) && (line < LinesTotal())) {
+		if (LineIsPlain(line)) {
+			const int lineEnd = LineEnd(line);
+			return ((pos < lineEnd) ? pos : lineEnd) - LineStart(line);
+		}
 		for (int i = LineStart(line); i < pos;) {
 			char ch = cb.CharAt(i);
 			if (ch == '\t') {
@@ -1323,6 +1403,11 @@ int Document::CountCharacters(int startPos, int endPos) const {
 int Document::FindColumn(int line, int column) {
 	int position = LineStart(line);
 	if ((line >= 0) && (line < LinesTotal())) {
+		if (LineIsPlain(line)) {
+			const int lineEnd = LineEnd(line);
+			position += column;
+			return (position < lineEnd) ? position : lineEnd;
+		}
 		int columnCurrent = 0;
 		while ((columnCurrent < column) && (position < Length())) {
 			char ch = cb.CharAt(position);
@@ -1650,18 +1735,115 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 		if (caseSensitive) {
 			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
-			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-				if (CharAt(pos) == charStartSearch) {
-					bool found = (pos + lengthFind) <= limitPos;
-					for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
-						found = CharAt(pos + indexSearch) == search[indexSearch];
+			if (forward && (!dbcsCodePage || SC_CP_UTF8 == dbcsCodePage)) {
+				// Fast path for case-sensitive forward searches in single-byte and UTF-8
+				// documents: scan each contiguous side of the gap with memchr/memcmp
+				// instead of CharAt() calls per position.  Byte-level matching is safe
+				// here since UTF-8 lead and trail bytes never collide; candidates
+				// overlapping the gap are checked byte by byte.
+				const int lengthDoc = Length();
+				const int gapPos = cb.GapPosition();
+				// For whole-word and word-start matching, precompute the per-byte
+				// character class once so boundaries of candidates inside a segment
+				// are checked by plain table lookups on the neighbouring bytes
+				// instead of CharAt() plus classification calls per candidate.
+				// Byte-level classes match WordCharClass() exactly: in UTF-8
+				// documents all non-ASCII bytes classify as ccWord.
+				const bool checkBoundaries = word || wordStart;
+				unsigned char byteClass[256];
+				bool byteWordOrPunct[256];
+				if (checkBoundaries) {
+					for (int ch = 0; ch < 256; ch++) {
+						const CharClassify::cc ccByte = WordCharClass(static_cast<unsigned char>(ch));
+						byteClass[ch] = static_cast<unsigned char>(ccByte);
+						byteWordOrPunct[ch] = (ccByte == CharClassify::ccWord) ||
+							(ccByte == CharClassify::ccPunctuation);
 					}
-					if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
-						return pos;
+				}
+				while (pos < endSearch) {
+					// End of the contiguous segment containing pos; range pointers
+					// within a segment do not move the gap.
+					const int segLimit = (pos < gapPos) ? gapPos : lengthDoc;
+					const int memLimit = Platform::Minimum(endSearch, segLimit - lengthFind + 1);
+					if (memLimit > pos) {
+						const char *base = cb.RangePointer(pos, segLimit - pos);
+						const char *cur = base;
+						const char * const endBase = base + (memLimit - pos);
+						while (cur < endBase) {
+							const char *hit = static_cast<const char *>(
+								memchr(cur, charStartSearch, endBase - cur));
+							if (!hit)
+								break;
+							if (memcmp(hit, search, lengthFind) == 0) {
+								const int posFound = pos + static_cast<int>(hit - base);
+								bool matches = true;
+								if (checkBoundaries) {
+									bool startOK;
+									if (posFound == 0) {
+										startOK = true;
+									} else if (hit > base) {
+										const unsigned char chFirst = static_cast<unsigned char>(hit[0]);
+										const unsigned char chPrev = static_cast<unsigned char>(hit[-1]);
+										startOK = byteWordOrPunct[chFirst] &&
+											(byteClass[chFirst] != byteClass[chPrev]);
+									} else {
+										// Previous byte lies on the other side of the gap
+										startOK = IsWordStartAt(posFound);
+									}
+									matches = startOK;
+									if (word && startOK) {
+										const int posEnd = posFound + lengthFind;
+										if (posEnd == lengthDoc) {
+											// matches stays true
+										} else if (posEnd < segLimit) {
+											const unsigned char chLast = static_cast<unsigned char>(hit[lengthFind - 1]);
+											const unsigned char chNext = static_cast<unsigned char>(hit[lengthFind]);
+											matches = byteWordOrPunct[chLast] &&
+												(byteClass[chLast] != byteClass[chNext]);
+										} else {
+											// Following byte lies on the other side of the gap
+											matches = IsWordEndAt(posEnd);
+										}
+									}
+								}
+								if (matches) {
+									return posFound;
+								}
+							}
+							cur = hit + 1;
+						}
+						pos = memLimit;
+					}
+					// Candidate matches extending past the segment end straddle the gap
+					// so are checked with CharAt() which handles the split.
+					const int charwiseEnd = Platform::Minimum(endSearch, segLimit);
+					while (pos < charwiseEnd) {
+						if (CharAt(pos) == charStartSearch) {
+							bool found = (pos + lengthFind) <= limitPos;
+							for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
+								found = CharAt(pos + indexSearch) == search[indexSearch];
+							}
+							if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+								return pos;
+							}
+						}
+						pos++;
 					}
 				}
-				if (!NextCharacter(pos, increment))
-					break;
+			} else {
+				while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+					if (CharAt(pos) == charStartSearch) {
+						bool found = (pos + lengthFind) <= limitPos;
+						for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
+							found = CharAt(pos + indexSearch) == search[indexSearch];
+						}
+						if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+							return pos;
+						}
+					}
+					if (!NextCharacter(pos, increment))
+						break;
+				}
 			}
 		} else if (SC_CP_UTF8 == dbcsCodePage) {
 			const size_t maxFoldingExpansion = 4;
@@ -1786,6 +1968,14 @@ int Document::LinesTotal() const {
 	return cb.Lines();
 }
 
+int Document::LongestLine() {
+	return cb.LongestLine();
+}
+
+int Document::LongestLineLength() {
+	return cb.LongestLineLength();
+}
+
 void Document::SetDefaultCharClasses(bool includeWordClass) {
     charClass.SetDefaultCharClasses(includeWordClass);
 }
@@ -1799,6 +1989,10 @@ int Document::GetCharsOfClass(CharClassify::cc characterClass, unsigned char *bu
 }
 
 void SCI_METHOD Document::StartStyling(int position, char) {
+	// Styles stored beyond position are about to be overwritten so are no longer
+	// a valid re-convergence target
+	if (position < styleReconvergeTo)
+		styleReconvergeTo = 0;
 	endStyled = position;
 }
 
@@ -1809,6 +2003,8 @@ bool SCI_METHOD Document::SetStyleFor(int length, char style) {
 		enteredStyling++;
 		int prevEndStyled = endStyled;
 		if (cb.SetStyleFor(endStyled, length, style)) {
+			styleOutputChanged = true;
+			styleNonLevelChanged = true;
 			DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
 			                   prevEndStyled, length);
 			NotifyModified(mh);
@@ -1838,6 +2034,8 @@ bool SCI_METHOD Document::SetStyles(int length, const char *styles) {
 			}
 		}
 		if (didChange) {
+			styleOutputChanged = true;
+			styleNonLevelChanged = true;
 			DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
 			                   startMod, endMod - startMod + 1);
 			NotifyModified(mh);
@@ -1851,9 +2049,61 @@ void Document::EnsureStyledTo(int pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
 		IncrementStyleClock();
 		if (pli && !pli->UseContainerLexing()) {
-			int lineEndStyled = LineFromPosition(GetEndStyled());
-			int endStyledTo = LineStart(lineEndStyled);
-			pli->Colourise(endStyledTo, pos);
+			// Take the re-convergence mark locally as the lexer resets the member
+			// through StartStyling while it runs
+			const int reconvergeTo = styleReconvergeTo;
+			styleReconvergeTo = 0;
+			// While there is stored styling beyond the last change, lex in chunks of
+			// lines: a chunk that alters neither style bytes, line states nor fold
+			// levels proves the lexer state has re-joined the styling already stored
+			// for the unchanged tail, which can then be accepted without relexing it.
+			const int linesPerChunk = 0x100;
+			while ((pos > GetEndStyled()) && (reconvergeTo > GetEndStyled())) {
+				const int endStyledWas = GetEndStyled();
+				int lineEndStyled = LineFromPosition(endStyledWas);
+				int chunkLine = lineEndStyled + linesPerChunk;
+				int chunkEnd = (chunkLine < LinesTotal()) ? LineStart(chunkLine) : Length();
+				if (chunkEnd > pos)
+					chunkEnd = pos;
+				styleOutputChanged = false;
+				styleNonLevelChanged = false;
+				styleLevelShiftUniform = false;
+				styleLevelShift = 0;
+				pli->Colourise(LineStart(lineEndStyled), chunkEnd);
+				if (GetEndStyled() <= endStyledWas)
+					break;	// No progress, give up on chunking
+				if (GetEndStyled() >= chunkEnd) {
+					if (!styleOutputChanged && (GetEndStyled() <= reconvergeTo)) {
+						// Re-converged with the previous styling
+						endStyled = reconvergeTo;
+						break;
+					}
+					if (!styleNonLevelChanged && styleLevelShiftUniform &&
+						(GetEndStyled() <= reconvergeTo)) {
+						// The chunk reproduced the stored style bytes and line states
+						// but moved every fold depth by the same amount, as happens when
+						// an edit opens or closes a nesting level: counting folders keep
+						// that shift constant over the unchanged tail, so apply it to the
+						// stored levels line by line instead of relexing to the end.
+						// Going through SetLevel keeps the fold change notifications that
+						// the container relies on.
+						if (ShiftLevels(LineFromPosition(GetEndStyled()),
+							LineFromPosition(reconvergeTo), styleLevelShift)) {
+							endStyled = reconvergeTo;
+							break;
+						}
+					}
+				}
+			}
+			if (pos > GetEndStyled()) {
+				int lineEndStyled = LineFromPosition(GetEndStyled());
+				int endStyledTo = LineStart(lineEndStyled);
+				pli->Colourise(endStyledTo, pos);
+			}
+			else if (reconvergeTo > GetEndStyled()) {
+				// Styling stopped short of the mark, keep it for the next call
+				styleReconvergeTo = reconvergeTo;
+			}
 		} else {
 			// Ask the watchers to style, and stop as soon as one responds.
 			for (std::vector<WatcherWithUserData>::iterator it = watchers.begin();
@@ -1864,7 +2114,35 @@ void Document::EnsureStyledTo(int pos) {
 	}
 }
 
+void Document::StyleToAdjustingLineDuration(int pos) {
+	// Place bounds on the duration used to avoid glitches spiking it
+	// and so causing slow styling or non-responsive scrolling
+	const double minDurationOneLine = 0.000001;
+	const double maxDurationOneLine = 0.0001;
+
+	// Alpha value for exponential smoothing.
+	// Most recent value contributes 25% to smoothed value.
+	const double alpha = 0.25;
+
+	const int lineFirst = LineFromPosition(GetEndStyled());
+	ElapsedTime etStyling;
+	EnsureStyledTo(pos);
+	const double durationStyling = etStyling.Duration();
+	const int lineLast = LineFromPosition(GetEndStyled());
+	if (lineLast >= lineFirst + 8) {
+		// Only adjust for styling multiple lines to avoid instability
+		const double durationOneLine = durationStyling / (lineLast - lineFirst);
+		durationStyleOneLine = alpha * durationOneLine + (1.0 - alpha) * durationStyleOneLine;
+		if (durationStyleOneLine < minDurationOneLine)
+			durationStyleOneLine = minDurationOneLine;
+		else if (durationStyleOneLine > maxDurationOneLine)
+			durationStyleOneLine = maxDurationOneLine;
+	}
+}
+
 void Document::LexerChanged() {
+	// Old styling no longer describes what the new lexer would produce
+	styleReconvergeTo = 0;
 	// Tell the watchers the lexer has changed.
 	for (std::vector<WatcherWithUserData>::iterator it = watchers.begin(); it != watchers.end(); ++it) {
 		it->watcher->NotifyLexerChanged(this, it->userData);
@@ -1874,6 +2152,8 @@ void Document::LexerChanged() {
 int SCI_METHOD Document::SetLineState(int line, int state) {
 	int statePrevious = static_cast<LineState *>(perLineData[ldState])->SetLineState(line, state);
 	if (state != statePrevious) {
+		styleOutputChanged = true;
+		styleNonLevelChanged = true;
 		DocModification mh(SC_MOD_CHANGELINESTATE, LineStart(line), 0, 0, 0, line);
 		NotifyModified(mh);
 	}
@@ -2011,8 +2291,15 @@ void Document::NotifySavePoint(bool atSavePoint) {
 void Document::NotifyModified(DocModification mh) {
 	if (mh.modificationType & SC_MOD_INSERTTEXT) {
 		decorations.InsertSpace(mh.position, mh.length);
+		// Keep the re-convergence mark pointing at the same text
+		if (styleReconvergeTo > mh.position)
+			styleReconvergeTo += mh.length;
 	} else if (mh.modificationType & SC_MOD_DELETETEXT) {
 		decorations.DeleteRange(mh.position, mh.length);
+		if (styleReconvergeTo >= mh.position + mh.length)
+			styleReconvergeTo -= mh.length;
+		else if (styleReconvergeTo > mh.position)
+			styleReconvergeTo = 0;
 	}
 	for (std::vector<WatcherWithUserData>::iterator it = watchers.begin(); it != watchers.end(); ++it) {
 		it->watcher->NotifyModified(this, mh, it->userData);
@@ -2164,6 +2451,47 @@ int Document::BraceMatch(int position, int /*maxReStyle*/) {
 	if (chBrace == '(' || chBrace == '[' || chBrace == '{' || chBrace == '<')
 		direction = 1;
 	int depth = 1;
+	if ((dbcsCodePage == 0) || (dbcsCodePage == SC_CP_UTF8)) {
+		// Single byte and UTF-8 text: the brace characters are ASCII and can
+		// not occur inside a multi-byte character, so scan the text a block at
+		// a time instead of a character at a time, only fetching the style
+		// when a candidate brace byte is found.  This keeps caret moves cheap
+		// in deeply nested files where the match may be megabytes away.
+		const int length = Length();
+		const int endStyled = GetEndStyled();
+		char buffer[4096];
+		int pos = position + direction;
+		while ((pos >= 0) && (pos < length)) {
+			int startBlock;
+			int lenBlock;
+			if (direction > 0) {
+				startBlock = pos;
+				lenBlock = Platform::Minimum(static_cast<int>(sizeof(buffer)), length - pos);
+			} else {
+				startBlock = Platform::Maximum(0, pos + 1 - static_cast<int>(sizeof(buffer)));
+				lenBlock = pos + 1 - startBlock;
+			}
+			GetCharRange(buffer, startBlock, lenBlock);
+			const int iStart = (direction > 0) ? 0 : lenBlock - 1;
+			const int iEnd = (direction > 0) ? lenBlock : -1;
+			for (int i = iStart; i != iEnd; i += direction) {
+				const char chAtPos = buffer[i];
+				if ((chAtPos == chBrace) || (chAtPos == chSeek)) {
+					const int posBrace = startBlock + i;
+					if ((posBrace > endStyled) || (static_cast<char>(StyleAt(posBrace)) == styBrace)) {
+						if (chAtPos == chBrace)
+							depth++;
+						if (chAtPos == chSeek)
+							depth--;
+						if (depth == 0)
+							return posBrace;
+					}
+				}
+			}
+			pos = (direction > 0) ? startBlock + lenBlock : startBlock - 1;
+		}
+		return - 1;
+	}
 	position = NextPosition(position, direction);
 	while ((position >= 0) && (position < Length())) {
 		char chAtPos = CharAt(position);
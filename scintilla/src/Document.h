@@ -215,11 +215,21 @@ private:
 	CharClassify charClass;
 	CaseFolder *pcf;
 	int endStyled;
+	int styleReconvergeTo;
+	bool styleOutputChanged;
+	bool styleNonLevelChanged;
+	bool styleLevelShiftUniform;
+	int styleLevelShift;
 	int styleClock;
 	int enteredModification;
 	int enteredStyling;
 	int enteredReadOnlyCount;
 
+	// Line known to contain only single-byte, non-tab characters, so columns on
+	// it map 1:1 to byte offsets; -1 when no line is known. Invalidated on every
+	// modification, which keeps caret-movement column queries O(1) between edits.
+	int plainLineCached;
+
 	bool insertionSet;
 	std::string insertion;
 
@@ -246,6 +256,7 @@ public:
 	bool useTabs;
 	bool tabIndents;
 	bool backspaceUnindents;
+	double durationStyleOneLine;
 
 	DecorationList decorations;
 
@@ -305,6 +316,9 @@ public:
 	void BeginUndoAction() { cb.BeginUndoAction(); }
 	void EndUndoAction() { cb.EndUndoAction(); }
 	void AddUndoAction(int token, bool mayCoalesce) { cb.AddUndoAction(token, mayCoalesce); }
+	int SerializedUndoLength() const { return cb.SerializedUndoLength(); }
+	void SerializeUndo(char *buf) const { cb.SerializeUndo(buf); }
+	int DeserializeUndo(const char *buf, int len) { return cb.DeserializeUndo(buf, len); }
 	void SetSavePoint();
 	bool IsSavePoint() const { return cb.IsSavePoint(); }
 
@@ -342,6 +356,8 @@ public:
 	}
 	int GetMark(int line);
 	int MarkerNext(int lineStart, int mask) const;
+	int MarkerPrevious(int lineStart, int mask) const;
+	int MarkersInRange(int lineStart, int lineEnd, int mask, int *lines, int maxLines) const;
 	int AddMark(int line, int markerNum);
 	void AddMarkSet(int line, int valueSet);
 	void DeleteMark(int line, int markerNum);
@@ -359,6 +375,7 @@ public:
 	int SCI_METHOD SetLevel(int line, int level);
 	int SCI_METHOD GetLevel(int line) const;
 	void ClearLevels();
+	bool ShiftLevels(int lineFirst, int lineLast, int shift);
 	int GetLastChild(int lineParent, int level=-1, int lastLine=-1);
 	int GetFoldParent(int line) const;
 	void GetHighlightDelimiters(HighlightDelimiter &hDelimiter, int line, int lastLine);
@@ -386,6 +403,8 @@ public:
 		bool wordStart, bool regExp, int flags, int *length);
 	const char *SubstituteByPosition(const char *text, int *length);
 	int LinesTotal() const;
+	int LongestLine();
+	int LongestLineLength();
 
 	void SetDefaultCharClasses(bool includeWordClass);
 	void SetCharClasses(const unsigned char *chars, CharClassify::cc newCharClass);
@@ -395,6 +414,7 @@ public:
 	bool SCI_METHOD SetStyles(int length, const char *styles);
 	int GetEndStyled() const { return endStyled; }
 	void EnsureStyledTo(int pos);
+	void StyleToAdjustingLineDuration(int pos);
 	void LexerChanged();
 	int GetStyleClock() const { return styleClock; }
 	void IncrementStyleClock();
@@ -440,6 +460,8 @@ private:
 	bool IsWordEndAt(int pos) const;
 	bool IsWordAt(int start, int end) const;
 
+	bool LineIsPlain(int line);
+
 	void NotifyModifyAttempt();
 	void NotifySavePoint(bool atSavePoint);
 	void NotifyModified(DocModification mh);
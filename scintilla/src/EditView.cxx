@@ -584,6 +584,15 @@ Point EditView::LocationFromPosition(Surface *surface, const EditModel &model, S
 	const int line = model.pdoc->LineFromPosition(pos.Position());
 	const int lineVisible = model.cs.DisplayFromDoc(line);
 	//Platform::DebugPrintf("line=%d\n", line);
+	if ((vs.wrapState == eWrapNone) && (pos.VirtualSpace() == 0) &&
+		(pos.Position() == model.pdoc->LineStart(line))) {
+		// Start of an unwrapped line needs no layout: the x ordinate is simply
+		// the left of the text and the y ordinate is arithmetic on the uniform
+		// line height
+		pt.x = vs.textStart - model.xOffset;
+		pt.y = (lineVisible - topLine) * vs.lineHeight;
+		return pt;
+	}
 	AutoLineLayout ll(llc, RetrieveLineLayout(line, model));
 	if (surface && ll) {
 		const int posLineStart = model.pdoc->LineStart(line);
@@ -668,6 +677,12 @@ SelectionPosition EditView::SPositionFromLineX(Surface *surface, const EditModel
 int EditView::DisplayFromPosition(Surface *surface, const EditModel &model, int pos, const ViewStyle &vs) {
 	int lineDoc = model.pdoc->LineFromPosition(pos);
 	int lineDisplay = model.cs.DisplayFromDoc(lineDoc);
+	// With wrapping off every document line occupies exactly one display line,
+	// so there is no sub-line to search for and no reason to lay the line out.
+	// This runs on every caret move and scroll, where the layout would often
+	// be the only non-arithmetic work
+	if (vs.wrapState == eWrapNone)
+		return lineDisplay;
 	AutoLineLayout ll(llc, RetrieveLineLayout(lineDoc, model));
 	if (surface && ll) {
 		LayoutLine(model, lineDoc, surface, vs, ll, model.wrapWidth);
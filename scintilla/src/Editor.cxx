@@ -146,6 +146,8 @@ Editor::Editor() {
 	xCaretMargin = 50;
 	horizontalScrollBarVisible = true;
 	scrollWidth = 2000;
+	longestLineMeasured = -1;
+	longestLineMeasuredLength = -1;
 	verticalScrollBarVisible = true;
 	endAtLastLine = true;
 	caretSticky = SC_CARETSTICKY_OFF;
@@ -172,9 +174,15 @@ Editor::Editor() {
 	paintAbandonedByStyling = false;
 	paintingAllText = false;
 	willRedrawAll = false;
+	batchingInsertions = false;
 
 	modEventMask = SC_MODEVENTMASKALL;
 
+	idleStyling = SC_IDLESTYLING_NONE;
+	needIdleStyling = false;
+
+	durationWrapOneLine = 0.00005;
+
 	pdoc->AddWatcher(this, 0);
 
 	recordingMacro = false;
@@ -847,7 +855,7 @@ void Editor::ScrollTo(int line, bool moveThumb) {
 		SetTopLine(topLineNew);
 		// Optimize by styling the view as this will invalidate any needed area
 		// which could abort the initial paint if discovered later.
-		StyleToPositionInView(PositionAfterArea(GetClientRectangle()));
+		StyleAreaBounded(GetClientRectangle(), true);
 #ifndef UNDER_CE
 		// Perform redraw rather than scroll if many lines would be redrawn anyway.
 		if (performBlit) {
@@ -1350,12 +1358,28 @@ void Editor::CaretSetPeriod(int period) {
 	}
 }
 
+void Editor::InvalidateCaretPosition(SelectionPosition pos) {
+	// For a simple bar caret only a narrow strip around the caret column needs
+	// repainting, which makes the blink timer much cheaper than redrawing the
+	// whole line rectangle. Block and overstrike carets cover a character cell
+	// whose width depends on the layout, so they keep the full invalidation.
+	if ((vs.caretStyle == CARETSTYLE_LINE) && !inOverstrike &&
+			!view.imeCaretBlockOverride && !view.LinesOverlap()) {
+		const Point pt = LocationFromPosition(pos);
+		PRectangle rcCaret(pt.x - 2, pt.y,
+			pt.x + vs.caretWidth + 2, pt.y + vs.lineHeight);
+		RedrawRect(rcCaret);
+	} else {
+		InvalidateRange(pos.Position(), pos.Position() + 1);
+	}
+}
+
 void Editor::InvalidateCaret() {
 	if (posDrag.IsValid()) {
-		InvalidateRange(posDrag.Position(), posDrag.Position() + 1);
+		InvalidateCaretPosition(posDrag);
 	} else {
 		for (size_t r=0; r<sel.Count(); r++) {
-			InvalidateRange(sel.Range(r).caret.Position(), sel.Range(r).caret.Position() + 1);
+			InvalidateCaretPosition(sel.Range(r).caret);
 		}
 	}
 	UpdateSystemCaret();
@@ -1364,6 +1388,13 @@ void Editor::InvalidateCaret() {
 void Editor::UpdateSystemCaret() {
 }
 
+bool Editor::BlinkCaret() {
+	// Platforms may toggle the caret directly on screen so the blink timer
+	// does not run the invalidate -> paint cycle; the default asks the caller
+	// to invalidate as usual.
+	return false;
+}
+
 bool Editor::Wrapping() const {
 	return vs.wrapState != eWrapNone;
 }
@@ -1438,7 +1469,14 @@ bool Editor::WrapLines(enum wrapScope ws) {
 				return false;
 			}
 		} else if (ws == wsIdle) {
-			lineToWrapEnd = lineToWrap + LinesOnScreen() + 100;
+			// Wrap as many lines as fit in the allowed time rather than a fixed
+			// page: cheap lines (logs and other mostly short text) then complete
+			// orders of magnitude sooner while expensive lines keep idle responsive.
+			const double secondsAllowed = 0.01;
+			const int linesInAllowedTime = Platform::Clamp(
+				static_cast<int>(secondsAllowed / durationWrapOneLine),
+				LinesOnScreen() + 100, 0x10000);
+			lineToWrapEnd = lineToWrap + linesInAllowedTime;
 		}
 		const int lineEndNeedWrap = std::min(wrapPending.end, pdoc->LinesTotal());
 		lineToWrapEnd = std::min(lineToWrapEnd, lineEndNeedWrap);
@@ -1457,6 +1495,8 @@ bool Editor::WrapLines(enum wrapScope ws) {
 			if (surface) {
 //Platform::DebugPrintf("Wraplines: scope=%0d need=%0d..%0d perform=%0d..%0d\n", ws, wrapPending.start, wrapPending.end, lineToWrap, lineToWrapEnd);
 
+				const int linesBeingWrapped = lineToWrapEnd - lineToWrap;
+				ElapsedTime etWrap;
 				while (lineToWrap < lineToWrapEnd) {
 					if (WrapOneLine(surface, lineToWrap)) {
 						wrapOccurred = true;
@@ -1464,6 +1504,15 @@ bool Editor::WrapLines(enum wrapScope ws) {
 					wrapPending.Wrapped(lineToWrap);
 					lineToWrap++;
 				}
+				if (linesBeingWrapped > 8) {
+					// Smooth the measured per-line wrap cost to size the next idle batch,
+					// only over larger batches to avoid instability
+					const double alpha = 0.25;
+					durationWrapOneLine = alpha * (etWrap.Duration() / linesBeingWrapped) +
+						(1.0 - alpha) * durationWrapOneLine;
+					if (durationWrapOneLine < 0.0000001)
+						durationWrapOneLine = 0.0000001;
+				}
 
 				goodTopLine = cs.DisplayFromDoc(lineDocTop) + std::min(subLineTop, cs.GetHeight(lineDocTop)-1);
 			}
@@ -1545,6 +1594,29 @@ void Editor::LinesSplit(int pixelWidth) {
 	}
 }
 
+// Measure the pixel width of the line with the most bytes so the horizontal
+// scroll bar covers the widest line up front instead of widening gradually as
+// wide lines happen to be painted.  The document maintains the byte-longest
+// line incrementally so finding the candidate is cheap; only when the
+// candidate changes is it laid out and measured precisely.
+void Editor::MeasureLongestLine() {
+	if (!trackLineWidth || Wrapping() || (pdoc->Length() == 0))
+		return;
+	const int lineLongest = pdoc->LongestLine();
+	const int lengthLongest = pdoc->LongestLineLength();
+	if ((lineLongest == longestLineMeasured) && (lengthLongest == longestLineMeasuredLength))
+		return;
+	AutoSurface surface(this);
+	AutoLineLayout ll(view.llc, view.RetrieveLineLayout(lineLongest, *this));
+	if (surface && ll) {
+		view.LayoutLine(*this, lineLongest, surface, vs, ll, wrapWidth);
+		view.lineWidthMaxSeen = Platform::Maximum(
+			view.lineWidthMaxSeen, static_cast<int>(ll->positions[ll->numCharsInLine]));
+		longestLineMeasured = lineLongest;
+		longestLineMeasuredLength = lengthLongest;
+	}
+}
+
 void Editor::PaintSelMargin(Surface *surfWindow, PRectangle &rc) {
 	if (vs.fixedColumnWidth == 0)
 		return;
@@ -1618,7 +1690,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 
 	paintAbandonedByStyling = false;
 
-	StyleToPositionInView(PositionAfterArea(rcArea));
+	StyleAreaBounded(rcArea, false);
 
 	PRectangle rcClient = GetClientRectangle();
 	//Platform::DebugPrintf("Client: (%3d,%3d) ... (%3d,%3d)   %d\n",
@@ -1677,6 +1749,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 
 	view.PaintText(surfaceWindow, *this, rcArea, rcClient, vs);
 
+	MeasureLongestLine();
 	if (horizontalScrollBarVisible && trackLineWidth && (view.lineWidthMaxSeen > scrollWidth)) {
 		if (FineTickerAvailable()) {
 			scrollWidth = view.lineWidthMaxSeen;
@@ -1799,15 +1872,41 @@ void Editor::AddCharUTF(const char *s, unsigned int len, bool treatAsDBCS) {
 		// Order selections by position in document.
 		std::sort(selPtrs.begin(), selPtrs.end(), cmpSelPtrs);
 
-		// Loop in reverse to avoid disturbing positions of selections yet to be processed.
-		for (std::vector<SelectionRange *>::reverse_iterator rit = selPtrs.rbegin();
-			rit != selPtrs.rend(); ++rit) {
-			SelectionRange *currentSel = *rit;
+		// When there are multiple selections that do not overlap, process them as one
+		// batch: a single forward pass carries the accumulated length change so the
+		// per-insertion selection adjustment in NotifyModified, which iterates every
+		// selection, can be suppressed along with per-insertion invalidation and
+		// rewrapping and performed once afterwards. This keeps column and multi-caret
+		// typing linear in the number of carets instead of quadratic.
+		bool batched = sel.Count() > 1;
+		for (size_t i = 1; batched && (i < selPtrs.size()); i++) {
+			if ((selPtrs[i-1]->End().Position() > selPtrs[i]->Start().Position()) ||
+				(selPtrs[i-1]->Start().Position() >= selPtrs[i]->Start().Position()))
+				batched = false;
+		}
+		batchingInsertions = batched;
+		int delta = 0;
+		int batchFirst = INVALID_POSITION;
+		int batchLast = INVALID_POSITION;
+
+		// Without batching, loop in reverse to avoid disturbing positions of selections
+		// yet to be processed.
+		for (size_t i = 0; i < selPtrs.size(); i++) {
+			SelectionRange *currentSel = batched ? selPtrs[i] : selPtrs[selPtrs.size() - i - 1];
+			if (batched && (delta != 0)) {
+				// Account for the length change made by the selections already processed
+				currentSel->caret.Add(delta);
+				currentSel->anchor.Add(delta);
+			}
 			if (!RangeContainsProtected(currentSel->Start().Position(),
 				currentSel->End().Position())) {
 				int positionInsert = currentSel->Start().Position();
+				if (batched && (batchFirst == INVALID_POSITION))
+					batchFirst = positionInsert;
 				if (!currentSel->Empty()) {
 					if (currentSel->Length()) {
+						if (batched)
+							delta -= currentSel->Length();
 						pdoc->DeleteChars(positionInsert, currentSel->Length());
 						currentSel->ClearVirtualSpace();
 					} else {
@@ -1817,20 +1916,28 @@ void Editor::AddCharUTF(const char *s, unsigned int len, bool treatAsDBCS) {
 				} else if (inOverstrike) {
 					if (positionInsert < pdoc->Length()) {
 						if (!pdoc->IsPositionInLineEnd(positionInsert)) {
+							if (batched)
+								delta -= pdoc->LenChar(positionInsert);
 							pdoc->DelChar(positionInsert);
 							currentSel->ClearVirtualSpace();
 						}
 					}
 				}
-				positionInsert = InsertSpace(positionInsert, currentSel->caret.VirtualSpace());
+				const int positionAfterSpace = InsertSpace(positionInsert, currentSel->caret.VirtualSpace());
+				if (batched)
+					delta += positionAfterSpace - positionInsert;
+				positionInsert = positionAfterSpace;
 				const int lengthInserted = pdoc->InsertString(positionInsert, s, len);
 				if (lengthInserted > 0) {
 					currentSel->caret.SetPosition(positionInsert + lengthInserted);
 					currentSel->anchor.SetPosition(positionInsert + lengthInserted);
 				}
 				currentSel->ClearVirtualSpace();
-				// If in wrap mode rewrap current line so EnsureCaretVisible has accurate information
-				if (Wrapping()) {
+				if (batched) {
+					delta += lengthInserted;
+					batchLast = positionInsert + lengthInserted;
+				} else if (Wrapping()) {
+					// If in wrap mode rewrap current line so EnsureCaretVisible has accurate information
 					AutoSurface surface(this);
 					if (surface) {
 						if (WrapOneLine(surface, pdoc->LineFromPosition(positionInsert))) {
@@ -1842,6 +1949,24 @@ void Editor::AddCharUTF(const char *s, unsigned int len, bool treatAsDBCS) {
 				}
 			}
 		}
+		batchingInsertions = false;
+		if (batched && (batchLast != INVALID_POSITION)) {
+			QueueIdleWork(WorkNeeded::workStyle, batchLast);
+			InvalidateRange(batchFirst, batchLast);
+			if (Wrapping()) {
+				// Rewrap only the line of the main caret so EnsureCaretVisible has
+				// accurate information; the other modified lines are rewrapped by the
+				// pending wrap marked through CheckModificationForWrap.
+				AutoSurface surface(this);
+				if (surface) {
+					if (WrapOneLine(surface, pdoc->LineFromPosition(sel.MainCaret()))) {
+						SetScrollBars();
+						SetVerticalScrollPos();
+						Redraw();
+					}
+				}
+			}
+		}
 	}
 	if (Wrapping()) {
 		SetScrollBars();
@@ -2486,13 +2611,16 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			view.llc.Invalidate(LineLayout::llCheckTextAndStyle);
 		}
 	} else {
-		// Move selection and brace highlights
+		// Move selection and brace highlights. During a batched multiple insertion
+		// AddCharUTF adjusts the selections itself.
 		if (mh.modificationType & SC_MOD_INSERTTEXT) {
-			sel.MovePositions(true, mh.position, mh.length);
+			if (!batchingInsertions)
+				sel.MovePositions(true, mh.position, mh.length);
 			braces[0] = MovePositionForInsertion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForInsertion(braces[1], mh.position, mh.length);
 		} else if (mh.modificationType & SC_MOD_DELETETEXT) {
-			sel.MovePositions(false, mh.position, mh.length);
+			if (!batchingInsertions)
+				sel.MovePositions(false, mh.position, mh.length);
 			braces[0] = MovePositionForDeletion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForDeletion(braces[1], mh.position, mh.length);
 		}
@@ -2550,7 +2678,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 				Redraw();
 			}
 		} else {
-			if (paintState == notPainting && mh.length && !CanEliminate(mh)) {
+			if (paintState == notPainting && mh.length && !CanEliminate(mh) && !batchingInsertions) {
 				QueueIdleWork(WorkNeeded::workStyle, mh.position + mh.length);
 				InvalidateRange(mh.position, mh.position + mh.length);
 			}
@@ -4564,7 +4692,8 @@ void Editor::Tick() {
 			caret.on = !caret.on;
 			timer.ticksToWait = caret.period;
 			if (caret.active) {
-				InvalidateCaret();
+				if (!BlinkCaret())
+					InvalidateCaret();
 			}
 		}
 	}
@@ -4598,12 +4727,16 @@ bool Editor::Idle() {
 			wrappingDone = true;
 	}
 
+	if (needIdleStyling) {
+		IdleStyling();
+	}
+
 	// Add more idle things to do here, but make sure idleDone is
 	// set correctly before the function returns. returning
 	// false will stop calling this idle function until SetIdle() is
 	// called again.
 
-	idleDone = wrappingDone; // && thatDone && theOtherThingDone...
+	idleDone = wrappingDone && !needIdleStyling; // && thatDone && theOtherThingDone...
 
 	return !idleDone;
 }
@@ -4620,7 +4753,8 @@ void Editor::TickFor(TickReason reason) {
 		case tickCaret:
 			caret.on = !caret.on;
 			if (caret.active) {
-				InvalidateCaret();
+				if (!BlinkCaret())
+					InvalidateCaret();
 			}
 			break;
 		case tickScroll:
@@ -4708,6 +4842,89 @@ void Editor::StyleToPositionInView(Position pos) {
 	}
 }
 
+int Editor::PositionAfterMaxStyling(int posMax, bool scrolling) const {
+	if ((idleStyling == SC_IDLESTYLING_NONE) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE)) {
+		// These modes do not limit styling
+		return posMax;
+	}
+
+	// Try to keep time taken by styling reasonable so interaction remains smooth.
+	// When scrolling, allow less time to ensure responsive
+	const double secondsAllowed = scrolling ? 0.005 : 0.02;
+	const int linesToStyle = Platform::Clamp(
+		static_cast<int>(secondsAllowed / pdoc->durationStyleOneLine),
+		10, 0x10000);
+	const int stylingMaxLine = Platform::Minimum(
+		pdoc->LineFromPosition(pdoc->GetEndStyled()) + linesToStyle,
+		pdoc->LinesTotal());
+	return Platform::Minimum(pdoc->LineStart(stylingMaxLine), posMax);
+}
+
+// Style for an area but bound the amount of styling to remain responsive
+void Editor::StyleAreaBounded(PRectangle rcArea, bool scrolling) {
+	const int posAfterArea = PositionAfterArea(rcArea);
+	const int posAfterMax = PositionAfterMaxStyling(posAfterArea, scrolling);
+	if (posAfterMax < posAfterArea) {
+		// Idle styling may be performed before current visible area
+		// Style a bit now then style further in idle time
+		pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	} else {
+		// Can style all wanted now.
+		StyleToPositionInView(posAfterArea);
+	}
+	StartIdleStyling(posAfterArea < pdoc->Length());
+}
+
+// Perform styling for deferred idle styling modes and mark more to be done if needed
+void Editor::IdleStyling() {
+	const int posAfterArea = PositionAfterArea(GetClientRectangle());
+	const int endGoal = (idleStyling >= SC_IDLESTYLING_AFTERVISIBLE) ?
+		pdoc->Length() : posAfterArea;
+	// Lexers style strictly forward from the end of the styled prefix, so text in
+	// and before the visible area always completes before anything below it.
+	// Budget each batch by distance from the view: catching up to the visible area
+	// is latency-critical and gets the full budget, while batches further beyond
+	// it get smaller ones so background styling of off-screen text stays
+	// unobtrusive. Batch sizes derive from the measured per-line styling duration
+	// so slow lexers take smaller bites.
+	double secondsAllowed = 0.02;
+	if (pdoc->GetEndStyled() >= posAfterArea) {
+		const int linesBeyondView = pdoc->LineFromPosition(pdoc->GetEndStyled()) -
+			pdoc->LineFromPosition(posAfterArea);
+		if (linesBeyondView > 1000)
+			secondsAllowed = 0.005;
+		else if (linesBeyondView > 100)
+			secondsAllowed = 0.01;
+	}
+	const int linesToStyle = Platform::Clamp(
+		static_cast<int>(secondsAllowed / pdoc->durationStyleOneLine),
+		10, 0x10000);
+	const int stylingMaxLine = Platform::Minimum(
+		pdoc->LineFromPosition(pdoc->GetEndStyled()) + linesToStyle,
+		pdoc->LinesTotal());
+	const int posAfterMax = Platform::Minimum(pdoc->LineStart(stylingMaxLine), endGoal);
+	pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	if (pdoc->GetEndStyled() >= endGoal) {
+		needIdleStyling = false;
+	}
+}
+
+// If idle styling is enabled, ensure the idler runs to perform the remaining styling
+void Editor::StartIdleStyling(bool truncatedLastStyling) {
+	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE)) {
+		if (pdoc->GetEndStyled() < pdoc->Length()) {
+			// Style remainder of document in idle time
+			needIdleStyling = true;
+		}
+	} else if (truncatedLastStyling) {
+		// Style remainder of visible area in idle time
+		needIdleStyling = true;
+	}
+	if (needIdleStyling) {
+		SetIdle(true);
+	}
+}
+
 void Editor::IdleWork() {
 	// Style the line after the modification as this allows modifications that change just the
 	// line of the modification to heal instead of propagating to the rest of the window.
@@ -5312,11 +5529,15 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 			if (wParam == 0)
 				return 0;
 			char *ptr = CharPtrFromSPtr(lParam);
-			unsigned int iChar = 0;
-			for (; iChar < wParam - 1; iChar++)
-				ptr[iChar] = pdoc->CharAt(iChar);
-			ptr[iChar] = '\0';
-			return iChar;
+			unsigned int len = static_cast<unsigned int>(wParam - 1);
+			if (len > static_cast<unsigned int>(pdoc->Length()))
+				len = static_cast<unsigned int>(pdoc->Length());
+			// Copy the two contiguous halves around the gap with memcpy
+			// instead of a CharAt call per byte; retrieving the whole text
+			// is how background consumers snapshot the buffer.
+			pdoc->GetCharRange(ptr, 0, len);
+			ptr[len] = '\0';
+			return len;
 		}
 
 	case SCI_SETTEXT: {
@@ -6354,13 +6575,8 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_MARKERNEXT:
 		return pdoc->MarkerNext(static_cast<int>(wParam), static_cast<int>(lParam));
 
-	case SCI_MARKERPREVIOUS: {
-			for (int iLine = static_cast<int>(wParam); iLine >= 0; iLine--) {
-				if ((pdoc->GetMark(iLine) & lParam) != 0)
-					return iLine;
-			}
-		}
-		return -1;
+	case SCI_MARKERPREVIOUS:
+		return pdoc->MarkerPrevious(static_cast<int>(wParam), static_cast<int>(lParam));
 
 	case SCI_MARKERDEFINEPIXMAP:
 		if (wParam <= MARKER_MAX) {
@@ -7161,6 +7377,28 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		reprs.ClearRepresentation(reinterpret_cast<const char *>(wParam));
 		break;
 
+	case SCI_SETIDLESTYLING:
+		idleStyling = static_cast<int>(wParam);
+		break;
+
+	case SCI_GETIDLESTYLING:
+		return idleStyling;
+
+	case SCI_SERIALIZEUNDO: {
+			const int lenSerialized = pdoc->SerializedUndoLength();
+			if (lParam == 0)
+				return lenSerialized;
+			if (static_cast<int>(wParam) < lenSerialized)
+				return 0;
+			pdoc->SerializeUndo(CharPtrFromSPtr(lParam));
+			return lenSerialized;
+		}
+
+	case SCI_DESERIALIZEUNDO:
+		if (lParam == 0)
+			return -1;
+		return pdoc->DeserializeUndo(CharPtrFromSPtr(lParam), static_cast<int>(wParam));
+
 	case SCI_STARTRECORD:
 		recordingMacro = true;
 		return 0;
@@ -182,6 +182,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	int xCaretMargin;	///< Ensure this many pixels visible on both sides of caret
 	bool horizontalScrollBarVisible;
 	int scrollWidth;
+	int longestLineMeasured;	///< Document line whose width last fed the scroll width
+	int longestLineMeasuredLength;	///< Byte length of that line when it was measured
 	bool verticalScrollBarVisible;
 	bool endAtLastLine;
 	int caretSticky;
@@ -233,7 +235,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	PRectangle rcPaint;
 	bool paintingAllText;
 	bool willRedrawAll;
+	bool batchingInsertions;
 	WorkNeeded workNeeded;
+	int idleStyling;
+	bool needIdleStyling;
 
 	int modEventMask;
 
@@ -256,6 +261,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	// Wrapping support
 	WrapPending wrapPending;
+	double durationWrapOneLine;
 
 	bool convertPastes;
 
@@ -360,8 +366,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void ShowCaretAtCurrentPosition();
 	void DropCaret();
 	void CaretSetPeriod(int period);
+	void InvalidateCaretPosition(SelectionPosition pos);
 	void InvalidateCaret();
 	virtual void UpdateSystemCaret();
+	virtual bool BlinkCaret();
 
 	bool Wrapping() const;
 	void NeedWrapping(int docLineStart=0, int docLineEnd=WrapPending::lineLarge);
@@ -371,6 +379,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
 
+	void MeasureLongestLine();
 	void PaintSelMargin(Surface *surface, PRectangle &rc);
 	void RefreshPixMaps(Surface *surfaceWindow);
 	void Paint(Surface *surfaceWindow, PRectangle rcArea);
@@ -514,6 +523,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	int PositionAfterArea(PRectangle rcArea) const;
 	void StyleToPositionInView(Position pos);
+	int PositionAfterMaxStyling(int posMax, bool scrolling) const;
+	void StartIdleStyling(bool truncatedLastStyling);
+	void StyleAreaBounded(PRectangle rcArea, bool scrolling);
+	void IdleStyling();
 	virtual void IdleWork();
 	virtual void QueueIdleWork(WorkNeeded::workItems items, int upTo=0);
 
@@ -103,11 +103,45 @@ MarginView::MarginView() {
 	pixmapSelMargin = 0;
 	pixmapSelPattern = 0;
 	pixmapSelPatternOffset1 = 0;
+	for (int markBit = 0; markBit < markerCacheSize; markBit++) {
+		markerCache[markBit].pixmap = 0;
+		markerCache[markBit].image = 0;
+		markerCache[markBit].width = 0;
+		markerCache[markBit].height = 0;
+	}
+	markerCacheWid = 0;
+	for (int slot = 0; slot < numberCacheSize; slot++) {
+		numberCache[slot].pixmap = 0;
+		numberCache[slot].text[0] = '\0';
+		numberCache[slot].widthText = 0;
+		numberCache[slot].height = 0;
+	}
 	wrapMarkerPaddingRight = 3;
 	customDrawWrapMarker = NULL;
 }
 
+void MarginView::DropMarkerCache() {
+	for (int markBit = 0; markBit < markerCacheSize; markBit++) {
+		delete markerCache[markBit].pixmap;
+		markerCache[markBit].pixmap = 0;
+		markerCache[markBit].image = 0;
+	}
+}
+
+void MarginView::DropNumberCache() {
+	for (int slot = 0; slot < numberCacheSize; slot++) {
+		delete numberCache[slot].pixmap;
+		numberCache[slot].pixmap = 0;
+		numberCache[slot].text[0] = '\0';
+	}
+}
+
 void MarginView::DropGraphics(bool freeObjects) {
+	// Cached markers are dropped entirely either way: redefining a marker may
+	// reallocate its image at the address of a freed predecessor, so a released
+	// but surviving entry could pass the pointer validation with stale pixels.
+	DropMarkerCache();
+	DropNumberCache();
 	if (freeObjects) {
 		delete pixmapSelMargin;
 		pixmapSelMargin = 0;
@@ -135,6 +169,7 @@ void MarginView::AllocateGraphics(const ViewStyle &vsDraw) {
 }
 
 void MarginView::RefreshPixMaps(Surface *surfaceWindow, WindowID wid, const ViewStyle &vsDraw) {
+	markerCacheWid = wid;
 	if (!pixmapSelPattern->Initialised()) {
 		const int patternSize = 8;
 		pixmapSelPattern->InitPixMap(patternSize, patternSize, surfaceWindow, wid);
@@ -176,12 +211,149 @@ void MarginView::RefreshPixMaps(Surface *surfaceWindow, WindowID wid, const View
 	}
 }
 
+// Blits a pre-rendered copy of an image marker, rendering it first if the cache
+// entry is missing or was built for a different image, cell size or background.
+void MarginView::DrawMarkerCached(Surface *surface, int markBit, const LineMarker &marker,
+	const void *image, PRectangle &rcMarker, ColourDesired background,
+	Font &fontForCharacter, int marginStyle, int technology) {
+	CachedMarker &entry = markerCache[markBit];
+	const int width = static_cast<int>(rcMarker.Width());
+	const int height = static_cast<int>(rcMarker.Height());
+	if (!entry.pixmap || entry.image != image || entry.width != width ||
+		entry.height != height || !(entry.back == background)) {
+		PRectangle rcCell = PRectangle::FromInts(0, 0, width, height);
+		if (!entry.pixmap)
+			entry.pixmap = Surface::Allocate(technology);
+		entry.pixmap->InitPixMap(width, height, surface, markerCacheWid);
+		entry.pixmap->FillRectangle(rcCell, background);
+		marker.Draw(entry.pixmap, rcCell, fontForCharacter, LineMarker::undefined, marginStyle);
+		entry.image = image;
+		entry.width = width;
+		entry.height = height;
+		entry.back = background;
+	}
+	surface->Copy(rcMarker, Point(), *entry.pixmap);
+}
+
+static int NumberCacheHash(const char *s) {
+	unsigned int h = 0;
+	for (; *s; s++)
+		h = h * 33 + static_cast<unsigned char>(*s);
+	return h % MarginView::numberCacheSize;
+}
+
+// Right justifies and blits a pre-rendered copy of a line number, rendering it
+// first if the cache entry holds different text, cell height or colours.
+void MarginView::DrawNumberCached(Surface *surface, const char *number, PRectangle &rcMarker,
+	Font &fontLineNumber, const ViewStyle &vs) {
+	const int len = static_cast<int>(strlen(number));
+	if (len >= static_cast<int>(sizeof(numberCache[0].text))) {
+		// Too long for a cache entry, draw directly
+		PRectangle rcNumber = rcMarker;
+		XYPOSITION width = surface->WidthText(fontLineNumber, number, len);
+		rcNumber.left = rcNumber.right - width - vs.marginNumberPadding;
+		DrawTextNoClipPhase(surface, rcNumber, vs.styles[STYLE_LINENUMBER],
+			rcNumber.top + vs.maxAscent, number, len, drawAll);
+		return;
+	}
+	CachedNumber &entry = numberCache[NumberCacheHash(number)];
+	if (!entry.pixmap || (strcmp(entry.text, number) != 0) || (entry.height != vs.lineHeight) ||
+		!(entry.fore == vs.styles[STYLE_LINENUMBER].fore) ||
+		!(entry.back == vs.styles[STYLE_LINENUMBER].back)) {
+		entry.widthText = surface->WidthText(fontLineNumber, number, len);
+		PRectangle rcCell = PRectangle::FromInts(0, 0,
+			static_cast<int>(entry.widthText) + 1, vs.lineHeight);
+		if (!entry.pixmap)
+			entry.pixmap = Surface::Allocate(vs.technology);
+		entry.pixmap->InitPixMap(static_cast<int>(rcCell.right), vs.lineHeight,
+			surface, markerCacheWid);
+		entry.pixmap->FillRectangle(rcCell, vs.styles[STYLE_LINENUMBER].back);
+		DrawTextNoClipPhase(entry.pixmap, rcCell, vs.styles[STYLE_LINENUMBER],
+			vs.maxAscent, number, len, drawAll);
+		strcpy(entry.text, number);
+		entry.height = vs.lineHeight;
+		entry.fore = vs.styles[STYLE_LINENUMBER].fore;
+		entry.back = vs.styles[STYLE_LINENUMBER].back;
+	}
+	PRectangle rcNumber = rcMarker;
+	rcNumber.left = rcNumber.right - entry.widthText - vs.marginNumberPadding;
+	rcNumber.right = rcNumber.left + static_cast<XYPOSITION>(static_cast<int>(entry.widthText) + 1);
+	surface->Copy(rcNumber, Point(), *entry.pixmap);
+}
+
 static int SubstituteMarkerIfEmpty(int markerCheck, int markerDefault, const ViewStyle &vs) {
 	if (vs.markers[markerCheck].markType == SC_MARK_EMPTY)
 		return markerDefault;
 	return markerCheck;
 }
 
+// Paints a document overview strip: the whole file is mapped onto the margin
+// height and each pixel band is fed from downsampled marker and fold level
+// data, never from rendered text. A band samples the fold depth of its first
+// line and the first marker in its line range (cheap via the sorted marker
+// index), so the cost is proportional to the strip height regardless of how
+// large the document is.
+void MarginView::PaintOverviewMargin(Surface *surface, PRectangle rcMargin,
+	const EditModel &model, const ViewStyle &vs, int mask) {
+	surface->FillRectangle(rcMargin, vs.styles[STYLE_LINENUMBER].back);
+	const int linesTotal = model.pdoc->LinesTotal();
+	const int height = static_cast<int>(rcMargin.Height());
+	if ((linesTotal <= 0) || (height <= 0))
+		return;
+
+	const XYPOSITION widthFold = rcMargin.Width() / 2;
+	const ColourDesired colourFold = vs.styles[STYLE_LINENUMBER].fore;
+
+	for (int y = 0; y < height; y++) {
+		const int lineStart = static_cast<int>(
+			static_cast<long long>(y) * linesTotal / height);
+		int lineEnd = static_cast<int>(
+			static_cast<long long>(y + 1) * linesTotal / height) - 1;
+		if (lineEnd < lineStart)
+			lineEnd = lineStart;
+
+		// fold structure: a bar whose length follows the nesting depth
+		const int level = model.pdoc->GetLevel(lineStart);
+		const int depth = (level & SC_FOLDLEVELNUMBERMASK) - SC_FOLDLEVELBASE;
+		if (depth > 0) {
+			PRectangle rcFold(rcMargin.left, rcMargin.top + y,
+				rcMargin.left + widthFold * Platform::Minimum(depth, 8) / 8,
+				rcMargin.top + y + 1);
+			surface->FillRectangle(rcFold, colourFold);
+		}
+
+		// markers: the band shows the first marked line of its range in the
+		// colour of that line's lowest numbered marker
+		int lineMarked[1];
+		if (model.pdoc->MarkersInRange(lineStart, lineEnd, mask, lineMarked, 1) > 0) {
+			const int markValue = model.pdoc->GetMark(lineMarked[0]) & mask;
+			int markBit = 0;
+			while ((markBit < 32) && !(markValue & (1 << markBit)))
+				markBit++;
+			if (markBit < 32) {
+				PRectangle rcMark(rcMargin.left + widthFold, rcMargin.top + y,
+					rcMargin.right, rcMargin.top + y + 1);
+				surface->FillRectangle(rcMark, vs.markers[markBit].back);
+			}
+		}
+	}
+
+	// translucent band over the part of the file currently on screen
+	const int lineTop = model.cs.DocFromDisplay(model.TopLineOfMain());
+	const int lineBottom = model.cs.DocFromDisplay(
+		model.TopLineOfMain() + model.LinesOnScreen());
+	PRectangle rcVisible(rcMargin.left,
+		rcMargin.top + static_cast<XYPOSITION>(
+			static_cast<long long>(lineTop) * height / linesTotal),
+		rcMargin.right,
+		rcMargin.top + static_cast<XYPOSITION>(
+			(static_cast<long long>(lineBottom) + 1) * height / linesTotal));
+	if (rcVisible.bottom < rcVisible.top + 2)
+		rcVisible.bottom = rcVisible.top + 2;
+	surface->AlphaRectangle(rcVisible, 0, vs.styles[STYLE_DEFAULT].fore, 30,
+		vs.styles[STYLE_DEFAULT].fore, 60, 0);
+}
+
 void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRectangle rcMargin,
 	const EditModel &model, const ViewStyle &vs) {
 
@@ -198,6 +370,17 @@ void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRect
 			rcSelMargin.left = rcSelMargin.right;
 			rcSelMargin.right = rcSelMargin.left + vs.ms[margin].width;
 
+			if (vs.ms[margin].style == SC_MARGIN_OVERVIEW) {
+				// whole-document strip, not painted per visible line
+				PaintOverviewMargin(surface, rcSelMargin, model, vs, vs.ms[margin].mask);
+				continue;
+			}
+
+			// Solid background colour behind this margin's markers, when there is
+			// one; the fold margin's dithered pattern is not cacheable per colour.
+			ColourDesired colourMarginBack = vs.styles[STYLE_LINENUMBER].back;
+			bool marginBackSolid = true;
+
 			if (vs.ms[margin].style != SC_MARGIN_NUMBER) {
 				if (vs.ms[margin].mask & SC_MASK_FOLDERS) {
 					// Required because of special way brush is created for selection margin
@@ -206,6 +389,7 @@ void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRect
 					bool invertPhase = static_cast<int>(ptOrigin.y) & 1;
 					surface->FillRectangle(rcSelMargin,
 						invertPhase ? *pixmapSelPattern : *pixmapSelPatternOffset1);
+					marginBackSolid = false;
 				} else {
 					ColourDesired colour;
 					switch (vs.ms[margin].style) {
@@ -220,6 +404,7 @@ void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRect
 						break;
 					}
 					surface->FillRectangle(rcSelMargin, colour);
+					colourMarginBack = colour;
 				}
 			} else {
 				surface->FillRectangle(rcSelMargin, vs.styles[STYLE_LINENUMBER].back);
@@ -385,13 +570,8 @@ void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRect
 								sprintf(number, "%0X", state);
 							}
 						}
-						PRectangle rcNumber = rcMarker;
-						// Right justify
-						XYPOSITION width = surface->WidthText(fontLineNumber, number, static_cast<int>(strlen(number)));
-						XYPOSITION xpos = rcNumber.right - width - vs.marginNumberPadding;
-						rcNumber.left = xpos;
-						DrawTextNoClipPhase(surface, rcNumber, vs.styles[STYLE_LINENUMBER],
-							rcNumber.top + vs.maxAscent, number, static_cast<int>(strlen(number)), drawAll);
+						// Right justified from a cached rendering of the number
+						DrawNumberCached(surface, number, rcMarker, fontLineNumber, vs);
 					} else if (vs.wrapVisualFlags & SC_WRAPVISUALFLAG_MARGIN) {
 						PRectangle rcWrapMarker = rcMarker;
 						rcWrapMarker.right -= wrapMarkerPaddingRight;
@@ -439,7 +619,22 @@ void MarginView::PaintMargin(Surface *surface, int topLine, PRectangle rc, PRect
 									tFold = LineMarker::tail;
 								}
 							}
-							vs.markers[markBit].Draw(surface, rcMarker, fontLineNumber, tFold, vs.ms[margin].style);
+							const LineMarker &marker = vs.markers[markBit];
+							const void *markerImage = 0;
+							if ((marker.markType == SC_MARK_PIXMAP) && marker.pxpm)
+								markerImage = marker.pxpm;
+							else if ((marker.markType == SC_MARK_RGBAIMAGE) && marker.image)
+								markerImage = marker.image;
+							// Image markers are rasterised from their source data on
+							// every draw; blit a cached rendering instead when the
+							// background they sit on is a known solid colour.
+							if (markerImage && marginBackSolid) {
+								DrawMarkerCached(surface, markBit, marker, markerImage,
+									rcMarker, colourMarginBack, fontLineNumber,
+									vs.ms[margin].style, vs.technology);
+							} else {
+								marker.Draw(surface, rcMarker, fontLineNumber, tFold, vs.ms[margin].style);
+							}
 						}
 						marks >>= 1;
 					}
@@ -24,6 +24,39 @@ public:
 	Surface *pixmapSelMargin;
 	Surface *pixmapSelPattern;
 	Surface *pixmapSelPatternOffset1;
+	// Pre-rendered image markers. Pixmap and RGBA markers are rasterised from
+	// their source data on every Draw call, which dominates repaints of margins
+	// carrying many markers. An entry holds the marker composed over the solid
+	// margin background and is validated against the image instance, the cell
+	// size and that background; entries are dropped together with the other
+	// pixmaps, i.e. on style, zoom and marker definition changes.
+	struct CachedMarker {
+		Surface *pixmap;
+		const void *image;
+		int width;
+		int height;
+		ColourDesired back;
+	};
+	enum { markerCacheSize = 32 };
+	CachedMarker markerCache[markerCacheSize];
+	WindowID markerCacheWid;	// set in RefreshPixMaps, needed to create cache surfaces
+	// Pre-rendered line number cells. Each repaint lays out and draws the
+	// number text of every visible line, but the set of visible numbers is
+	// nearly identical from frame to frame, so cache each rendered number
+	// composed over the margin background and blit it on later frames. The
+	// cache is a direct-mapped hash on the number text; entries also remember
+	// the measured text width so right justification needs no layout either.
+	// Dropped with the other pixmaps on style and zoom changes.
+	struct CachedNumber {
+		Surface *pixmap;
+		char text[16];
+		XYPOSITION widthText;
+		int height;
+		ColourDesired fore;
+		ColourDesired back;
+	};
+	enum { numberCacheSize = 256 };
+	CachedNumber numberCache[numberCacheSize];
 	// Highlight current folding block
 	HighlightDelimiter highlightDelimiter;
 
@@ -37,8 +70,17 @@ public:
 	MarginView();
 
 	void DropGraphics(bool freeObjects);
+	void DropMarkerCache();
+	void DropNumberCache();
+	void DrawNumberCached(Surface *surface, const char *number, PRectangle &rcMarker,
+		Font &fontLineNumber, const ViewStyle &vs);
+	void DrawMarkerCached(Surface *surface, int markBit, const LineMarker &marker,
+		const void *image, PRectangle &rcMarker, ColourDesired background,
+		Font &fontForCharacter, int marginStyle, int technology);
 	void AllocateGraphics(const ViewStyle &vsDraw);
 	void RefreshPixMaps(Surface *surfaceWindow, WindowID wid, const ViewStyle &vsDraw);
+	void PaintOverviewMargin(Surface *surface, PRectangle rcMargin,
+		const EditModel &model, const ViewStyle &vs, int mask);
 	void PaintMargin(Surface *surface, int topLine, PRectangle rc, PRectangle rcMargin,
 		const EditModel &model, const ViewStyle &vs);
 };
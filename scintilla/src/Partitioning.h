@@ -109,6 +109,20 @@ public:
 		stepPartition++;
 	}
 
+	// Insert a run of consecutive partitions in one go.  Equivalent to calling
+	// InsertPartition for each element of positions but applies the step and
+	// opens the gap only once, which matters when a file load inserts every
+	// line of the document at the same point.
+	void InsertPartitions(int partition, const int *positions, int count) {
+		if (count <= 0)
+			return;
+		if (stepPartition < partition) {
+			ApplyStep(partition);
+		}
+		body->InsertFromArray(partition, positions, 0, count);
+		stepPartition += count;
+	}
+
 	void SetPartitionStartPosition(int partition, int pos) {
 		ApplyStep(partition+1);
 		if ((partition < 0) || (partition > body->Length())) {
@@ -126,11 +126,13 @@ void LineMarkers::Init() {
 		markers[line] = 0;
 	}
 	markers.DeleteAll();
+	markedLinesValid = false;
 }
 
 void LineMarkers::InsertLine(int line) {
 	if (markers.Length()) {
 		markers.Insert(line, 0);
+		markedLinesValid = false;
 	}
 }
 
@@ -141,6 +143,7 @@ void LineMarkers::RemoveLine(int line) {
 			MergeMarkers(line - 1);
 		}
 		markers.Delete(line);
+		markedLinesValid = false;
 	}
 }
 
@@ -174,19 +177,68 @@ int LineMarkers::MarkValue(int line) {
 		return 0;
 }
 
+// Collects the sorted list of lines that carry any marker. Rebuilt lazily:
+// structural changes only drop the index, so a burst of edits costs one scan
+// on the next query instead of bookkeeping per line shift, and repeated
+// next/previous navigation in between runs on binary searches.
+void LineMarkers::BuildMarkedLines() const {
+	markedLines.clear();
+	for (int line = 0; line < markers.Length(); line++) {
+		if (markers[line])
+			markedLines.push_back(line);
+	}
+	markedLinesValid = true;
+}
+
 int LineMarkers::MarkerNext(int lineStart, int mask) const {
 	if (lineStart < 0)
 		lineStart = 0;
-	int length = markers.Length();
-	for (int iLine = lineStart; iLine < length; iLine++) {
-		MarkerHandleSet *onLine = markers[iLine];
-		if (onLine && ((onLine->MarkValue() & mask) != 0))
-		//if ((pdoc->GetMark(iLine) & lParam) != 0)
-			return iLine;
+	if (!markedLinesValid)
+		BuildMarkedLines();
+	for (std::vector<int>::const_iterator it =
+			std::lower_bound(markedLines.begin(), markedLines.end(), lineStart);
+			it != markedLines.end(); ++it) {
+		if ((markers[*it]->MarkValue() & mask) != 0)
+			return *it;
 	}
 	return -1;
 }
 
+int LineMarkers::MarkerPrevious(int lineStart, int mask) const {
+	if (!markedLinesValid)
+		BuildMarkedLines();
+	for (std::vector<int>::const_iterator it =
+			std::upper_bound(markedLines.begin(), markedLines.end(), lineStart);
+			it != markedLines.begin();) {
+		--it;
+		if ((markers[*it]->MarkValue() & mask) != 0)
+			return *it;
+	}
+	return -1;
+}
+
+// Writes up to maxLines lines in [lineStart, lineEnd] whose markers intersect
+// mask into lines and returns how many matched in total, so callers can size
+// a buffer with a first lines == 0 pass. Meant for margin or overview style
+// rendering that needs all markers of a region in one call.
+int LineMarkers::MarkersInRange(int lineStart, int lineEnd, int mask, int *lines, int maxLines) const {
+	int count = 0;
+	if (lineStart < 0)
+		lineStart = 0;
+	if (!markedLinesValid)
+		BuildMarkedLines();
+	for (std::vector<int>::const_iterator it =
+			std::lower_bound(markedLines.begin(), markedLines.end(), lineStart);
+			(it != markedLines.end()) && (*it <= lineEnd); ++it) {
+		if ((markers[*it]->MarkValue() & mask) != 0) {
+			if (lines && (count < maxLines))
+				lines[count] = *it;
+			count++;
+		}
+	}
+	return count;
+}
+
 int LineMarkers::AddMark(int line, int markerNum, int lines) {
 	handleCurrent++;
 	if (!markers.Length()) {
@@ -201,6 +253,7 @@ int LineMarkers::AddMark(int line, int markerNum, int lines) {
 		markers[line] = new MarkerHandleSet();
 	}
 	markers[line]->InsertHandle(handleCurrent, markerNum);
+	markedLinesValid = false;
 
 	return handleCurrent;
 }
@@ -220,6 +273,39 @@ bool LineMarkers::DeleteMark(int line, int markerNum, bool all) {
 			}
 		}
 	}
+	if (someChanges)
+		markedLinesValid = false;
+	return someChanges;
+}
+
+bool LineMarkers::DeleteMarkAll(int markerNum) {
+	// Whole-document removal in one pass rather than a DeleteMark call per
+	// line; if no marker sets remain afterwards, release the per-line array.
+	bool someChanges = false;
+	bool anyLeft = false;
+	for (int line = 0; line < markers.Length(); line++) {
+		if (markers[line]) {
+			if (markerNum == -1) {
+				someChanges = true;
+				delete markers[line];
+				markers[line] = NULL;
+			} else {
+				if (markers[line]->RemoveNumber(markerNum, true))
+					someChanges = true;
+				if (markers[line]->Length() == 0) {
+					delete markers[line];
+					markers[line] = NULL;
+				} else {
+					anyLeft = true;
+				}
+			}
+		}
+	}
+	if (!anyLeft) {
+		markers.DeleteAll();
+	}
+	if (someChanges)
+		markedLinesValid = false;
 	return someChanges;
 }
 
@@ -231,6 +317,7 @@ void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 			delete markers[line];
 			markers[line] = NULL;
 		}
+		markedLinesValid = false;
 	}
 }
 
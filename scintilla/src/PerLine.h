@@ -44,8 +44,13 @@ class LineMarkers : public PerLine {
 	SplitVector<MarkerHandleSet *> markers;
 	/// Handles are allocated sequentially and should never have to be reused as 32 bit ints are very big.
 	int handleCurrent;
+	/// Sorted lines carrying at least one marker, rebuilt lazily after any
+	/// change so next/previous queries need not scan every line.
+	mutable std::vector<int> markedLines;
+	mutable bool markedLinesValid;
+	void BuildMarkedLines() const;
 public:
-	LineMarkers() : handleCurrent(0) {
+	LineMarkers() : handleCurrent(0), markedLinesValid(false) {
 	}
 	virtual ~LineMarkers();
 	virtual void Init();
@@ -54,9 +59,12 @@ public:
 
 	int MarkValue(int line);
 	int MarkerNext(int lineStart, int mask) const;
+	int MarkerPrevious(int lineStart, int mask) const;
+	int MarkersInRange(int lineStart, int lineEnd, int mask, int *lines, int maxLines) const;
 	int AddMark(int line, int marker, int lines);
 	void MergeMarkers(int pos);
 	bool DeleteMark(int line, int markerNum, bool all);
+	bool DeleteMarkAll(int markerNum);
 	void DeleteMarkFromHandle(int markerHandle);
 	int LineFromHandle(int markerHandle);
 };
@@ -488,6 +488,21 @@ TextSegment BreakFinder::Next() {
 	if (subBreak == -1) {
 		int prev = nextBreak;
 		while (nextBreak < lineRange.end) {
+			// Fast forward over runs of plain ASCII text in an unchanging style with no
+			// special representations registered for the bytes seen. Such bytes are one
+			// character wide in every encoding so the per-character width and
+			// representation lookups below can be skipped until a possible break.
+			if ((saeNext < 0) || (nextBreak < saeNext)) {
+				const int runLimit = ((saeNext >= 0) && (saeNext < lineRange.end)) ? saeNext : lineRange.end;
+				while ((nextBreak < runLimit) &&
+						(static_cast<unsigned char>(ll->chars[nextBreak]) < 0x80) &&
+						!preprs->MayContain(static_cast<unsigned char>(ll->chars[nextBreak])) &&
+						((nextBreak == 0) || (ll->styles[nextBreak] == ll->styles[nextBreak - 1]))) {
+					nextBreak++;
+				}
+				if (nextBreak >= lineRange.end)
+					break;
+			}
 			int charWidth = 1;
 			if (encodingFamily == efUnicode)
 				charWidth = UTF8DrawBytes(reinterpret_cast<unsigned char *>(ll->chars) + nextBreak, lineRange.end - nextBreak);
@@ -600,6 +615,12 @@ unsigned int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s,
 	return ret;
 }
 
+size_t PositionCacheEntry::ByteSize() const {
+	if (positions)
+		return (len + (len / 4) + 1) * sizeof(XYPOSITION) + len;
+	return 0;
+}
+
 bool PositionCacheEntry::NewerThan(const PositionCacheEntry &other) const {
 	return clock > other.clock;
 }
@@ -614,6 +635,8 @@ PositionCache::PositionCache() {
 	clock = 1;
 	pces.resize(0x400);
 	allClear = true;
+	bytesUsed = 0;
+	maxBytes = 1024 * 1024;
 }
 
 PositionCache::~PositionCache() {
@@ -628,6 +651,7 @@ void PositionCache::Clear() {
 	}
 	clock = 1;
 	allClear = true;
+	bytesUsed = 0;
 }
 
 void PositionCache::SetSize(size_t size_) {
@@ -640,10 +664,12 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 
 	allClear = false;
 	size_t probe = pces.size();	// Out of bounds
-	if ((!pces.empty()) && (len < 30)) {
-		// Only store short strings in the cache so it doesn't churn with
-		// long comments with only a single comment.
-
+	// Short strings are always cached; longer runs up to a whole undivided
+	// measurement are cached while within the byte budget, so repeated identical
+	// lines (logs, generated code) reuse measurements instead of remeasuring.
+	const bool cacheable = (len < 30) ||
+		((len <= BreakFinder::lengthStartSubdivision) && (bytesUsed < maxBytes));
+	if ((!pces.empty()) && cacheable) {
 		// Two way associative: try two probe positions.
 		unsigned int hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
 		probe = hashValue % pces.size();
@@ -660,13 +686,13 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 		}
 	}
 	if (len > BreakFinder::lengthStartSubdivision) {
-		// Break up into segments
+		// Break up into segments, measuring each through the cache so segments
+		// repeated across long lines reuse their measurements
 		unsigned int startSegment = 0;
 		XYPOSITION xStartSegment = 0;
 		while (startSegment < len) {
 			unsigned int lenSegment = pdoc->SafeSegment(s + startSegment, len - startSegment, BreakFinder::lengthEachSubdivision);
-			FontAlias fontStyle = vstyle.styles[styleNumber].font;
-			surface->MeasureWidths(fontStyle, s + startSegment, lenSegment, positions + startSegment);
+			MeasureWidths(surface, vstyle, styleNumber, s + startSegment, lenSegment, positions + startSegment, pdoc);
 			for (unsigned int inSeg = 0; inSeg < lenSegment; inSeg++) {
 				positions[startSegment + inSeg] += xStartSegment;
 			}
@@ -688,6 +714,8 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 			}
 			clock = 2;
 		}
+		bytesUsed -= pces[probe].ByteSize();
 		pces[probe].Set(styleNumber, s, len, positions, clock);
+		bytesUsed += pces[probe].ByteSize();
 	}
 }
@@ -98,7 +98,7 @@ public:
 
 class PositionCacheEntry {
 	unsigned int styleNumber:8;
-	unsigned int len:8;
+	unsigned int len:16;
 	unsigned int clock:16;
 	XYPOSITION *positions;
 public:
@@ -107,6 +107,7 @@ public:
 	void Set(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_, unsigned int clock_);
 	void Clear();
 	bool Retrieve(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_) const;
+	size_t ByteSize() const;
 	static unsigned int Hash(unsigned int styleNumber_, const char *s, unsigned int len);
 	bool NewerThan(const PositionCacheEntry &other) const;
 	void ResetClock();
@@ -130,6 +131,9 @@ public:
 	void ClearRepresentation(const char *charBytes);
 	const Representation *RepresentationFromCharacter(const char *charBytes, size_t len) const;
 	bool Contains(const char *charBytes, size_t len) const;
+	bool MayContain(unsigned char ch) const {
+		return startByteHasReprs[ch] != 0;
+	}
 	void Clear();
 };
 
@@ -178,6 +182,8 @@ class PositionCache {
 	std::vector<PositionCacheEntry> pces;
 	unsigned int clock;
 	bool allClear;
+	size_t bytesUsed;
+	size_t maxBytes;
 	// Private so PositionCache objects can not be copied
 	PositionCache(const PositionCache &);
 public:
@@ -6,6 +6,7 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "UniConversion.h"
 
@@ -22,9 +23,28 @@ enum { SURROGATE_TRAIL_FIRST = 0xDC00 };
 enum { SURROGATE_TRAIL_LAST = 0xDFFF };
 enum { SUPPLEMENTAL_PLANE_FIRST = 0x10000 };
 
+// True if the next sizeof(unsigned long) bytes are all ASCII.  Mostly-ASCII
+// text is the common case on the clipboard and search paths, so the
+// conversion loops below consume whole words of it at a time and only fall
+// back to the byte-wise decoders at non-ASCII boundaries.
+static inline bool AllASCII(const unsigned char *us) {
+	unsigned long chunk;
+	memcpy(&chunk, us, sizeof(chunk));
+	return (chunk & static_cast<unsigned long>(0x8080808080808080ULL)) == 0;
+}
+
 unsigned int UTF8Length(const wchar_t *uptr, unsigned int tlen) {
 	unsigned int len = 0;
 	for (unsigned int i = 0; i < tlen && uptr[i];) {
+		// Each non-NUL ASCII unit contributes one byte; step four at a time
+		while ((i + 4 <= tlen) &&
+			(uptr[i] && uptr[i] < 0x80) && (uptr[i+1] && uptr[i+1] < 0x80) &&
+			(uptr[i+2] && uptr[i+2] < 0x80) && (uptr[i+3] && uptr[i+3] < 0x80)) {
+			i += 4;
+			len += 4;
+		}
+		if ((i >= tlen) || !uptr[i])
+			break;
 		unsigned int uch = uptr[i];
 		if (uch < 0x80) {
 			len++;
@@ -45,6 +65,17 @@ unsigned int UTF8Length(const wchar_t *uptr, unsigned int tlen) {
 void UTF8FromUTF16(const wchar_t *uptr, unsigned int tlen, char *putf, unsigned int len) {
 	int k = 0;
 	for (unsigned int i = 0; i < tlen && uptr[i];) {
+		// Narrow runs of non-NUL ASCII units four at a time
+		while ((i + 4 <= tlen) &&
+			(uptr[i] && uptr[i] < 0x80) && (uptr[i+1] && uptr[i+1] < 0x80) &&
+			(uptr[i+2] && uptr[i+2] < 0x80) && (uptr[i+3] && uptr[i+3] < 0x80)) {
+			putf[k++] = static_cast<char>(uptr[i++]);
+			putf[k++] = static_cast<char>(uptr[i++]);
+			putf[k++] = static_cast<char>(uptr[i++]);
+			putf[k++] = static_cast<char>(uptr[i++]);
+		}
+		if ((i >= tlen) || !uptr[i])
+			break;
 		unsigned int uch = uptr[i];
 		if (uch < 0x80) {
 			putf[k++] = static_cast<char>(uch);
@@ -85,8 +116,16 @@ unsigned int UTF8CharLength(unsigned char ch) {
 unsigned int UTF16Length(const char *s, unsigned int len) {
 	unsigned int ulen = 0;
 	unsigned int charLen;
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(s);
 	for (unsigned int i=0; i<len;) {
-		unsigned char ch = static_cast<unsigned char>(s[i]);
+		// ASCII maps one byte to one UTF-16 unit so count whole words of it
+		while ((i + sizeof(unsigned long) <= len) && AllASCII(us + i)) {
+			i += static_cast<unsigned int>(sizeof(unsigned long));
+			ulen += static_cast<unsigned int>(sizeof(unsigned long));
+		}
+		if (i >= len)
+			break;
+		unsigned char ch = us[i];
 		if (ch < 0x80) {
 			charLen = 1;
 		} else if (ch < 0x80 + 0x40 + 0x20) {
@@ -108,6 +147,14 @@ unsigned int UTF16FromUTF8(const char *s, unsigned int len, wchar_t *tbuf, unsig
 	const unsigned char *us = reinterpret_cast<const unsigned char *>(s);
 	unsigned int i=0;
 	while ((i<len) && (ui<tlen)) {
+		// Widen whole words of ASCII without entering the decoder
+		while ((i + sizeof(unsigned long) <= len) && (ui + sizeof(unsigned long) <= tlen) &&
+			AllASCII(us + i)) {
+			for (unsigned int b = 0; b < sizeof(unsigned long); b++)
+				tbuf[ui++] = us[i++];
+		}
+		if ((i>=len) || (ui>=tlen))
+			break;
 		unsigned char ch = us[i++];
 		if (ch < 0x80) {
 			tbuf[ui] = ch;
@@ -144,6 +191,14 @@ unsigned int UTF32FromUTF8(const char *s, unsigned int len, unsigned int *tbuf,
 	const unsigned char *us = reinterpret_cast<const unsigned char *>(s);
 	unsigned int i=0;
 	while ((i<len) && (ui<tlen)) {
+		// Widen whole words of ASCII without entering the decoder
+		while ((i + sizeof(unsigned long) <= len) && (ui + sizeof(unsigned long) <= tlen) &&
+			AllASCII(us + i)) {
+			for (unsigned int b = 0; b < sizeof(unsigned long); b++)
+				tbuf[ui++] = us[i++];
+		}
+		if ((i>=len) || (ui>=tlen))
+			break;
 		unsigned char ch = us[i++];
 		wchar_t value = 0;
 		if (ch < 0x80) {
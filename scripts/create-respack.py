@@ -0,0 +1,60 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# License: GPL v2 or later
+#
+# Bundles data files into a single resource pack read by src/respack.c.
+#
+# Usage: create-respack.py OUTPUT FILE...
+# The FILE arguments are paths relative to the current directory; they are
+# stored in the pack under those relative names, which must match the paths
+# Geany uses below its system data directory.
+#
+# Format (all integers little endian):
+#   8 bytes   magic "GnyPack1"
+#   uint32    number of entries
+#   per entry:
+#     uint16  path length
+#     ...     path bytes (no terminator, '/' separated)
+#     uint32  offset of the file contents from the start of the pack
+#     uint32  size of the file contents
+#   file contents, concatenated
+
+import struct
+import sys
+
+MAGIC = b'GnyPack1'
+
+
+def main(args):
+    if len(args) < 2:
+        sys.stderr.write('Usage: create-respack.py OUTPUT FILE...\n')
+        return 1
+
+    output = args[0]
+    paths = args[1:]
+
+    contents = []
+    table_size = len(MAGIC) + 4
+    for path in paths:
+        with open(path, 'rb') as f:
+            contents.append(f.read())
+        table_size += 2 + len(path.replace('\\', '/').encode('utf-8')) + 8
+
+    with open(output, 'wb') as out:
+        out.write(MAGIC)
+        out.write(struct.pack('<I', len(paths)))
+        offset = table_size
+        for path, data in zip(paths, contents):
+            name = path.replace('\\', '/').encode('utf-8')
+            out.write(struct.pack('<H', len(name)))
+            out.write(name)
+            out.write(struct.pack('<II', offset, len(data)))
+            offset += len(data)
+        for data in contents:
+            out.write(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -76,11 +76,51 @@
 /* Number of editor indicators to draw - limited as this can affect performance */
 #define GEANY_BUILD_ERR_HIGHLIGHT_MAX 50
 
+/* Maximum number of output lines kept in the Compiler tab. Builds emitting
+ * hundreds of thousands of warnings used to grow the list store without bound
+ * and make the tree view (and so the whole UI) crawl; beyond this limit the
+ * oldest row is dropped for each new one, so the tab behaves like a ring
+ * buffer of the most recent output. */
+#define GEANY_BUILD_OUTPUT_MAX_LINES 20000
+
 
 GeanyBuildInfo build_info = {GEANY_GBG_FT, 0, 0, NULL, GEANY_FILETYPES_NONE, NULL, 0};
 
 static gchar *current_dir_entered = NULL;
 
+/* rows currently in the Compiler tab, to enforce GEANY_BUILD_OUTPUT_MAX_LINES */
+static guint compiler_output_rows = 0;
+
+#ifndef SYNC_SPAWN
+/* Asynchronous build-output parsing: extracting the error filename/line from
+ * every line of compiler output (regex matching in
+ * msgwin_parse_compiler_error_line()) is expensive enough that noisy builds
+ * made the whole UI unresponsive when it ran line by line on the main thread.
+ * Raw lines read from the build pipes are handed to a worker thread instead,
+ * and the parsed results are appended to the Compiler tab in batches from an
+ * idle handler. */
+enum
+{
+	BUILD_OUTPUT_LINE,		/* compiler output to parse and display */
+	BUILD_OUTPUT_RESET,		/* a new build started - reset parser state */
+	BUILD_OUTPUT_FINISHED	/* build exited - line holds the failure flag */
+};
+
+typedef struct
+{
+	gint type;
+	gchar *msg;			/* raw output line, owned by the item */
+	gint color;
+	gchar *filename;	/* error location, filled in by the parser thread */
+	gint line;
+} BuildOutputItem;
+
+static GAsyncQueue *build_parse_queue = NULL;
+static GStaticMutex build_parsed_mutex = G_STATIC_MUTEX_INIT;
+static GSList *build_parsed_items = NULL;	/* batch awaiting delivery, newest first */
+static gboolean build_flush_queued = FALSE;
+#endif
+
 typedef struct RunInfo
 {
 	GPid pid;
@@ -89,6 +129,21 @@ typedef struct RunInfo
 
 static RunInfo *run_info;
 
+/* Build commands invoked while another build is running are queued and started
+ * from build_exit_cb() as their predecessors finish, so a "build + lint + docs"
+ * sequence can be fired in one go. Execution stays serial: the Compiler tab,
+ * the error parser state and the working directory used to resolve relative
+ * paths in error messages are all single-instance, so interleaving concurrent
+ * output would corrupt error navigation. */
+typedef struct PendingBuild
+{
+	GeanyDocument *doc;
+	GeanyBuildGroup grp;
+	guint cmd;
+} PendingBuild;
+
+static GSList *build_queue = NULL;
+
 #ifdef G_OS_WIN32
 static const gchar RUN_SCRIPT_CMD[] = "geany_run_script.bat";
 #else
@@ -135,6 +190,7 @@ static void on_set_build_commands_activate(GtkWidget *w, gpointer u);
 static void on_build_next_error(GtkWidget *menuitem, gpointer user_data);
 static void on_build_previous_error(GtkWidget *menuitem, gpointer user_data);
 static void kill_process(GPid *pid);
+static void build_queue_start_next(void);
 static void show_build_result_message(gboolean failure);
 static void process_build_output_line(const gchar *line, gint color);
 static void show_build_commands_dialog(void);
@@ -145,6 +201,10 @@ void build_finalize(void)
 	g_free(build_info.dir);
 	g_free(build_info.custom_target);
 
+	g_slist_foreach(build_queue, (GFunc) g_free, NULL);
+	g_slist_free(build_queue);
+	build_queue = NULL;
+
 	if (menu_items.menu != NULL && GTK_IS_WIDGET(menu_items.menu))
 		gtk_widget_destroy(menu_items.menu);
 }
@@ -799,7 +859,12 @@ static GPid build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	}
 
 	clear_all_errors();
+#ifdef SYNC_SPAWN
 	SETPTR(current_dir_entered, NULL);
+#else
+	/* the parser thread owns current_dir_entered, so reset it from there */
+	build_parse_enqueue(BUILD_OUTPUT_RESET, NULL, 0, -1);
+#endif
 
 #ifdef G_OS_WIN32
 	argv = g_strsplit(cmd, " ", 0);
@@ -816,6 +881,7 @@ static GPid build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	working_dir = utils_get_locale_from_utf8(utf8_working_dir);
 
 	gtk_list_store_clear(msgwindow.store_compiler);
+	compiler_output_rows = 0;
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_COMPILER);
 	msgwin_compiler_add(COLOR_BLUE, _("%s (in directory: %s)"), utf8_cmd_string, utf8_working_dir);
 	g_free(utf8_working_dir);
@@ -1075,6 +1141,41 @@ static GPid build_run_cmd(GeanyDocument *doc, guint cmdindex)
 }
 
 
+/* appends one already parsed output line to the Compiler tab, setting the
+ * error indicator when a filename and line were extracted, and dropping the
+ * oldest row once the tab holds GEANY_BUILD_OUTPUT_MAX_LINES rows */
+static void build_show_output_line(const gchar *msg, gint color, const gchar *filename, gint line)
+{
+	if (line != -1 && filename != NULL)
+	{
+		GeanyDocument *doc = document_find_by_filename(filename);
+
+		/* limit number of indicators */
+		if (doc && editor_prefs.use_indicators &&
+			build_info.message_count < GEANY_BUILD_ERR_HIGHLIGHT_MAX)
+		{
+			if (line > 0) /* some compilers, like pdflatex report errors on line 0 */
+				line--;   /* so only adjust the line number if it is greater than 0 */
+			editor_indicator_set_on_line(doc->editor, GEANY_INDICATOR_ERROR, line);
+		}
+		build_info.message_count++;
+		color = COLOR_RED;	/* error message parsed on the line */
+	}
+
+	if (compiler_output_rows >= GEANY_BUILD_OUTPUT_MAX_LINES)
+	{
+		GtkTreeIter iter;
+
+		if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(msgwindow.store_compiler), &iter))
+			gtk_list_store_remove(msgwindow.store_compiler, &iter);
+	}
+	else
+		compiler_output_rows++;
+
+	msgwin_compiler_add_string(color, msg);
+}
+
+
 static void process_build_output_line(const gchar *str, gint color)
 {
 	gchar *msg, *tmp;
@@ -1097,29 +1198,115 @@ static void process_build_output_line(const gchar *str, gint color)
 	}
 	msgwin_parse_compiler_error_line(msg, current_dir_entered, &filename, &line);
 
-	if (line != -1 && filename != NULL)
+	build_show_output_line(msg, color, filename, line);
+
+	g_free(filename);
+	g_free(msg);
+}
+
+
+#ifndef SYNC_SPAWN
+static void build_output_item_free(BuildOutputItem *item)
+{
+	g_free(item->msg);
+	g_free(item->filename);
+	g_free(item);
+}
+
+
+/* idle handler delivering a batch of parsed output lines to the Compiler tab */
+static gboolean build_flush_parsed_items(gpointer data)
+{
+	GSList *items, *node;
+
+	g_static_mutex_lock(&build_parsed_mutex);
+	items = g_slist_reverse(build_parsed_items);
+	build_parsed_items = NULL;
+	build_flush_queued = FALSE;
+	g_static_mutex_unlock(&build_parsed_mutex);
+
+	foreach_slist(node, items)
 	{
-		GeanyDocument *doc = document_find_by_filename(filename);
+		BuildOutputItem *item = node->data;
 
-		/* limit number of indicators */
-		if (doc && editor_prefs.use_indicators &&
-			build_info.message_count < GEANY_BUILD_ERR_HIGHLIGHT_MAX)
+		if (item->type == BUILD_OUTPUT_FINISHED)
+			show_build_result_message(item->line);
+		else
+			build_show_output_line(item->msg, item->color, item->filename, item->line);
+		build_output_item_free(item);
+	}
+	g_slist_free(items);
+	return FALSE;
+}
+
+
+/* parses raw build output off the main thread. current_dir_entered and the
+ * error regexes are only touched here while a build is running, and the
+ * build_info fields read during parsing are set up before the first line of
+ * a build can be queued */
+static gpointer build_parse_thread_func(gpointer data)
+{
+	for (;;)
+	{
+		BuildOutputItem *item = g_async_queue_pop(build_parse_queue);
+
+		if (item->type == BUILD_OUTPUT_RESET)
 		{
-			if (line > 0) /* some compilers, like pdflatex report errors on line 0 */
-				line--;   /* so only adjust the line number if it is greater than 0 */
-			editor_indicator_set_on_line(doc->editor, GEANY_INDICATOR_ERROR, line);
+			SETPTR(current_dir_entered, NULL);
+			build_output_item_free(item);
+			continue;
 		}
-		build_info.message_count++;
-		color = COLOR_RED;	/* error message parsed on the line */
+		if (item->type == BUILD_OUTPUT_LINE)
+		{
+			gchar *tmp;
+
+			g_strchomp(item->msg);
+			if (EMPTY(item->msg))
+			{
+				build_output_item_free(item);
+				continue;
+			}
+			if (build_parse_make_dir(item->msg, &tmp))
+			{
+				SETPTR(current_dir_entered, tmp);
+			}
+			msgwin_parse_compiler_error_line(item->msg, current_dir_entered,
+				&item->filename, &item->line);
+		}
+
+		g_static_mutex_lock(&build_parsed_mutex);
+		build_parsed_items = g_slist_prepend(build_parsed_items, item);
+		if (! build_flush_queued)
+		{	/* one pending idle handler delivers the whole batch */
+			build_flush_queued = TRUE;
+			g_idle_add(build_flush_parsed_items, NULL);
+		}
+		g_static_mutex_unlock(&build_parsed_mutex);
 	}
-	g_free(filename);
+	return NULL;
+}
 
-	msgwin_compiler_add_string(color, msg);
-	g_free(msg);
+
+/* hands one item to the parser thread, starting it on first use;
+ * takes ownership of @msg */
+static void build_parse_enqueue(gint type, gchar *msg, gint color, gint line)
+{
+	BuildOutputItem *item = g_new0(BuildOutputItem, 1);
+
+	item->type = type;
+	item->msg = msg;
+	item->color = color;
+	item->line = line;
+
+	if (build_parse_queue == NULL)
+	{
+		build_parse_queue = g_async_queue_new();
+		g_thread_create(build_parse_thread_func, NULL, FALSE, NULL);
+	}
+	g_async_queue_push(build_parse_queue, item);
 }
 
 
-#ifndef SYNC_SPAWN
 static gboolean build_iofunc(GIOChannel *ioc, GIOCondition cond, gpointer data)
 {
 	if (cond & (G_IO_IN | G_IO_PRI))
@@ -1131,8 +1318,7 @@ static gboolean build_iofunc(GIOChannel *ioc, GIOCondition cond, gpointer data)
 		{
 			gint color = (GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK;
 
-			process_build_output_line(msg, color);
- 			g_free(msg);
+			build_parse_enqueue(BUILD_OUTPUT_LINE, msg, color, -1);
 		}
 		if (st == G_IO_STATUS_ERROR || st == G_IO_STATUS_EOF) return FALSE;
 	}
@@ -1237,7 +1423,9 @@ static void build_exit_cb(GPid child_pid, gint status, gpointer user_data)
 		failure = TRUE;
 	}
 #endif
-	show_build_result_message(failure);
+	/* routed through the parser queue so the result message appears after the
+	 * output lines still being parsed */
+	build_parse_enqueue(BUILD_OUTPUT_FINISHED, NULL, 0, failure);
 
 	utils_beep();
 	g_spawn_close_pid(child_pid);
@@ -1246,6 +1434,8 @@ static void build_exit_cb(GPid child_pid, gint status, gpointer user_data)
 	/* enable build items again */
 	build_menu_update(NULL);
 	ui_progress_bar_stop();
+	/* start the next queued build command, if any */
+	build_queue_start_next();
 }
 #endif
 
@@ -1356,6 +1546,25 @@ static void build_command(GeanyDocument *doc, GeanyBuildGroup grp, guint cmd, gc
 }
 
 
+/* Starts the next queued build command, skipping entries whose document was
+ * closed meanwhile, until one actually spawned or the queue is empty. */
+static void build_queue_start_next(void)
+{
+	while (build_queue != NULL && build_info.pid <= (GPid) 1)
+	{
+		PendingBuild *pending = build_queue->data;
+
+		build_queue = g_slist_remove(build_queue, pending);
+		if (pending->doc == NULL || pending->doc->is_valid)
+		{
+			g_signal_emit_by_name(geany_object, "build-start");
+			build_command(pending->doc, pending->grp, pending->cmd, NULL);
+		}
+		g_free(pending);
+	}
+}
+
+
 /*----------------------------------------------------------------
  *
  * Create build menu and handle callbacks (&toolbar callbacks)
@@ -1382,6 +1591,25 @@ static void on_build_menu_item(GtkWidget *w, gpointer user_data)
 	{
 		if (!document_save_file(doc, FALSE))
 			return;
+		/* with asynchronous saving the write may still be in flight; the
+		 * build must not read the file before it finished */
+		document_wait_for_saves();
+	}
+
+	if ((grp == GEANY_GBG_FT || grp == GEANY_GBG_NON_FT) &&
+		! (grp == GEANY_GBG_NON_FT && cmd == GBO_TO_CMD(GEANY_GBO_CUSTOM)) &&
+		build_info.pid > (GPid) 1)
+	{
+		/* another build is running: queue this command; "build-start" is
+		 * emitted when it actually starts */
+		PendingBuild *pending = g_new0(PendingBuild, 1);
+
+		pending->doc = doc;
+		pending->grp = grp;
+		pending->cmd = cmd;
+		build_queue = g_slist_append(build_queue, pending);
+		ui_set_statusbar(FALSE, _("Build command queued"));
+		return;
 	}
 	g_signal_emit_by_name(geany_object, "build-start");
 
@@ -1648,9 +1876,11 @@ void build_menu_update(GeanyDocument *doc)
 
 					if (grp < GEANY_GBG_EXEC)
 					{
+						/* build and make items stay sensitive while a build is
+						 * running - activating them queues the command */
 						cmd_sensitivity =
-							(grp == GEANY_GBG_FT && bc != NULL && have_path && ! build_running) ||
-							(grp == GEANY_GBG_NON_FT && bc != NULL && ! build_running);
+							(grp == GEANY_GBG_FT && bc != NULL && have_path) ||
+							(grp == GEANY_GBG_NON_FT && bc != NULL);
 						gtk_widget_set_sensitive(menu_item, cmd_sensitivity);
 						if (bc != NULL && !EMPTY(label))
 						{
@@ -1818,6 +2048,7 @@ static void kill_process(GPid *pid)
 
 static void on_build_next_error(GtkWidget *menuitem, gpointer user_data)
 {
+	msgwin_attach_tab_model(MSG_COMPILER);
 	if (ui_tree_view_find_next(GTK_TREE_VIEW(msgwindow.tree_compiler),
 		msgwin_goto_compiler_file_line))
 	{
@@ -1830,6 +2061,7 @@ static void on_build_next_error(GtkWidget *menuitem, gpointer user_data)
 
 static void on_build_previous_error(GtkWidget *menuitem, gpointer user_data)
 {
+	msgwin_attach_tab_model(MSG_COMPILER);
 	if (ui_tree_view_find_previous(GTK_TREE_VIEW(msgwindow.tree_compiler),
 		msgwin_goto_compiler_file_line))
 	{
@@ -113,6 +113,7 @@ G_MODULE_EXPORT void on_menu_comments_bsd_activate(GtkMenuItem *menuitem, gpoint
 G_MODULE_EXPORT void on_comments_bsd_activate(GtkMenuItem *menuitem, gpointer user_data);
 G_MODULE_EXPORT void on_menu_project1_activate(GtkMenuItem *menuitem, gpointer user_data);
 G_MODULE_EXPORT void on_load_tags1_activate(GtkMenuItem *menuitem, gpointer user_data);
+G_MODULE_EXPORT void on_rebuild_symbol_index1_activate(GtkMenuItem *menuitem, gpointer user_data);
 G_MODULE_EXPORT void on_file1_activate(GtkMenuItem *menuitem, gpointer user_data);
 G_MODULE_EXPORT void on_tv_notebook_switch_page_after(GtkNotebook *notebook, gpointer page, guint page_num, gpointer user_data);
 G_MODULE_EXPORT void on_tabs1_activate(GtkCheckMenuItem *menuitem, gpointer user_data);
@@ -204,28 +205,7 @@ G_MODULE_EXPORT void on_save_as1_activate(GtkMenuItem *menuitem, gpointer user_d
 
 G_MODULE_EXPORT void on_save_all1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
-	guint i, max = (guint) gtk_notebook_get_n_pages(GTK_NOTEBOOK(main_widgets.notebook));
-	GeanyDocument *doc, *cur_doc = document_get_current();
-	guint count = 0;
-
-	/* iterate over documents in tabs order */
-	for (i = 0; i < max; i++)
-	{
-		doc = document_get_from_page(i);
-		if (! doc->changed)
-			continue;
-
-		if (document_save_file(doc, FALSE))
-			count++;
-	}
-	if (!count)
-		return;
-
-	ui_set_statusbar(FALSE, ngettext("%d file saved.", "%d files saved.", count), count);
-	/* saving may have changed window title, sidebar for another doc, so update */
-	document_show_tab(cur_doc);
-	sidebar_update_tag_list(cur_doc, TRUE);
-	ui_set_window_title(cur_doc);
+	document_save_all();
 }
 
 
@@ -523,15 +503,50 @@ G_MODULE_EXPORT void on_normal_size1_activate(GtkMenuItem *menuitem, gpointer us
 }
 
 
-static gboolean delayed_check_disk_status(gpointer data)
+/* the document the pending switch-page idle callback will activate; switching
+ * again before it runs just repoints this, so only the document the user
+ * settles on pays for the UI updates */
+static GeanyDocument *pending_switch_doc = NULL;
+static guint pending_switch_source = 0;
+
+static gboolean on_switch_page_idle(gpointer data)
 {
-	document_check_disk_status(data, FALSE);
+	GeanyDocument *doc = pending_switch_doc;
+
+	pending_switch_source = 0;
+	pending_switch_doc = NULL;
+	/* the tab may have been closed, or left again, before we ran */
+	if (! DOC_VALID(doc) || doc != document_get_current())
+		return FALSE;
+
+	sidebar_select_openfiles_item(doc);
+	ui_save_buttons_toggle(doc->changed);
+	ui_set_window_title(doc);
+	ui_update_statusbar(doc, -1);
+	ui_update_popup_reundo_items(doc);
+	ui_document_show_hide(doc); /* update the document menu */
+	build_menu_update(doc);
+	sidebar_update_tag_list(doc, FALSE);
+	document_highlight_tags(doc);
+	/* Running the check here also avoids weird fast, unintended switching of notebook
+	 * pages when the 'file has changed' dialog is shown while the switch event is not
+	 * yet completely finished. */
+	document_check_disk_status(doc, FALSE);
+
+#ifdef HAVE_VTE
+	vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
+#endif
+
+	g_signal_emit_by_name(geany_object, "document-activate", doc);
 	return FALSE;
 }
 
 
 /* Changes window-title after switching tabs and lots of other things.
- * note: using 'after' makes Scintilla redraw before the UI, appearing more responsive */
+ * The switch itself only swaps the Scintilla widget; the UI updates (statusbar,
+ * menus, symbol list, disk check, "document-activate") run from an idle callback
+ * once the user has settled on a tab, so flipping through tabs of large files
+ * stays instant and the skipped tabs never pay for them. */
 G_MODULE_EXPORT void on_notebook1_switch_page_after(GtkNotebook *notebook, gpointer page,
 		guint page_num, gpointer user_data)
 {
@@ -547,26 +562,9 @@ G_MODULE_EXPORT void on_notebook1_switch_page_after(GtkNotebook *notebook, gpoin
 
 	if (doc != NULL)
 	{
-		sidebar_select_openfiles_item(doc);
-		ui_save_buttons_toggle(doc->changed);
-		ui_set_window_title(doc);
-		ui_update_statusbar(doc, -1);
-		ui_update_popup_reundo_items(doc);
-		ui_document_show_hide(doc); /* update the document menu */
-		build_menu_update(doc);
-		sidebar_update_tag_list(doc, FALSE);
-		document_highlight_tags(doc);
-
-		/* We delay the check to avoid weird fast, unintended switching of notebook pages when
-		 * the 'file has changed' dialog is shown while the switch event is not yet completely
-		 * finished. So, we check after the switch has been performed to be safe. */
-		g_idle_add(delayed_check_disk_status, doc);
-
-#ifdef HAVE_VTE
-		vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
-#endif
-
-		g_signal_emit_by_name(geany_object, "document-activate", doc);
+		pending_switch_doc = doc;
+		if (pending_switch_source == 0)
+			pending_switch_source = g_idle_add(on_switch_page_idle, NULL);
 	}
 }
 
@@ -1385,6 +1383,7 @@ G_MODULE_EXPORT void on_menu_decrease_indent1_activate(GtkMenuItem *menuitem, gp
 
 G_MODULE_EXPORT void on_next_message1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
+	msgwin_attach_tab_model(MSG_MESSAGE);
 	if (! ui_tree_view_find_next(GTK_TREE_VIEW(msgwindow.tree_msg),
 		msgwin_goto_messages_file_line))
 		ui_set_statusbar(FALSE, _("No more message items."));
@@ -1393,6 +1392,7 @@ G_MODULE_EXPORT void on_next_message1_activate(GtkMenuItem *menuitem, gpointer u
 
 G_MODULE_EXPORT void on_previous_message1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
+	msgwin_attach_tab_model(MSG_MESSAGE);
 	if (! ui_tree_view_find_previous(GTK_TREE_VIEW(msgwindow.tree_msg),
 		msgwin_goto_messages_file_line))
 		ui_set_statusbar(FALSE, _("No more message items."));
@@ -1514,7 +1514,8 @@ G_MODULE_EXPORT void on_remove_markers1_activate(GtkMenuItem *menuitem, gpointer
 
 	sci_marker_delete_all(doc->editor->sci, 0);	/* delete the yellow tag marker */
 	sci_marker_delete_all(doc->editor->sci, 1);	/* delete user markers */
-	editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
+	/* clears the search indicator and resets the cached match state */
+	search_mark_all(doc, NULL, 0);
 }
 
 
@@ -1524,6 +1525,12 @@ G_MODULE_EXPORT void on_load_tags1_activate(GtkMenuItem *menuitem, gpointer user
 }
 
 
+G_MODULE_EXPORT void on_rebuild_symbol_index1_activate(GtkMenuItem *menuitem, gpointer user_data)
+{
+	tools_rebuild_symbol_index();
+}
+
+
 G_MODULE_EXPORT void on_context_action1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
 	gchar *word, *command;
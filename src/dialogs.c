@@ -35,6 +35,7 @@
 #include "encodings.h"
 #include "filetypes.h"
 #include "main.h"
+#include "project.h"
 #include "support.h"
 #include "utils.h"
 #include "ui_utils.h"
@@ -1437,3 +1438,458 @@ gint dialogs_show_prompt(GtkWidget *parent,
 	g_free(string);
 	return result;
 }
+
+
+/* --- fuzzy "Go to File" dialog --- */
+
+#define GOTO_FILE_MAX_RESULTS 100
+#define GOTO_FILE_MRU_LENGTH 20
+
+enum
+{
+	GOTO_FILE_COLUMN_NAME,
+	GOTO_FILE_COLUMN_PATH,
+	GOTO_FILE_COLUMN_ENTRY,
+	GOTO_FILE_COLUMNS
+};
+
+/* One indexed file. All strings are owned by the entry; lower is the
+ * lowercased display path the matcher runs on, base points at its basename. */
+typedef struct
+{
+	gchar *display;			/* UTF-8 path relative to the index root */
+	gchar *locale_path;		/* absolute path in locale encoding, for opening */
+	gchar *lower;			/* lowercased display used for matching */
+	const gchar *base;		/* basename within lower */
+}
+GotoFileEntry;
+
+typedef struct
+{
+	GotoFileEntry *entry;
+	gint score;
+}
+GotoFileMatch;
+
+static struct
+{
+	GtkWidget *dialog;
+	GtkWidget *entry;
+	GtkWidget *view;
+	GtkListStore *store;
+	GPtrArray *index;	/* GotoFileEntry list, rebuilt on every show */
+	gchar *filter;		/* the query the current matches were computed for */
+	GPtrArray *matches;	/* entries matching filter, borrowed from the index */
+	GQueue *mru;		/* display paths of recently opened files */
+} goto_file = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+
+static void goto_file_entry_free(GotoFileEntry *entry)
+{
+	g_free(entry->display);
+	g_free(entry->locale_path);
+	g_free(entry->lower);
+	g_free(entry);
+}
+
+
+static GotoFileEntry *goto_file_entry_new(const gchar *display, gchar *locale_path)
+{
+	GotoFileEntry *entry = g_new(GotoFileEntry, 1);
+	const gchar *base;
+
+	entry->display = g_strdup(display);
+	entry->locale_path = locale_path;
+	entry->lower = g_utf8_strdown(display, -1);
+	base = strrchr(entry->lower, G_DIR_SEPARATOR);
+	entry->base = (base != NULL) ? base + 1 : entry->lower;
+	return entry;
+}
+
+
+/* Builds the searchable file list: the project manifest when one is loaded
+ * and reconciled with the disk, otherwise the files open in the session. */
+static GPtrArray *goto_file_build_index(void)
+{
+	GPtrArray *index = g_ptr_array_new();
+	gchar *base_path = project_get_base_path();
+
+	if (base_path != NULL)
+	{
+		gchar *locale_root = utils_get_locale_from_utf8(base_path);
+		GPtrArray *files = project_get_file_list(locale_root);
+
+		if (files != NULL)
+		{
+			guint i;
+
+			for (i = 0; i < files->len; i++)
+			{
+				gchar *rel = files->pdata[i];
+				gchar *display = utils_get_utf8_from_locale(rel);
+
+				g_ptr_array_add(index, goto_file_entry_new(display,
+					g_build_filename(locale_root, rel, NULL)));
+				g_free(display);
+				g_free(rel);
+			}
+			g_ptr_array_free(files, TRUE);
+		}
+		g_free(locale_root);
+		g_free(base_path);
+	}
+
+	if (index->len == 0)
+	{	/* no usable manifest: at least make the open files searchable */
+		guint i;
+
+		foreach_document(i)
+		{
+			GeanyDocument *doc = documents[i];
+
+			if (doc->file_name != NULL)
+				g_ptr_array_add(index, goto_file_entry_new(doc->file_name,
+					utils_get_locale_from_utf8(doc->file_name)));
+		}
+	}
+	return index;
+}
+
+
+/* Scores the entry against the lowercased query as a subsequence match over
+ * the relative path. Runs of consecutive matches and matches after a path or
+ * word separator score higher, matches that all land in the basename higher
+ * still, and long paths are slightly penalized so tight matches rank first.
+ * Returns -1 when query is not a subsequence of the path. */
+static gint goto_file_match_score(const GotoFileEntry *entry, const gchar *query)
+{
+	const gchar *path = entry->lower;
+	const gchar *q = query;
+	gint score = 0;
+	gint run = 0;
+	gboolean boundary = TRUE;
+
+	for (; *path != '\0' && *q != '\0'; path++)
+	{
+		if (*path == *q)
+		{
+			score += 1 + 2 * run;
+			if (boundary)
+				score += 4;
+			run++;
+			q++;
+		}
+		else
+			run = 0;
+		boundary = (*path == G_DIR_SEPARATOR || *path == '_' || *path == '-' || *path == '.');
+	}
+	if (*q != '\0')
+		return -1;
+
+	/* an extra bonus when the query is a subsequence of the basename alone,
+	 * the most common way to look for a file */
+	for (path = entry->base, q = query; *path != '\0' && *q != '\0'; path++)
+	{
+		if (*path == *q)
+			q++;
+	}
+	if (*q == '\0')
+		score += 16;
+
+	return score - (gint) strlen(entry->lower) / 8;
+}
+
+
+/* Recently opened files get a bonus proportional to how recently they were
+ * used, so repeat jumps stay at the top of the list. */
+static gint goto_file_mru_bonus(const gchar *display)
+{
+	GList *node;
+	gint bonus = 2 * GOTO_FILE_MRU_LENGTH;
+
+	if (goto_file.mru == NULL)
+		return 0;
+	for (node = goto_file.mru->head; node != NULL; node = node->next, bonus -= 2)
+	{
+		if (strcmp(node->data, display) == 0)
+			return bonus;
+	}
+	return 0;
+}
+
+
+static gint goto_file_match_compare(gconstpointer a, gconstpointer b)
+{
+	const GotoFileMatch *ma = a;
+	const GotoFileMatch *mb = b;
+
+	if (ma->score != mb->score)
+		return mb->score - ma->score;
+	return strcmp(ma->entry->display, mb->entry->display);
+}
+
+
+static void goto_file_remember(const gchar *display)
+{
+	GList *node;
+
+	if (goto_file.mru == NULL)
+		goto_file.mru = g_queue_new();
+	for (node = goto_file.mru->head; node != NULL; node = node->next)
+	{
+		if (strcmp(node->data, display) == 0)
+		{
+			g_free(node->data);
+			g_queue_delete_link(goto_file.mru, node);
+			break;
+		}
+	}
+	g_queue_push_head(goto_file.mru, g_strdup(display));
+	while (g_queue_get_length(goto_file.mru) > GOTO_FILE_MRU_LENGTH)
+		g_free(g_queue_pop_tail(goto_file.mru));
+}
+
+
+static void goto_file_fill_store(GArray *ranked)
+{
+	guint i, count;
+
+	gtk_list_store_clear(goto_file.store);
+	count = MIN(ranked->len, GOTO_FILE_MAX_RESULTS);
+	for (i = 0; i < count; i++)
+	{
+		GotoFileMatch *match = &g_array_index(ranked, GotoFileMatch, i);
+		gchar *name = g_path_get_basename(match->entry->display);
+		GtkTreeIter iter;
+
+		gtk_list_store_append(goto_file.store, &iter);
+		gtk_list_store_set(goto_file.store, &iter,
+			GOTO_FILE_COLUMN_NAME, name,
+			GOTO_FILE_COLUMN_PATH, match->entry->display,
+			GOTO_FILE_COLUMN_ENTRY, match->entry,
+			-1);
+		g_free(name);
+	}
+	if (count > 0)
+	{	/* preselect the best match so Enter jumps straight to it */
+		GtkTreeIter iter;
+
+		gtk_tree_model_get_iter_first(GTK_TREE_MODEL(goto_file.store), &iter);
+		gtk_tree_selection_select_iter(
+			gtk_tree_view_get_selection(GTK_TREE_VIEW(goto_file.view)), &iter);
+	}
+}
+
+
+static void goto_file_refilter(void)
+{
+	gchar *query;
+	GPtrArray *source;
+	GPtrArray *matches;
+	GArray *ranked;
+	guint i;
+
+	if (goto_file.index == NULL)
+		return;
+
+	query = g_utf8_strdown(gtk_entry_get_text(GTK_ENTRY(goto_file.entry)), -1);
+	if (EMPTY(query))
+	{
+		gtk_list_store_clear(goto_file.store);
+		if (goto_file.matches != NULL)
+			g_ptr_array_free(goto_file.matches, TRUE);
+		goto_file.matches = NULL;
+		SETPTR(goto_file.filter, NULL);
+		g_free(query);
+		return;
+	}
+
+	/* extending the query can only narrow the result set, so rescan just the
+	 * previous matches instead of the whole index - this is what keeps each
+	 * keystroke fast on very large projects */
+	if (goto_file.matches != NULL && !EMPTY(goto_file.filter) &&
+		g_str_has_prefix(query, goto_file.filter))
+		source = goto_file.matches;
+	else
+		source = goto_file.index;
+
+	matches = g_ptr_array_sized_new(1024);
+	ranked = g_array_sized_new(FALSE, FALSE, sizeof(GotoFileMatch), 1024);
+	for (i = 0; i < source->len; i++)
+	{
+		GotoFileMatch match;
+
+		match.entry = source->pdata[i];
+		match.score = goto_file_match_score(match.entry, query);
+		if (match.score < 0)
+			continue;
+		g_ptr_array_add(matches, match.entry);
+		match.score += goto_file_mru_bonus(match.entry->display);
+		g_array_append_val(ranked, match);
+	}
+	g_array_sort(ranked, goto_file_match_compare);
+	goto_file_fill_store(ranked);
+	g_array_free(ranked, TRUE);
+
+	if (goto_file.matches != NULL)
+		g_ptr_array_free(goto_file.matches, TRUE);
+	goto_file.matches = matches;
+	SETPTR(goto_file.filter, query);
+}
+
+
+static void goto_file_activate_selection(void)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(goto_file.store);
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(goto_file.view));
+	GtkTreeIter iter;
+	GotoFileEntry *entry = NULL;
+
+	if (! gtk_tree_selection_get_selected(selection, NULL, &iter) &&
+		! gtk_tree_model_get_iter_first(model, &iter))
+		return;
+
+	gtk_tree_model_get(model, &iter, GOTO_FILE_COLUMN_ENTRY, &entry, -1);
+	if (entry == NULL)
+		return;
+
+	if (document_open_file(entry->locale_path, FALSE, NULL, NULL) != NULL)
+	{
+		goto_file_remember(entry->display);
+		gtk_widget_hide(goto_file.dialog);
+	}
+	else
+		utils_beep();
+}
+
+
+static void on_goto_file_entry_changed(G_GNUC_UNUSED GtkEditable *editable,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_file_refilter();
+}
+
+
+static void on_goto_file_entry_activate(G_GNUC_UNUSED GtkEntry *entry,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_file_activate_selection();
+}
+
+
+static void on_goto_file_row_activated(G_GNUC_UNUSED GtkTreeView *view,
+		G_GNUC_UNUSED GtkTreePath *path, G_GNUC_UNUSED GtkTreeViewColumn *column,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_file_activate_selection();
+}
+
+
+static void on_goto_file_response(GtkWidget *dialog, gint response,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	if (response == GTK_RESPONSE_ACCEPT)
+		goto_file_activate_selection();
+	else
+		gtk_widget_hide(dialog);
+}
+
+
+/* drop the index when the dialog goes away; a fresh one is built on every
+ * show so the list follows the manifest without change tracking */
+static void on_goto_file_hide(G_GNUC_UNUSED GtkWidget *widget,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	gtk_list_store_clear(goto_file.store);
+	if (goto_file.matches != NULL)
+	{
+		g_ptr_array_free(goto_file.matches, TRUE);
+		goto_file.matches = NULL;
+	}
+	if (goto_file.index != NULL)
+	{
+		g_ptr_array_foreach(goto_file.index, (GFunc) goto_file_entry_free, NULL);
+		g_ptr_array_free(goto_file.index, TRUE);
+		goto_file.index = NULL;
+	}
+	SETPTR(goto_file.filter, NULL);
+}
+
+
+static void create_goto_file_dialog(void)
+{
+	GtkWidget *vbox, *scrolled;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	goto_file.dialog = gtk_dialog_new_with_buttons(_("Go to File"),
+		GTK_WINDOW(main_widgets.window), GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE,
+		GTK_STOCK_OPEN, GTK_RESPONSE_ACCEPT, NULL);
+	gtk_widget_set_name(goto_file.dialog, "GeanyDialog");
+	gtk_window_set_default_size(GTK_WINDOW(goto_file.dialog), 500, 350);
+	gtk_dialog_set_default_response(GTK_DIALOG(goto_file.dialog), GTK_RESPONSE_ACCEPT);
+
+	vbox = ui_dialog_vbox_new(GTK_DIALOG(goto_file.dialog));
+
+	goto_file.entry = gtk_entry_new();
+	gtk_box_pack_start(GTK_BOX(vbox), goto_file.entry, FALSE, FALSE, 0);
+
+	goto_file.store = gtk_list_store_new(GOTO_FILE_COLUMNS,
+		G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER);
+	goto_file.view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(goto_file.store));
+	g_object_unref(goto_file.store);
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(goto_file.view), FALSE);
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("File"), renderer,
+		"text", GOTO_FILE_COLUMN_NAME, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_file.view), column);
+
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_START, NULL);
+	column = gtk_tree_view_column_new_with_attributes(_("Path"), renderer,
+		"text", GOTO_FILE_COLUMN_PATH, NULL);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_file.view), column);
+
+	scrolled = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+		GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_container_add(GTK_CONTAINER(scrolled), goto_file.view);
+	gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+
+	g_signal_connect(goto_file.entry, "changed",
+		G_CALLBACK(on_goto_file_entry_changed), NULL);
+	g_signal_connect(goto_file.entry, "activate",
+		G_CALLBACK(on_goto_file_entry_activate), NULL);
+	g_signal_connect(goto_file.view, "row-activated",
+		G_CALLBACK(on_goto_file_row_activated), NULL);
+	g_signal_connect(goto_file.dialog, "response",
+		G_CALLBACK(on_goto_file_response), NULL);
+	g_signal_connect(goto_file.dialog, "hide",
+		G_CALLBACK(on_goto_file_hide), NULL);
+	g_signal_connect(goto_file.dialog, "delete-event",
+		G_CALLBACK(gtk_widget_hide_on_delete), NULL);
+}
+
+
+void dialogs_show_goto_file(void)
+{
+	if (goto_file.dialog == NULL)
+		create_goto_file_dialog();
+
+	if (goto_file.index != NULL)
+	{
+		g_ptr_array_foreach(goto_file.index, (GFunc) goto_file_entry_free, NULL);
+		g_ptr_array_free(goto_file.index, TRUE);
+	}
+	goto_file.index = goto_file_build_index();
+	SETPTR(goto_file.filter, NULL);
+
+	gtk_entry_set_text(GTK_ENTRY(goto_file.entry), "");
+	gtk_list_store_clear(goto_file.store);
+	gtk_widget_show_all(goto_file.dialog);
+	gtk_widget_grab_focus(goto_file.entry);
+	gtk_window_present(GTK_WINDOW(goto_file.dialog));
+}
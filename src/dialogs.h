@@ -54,6 +54,8 @@ typedef void (*GeanyInputCallback)(const gchar *text, gpointer data);
 
 void dialogs_show_open_file(void);
 
+void dialogs_show_goto_file(void);
+
 gboolean dialogs_show_unsaved_file(GeanyDocument *doc);
 
 void dialogs_show_open_font(void);
@@ -40,6 +40,7 @@
 #include "geanyobject.h"
 #include "geanywraplabel.h"
 #include "highlighting.h"
+#include "keyfile.h"
 #include "main.h"
 #include "msgwindow.h"
 #include "navqueue.h"
@@ -47,6 +48,7 @@
 #include "project.h"
 #include "sciwrappers.h"
 #include "sidebar.h"
+#include "stats.h"
 #include "support.h"
 #include "symbols.h"
 #include "ui_utils.h"
@@ -74,8 +76,6 @@
 /* gstdio.h also includes sys/stat.h */
 #include <glib/gstdio.h>
 
-/* uncomment to use GIO based file monitoring, though it is not completely stable yet */
-/*#define USE_GIO_FILEMON 1*/
 #include <gio/gio.h>
 
 #include <gdk/gdkkeysyms.h>
@@ -121,10 +121,24 @@ enum
 
 static guint doc_id_counter = 0;
 
+/* pending timeout collecting a burst of file monitor events for a bulk reload
+ * (see document_reload_all_changed()) */
+static guint bulk_reload_source = 0;
+
 
 static void document_undo_clear(GeanyDocument *doc);
 static void document_redo_add(GeanyDocument *doc, guint type, gpointer data);
 static gboolean remove_page(guint page_num);
+static void on_document_tags_parsed(TMSourceFile *source_file, gpointer user_data);
+static void document_cancel_background_load(GeanyDocument *doc);
+static void monitor_reload_file(GeanyDocument *doc);
+static gboolean save_all_is_inflight(GeanyDocument *doc);
+static void save_all_queue_write(GeanyDocument *doc, const gchar *locale_filename,
+	gchar *data, gsize len);
+static gboolean bulk_reload_timeout(gpointer data);
+static void clone_pair_split(GeanyDocument *doc);
+static void document_save_undo_history(GeanyDocument *doc);
+static void document_restore_undo_history(GeanyDocument *doc);
 static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgtype,
 	void (*response_cb)(GtkWidget *info_bar, gint response_id, GeanyDocument *doc),
 	const gchar *btn_1, GtkResponseType response_1,
@@ -133,6 +147,72 @@ static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgty
 	const gchar *extra_text, const gchar *format, ...) G_GNUC_PRINTF(11, 12);
 
 
+/* Hash indexes over the open documents so the filename lookups called from
+ * hot paths (navigation queue jumps, search result activation, disk change
+ * checks) are a probe instead of a scan over every document with per-element
+ * string comparison. The tables own copies of the keys; on key collisions
+ * (e.g. two unsaved documents given the same name) the document first in
+ * documents_array wins, matching the old scan order. Rebuilt by
+ * document_index_update() whenever a file_name or real_path changes, which is
+ * rare compared to lookups. */
+static GHashTable *file_name_index = NULL;	/* GeanyDocument::file_name -> doc */
+static GHashTable *real_path_index = NULL;	/* GeanyDocument::real_path -> doc */
+
+
+/* hash/equal pair matching utils_filenamecmp() semantics (filename case is
+ * ignored on Windows) */
+static guint document_index_hash(gconstpointer key)
+{
+#ifdef G_OS_WIN32
+	guint hash;
+	gchar *down = g_utf8_validate(key, -1, NULL) ?
+		g_utf8_strdown(key, -1) : g_strdup(key);
+
+	hash = g_str_hash(down);
+	g_free(down);
+	return hash;
+#else
+	return g_str_hash(key);
+#endif
+}
+
+
+static gboolean document_index_equal(gconstpointer a, gconstpointer b)
+{
+	return utils_filenamecmp((const gchar *) a, (const gchar *) b) == 0;
+}
+
+
+/* rebuilds the lookup indexes from documents_array; must be called after any
+ * change to a document's file_name or real_path, including closing */
+static void document_index_update(void)
+{
+	guint i;
+
+	if (file_name_index == NULL)
+	{
+		file_name_index = g_hash_table_new_full(document_index_hash,
+			document_index_equal, g_free, NULL);
+		real_path_index = g_hash_table_new_full(document_index_hash,
+			document_index_equal, g_free, NULL);
+	}
+	g_hash_table_remove_all(file_name_index);
+	g_hash_table_remove_all(real_path_index);
+
+	foreach_document(i)
+	{
+		GeanyDocument *doc = documents[i];
+
+		if (doc->file_name != NULL &&
+			g_hash_table_lookup(file_name_index, doc->file_name) == NULL)
+			g_hash_table_insert(file_name_index, g_strdup(doc->file_name), doc);
+		if (doc->real_path != NULL &&
+			g_hash_table_lookup(real_path_index, doc->real_path) == NULL)
+			g_hash_table_insert(real_path_index, g_strdup(doc->real_path), doc);
+	}
+}
+
+
 /**
  * Finds a document whose @c real_path field matches the given filename.
  *
@@ -148,24 +228,12 @@ static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgty
  **/
 GeanyDocument* document_find_by_real_path(const gchar *realname)
 {
-	guint i;
-
 	if (! realname)
 		return NULL;	/* file doesn't exist on disk */
+	if (real_path_index == NULL)
+		return NULL;	/* no document was ever opened */
 
-	for (i = 0; i < documents_array->len; i++)
-	{
-		GeanyDocument *doc = documents[i];
-
-		if (! doc->is_valid || ! doc->real_path)
-			continue;
-
-		if (utils_filenamecmp(realname, doc->real_path) == 0)
-		{
-			return doc;
-		}
-	}
-	return NULL;
+	return g_hash_table_lookup(real_path_index, realname);
 }
 
 
@@ -193,7 +261,6 @@ static gchar *get_real_path_from_utf8(const gchar *utf8_filename)
  **/
 GeanyDocument *document_find_by_filename(const gchar *utf8_filename)
 {
-	guint i;
 	GeanyDocument *doc;
 	gchar *realname;
 
@@ -201,17 +268,11 @@ GeanyDocument *document_find_by_filename(const gchar *utf8_filename)
 
 	/* First search GeanyDocument::file_name, so we can find documents with a
 	 * filename set but not saved on disk, like vcdiff produces */
-	for (i = 0; i < documents_array->len; i++)
+	if (file_name_index != NULL)
 	{
-		doc = documents[i];
-
-		if (! doc->is_valid || doc->file_name == NULL)
-			continue;
-
-		if (utils_filenamecmp(utf8_filename, doc->file_name) == 0)
-		{
+		doc = g_hash_table_lookup(file_name_index, utf8_filename);
+		if (doc != NULL)
 			return doc;
-		}
 	}
 	/* Now try matching based on the realpath(), which is unique per file on disk */
 	realname = get_real_path_from_utf8(utf8_filename);
@@ -368,9 +429,135 @@ GeanyDocument *document_get_current(void)
 }
 
 
+/* Rough estimate of the memory tied to a document's buffer: Scintilla keeps one
+ * text byte and one style byte per character plus a few words of per-line
+ * bookkeeping (line starts, markers, levels). Undo history and line layout
+ * caches cannot be queried from outside Scintilla and are not counted. */
+static gsize document_memory_estimate(GeanyDocument *doc)
+{
+	gsize bytes;
+
+	bytes = (gsize) sci_get_length(doc->editor->sci) * 2;
+	bytes += (gsize) sci_get_line_count(doc->editor->sci) * 3 * sizeof(gint);
+	return bytes;
+}
+
+
+/* Builds a per-document memory breakdown as one newline separated string;
+ * the caller frees the result. Served over the single instance socket as part
+ * of the stats reply. */
+gchar *document_memory_report(void)
+{
+	GString *out = g_string_new(NULL);
+	guint i;
+
+	foreach_document(i)
+	{
+		GeanyDocument *doc = documents[i];
+
+		g_string_append_printf(out, "document %d: %lu KB buffer+styles, %d lines%s - %s\n",
+			doc->index,
+			(gulong) (document_memory_estimate(doc) / 1024),
+			sci_get_line_count(doc->editor->sci),
+			doc->changed ? ", modified" : "",
+			DOC_FILENAME(doc));
+	}
+	return g_string_free(out, FALSE);
+}
+
+
+/* Frees what can be rebuilt on demand for a document which is not currently
+ * shown: cached line layouts (recreated on the next paint) and, for documents
+ * without unsaved changes, the undo history. Style bytes live inline in the
+ * cell buffer and would not be returned to the allocator, so they are kept. */
+static void document_evict_caches(GeanyDocument *doc)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	sptr_t cache_mode = scintilla_send_message(sci, SCI_GETLAYOUTCACHE, 0, 0);
+
+	/* changing the layout cache mode deallocates all cached layouts */
+	scintilla_send_message(sci, SCI_SETLAYOUTCACHE, SC_CACHE_NONE, 0);
+	scintilla_send_message(sci, SCI_SETLAYOUTCACHE, (uptr_t) cache_mode, 0);
+
+	if (! doc->changed && ! sci_is_modified(sci))
+		sci_empty_undo_buffer(sci);
+}
+
+
+#ifdef __linux__
+
+#define MEMORY_CHECK_INTERVAL 60 /* seconds */
+
+static guint memory_check_source = 0;
+/* whether we already shed caches since resident memory last crossed the cap;
+ * freed pages are not necessarily returned to the kernel immediately, so
+ * evicting again on every check would be pointless churn */
+static gboolean memory_evicted = FALSE;
+
+
+/* resident set size in bytes, read from /proc/self/statm */
+static gsize get_resident_memory(void)
+{
+	gchar *contents = NULL;
+	gsize rss = 0;
+
+	if (g_file_get_contents("/proc/self/statm", &contents, NULL, NULL))
+	{
+		gulong size_pages, rss_pages;
+
+		if (sscanf(contents, "%lu %lu", &size_pages, &rss_pages) == 2)
+			rss = (gsize) rss_pages * (gsize) sysconf(_SC_PAGESIZE);
+		g_free(contents);
+	}
+	return rss;
+}
+
+
+static gboolean on_memory_check_timeout(gpointer data)
+{
+	GeanyDocument *current;
+	gsize cap, rss;
+	guint i, evicted = 0;
+
+	if (file_prefs.max_memory_usage <= 0)
+		return TRUE;
+
+	cap = (gsize) file_prefs.max_memory_usage * 1024 * 1024;
+	rss = get_resident_memory();
+	if (rss == 0 || rss <= cap)
+	{
+		memory_evicted = FALSE;
+		return TRUE;
+	}
+	if (memory_evicted)
+		return TRUE;
+
+	current = document_get_current();
+	foreach_document(i)
+	{
+		if (documents[i] == current)
+			continue;
+		document_evict_caches(documents[i]);
+		evicted++;
+	}
+	memory_evicted = TRUE;
+	geany_debug("Resident memory %lu MB is above the configured cap of %d MB, "
+		"dropped caches of %u background documents",
+		(gulong) (rss / (1024 * 1024)), file_prefs.max_memory_usage, evicted);
+	stats_count("document.memory-evictions", 1);
+	return TRUE;
+}
+
+#endif /* __linux__ */
+
+
 void document_init_doclist(void)
 {
 	documents_array = g_ptr_array_new();
+#ifdef __linux__
+	memory_check_source = g_timeout_add_seconds(MEMORY_CHECK_INTERVAL,
+		on_memory_check_timeout, NULL);
+#endif
 }
 
 
@@ -378,6 +565,13 @@ void document_finalize(void)
 {
 	guint i;
 
+#ifdef __linux__
+	if (memory_check_source != 0)
+	{
+		g_source_remove(memory_check_source);
+		memory_check_source = 0;
+	}
+#endif
 	for (i = 0; i < documents_array->len; i++)
 		g_free(documents[i]);
 	g_ptr_array_free(documents_array, TRUE);
@@ -490,7 +684,6 @@ static void queue_colourise(GeanyDocument *doc)
 }
 
 
-#ifdef USE_GIO_FILEMON
 static void monitor_file_changed_cb(G_GNUC_UNUSED GFileMonitor *monitor, G_GNUC_UNUSED GFile *file,
 									G_GNUC_UNUSED GFile *other_file, GFileMonitorEvent event,
 									GeanyDocument *doc)
@@ -509,14 +702,29 @@ static void monitor_file_changed_cb(G_GNUC_UNUSED GFileMonitor *monitor, G_GNUC_
 			if (doc->priv->file_disk_status == FILE_IGNORE)
 				doc->priv->file_disk_status = FILE_OK;
 			else
+			{
 				doc->priv->file_disk_status = FILE_CHANGED;
-			g_message("%s: FILE_CHANGED", G_STRFUNC);
+				/* a version control update touches many files at once; wait for the
+				 * burst of events to settle and reload the pristine documents in one
+				 * go instead of prompting for each of them on tab switch */
+				if (! doc->changed && ! document_can_undo(doc) && ! document_can_redo(doc))
+				{
+					if (bulk_reload_source != 0)
+						g_source_remove(bulk_reload_source);
+					bulk_reload_source = g_timeout_add(500, bulk_reload_timeout, NULL);
+				}
+			}
+			geany_debug("%s: FILE_CHANGED", G_STRFUNC);
 			break;
 		}
 		case G_FILE_MONITOR_EVENT_DELETED:
 		{
+			gchar *locale_filename = utils_get_locale_from_utf8(doc->file_name);
+
 			doc->priv->file_disk_status = FILE_CHANGED;
-			g_message("%s: FILE_MISSING", G_STRFUNC);
+			project_update_file_manifest(locale_filename);
+			g_free(locale_filename);
+			geany_debug("%s: FILE_MISSING", G_STRFUNC);
 			break;
 		}
 		default:
@@ -527,7 +735,6 @@ static void monitor_file_changed_cb(G_GNUC_UNUSED GFileMonitor *monitor, G_GNUC_
 		ui_update_tab_status(doc);
 	}
 }
-#endif
 
 
 static void document_stop_file_monitoring(GeanyDocument *doc)
@@ -549,7 +756,6 @@ static void monitor_file_setup(GeanyDocument *doc)
 	 * doesn't work at all for remote files and legacy polling is too slow. */
 	if (! doc->priv->is_remote)
 	{
-#ifdef USE_GIO_FILEMON
 		gchar *locale_filename;
 
 		/* stop any previous monitoring */
@@ -561,16 +767,27 @@ static void monitor_file_setup(GeanyDocument *doc)
 			/* get a file monitor and connect to the 'changed' signal */
 			GFile *file = g_file_new_for_path(locale_filename);
 			doc->priv->monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, NULL, NULL);
-			g_signal_connect(doc->priv->monitor, "changed",
-				G_CALLBACK(monitor_file_changed_cb), doc);
 
-			/* we set the rate limit according to the GUI pref but it's most probably not used */
-			g_file_monitor_set_rate_limit(doc->priv->monitor, file_prefs.disk_check_timeout * 1000);
+			/* on filesystems without change notification (e.g. NFS) GIO hands
+			 * back a poll based monitor; drop it and stay with the legacy
+			 * stat-on-demand checks instead of polling every file ourselves */
+			if (doc->priv->monitor != NULL &&
+				strstr(g_type_name(G_TYPE_FROM_INSTANCE(doc->priv->monitor)), "Poll") != NULL)
+			{
+				document_stop_file_monitoring(doc);
+			}
+			else if (doc->priv->monitor != NULL)
+			{
+				g_signal_connect(doc->priv->monitor, "changed",
+					G_CALLBACK(monitor_file_changed_cb), doc);
+
+				/* we set the rate limit according to the GUI pref but it's most probably not used */
+				g_file_monitor_set_rate_limit(doc->priv->monitor, file_prefs.disk_check_timeout * 1000);
+			}
 
 			g_object_unref(file);
 		}
 		g_free(locale_filename);
-#endif
 	}
 	doc->priv->file_disk_status = FILE_OK;
 }
@@ -635,9 +852,7 @@ static GeanyDocument *document_create(const gchar *utf8_filename)
 	doc->index = new_idx;
 	doc->file_name = g_strdup(utf8_filename);
 	doc->editor = editor_create(doc);
-#ifndef USE_GIO_FILEMON
 	doc->priv->last_check = time(NULL);
-#endif
 
 	sidebar_openfiles_add(doc);	/* sets doc->iter */
 
@@ -654,6 +869,7 @@ static GeanyDocument *document_create(const gchar *utf8_filename)
 	ui_document_buttons_update();
 
 	doc->is_valid = TRUE;	/* do this last to prevent UI updating with NULL items. */
+	document_index_update();
 	return doc;
 }
 
@@ -677,6 +893,37 @@ gboolean document_close(GeanyDocument *doc)
 
 /* Call document_remove_page() instead, this is only needed for document_create()
  * to prevent re-opening a new document when the last document is closed (if enabled). */
+/* During Close All the TMSourceFiles of the closed documents are collected
+ * here and removed from the workspace in one batch, so the workspace tag
+ * array is re-sorted once instead of once per file. */
+static GPtrArray *closing_tm_files = NULL;
+
+/* Notebook page widgets parked for deferred destruction: finalizing a
+ * ScintillaObject (buffer, styles, line data) is the expensive part of
+ * closing a tab, so Close All detaches the pages immediately and destroys
+ * them one per idle callback. */
+static GQueue deferred_page_widgets = G_QUEUE_INIT;
+static guint deferred_page_source = 0;
+
+
+static gboolean deferred_page_destroy_idle(gpointer data)
+{
+	GtkWidget *widget = g_queue_pop_head(&deferred_page_widgets);
+
+	if (widget != NULL)
+	{
+		gtk_widget_destroy(widget);
+		g_object_unref(widget);
+	}
+	if (g_queue_is_empty(&deferred_page_widgets))
+	{
+		deferred_page_source = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
 static gboolean remove_page(guint page_num)
 {
 	GeanyDocument *doc = document_get_from_page(page_num);
@@ -686,6 +933,10 @@ static gboolean remove_page(guint page_num)
 	if (doc->changed && ! dialogs_show_unsaved_file(doc))
 		return FALSE;
 
+	/* persist the undo history while the buffer still matches the saved file */
+	if (! doc->changed)
+		document_save_undo_history(doc);
+
 	/* tell any plugins that the document is about to be closed */
 	g_signal_emit_by_name(geany_object, "document-close", doc);
 
@@ -693,8 +944,37 @@ static gboolean remove_page(guint page_num)
 	if (! main_status.closing_all && doc->real_path != NULL)
 		ui_add_recent_document(doc);
 
+	/* record the close in the session journal rather than rewriting the session */
+	configuration_journal_document_close(doc);
+
 	doc->is_valid = FALSE;
 	doc->id = 0;
+	document_index_update();
+
+	document_cancel_background_load(doc);
+
+	if (doc->priv->clone_partner != NULL)
+	{	/* the partner keeps the shared buffer for itself, no copy needed */
+		GeanyDocument *partner = doc->priv->clone_partner;
+
+		partner->priv->clone_partner = NULL;
+		if (partner->priv->clone_split_source != 0)
+		{
+			g_source_remove(partner->priv->clone_split_source);
+			partner->priv->clone_split_source = 0;
+		}
+		g_free(partner->priv->clone_split_snapshot);
+		partner->priv->clone_split_snapshot = NULL;
+		sci_set_readonly(partner->editor->sci, partner->readonly);
+		doc->priv->clone_partner = NULL;
+	}
+	if (doc->priv->clone_split_source != 0)
+	{
+		g_source_remove(doc->priv->clone_split_source);
+		doc->priv->clone_split_source = 0;
+	}
+	g_free(doc->priv->clone_split_snapshot);
+	doc->priv->clone_split_snapshot = NULL;
 
 	if (main_status.quitting)
 	{
@@ -705,6 +985,20 @@ static gboolean remove_page(guint page_num)
 	}
 	else
 	{
+		if (main_status.closing_all)
+		{
+			GtkWidget *page = gtk_notebook_get_nth_page(
+				GTK_NOTEBOOK(main_widgets.notebook), page_num);
+
+			/* our handlers pass doc->editor, which is freed below; the parked
+			 * widget must not call back into it */
+			g_signal_handlers_disconnect_matched(doc->editor->sci,
+				G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, doc->editor);
+			g_object_ref(page);
+			g_queue_push_tail(&deferred_page_widgets, page);
+			if (deferred_page_source == 0)
+				deferred_page_source = g_idle_add(deferred_page_destroy_idle, NULL);
+		}
 		notebook_remove_page(page_num);
 		sidebar_remove_document(doc);
 		navqueue_remove_file(doc->file_name);
@@ -716,13 +1010,32 @@ static gboolean remove_page(guint page_num)
 	g_free(doc->real_path);
 	if (doc->tm_file)
 	{
-		tm_workspace_remove_source_file(doc->tm_file);
-		tm_source_file_free(doc->tm_file);
+		if (closing_tm_files != NULL)
+			g_ptr_array_add(closing_tm_files, doc->tm_file);
+		else
+		{
+			tm_workspace_remove_source_file(doc->tm_file);
+			tm_source_file_free(doc->tm_file);
+		}
 	}
 
 	if (doc->priv->tag_tree)
 		gtk_widget_destroy(doc->priv->tag_tree);
 
+	if (doc->priv->displayed_tags)
+		tm_tags_array_free(doc->priv->displayed_tags, TRUE);
+	if (doc->priv->sort_rank_name)
+		g_hash_table_destroy(doc->priv->sort_rank_name);
+	if (doc->priv->sort_rank_appearance)
+		g_hash_table_destroy(doc->priv->sort_rank_appearance);
+
+	g_free(doc->priv->mark_all_text);
+
+	if (doc->priv->word_index_source != 0)
+		g_source_remove(doc->priv->word_index_source);
+	if (doc->priv->word_index)
+		g_hash_table_destroy(doc->priv->word_index);
+
 	editor_destroy(doc->editor);
 	doc->editor = NULL; /* needs to be NULL for document_undo_clear() call below */
 
@@ -848,11 +1161,8 @@ GeanyDocument *document_new_file(const gchar *utf8_filename, GeanyFiletype *ft,
 	editor_goto_pos(doc->editor, 0, FALSE);
 	document_try_focus(doc, NULL);
 
-#ifdef USE_GIO_FILEMON
-	monitor_file_setup(doc);
-#else
 	doc->priv->mtime = time(NULL);
-#endif
+	monitor_file_setup(doc);
 
 	/* "the" SCI signal (connect after initial setup(i.e. adding text)) */
 	g_signal_connect(doc->editor->sci, "sci-notify", G_CALLBACK(editor_sci_notify_cb), doc->editor);
@@ -892,8 +1202,63 @@ typedef struct
 	gboolean	 bom;
 	time_t		 mtime;	/* modification time, read by stat::st_mtime */
 	gboolean	 readonly;
+	goffset		 disk_size;		/* on-disk file size */
+	goffset		 async_offset;	/* raw offset the background loader continues from,
+								 * or 0 when the whole file was loaded here */
 } FileData;
 
+/* load files bigger than this in the background, appending the remainder to the buffer in
+ * chunks so the first screen is usable almost immediately */
+#define ASYNC_LOAD_THRESHOLD	(8u * 1024 * 1024)
+#define ASYNC_LOAD_CHUNK_SIZE	(1024u * 1024)
+
+
+/* Reads only an initial chunk of a large file so the rest can be loaded in the background
+ * (see document_start_background_load()). The chunk is cut at a newline to keep the encoding
+ * detection away from a possibly split multibyte character; UTF-16/32 files (recognized by
+ * their BOM) don't allow this and are loaded in one go as usual.
+ * Returns FALSE without setting an error when the normal loading code should be used. */
+static gboolean load_file_head(const gchar *locale_filename, FileData *filedata)
+{
+	FILE *fp;
+	gchar *buf;
+	gsize read_len;
+	gsize cut;
+	GeanyEncodingIndex bom_idx;
+
+	fp = g_fopen(locale_filename, "rb");
+	if (fp == NULL)
+		return FALSE;
+
+	buf = g_malloc(ASYNC_LOAD_CHUNK_SIZE + 1);
+	read_len = fread(buf, 1, ASYNC_LOAD_CHUNK_SIZE, fp);
+	fclose(fp);
+	if (read_len < ASYNC_LOAD_CHUNK_SIZE)
+	{	/* the file shrank below the threshold or could not be read completely */
+		g_free(buf);
+		return FALSE;
+	}
+	bom_idx = encodings_scan_unicode_bom(buf, read_len, NULL);
+	if (bom_idx != GEANY_ENCODING_NONE && bom_idx != GEANY_ENCODING_UTF_8)
+	{	/* multibyte encoding where cutting at a newline byte isn't safe */
+		g_free(buf);
+		return FALSE;
+	}
+	cut = read_len;
+	while (cut > 0 && buf[cut - 1] != '\n')
+		cut--;
+	if (cut == 0)
+	{	/* a single huge line, splitting won't help */
+		g_free(buf);
+		return FALSE;
+	}
+	buf[cut] = '\0';
+	filedata->data = buf;
+	filedata->len = cut;
+	filedata->async_offset = (goffset) cut;
+	return TRUE;
+}
+
 
 /* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM. */
 static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
@@ -907,6 +1272,7 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	filedata->enc = NULL;
 	filedata->bom = FALSE;
 	filedata->readonly = FALSE;
+	filedata->async_offset = 0;
 
 	if (g_stat(locale_filename, &st) != 0)
 	{
@@ -916,18 +1282,34 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	}
 
 	filedata->mtime = st.st_mtime;
+	filedata->disk_size = (goffset) st.st_size;
 
-	if (! g_file_get_contents(locale_filename, &filedata->data, NULL, &err))
+	if (forced_enc == NULL && filedata->disk_size >= (goffset) ASYNC_LOAD_THRESHOLD)
+		load_file_head(locale_filename, filedata);
+
+retry_full:
+	if (filedata->data == NULL)
 	{
-		ui_set_statusbar(TRUE, "%s", err->message);
-		g_error_free(err);
-		return FALSE;
+		if (! g_file_get_contents(locale_filename, &filedata->data, NULL, &err))
+		{
+			ui_set_statusbar(TRUE, "%s", err->message);
+			g_error_free(err);
+			return FALSE;
+		}
+		filedata->len = (gsize) st.st_size;
 	}
 
-	filedata->len = (gsize) st.st_size;
 	if (! encodings_convert_to_utf8_auto(&filedata->data, &filedata->len, forced_enc,
 				&filedata->enc, &filedata->bom, &filedata->readonly))
 	{
+		g_free(filedata->data);
+		filedata->data = NULL;
+		if (filedata->async_offset > 0)
+		{	/* the encoding could not be detected from the initial chunk alone,
+			 * retry with the whole file */
+			filedata->async_offset = 0;
+			goto retry_full;
+		}
 		if (forced_enc)
 		{
 			ui_set_statusbar(TRUE, _("The file \"%s\" is not valid %s."),
@@ -939,10 +1321,14 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	_("The file \"%s\" does not look like a text file or the file encoding is not supported."),
 			display_filename);
 		}
-		g_free(filedata->data);
 		return FALSE;
 	}
 
+	/* a NULL byte already in the initial chunk truncates the file there anyway,
+	 * so loading the remainder makes no sense */
+	if (filedata->readonly)
+		filedata->async_offset = 0;
+
 	if (filedata->readonly)
 	{
 		const gchar *warn_msg = _(
@@ -960,85 +1346,491 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 }
 
 
-/* Sets the cursor position on opening a file. First it sets the line when cl_options.goto_line
- * is set, otherwise it sets the line when pos is greater than zero and finally it sets the column
- * if cl_options.goto_column is set.
- *
- * returns the new position which may have changed */
-static gint set_cursor_position(GeanyEditor *editor, gint pos)
+/* State of a background load of a large file. Owned by the worker thread and freed on the
+ * main thread by the final idle callback; document.c only keeps a borrowed pointer in
+ * doc->priv->file_load for cancellation. */
+typedef struct
 {
-	if (cl_options.goto_line >= 0)
-	{	/* goto line which was specified on command line and then undefine the line */
-		sci_goto_line(editor->sci, cl_options.goto_line - 1, TRUE);
-		editor->scroll_percent = 0.5F;
-		cl_options.goto_line = -1;
-	}
-	else if (pos > 0)
-	{
-		sci_set_current_position(editor->sci, pos, FALSE);
-		editor->scroll_percent = 0.5F;
-	}
+	GeanyDocument	*doc;				/* checked with DOC_VALID() before use */
+	gchar			*locale_filename;
+	gchar			*display_filename;
+	gchar			*enc;				/* encoding to convert from */
+	goffset			 offset;			/* raw offset to continue reading from */
+	GMappedFile		*map;				/* mapping of the file, or NULL when it could
+										 * not be mapped (remote filesystems) */
+	volatile gint	 cancelled;
+} FileLoad;
 
-	if (cl_options.goto_column >= 0)
-	{	/* goto column which was specified on command line and then undefine the column */
+typedef struct
+{
+	FileLoad	*load;
+	gchar		*text;		/* UTF-8 text to append, or NULL for the final notification */
+	gsize		 len;
+	gboolean	 borrowed;	/* text points into load->map and must not be freed */
+	gboolean	 finished;
+	gboolean	 truncated;	/* loading stopped early (NULL byte or invalid input) */
+} FileLoadChunk;
 
-		gint new_pos = sci_get_current_position(editor->sci) + cl_options.goto_column;
-		sci_set_current_position(editor->sci, new_pos, FALSE);
-		editor->scroll_percent = 0.5F;
-		cl_options.goto_column = -1;
-		return new_pos;
-	}
-	return sci_get_current_position(editor->sci);
+
+static void file_load_free(FileLoad *load)
+{
+	if (load->map != NULL)
+		g_mapped_file_free(load->map);
+	g_free(load->locale_filename);
+	g_free(load->display_filename);
+	g_free(load->enc);
+	g_free(load);
 }
 
 
-/* Count lines that start with some hard tabs then a soft tab. */
-static gboolean detect_tabs_and_spaces(GeanyEditor *editor)
+/* all remaining chunks arrived, restore the state normally set up by document_open_file_full() */
+static void file_load_finished(GeanyDocument *doc, FileLoad *load, gboolean truncated)
 {
-	const GeanyIndentPrefs *iprefs = editor_get_indent_prefs(editor);
-	ScintillaObject *sci = editor->sci;
-	gsize count = 0;
-	struct Sci_TextToFind ttf;
-	gchar *soft_tab = g_strnfill((gsize)iprefs->width, ' ');
-	gchar *regex = g_strconcat("^\t+", soft_tab, "[^ ]", NULL);
+	doc->priv->file_load = NULL;
 
-	g_free(soft_tab);
+	doc->priv->line_count = sci_get_line_count(doc->editor->sci);
+	sci_set_line_numbers(doc->editor->sci, editor_prefs.show_linenumber_margin);
+	queue_colourise(doc);
+	document_update_tags(doc);
 
-	ttf.chrg.cpMin = 0;
-	ttf.chrg.cpMax = sci_get_length(sci);
-	ttf.lpstrText = regex;
-	while (1)
+	if (truncated)
 	{
-		gint pos;
+		const gchar *warn_msg = _(
+			"The file \"%s\" could not be opened properly and has been truncated. " \
+			"This can occur if the file contains a NULL byte. " \
+			"Be aware that saving it can cause data loss.\nThe file was set to read-only.");
 
-		pos = sci_find_text(sci, SCFIND_REGEXP, &ttf);
-		if (pos == -1)
-			break;	/* no more matches */
-		count++;
-		ttf.chrg.cpMin = ttf.chrgText.cpMax + 1;	/* search after this match */
+		doc->readonly = TRUE;
+		sci_set_readonly(doc->editor->sci, TRUE);
+		if (main_status.main_window_realized)
+			dialogs_show_msgbox(GTK_MESSAGE_WARNING, warn_msg, load->display_filename);
+		ui_set_statusbar(TRUE, warn_msg, load->display_filename);
 	}
-	g_free(regex);
-	/* The 0.02 is a low weighting to ignore a few possibly accidental occurrences */
-	return count > sci_get_line_count(sci) * 0.02;
+	else
+		ui_set_statusbar(FALSE, _("File %s fully loaded."), load->display_filename);
 }
 
 
-/* Detect the indent type based on counting the leading indent characters for each line.
- * Returns whether detection succeeded, and the detected type in *type_ upon success */
-gboolean document_detect_indent_type(GeanyDocument *doc, GeanyIndentType *type_)
+/* main thread: append a converted chunk to the Scintilla buffer */
+static gboolean file_load_append_idle(gpointer data)
 {
-	GeanyEditor *editor = doc->editor;
-	ScintillaObject *sci = editor->sci;
-	gint line, line_count;
-	gsize tabs = 0, spaces = 0;
+	FileLoadChunk *chunk = data;
+	FileLoad *load = chunk->load;
+	GeanyDocument *doc = load->doc;
+	gboolean alive = ! g_atomic_int_get(&load->cancelled) &&
+		DOC_VALID(doc) && doc->priv->file_load == load;
 
-	if (detect_tabs_and_spaces(editor))
+	if (alive && chunk->text != NULL && chunk->len > 0)
 	{
-		*type_ = GEANY_INDENT_TYPE_BOTH;
-		return TRUE;
+		ScintillaObject *sci = doc->editor->sci;
+		gboolean was_changed = doc->changed;
+
+		if (doc->readonly)
+			sci_set_readonly(sci, FALSE);
+		sci_set_undo_collection(sci, FALSE);
+		sci_append_text(sci, chunk->text, chunk->len);
+		sci_set_undo_collection(sci, TRUE);
+		if (doc->readonly)
+			sci_set_readonly(sci, TRUE);
+		/* the append must not mark the document as changed, but keep changes the user
+		 * made while loading */
+		if (! was_changed)
+			document_set_text_changed(doc, FALSE);
 	}
-
-	line_count = sci_get_line_count(sci);
+	if (chunk->finished)
+	{
+		if (alive)
+			file_load_finished(doc, load, chunk->truncated);
+		file_load_free(load);
+	}
+	if (! chunk->borrowed)
+		g_free(chunk->text);
+	g_free(chunk);
+	return FALSE;
+}
+
+
+/* the idle callbacks run in submission order, so borrowed chunks are consumed before
+ * the finishing chunk unmaps the file in file_load_free() */
+static void file_load_deliver(FileLoad *load, gchar *text, gsize len,
+	gboolean borrowed, gboolean finished, gboolean truncated)
+{
+	FileLoadChunk *chunk = g_new0(FileLoadChunk, 1);
+
+	chunk->load = load;
+	chunk->text = text;
+	chunk->len = len;
+	chunk->borrowed = borrowed;
+	chunk->finished = finished;
+	chunk->truncated = truncated;
+	g_idle_add(file_load_append_idle, chunk);
+}
+
+
+/* worker thread: convert the raw bytes at *in to UTF-8 with converter. Consumed input
+ * is advanced past; an incomplete character at the end of the input is left behind for
+ * the next chunk when more input follows (g_iconv() reports it as EINVAL), otherwise
+ * it truncates the file. Returns a malloc'd buffer, or NULL when nothing converted. */
+static gchar *file_load_convert(GIConv converter, const gchar **in, gsize *inleft,
+	gboolean more, gsize *out_len, gboolean *truncated)
+{
+	gsize outalloc = *inleft * 2 + 8;
+	gchar *out = g_malloc(outalloc);
+	gchar *outp = out;
+	gsize outleft = outalloc - 1;
+	gchar *inbuf = (gchar *) *in;
+
+	while (*inleft > 0)
+	{
+		if (g_iconv(converter, &inbuf, inleft, &outp, &outleft) != (gsize) -1)
+			continue;
+		if (errno == E2BIG)
+		{
+			gsize used = (gsize) (outp - out);
+
+			outalloc *= 2;
+			out = g_realloc(out, outalloc);
+			outp = out + used;
+			outleft = outalloc - used - 1;
+		}
+		else if (errno == EINVAL && more && *inleft < 64)
+		{	/* character split at the chunk boundary, retry with the next chunk */
+			break;
+		}
+		else
+		{	/* invalid input, stop like the synchronous loader does */
+			*truncated = TRUE;
+			break;
+		}
+	}
+	*in = inbuf;
+	*out_len = (gsize) (outp - out);
+	*outp = '\0';
+	if (*out_len == 0)
+	{
+		g_free(out);
+		out = NULL;
+	}
+	return out;
+}
+
+
+/* worker thread: read the rest of the file in chunks, convert each to UTF-8 and hand it
+ * over to the main thread. When the file can be mapped, chunks that need no conversion
+ * are delivered as borrowed pointers into the mapping, so the only copy made of the
+ * data is the one inside the Scintilla buffer; reading through a FILE is kept as the
+ * fallback for files that cannot be mapped. */
+static gpointer file_load_thread(gpointer data)
+{
+	FileLoad *load = data;
+	FILE *fp = NULL;
+	GIConv converter = (GIConv) -1;
+	gboolean truncated = FALSE;
+	gboolean utf8 = utils_str_equal(load->enc, "UTF-8");
+	gboolean convert = ! utils_str_equal(load->enc,
+		encodings[GEANY_ENCODING_NONE].charset);
+
+	if (convert)
+	{
+		converter = g_iconv_open("UTF-8", load->enc);
+		if (converter == (GIConv) -1)
+			convert = FALSE;	/* shouldn't happen, the initial chunk converted fine */
+	}
+
+	load->map = g_mapped_file_new(load->locale_filename, FALSE, NULL);
+	if (load->map != NULL)
+	{
+		const gchar *mapped = g_mapped_file_get_contents(load->map);
+		gsize mapped_len = g_mapped_file_get_length(load->map);
+		goffset offset = load->offset;
+
+		if ((goffset) mapped_len < offset)
+			truncated = TRUE;	/* the file shrank below the initial chunk */
+
+		while (! truncated && (gsize) offset < mapped_len &&
+			! g_atomic_int_get(&load->cancelled))
+		{
+			const gchar *in = mapped + offset;
+			gsize avail = mapped_len - (gsize) offset;
+			gboolean more = avail > ASYNC_LOAD_CHUNK_SIZE;
+
+			if (more)
+				avail = ASYNC_LOAD_CHUNK_SIZE;
+
+			if (convert && ! utf8)
+			{
+				gsize out_len;
+				gchar *out = file_load_convert(converter, &in, &avail, more,
+					&out_len, &truncated);
+
+				if (out != NULL)
+				{
+					/* embedded NULL bytes truncate the file, matching load_text_file() */
+					gchar *nul = memchr(out, '\0', out_len);
+
+					if (nul != NULL)
+					{
+						out_len = (gsize) (nul - out);
+						truncated = TRUE;
+					}
+					if (out_len > 0)
+						file_load_deliver(load, out, out_len, FALSE, FALSE, FALSE);
+					else
+						g_free(out);
+					offset = (goffset) (in - mapped);
+				}
+				else if (! truncated)
+				{	/* incomplete character at the end of the file */
+					truncated = TRUE;
+				}
+			}
+			else
+			{	/* UTF-8 or pass-through: deliver the bytes straight from the mapping */
+				const gchar *nul = memchr(in, '\0', avail);
+				gsize good = avail;
+
+				if (nul != NULL)
+				{
+					good = (gsize) (nul - in);
+					truncated = TRUE;
+				}
+				if (utf8 && good > 0)
+				{
+					const gchar *valid_end;
+
+					if (! utils_utf8_validate(in, (gssize) good, &valid_end))
+					{
+						gsize tail = good - (gsize) (valid_end - in);
+
+						good = (gsize) (valid_end - in);
+						/* a short invalid tail with more data following is a character
+						 * split at the chunk boundary, anything else is invalid input */
+						if (truncated || ! more || tail >= 6)
+							truncated = TRUE;
+					}
+				}
+				if (good > 0)
+					file_load_deliver(load, (gchar *) in, good, TRUE, FALSE, FALSE);
+				else if (! truncated)
+					truncated = TRUE;	/* incomplete character at the end of the file */
+				offset += (goffset) good;
+			}
+		}
+	}
+	else
+	{
+		fp = g_fopen(load->locale_filename, "rb");
+		if (fp == NULL || fseek(fp, (long) load->offset, SEEK_SET) != 0)
+		{
+			if (fp != NULL)
+				fclose(fp);
+			if (converter != (GIConv) -1)
+				g_iconv_close(converter);
+			file_load_deliver(load, NULL, 0, FALSE, TRUE, TRUE);
+			return NULL;
+		}
+	}
+
+	if (fp != NULL)
+	{
+		gchar *raw = g_malloc(ASYNC_LOAD_CHUNK_SIZE + 64);
+		gsize carry = 0;	/* undecoded bytes kept at the start of raw */
+
+		while (! g_atomic_int_get(&load->cancelled))
+		{
+			gsize got = fread(raw + carry, 1, ASYNC_LOAD_CHUNK_SIZE, fp);
+			gsize avail = carry + got;
+			gchar *out;
+			gsize out_len = 0;
+			gchar *nul;
+
+			if (avail == 0)
+				break;
+			if (got == 0 && carry > 0)
+			{	/* incomplete character at the end of the file */
+				truncated = TRUE;
+				break;
+			}
+			carry = 0;
+
+			if (convert)
+			{
+				const gchar *in = raw;
+				gsize inleft = avail;
+
+				out = file_load_convert(converter, &in, &inleft, got > 0,
+					&out_len, &truncated);
+				if (inleft > 0 && ! truncated)
+				{	/* keep the split character for the next chunk */
+					carry = inleft;
+					g_memmove(raw, in, carry);
+				}
+				if (out == NULL)
+				{
+					if (truncated || got == 0)
+						break;
+					continue;
+				}
+			}
+			else
+			{	/* no conversion needed, pass the data through */
+				out = g_malloc(avail + 1);
+				memcpy(out, raw, avail);
+				out[avail] = '\0';
+				out_len = avail;
+			}
+
+			/* embedded NULL bytes truncate the file, matching load_text_file() */
+			nul = memchr(out, '\0', out_len);
+			if (nul != NULL)
+			{
+				out_len = (gsize) (nul - out);
+				truncated = TRUE;
+			}
+
+			if (out_len > 0)
+				file_load_deliver(load, out, out_len, FALSE, FALSE, FALSE);
+			else
+				g_free(out);
+
+			if (truncated || got == 0)
+				break;
+		}
+		fclose(fp);
+		g_free(raw);
+	}
+	if (converter != (GIConv) -1)
+		g_iconv_close(converter);
+
+	file_load_deliver(load, NULL, 0, FALSE, TRUE, truncated);
+	return NULL;
+}
+
+
+/* continues loading the part of the file load_file_head() didn't read, appending it to the
+ * Scintilla buffer in the background */
+static void document_start_background_load(GeanyDocument *doc, const gchar *locale_filename,
+	const gchar *display_filename, const FileData *filedata)
+{
+	FileLoad *load = g_new0(FileLoad, 1);
+	GError *error = NULL;
+
+	load->doc = doc;
+	load->locale_filename = g_strdup(locale_filename);
+	load->display_filename = g_strdup(display_filename);
+	load->enc = g_strdup(filedata->enc);
+	load->offset = filedata->async_offset;
+	doc->priv->file_load = load;
+
+	if (g_thread_create(file_load_thread, load, FALSE, &error) == NULL)
+	{
+		geany_debug("%s: %s", G_STRFUNC, error->message);
+		g_error_free(error);
+		doc->priv->file_load = NULL;
+		file_load_free(load);
+		/* leave the partially loaded buffer read-only so it cannot be saved truncated */
+		doc->readonly = TRUE;
+		sci_set_readonly(doc->editor->sci, TRUE);
+	}
+}
+
+
+/* stops appending further chunks; the loader frees itself when its final idle callback runs */
+static void document_cancel_background_load(GeanyDocument *doc)
+{
+	FileLoad *load = doc->priv->file_load;
+
+	if (load != NULL)
+	{
+		g_atomic_int_set(&load->cancelled, TRUE);
+		doc->priv->file_load = NULL;
+	}
+}
+
+
+/* Sets the cursor position on opening a file. First it sets the line when cl_options.goto_line
+ * is set, otherwise it sets the line when pos is greater than zero and finally it sets the column
+ * if cl_options.goto_column is set.
+ *
+ * returns the new position which may have changed */
+static gint set_cursor_position(GeanyEditor *editor, gint pos)
+{
+	if (cl_options.goto_line >= 0)
+	{	/* goto line which was specified on command line and then undefine the line */
+		sci_goto_line(editor->sci, cl_options.goto_line - 1, TRUE);
+		editor->scroll_percent = 0.5F;
+		cl_options.goto_line = -1;
+	}
+	else if (pos > 0)
+	{
+		sci_set_current_position(editor->sci, pos, FALSE);
+		editor->scroll_percent = 0.5F;
+	}
+
+	if (cl_options.goto_column >= 0)
+	{	/* goto column which was specified on command line and then undefine the column */
+
+		gint new_pos = sci_get_current_position(editor->sci) + cl_options.goto_column;
+		sci_set_current_position(editor->sci, new_pos, FALSE);
+		editor->scroll_percent = 0.5F;
+		cl_options.goto_column = -1;
+		return new_pos;
+	}
+	return sci_get_current_position(editor->sci);
+}
+
+
+/* Count lines that start with some hard tabs then a soft tab. */
+static gboolean detect_tabs_and_spaces(GeanyEditor *editor)
+{
+	const GeanyIndentPrefs *iprefs = editor_get_indent_prefs(editor);
+	ScintillaObject *sci = editor->sci;
+	gsize count = 0;
+	struct Sci_TextToFind ttf;
+	gchar *soft_tab = g_strnfill((gsize)iprefs->width, ' ');
+	gchar *regex = g_strconcat("^\t+", soft_tab, "[^ ]", NULL);
+
+	g_free(soft_tab);
+
+	ttf.chrg.cpMin = 0;
+	ttf.chrg.cpMax = sci_get_length(sci);
+	ttf.lpstrText = regex;
+	while (1)
+	{
+		gint pos;
+
+		pos = sci_find_text(sci, SCFIND_REGEXP, &ttf);
+		if (pos == -1)
+			break;	/* no more matches */
+		count++;
+		ttf.chrg.cpMin = ttf.chrgText.cpMax + 1;	/* search after this match */
+	}
+	g_free(regex);
+	/* The 0.02 is a low weighting to ignore a few possibly accidental occurrences */
+	return count > sci_get_line_count(sci) * 0.02;
+}
+
+
+/* Detect the indent type based on counting the leading indent characters for each line.
+ * Returns whether detection succeeded, and the detected type in *type_ upon success */
+gboolean document_detect_indent_type(GeanyDocument *doc, GeanyIndentType *type_)
+{
+	GeanyEditor *editor = doc->editor;
+	ScintillaObject *sci = editor->sci;
+	gint line, line_count;
+	gsize tabs = 0, spaces = 0;
+	const gchar *text;
+
+	if (detect_tabs_and_spaces(editor))
+	{
+		*type_ = GEANY_INDENT_TYPE_BOTH;
+		return TRUE;
+	}
+
+	/* read the leading characters in place, the buffer is NUL-terminated and
+	 * nothing below modifies it */
+	text = sci_get_character_pointer(sci);
+	line_count = sci_get_line_count(sci);
 	for (line = 0; line < line_count; line++)
 	{
 		gint pos = sci_get_position_from_line(sci, line);
@@ -1049,11 +1841,11 @@ gboolean document_detect_indent_type(GeanyDocument *doc, GeanyIndentType *type_)
 		if (sci_get_line_indentation(sci, line) > 24)
 			continue;
 
-		c = sci_get_char_at(sci, pos);
+		c = text[pos];
 		if (c == '\t')
 			tabs++;
 		/* check for at least 2 spaces */
-		else if (c == ' ' && sci_get_char_at(sci, pos + 1) == ' ')
+		else if (c == ' ' && text[pos + 1] == ' ')
 			spaces++;
 	}
 	if (spaces == 0 && tabs == 0)
@@ -1149,7 +1941,8 @@ void document_apply_indent_settings(GeanyDocument *doc)
 	GeanyIndentType type = iprefs->type;
 	gint width = iprefs->width;
 
-	if (iprefs->detect_type && document_detect_indent_type(doc, &type))
+	if (iprefs->detect_type && ! doc->priv->is_large_file &&
+		document_detect_indent_type(doc, &type))
 	{
 		if (type != iprefs->type)
 		{
@@ -1176,7 +1969,8 @@ void document_apply_indent_settings(GeanyDocument *doc)
 	else if (doc->file_type->indent_type > -1)
 		type = doc->file_type->indent_type;
 
-	if (iprefs->detect_width && detect_indent_width(doc->editor, type, &width))
+	if (iprefs->detect_width && ! doc->priv->is_large_file &&
+		detect_indent_width(doc->editor, type, &width))
 	{
 		if (width != iprefs->width)
 		{
@@ -1198,6 +1992,41 @@ void document_show_tab(GeanyDocument *doc)
 }
 
 
+/* Documents opened while a batch open is in progress, NULL outside a batch */
+static GPtrArray *open_batch_docs = NULL;
+static guint open_batch_depth = 0;
+
+
+/* Suspends the per-document "document-open" signal; documents opened until the
+ * matching document_open_batch_end() are announced to plugins in a single
+ * "documents-opened" emission instead, so opening a whole session runs each
+ * plugin handler once rather than once per file. Calls may nest. */
+void document_open_batch_begin(void)
+{
+	if (open_batch_depth++ == 0)
+		open_batch_docs = g_ptr_array_new();
+}
+
+
+void document_open_batch_end(void)
+{
+	GPtrArray *docs = open_batch_docs;
+
+	g_return_if_fail(open_batch_depth > 0);
+
+	if (--open_batch_depth > 0)
+		return;
+
+	open_batch_docs = NULL;
+	/* a batch of one behaves like a plain open for plugins */
+	if (docs->len == 1)
+		g_signal_emit_by_name(geany_object, "document-open", g_ptr_array_index(docs, 0));
+	else if (docs->len > 1)
+		g_signal_emit_by_name(geany_object, "documents-opened", docs);
+	g_ptr_array_free(docs, TRUE);
+}
+
+
 /* To open a new file, set doc to NULL; filename should be locale encoded.
  * To reload a file, set the doc for the document to be reloaded; filename should be NULL.
  * pos is the cursor position, which can be overridden by --line and --column.
@@ -1207,6 +2036,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc)
 {
 	gint editor_mode;
+	GTimeVal load_start;
 	gboolean reload = (doc == NULL) ? FALSE : TRUE;
 	gchar *utf8_filename = NULL;
 	gchar *display_filename = NULL;
@@ -1252,6 +2082,15 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	{	/* doc possibly changed */
 		display_filename = utils_str_middle_truncate(utf8_filename, 100);
 
+		if (reload)
+		{
+			document_cancel_background_load(doc);
+			/* a reload must not clobber a clone still sharing this buffer */
+			if (doc->priv->clone_partner != NULL)
+				clone_pair_split(doc);
+		}
+
+		g_get_current_time(&load_start);
 		if (! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
 		{
 			g_free(display_filename);
@@ -1259,6 +2098,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			g_free(locale_filename);
 			return NULL;
 		}
+		stats_time_since("document.load-file", &load_start);
 
 		if (! reload)
 		{
@@ -1267,6 +2107,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 			/* file exists on disk, set real_path */
 			SETPTR(doc->real_path, tm_get_real_path(locale_filename));
+			document_index_update();
 
 			doc->priv->is_remote = utils_is_remote_path(locale_filename);
 			monitor_file_setup(doc);
@@ -1288,6 +2129,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		sci_set_undo_collection(doc->editor->sci, TRUE);
 
 		doc->priv->mtime = filedata.mtime; /* get the modification time from file and keep it */
+		doc->priv->disk_size = filedata.disk_size;
 		g_free(doc->encoding);	/* if reloading, free old encoding */
 		doc->encoding = filedata.enc;
 		doc->has_bom = filedata.bom;
@@ -1316,6 +2158,29 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 			use_ft = ft;
 		}
+
+		/* large file mode: drop syntax highlighting, folding and symbol parsing to keep
+		 * the editor responsive (see also document_update_tags()) */
+		doc->priv->is_large_file = file_prefs.large_file_size > 0 &&
+			filedata.disk_size >= (goffset) file_prefs.large_file_size * 1024 * 1024;
+		doc->priv->readonly_view = FALSE;
+		if (doc->priv->is_large_file)
+		{
+			use_ft = filetypes[GEANY_FILETYPES_NONE];
+			sci_set_folding_margin_visible(doc->editor->sci, FALSE);
+			/* open for viewing only; the first modification attempt offers making
+			 * the document editable */
+			if (! doc->readonly)
+			{
+				doc->priv->readonly_view = TRUE;
+				doc->readonly = TRUE;
+				sci_set_readonly(doc->editor->sci, TRUE);
+			}
+			ui_set_statusbar(FALSE,
+				_("File %s is very large: it was opened read-only and syntax highlighting, folding and the symbol list are disabled."),
+				display_filename);
+		}
+
 		/* update taglist, typedef keywords and build menu if necessary */
 		document_set_filetype(doc, use_ft);
 
@@ -1328,10 +2193,23 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		document_set_text_changed(doc, FALSE);	/* also updates tab state */
 		ui_document_show_hide(doc);	/* update the document menu */
 
+		/* with a background load pending the buffer is incomplete, so its
+		 * content hash could never match a persisted history */
+		if (! reload && filedata.async_offset <= 0)
+			document_restore_undo_history(doc);
+
+		/* load the remainder of a large file in the background now the document is set up */
+		if (filedata.async_offset > 0)
+			document_start_background_load(doc, locale_filename, display_filename, &filedata);
+
 		/* finally add current file to recent files menu, but not the files from the last session */
 		if (! main_status.opening_session_files)
 			ui_add_recent_document(doc);
 
+		/* record the open in the session journal rather than rewriting the session */
+		if (! reload)
+			configuration_journal_document_open(doc);
+
 		if (reload)
 		{
 			g_signal_emit_by_name(geany_object, "document-reload", doc);
@@ -1339,7 +2217,10 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		}
 		else
 		{
-			g_signal_emit_by_name(geany_object, "document-open", doc);
+			if (open_batch_docs != NULL)
+				g_ptr_array_add(open_batch_docs, doc);
+			else
+				g_signal_emit_by_name(geany_object, "document-open", doc);
 			/* For translators: this is the status window message for opening a file. %d is the number
 			 * of the newly opened file, %s indicates whether the file is opened read-only
 			 * (it is replaced with the string ", read-only"). */
@@ -1377,6 +2258,7 @@ void document_open_file_list(const gchar *data, gsize length)
 
 	list = g_strsplit(data, utils_get_eol_char(utils_get_line_endings(data, length)), 0);
 
+	document_open_batch_begin();
 	/* stop at the end or first empty item, because last item is empty but not null */
 	for (i = 0; list[i] != NULL && list[i][0] != '\0'; i++)
 	{
@@ -1386,6 +2268,7 @@ void document_open_file_list(const gchar *data, gsize length)
 		document_open_file(filename, FALSE, NULL, NULL);
 		g_free(filename);
 	}
+	document_open_batch_end();
 
 	g_strfreev(list);
 }
@@ -1405,10 +2288,12 @@ void document_open_files(const GSList *filenames, gboolean readonly, GeanyFilety
 {
 	const GSList *item;
 
+	document_open_batch_begin();
 	for (item = filenames; item != NULL; item = g_slist_next(item))
 	{
 		document_open_file(item->data, readonly, ft, forced_enc);
 	}
+	document_open_batch_end();
 }
 
 
@@ -1464,18 +2349,400 @@ gboolean document_reload_prompt(GeanyDocument *doc, const gchar *forced_enc)
 			_("Undo history will be lost."),
 		_("Are you sure you want to reload '%s'?"), base_name))
 	{
-		result = document_reload_force(doc, forced_enc);
-		if (forced_enc != NULL)
-			ui_update_statusbar(doc, -1);
+		result = document_reload_force(doc, forced_enc);
+		if (forced_enc != NULL)
+			ui_update_statusbar(doc, -1);
+	}
+	g_free(base_name);
+	return result;
+}
+
+
+/* Follow mode fast path for files that only ever grow, e.g. build logs kept open in the
+ * editor: when the file grew and the bytes right before the old end still match the
+ * buffer, only the new tail is read and appended instead of reloading the whole file.
+ * Scintilla styles incrementally, so just the appended lines get lexed. Restricted to
+ * pristine documents in encodings whose buffer bytes equal the bytes on disk (UTF-8
+ * without BOM, or None). When the caret sat at the end of the buffer it is kept there,
+ * following the file like tail -f. Returns TRUE when the change was fully handled. */
+static gboolean document_append_tail(GeanyDocument *doc, const gchar *locale_filename,
+	const struct stat *st)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	goffset old_size = doc->priv->disk_size;
+	gchar check[4096];
+	gchar *buffer_tail;
+	gchar *tail;
+	const gchar *valid_end;
+	gsize check_len, tail_len, append_len;
+	gboolean follow;
+	FILE *fp;
+
+	if (old_size <= 0 || (goffset) st->st_size <= old_size)
+		return FALSE;
+	if (doc->changed || document_can_undo(doc) || document_can_redo(doc))
+		return FALSE;
+	/* a clone still shares this buffer; the full reload path splits the pair first */
+	if (doc->priv->clone_partner != NULL)
+		return FALSE;
+	if (doc->has_bom ||
+		(! utils_str_equal(doc->encoding, "UTF-8") &&
+		 ! utils_str_equal(doc->encoding, encodings[GEANY_ENCODING_NONE].charset)))
+		return FALSE;
+	/* a shorter buffer means the loaded data was truncated or is still loading */
+	if ((goffset) sci_get_length(sci) != old_size)
+		return FALSE;
+
+	fp = g_fopen(locale_filename, "rb");
+	if (fp == NULL)
+		return FALSE;
+
+	/* head unchanged check: the window right before the old end must still match the
+	 * buffer, otherwise the file was rewritten and needs the full reload */
+	check_len = (gsize) MIN(old_size, (goffset) sizeof check);
+	if (fseek(fp, (long) (old_size - (goffset) check_len), SEEK_SET) != 0 ||
+		fread(check, 1, check_len, fp) != check_len)
+	{
+		fclose(fp);
+		return FALSE;
+	}
+	buffer_tail = sci_get_contents_range(sci, (gint) (old_size - (goffset) check_len),
+		(gint) old_size);
+	if (buffer_tail == NULL || memcmp(buffer_tail, check, check_len) != 0)
+	{
+		g_free(buffer_tail);
+		fclose(fp);
+		return FALSE;
+	}
+	g_free(buffer_tail);
+
+	tail_len = (gsize) (st->st_size - old_size);
+	tail = g_malloc(tail_len + 1);
+	if (fread(tail, 1, tail_len, fp) != tail_len)
+	{
+		g_free(tail);
+		fclose(fp);
+		return FALSE;
+	}
+	fclose(fp);
+	tail[tail_len] = '\0';
+
+	/* embedded NULL bytes or broken UTF-8 need the full loader and its warnings */
+	if (memchr(tail, '\0', tail_len) != NULL)
+	{
+		g_free(tail);
+		return FALSE;
+	}
+	append_len = tail_len;
+	if (utils_str_equal(doc->encoding, "UTF-8") &&
+		! utils_utf8_validate(tail, (gssize) tail_len, &valid_end))
+	{
+		if (tail_len - (gsize) (valid_end - tail) >= 4)
+		{	/* invalid in the middle, not just a character the writer split */
+			g_free(tail);
+			return FALSE;
+		}
+		/* hold the incomplete trailing character back until the next change event */
+		append_len = (gsize) (valid_end - tail);
+	}
+
+	follow = sci_get_current_position(sci) == sci_get_length(sci);
+	if (append_len > 0)
+	{
+		if (doc->readonly)
+			sci_set_readonly(sci, FALSE);
+		sci_set_undo_collection(sci, FALSE);
+		sci_append_text(sci, tail, append_len);
+		sci_set_undo_collection(sci, TRUE);
+		if (doc->readonly)
+			sci_set_readonly(sci, TRUE);
+		document_set_text_changed(doc, FALSE);
+
+		doc->priv->line_count = sci_get_line_count(sci);
+		sci_set_line_numbers(sci, editor_prefs.show_linenumber_margin);
+
+		if (follow)
+			sci_goto_pos(sci, sci_get_length(sci), FALSE);
+	}
+	g_free(tail);
+
+	doc->priv->mtime = st->st_mtime;
+	doc->priv->disk_size = old_size + (goffset) append_len;
+	doc->priv->file_disk_status = FILE_OK;
+	ui_update_tab_status(doc);
+	return TRUE;
+}
+
+
+/* One document of a bulk reload (document_reload_all_changed()). The file is read and
+ * converted on a worker thread; the buffer swap happens later on the main loop. */
+typedef struct
+{
+	GeanyDocument	*doc;				/* checked with DOC_VALID() before use */
+	gchar			*locale_filename;
+	gchar			*enc;				/* the document's encoding, used as forced encoding */
+	FileData		 filedata;
+	gboolean		 ok;
+} BulkReloadJob;
+
+typedef struct
+{
+	GPtrArray		*jobs;
+	volatile gint	 next_job;	/* next job index for a worker thread to claim */
+	volatile gint	 pending;	/* jobs not read yet; the last worker schedules the apply */
+} BulkReload;
+
+/* enough to saturate the disk without drowning the box during a 200 file reload */
+#define BULK_RELOAD_MAX_THREADS 4
+
+
+static void bulk_reload_free(BulkReload *bulk)
+{
+	guint i;
+
+	for (i = 0; i < bulk->jobs->len; i++)
+	{
+		BulkReloadJob *job = g_ptr_array_index(bulk->jobs, i);
+
+		g_free(job->filedata.data);
+		g_free(job->locale_filename);
+		g_free(job->enc);
+		g_free(job);
+	}
+	g_ptr_array_free(bulk->jobs, TRUE);
+	g_free(bulk);
+}
+
+
+/* main thread: swap the freshly read buffers into their documents in one pass */
+static gboolean bulk_reload_apply_idle(gpointer data)
+{
+	BulkReload *bulk = data;
+	guint i, reloaded = 0;
+
+	if (main_status.quitting)
+	{
+		bulk_reload_free(bulk);
+		return FALSE;
+	}
+
+	for (i = 0; i < bulk->jobs->len; i++)
+	{
+		BulkReloadJob *job = g_ptr_array_index(bulk->jobs, i);
+		GeanyDocument *doc = job->doc;
+		FileData *filedata = &job->filedata;
+		ScintillaObject *sci;
+		gint pos;
+
+		if (! DOC_VALID(doc))
+			continue;
+		if (doc->changed || document_can_undo(doc) || document_can_redo(doc))
+		{	/* edited while the file was being read; leave it to the usual info bar */
+			ui_update_tab_status(doc);
+			continue;
+		}
+		if (! job->ok)
+		{	/* unreadable or no longer valid in its old encoding; the synchronous
+			 * reload re-detects the encoding and reports errors properly */
+			document_reload_force(doc, NULL);
+			continue;
+		}
+
+		sci = doc->editor->sci;
+		document_cancel_background_load(doc);
+		/* use cancel to dismiss a pending "file changed on disk" bar,
+		 * like document_reload_force() does */
+		if (doc->priv->info_bars[MSG_TYPE_RELOAD] != NULL)
+			gtk_info_bar_response(GTK_INFO_BAR(doc->priv->info_bars[MSG_TYPE_RELOAD]),
+				GTK_RESPONSE_CANCEL);
+
+		/* the buffer swap mirrors the reload branch of document_open_file_full(),
+		 * minus re-reading the file and re-applying the unchanged filetype */
+		pos = sci_get_current_position(sci);
+		sci_set_undo_collection(sci, FALSE);
+		sci_empty_undo_buffer(sci);
+		sci_set_readonly(sci, FALSE);
+		sci_set_text(sci, filedata->data);
+		queue_colourise(doc);
+		sci_set_eol_mode(sci, utils_get_line_endings(filedata->data, filedata->len));
+		sci_set_undo_collection(sci, TRUE);
+
+		doc->priv->mtime = filedata->mtime;
+		doc->priv->disk_size = filedata->disk_size;
+		SETPTR(doc->encoding, filedata->enc);
+		filedata->enc = NULL;
+		doc->has_bom = filedata->bom;
+		store_saved_encoding(doc);
+
+		doc->readonly = doc->readonly || filedata->readonly;
+		sci_set_readonly(sci, doc->readonly);
+		doc->priv->protected = 0;
+
+		doc->priv->line_count = sci_get_line_count(sci);
+		sci_set_line_numbers(sci, editor_prefs.show_linenumber_margin);
+
+		document_undo_clear(doc);
+		editor_set_indent(doc->editor, doc->editor->indent_type, doc->editor->indent_width);
+		document_set_text_changed(doc, FALSE);
+		doc->priv->file_disk_status = FILE_OK;
+		ui_update_tab_status(doc);
+		sci_set_current_position(sci, pos, FALSE);
+
+		/* the symbols are re-parsed on the tag manager's worker thread; the symbol
+		 * list is refreshed from the parse callbacks, so the sidebar is not rebuilt
+		 * once per document here */
+		document_update_tags(doc);
+		g_signal_emit_by_name(geany_object, "document-reload", doc);
+		reloaded++;
+	}
+
+	if (reloaded > 0)
+		ui_set_statusbar(TRUE, ngettext("%u file changed on disk reloaded.",
+			"%u files changed on disk reloaded.", reloaded), reloaded);
+
+	bulk_reload_free(bulk);
+	return FALSE;
+}
+
+
+/* worker thread: claim jobs off the shared list and read and convert their files; several
+ * workers run this concurrently. Reloads keep the document's encoding, so the conversion
+ * stays on the g_iconv() path and away from the encoding detection's shared regex state. */
+static gpointer bulk_reload_thread(gpointer data)
+{
+	BulkReload *bulk = data;
+
+	while (TRUE)
+	{
+		gint i = g_atomic_int_exchange_and_add(&bulk->next_job, 1);
+		BulkReloadJob *job;
+		struct stat st;
+
+		if (i >= (gint) bulk->jobs->len)
+			break;
+		job = g_ptr_array_index(bulk->jobs, i);
+
+		if (g_stat(job->locale_filename, &st) == 0 &&
+			g_file_get_contents(job->locale_filename, &job->filedata.data, NULL, NULL))
+		{
+			job->filedata.len = (gsize) st.st_size;
+			job->filedata.mtime = st.st_mtime;
+			job->filedata.disk_size = (goffset) st.st_size;
+			job->ok = encodings_convert_to_utf8_auto(&job->filedata.data, &job->filedata.len,
+				job->enc, &job->filedata.enc, &job->filedata.bom, &job->filedata.readonly);
+			if (! job->ok)
+			{
+				g_free(job->filedata.data);
+				job->filedata.data = NULL;
+			}
+		}
+
+		if (g_atomic_int_dec_and_test(&bulk->pending))
+			g_idle_add(bulk_reload_apply_idle, bulk);
+	}
+	return NULL;
+}
+
+
+/* Reloads every document whose file was modified behind the editor's back, reading and
+ * converting the files on a few worker threads and swapping the buffers into the documents
+ * in a single pass on the main loop. Only pristine documents (no unsaved changes and no
+ * undo history) are reloaded, matching what document_reload_prompt() does without asking;
+ * edited documents keep the usual per-file info bar.
+ * Returns the number of documents scheduled for reload. */
+guint document_reload_all_changed(void)
+{
+	BulkReload *bulk;
+	guint i, n_threads, n_jobs;
+
+	bulk = g_new0(BulkReload, 1);
+	bulk->jobs = g_ptr_array_new();
+
+	foreach_document(i)
+	{
+		GeanyDocument *doc = documents[i];
+		BulkReloadJob *job;
+		struct stat st;
+		gchar *locale_filename;
+
+		if (doc->real_path == NULL || doc->priv->is_remote)
+			continue;
+		locale_filename = utils_get_locale_from_utf8(doc->file_name);
+		/* missing files are the resave prompt's business, not ours */
+		if (locale_filename == NULL || g_stat(locale_filename, &st) != 0 ||
+			(doc->priv->file_disk_status != FILE_CHANGED && doc->priv->mtime >= st.st_mtime))
+		{
+			g_free(locale_filename);
+			continue;
+		}
+		if (document_append_tail(doc, locale_filename, &st))
+		{	/* the file only grew, the new tail has been appended already */
+			g_free(locale_filename);
+			continue;
+		}
+		if (doc->priv->clone_partner != NULL)
+		{	/* reloading must split the clone pair first, go through the info bar */
+			doc->priv->mtime = st.st_mtime;
+			monitor_reload_file(doc);
+			g_free(locale_filename);
+			continue;
+		}
+		if (doc->changed || document_can_undo(doc) || document_can_redo(doc))
+		{	/* never reload over the user's edits; show the info bar instead */
+			doc->priv->mtime = st.st_mtime;
+			monitor_reload_file(doc);
+			g_free(locale_filename);
+			continue;
+		}
+
+		job = g_new0(BulkReloadJob, 1);
+		job->doc = doc;
+		job->locale_filename = locale_filename;
+		job->enc = g_strdup(doc->encoding);
+		g_ptr_array_add(bulk->jobs, job);
+	}
+
+	n_jobs = bulk->jobs->len;
+	if (n_jobs == 0)
+	{
+		bulk_reload_free(bulk);
+		return 0;
+	}
+
+	bulk->pending = (gint) n_jobs;
+	n_threads = MIN(n_jobs, BULK_RELOAD_MAX_THREADS);
+	for (i = 0; i < n_threads; i++)
+	{
+		/* the workers share the job list, so fewer threads than requested just
+		 * means less parallelism, not lost jobs */
+		if (g_thread_create(bulk_reload_thread, bulk, FALSE, NULL) == NULL)
+			break;
 	}
-	g_free(base_name);
-	return result;
+	if (i == 0)
+	{	/* no worker could be created at all, reload serially as before */
+		for (i = 0; i < n_jobs; i++)
+		{
+			BulkReloadJob *job = g_ptr_array_index(bulk->jobs, i);
+
+			document_reload_force(job->doc, job->enc);
+		}
+		bulk_reload_free(bulk);
+	}
+	return n_jobs;
+}
+
+
+static gboolean bulk_reload_timeout(G_GNUC_UNUSED gpointer data)
+{
+	bulk_reload_source = 0;
+	if (! main_status.quitting && ! main_status.closing_all)
+		document_reload_all_changed();
+	return FALSE;
 }
 
 
 static gboolean document_update_timestamp(GeanyDocument *doc, const gchar *locale_filename)
 {
-#ifndef USE_GIO_FILEMON
 	struct stat st;
 
 	g_return_val_if_fail(doc != NULL, FALSE);
@@ -1490,7 +2757,7 @@ static gboolean document_update_timestamp(GeanyDocument *doc, const gchar *local
 	}
 
 	doc->priv->mtime = st.st_mtime; /* get the modification time from file and keep it */
-#endif
+	doc->priv->disk_size = (goffset) st.st_size;
 	return TRUE;
 }
 
@@ -1643,6 +2910,7 @@ gboolean document_save_file_as(GeanyDocument *doc, const gchar *utf8_fname)
 
 	/* reset real path, it's retrieved again in document_save() */
 	SETPTR(doc->real_path, NULL);
+	document_index_update();
 
 	/* detect filetype */
 	if (doc->file_type->id == GEANY_FILETYPES_NONE)
@@ -1743,11 +3011,77 @@ _("An error occurred while converting the file from UTF-8 in \"%s\". The file re
 }
 
 
+/* POSIX write+rename save used for the relaxed fsync policies: the data is
+ * written to a temporary file in the target directory which then atomically
+ * replaces the target, flushed to disk beforehand only when requested. Unlike
+ * the truncating POSIX writer below, an interrupted save cannot damage the
+ * old file contents. Not GVFS-safe. */
+static gchar *write_data_atomic(const gchar *locale_filename,
+								const gchar *data, gsize len, gboolean sync_file)
+{
+	gchar *tmp_name = g_strconcat(locale_filename, ".geany-save-XXXXXX", NULL);
+	gint fd = g_mkstemp(tmp_name);
+	gchar *err = NULL;
+
+	if (fd == -1)
+		err = g_strdup(g_strerror(errno));
+	else
+	{
+		gsize written = 0;
+		struct stat s;
+
+#ifndef G_OS_WIN32
+		/* carry over the permissions of an already existing target */
+		if (g_stat(locale_filename, &s) == 0)
+			fchmod(fd, s.st_mode);
+#endif
+		while (written < len && err == NULL)
+		{
+			gssize n = write(fd, data + written, len - written);
+
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				err = g_strdup(g_strerror(errno));
+			}
+			else
+				written += (gsize) n;
+		}
+#ifndef G_OS_WIN32
+		if (err == NULL && sync_file && fsync(fd) != 0)
+			err = g_strdup(g_strerror(errno));
+#endif
+		if (close(fd) != 0 && err == NULL)
+			err = g_strdup(g_strerror(errno));
+		if (err == NULL && g_rename(tmp_name, locale_filename) != 0)
+			err = g_strdup(g_strerror(errno));
+		if (err != NULL)
+			g_unlink(tmp_name);
+		else
+			geany_debug("Wrote %s with write_data_atomic().", locale_filename);
+	}
+	g_free(tmp_name);
+	return err;
+}
+
+
 static gchar *write_data_to_disk(const gchar *locale_filename,
 								 const gchar *data, gsize len)
 {
 	GError *error = NULL;
 
+	if (file_prefs.save_fsync_policy != GEANY_FSYNC_ALWAYS)
+	{
+		/* the glib and GIO writers flush unconditionally, so the relaxed
+		 * policies use the write+rename path; quitting still flushes under
+		 * the on-close policy */
+		gboolean sync_file = file_prefs.save_fsync_policy == GEANY_FSYNC_ON_CLOSE &&
+			main_status.quitting;
+
+		return write_data_atomic(locale_filename, data, len, sync_file);
+	}
+
 	if (file_prefs.use_safe_file_saving)
 	{
 		/* Use old GLib API for safe saving (GVFS-safe, but alters ownership and permissons).
@@ -1851,6 +3185,7 @@ static gchar *save_doc(GeanyDocument *doc, const gchar *locale_filename,
 	if (doc->real_path == NULL)
 	{
 		doc->real_path = tm_get_real_path(locale_filename);
+		document_index_update();
 		doc->priv->is_remote = utils_is_remote_path(locale_filename);
 		monitor_file_setup(doc);
 	}
@@ -1892,6 +3227,73 @@ static gboolean save_file_handle_infobars(GeanyDocument *doc, gboolean force)
 }
 
 
+/* Runs the pre-save buffer hooks and the "document-before-save" signal, then
+ * snapshots the buffer converted to the document's encoding. Returns the data
+ * to write (caller frees) and its length in len, or NULL when the conversion
+ * failed (an error dialog has been shown then). */
+static gchar *save_file_prepare_data(GeanyDocument *doc, gsize *len)
+{
+	const GeanyFilePrefs *fp;
+	gchar *data;
+
+	/* saving is a clear divergence point for a clone pair, and the save hooks
+	 * (strip trailing spaces, final newline) must be able to edit the buffer */
+	if (doc->priv->clone_partner != NULL)
+		clone_pair_split(doc);
+
+	fp = project_get_file_prefs();
+	/* replaces tabs with spaces but only if the current file is not a Makefile */
+	if (fp->replace_tabs && doc->file_type->id != GEANY_FILETYPES_MAKE)
+		editor_replace_tabs(doc->editor);
+	/* strip trailing spaces */
+	if (fp->strip_trailing_spaces)
+		editor_strip_trailing_spaces(doc->editor);
+	/* ensure the file has a newline at the end */
+	if (fp->final_new_line)
+		editor_ensure_final_newline(doc->editor);
+	/* ensure newlines are consistent */
+	if (fp->ensure_convert_new_lines)
+		sci_convert_eols(doc->editor->sci, sci_get_eol_mode(doc->editor->sci));
+
+	/* notify plugins which may wish to modify the document before it's saved */
+	g_signal_emit_by_name(geany_object, "document-before-save", doc);
+
+	*len = sci_get_length(doc->editor->sci) + 1;
+	if (doc->has_bom && encodings_is_unicode_charset(doc->encoding))
+	{	/* always write a UTF-8 BOM because in this moment the text itself is still in UTF-8
+		 * encoding, it will be converted to doc->encoding below and this conversion
+		 * also changes the BOM */
+		data = (gchar*) g_malloc(*len + 3);	/* 3 chars for BOM */
+		data[0] = (gchar) 0xef;
+		data[1] = (gchar) 0xbb;
+		data[2] = (gchar) 0xbf;
+		sci_get_text(doc->editor->sci, *len, data + 3);
+		*len += 3;
+	}
+	else
+	{
+		data = (gchar*) g_malloc(*len);
+		sci_get_text(doc->editor->sci, *len, data);
+	}
+
+	/* save in original encoding, skip when it is already UTF-8 or has the encoding "None" */
+	if (doc->encoding != NULL && ! utils_str_equal(doc->encoding, "UTF-8") &&
+		! utils_str_equal(doc->encoding, encodings[GEANY_ENCODING_NONE].charset))
+	{
+		if (! save_convert_to_encoding(doc, &data, len))
+		{
+			g_free(data);
+			return NULL;
+		}
+	}
+	else
+	{
+		*len = strlen(data);
+	}
+	return data;
+}
+
+
 /**
  *  Saves the document.
  *  Also shows the Save As dialog if necessary.
@@ -1923,7 +3325,6 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 	gchar *data;
 	gsize len;
 	gchar *locale_filename;
-	const GeanyFilePrefs *fp;
 
 	g_return_val_if_fail(doc != NULL, FALSE);
 
@@ -1946,109 +3347,325 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 	if (doc->priv->protected)
 		return save_file_handle_infobars(doc, force);
 
-	fp = project_get_file_prefs();
-	/* replaces tabs with spaces but only if the current file is not a Makefile */
-	if (fp->replace_tabs && doc->file_type->id != GEANY_FILETYPES_MAKE)
-		editor_replace_tabs(doc->editor);
-	/* strip trailing spaces */
-	if (fp->strip_trailing_spaces)
-		editor_strip_trailing_spaces(doc->editor);
-	/* ensure the file has a newline at the end */
-	if (fp->final_new_line)
-		editor_ensure_final_newline(doc->editor);
-	/* ensure newlines are consistent */
-	if (fp->ensure_convert_new_lines)
-		sci_convert_eols(doc->editor->sci, sci_get_eol_mode(doc->editor->sci));
+	/* wait out a still running write for this document before snapshotting,
+	 * so writes to the same file cannot be reordered and edits made while
+	 * waiting become part of the snapshot; the main loop runs meanwhile, so
+	 * re-validate the document afterwards */
+	if (file_prefs.use_async_file_saving && ! main_status.quitting)
+	{
+		while (save_all_is_inflight(doc))
+			gtk_main_iteration();
+		if (! DOC_VALID(doc))
+			return FALSE;
+	}
 
-	/* notify plugins which may wish to modify the document before it's saved */
-	g_signal_emit_by_name(geany_object, "document-before-save", doc);
+	data = save_file_prepare_data(doc, &len);
+	if (data == NULL)
+		return FALSE;
 
-	len = sci_get_length(doc->editor->sci) + 1;
-	if (doc->has_bom && encodings_is_unicode_charset(doc->encoding))
-	{	/* always write a UTF-8 BOM because in this moment the text itself is still in UTF-8
-		 * encoding, it will be converted to doc->encoding below and this conversion
-		 * also changes the BOM */
-		data = (gchar*) g_malloc(len + 3);	/* 3 chars for BOM */
-		data[0] = (gchar) 0xef;
-		data[1] = (gchar) 0xbb;
-		data[2] = (gchar) 0xbf;
-		sci_get_text(doc->editor->sci, len, data + 3);
-		len += 3;
+	locale_filename = utils_get_locale_from_utf8(doc->file_name);
+
+	/* optionally hand the disk write to the worker pool; the result including
+	 * errors is delivered from the main loop as for Save All. Quitting keeps
+	 * the synchronous path so no write can be lost when the main loop stops. */
+	if (file_prefs.use_async_file_saving && ! main_status.quitting)
+	{
+		save_all_queue_write(doc, locale_filename, data, len);
+		g_free(locale_filename);
+		return TRUE;
 	}
-	else
+
+	/* ignore file changed notification when the file is written */
+	doc->priv->file_disk_status = FILE_IGNORE;
+
+	/* actually write the content of data to the file on disk */
+	errmsg = save_doc(doc, locale_filename, data, len);
+	g_free(data);
+
+	if (errmsg != NULL)
 	{
-		data = (gchar*) g_malloc(len);
-		sci_get_text(doc->editor->sci, len, data);
+		ui_set_statusbar(TRUE, _("Error saving file (%s)."), errmsg);
+
+		if (!file_prefs.use_safe_file_saving)
+		{
+			SETPTR(errmsg,
+				g_strdup_printf(_("%s\n\nThe file on disk may now be truncated!"), errmsg));
+		}
+		dialogs_show_msgbox_with_secondary(GTK_MESSAGE_ERROR, _("Error saving file."), errmsg);
+		doc->priv->file_disk_status = FILE_OK;
+		utils_beep();
+		g_free(locale_filename);
+		g_free(errmsg);
+		return FALSE;
 	}
 
-	/* save in original encoding, skip when it is already UTF-8 or has the encoding "None" */
-	if (doc->encoding != NULL && ! utils_str_equal(doc->encoding, "UTF-8") &&
-		! utils_str_equal(doc->encoding, encodings[GEANY_ENCODING_NONE].charset))
+	project_update_file_manifest(locale_filename);
+
+	/* store the opened encoding for undo/redo */
+	store_saved_encoding(doc);
+
+	document_save_undo_history(doc);
+
+	/* ignore the following things if we are quitting */
+	if (! main_status.quitting)
+	{
+		sci_set_savepoint(doc->editor->sci);
+
+		if (file_prefs.disk_check_timeout > 0)
+			document_update_timestamp(doc, locale_filename);
+
+		/* update filetype-related things */
+		document_set_filetype(doc, doc->file_type);
+
+		document_update_tab_label(doc);
+
+		msgwin_status_add(_("File %s saved."), doc->file_name);
+		ui_update_statusbar(doc, -1);
+#ifdef HAVE_VTE
+		vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
+#endif
+	}
+	g_free(locale_filename);
+
+	g_signal_emit_by_name(geany_object, "document-save", doc);
+
+	return TRUE;
+}
+
+
+/* --- parallel Save All ---
+ *
+ * Save All snapshots and converts each modified buffer on the main thread,
+ * then hands the disk writes to a small thread pool so slow targets (NFS,
+ * VFS mounts) overlap instead of adding up. Per-document UI state is updated
+ * from the main loop as each write completes. */
+
+typedef struct
+{
+	GeanyDocument *doc;			/* revalidated with DOC_VALID on delivery */
+	gchar *locale_filename;
+	gchar *data;
+	gsize len;
+	guint edit_count;			/* doc->priv->edit_count when the buffer was snapshotted */
+	gchar *errmsg;				/* write result, NULL on success */
+} SaveAllJob;
+
+static GThreadPool *save_all_pool = NULL;
+/* the following are accessed from the main thread only */
+static GPtrArray *save_all_inflight = NULL;
+static guint save_all_pending = 0;
+static guint save_all_saved = 0;
+
+
+static void save_all_update_ui(void)
+{
+	GeanyDocument *cur_doc = document_get_current();
+
+	if (save_all_saved > 0)
+	{
+		ui_set_statusbar(FALSE, ngettext("%d file saved.", "%d files saved.",
+			save_all_saved), save_all_saved);
+	}
+	if (cur_doc == NULL)
+		return;
+	/* saving may have changed window title, sidebar for another doc, so update */
+	document_show_tab(cur_doc);
+	sidebar_update_tag_list(cur_doc, TRUE);
+	ui_set_window_title(cur_doc);
+}
+
+
+/* runs on the main loop once the worker has finished writing a document */
+static gboolean save_all_finish_idle(gpointer data)
+{
+	SaveAllJob *job = data;
+	GeanyDocument *doc = job->doc;
+
+	save_all_pending--;
+	g_ptr_array_remove_fast(save_all_inflight, doc);
+
+	if (! DOC_VALID(doc))
 	{
-		if (! save_convert_to_encoding(doc, &data, &len))
+		/* closed while the write was in flight - nothing to update */
+	}
+	else if (job->errmsg != NULL)
+	{
+		ui_set_statusbar(TRUE, _("Error saving file (%s)."), job->errmsg);
+		if (!file_prefs.use_safe_file_saving)
 		{
-			g_free(data);
-			return FALSE;
+			SETPTR(job->errmsg,
+				g_strdup_printf(_("%s\n\nThe file on disk may now be truncated!"), job->errmsg));
 		}
+		dialogs_show_msgbox_with_secondary(GTK_MESSAGE_ERROR, _("Error saving file."), job->errmsg);
+		doc->priv->file_disk_status = FILE_OK;
+		utils_beep();
 	}
 	else
 	{
-		len = strlen(data);
+		save_all_saved++;
+
+		/* now the file is on disk, set real_path */
+		if (doc->real_path == NULL)
+		{
+			doc->real_path = tm_get_real_path(job->locale_filename);
+			document_index_update();
+			doc->priv->is_remote = utils_is_remote_path(job->locale_filename);
+			monitor_file_setup(doc);
+		}
+
+		project_update_file_manifest(job->locale_filename);
+
+		/* store the opened encoding for undo/redo */
+		store_saved_encoding(doc);
+
+		document_save_undo_history(doc);
+
+		if (! main_status.quitting)
+		{
+			/* edits made while the worker was writing the snapshot are not in
+			 * the file on disk: keep the document marked as changed then,
+			 * otherwise closing it would discard them without a prompt */
+			if (doc->priv->edit_count == job->edit_count)
+				sci_set_savepoint(doc->editor->sci);
+
+			if (file_prefs.disk_check_timeout > 0)
+				document_update_timestamp(doc, job->locale_filename);
+
+			/* update filetype-related things */
+			document_set_filetype(doc, doc->file_type);
+
+			document_update_tab_label(doc);
+
+			msgwin_status_add(_("File %s saved."), doc->file_name);
+			ui_update_statusbar(doc, -1);
+		}
+		g_signal_emit_by_name(geany_object, "document-save", doc);
 	}
 
-	locale_filename = utils_get_locale_from_utf8(doc->file_name);
+	if (save_all_pending == 0)
+		save_all_update_ui();
 
-	/* ignore file changed notification when the file is written */
-	doc->priv->file_disk_status = FILE_IGNORE;
+	g_free(job->locale_filename);
+	g_free(job->data);
+	g_free(job->errmsg);
+	g_free(job);
+	return FALSE;
+}
 
-	/* actually write the content of data to the file on disk */
-	errmsg = save_doc(doc, locale_filename, data, len);
-	g_free(data);
 
-	if (errmsg != NULL)
+static void save_all_worker(gpointer data, G_GNUC_UNUSED gpointer user_data)
+{
+	SaveAllJob *job = data;
+
+	job->errmsg = write_data_to_disk(job->locale_filename, job->data, job->len);
+	g_idle_add(save_all_finish_idle, job);
+}
+
+
+static gboolean save_all_is_inflight(GeanyDocument *doc)
+{
+	guint i;
+
+	if (save_all_inflight == NULL)
+		return FALSE;
+	for (i = 0; i < save_all_inflight->len; i++)
 	{
-		ui_set_statusbar(TRUE, _("Error saving file (%s)."), errmsg);
+		if (save_all_inflight->pdata[i] == doc)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+/* queues the converted buffer of doc for writing by the worker pool, adopting
+ * data; the caller must ensure no earlier write for doc is still in flight */
+static void save_all_queue_write(GeanyDocument *doc, const gchar *locale_filename,
+	gchar *data, gsize len)
+{
+	SaveAllJob *job;
+
+	if (save_all_inflight == NULL)
+		save_all_inflight = g_ptr_array_new();
+	if (save_all_pool == NULL)
+		save_all_pool = g_thread_pool_new(save_all_worker, NULL, 4, FALSE, NULL);
+
+	job = g_new0(SaveAllJob, 1);
+	job->doc = doc;
+	job->locale_filename = g_strdup(locale_filename);
+	job->data = data;
+	job->len = len;
+	job->edit_count = doc->priv->edit_count;
+
+	/* ignore file changed notification while the file is written */
+	doc->priv->file_disk_status = FILE_IGNORE;
+	g_ptr_array_add(save_all_inflight, doc);
+	save_all_pending++;
+	g_thread_pool_push(save_all_pool, job, NULL);
+}
+
+
+/* Blocks until all writes queued to the worker pool have been delivered,
+ * processing main loop events meanwhile. Called before actions that read the
+ * saved files back, like building, and on exit. */
+void document_wait_for_saves(void)
+{
+	while (save_all_pending > 0)
+		gtk_main_iteration();
+}
 
-		if (!file_prefs.use_safe_file_saving)
-		{
-			SETPTR(errmsg,
-				g_strdup_printf(_("%s\n\nThe file on disk may now be truncated!"), errmsg));
-		}
-		dialogs_show_msgbox_with_secondary(GTK_MESSAGE_ERROR, _("Error saving file."), errmsg);
-		doc->priv->file_disk_status = FILE_OK;
-		utils_beep();
-		g_free(locale_filename);
-		g_free(errmsg);
-		return FALSE;
-	}
 
-	/* store the opened encoding for undo/redo */
-	store_saved_encoding(doc);
+/* Saves every modified document. Documents with a file name and no pending
+ * user decision are snapshotted and converted up front and written by a small
+ * worker pool, so the disk latencies of many files overlap; documents needing
+ * interaction (Save As dialog, disk change info bars, read-only warning) are
+ * saved synchronously as before. The UI state of each document is updated as
+ * its write completes. */
+void document_save_all(void)
+{
+	guint i, max = (guint) gtk_notebook_get_n_pages(GTK_NOTEBOOK(main_widgets.notebook));
+	guint queued = 0;
 
-	/* ignore the following things if we are quitting */
-	if (! main_status.quitting)
+	save_all_saved = 0;
+	if (save_all_inflight == NULL)
+		save_all_inflight = g_ptr_array_new();
+
+	/* iterate over documents in tabs order */
+	for (i = 0; i < max; i++)
 	{
-		sci_set_savepoint(doc->editor->sci);
+		GeanyDocument *doc = document_get_from_page(i);
+		gchar *locale_filename;
+		gchar *data;
+		gsize len;
 
-		if (file_prefs.disk_check_timeout > 0)
-			document_update_timestamp(doc, locale_filename);
+		if (! doc->changed)
+			continue;
+		/* re-queueing a document whose previous write has not finished yet
+		 * could reorder the writes */
+		if (save_all_is_inflight(doc))
+			continue;
 
-		/* update filetype-related things */
-		document_set_filetype(doc, doc->file_type);
+		document_check_disk_status(doc, TRUE);
 
-		document_update_tab_label(doc);
+		/* documents needing user interaction take the synchronous path */
+		if (document_need_save_as(doc) || doc->readonly || doc->priv->protected)
+		{
+			if (document_save_file(doc, FALSE))
+				save_all_saved++;
+			continue;
+		}
 
-		msgwin_status_add(_("File %s saved."), doc->file_name);
-		ui_update_statusbar(doc, -1);
-#ifdef HAVE_VTE
-		vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
-#endif
-	}
-	g_free(locale_filename);
+		data = save_file_prepare_data(doc, &len);
+		if (data == NULL)
+			continue;
 
-	g_signal_emit_by_name(geany_object, "document-save", doc);
+		locale_filename = utils_get_locale_from_utf8(doc->file_name);
+		save_all_queue_write(doc, locale_filename, data, len);
+		g_free(locale_filename);
+		queued++;
+	}
 
-	return TRUE;
+	if (queued == 0 && save_all_saved > 0)
+		save_all_update_ui();
 }
 
 
@@ -2360,38 +3977,56 @@ void document_replace_sel(GeanyDocument *doc, const gchar *find_text, const gcha
 	/* handle rectangle, multi line selections (it doesn't matter on a single line) */
 	if (selection_mode == SC_SEL_RECTANGLE && selected_lines > 1)
 	{
-		gint first_line, line;
-
-		sci_start_undo_action(doc->editor->sci);
+		gint first_line, line, n = 0, k;
+		gint *starts = g_new(gint, selected_lines);
+		gint *ends = g_new(gint, selected_lines);
+		gint *line_starts = g_new(gint, selected_lines);
+		gint *new_ends = g_new(gint, selected_lines);
+		gint prev_delta = 0;
 
 		first_line = sci_get_line_from_position(doc->editor->sci, selection_start);
 		/* Find the last line with chars selected (not EOL char) */
 		last_line = sci_get_line_from_position(doc->editor->sci,
 			selection_end - editor_get_eol_char_len(doc->editor));
 		last_line = MAX(first_line, last_line);
+		/* collect the selected span of each line against the unmodified buffer */
 		for (line = first_line; line < (first_line + selected_lines); line++)
 		{
 			gint line_start = sci_get_pos_at_line_sel_start(doc->editor->sci, line);
-			gint line_end = sci_get_pos_at_line_sel_end(doc->editor->sci, line);
 
 			/* skip line if there is no selection */
 			if (line_start != INVALID_POSITION)
 			{
-				/* don't let document_replace_range() scroll to match to keep our selection */
-				gint new_sel_end;
-
-				count += document_replace_range(doc, find_text, replace_text, flags,
-								line_start, line_end, FALSE, &new_sel_end);
-				if (new_sel_end != -1)
-				{
-					replaced = TRUE;
-					/* this gets the greatest column within the selection after replacing */
-					max_column = MAX(max_column,
-						new_sel_end - sci_get_position_from_line(doc->editor->sci, line));
-				}
+				starts[n] = line_start;
+				ends[n] = sci_get_pos_at_line_sel_end(doc->editor->sci, line);
+				line_starts[n] = sci_get_position_from_line(doc->editor->sci, line);
+				n++;
 			}
 		}
+		/* all matches are found first and replaced with a single buffer edit,
+		 * instead of one edit per line which re-shifts the rest of the buffer
+		 * every time on large rectangular selections */
+		sci_start_undo_action(doc->editor->sci);
+		count += search_replace_in_ranges(doc->editor->sci, flags, find_text, replace_text,
+			starts, ends, n, new_ends);
 		sci_end_undo_action(doc->editor->sci);
+
+		for (k = 0; k < n; k++)
+		{
+			if (new_ends[k] != -1)
+			{
+				replaced = TRUE;
+				/* this gets the greatest column within the selection after
+				 * replacing; the line start only shifted by edits on the
+				 * preceding lines */
+				max_column = MAX(max_column, new_ends[k] - (line_starts[k] + prev_delta));
+				prev_delta = new_ends[k] - ends[k];
+			}
+		}
+		g_free(starts);
+		g_free(ends);
+		g_free(line_starts);
+		g_free(new_ends);
 	}
 	else	/* handle normal line selection */
 	{
@@ -2469,6 +4104,13 @@ void document_update_tags(GeanyDocument *doc)
 	g_return_if_fail(DOC_VALID(doc));
 	g_return_if_fail(app->tm_workspace != NULL);
 
+	/* large file mode: symbol parsing is suspended */
+	if (doc->priv->is_large_file)
+	{
+		sidebar_update_tag_list(doc, FALSE);
+		return;
+	}
+
 	/* early out if it's a new file or doesn't support tags */
 	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type))
 	{
@@ -2488,10 +4130,24 @@ void document_update_tags(GeanyDocument *doc)
 		/* lookup the name rather than using filetype name to support custom filetypes */
 		name = tm_source_file_get_lang_name(doc->file_type->lang);
 		doc->tm_file = tm_source_file_new(locale_filename, name);
-		g_free(locale_filename);
 
 		if (doc->tm_file)
+		{
 			tm_workspace_add_source_file_noupdate(doc->tm_file);
+
+			/* an unmodified buffer matches the on-disk content, so tags cached
+			 * from a previous session can stand in for a full parse; this is
+			 * what makes reopening a large project session fast */
+			if (! doc->changed && project_load_cached_tags(doc->tm_file, locale_filename))
+			{
+				tm_workspace_merge_file_tags(doc->tm_file);
+				g_free(locale_filename);
+				sidebar_update_tag_list(doc, TRUE);
+				document_highlight_tags(doc);
+				return;
+			}
+		}
+		g_free(locale_filename);
 	}
 
 	/* early out if there's no tm source file and we couldn't create one */
@@ -2504,11 +4160,44 @@ void document_update_tags(GeanyDocument *doc)
 		return;
 	}
 
-	/* Parse Scintilla's buffer directly using TagManager
-	 * Note: this buffer *MUST NOT* be modified */
+	/* Parse a snapshot of the buffer on the tag manager's worker thread so
+	 * typing is never blocked on the ctags parsers; the symbol list and the
+	 * type keyword highlighting are refreshed from the callback once the
+	 * workspace has been updated. Superseded parses are cancelled by the
+	 * tag manager. */
 	len = sci_get_length(doc->editor->sci);
-	buffer_ptr = (guchar *) scintilla_send_message(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
-	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	buffer_ptr = (guchar *) sci_get_contents(doc->editor->sci, len + 1);
+	/* the snapshot covers everything modified so far; a pending scheduled
+	 * reparse seeing an unchanged counter skips itself */
+	doc->priv->tag_parsed_mod_count = doc->priv->tag_mod_count;
+	stats_count("document.parses-requested", 1);
+	tm_workspace_update_source_file_buffer_async(doc->tm_file, buffer_ptr, len,
+		on_document_tags_parsed, doc);
+}
+
+
+/* Called on the main loop when a background parse of the document has been
+ * merged into the tag manager workspace. */
+static void on_document_tags_parsed(TMSourceFile *source_file, gpointer user_data)
+{
+	GeanyDocument *doc = user_data;
+
+	if (! DOC_VALID(doc) || doc->tm_file != source_file || main_status.quitting)
+		return;
+
+	/* the difference to document.parses-requested is the number of parses the
+	 * tag manager cancelled as superseded */
+	stats_count("document.parses-merged", 1);
+
+	/* refresh the cache entry whenever the parsed buffer matches the file on
+	 * disk, i.e. right after opening an uncached file or after a save */
+	if (! doc->changed && doc->real_path != NULL)
+	{
+		gchar *locale_filename = utils_get_locale_from_utf8(doc->file_name);
+
+		project_save_cached_tags(doc->tm_file, locale_filename);
+		g_free(locale_filename);
+	}
 
 	sidebar_update_tag_list(doc, TRUE);
 	document_highlight_tags(doc);
@@ -2570,27 +4259,92 @@ static gboolean on_document_update_tag_list_idle(gpointer data)
 	if (! DOC_VALID(doc))
 		return FALSE;
 
-	if (! main_status.quitting)
+	if (! main_status.quitting &&
+		doc->priv->tag_mod_count != doc->priv->tag_parsed_mod_count)
 		document_update_tags(doc);
 
 	doc->priv->tag_list_update_source = 0;
+	doc->priv->tag_backoff = 0;
 
 	/* don't update the tags until another modification of the buffer */
 	return FALSE;
 }
 
 
+/* the reparse interval with the static adjustments (large file mode, latency
+ * shedding) applied, in milliseconds */
+static guint document_tag_update_freq(GeanyDocument *doc)
+{
+	guint freq = (guint) editor_prefs.autocompletion_update_freq;
+
+	/* large file mode: reparsing is suspended anyway, so check far less often */
+	if (doc->priv->is_large_file)
+		freq = MAX(freq * 10, 5000);
+
+	/* typing latency over budget: back off reparsing until it recovers
+	 * (4x per shed level) */
+	freq <<= 2 * editor_get_latency_shed_level();
+	return freq;
+}
+
+
 void document_update_tag_list_in_idle(GeanyDocument *doc)
 {
+	guint freq;
+	GTimeVal now;
+
 	if (editor_prefs.autocompletion_update_freq <= 0 || ! filetype_has_tags(doc->file_type))
 		return;
 
+	doc->priv->tag_mod_count++;
+	freq = document_tag_update_freq(doc);
+
+	/* adapt to the edit rate: while modifications keep arriving faster than
+	 * the reparse interval, back off exponentially - a parse scheduled in the
+	 * middle of a typing burst would be outdated before it is displayed.  The
+	 * first modification after a pause resets the backoff, so a parse still
+	 * follows promptly once typing stops. */
+	g_get_current_time(&now);
+	if (doc->priv->tag_list_update_source != 0)
+	{
+		glong elapsed = (now.tv_sec - doc->priv->tag_last_mod_time.tv_sec) * 1000 +
+			(now.tv_usec - doc->priv->tag_last_mod_time.tv_usec) / 1000;
+
+		if (elapsed >= 0 && elapsed < (glong) freq)
+			doc->priv->tag_backoff = MIN(doc->priv->tag_backoff + 1, 2);
+		else
+			doc->priv->tag_backoff = 0;
+	}
+	else
+		doc->priv->tag_backoff = 0;
+	doc->priv->tag_last_mod_time = now;
+
 	/* prevent "stacking up" callback handlers, we only need one to run soon */
 	if (doc->priv->tag_list_update_source != 0)
 		g_source_remove(doc->priv->tag_list_update_source);
 
 	doc->priv->tag_list_update_source = g_timeout_add_full(G_PRIORITY_LOW,
-		editor_prefs.autocompletion_update_freq, on_document_update_tag_list_idle, doc, NULL);
+		freq << doc->priv->tag_backoff, on_document_update_tag_list_idle, doc, NULL);
+}
+
+
+/* Called when the typed character suggests a scope was just closed (e.g. '}'):
+ * the code is likely to be in a parsable state now, so reparse soon instead of
+ * waiting out the regular - possibly backed off - interval. */
+void document_update_tag_list_on_scope_exit(GeanyDocument *doc)
+{
+	if (editor_prefs.autocompletion_update_freq <= 0 || ! filetype_has_tags(doc->file_type))
+		return;
+
+	if (doc->priv->tag_mod_count == doc->priv->tag_parsed_mod_count)
+		return;
+
+	doc->priv->tag_backoff = 0;
+	if (doc->priv->tag_list_update_source != 0)
+		g_source_remove(doc->priv->tag_list_update_source);
+
+	doc->priv->tag_list_update_source = g_timeout_add_full(G_PRIORITY_LOW,
+		MIN(document_tag_update_freq(doc), 100), on_document_update_tag_list_idle, doc, NULL);
 }
 
 
@@ -2616,7 +4370,17 @@ static void document_load_config(GeanyDocument *doc, GeanyFiletype *type,
 		if (type->id != GEANY_FILETYPES_NONE)
 			symbols_global_tags_loaded(type->id);
 
-		highlighting_set_styles(doc->editor->sci, type);
+		if (main_status.opening_session_files)
+		{	/* applying the full style set is a large batch of Scintilla calls per
+			 * widget; defer it for restored tabs until they are first drawn, the
+			 * same way colourising is deferred */
+			doc->priv->highlighting_needed = TRUE;
+		}
+		else
+		{
+			doc->priv->highlighting_needed = FALSE;
+			highlighting_set_styles(doc->editor->sci, type);
+		}
 		editor_set_indentation_guides(doc->editor);
 		build_menu_update(doc);
 		queue_colourise(doc);
@@ -2697,6 +4461,140 @@ void document_set_encoding(GeanyDocument *doc, const gchar *new_encoding)
 }
 
 
+/* --- persistent undo history ---
+ *
+ * Opt-in via the "persist_undo_history" hidden pref: the Scintilla undo
+ * history is serialized into a sidecar file below the user config dir, keyed
+ * by a hash of the buffer contents, and restored when a file with identical
+ * contents is opened again.  Keying by content means a restored history can
+ * only ever be applied to the exact buffer state it was recorded against. */
+
+#define UNDO_HISTORY_SUBDIR "undo"
+/* serialized histories larger than this are not persisted */
+#define UNDO_HISTORY_MAX_SIZE (4 * 1024 * 1024)
+/* sidecar files untouched for this long are removed */
+#define UNDO_HISTORY_MAX_AGE (30 * 24 * 3600)
+
+
+static gchar *undo_history_filename(GeanyDocument *doc)
+{
+	const gchar *text = (const gchar *) scintilla_send_message(doc->editor->sci,
+		SCI_GETCHARACTERPOINTER, 0, 0);
+	gchar *hash = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+		(const guchar *) text, sci_get_length(doc->editor->sci));
+	gchar *base = g_strconcat(hash, ".undo", NULL);
+	gchar *filename = g_build_filename(app->configdir, UNDO_HISTORY_SUBDIR, base, NULL);
+
+	g_free(hash);
+	g_free(base);
+	return filename;
+}
+
+
+/* removes sidecar files whose buffer contents have not been seen for a long
+ * time; run once per session, when the first history is written */
+static void undo_history_prune(const gchar *dir)
+{
+	static gboolean pruned = FALSE;
+	GDir *gdir;
+	const gchar *name;
+	time_t now = time(NULL);
+
+	if (pruned)
+		return;
+	pruned = TRUE;
+
+	gdir = g_dir_open(dir, 0, NULL);
+	if (gdir == NULL)
+		return;
+	while ((name = g_dir_read_name(gdir)) != NULL)
+	{
+		gchar *filename = g_build_filename(dir, name, NULL);
+		struct stat st;
+
+		if (g_stat(filename, &st) == 0 && (now - st.st_mtime) > UNDO_HISTORY_MAX_AGE)
+			g_unlink(filename);
+		g_free(filename);
+	}
+	g_dir_close(gdir);
+}
+
+
+/* Serializes the Scintilla undo history into the sidecar keyed by the current
+ * buffer contents.  Callers ensure this runs at a point where re-opening the
+ * same contents makes sense (after a save, or when closing an unmodified
+ * document). */
+static void document_save_undo_history(GeanyDocument *doc)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	gint len;
+	gchar *buf, *filename, *dir;
+
+	if (! file_prefs.persist_undo || doc->real_path == NULL)
+		return;
+	if (! sci_can_undo(sci) && ! sci_can_redo(sci))
+		return;
+
+	len = (gint) scintilla_send_message(sci, SCI_SERIALIZEUNDO, 0, 0);
+	if (len <= 0 || len > UNDO_HISTORY_MAX_SIZE)
+		return;
+	buf = g_malloc(len);
+	if ((gint) scintilla_send_message(sci, SCI_SERIALIZEUNDO, len, (sptr_t) buf) != len)
+	{
+		g_free(buf);
+		return;
+	}
+
+	filename = undo_history_filename(doc);
+	dir = g_path_get_dirname(filename);
+	if (utils_mkdir(dir, TRUE) == 0)
+	{
+		g_file_set_contents(filename, buf, len, NULL);
+		undo_history_prune(dir);
+	}
+	g_free(dir);
+	g_free(filename);
+	g_free(buf);
+}
+
+
+/* Restores a previously persisted undo history matching the just loaded
+ * buffer contents, if one exists. */
+static void document_restore_undo_history(GeanyDocument *doc)
+{
+	gchar *filename, *contents = NULL;
+	gsize len = 0;
+
+	if (! file_prefs.persist_undo || doc->real_path == NULL)
+		return;
+
+	filename = undo_history_filename(doc);
+	if (g_file_get_contents(filename, &contents, &len, NULL))
+	{
+		gint steps = (gint) scintilla_send_message(doc->editor->sci,
+			SCI_DESERIALIZEUNDO, len, (sptr_t) contents);
+		gint i;
+
+		/* mirror the restored steps on our own undo stack, as the
+		 * SC_STARTACTION notifications did while they were recorded */
+		for (i = 0; i < steps; i++)
+		{
+			undo_action *action = g_new0(undo_action, 1);
+
+			action->type = UNDO_SCINTILLA;
+			g_trash_stack_push(&doc->priv->undo_actions, action);
+		}
+		if (steps > 0)
+		{
+			geany_debug("Restored %d undo steps for %s", steps, DOC_FILENAME(doc));
+			ui_update_popup_reundo_items(doc);
+		}
+	}
+	g_free(contents);
+	g_free(filename);
+}
+
+
 /* own Undo / Redo implementation to be able to undo / redo changes
  * to the encoding or the Unicode BOM (which are Scintilla independet).
  * All Scintilla events are stored in the undo / redo buffer and are passed through. */
@@ -2951,11 +4849,7 @@ static gint document_get_status_id(GeanyDocument *doc)
 {
 	if (doc->changed)
 		return STATUS_CHANGED;
-#ifdef USE_GIO_FILEMON
-	else if (doc->priv->file_disk_status == FILE_CHANGED)
-#else
-	else if (doc->priv->protected)
-#endif
+	else if (doc->priv->file_disk_status == FILE_CHANGED || doc->priv->protected)
 		return STATUS_DISK_CHANGED;
 	else if (doc->readonly)
 		return STATUS_READONLY;
@@ -3050,6 +4944,138 @@ GeanyDocument *document_index(gint idx)
 }
 
 
+/* Splits a clone pair: the copy side view gets its own Scintilla document holding a
+ * snapshot of the shared buffer, the other side keeps the shared document. Afterwards
+ * both sides are independent and writable again. */
+static void clone_pair_split(GeanyDocument *doc)
+{
+	GeanyDocument *partner = doc->priv->clone_partner;
+	GeanyDocument *copy_doc, *keep_doc;
+	ScintillaObject *copy_sci, *keep_sci;
+	gchar *snapshot = NULL;
+	gint snapshot_len = 0;
+	gint eol_mode;
+
+	g_return_if_fail(partner != NULL);
+
+	copy_doc = doc->priv->clone_copy_side ? doc : partner;
+	keep_doc = (copy_doc == doc) ? partner : doc;
+	copy_sci = copy_doc->editor->sci;
+	keep_sci = keep_doc->editor->sci;
+
+	doc->priv->clone_partner = NULL;
+	partner->priv->clone_partner = NULL;
+	if (doc->priv->clone_split_source != 0)
+	{
+		g_source_remove(doc->priv->clone_split_source);
+		doc->priv->clone_split_source = 0;
+	}
+	if (partner->priv->clone_split_source != 0)
+	{
+		g_source_remove(partner->priv->clone_split_source);
+		partner->priv->clone_split_source = 0;
+	}
+	/* collect the snapshot taken on the modification attempt, if any */
+	if (doc->priv->clone_split_snapshot != NULL)
+	{
+		snapshot = doc->priv->clone_split_snapshot;
+		snapshot_len = doc->priv->clone_split_snapshot_len;
+		doc->priv->clone_split_snapshot = NULL;
+	}
+	else if (partner->priv->clone_split_snapshot != NULL)
+	{
+		snapshot = partner->priv->clone_split_snapshot;
+		snapshot_len = partner->priv->clone_split_snapshot_len;
+		partner->priv->clone_split_snapshot = NULL;
+	}
+
+	/* drop the share guard (read-only lives in the still shared buffer) */
+	scintilla_send_message(keep_sci, SCI_SETREADONLY, FALSE, 0);
+	eol_mode = sci_get_eol_mode(keep_sci);
+
+	/* give the copy side a fresh document */
+	scintilla_send_message(copy_sci, SCI_SETDOCPOINTER, 0, 0);
+	if (snapshot != NULL)
+	{
+		/* the shared buffer became writable on the modification attempt and
+		 * already contains edits meant for the keep side only; the copy side
+		 * gets the contents captured before they landed */
+		scintilla_send_message(copy_sci, SCI_ADDTEXT, (uptr_t) snapshot_len,
+			(sptr_t) snapshot);
+		g_free(snapshot);
+	}
+	else
+	{	/* no edit happened: fill straight from the shared buffer's contiguous
+		 * pointer, avoiding an intermediate copy */
+		scintilla_send_message(copy_sci, SCI_ADDTEXT, (uptr_t) sci_get_length(keep_sci),
+			scintilla_send_message(keep_sci, SCI_GETCHARACTERPOINTER, 0, 0));
+	}
+	sci_set_eol_mode(copy_sci, eol_mode);
+	sci_empty_undo_buffer(copy_sci);
+	sci_set_savepoint(copy_sci);
+
+	/* document pointer swaps reset per document state on the copy side */
+	if (copy_doc->file_type != NULL)
+		highlighting_set_styles(copy_sci, copy_doc->file_type);
+	queue_colourise(copy_doc);
+
+	sci_set_readonly(copy_sci, copy_doc->readonly);
+	sci_set_readonly(keep_sci, keep_doc->readonly);
+	document_set_text_changed(copy_doc, copy_doc->changed);
+	document_set_text_changed(keep_doc, keep_doc->changed);
+}
+
+
+static gboolean clone_split_idle(gpointer data)
+{
+	GeanyDocument *doc = data;
+
+	if (DOC_VALID(doc) && doc->priv->clone_partner != NULL)
+	{
+		doc->priv->clone_split_source = 0;
+		clone_pair_split(doc);
+	}
+	return FALSE;
+}
+
+
+/* Called from the SCN_MODIFYATTEMPTRO handler: a modification was attempted on the
+ * shared buffer of a clone pair. The buffer is made writable right here, so when
+ * Scintilla re-checks the read-only flag after this notification the blocked
+ * keystroke, IM commit or paste goes through instead of being dropped. The rest of
+ * the split cannot run inside the notification (SCI_SETDOCPOINTER unregisters a
+ * watcher of the document currently dispatching it), so the pre-edit contents are
+ * captured now and an idle callback detaches the copy side from them.
+ * Returns TRUE when the document belongs to a clone pair. */
+gboolean document_clone_modify_attempt(GeanyDocument *doc)
+{
+	g_return_val_if_fail(doc != NULL, FALSE);
+
+	if (doc->priv->clone_partner == NULL)
+		return FALSE;
+	if (doc->priv->clone_split_source == 0 &&
+		doc->priv->clone_partner->priv->clone_split_source == 0)
+	{
+		GeanyDocument *current = document_get_current();
+
+		/* the pending modification happens in the focused view: that side keeps
+		 * the shared document so the edit lands where the user typed, the other
+		 * side gets the snapshot (the notification reaches both views, so doc
+		 * is not necessarily the edited one) */
+		if (current == doc || current == doc->priv->clone_partner)
+		{
+			current->priv->clone_copy_side = FALSE;
+			current->priv->clone_partner->priv->clone_copy_side = TRUE;
+		}
+		doc->priv->clone_split_snapshot = sci_get_contents(doc->editor->sci, -1);
+		doc->priv->clone_split_snapshot_len = sci_get_length(doc->editor->sci);
+		scintilla_send_message(doc->editor->sci, SCI_SETREADONLY, FALSE, 0);
+		doc->priv->clone_split_source = g_idle_add(clone_split_idle, doc);
+	}
+	return TRUE;
+}
+
+
 GeanyDocument *document_clone(GeanyDocument *old_doc)
 {
 	gchar *text;
@@ -3058,13 +5084,38 @@ GeanyDocument *document_clone(GeanyDocument *old_doc)
 
 	g_return_val_if_fail(old_doc, NULL);
 	old_sci = old_doc->editor->sci;
-	if (sci_has_selection(old_sci))
-		text = sci_get_selection_contents(old_sci);
+
+	if (! sci_has_selection(old_sci) && old_doc->priv->clone_partner == NULL)
+	{
+		/* share the underlying Scintilla document instead of copying it, so cloning
+		 * a huge buffer is instant and costs no memory until one side is edited.
+		 * The shared buffer is made read-only; the first modification attempt on
+		 * either side splits the pair (see document_clone_modify_attempt()) */
+		doc = document_new_file(NULL, old_doc->file_type, NULL);
+		scintilla_send_message(doc->editor->sci, SCI_SETDOCPOINTER, 0,
+			scintilla_send_message(old_sci, SCI_GETDOCPOINTER, 0, 0));
+		if (doc->file_type != NULL)
+			highlighting_set_styles(doc->editor->sci, doc->file_type);
+		queue_colourise(doc);
+		doc->priv->line_count = sci_get_line_count(doc->editor->sci);
+		sci_set_line_numbers(doc->editor->sci, editor_prefs.show_linenumber_margin);
+
+		doc->priv->clone_partner = old_doc;
+		doc->priv->clone_copy_side = TRUE;
+		old_doc->priv->clone_partner = doc;
+		old_doc->priv->clone_copy_side = FALSE;
+		scintilla_send_message(old_sci, SCI_SETREADONLY, TRUE, 0);
+	}
 	else
-		text = sci_get_contents(old_sci, -1);
+	{
+		if (sci_has_selection(old_sci))
+			text = sci_get_selection_contents(old_sci);
+		else
+			text = sci_get_contents(old_sci, -1);
 
-	doc = document_new_file(NULL, old_doc->file_type, text);
-	g_free(text);
+		doc = document_new_file(NULL, old_doc->file_type, text);
+		g_free(text);
+	}
 	document_set_text_changed(doc, TRUE);
 
 	/* copy file properties */
@@ -3127,12 +5178,19 @@ static void force_close_all(void)
 		}
 	}
 	main_status.closing_all = TRUE;
+	closing_tm_files = g_ptr_array_new();
 
 	foreach_document(i)
 	{
 		document_close(documents[i]);
 	}
 
+	/* one workspace update instead of a tag array re-sort per closed file */
+	tm_workspace_remove_source_files(closing_tm_files);
+	g_ptr_array_foreach(closing_tm_files, (GFunc) tm_source_file_free, NULL);
+	g_ptr_array_free(closing_tm_files, TRUE);
+	closing_tm_files = NULL;
+
 	main_status.closing_all = FALSE;
 }
 
@@ -3329,6 +5387,53 @@ static void enable_key_intercept(GeanyDocument *doc, GtkWidget *bar)
 }
 
 
+static void on_readonly_view_response(GtkWidget *bar, gint response_id, GeanyDocument *doc)
+{
+	doc->priv->info_bars[MSG_TYPE_READONLY_VIEW] = NULL;
+
+	if (response_id == GTK_RESPONSE_ACCEPT)
+	{
+		doc->priv->readonly_view = FALSE;
+		doc->readonly = FALSE;
+		sci_set_readonly(doc->editor->sci, FALSE);
+		ui_update_tab_status(doc);
+		ui_update_statusbar(doc, -1);
+	}
+	gtk_widget_destroy(bar);
+}
+
+
+/* Called from the SCN_MODIFYATTEMPTRO handler: a modification was attempted on a
+ * document opened read-only for viewing because of its size. Offers making the
+ * document editable; the attempted keystroke is discarded like any edit in a
+ * read-only buffer. Returns TRUE when the document is such a viewer. */
+gboolean document_readonly_view_modify_attempt(GeanyDocument *doc)
+{
+	g_return_val_if_fail(doc != NULL, FALSE);
+
+	if (! doc->priv->readonly_view)
+		return FALSE;
+	if (doc->priv->info_bars[MSG_TYPE_READONLY_VIEW] == NULL)
+	{
+		gchar *base_name = g_path_get_basename(DOC_FILENAME(doc));
+		GtkWidget *bar;
+
+		bar = document_show_message(doc, GTK_MESSAGE_QUESTION, on_readonly_view_response,
+				_("Enable _Editing"), GTK_RESPONSE_ACCEPT,
+				GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+				NULL, 0,
+				_("Editing very large files can make the editor considerably slower."),
+				_("The file '%s' was opened read-only for viewing because of its size. Do you want to make it editable?"),
+				base_name);
+
+		doc->priv->info_bars[MSG_TYPE_READONLY_VIEW] = bar;
+		enable_key_intercept(doc, bar);
+		g_free(base_name);
+	}
+	return TRUE;
+}
+
+
 static void monitor_reload_file(GeanyDocument *doc)
 {
 	gchar *base_name = g_path_get_basename(doc->file_name);
@@ -3400,6 +5505,7 @@ static void monitor_resave_missing_file(GeanyDocument *doc)
 		document_set_text_changed(doc, TRUE);
 		/* don't prompt more than once */
 		SETPTR(doc->real_path, NULL);
+		document_index_update();
 		doc->priv->info_bars[MSG_TYPE_RESAVE] = bar;
 		enable_key_intercept(doc, bar);
 	}
@@ -3456,11 +5562,18 @@ gboolean document_check_disk_status(GeanyDocument *doc, gboolean force)
 	}
 	else if (doc->priv->mtime < st.st_mtime)
 	{
-		/* make sure the user is not prompted again after he cancelled the "reload file?" message */
-		doc->priv->mtime = st.st_mtime;
-		monitor_reload_file(doc);
-		/* doc may be closed now */
-		ret = TRUE;
+		if (document_append_tail(doc, locale_filename, &st))
+		{	/* the file only grew and the new tail has been appended already */
+			ret = FALSE;
+		}
+		else
+		{
+			/* make sure the user is not prompted again after he cancelled the "reload file?" message */
+			doc->priv->mtime = st.st_mtime;
+			monitor_reload_file(doc);
+			/* doc may be closed now */
+			ret = TRUE;
+		}
 	}
 	g_free(locale_filename);
 
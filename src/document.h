@@ -44,6 +44,14 @@
 G_BEGIN_DECLS
 
 /** File Prefs. */
+/* available values of GeanyFilePrefs::save_fsync_policy */
+enum
+{
+	GEANY_FSYNC_ALWAYS = 0,	/* flush every saved file to disk */
+	GEANY_FSYNC_ON_CLOSE,	/* flush only the saves performed while quitting */
+	GEANY_FSYNC_NEVER
+};
+
 typedef struct GeanyFilePrefs
 {
 	gint			default_new_encoding;
@@ -64,6 +72,13 @@ typedef struct GeanyFilePrefs
 	gboolean		use_gio_unsafe_file_saving; /* whether to use GIO as the unsafe backend */
 	gchar			*extract_filetype_regex;	/* regex to extract filetype on opening */
 	gboolean		tab_close_switch_to_mru;
+	gint			large_file_size;	/* file size in MB from which large file mode is
+										 * enabled, 0 to disable it */
+	gint			save_fsync_policy;	/* one of the GEANY_FSYNC_* values */
+	gboolean		use_async_file_saving;	/* hand regular saves to the worker pool */
+	gint			max_memory_usage;	/* resident memory in MB above which caches of
+										 * background documents are dropped, 0 to disable */
+	gboolean		persist_undo;		/* persist undo histories across sessions */
 }
 GeanyFilePrefs;
 
@@ -237,6 +252,8 @@ GeanyDocument* document_new_file_if_non_open(void);
 
 gboolean document_reload_prompt(GeanyDocument *doc, const gchar *forced_enc);
 
+guint document_reload_all_changed(void);
+
 void document_reload_config(GeanyDocument *doc);
 
 GeanyDocument *document_find_by_sci(ScintillaObject *sci);
@@ -247,15 +264,25 @@ void document_init_doclist(void);
 
 void document_finalize(void);
 
+gchar *document_memory_report(void);
+
 void document_try_focus(GeanyDocument *doc, GtkWidget *source_widget);
 
 gboolean document_account_for_unsaved(void);
 
 gboolean document_close_all(void);
 
+void document_save_all(void);
+
+void document_wait_for_saves(void);
+
 GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename, gint pos,
 		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc);
 
+void document_open_batch_begin(void);
+
+void document_open_batch_end(void);
+
 void document_open_file_list(const gchar *data, gsize length);
 
 gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolean inc,
@@ -278,6 +305,8 @@ void document_update_tags(GeanyDocument *doc);
 
 void document_update_tag_list_in_idle(GeanyDocument *doc);
 
+void document_update_tag_list_on_scope_exit(GeanyDocument *doc);
+
 void document_highlight_tags(GeanyDocument *doc);
 
 gboolean document_check_disk_status(GeanyDocument *doc, gboolean force);
@@ -312,6 +341,10 @@ void document_grab_focus(GeanyDocument *doc);
 
 GeanyDocument *document_clone(GeanyDocument *old_doc);
 
+gboolean document_clone_modify_attempt(GeanyDocument *doc);
+
+gboolean document_readonly_view_modify_attempt(GeanyDocument *doc);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -57,6 +57,7 @@ enum
 {
 	MSG_TYPE_RELOAD,
 	MSG_TYPE_RESAVE,
+	MSG_TYPE_READONLY_VIEW,
 
 	NUM_MSG_TYPES
 };
@@ -79,6 +80,10 @@ typedef struct GeanyDocumentPrivate
 	/* Used so Undo/Redo works for encoding changes. */
 	FileEncoding	 saved_encoding;
 	gboolean		 colourise_needed;	/* use document.c:queue_colourise() instead */
+	gboolean		 highlighting_needed;	/* apply filetype styles before first draw
+											 * (deferred during session restore) */
+	gboolean		 font_needed;		/* apply the editor font before the next draw
+										 * (deferred for background tabs on font change) */
 	gint			 line_count;		/* Number of lines in the document. */
 	gint			 symbol_list_sort_mode;
 	/* indicates whether a file is on a remote filesystem, works only with GIO/GVfs */
@@ -91,13 +96,74 @@ typedef struct GeanyDocumentPrivate
 	time_t			 last_check;
 	/* Modification time of the document on disk, only used when legacy file monitoring is used. */
 	time_t			 mtime;
+	/* On-disk size of the file as last loaded or saved, used to detect append-only
+	 * growth (e.g. followed build logs), see document.c:document_append_tail() */
+	goffset			 disk_size;
+	/* Counts every text insertion and deletion (see editor.c:SCN_MODIFIED);
+	 * asynchronous saves compare it against the value captured when the
+	 * buffer was snapshotted to detect edits made while the write was in
+	 * flight, see document.c:save_all_finish_idle() */
+	guint			 edit_count;
 	/* ID of the idle callback updating the tag list */
 	guint			 tag_list_update_source;
+	/* Buffer modification counter and its value when the last reparse was
+	 * requested; a scheduled reparse is skipped when they are equal (e.g.
+	 * the document was already parsed on save), see document.c */
+	guint			 tag_mod_count;
+	guint			 tag_parsed_mod_count;
+	/* Exponential backoff level of the reparse timer while edits keep
+	 * arriving, and the time of the last modification driving it, see
+	 * document_update_tag_list_in_idle() */
+	guint			 tag_backoff;
+	GTimeVal		 tag_last_mod_time;
+	/* Snapshot of the tags currently shown in the symbol tree, used to skip
+	 * updates when a reparse produced an identical tag list. */
+	GPtrArray		*displayed_tags;
+	/* Both sort orders of the displayed tags as tag-to-rank tables, computed
+	 * once per parse result so the sidebar sort toggle only compares cached
+	 * ranks, see symbols.c:update_sort_ranks() */
+	GHashTable		*sort_rank_name;
+	GHashTable		*sort_rank_appearance;
+	/* Background loader of a large file, see document.c:document_start_background_load() */
+	gpointer		 file_load;
+	/* Whether the file exceeded file_prefs.large_file_size on opening; expensive
+	 * per-keystroke features are disabled then */
+	gboolean		 is_large_file;
+	/* Whether the document was opened read-only for viewing because of its size; the
+	 * first modification attempt offers making it editable, see
+	 * document.c:document_readonly_view_modify_attempt() */
+	gboolean		 readonly_view;
 	/* Whether it's temporarily protected (read-only and saving needs confirmation). Does
 	 * not imply doc->readonly as writable files can be protected */
 	gint			 protected;
 	/* Save pointer to info bars allowing to cancel them programatically (to avoid multiple ones) */
 	GtkWidget		*info_bars[NUM_MSG_TYPES];
+	/* The other document sharing this document's Scintilla buffer after a clone, until
+	 * the first modification splits the pair, see document.c:document_clone() */
+	struct GeanyDocument	*clone_partner;
+	/* Which side of a clone pair receives its own buffer copy on the split */
+	gboolean		 clone_copy_side;
+	/* Pending idle callback performing the clone split */
+	guint			 clone_split_source;
+	/* Buffer contents captured when the first modification attempt made the
+	 * shared buffer writable again, so the deferred split can give the copy
+	 * side the text without that edit, see document.c:clone_pair_split() */
+	gchar			*clone_split_snapshot;
+	gint			 clone_split_snapshot_len;
+	/* Last query marked by search_mark_all(), NULL when nothing is marked.
+	 * Together with the damage range below it allows re-marking only the
+	 * edited part of the buffer, see search.c:search_mark_all() */
+	gchar			*mark_all_text;
+	gint			 mark_all_flags;
+	gint			 mark_all_count;
+	/* Byte range modified since the last marking pass (-1 = unmodified) */
+	gint			 mark_all_dmin;
+	gint			 mark_all_dmax;
+	/* Word completion index mapping each word in the buffer to its number of
+	 * occurrences, see editor.c:word_index_rebuild(). NULL until first built */
+	GHashTable		*word_index;
+	/* ID of the debounced callback rebuilding the word index after edits */
+	guint			 word_index_source;
 }
 GeanyDocumentPrivate;
 
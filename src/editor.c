@@ -50,7 +50,12 @@
 #include "main.h"
 #include "prefs.h"
 #include "projectprivate.h"
+#ifdef HAVE_PLUGINS
+# include "pluginutils.h"
+#endif
+#include "respack.h"
 #include "sciwrappers.h"
+#include "stats.h"
 #include "support.h"
 #include "symbols.h"
 #include "templates.h"
@@ -94,7 +99,11 @@ static struct
 	guint tag_index;
 	gint pos;
 	ScintillaObject *sci;
-} calltip = {NULL, FALSE, NULL, 0, 0, NULL};
+	/* deferred resolution triggered by typing '(', see show_calltip_idle() */
+	GeanyEditor *pending_editor;
+	gint pending_pos;
+	guint pending_source;
+} calltip = {NULL, FALSE, NULL, 0, 0, NULL, NULL, 0, 0};
 
 static gchar indent[100];
 
@@ -108,22 +117,80 @@ static void close_block(GeanyEditor *editor, gint pos);
 static void editor_highlight_braces(GeanyEditor *editor, gint cur_pos);
 static void read_current_word(GeanyEditor *editor, gint pos, gchar *word, gsize wordlen,
 		const gchar *wc, gboolean stem);
-static gsize count_indent_size(GeanyEditor *editor, const gchar *base_indent);
+static gsize count_indent_size(GeanyEditor *editor, const gchar *base_indent, gint length);
 static const gchar *snippets_find_completion_by_name(const gchar *type, const gchar *name);
 static void snippets_make_replacements(GeanyEditor *editor, GString *pattern);
 static gssize replace_cursor_markers(GeanyEditor *editor, GString *pattern);
 static GeanyFiletype *editor_get_filetype_at_line(GeanyEditor *editor, gint line);
 static gboolean sci_is_blank_line(ScintillaObject *sci, gint line);
+static void word_index_schedule_update(GeanyDocument *doc);
+static GPtrArray *get_indexed_words(GeanyDocument *doc, const gchar *root, gsize rootlen,
+		GHashTable *exclude);
+
+
+/* Flattened per-filetype snippet tables with the [Default] fallback chain
+ * resolved at build time, so the per-Tab-press lookup is a single hash probe.
+ * Keys and values are borrowed from snippet_hash. Built lazily per filetype. */
+static GHashTable **snippet_ft_tables = NULL;
+static guint snippet_ft_tables_len = 0;
+/* [Special] wordchars resolved once at load time for the Tab press path */
+static const gchar *snippet_wordchars = NULL;
 
 
 void editor_snippets_free(void)
 {
+	guint i;
+
+	for (i = 0; i < snippet_ft_tables_len; i++)
+	{
+		if (snippet_ft_tables[i] != NULL)
+			g_hash_table_destroy(snippet_ft_tables[i]);
+	}
+	g_free(snippet_ft_tables);
+	snippet_ft_tables = NULL;
+	snippet_ft_tables_len = 0;
+	snippet_wordchars = NULL;
+
 	g_hash_table_destroy(snippet_hash);
 	g_queue_free(snippet_offsets);
 	gtk_window_remove_accel_group(GTK_WINDOW(main_widgets.window), snippet_accel_group);
 }
 
 
+static void snippet_table_copy_entry(gpointer key, gpointer value, gpointer data)
+{
+	g_hash_table_replace(data, key, value);
+}
+
+
+/* Single-probe lookup in the flattened table of @a ft_id; equivalent to
+ * snippets_find_completion_by_name(filetypes[ft_id]->name, name). */
+static const gchar *snippets_lookup(guint ft_id, const gchar *name)
+{
+	GHashTable *table;
+
+	if (G_UNLIKELY(snippet_ft_tables == NULL || ft_id >= snippet_ft_tables_len))
+		return snippets_find_completion_by_name(filetypes[ft_id]->name, name);
+
+	table = snippet_ft_tables[ft_id];
+	if (G_UNLIKELY(table == NULL))
+	{
+		GHashTable *group;
+
+		/* flatten [Default] overlaid by the filetype's own group */
+		table = g_hash_table_new(g_str_hash, g_str_equal);
+		group = g_hash_table_lookup(snippet_hash, "Default");
+		if (group != NULL)
+			g_hash_table_foreach(group, snippet_table_copy_entry, table);
+		group = g_hash_table_lookup(snippet_hash, filetypes[ft_id]->name);
+		if (group != NULL)
+			g_hash_table_foreach(group, snippet_table_copy_entry, table);
+		snippet_ft_tables[ft_id] = table;
+	}
+	return g_hash_table_lookup(table, name);
+}
+
+
 static void snippets_load(GKeyFile *sysconfig, GKeyFile *userconfig)
 {
 	gsize i, j, len = 0, len_keys = 0;
@@ -279,11 +346,16 @@ void editor_snippets_init(void)
 		SETPTR(userconfigfile, g_build_filename(app->configdir, "autocomplete.conf", NULL));
 
 	/* load the actual config files */
-	g_key_file_load_from_file(sysconfig, sysconfigfile, G_KEY_FILE_NONE, NULL);
+	respack_load_key_file(sysconfig, sysconfigfile, G_KEY_FILE_NONE, NULL);
 	g_key_file_load_from_file(userconfig, userconfigfile, G_KEY_FILE_NONE, NULL);
 
 	snippets_load(sysconfig, userconfig);
 
+	/* the flattened per-filetype tables are built lazily on first lookup */
+	snippet_ft_tables_len = filetypes_array->len;
+	snippet_ft_tables = g_new0(GHashTable*, snippet_ft_tables_len);
+	snippet_wordchars = snippets_find_completion_by_name("Special", "wordchars");
+
 	/* setup snippet keybindings */
 	snippet_accel_group = gtk_accel_group_new();
 	gtk_window_add_accel_group(GTK_WINDOW(main_widgets.window), snippet_accel_group);
@@ -598,7 +670,145 @@ static void check_line_breaking(GeanyEditor *editor, gint pos)
 }
 
 
-static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words)
+/* Completion usage statistics: every accepted completion bumps a per-symbol
+ * score which pushes the symbol towards the top of subsequent candidate lists.
+ * The scores are stored in the project file ("completion_usage" group) and are
+ * halved on each load, so symbols that stop being used sink back down. */
+#define COMPLETION_USAGE_GROUP "completion_usage"
+#define COMPLETION_USAGE_BUMP 8
+
+static GHashTable *completion_usage = NULL;	/* symbol name -> usage score */
+
+
+static guint completion_usage_score(const gchar *name)
+{
+	if (completion_usage == NULL)
+		return 0;
+	return GPOINTER_TO_UINT(g_hash_table_lookup(completion_usage, name));
+}
+
+
+static void completion_usage_accept(const gchar *text)
+{
+	gchar *name, *sep;
+	guint score;
+
+	if (completion_usage == NULL)
+		completion_usage = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	name = g_strdup(text);
+	/* strip a type marker in case the selection text carries one */
+	sep = strchr(name, '?');
+	if (sep != NULL)
+		*sep = '\0';
+	score = GPOINTER_TO_UINT(g_hash_table_lookup(completion_usage, name));
+	g_hash_table_insert(completion_usage, name, GUINT_TO_POINTER(score + COMPLETION_USAGE_BUMP));
+}
+
+
+static gint completion_usage_cmp(gconstpointer a, gconstpointer b)
+{
+	const TMTag *tag_a = *(TMTag * const *) a;
+	const TMTag *tag_b = *(TMTag * const *) b;
+	guint score_a = completion_usage_score(tag_a->name);
+	guint score_b = completion_usage_score(tag_b->name);
+
+	if (score_a != score_b)
+		return (score_a > score_b) ? -1 : 1;
+	return strcmp(tag_a->name, tag_b->name);
+}
+
+
+/* Reorders the candidates so that symbols whose completions were accepted
+ * before come first. Returns NULL when no candidate has a score, in which case
+ * the alphabetical list can be shown presorted. */
+static GPtrArray *completion_usage_rank(const GPtrArray *tags)
+{
+	GPtrArray *ranked;
+	guint i, scored = 0;
+
+	if (completion_usage == NULL)
+		return NULL;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+
+		if (completion_usage_score(tag->name) > 0)
+			scored++;
+	}
+	if (scored == 0)
+		return NULL;
+
+	ranked = g_ptr_array_sized_new(tags->len);
+	for (i = 0; i < tags->len; i++)
+	{	/* used symbols first, ordered by score */
+		TMTag *tag = tags->pdata[i];
+
+		if (completion_usage_score(tag->name) > 0)
+			g_ptr_array_add(ranked, tag);
+	}
+	g_ptr_array_sort(ranked, completion_usage_cmp);
+	for (i = 0; i < tags->len; i++)
+	{	/* then the rest, still alphabetical */
+		TMTag *tag = tags->pdata[i];
+
+		if (completion_usage_score(tag->name) == 0)
+			g_ptr_array_add(ranked, tag);
+	}
+	return ranked;
+}
+
+
+void editor_completion_stats_load(GKeyFile *config)
+{
+	gchar **names;
+	gsize len, i;
+
+	editor_completion_stats_reset();
+	names = g_key_file_get_keys(config, COMPLETION_USAGE_GROUP, &len, NULL);
+	if (names == NULL)
+		return;
+
+	completion_usage = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; i < len; i++)
+	{
+		/* halve stored scores so symbols decay when they stop being used */
+		gint score = g_key_file_get_integer(config, COMPLETION_USAGE_GROUP, names[i], NULL) / 2;
+
+		if (score > 0)
+			g_hash_table_insert(completion_usage, g_strdup(names[i]), GUINT_TO_POINTER(score));
+	}
+	g_strfreev(names);
+}
+
+
+void editor_completion_stats_save(GKeyFile *config)
+{
+	GHashTableIter iter;
+	gpointer name, score;
+
+	g_key_file_remove_group(config, COMPLETION_USAGE_GROUP, NULL);
+	if (completion_usage == NULL)
+		return;
+
+	g_hash_table_iter_init(&iter, completion_usage);
+	while (g_hash_table_iter_next(&iter, &name, &score))
+		g_key_file_set_integer(config, COMPLETION_USAGE_GROUP, name, GPOINTER_TO_UINT(score));
+}
+
+
+void editor_completion_stats_reset(void)
+{
+	if (completion_usage != NULL)
+	{
+		g_hash_table_destroy(completion_usage);
+		completion_usage = NULL;
+	}
+}
+
+
+static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words, gint order)
 {
 	/* hide autocompletion if only option is already typed */
 	if (rootlen >= words->len ||
@@ -609,11 +819,15 @@ static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *word
 	}
 	/* store whether a calltip is showing, so we can reshow it after autocompletion */
 	calltip.set = (gboolean) SSM(sci, SCI_CALLTIPACTIVE, 0, 0);
+	SSM(sci, SCI_AUTOCSETORDER, order, 0);
 	SSM(sci, SCI_AUTOCSHOW, rootlen, (sptr_t) words->str);
 }
 
 
-static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen)
+/* @p root is the typed word start used to merge in further matching words from
+ * the document's word index, or NULL to show the tags alone */
+static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, const gchar *root,
+		gsize rootlen)
 {
 	ScintillaObject *sci = editor->sci;
 
@@ -623,6 +837,15 @@ static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize roo
 	{
 		GString *words = g_string_sized_new(150);
 		guint j;
+		guint n_words = 0;
+		gint order = SC_ORDER_PRESORTED;
+		GPtrArray *ranked_tags = completion_usage_rank(tags);
+
+		if (ranked_tags != NULL)
+		{	/* previously accepted symbols come first */
+			tags = ranked_tags;
+			order = SC_ORDER_CUSTOM;
+		}
 
 		for (j = 0; j < tags->len; ++j)
 		{
@@ -637,6 +860,7 @@ static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize roo
 				break;
 			}
 			g_string_append(words, tag->name);
+			n_words++;
 
 			/* for now, tag types don't all follow C, so just look at arglist */
 			if (!EMPTY(tag->arglist))
@@ -644,8 +868,43 @@ static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize roo
 			else
 				g_string_append(words, "?1");
 		}
-		show_autocomplete(sci, rootlen, words);
+
+		/* merge in other matching words from the document, most frequent first;
+		 * tag names stay on top of the list */
+		if (root != NULL && editor_prefs.autocomplete_doc_words &&
+			n_words < editor_prefs.autocompletion_max_entries)
+		{
+			GHashTable *exclude = g_hash_table_new(g_str_hash, g_str_equal);
+			GPtrArray *ranked;
+
+			for (j = 0; j < tags->len; ++j)
+			{
+				TMTag *tag = tags->pdata[j];
+				g_hash_table_insert(exclude, tag->name, tag->name);
+			}
+
+			ranked = get_indexed_words(editor->document, root, rootlen, exclude);
+			if (ranked == NULL)
+				word_index_schedule_update(editor->document);
+			else
+			{
+				for (j = 0; j < ranked->len && n_words < editor_prefs.autocompletion_max_entries;
+					j++, n_words++)
+				{
+					g_string_append_c(words, '\n');
+					g_string_append(words, ranked->pdata[j]);
+				}
+				if (j > 0)
+					order = SC_ORDER_CUSTOM;
+				g_ptr_array_free(ranked, TRUE);
+			}
+			g_hash_table_destroy(exclude);
+		}
+
+		show_autocomplete(sci, rootlen, words, order);
 		g_string_free(words, TRUE);
+		if (ranked_tags != NULL)
+			g_ptr_array_free(ranked_tags, TRUE);
 	}
 }
 
@@ -697,6 +956,32 @@ static void request_reshowing_calltip(SCNotification *nt)
 }
 
 
+/* Resolving a signature searches the whole workspace tag index, which is too slow to
+ * run while the keystroke that typed the '(' waits: the lookup is deferred to an idle
+ * callback so the character is inserted and drawn first and the tip pops right after */
+static gboolean show_calltip_idle(gpointer data)
+{
+	GeanyDocument *doc = document_get_current();
+
+	calltip.pending_source = 0;
+	/* the document may have been closed or switched since the keystroke; the stale
+	 * editor pointer is only compared, never dereferenced */
+	if (doc != NULL && doc->editor == calltip.pending_editor)
+		editor_show_calltip(doc->editor, calltip.pending_pos);
+	calltip.pending_editor = NULL;
+	return FALSE;
+}
+
+
+static void request_calltip(GeanyEditor *editor, gint pos)
+{
+	calltip.pending_editor = editor;
+	calltip.pending_pos = pos;
+	if (calltip.pending_source == 0)
+		calltip.pending_source = g_idle_add(show_calltip_idle, NULL);
+}
+
+
 static void autocomplete_scope(GeanyEditor *editor)
 {
 	ScintillaObject *sci = editor->sci;
@@ -740,7 +1025,7 @@ static void autocomplete_scope(GeanyEditor *editor)
 		tags = tm_workspace_find_scope_members(obj ? obj->tags_array : NULL,
 			name, TRUE, FALSE);
 		if (tags)
-			show_tags_list(editor, tags, 0);
+			show_tags_list(editor, tags, NULL, 0);
 	}
 }
 
@@ -774,8 +1059,8 @@ static void on_char_added(GeanyEditor *editor, SCNotification *nt)
 		case '(':
 		{
 			auto_close_chars(sci, pos, nt->ch);
-			/* show calltips */
-			editor_show_calltip(editor, --pos);
+			/* show calltips, resolved in an idle callback off the typing path */
+			request_calltip(editor, --pos);
 			break;
 		}
 		case ')':
@@ -784,6 +1069,14 @@ static void on_char_added(GeanyEditor *editor, SCNotification *nt)
 			{
 				SSM(sci, SCI_CALLTIPCANCEL, 0, 0);
 			}
+			/* drop a resolution still pending so the tip of a closed call cannot
+			 * pop after its ')' */
+			if (calltip.pending_source != 0)
+			{
+				g_source_remove(calltip.pending_source);
+				calltip.pending_source = 0;
+				calltip.pending_editor = NULL;
+			}
 			g_free(calltip.text);
 			calltip.text = NULL;
 			calltip.pos = 0;
@@ -803,6 +1096,9 @@ static void on_char_added(GeanyEditor *editor, SCNotification *nt)
 		{	/* closing bracket handling */
 			if (editor->auto_indent)
 				close_block(editor, pos - 1);
+			/* a closed scope usually leaves the code parsable, so don't wait
+			 * out the full (possibly backed off) reparse interval */
+			document_update_tag_list_on_scope_exit(editor->document);
 			break;
 		}
 		/* scope autocompletion */
@@ -1007,11 +1303,92 @@ void editor_sci_notify_cb(G_GNUC_UNUSED GtkWidget *widget, G_GNUC_UNUSED gint sc
 }
 
 
+/* --- typing latency governor ---
+ *
+ * Every Scintilla notification handled below sits on the keystroke-to-paint
+ * path, so its duration is measured against a fixed budget. When the budget is
+ * blown repeatedly, optional background work is shed step by step: first the
+ * background styling is restricted to the visible area and the symbol list
+ * reparse interval is widened (see document_update_tag_list_in_idle()), then
+ * automatic completion scans are skipped too. Once notifications stay well
+ * inside the budget again for a while, the features come back in reverse
+ * order. The current level is visible in the "editor.latency-shed" counter. */
+
+#define LATENCY_BUDGET 0.008		/* seconds per notification */
+#define LATENCY_SHED_AFTER 8		/* consecutive overruns before shedding more */
+#define LATENCY_RESTORE_AFTER 512	/* consecutive calm notifications before restoring */
+#define LATENCY_SHED_MAX 2
+
+static gint latency_shed_level = 0;
+static gint latency_overruns = 0;
+static gint latency_underruns = 0;
+
+
+gint editor_get_latency_shed_level(void)
+{
+	return latency_shed_level;
+}
+
+
+static void latency_apply_shed_level(void)
+{
+	guint i;
+
+	foreach_document(i)
+	{
+		/* level 0 restores the document-wide background styling set up in
+		 * create_new_sci() */
+		scintilla_send_message(documents[i]->editor->sci, SCI_SETIDLESTYLING,
+			latency_shed_level >= 1 ? SC_IDLESTYLING_TOVISIBLE : SC_IDLESTYLING_ALL, 0);
+	}
+}
+
+
+static void latency_track(const GTimeVal *start)
+{
+	GTimeVal now;
+	gdouble elapsed;
+
+	g_get_current_time(&now);
+	elapsed = (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+
+	if (elapsed > LATENCY_BUDGET)
+	{
+		latency_underruns = 0;
+		if (++latency_overruns >= LATENCY_SHED_AFTER && latency_shed_level < LATENCY_SHED_MAX)
+		{
+			latency_shed_level++;
+			latency_overruns = 0;
+			stats_count("editor.latency-shed", 1);
+			geany_debug("typing latency over budget, shedding load (level %d)",
+				latency_shed_level);
+			latency_apply_shed_level();
+		}
+	}
+	else if (elapsed < LATENCY_BUDGET / 2)
+	{
+		latency_overruns = 0;
+		if (++latency_underruns >= LATENCY_RESTORE_AFTER && latency_shed_level > 0)
+		{
+			latency_shed_level--;
+			latency_underruns = 0;
+			geany_debug("typing latency back in budget (level %d)", latency_shed_level);
+			latency_apply_shed_level();
+		}
+	}
+}
+
+
 static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *editor,
 								 SCNotification *nt, G_GNUC_UNUSED gpointer data)
 {
 	ScintillaObject *sci = editor->sci;
 	GeanyDocument *doc = editor->document;
+	GTimeVal start;
+
+	/* time spent here is part of every keystroke's latency, so it is worth a counter
+	 * (dump with SIGUSR2, see stats.c) */
+	g_get_current_time(&start);
 
 	switch (nt->nmhdr.code)
 	{
@@ -1024,7 +1401,12 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 			break;
 
 		case SCN_MODIFYATTEMPTRO:
-			utils_beep();
+			/* the read-only buffer may be the share guard of a clone pair, in which
+			 * case the attempt triggers the copy-on-write split instead of a beep;
+			 * a large file opened for viewing offers becoming editable instead */
+			if (! document_clone_modify_attempt(doc) &&
+				! document_readonly_view_modify_attempt(doc))
+				utils_beep();
 			break;
 
 		case SCN_MARGINCLICK:
@@ -1070,7 +1452,16 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 			}
 			if (nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
 			{
+				doc->priv->edit_count++;
 				document_update_tag_list_in_idle(doc);
+				search_mark_all_modified(doc, (gint) nt->position, (gint) nt->length,
+					(nt->modificationType & SC_MOD_INSERTTEXT) != 0);
+				if (doc->priv->word_index != NULL)
+					word_index_schedule_update(doc);
+#ifdef HAVE_PLUGINS
+				plugin_doc_journal_record(doc, (gint) nt->position, (gint) nt->length,
+					(gint) nt->modificationType, nt->text);
+#endif
 			}
 			break;
 
@@ -1092,6 +1483,7 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 				utils_beep();
 				break;
 			}
+			completion_usage_accept(nt->text);
 			/* fall through */
 		case SCN_AUTOCCANCELLED:
 			/* now that autocomplete is finishing or was cancelled, reshow calltips
@@ -1136,6 +1528,8 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 			sci_set_line_numbers(sci, editor_prefs.show_linenumber_margin);
 			break;
 	}
+	stats_time_since("editor.sci-notify", &start);
+	latency_track(&start);
 	/* we always return FALSE here to let plugins handle the event too */
 	return FALSE;
 }
@@ -1282,12 +1676,12 @@ static void read_indent(GeanyEditor *editor, gint pos)
 	ScintillaObject *sci = editor->sci;
 	guint i, len, j = 0;
 	gint line;
-	gchar *linebuf;
+	const gchar *linebuf;
 
 	line = sci_get_line_from_position(sci, pos);
 
 	len = sci_get_line_length(sci, line);
-	linebuf = sci_get_line(sci, line);
+	linebuf = sci_get_range_pointer(sci, sci_get_position_from_line(sci, line), len);
 
 	for (i = 0; i < len && j <= (sizeof(indent) - 1); i++)
 	{
@@ -1297,7 +1691,6 @@ static void read_indent(GeanyEditor *editor, gint pos)
 			break;
 	}
 	indent[j] = '\0';
-	g_free(linebuf);
 }
 
 
@@ -1380,7 +1773,9 @@ static gint get_xml_indent(ScintillaObject *sci, gint line)
 		if (style == SCE_H_TAG || style == SCE_H_TAGUNKNOWN)
 		{
 			gint start = sci_get_position_from_line(sci, line);
-			gchar *line_contents = sci_get_contents_range(sci, start, end + 1);
+			/* borrow the range in place; utils_find_open_xml_tag() respects
+			 * the length and never scans past the trailing '>' */
+			const gchar *line_contents = sci_get_range_pointer(sci, start, end + 1 - start);
 			gchar *opened_tag_name = utils_find_open_xml_tag(line_contents, end + 1 - start);
 
 			if (!EMPTY(opened_tag_name))
@@ -1389,7 +1784,6 @@ static gint get_xml_indent(ScintillaObject *sci, gint line)
 				if (sci_get_lexer(sci) == SCLEX_HTML && utils_is_short_html_tag(opened_tag_name))
 					need_close = FALSE;
 			}
-			g_free(line_contents);
 			g_free(opened_tag_name);
 		}
 	}
@@ -1551,7 +1945,8 @@ static void close_block(GeanyEditor *editor, gint pos)
 	const GeanyIndentPrefs *iprefs = editor_get_indent_prefs(editor);
 	gint x = 0, cnt = 0;
 	gint line, line_len;
-	gchar *text, *line_buf;
+	gchar *text;
+	const gchar *line_buf;
 	ScintillaObject *sci;
 	gint line_indent, last_indent;
 
@@ -1568,15 +1963,13 @@ static void close_block(GeanyEditor *editor, gint pos)
 	line_len = sci_get_line_end_position(sci, line) - sci_get_position_from_line(sci, line);
 
 	/* check that the line is empty, to not kill text in the line */
-	line_buf = sci_get_line(sci, line);
-	line_buf[line_len] = '\0';
+	line_buf = sci_get_range_pointer(sci, sci_get_position_from_line(sci, line), line_len);
 	while (x < line_len)
 	{
 		if (isspace(line_buf[x]))
 			cnt++;
 		x++;
 	}
-	g_free(line_buf);
 
 	if ((line_len - 1) != cnt)
 		return;
@@ -1615,8 +2008,33 @@ static void close_block(GeanyEditor *editor, gint pos)
 }
 
 
-/* checks whether @p c is an ASCII character (e.g. < 0x80) */
-#define IS_ASCII(c) (((unsigned char)(c)) < 0x80)
+/* 256-bit membership bitmap compiled from a wordchars string so that the
+ * per-character boundary tests below are a shift and a mask instead of a
+ * strchr() over the whole set */
+typedef struct
+{
+	guint32 bits[8];
+} WordCharSet;
+
+#define WORDCHAR_SET_CONTAINS(set, c) \
+	(((set)->bits[((guchar) (c)) >> 5] >> (((guchar) (c)) & 31)) & 1U)
+
+static void wordchar_set_compile(WordCharSet *set, const gchar *wc)
+{
+	memset(set, 0, sizeof *set);
+	/* every non-ASCII byte is part of a word, which allows any Unicode character
+	 * and any Unicode punctuation, see the TODO that used to sit on the loops */
+	set->bits[4] = set->bits[5] = set->bits[6] = set->bits[7] = 0xffffffffU;
+	/* the old strchr() test also matched a NUL byte when scanning backwards;
+	 * keep that so files with embedded NULs behave as before */
+	set->bits[0] |= 1U;
+	while (*wc != '\0')
+	{
+		guchar c = (guchar) *wc++;
+
+		set->bits[c >> 5] |= 1U << (c & 31);
+	}
+}
 
 
 /* Reads the word at given cursor position and writes it into the given buffer. The buffer will be
@@ -1626,8 +2044,10 @@ static void close_block(GeanyEditor *editor, gint pos)
 static void read_current_word(GeanyEditor *editor, gint pos, gchar *word, gsize wordlen,
 		const gchar *wc, gboolean stem)
 {
-	gint line, line_start, startword, endword;
-	gchar *chunk;
+	static WordCharSet wc_set;
+	static gchar wc_cached[128] = "";
+	gint line, line_start, line_len, startword, endword;
+	const gchar *chunk;
 	ScintillaObject *sci;
 
 	g_return_if_fail(editor != NULL);
@@ -1638,36 +2058,44 @@ static void read_current_word(GeanyEditor *editor, gint pos, gchar *word, gsize
 
 	line = sci_get_line_from_position(sci, pos);
 	line_start = sci_get_position_from_line(sci, line);
+	line_len = sci_get_line_length(sci, line);
 	startword = pos - line_start;
 	endword = pos - line_start;
 
 	word[0] = '\0';
-	chunk = sci_get_line(sci, line);
+	/* read the line in place, the buffer is not modified before the copy below */
+	chunk = sci_get_range_pointer(sci, line_start, line_len);
 
 	if (wc == NULL)
 		wc = GEANY_WORDCHARS;
 
-	/* the checks for "c < 0" are to allow any Unicode character which should make the code
-	 * a little bit more Unicode safe, anyway, this allows also any Unicode punctuation,
-	 * TODO: improve this code */
-	while (startword > 0 && (strchr(wc, chunk[startword - 1]) || ! IS_ASCII(chunk[startword - 1])))
+	/* nearly every call passes the set of the previous call, so the compiled
+	 * bitmap is cached against the string and effectively built once per set */
+	if (! utils_str_equal(wc, wc_cached))
+	{
+		wordchar_set_compile(&wc_set, wc);
+		if (g_strlcpy(wc_cached, wc, sizeof wc_cached) >= sizeof wc_cached)
+			wc_cached[0] = '\0';	/* oversized set, do not let its prefix match */
+	}
+
+	while (startword > 0 && WORDCHAR_SET_CONTAINS(&wc_set, chunk[startword - 1]))
 		startword--;
 	if (!stem)
 	{
-		while (chunk[endword] != 0 && (strchr(wc, chunk[endword]) || ! IS_ASCII(chunk[endword])))
+		while (endword < line_len && chunk[endword] != 0 &&
+				WORDCHAR_SET_CONTAINS(&wc_set, chunk[endword]))
 			endword++;
 	}
 
 	if (startword != endword)
 	{
-		chunk[endword] = '\0';
+		gsize len = MIN((gsize) (endword - startword), wordlen - 1);
 
-		g_strlcpy(word, chunk + startword, wordlen); /* ensure null terminated */
+		memcpy(word, chunk + startword, len);
+		word[len] = '\0';
 	}
 	else
 		g_strlcpy(word, "", wordlen);
-
-	g_free(chunk);
 }
 
 
@@ -2014,7 +2442,7 @@ autocomplete_html(ScintillaObject *sci, const gchar *root, gsize rootlen)
 		}
 	}
 	if (found)
-		show_autocomplete(sci, rootlen, words);
+		show_autocomplete(sci, rootlen, words, SC_ORDER_PRESORTED);
 
 	g_string_free(words, TRUE);
 	return found;
@@ -2025,7 +2453,6 @@ autocomplete_html(ScintillaObject *sci, const gchar *root, gsize rootlen)
 static gboolean
 autocomplete_tags(GeanyEditor *editor, const gchar *root, gsize rootlen)
 {
-	TMTagAttrType attrs[] = { tm_tag_attr_name_t, 0 };
 	const GPtrArray *tags;
 	GeanyDocument *doc;
 
@@ -2033,10 +2460,13 @@ autocomplete_tags(GeanyEditor *editor, const gchar *root, gsize rootlen)
 
 	doc = editor->document;
 
-	tags = tm_workspace_find(root, tm_tag_max_t, attrs, TRUE, doc->file_type->lang);
+	/* the prefix lookup stays O(log n + k) on huge workspaces and never
+	 * collects more entries than the popup can show */
+	tags = tm_workspace_find_prefix(root, doc->file_type->lang,
+		editor_prefs.autocompletion_max_entries);
 	if (tags)
 	{
-		show_tags_list(editor, tags, rootlen);
+		show_tags_list(editor, tags, root, rootlen);
 		return tags->len > 0;
 	}
 	return FALSE;
@@ -2079,11 +2509,151 @@ static gboolean autocomplete_check_html(GeanyEditor *editor, gint style, gint po
 }
 
 
+/* Per-document word index for completion: maps each word in the buffer to its
+ * number of occurrences. It is rebuilt with a debounce after modifications, so
+ * completion retrieval is a walk over the unique words instead of a text search
+ * over the whole buffer, and candidates can be ranked by frequency. */
+
+static gboolean word_index_chars[256] = { FALSE };
+
+
+static void word_index_rebuild(GeanyDocument *doc)
+{
+	GHashTable *index;
+	const gchar *text;
+	gint len, i;
+	gchar word[GEANY_MAX_WORD_LENGTH];
+
+	if (doc->priv->word_index == NULL)
+		doc->priv->word_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	index = doc->priv->word_index;
+	g_hash_table_remove_all(index);
+
+	if (! word_index_chars[(guchar) 'a'])
+	{
+		const gchar *c;
+
+		for (c = GEANY_WORDCHARS; *c != '\0'; c++)
+			word_index_chars[(guchar) *c] = TRUE;
+	}
+
+	len = sci_get_length(doc->editor->sci);
+	text = sci_get_range_pointer(doc->editor->sci, 0, len);
+
+	for (i = 0; i < len; )
+	{
+		if (word_index_chars[(guchar) text[i]])
+		{
+			gint start = i;
+
+			while (i < len && word_index_chars[(guchar) text[i]])
+				i++;
+			if (i - start > 1 && i - start < (gint) sizeof(word))
+			{
+				guint *count;
+
+				memcpy(word, &text[start], i - start);
+				word[i - start] = '\0';
+				count = g_hash_table_lookup(index, word);
+				if (count != NULL)
+					(*count)++;
+				else
+				{
+					count = g_new(guint, 1);
+					*count = 1;
+					g_hash_table_insert(index, g_strdup(word), count);
+				}
+			}
+		}
+		else
+			i++;
+	}
+}
+
+
+static gboolean on_word_index_update_idle(gpointer data)
+{
+	GeanyDocument *doc = data;
+
+	if (! DOC_VALID(doc))
+		return FALSE;
+
+	doc->priv->word_index_source = 0;
+	word_index_rebuild(doc);
+	return FALSE;
+}
+
+
+/* Schedules a rebuild of the word index, called after buffer modifications.
+ * Like the symbol list update this is debounced so fast typing causes only one
+ * rebuild per pause. */
+static void word_index_schedule_update(GeanyDocument *doc)
+{
+	guint freq = (guint) editor_prefs.autocompletion_update_freq;
+
+	if (editor_prefs.autocompletion_update_freq <= 0 || doc->priv->is_large_file)
+		return;
+
+	/* typing latency over budget: back off until it recovers */
+	freq <<= 2 * latency_shed_level;
+
+	if (doc->priv->word_index_source != 0)
+		g_source_remove(doc->priv->word_index_source);
+
+	doc->priv->word_index_source = g_timeout_add_full(G_PRIORITY_LOW,
+		freq, on_word_index_update_idle, doc, NULL);
+}
+
+
+static gint compare_indexed_words(gconstpointer a, gconstpointer b, gpointer data)
+{
+	GHashTable *index = data;
+	const gchar *word_a = *(const gchar **) a;
+	const gchar *word_b = *(const gchar **) b;
+	guint count_a = *(guint *) g_hash_table_lookup(index, word_a);
+	guint count_b = *(guint *) g_hash_table_lookup(index, word_b);
+
+	if (count_a != count_b)
+		return count_b > count_a ? 1 : -1;
+	return utils_str_casecmp(word_a, word_b);
+}
+
+
+/* Collects the words matching @p root from the document's word index, most
+ * frequent first, skipping words found in @p exclude (which may be NULL).
+ * The strings are owned by the index, only the array needs to be freed.
+ * Returns NULL if the index has not been built yet. */
+static GPtrArray *get_indexed_words(GeanyDocument *doc, const gchar *root, gsize rootlen,
+		GHashTable *exclude)
+{
+	GPtrArray *words;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (doc->priv->word_index == NULL)
+		return NULL;
+
+	words = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, doc->priv->word_index);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const gchar *word = key;
+
+		if (strlen(word) > rootlen && strncmp(word, root, rootlen) == 0 &&
+			(exclude == NULL || g_hash_table_lookup(exclude, word) == NULL))
+		{
+			g_ptr_array_add(words, key);
+		}
+	}
+	g_ptr_array_sort_with_data(words, compare_indexed_words, doc->priv->word_index);
+	return words;
+}
+
+
 /* Algorithm based on based on Scite's StartAutoCompleteWord()
  * @returns a sorted list of words matching @p root */
 static GSList *get_doc_words(ScintillaObject *sci, gchar *root, gsize rootlen)
 {
-	gchar *word;
 	gint len, current, word_end;
 	gint pos_find, flags;
 	guint word_length;
@@ -2113,13 +2683,22 @@ static GSList *get_doc_words(ScintillaObject *sci, gchar *root, gsize rootlen)
 			word_length = word_end - pos_find;
 			if (word_length > rootlen)
 			{
-				word = sci_get_contents_range(sci, pos_find, word_end);
-				/* search whether we already have the word in, otherwise add it */
-				if (g_slist_find_custom(words, word, (GCompareFunc)strcmp) != NULL)
-					g_free(word);
-				else
+				/* compare the candidate against the buffer in place and only
+				 * allocate once it is actually added to the list - duplicates
+				 * are the common case in this per-keystroke scan */
+				const gchar *chunk = sci_get_range_pointer(sci, pos_find, word_length);
+				GSList *node;
+
+				for (node = words; node != NULL; node = node->next)
+				{
+					const gchar *w = node->data;
+
+					if (strncmp(w, chunk, word_length) == 0 && w[word_length] == '\0')
+						break;
+				}
+				if (node == NULL)
 				{
-					words = g_slist_prepend(words, word);
+					words = g_slist_prepend(words, g_strndup(chunk, word_length));
 					nmatches++;
 				}
 
@@ -2138,10 +2717,42 @@ static GSList *get_doc_words(ScintillaObject *sci, gchar *root, gsize rootlen)
 static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize rootlen)
 {
 	ScintillaObject *sci = editor->sci;
+	GPtrArray *ranked;
 	GSList *words, *node;
 	GString *str;
 	guint n_words = 0;
 
+	ranked = get_indexed_words(editor->document, root, rootlen, NULL);
+	if (ranked != NULL)
+	{
+		guint i;
+
+		if (ranked->len == 0)
+		{
+			g_ptr_array_free(ranked, TRUE);
+			scintilla_send_message(sci, SCI_AUTOCCANCEL, 0, 0);
+			return FALSE;
+		}
+
+		str = g_string_sized_new(rootlen * 2 * 10);
+		for (i = 0; i < ranked->len && i < editor_prefs.autocompletion_max_entries; i++)
+		{
+			if (i > 0)
+				g_string_append_c(str, '\n');
+			g_string_append(str, ranked->pdata[i]);
+		}
+		if (ranked->len >= editor_prefs.autocompletion_max_entries)
+			g_string_append(str, "\n...");
+		g_ptr_array_free(ranked, TRUE);
+
+		show_autocomplete(sci, rootlen, str, SC_ORDER_CUSTOM);
+		g_string_free(str, TRUE);
+		return TRUE;
+	}
+
+	/* index not built yet: scan the buffer as before and request a build */
+	word_index_schedule_update(editor->document);
+
 	words = get_doc_words(sci, root, rootlen);
 	if (!words)
 	{
@@ -2163,7 +2774,7 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 
 	g_slist_free(words);
 
-	show_autocomplete(sci, rootlen, str);
+	show_autocomplete(sci, rootlen, str, SC_ORDER_PRESORTED);
 	g_string_free(str, TRUE);
 	return TRUE;
 }
@@ -2184,6 +2795,10 @@ gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean forc
 	if (! editor_prefs.auto_complete_symbols && ! force)
 		return FALSE;
 
+	/* typing latency over budget: skip the completion scan until it recovers */
+	if (! force && latency_shed_level >= 2)
+		return FALSE;
+
 	/* If we are at the beginning of the document, we skip autocompletion as we can't determine the
 	 * necessary styling information */
 	if (G_UNLIKELY(pos < 2))
@@ -2364,12 +2979,11 @@ void editor_insert_text_block(GeanyEditor *editor, const gchar *text, gint inser
 	{
 		/* count indent size up to insert_pos instead of asking sci
 		 * because there may be spaces after it */
-		gchar *tmp = sci_get_line(sci, line_start);
+		gint start = sci_get_position_from_line(sci, line_start);
+		const gchar *tmp = sci_get_range_pointer(sci, start, insert_pos - start);
 
-		idx = insert_pos - sci_get_position_from_line(sci, line_start);
-		tmp[idx] = '\0';
-		newline_indent_size = count_indent_size(editor, tmp);
-		g_free(tmp);
+		idx = insert_pos - start;
+		newline_indent_size = count_indent_size(editor, tmp, idx);
 	}
 
 	/* Add line indents (in spaces) */
@@ -2514,20 +3128,17 @@ static gssize replace_cursor_markers(GeanyEditor *editor, GString *pattern)
 static gboolean snippets_complete_constructs(GeanyEditor *editor, gint pos, const gchar *word)
 {
 	ScintillaObject *sci = editor->sci;
-	gchar *str;
+	gchar str[GEANY_MAX_WORD_LENGTH];
 	const gchar *completion;
 	gint str_len;
 	gint ft_id = editor->document->file_type->id;
 
-	str = g_strdup(word);
+	g_strlcpy(str, word, sizeof str);
 	g_strstrip(str);
 
-	completion = snippets_find_completion_by_name(filetypes[ft_id]->name, str);
+	completion = snippets_lookup(ft_id, str);
 	if (completion == NULL)
-	{
-		g_free(str);
 		return FALSE;
-	}
 
 	/* remove the typed word, it will be added again by the used auto completion
 	 * (not really necessary but this makes the auto completion more flexible,
@@ -2541,7 +3152,6 @@ static gboolean snippets_complete_constructs(GeanyEditor *editor, gint pos, cons
 	editor_insert_snippet(editor, pos, completion);
 	sci_scroll_caret(sci);
 
-	g_free(str);
  	return TRUE;
 }
 
@@ -2583,7 +3193,7 @@ gboolean editor_complete_snippet(GeanyEditor *editor, gint pos)
 		! editor_prefs.complete_snippets_whilst_editing && ! at_eol(sci, pos))
 		return FALSE;
 
-	wc = snippets_find_completion_by_name("Special", "wordchars");
+	wc = snippet_wordchars;
 	word = editor_read_word_stem(editor, pos, wc);
 
 	/* prevent completion of "for " */
@@ -2704,7 +3314,9 @@ static gboolean handle_xml(GeanyEditor *editor, gint pos, gchar ch)
 
 
 /* like sci_get_line_indentation(), but for a string. */
-static gsize count_indent_size(GeanyEditor *editor, const gchar *base_indent)
+/* @a base_indent need not be NUL-terminated, @a length bounds the scan so a
+ * borrowed buffer range can be passed directly */
+static gsize count_indent_size(GeanyEditor *editor, const gchar *base_indent, gint length)
 {
 	const gchar *ptr;
 	gsize tab_size = sci_get_tab_width(editor->sci);
@@ -2712,7 +3324,7 @@ static gsize count_indent_size(GeanyEditor *editor, const gchar *base_indent)
 
 	g_return_val_if_fail(base_indent, 0);
 
-	for (ptr = base_indent; *ptr != 0; ptr++)
+	for (ptr = base_indent; ptr < base_indent + length && *ptr != 0; ptr++)
 	{
 		switch (*ptr)
 		{
@@ -3252,7 +3864,64 @@ gint editor_do_comment(GeanyEditor *editor, gint line, gboolean allow_empty_line
 
 	sci_start_undo_action(editor->sci);
 
-	for (i = first_line; (i <= last_line) && (! break_loop); i++)
+	/* use single line comments: assemble the commented span in memory and swap
+	 * it in with one target replacement, so commenting any number of lines
+	 * performs one buffer edit (with one undo entry, marker/fold adjustment
+	 * and modification notification) instead of one insertion per line */
+	if (EMPTY(cc))
+	{
+		gint span_start = sci_get_position_from_line(editor->sci, first_line);
+		gint span_end = sci_get_line_end_position(editor->sci, last_line);
+		const gchar *text = sci_get_range_pointer(editor->sci, span_start, span_end - span_start);
+		gchar *prefix;
+		GString *repl;
+		gint copied = 0;	/* offset into text up to which repl is filled */
+
+		if (toggle)
+			prefix = g_strconcat(co, editor_prefs.comment_toggle_mark, NULL);
+		else
+			prefix = g_strdup(co);
+
+		repl = g_string_sized_new(span_end - span_start +
+			(last_line - first_line + 1) * (gint) strlen(prefix));
+
+		for (i = first_line; i <= last_line; i++)
+		{
+			line_start = sci_get_position_from_line(editor->sci, i) - span_start;
+			line_len = sci_get_line_end_position(editor->sci, i) - span_start - line_start;
+			x = 0;
+
+			while (x < line_len && isspace((guchar) text[line_start + x]))
+				x++;
+
+			/* to skip blank lines */
+			if (allow_empty_lines || x < line_len)
+			{
+				gint start = line_start;
+
+				if (ft->comment_use_indent)
+					start = line_start + x;
+
+				g_string_append_len(repl, text + copied, start - copied);
+				g_string_append(repl, prefix);
+				copied = start;
+				count++;
+				single_line = TRUE;
+			}
+		}
+		g_string_append_len(repl, text + copied, (span_end - span_start) - copied);
+
+		if (count > 0)
+		{
+			sci_set_target_start(editor->sci, span_start);
+			sci_set_target_end(editor->sci, span_end);
+			sci_replace_target(editor->sci, repl->str, FALSE);
+		}
+		g_string_free(repl, TRUE);
+		g_free(prefix);
+	}
+	/* use multi line comment */
+	else for (i = first_line; (i <= last_line) && (! break_loop); i++)
 	{
 		gint buf_len;
 
@@ -3271,42 +3940,19 @@ gint editor_do_comment(GeanyEditor *editor, gint line, gboolean allow_empty_line
 		/* to skip blank lines */
 		if (allow_empty_lines || (x < line_len && sel[x] != '\0'))
 		{
-			/* use single line comment */
-			if (EMPTY(cc))
-			{
-				gint start = line_start;
-				single_line = TRUE;
-
-				if (ft->comment_use_indent)
-					start = line_start + x;
-
-				if (toggle)
-				{
-					gchar *text = g_strconcat(co, editor_prefs.comment_toggle_mark, NULL);
-					sci_insert_text(editor->sci, start, text);
-					g_free(text);
-				}
-				else
-					sci_insert_text(editor->sci, start, co);
-				count++;
-			}
-			/* use multi line comment */
-			else
-			{
-				gint style_comment;
+			gint style_comment;
 
-				/* skip lines which are already comments */
-				style_comment = get_multiline_comment_style(editor, line_start);
-				if (sci_get_style_at(editor->sci, line_start + x) == style_comment)
-					continue;
+			/* skip lines which are already comments */
+			style_comment = get_multiline_comment_style(editor, line_start);
+			if (sci_get_style_at(editor->sci, line_start + x) == style_comment)
+				continue;
 
-				real_comment_multiline(editor, line_start, last_line);
-				count = 1;
+			real_comment_multiline(editor, line_start, last_line);
+			count = 1;
 
-				/* break because we are already on the last line */
-				break_loop = TRUE;
-				break;
-			}
+			/* break because we are already on the last line */
+			break_loop = TRUE;
+			break;
 		}
 	}
 	sci_end_undo_action(editor->sci);
@@ -3467,12 +4113,14 @@ static void auto_multiline(GeanyEditor *editor, gint cur_line)
 	indent_pos = sci_get_line_indent_position(sci, cur_line);
 	if (sci_get_style_at(sci, indent_pos) == style || indent_pos >= sci_get_length(sci))
 	{
-		gchar *previous_line = sci_get_line(sci, cur_line - 1);
+		gint prev_line_start = sci_get_position_from_line(sci, cur_line - 1);
+		gint len = sci_get_line_length(sci, cur_line - 1);
+		/* borrow the line in place; all scans below are bounded by len */
+		const gchar *previous_line = sci_get_range_pointer(sci, prev_line_start, len);
 		/* the type of comment, '*' (C/C++/Java), '+' and the others (D) */
 		const gchar *continuation = "*";
 		const gchar *whitespace = ""; /* to hold whitespace if needed */
 		gchar *result;
-		gint len = strlen(previous_line);
 		gint i;
 
 		/* find and stop at end of multi line comment */
@@ -3490,7 +4138,6 @@ static void auto_multiline(GeanyEditor *editor, gint cur_line)
 			 * to return to the indent used before the multiline comment was started. */
 			if (indent_len % indent_width == 1)
 				SSM(sci, SCI_DELETEBACKNOTLINE, 0, 0);	/* remove whitespace indent */
-			g_free(previous_line);
 			return;
 		}
 		/* check whether we are on the second line of multi line comment */
@@ -3509,8 +4156,6 @@ static void auto_multiline(GeanyEditor *editor, gint cur_line)
 		result = g_strconcat(whitespace, continuation, " ", NULL);
 		sci_add_text(sci, result);
 		g_free(result);
-
-		g_free(previous_line);
 	}
 }
 
@@ -3911,8 +4556,12 @@ void editor_smart_line_indentation(GeanyEditor *editor, gint pos)
 /* increase / decrease current line or selection by one space */
 void editor_indentation_by_one_space(GeanyEditor *editor, gint pos, gboolean decrease)
 {
-	gint i, first_line, last_line, line_start, indentation_end, count = 0;
+	gint i, first_line, last_line, count = 0;
 	gint sel_start, sel_end, first_line_offset = 0;
+	gint span_start, span_end;
+	const gchar *text;
+	GString *repl;
+	gint copied = 0;	/* offset into text up to which repl is filled */
 
 	g_return_if_fail(editor != NULL);
 
@@ -3927,22 +4576,37 @@ void editor_indentation_by_one_space(GeanyEditor *editor, gint pos, gboolean dec
 	if (pos == -1)
 		pos = sel_start;
 
-	sci_start_undo_action(editor->sci);
+	/* assemble the re-indented span in memory and swap it in with one target
+	 * replacement, so indenting any number of lines performs one buffer edit
+	 * (with one undo entry, marker/fold adjustment and modification
+	 * notification) instead of one per line */
+	span_start = SSM(editor->sci, SCI_POSITIONFROMLINE, first_line, 0);
+	span_end = sci_get_line_end_position(editor->sci, last_line);
+	text = sci_get_range_pointer(editor->sci, span_start, span_end - span_start);
+	repl = g_string_sized_new(span_end - span_start + (last_line - first_line + 1));
 
 	for (i = first_line; i <= last_line; i++)
 	{
-		indentation_end = SSM(editor->sci, SCI_GETLINEINDENTPOSITION, i, 0);
+		gint line_start = SSM(editor->sci, SCI_POSITIONFROMLINE, i, 0) - span_start;
+		gint line_end = sci_get_line_end_position(editor->sci, i) - span_start;
+		gint indentation_end = line_start;
+
+		while (indentation_end < line_end &&
+			(text[indentation_end] == ' ' || text[indentation_end] == '\t'))
+		{
+			indentation_end++;
+		}
+
 		if (decrease)
 		{
-			line_start = SSM(editor->sci, SCI_POSITIONFROMLINE, i, 0);
 			/* searching backwards for a space to remove */
-			while (sci_get_char_at(editor->sci, indentation_end) != ' ' && indentation_end > line_start)
+			while (indentation_end > line_start && text[indentation_end - 1] != ' ')
 				indentation_end--;
 
-			if (sci_get_char_at(editor->sci, indentation_end) == ' ')
+			if (indentation_end > line_start)
 			{
-				sci_set_selection(editor->sci, indentation_end, indentation_end + 1);
-				sci_replace_sel(editor->sci, "");
+				g_string_append_len(repl, text + copied, indentation_end - 1 - copied);
+				copied = indentation_end;	/* drop the space */
 				count--;
 				if (i == first_line)
 					first_line_offset = -1;
@@ -3950,20 +4614,31 @@ void editor_indentation_by_one_space(GeanyEditor *editor, gint pos, gboolean dec
 		}
 		else
 		{
-			sci_insert_text(editor->sci, indentation_end, " ");
+			g_string_append_len(repl, text + copied, indentation_end - copied);
+			g_string_append_c(repl, ' ');
+			copied = indentation_end;
 			count++;
 			if (i == first_line)
 				first_line_offset = 1;
 		}
 	}
+	g_string_append_len(repl, text + copied, (span_end - span_start) - copied);
+
+	sci_start_undo_action(editor->sci);
+
+	if (count != 0)
+	{
+		sci_set_target_start(editor->sci, span_start);
+		sci_set_target_end(editor->sci, span_end);
+		sci_replace_target(editor->sci, repl->str, FALSE);
+	}
 
 	/* set cursor position */
 	if (sel_start < sel_end)
 	{
 		gint start = sel_start + first_line_offset;
 		if (first_line_offset < 0)
-			start = MAX(sel_start + first_line_offset,
-						SSM(editor->sci, SCI_POSITIONFROMLINE, first_line, 0));
+			start = MAX(sel_start + first_line_offset, span_start);
 
 		sci_set_selection_start(editor->sci, start);
 		sci_set_selection_end(editor->sci, sel_end + count);
@@ -3972,6 +4647,7 @@ void editor_indentation_by_one_space(GeanyEditor *editor, gint pos, gboolean dec
 		sci_set_current_position(editor->sci, pos + count, FALSE);
 
 	sci_end_undo_action(editor->sci);
+	g_string_free(repl, TRUE);
 }
 
 
@@ -4106,7 +4782,7 @@ void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
 {
 	gint start, end;
 	guint i = 0, len;
-	gchar *linebuf;
+	const gchar *linebuf;
 
 	g_return_if_fail(editor != NULL);
 	g_return_if_fail(line >= 0);
@@ -4123,7 +4799,7 @@ void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
 	}
 
 	len = end - start;
-	linebuf = sci_get_line(editor->sci, line);
+	linebuf = sci_get_range_pointer(editor->sci, start, len);
 
 	/* don't set the indicator on whitespace */
 	while (isspace(linebuf[i]))
@@ -4133,7 +4809,6 @@ void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
 		len--;
 		end--;
 	}
-	g_free(linebuf);
 
 	editor_indicator_set_on_range(editor, indic, start + i, end);
 }
@@ -4487,6 +5162,8 @@ void editor_set_font(GeanyEditor *editor, const gchar *font)
 
 	/* zoom to 100% to prevent confusion */
 	sci_zoom_off(editor->sci);
+
+	editor->document->priv->font_needed = FALSE;
 }
 
 
@@ -4632,6 +5309,19 @@ static gboolean editor_check_colourise(GeanyEditor *editor)
 {
 	GeanyDocument *doc = editor->document;
 
+	if (doc->priv->font_needed)
+	{	/* the global editor font changed while this document was in a
+		 * background tab; apply it before the tab is first drawn */
+		doc->priv->font_needed = FALSE;
+		editor_set_font(editor, interface_prefs.editor_font);
+	}
+
+	if (doc->priv->highlighting_needed)
+	{	/* styles deferred during session restore; must be set before colourising */
+		doc->priv->highlighting_needed = FALSE;
+		highlighting_set_styles(editor->sci, doc->file_type);
+	}
+
 	if (!doc->priv->colourise_needed)
 		return FALSE;
 
@@ -4796,6 +5486,16 @@ static ScintillaObject *create_new_sci(GeanyEditor *editor)
 	/* virtual space */
 	SSM(sci, SCI_SETVIRTUALSPACEOPTIONS, editor_prefs.show_virtual_space, 0);
 
+	/* style the whole document in idle time so scrolling through unstyled parts of a
+	 * large document doesn't block on the lexer catching up (unless the latency
+	 * governor is currently shedding load, see latency_apply_shed_level()) */
+	SSM(sci, SCI_SETIDLESTYLING,
+		latency_shed_level >= 1 ? SC_IDLESTYLING_TOVISIBLE : SC_IDLESTYLING_ALL, 0);
+
+	/* cache the layout of all visible lines, not just the caret line, so repaints of
+	 * tall windows reuse the measured lines instead of re-laying every line out */
+	SSM(sci, SCI_SETLAYOUTCACHE, SC_CACHE_PAGE, 0);
+
 	/* only connect signals if this is for the document notebook, not split window */
 	if (editor->sci == NULL)
 	{
@@ -226,6 +226,9 @@ void editor_destroy(GeanyEditor *editor);
 
 void editor_sci_notify_cb(GtkWidget *widget, gint scn, gpointer scnt, gpointer data);
 
+/* current load-shedding level of the typing latency governor (0 = no shedding) */
+gint editor_get_latency_shed_level(void);
+
 gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean force);
 
 gboolean editor_complete_word_part(GeanyEditor *editor);
@@ -267,6 +270,12 @@ void editor_snippets_init(void);
 
 void editor_snippets_free(void);
 
+void editor_completion_stats_load(GKeyFile *config);
+
+void editor_completion_stats_save(GKeyFile *config);
+
+void editor_completion_stats_reset(void);
+
 const GeanyEditorPrefs *editor_get_prefs(GeanyEditor *editor);
 
 
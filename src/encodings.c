@@ -193,42 +193,56 @@ static gboolean encodings_charset_equals(const gchar *a, const gchar *b)
 }
 
 
-GeanyEncodingIndex encodings_get_idx_from_charset(const gchar *charset)
+/* Resolves a charset name to its encodings[] index, or -1 if unknown. The fuzzy
+ * matching of encodings_charset_equals() rules out hashing the table directly,
+ * so instead each distinct queried spelling is resolved by the linear scan only
+ * once and memoized - these lookups run per document open and per statusbar
+ * update. */
+static gint encodings_scan_charset(const gchar *charset)
 {
+	static GHashTable *idx_cache = NULL;
+	gpointer value;
 	gint i;
 
-	if (charset == NULL)
-		return GEANY_ENCODING_UTF_8;
+	if (G_UNLIKELY(idx_cache == NULL))
+		idx_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
-	i = 0;
-	while (i < GEANY_ENCODINGS_MAX)
+	if (g_hash_table_lookup_extended(idx_cache, charset, NULL, &value))
+		return GPOINTER_TO_INT(value);
+
+	for (i = 0; i < GEANY_ENCODINGS_MAX; i++)
 	{
 		if (encodings_charset_equals(charset, encodings[i].charset))
-			return i;
-
-		++i;
+			break;
 	}
-	return GEANY_ENCODING_UTF_8;
+	if (i == GEANY_ENCODINGS_MAX)
+		i = -1;
+	g_hash_table_insert(idx_cache, g_strdup(charset), GINT_TO_POINTER(i));
+	return i;
 }
 
 
-const GeanyEncoding *encodings_get_from_charset(const gchar *charset)
+GeanyEncodingIndex encodings_get_idx_from_charset(const gchar *charset)
 {
 	gint i;
 
 	if (charset == NULL)
-		return &encodings[GEANY_ENCODING_UTF_8];
+		return GEANY_ENCODING_UTF_8;
 
-	i = 0;
-	while (i < GEANY_ENCODINGS_MAX)
-	{
-		if (encodings_charset_equals(charset, encodings[i].charset))
-			return &encodings[i];
+	i = encodings_scan_charset(charset);
+	return (i >= 0) ? i : GEANY_ENCODING_UTF_8;
+}
 
-		++i;
-	}
 
-	return NULL;
+const GeanyEncoding *encodings_get_from_charset(const gchar *charset)
+{
+	gint i;
+
+	if (charset == NULL)
+		return &encodings[GEANY_ENCODING_UTF_8];
+
+	i = encodings_scan_charset(charset);
+	return (i >= 0) ? &encodings[i] : NULL;
 }
 
 
@@ -535,6 +549,11 @@ static gint encoding_combo_store_sort_func(GtkTreeModel *model,
 
 GtkTreeStore *encodings_encoding_store_new(gboolean has_detect)
 {
+	/* the encodings table is fixed at runtime, so each store variant is built
+	 * once and shared between the combo boxes displaying it - the Open dialog
+	 * recreates its combo every time it is shown */
+	static GtkTreeStore *store_cache[2] = { NULL, NULL };
+	GtkTreeStore **cached = &store_cache[has_detect ? 1 : 0];
 	GtkTreeStore *store;
 	GtkTreeIter iter_current, iter_westeuro, iter_easteuro, iter_eastasian,
 				iter_asian, iter_utf8, iter_middleeast;
@@ -542,6 +561,9 @@ GtkTreeStore *encodings_encoding_store_new(gboolean has_detect)
 	gchar *encoding_string;
 	gint i;
 
+	if (*cached != NULL)
+		return g_object_ref(*cached);
+
 	store = gtk_tree_store_new(2, G_TYPE_INT, G_TYPE_STRING);
 
 	if (has_detect)
@@ -585,6 +607,7 @@ GtkTreeStore *encodings_encoding_store_new(gboolean has_detect)
 	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store), 1, GTK_SORT_ASCENDING);
 	gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(store), 1, encoding_combo_store_sort_func, NULL, NULL);
 
+	*cached = g_object_ref(store);
 	return store;
 }
 
@@ -627,6 +650,61 @@ void encodings_encoding_store_cell_data_func(GtkCellLayout *cell_layout,
 }
 
 
+/* size of the head and tail samples converted when probing a candidate charset */
+#define ENCODING_PROBE_SIZE (64 * 1024)
+
+/* Cheaply checks whether @a buffer could be encoded in @a charset by converting only a head
+ * and a tail sample of large buffers, so clearly wrong candidates are rejected without
+ * converting the whole buffer. A candidate is only rejected on a hard conversion error:
+ * incomplete input at the end of a sample may just be a character cut in half and passes,
+ * and the tail sample is retried at a few start offsets since it can begin in the middle of
+ * a character. Returns TRUE when a full conversion attempt is worthwhile. */
+static gboolean encodings_probe_charset(const gchar *buffer, gsize size, const gchar *charset)
+{
+	GError *error = NULL;
+	gchar *text;
+	gsize bytes_read;
+	guint offset;
+
+	if (size <= 2 * ENCODING_PROBE_SIZE)
+		return TRUE;
+
+	text = g_convert(buffer, ENCODING_PROBE_SIZE, "UTF-8", charset, &bytes_read, NULL, &error);
+	g_free(text);
+	if (error != NULL)
+	{
+		gboolean reject = (error->code == G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+
+		g_error_free(error);
+		if (reject)
+			return FALSE;
+	}
+
+	/* stateful encodings cannot be decoded starting from the middle of the data, their
+	 * tail sample would falsely reject valid files */
+	if (strstr(charset, "2022") != NULL || strstr(charset, "UTF-7") != NULL ||
+		utils_str_equal(charset, "HZ"))
+		return TRUE;
+
+	for (offset = 0; offset < 4; offset++)
+	{
+		gboolean reject;
+
+		error = NULL;
+		text = g_convert(buffer + size - ENCODING_PROBE_SIZE + offset,
+			ENCODING_PROBE_SIZE - offset, "UTF-8", charset, &bytes_read, NULL, &error);
+		g_free(text);
+		if (error == NULL)
+			return TRUE;
+		reject = (error->code == G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+		g_error_free(error);
+		if (! reject)
+			return TRUE;	/* incomplete input at the very end of the buffer */
+	}
+	return FALSE;
+}
+
+
 /**
  *  Tries to convert @a buffer into UTF-8 encoding from the encoding specified with @a charset.
  *  If @a fast is not set, additional checks to validate the converted string are performed.
@@ -658,7 +736,8 @@ gchar *encodings_convert_to_utf8_from_charset(const gchar *buffer, gssize size,
 		utf8_content = converted_contents;
 		if (conv_error != NULL) g_error_free(conv_error);
 	}
-	else if (conv_error != NULL || ! g_utf8_validate(converted_contents, bytes_written, NULL))
+	else if (conv_error != NULL ||
+		! utils_utf8_validate(converted_contents, (gssize) bytes_written, NULL))
 	{
 		if (conv_error != NULL)
 		{
@@ -763,6 +842,12 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 		if (G_UNLIKELY(charset == NULL))
 			continue;
 
+		if (! encodings_probe_charset(buffer, size, charset))
+		{
+			geany_debug("Skipping %s, the probe conversion failed.", charset);
+			continue;
+		}
+
 		geany_debug("Trying to convert %" G_GSIZE_FORMAT " bytes of data from %s into UTF-8.",
 			size, charset);
 		utf8_content = encodings_convert_to_utf8_from_charset(buffer, size, charset, FALSE);
@@ -898,7 +983,7 @@ handle_forced_encoding(BufferData *buffer, const gchar *forced_enc)
 
 	if (utils_str_equal(forced_enc, "UTF-8"))
 	{
-		if (! g_utf8_validate(buffer->data, buffer->len, NULL))
+		if (! utils_utf8_validate(buffer->data, (gssize) buffer->len, NULL))
 		{
 			return FALSE;
 		}
@@ -970,7 +1055,8 @@ handle_encoding(BufferData *buffer, GeanyEncodingIndex enc_idx)
 
 			/* try UTF-8 first */
 			if (encodings_get_idx_from_charset(regex_charset) == GEANY_ENCODING_UTF_8 &&
-				(buffer->size == buffer->len) && g_utf8_validate(buffer->data, buffer->len, NULL))
+				(buffer->size == buffer->len) &&
+				utils_utf8_validate(buffer->data, (gssize) buffer->len, NULL))
 			{
 				buffer->enc = g_strdup("UTF-8");
 			}
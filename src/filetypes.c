@@ -41,6 +41,7 @@
 #include "geanyobject.h"
 #include "highlighting.h"
 #include "projectprivate.h"
+#include "respack.h"
 #include "sciwrappers.h"
 #include "support.h"
 #include "symbols.h"
@@ -451,29 +452,142 @@ GeanyFiletype *filetypes_find(GCompareFunc predicate, gpointer user_data)
 }
 
 
-static gboolean match_basename(gconstpointer pft, gconstpointer user_data)
+/* Precomputed filename pattern matching: almost all filetype patterns have
+ * the simple form "*.ext", so they are resolved through a one-time-built
+ * extension hash table. Only the few genuinely wildcarded patterns
+ * (e.g. Makefile*) remain in a small list which is scanned linearly. Both
+ * structures are rebuilt lazily after the patterns change. */
+
+typedef struct
+{
+	GPatternSpec *pattern;
+	GeanyFiletype *ft;
+	guint order; /* position of ft in the filetypes array, for priority */
+} WildcardPattern;
+
+typedef struct
+{
+	GeanyFiletype *ft;
+	guint order;
+} ExtensionEntry;
+
+static GHashTable *extension_table = NULL; /* extension (without dot) -> ExtensionEntry */
+static GSList *wildcard_patterns = NULL; /* WildcardPattern list, ascending by order */
+
+
+static void free_wildcard_pattern(gpointer data, gpointer user_data)
+{
+	WildcardPattern *wp = data;
+
+	g_pattern_spec_free(wp->pattern);
+	g_free(wp);
+}
+
+
+/* matches "*.ext" where ext itself contains no wildcard characters */
+static gboolean pattern_is_simple_extension(const gchar *pattern)
+{
+	return pattern[0] == '*' && pattern[1] == '.' && pattern[2] != '\0' &&
+		strpbrk(pattern + 2, "*?[") == NULL;
+}
+
+
+static void free_pattern_tables(void)
+{
+	if (extension_table != NULL)
+	{
+		g_hash_table_destroy(extension_table);
+		extension_table = NULL;
+	}
+	g_slist_foreach(wildcard_patterns, free_wildcard_pattern, NULL);
+	g_slist_free(wildcard_patterns);
+	wildcard_patterns = NULL;
+}
+
+
+static void build_pattern_tables(void)
 {
-	const GeanyFiletype *ft = pft;
-	const gchar *base_filename = user_data;
+	guint i;
 	gint j;
-	gboolean ret = FALSE;
 
-	if (G_UNLIKELY(ft->id == GEANY_FILETYPES_NONE))
-		return FALSE;
+	extension_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	for (i = 0; i < filetypes_array->len; i++)
+	{
+		GeanyFiletype *ft = filetypes[i];
+
+		if (G_UNLIKELY(ft->id == GEANY_FILETYPES_NONE))
+			continue;
+
+		for (j = 0; ft->pattern[j] != NULL; j++)
+		{
+			if (pattern_is_simple_extension(ft->pattern[j]))
+			{
+				/* the first filetype claiming an extension wins, as in the
+				 * sequential scan this replaces */
+				if (g_hash_table_lookup(extension_table, ft->pattern[j] + 2) == NULL)
+				{
+					ExtensionEntry *entry = g_new(ExtensionEntry, 1);
+
+					entry->ft = ft;
+					entry->order = i;
+					g_hash_table_insert(extension_table,
+						g_strdup(ft->pattern[j] + 2), entry);
+				}
+			}
+			else
+			{
+				WildcardPattern *wp = g_new(WildcardPattern, 1);
+
+				wp->pattern = g_pattern_spec_new(ft->pattern[j]);
+				wp->ft = ft;
+				wp->order = i;
+				wildcard_patterns = g_slist_prepend(wildcard_patterns, wp);
+			}
+		}
+	}
+	wildcard_patterns = g_slist_reverse(wildcard_patterns);
+}
+
 
-	for (j = 0; ft->pattern[j] != NULL; j++)
+/* Matches base_filename against all filetype patterns, preferring the
+ * filetype which comes first in the filetypes array (like the sequential
+ * scan did). Returns NULL if nothing matches. */
+static GeanyFiletype *match_basename(const gchar *base_filename)
+{
+	GeanyFiletype *best = NULL;
+	guint best_order = G_MAXUINT;
+	const gchar *ext;
+	GSList *node;
+
+	if (extension_table == NULL)
+		build_pattern_tables();
+
+	/* probe every dot-suffix, not just the last extension, so multi-part
+	 * patterns like "*.coffee.erb" (hashed as "coffee.erb") are found too */
+	for (ext = strchr(base_filename, '.'); ext != NULL; ext = strchr(ext + 1, '.'))
 	{
-		GPatternSpec *pattern = g_pattern_spec_new(ft->pattern[j]);
+		ExtensionEntry *entry = g_hash_table_lookup(extension_table, ext + 1);
 
-		if (g_pattern_match_string(pattern, base_filename))
+		if (entry != NULL && entry->order < best_order)
 		{
-			ret = TRUE;
-			g_pattern_spec_free(pattern);
+			best = entry->ft;
+			best_order = entry->order;
+		}
+	}
+	foreach_slist(node, wildcard_patterns)
+	{
+		WildcardPattern *wp = node->data;
+
+		/* the list is sorted by order, so no later entry can win anymore */
+		if (wp->order >= best_order)
+			break;
+		if (g_pattern_match_string(wp->pattern, base_filename))
+		{
+			best = wp->ft;
 			break;
 		}
-		g_pattern_spec_free(pattern);
 	}
-	return ret;
+	return best;
 }
 
 
@@ -523,7 +637,7 @@ GeanyFiletype *filetypes_detect_from_extension(const gchar *utf8_filename)
 	SETPTR(base_filename, g_utf8_strdown(base_filename, -1));
 #endif
 
-	ft = filetypes_find(match_basename, base_filename);
+	ft = match_basename(base_filename);
 	if (ft == NULL)
 		ft = filetypes[GEANY_FILETYPES_NONE];
 
@@ -833,9 +947,17 @@ void filetypes_free_types(void)
 	g_return_if_fail(filetypes_array != NULL);
 	g_return_if_fail(filetypes_hash != NULL);
 
+	free_pattern_tables();
+
 	g_ptr_array_foreach(filetypes_array, filetype_free, NULL);
 	g_ptr_array_free(filetypes_array, TRUE);
 	g_hash_table_destroy(filetypes_hash);
+
+	if (parent_keyfile_cache != NULL)
+	{
+		g_hash_table_destroy(parent_keyfile_cache);
+		parent_keyfile_cache = NULL;
+	}
 }
 
 
@@ -979,6 +1101,41 @@ static gchar *filetypes_get_filename(GeanyFiletype *ft, gboolean user)
 }
 
 
+/* Cache of parsed keyfiles used to resolve [group=Parent] groups: several
+ * derived filetypes reference the same parent file, so parse each file once
+ * instead of re-reading it from disk per group.  Failed loads are cached as
+ * NULL entries to avoid retrying missing files. */
+static GHashTable *parent_keyfile_cache = NULL;
+
+static void parent_keyfile_cache_value_free(gpointer data)
+{
+	if (data != NULL)
+		g_key_file_free(data);
+}
+
+
+static GKeyFile *load_parent_keyfile(const gchar *filename)
+{
+	GKeyFile *kf = NULL;
+
+	if (parent_keyfile_cache == NULL)
+		parent_keyfile_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, parent_keyfile_cache_value_free);
+
+	if (g_hash_table_lookup_extended(parent_keyfile_cache, filename, NULL, (gpointer *) &kf))
+		return kf;
+
+	kf = g_key_file_new();
+	if (! respack_load_key_file(kf, filename, G_KEY_FILE_NONE, NULL))
+	{
+		g_key_file_free(kf);
+		kf = NULL;
+	}
+	g_hash_table_insert(parent_keyfile_cache, g_strdup(filename), kf);
+	return kf;
+}
+
+
 static void add_group_keys(GKeyFile *kf, const gchar *group, GeanyFiletype *ft)
 {
 	gchar *files[2];
@@ -990,14 +1147,13 @@ static void add_group_keys(GKeyFile *kf, const gchar *group, GeanyFiletype *ft)
 
 	for (i = 0; i < G_N_ELEMENTS(files); i++)
 	{
-		GKeyFile *src = g_key_file_new();
+		GKeyFile *src = load_parent_keyfile(files[i]);
 
-		if (g_key_file_load_from_file(src, files[i], G_KEY_FILE_NONE, NULL))
+		if (src != NULL)
 		{
 			copy_keys(kf, group, src, group);
 			loaded = TRUE;
 		}
-		g_key_file_free(src);
 	}
 
 	if (!loaded)
@@ -1047,7 +1203,7 @@ static void load_system_keyfile(GKeyFile *key_file, const gchar *file, GKeyFileF
 		GeanyFiletype *ft)
 {
 	GError *error = NULL;
-	gboolean done = g_key_file_load_from_file(key_file, file, flags, &error);
+	gboolean done = respack_load_key_file(key_file, file, flags, &error);
 
 	if (error != NULL)
 	{
@@ -1231,7 +1387,10 @@ GeanyFiletype *filetypes_lookup_by_name(const gchar *name)
 static void compile_regex(GeanyFiletype *ft, gchar *regstr)
 {
 	GError *error = NULL;
-	GRegex *regex = g_regex_new(regstr, 0, 0, &error);
+	/* the regex runs against every line of build output, so spend a little more
+	 * time here optimizing the compiled form; it is cached until the pattern
+	 * changes (see last_error_pattern), i.e. compiled once per build session */
+	GRegex *regex = g_regex_new(regstr, G_REGEX_OPTIMIZE, 0, &error);
 
 	if (!regex)
 	{
@@ -1377,6 +1536,9 @@ static void read_extensions(GKeyFile *sysconfig, GKeyFile *userconfig)
 		convert_filetype_extensions_to_lower_case(filetypes[i]->pattern, len);
 #endif
 	}
+
+	/* rebuilt lazily on the next detection */
+	free_pattern_tables();
 }
 
 
@@ -1422,7 +1584,7 @@ static void read_filetype_config(void)
 	GKeyFile *sysconfig = g_key_file_new();
 	GKeyFile *userconfig = g_key_file_new();
 
-	g_key_file_load_from_file(sysconfig, sysconfigfile, G_KEY_FILE_NONE, NULL);
+	respack_load_key_file(sysconfig, sysconfigfile, G_KEY_FILE_NONE, NULL);
 	g_key_file_load_from_file(userconfig, userconfigfile, G_KEY_FILE_NONE, NULL);
 
 	read_extensions(sysconfig, userconfig);
@@ -1471,6 +1633,10 @@ void filetypes_reload(void)
 	guint i;
 	GeanyDocument *current_doc;
 
+	/* the parent keyfiles on disk may have changed */
+	if (parent_keyfile_cache != NULL)
+		g_hash_table_remove_all(parent_keyfile_cache);
+
 	/* reload filetype configs */
 	for (i = 0; i < filetypes_array->len; i++)
 	{
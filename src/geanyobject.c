@@ -189,6 +189,18 @@ static void create_signals(GObjectClass *g_object_class)
 		g_cclosure_marshal_VOID__POINTER,
 		G_TYPE_NONE, 1,
 		G_TYPE_POINTER);
+	/* emitted once with a GPtrArray of GeanyDocument pointers when several
+	 * files are opened together (session restore, multi-file open); the
+	 * per-document "document-open" signal is not emitted for these */
+	geany_object_signals[GCB_DOCUMENTS_OPENED] = g_signal_new (
+		"documents-opened",
+		G_OBJECT_CLASS_TYPE (g_object_class),
+		G_SIGNAL_RUN_FIRST,
+		G_STRUCT_OFFSET (GeanyObjectClass, documents_opened),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__POINTER,
+		G_TYPE_NONE, 1,
+		G_TYPE_POINTER);
 	geany_object_signals[GCB_DOCUMENT_RELOAD] = g_signal_new (
 		"document-reload",
 		G_OBJECT_CLASS_TYPE (g_object_class),
@@ -38,6 +38,7 @@ typedef enum
 {
 	GCB_DOCUMENT_NEW,
 	GCB_DOCUMENT_OPEN,
+	GCB_DOCUMENTS_OPENED,
 	GCB_DOCUMENT_RELOAD,
 	GCB_DOCUMENT_BEFORE_SAVE,
 	GCB_DOCUMENT_SAVE,
@@ -88,6 +89,7 @@ struct _GeanyObjectClass
 
 	void (*document_new)(GeanyDocument *doc);
 	void (*document_open)(GeanyDocument *doc);
+	void (*documents_opened)(GPtrArray *docs);
 	void (*document_reload)(GeanyDocument *doc);
 	void (*document_before_save)(GeanyDocument *doc);
 	void (*document_save)(GeanyDocument *doc);
@@ -30,16 +30,33 @@
 
 #include "geanywraplabel.h"
 
+#include <string.h>
+
 
 struct _GeanyWrapLabelClass
 {
 	GtkLabelClass parent_class;
 };
 
+/* During a size negotiation cycle GTK probes the same widths several times,
+ * and interactive resizing re-runs the cycle for every pointer motion; cache
+ * the wrapped height per width so each (text, width) pair costs only one Pango
+ * relayout.  The cache is tiny because a cycle only revisits a handful of
+ * widths; entries are kept most-recently-used first. */
+#define WRAP_HEIGHT_CACHE_SIZE 8
+
+typedef struct
+{
+	gint width;
+	gint height;
+} WrapHeightCacheEntry;
+
 typedef struct
 {
 	gint wrap_width;
 	gint wrap_height;
+	guint cache_len;
+	WrapHeightCacheEntry cache[WRAP_HEIGHT_CACHE_SIZE];
 } GeanyWrapLabelPrivate;
 
 struct _GeanyWrapLabel
@@ -67,6 +84,11 @@ static void geany_wrap_label_size_request	(GtkWidget *widget, GtkRequisition *re
 static void geany_wrap_label_size_allocate	(GtkWidget *widget, GtkAllocation *alloc);
 static void geany_wrap_label_set_wrap_width	(GtkWidget *widget, gint width);
 static void geany_wrap_label_label_notify	(GObject *object, GParamSpec *pspec, gpointer data);
+#if GTK_CHECK_VERSION(3, 0, 0)
+static void geany_wrap_label_style_updated	(GtkWidget *widget);
+#else
+static void geany_wrap_label_style_set		(GtkWidget *widget, GtkStyle *previous_style);
+#endif
 
 G_DEFINE_TYPE(GeanyWrapLabel, geany_wrap_label, GTK_TYPE_LABEL)
 
@@ -83,9 +105,11 @@ static void geany_wrap_label_class_init(GeanyWrapLabelClass *klass)
 	widget_class->get_preferred_height = geany_wrap_label_get_preferred_height;
 	widget_class->get_preferred_height_for_width = geany_wrap_label_get_preferred_height_for_width;
 	widget_class->get_request_mode = geany_wrap_label_get_request_mode;
+	widget_class->style_updated = geany_wrap_label_style_updated;
 #else
 	widget_class->size_request = geany_wrap_label_size_request;
 	widget_class->expose_event = geany_wrap_label_expose;
+	widget_class->style_set = geany_wrap_label_style_set;
 #endif
 
 	g_type_class_add_private(klass, sizeof (GeanyWrapLabelPrivate));
@@ -99,30 +123,76 @@ static void geany_wrap_label_init(GeanyWrapLabel *self)
 
 	self->priv->wrap_width = 0;
 	self->priv->wrap_height = 0;
+	self->priv->cache_len = 0;
 
 	g_signal_connect(self, "notify::label", G_CALLBACK(geany_wrap_label_label_notify), NULL);
 	gtk_misc_set_alignment(GTK_MISC(self), 0.0, 0.0);
 }
 
 
+/* Returns the cached wrapped height for width, or -1 on a cache miss.
+ * A hit is moved to the front of the cache. */
+static gint wrap_height_cache_lookup(GeanyWrapLabelPrivate *priv, gint width)
+{
+	guint i;
+
+	for (i = 0; i < priv->cache_len; i++)
+	{
+		if (priv->cache[i].width == width)
+		{
+			WrapHeightCacheEntry entry = priv->cache[i];
+
+			memmove(&priv->cache[1], &priv->cache[0], i * sizeof entry);
+			priv->cache[0] = entry;
+			return entry.height;
+		}
+	}
+	return -1;
+}
+
+
+static void wrap_height_cache_insert(GeanyWrapLabelPrivate *priv, gint width, gint height)
+{
+	if (priv->cache_len < WRAP_HEIGHT_CACHE_SIZE)
+		priv->cache_len++;
+	memmove(&priv->cache[1], &priv->cache[0],
+		(priv->cache_len - 1) * sizeof priv->cache[0]);
+	priv->cache[0].width = width;
+	priv->cache[0].height = height;
+}
+
+
+/* Computes the height of the text wrapped at width, preferring the cache over
+ * a Pango relayout. */
+static gint geany_wrap_label_get_wrapped_height(GtkWidget *widget, gint width)
+{
+	GeanyWrapLabel *self = GEANY_WRAP_LABEL(widget);
+	gint height = wrap_height_cache_lookup(self->priv, width);
+
+	if (height < 0)
+	{
+		PangoLayout *layout = gtk_label_get_layout(GTK_LABEL(widget));
+
+		pango_layout_set_width(layout, width * PANGO_SCALE);
+		pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+		pango_layout_get_pixel_size(layout, NULL, &height);
+		wrap_height_cache_insert(self->priv, width, height);
+	}
+	return height;
+}
+
+
 /* Sets the point at which the text should wrap. */
 static void geany_wrap_label_set_wrap_width(GtkWidget *widget, gint width)
 {
 	GeanyWrapLabel *self = GEANY_WRAP_LABEL(widget);
-	PangoLayout *layout;
 
 	if (width <= 0)
 		return;
 
-	layout = gtk_label_get_layout(GTK_LABEL(widget));
-
-	/*
-	* We may need to reset the wrap width, so do this regardless of whether
-	* or not we've changed the width.
-	*/
-	pango_layout_set_width(layout, width * PANGO_SCALE);
-	pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
-	pango_layout_get_pixel_size(layout, NULL, &self->priv->wrap_height);
+	/* the render handlers restore the layout's wrap width, so on a cache hit
+	 * the layout does not need to be touched here */
+	self->priv->wrap_height = geany_wrap_label_get_wrapped_height(widget, width);
 
 	if (self->priv->wrap_width != width)
 	{
@@ -137,10 +207,28 @@ static void geany_wrap_label_label_notify(GObject *object, GParamSpec *pspec, gp
 {
 	GeanyWrapLabel *self = GEANY_WRAP_LABEL(object);
 
+	/* all cached heights were computed for the old text */
+	self->priv->cache_len = 0;
 	geany_wrap_label_set_wrap_width(GTK_WIDGET(object), self->priv->wrap_width);
 }
 
 
+/* drops cached heights on font/style changes, which alter the wrapping */
+#if GTK_CHECK_VERSION(3, 0, 0)
+static void geany_wrap_label_style_updated(GtkWidget *widget)
+{
+	GEANY_WRAP_LABEL(widget)->priv->cache_len = 0;
+	(* GTK_WIDGET_CLASS(geany_wrap_label_parent_class)->style_updated)(widget);
+}
+#else
+static void geany_wrap_label_style_set(GtkWidget *widget, GtkStyle *previous_style)
+{
+	GEANY_WRAP_LABEL(widget)->priv->cache_len = 0;
+	(* GTK_WIDGET_CLASS(geany_wrap_label_parent_class)->style_set)(widget, previous_style);
+}
+#endif
+
+
 #if GTK_CHECK_VERSION(3, 0, 0)
 /* makes sure the layout is setup for rendering and chains to parent renderer */
 static gboolean geany_wrap_label_draw(GtkWidget *widget, cairo_t *cr)
@@ -185,13 +273,7 @@ static void geany_wrap_label_get_preferred_height (GtkWidget *widget,
 static void geany_wrap_label_get_preferred_height_for_width (GtkWidget *widget,
 		gint width, gint *minimal_height, gint *natural_height)
 {
-	PangoLayout *layout = gtk_label_get_layout(GTK_LABEL(widget));
-
-	pango_layout_set_width(layout, width * PANGO_SCALE);
-	pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
-	pango_layout_get_pixel_size(layout, NULL, natural_height);
-
-	*minimal_height = *natural_height;
+	*minimal_height = *natural_height = geany_wrap_label_get_wrapped_height(widget, width);
 }
 
 
@@ -35,6 +35,7 @@
 #include "app.h"
 #include "dialogs.h"
 #include "document.h"
+#include "documentprivate.h"
 #include "editor.h"
 #include "filetypesprivate.h"
 #include "sciwrappers.h"
@@ -69,11 +70,26 @@ typedef struct
 	gchar			*wordchars;	/* NULL used for style sets with no styles */
 	gchar			**property_keys;
 	gchar			**property_values;
+	gpointer		compiled;	/* owning CompiledStyleSet when the arrays are shared */
 } StyleSet;
 
 /* each filetype has a styleset but GEANY_FILETYPES_NONE uses common_style_set for styling */
 static StyleSet *style_sets = NULL;
 
+/* A style set compiled for one filetype under one colour scheme. Immutable
+ * once built, so it can be shared between the active style_sets entry and the
+ * scheme cache, and survive scheme switches. */
+typedef struct
+{
+	StyleSet	set;
+	guint		refcount;
+} CompiledStyleSet;
+
+/* compiled style sets keyed by "<color scheme>\x1f<filetype name>"; switching
+ * back to an already seen scheme reuses them instead of re-reading and
+ * re-parsing every filetype definition file */
+static GHashTable *compiled_scheme_cache = NULL;
+
 
 enum	/* Geany common styling */
 {
@@ -144,11 +160,40 @@ static void new_styleset(guint file_type_id, gsize styling_count)
 }
 
 
+static void compiled_style_set_unref(gpointer data)
+{
+	CompiledStyleSet *compiled = data;
+
+	if (--compiled->refcount > 0)
+		return;
+
+	g_free(compiled->set.styling);
+	g_strfreev(compiled->set.keywords);
+	g_free(compiled->set.wordchars);
+	g_strfreev(compiled->set.property_keys);
+	g_strfreev(compiled->set.property_values);
+	g_free(compiled);
+}
+
+
+static gchar *compiled_scheme_key(const GeanyFiletype *ft)
+{
+	return g_strconcat(FALLBACK(editor_prefs.color_scheme, ""), "\x1f", ft->name, NULL);
+}
+
+
 static void free_styleset(guint file_type_id)
 {
 	StyleSet *style_ptr;
 	style_ptr = &style_sets[file_type_id];
 
+	if (style_ptr->compiled != NULL)
+	{	/* the arrays belong to a shared compiled set */
+		compiled_style_set_unref(style_ptr->compiled);
+		memset(style_ptr, 0, sizeof *style_ptr);
+		return;
+	}
+
 	style_ptr->count = 0;
 	g_free(style_ptr->styling);
 	style_ptr->styling = NULL;
@@ -419,6 +464,19 @@ static void set_sci_style(ScintillaObject *sci, guint style, guint ft_id, guint
 }
 
 
+/* Drops the compiled scheme cache, for when filetype definition or colour
+ * scheme files may have changed on disk. Active style sets keep their data
+ * alive through their own references. */
+void highlighting_invalidate_compiled_schemes(void)
+{
+	if (compiled_scheme_cache != NULL)
+	{
+		g_hash_table_destroy(compiled_scheme_cache);
+		compiled_scheme_cache = NULL;
+	}
+}
+
+
 void highlighting_free_styles(void)
 {
 	guint i;
@@ -426,6 +484,8 @@ void highlighting_free_styles(void)
 	for (i = 0; i < filetypes_array->len; i++)
 		free_styleset(i);
 
+	highlighting_invalidate_compiled_schemes();
+
 	if (named_style_hash)
 		g_hash_table_destroy(named_style_hash);
 
@@ -966,6 +1026,8 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 	GeanyFiletype *ft = filetypes[filetype_idx];
 	guint lexer_id = get_lexer_filetype(ft);
 	gchar *default_str;
+	gchar *cache_key;
+	CompiledStyleSet *compiled;
 
 	if (!style_sets)
 		style_sets = g_new0(StyleSet, filetypes_array->len);
@@ -973,7 +1035,6 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 	/* Clear old information if necessary - e.g. when reloading config */
 	free_styleset(filetype_idx);
 
-	read_properties(ft, config, configh);
 	/* If a default style exists, check it uses a named style
 	 * Note: almost all filetypes have a "default" style, except HTML ones */
 	default_str = utils_get_setting(string, configh, config,
@@ -984,12 +1045,29 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 	/* None filetype handled specially */
 	if (filetype_idx == GEANY_FILETYPES_NONE)
 	{
+		read_properties(ft, config, configh);
 		styleset_common_init(config, configh);
 		return;
 	}
 	/* All stylesets depend on filetypes.common */
 	filetypes_load_config(GEANY_FILETYPES_NONE, FALSE);
 
+	/* reuse the immutable compiled set if this filetype was already built
+	 * under the active colour scheme, e.g. when switching back to a scheme */
+	cache_key = compiled_scheme_key(ft);
+	compiled = (compiled_scheme_cache != NULL) ?
+		g_hash_table_lookup(compiled_scheme_cache, cache_key) : NULL;
+	if (compiled != NULL)
+	{
+		compiled->refcount++;
+		style_sets[filetype_idx] = compiled->set;
+		style_sets[filetype_idx].compiled = compiled;
+		g_free(cache_key);
+		return;
+	}
+
+	read_properties(ft, config, configh);
+
 	switch (lexer_id)
 	{
 		init_styleset_case(ABAQUS);
@@ -1052,6 +1130,19 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 
 	/* should be done in filetypes.c really: */
 	get_keyfile_wordchars(config, configh, &style_sets[filetype_idx].wordchars);
+
+	/* publish the freshly built set as an immutable compiled set shared by
+	 * the cache and the active style_sets entry */
+	compiled = g_new0(CompiledStyleSet, 1);
+	compiled->set = style_sets[filetype_idx];
+	compiled->set.compiled = NULL;
+	compiled->refcount = 2;	/* one for the cache, one for style_sets */
+	style_sets[filetype_idx].compiled = compiled;
+
+	if (compiled_scheme_cache == NULL)
+		compiled_scheme_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, compiled_style_set_unref);
+	g_hash_table_replace(compiled_scheme_cache, cache_key, compiled);
 }
 
 
@@ -1178,6 +1269,36 @@ enum
 	SCHEME_COLUMNS
 };
 
+/* Recompiles the style sets for the newly selected scheme and reapplies them.
+ * Only the visible document is restyled synchronously: the other tabs are just
+ * marked and pick the new styles up before they are next drawn, the same
+ * mechanism session restore uses, so switching schemes with hundreds of tabs
+ * open does not stall. A scheme only changes colours, so unlike
+ * filetypes_reload() the filetype settings and tags are left alone. */
+static void apply_color_scheme(void)
+{
+	GeanyDocument *current_doc = document_get_current();
+	guint i;
+
+	for (i = 0; i < filetypes_array->len; i++)
+		filetypes_load_config(i, TRUE);
+
+	foreach_document(i)
+	{
+		GeanyDocument *doc = documents[i];
+
+		if (doc == current_doc)
+		{
+			doc->priv->highlighting_needed = FALSE;
+			highlighting_set_styles(doc->editor->sci, doc->file_type);
+		}
+		else
+			doc->priv->highlighting_needed = TRUE;
+		doc->priv->colourise_needed = TRUE;
+	}
+}
+
+
 static void on_color_scheme_changed(GtkTreeSelection *treesel, gpointer dummy)
 {
 	GtkTreeModel *model;
@@ -1193,7 +1314,7 @@ static void on_color_scheme_changed(GtkTreeSelection *treesel, gpointer dummy)
 	if (!fname)
 	{
 		SETPTR(editor_prefs.color_scheme, NULL);
-		filetypes_reload();
+		apply_color_scheme();
 		return;
 	}
 	SETPTR(fname, utils_get_locale_from_utf8(fname));
@@ -1210,7 +1331,7 @@ static void on_color_scheme_changed(GtkTreeSelection *treesel, gpointer dummy)
 	{
 		SETPTR(editor_prefs.color_scheme, fname);
 		fname = NULL;
-		filetypes_reload();
+		apply_color_scheme();
 	}
 	else
 	{
@@ -61,6 +61,8 @@ void highlighting_init_styles(guint filetype_idx, GKeyFile *config, GKeyFile *co
 
 void highlighting_free_styles(void);
 
+void highlighting_invalidate_compiled_schemes(void);
+
 void highlighting_show_color_scheme_dialog(void);
 
 #endif /* GEANY_PRIVATE */
@@ -36,6 +36,7 @@
 #include "app.h"
 #include "build.h"
 #include "callbacks.h"
+#include "dialogs.h"
 #include "documentprivate.h"
 #include "filetypes.h"
 #include "keybindingsprivate.h"
@@ -71,6 +72,19 @@ static GeanyKeyBinding binding_ids[GEANY_KEYS_COUNT];
 static GtkAccelGroup *kb_accel_group = NULL;
 static const gboolean swap_alt_tab_order = FALSE;
 
+/* Dispatch table for on_key_press_event(): maps a key value to the short list of
+ * bindings using that key, so a keypress doesn't walk every binding of every
+ * group.  Rebuilt lazily on the next keypress after any binding changed. */
+typedef struct
+{
+	GeanyKeyGroup *group;
+	GeanyKeyBinding *kb;
+}
+KbDispatchEntry;
+
+static GHashTable *kb_dispatch_table = NULL;
+static gboolean kb_dispatch_dirty = TRUE;
+
 
 /* central keypress event handler, almost all keypress events go to this function */
 static gboolean on_key_press_event(GtkWidget *widget, GdkEventKey *event, gpointer user_data);
@@ -174,6 +188,7 @@ GeanyKeyBinding *keybindings_set_item(GeanyKeyGroup *group, gsize key_id,
 	kb->callback = callback;
 	kb->menu_item = menu_item;
 	kb->id = key_id;
+	kb_dispatch_dirty = TRUE;
 	return kb;
 }
 
@@ -271,6 +286,8 @@ static void init_default_kb(void)
 		GDK_r, GDK_CONTROL_MASK, "menu_reloadfile", _("Reload file"), "menu_reload1");
 	add_kb(group, GEANY_KEYS_FILE_OPENLASTTAB, NULL,
 		0, 0, "file_openlasttab", _("Re-open last closed tab"), NULL);
+	add_kb(group, GEANY_KEYS_FILE_GOTOFILE, NULL,
+		GDK_p, GDK_CONTROL_MASK | GDK_SHIFT_MASK, "file_gotofile", _("Go to File"), NULL);
 	add_kb(group, GEANY_KEYS_FILE_QUIT, NULL,
 		GDK_q, GDK_CONTROL_MASK, "menu_quit", _("Quit"), "menu_quit1");
 
@@ -482,6 +499,8 @@ static void init_default_kb(void)
 	add_kb(group, GEANY_KEYS_GOTO_TAGDECLARATION, NULL,
 		GDK_t, GDK_CONTROL_MASK | GDK_SHIFT_MASK, "popup_gototagdeclaration",
 		_("Go to Tag Declaration"), "goto_tag_declaration1");
+	add_kb(group, GEANY_KEYS_GOTO_SYMBOL, NULL,
+		0, 0, "edit_gotosymbol", _("Go to Workspace Symbol"), NULL);
 	add_kb(group, GEANY_KEYS_GOTO_LINESTART, NULL,
 		GDK_Home, 0, "edit_gotolinestart", _("Go to Start of Line"), NULL);
 	add_kb(group, GEANY_KEYS_GOTO_LINEEND, NULL,
@@ -659,6 +678,7 @@ static void load_kb(GeanyKeyGroup *group, GeanyKeyBinding *kb, gpointer user_dat
 		gtk_accelerator_parse(val, &key, &mods);
 		kb->key = key;
 		kb->mods = mods;
+		kb_dispatch_dirty = TRUE;
 		g_free(val);
 	}
 }
@@ -807,6 +827,12 @@ void keybindings_free(void)
 		keybindings_free_group(group);
 
 	g_ptr_array_free(keybinding_groups, TRUE);
+
+	if (kb_dispatch_table != NULL)
+	{
+		g_hash_table_destroy(kb_dispatch_table);
+		kb_dispatch_table = NULL;
+	}
 }
 
 
@@ -1224,11 +1250,57 @@ gboolean keybindings_check_event(GdkEventKey *ev, GeanyKeyBinding *kb)
 }
 
 
+static void kb_dispatch_entry_list_free(gpointer data)
+{
+	GSList *list = data;
+
+	g_slist_foreach(list, (GFunc) g_free, NULL);
+	g_slist_free(list);
+}
+
+
+static void kb_dispatch_rebuild(void)
+{
+	GeanyKeyGroup *group;
+	GeanyKeyBinding *kb;
+	gsize g, i;
+
+	if (kb_dispatch_table == NULL)
+		kb_dispatch_table = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, kb_dispatch_entry_list_free);
+	else
+		g_hash_table_remove_all(kb_dispatch_table);
+
+	foreach_ptr_array(group, g, keybinding_groups)
+	{
+		foreach_ptr_array(kb, i, group->key_items)
+		{
+			KbDispatchEntry *entry;
+			GSList *list;
+
+			if (kb->key == 0)
+				continue;
+
+			entry = g_new(KbDispatchEntry, 1);
+			entry->group = group;
+			entry->kb = kb;
+			list = g_hash_table_lookup(kb_dispatch_table, GUINT_TO_POINTER(kb->key));
+			if (list == NULL)
+				g_hash_table_insert(kb_dispatch_table, GUINT_TO_POINTER(kb->key),
+					g_slist_append(NULL, entry));
+			else	/* append keeps the head and so the group scan order for shared keys */
+				g_slist_append(list, entry);
+		}
+	}
+	kb_dispatch_dirty = FALSE;
+}
+
+
 /* central keypress event handler, almost all keypress events go to this function */
 static gboolean on_key_press_event(GtkWidget *widget, GdkEventKey *ev, gpointer user_data)
 {
 	guint state, keyval;
-	gsize g, i;
+	GSList *node;
 	GeanyDocument *doc;
 	GeanyKeyGroup *group;
 	GeanyKeyBinding *kb;
@@ -1260,27 +1332,31 @@ static gboolean on_key_press_event(GtkWidget *widget, GdkEventKey *ev, gpointer
 	if (check_menu_key(doc, keyval, state, ev->time))
 		return TRUE;
 
-	foreach_ptr_array(group, g, keybinding_groups)
+	if (kb_dispatch_dirty)
+		kb_dispatch_rebuild();
+
+	foreach_slist(node, g_hash_table_lookup(kb_dispatch_table, GUINT_TO_POINTER(keyval)))
 	{
-		foreach_ptr_array(kb, i, group->key_items)
+		KbDispatchEntry *entry = node->data;
+
+		kb = entry->kb;
+		group = entry->group;
+		if (state == kb->mods)
 		{
-			if (keyval == kb->key && state == kb->mods)
+			/* call the corresponding callback function for this shortcut */
+			if (kb->callback)
 			{
-				/* call the corresponding callback function for this shortcut */
-				if (kb->callback)
-				{
-					kb->callback(kb->id);
+				kb->callback(kb->id);
+				return TRUE;
+			}
+			else if (group->callback)
+			{
+				if (group->callback(kb->id))
 					return TRUE;
-				}
-				else if (group->callback)
-				{
-					if (group->callback(kb->id))
-						return TRUE;
-					else
-						continue;	/* not handled */
-				}
-				g_warning("No callback for keybinding %s: %s!", group->name, kb->name);
+				else
+					continue;	/* not handled */
 			}
+			g_warning("No callback for keybinding %s: %s!", group->name, kb->name);
 		}
 	}
 	/* fixed keybindings can be overridden by user bindings, so check them last */
@@ -1346,6 +1422,9 @@ static gboolean cb_func_file_action(guint key_id)
 		case GEANY_KEYS_FILE_OPENSELECTED:
 			on_menu_open_selected_file1_activate(NULL, NULL);
 			break;
+		case GEANY_KEYS_FILE_GOTOFILE:
+			dialogs_show_goto_file();
+			break;
 		case GEANY_KEYS_FILE_OPENLASTTAB:
 		{
 			gchar *utf8_filename = g_queue_peek_head(ui_prefs.recent_queue);
@@ -1957,6 +2036,9 @@ static gboolean cb_func_goto_action(guint key_id)
 		case GEANY_KEYS_GOTO_TAGDECLARATION:
 			goto_tag(doc, FALSE);
 			return TRUE;
+		case GEANY_KEYS_GOTO_SYMBOL:
+			symbols_show_goto_symbol_dialog();
+			return TRUE;
 	}
 	/* only check editor-sensitive keybindings when editor has focus so home,end still
 	 * work in other widgets */
@@ -2561,6 +2643,7 @@ void keybindings_update_combo(GeanyKeyBinding *kb, guint key, GdkModifierType mo
 
 	kb->key = key;
 	kb->mods = mods;
+	kb_dispatch_dirty = TRUE;
 
 	if (widget && kb->key)
 		gtk_widget_add_accelerator(widget, "activate", kb_accel_group,
@@ -2587,6 +2670,7 @@ GeanyKeyGroup *keybindings_set_group(GeanyKeyGroup *group, const gchar *section_
 	group->plugin_keys = g_new0(GeanyKeyBinding, count);
 	group->plugin_key_count = count;
 	g_ptr_array_set_size(group->key_items, 0);
+	kb_dispatch_dirty = TRUE;
 	return group;
 }
 
@@ -2595,6 +2679,7 @@ void keybindings_free_group(GeanyKeyGroup *group)
 {
 	GeanyKeyBinding *kb;
 
+	kb_dispatch_dirty = TRUE;
 	g_ptr_array_free(group->key_items, TRUE);
 
 	if (group->plugin)
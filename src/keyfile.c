@@ -42,6 +42,7 @@
 #include "geanyobject.h"
 #include "main.h"
 #include "msgwindow.h"
+#include "navqueue.h"
 #include "prefs.h"
 #include "printing.h"
 #include "project.h"
@@ -57,6 +58,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdio.h>
+
+#include <glib/gstdio.h>
 
 #ifdef HAVE_VTE
 #include <pwd.h>
@@ -102,6 +106,19 @@ static GPtrArray *keyfile_groups = NULL;
 
 GPtrArray *pref_groups = NULL;
 
+/* Asynchronous config writing: serializing a GKeyFile with a large session
+ * and replacing the file on disk is slow enough to cause a perceptible pause
+ * on every settings save, so the snapshot is handed to a worker thread which
+ * performs g_key_file_to_data() and the write. Rapid successive saves are
+ * coalesced - a snapshot that has not been written yet when the next one
+ * arrives is simply dropped in its favour. */
+static GAsyncQueue *config_write_queue = NULL;
+static GThread *config_write_thread = NULL;
+static GStaticMutex config_write_mutex = G_STATIC_MUTEX_INIT;
+static GKeyFile *pending_config = NULL;
+static gchar *pending_configfile = NULL;
+static gint config_write_quit;	/* address used as the thread's quit sentinel */
+
 static struct
 {
 	gint number_ft_menu_items;
@@ -224,6 +241,10 @@ static void init_pref_groups(void)
 		"gio_unsafe_save_backup", FALSE);
 	stash_group_add_boolean(group, &file_prefs.use_gio_unsafe_file_saving,
 		"use_gio_unsafe_file_saving", TRUE);
+	stash_group_add_integer(group, &file_prefs.save_fsync_policy,
+		"save_fsync_policy", GEANY_FSYNC_ALWAYS);
+	stash_group_add_boolean(group, &file_prefs.use_async_file_saving,
+		"use_async_file_saving", FALSE);
 	/* for backwards-compatibility */
 	stash_group_add_integer(group, &editor_prefs.indentation->hard_tab_width,
 		"indent_hard_tab_width", 8);
@@ -231,6 +252,12 @@ static void init_pref_groups(void)
 		"find_selection_type", GEANY_FIND_SEL_CURRENT_WORD);
 	stash_group_add_string(group, &file_prefs.extract_filetype_regex,
 		"extract_filetype_regex", GEANY_DEFAULT_FILETYPE_REGEX);
+	stash_group_add_integer(group, &file_prefs.large_file_size,
+		"large_file_size_mb", 50);
+	stash_group_add_integer(group, &file_prefs.max_memory_usage,
+		"max_memory_usage_mb", 0);
+	stash_group_add_boolean(group, &file_prefs.persist_undo,
+		"persist_undo_history", FALSE);
 	stash_group_add_boolean(group, &search_prefs.replace_and_find_by_default,
 		"replace_and_find_by_default", TRUE);
 
@@ -301,18 +328,28 @@ static void save_recent_files(GKeyFile *config, GQueue *queue, gchar const *key)
 }
 
 
+/* the escaped locale filename is also the key identifying a file in session
+ * entries and in the session journal */
+static gchar *get_session_escaped_filename(GeanyDocument *doc)
+{
+	gchar *locale_filename = utils_get_locale_from_utf8(doc->file_name);
+	gchar *escaped_filename = g_uri_escape_string(locale_filename, NULL, TRUE);
+
+	g_free(locale_filename);
+	return escaped_filename;
+}
+
+
 static gchar *get_session_file_string(GeanyDocument *doc)
 {
 	gchar *fname;
-	gchar *locale_filename;
 	gchar *escaped_filename;
 	GeanyFiletype *ft = doc->file_type;
 
 	if (ft == NULL) /* can happen when saving a new file when quitting */
 		ft = filetypes[GEANY_FILETYPES_NONE];
 
-	locale_filename = utils_get_locale_from_utf8(doc->file_name);
-	escaped_filename = g_uri_escape_string(locale_filename, NULL, TRUE);
+	escaped_filename = get_session_escaped_filename(doc);
 
 	fname = g_strdup_printf("%d;%s;%d;E%s;%d;%d;%d;%s;%d;%d",
 		sci_get_current_position(doc->editor->sci),
@@ -326,7 +363,6 @@ static gchar *get_session_file_string(GeanyDocument *doc)
 		doc->editor->line_breaking,
 		doc->editor->indent_width);
 	g_free(escaped_filename);
-	g_free(locale_filename);
 	return fname;
 }
 
@@ -375,6 +411,8 @@ void configuration_save_session_files(GKeyFile *config)
 		}
 	}
 
+	navqueue_save_to_config(config);
+
 #ifdef HAVE_VTE
 	if (vte_info.have_vte)
 	{
@@ -385,6 +423,196 @@ void configuration_save_session_files(GKeyFile *config)
 }
 
 
+/* Session journal: opening or closing a document appends one line to
+ * session.journal instead of rewriting the whole configuration file, which
+ * grows large with a big session. The journal is replayed on top of the
+ * session list at startup and discarded whenever the full session is written
+ * out, so it only ever carries the changes since the last complete save. */
+#define SESSION_JOURNAL_COMPACT_AFTER 200
+
+static FILE *session_journal = NULL;
+static guint session_journal_entries = 0;
+
+
+static gchar *session_journal_filename(void)
+{
+	return g_build_filename(app->configdir, "session.journal", NULL);
+}
+
+
+static gboolean session_journal_compact_idle(gpointer data)
+{
+	/* writes the full session and resets the journal */
+	configuration_save_default_session();
+	return FALSE;
+}
+
+
+static void session_journal_append(gchar op, const gchar *line)
+{
+	if (session_journal == NULL)
+	{
+		gchar *filename = session_journal_filename();
+
+		session_journal = g_fopen(filename, "ab");
+		g_free(filename);
+		if (session_journal == NULL)
+			return;
+	}
+	fprintf(session_journal, "%c%s\n", op, line);
+	fflush(session_journal);
+	/* compact before the journal outgrows the file it is meant to avoid
+	 * rewriting; from an idle handler so a close being journalled right now
+	 * has finished before the notebook is walked for the full save */
+	if (++session_journal_entries == SESSION_JOURNAL_COMPACT_AFTER)
+		g_idle_add(session_journal_compact_idle, NULL);
+}
+
+
+/* journalling applies to the default session only: project sessions are small
+ * and saved separately, and session changes made while the session itself is
+ * being opened or torn down are part of a full save anyway */
+static gboolean session_journal_usable(GeanyDocument *doc)
+{
+	return cl_options.load_session && app->project == NULL &&
+		! main_status.opening_session_files && ! main_status.closing_all &&
+		! main_status.quitting && doc->real_path != NULL;
+}
+
+
+void configuration_journal_document_open(GeanyDocument *doc)
+{
+	gchar *str;
+
+	if (! session_journal_usable(doc))
+		return;
+	str = get_session_file_string(doc);
+	session_journal_append('+', str);
+	g_free(str);
+}
+
+
+void configuration_journal_document_close(GeanyDocument *doc)
+{
+	gchar *escaped_filename;
+
+	if (! session_journal_usable(doc))
+		return;
+	escaped_filename = get_session_escaped_filename(doc);
+	session_journal_append('-', escaped_filename);
+	g_free(escaped_filename);
+}
+
+
+/* MRU changes are journalled too: the recent files lists are otherwise only
+ * written with a full configuration save, so without the journal every list
+ * update would have to rewrite geany.conf to survive a crash */
+void configuration_journal_recent_file(const gchar *utf8_filename, gboolean project)
+{
+	gchar *escaped;
+
+	if (! cl_options.load_session || main_status.opening_session_files ||
+		main_status.closing_all || main_status.quitting)
+		return;
+	escaped = g_uri_escape_string(utf8_filename, NULL, TRUE);
+	session_journal_append(project ? 'p' : 'r', escaped);
+	g_free(escaped);
+}
+
+
+/* discard the journal after a full session save has been queued; should the
+ * process die before the worker thread finishes the write, at worst the
+ * session falls back to the previous complete save, as it always did */
+static void session_journal_reset(void)
+{
+	gchar *filename = session_journal_filename();
+
+	if (session_journal != NULL)
+	{
+		fclose(session_journal);
+		session_journal = NULL;
+	}
+	session_journal_entries = 0;
+	g_unlink(filename);
+	g_free(filename);
+}
+
+
+/* drop every session entry for the given escaped filename */
+static void session_journal_remove_file(const gchar *escaped_filename)
+{
+	guint i;
+
+	for (i = 0; i < session_files->len; i++)
+	{
+		gchar **tmp = g_ptr_array_index(session_files, i);
+
+		if (tmp != NULL && g_strv_length(tmp) >= 8 &&
+			utils_str_equal(tmp[7], escaped_filename))
+		{
+			g_strfreev(tmp);
+			g_ptr_array_index(session_files, i) = NULL;
+		}
+	}
+}
+
+
+/* apply the journalled opens and closes on top of the session list loaded
+ * from the configuration file */
+static void session_journal_replay(void)
+{
+	gchar *filename = session_journal_filename();
+	gchar *contents = NULL;
+	gchar **lines, **line;
+
+	if (g_file_get_contents(filename, &contents, NULL, NULL))
+	{
+		lines = g_strsplit(contents, "\n", 0);
+		foreach_strv(line, lines)
+		{
+			if (**line == '+')
+			{
+				gchar **tmp = g_strsplit(*line + 1, ";", 0);
+
+				if (g_strv_length(tmp) >= 8)
+				{
+					/* a reopened file replaces its previous entry */
+					session_journal_remove_file(tmp[7]);
+					g_ptr_array_add(session_files, tmp);
+				}
+				else
+					g_strfreev(tmp);
+			}
+			else if (**line == '-')
+				session_journal_remove_file(*line + 1);
+			else if (**line == 'r' || **line == 'p')
+			{
+				GQueue *queue = (**line == 'p') ?
+					ui_prefs.recent_projects_queue : ui_prefs.recent_queue;
+				gchar *utf8_filename = g_uri_unescape_string(*line + 1, NULL);
+				GList *item;
+
+				if (utf8_filename == NULL)
+					continue;
+				/* most recently used in front, no duplicates, bounded length */
+				item = g_queue_find_custom(queue, utf8_filename, (GCompareFunc) strcmp);
+				if (item != NULL)
+				{
+					g_free(item->data);
+					g_queue_delete_link(queue, item);
+				}
+				g_queue_push_head(queue, utf8_filename);
+				while (g_queue_get_length(queue) > file_prefs.mru_length)
+					g_free(g_queue_pop_tail(queue));
+			}
+		}
+		g_strfreev(lines);
+		g_free(contents);
+	}
+	g_free(filename);
+}
+
+
 static void save_dialog_prefs(GKeyFile *config)
 {
 	/* new settings should be added in init_pref_groups() */
@@ -586,13 +814,89 @@ static void save_ui_prefs(GKeyFile *config)
 }
 
 
+static gpointer config_write_thread_func(gpointer data)
+{
+	gpointer token;
+
+	while ((token = g_async_queue_pop(config_write_queue)) != (gpointer) &config_write_quit)
+	{
+		GKeyFile *config;
+		gchar *configfile;
+		gchar *file_data;
+
+		/* take the latest coalesced snapshot; a token whose snapshot has
+		 * been superseded finds the slot empty */
+		g_static_mutex_lock(&config_write_mutex);
+		config = pending_config;
+		configfile = pending_configfile;
+		pending_config = NULL;
+		pending_configfile = NULL;
+		g_static_mutex_unlock(&config_write_mutex);
+
+		if (config == NULL)
+			continue;
+
+		file_data = g_key_file_to_data(config, NULL, NULL);
+		utils_write_file(configfile, file_data);
+		g_free(file_data);
+		g_key_file_free(config);
+		g_free(configfile);
+	}
+	return NULL;
+}
+
+
+/* Queues @config to be serialized and written to @configfile from a worker
+ * thread; takes ownership of both arguments. If a previously queued snapshot
+ * has not been written yet, it is replaced, so bursts of saves result in a
+ * single write of the final state. */
+static void write_config_file_async(gchar *configfile, GKeyFile *config)
+{
+	if (config_write_queue == NULL)
+	{
+		config_write_queue = g_async_queue_new();
+		config_write_thread = g_thread_create(config_write_thread_func, NULL, TRUE, NULL);
+	}
+	g_static_mutex_lock(&config_write_mutex);
+	if (pending_config != NULL)
+	{	/* coalesce with the still unwritten previous snapshot */
+		g_key_file_free(pending_config);
+		g_free(pending_configfile);
+	}
+	pending_config = config;
+	pending_configfile = configfile;
+	g_static_mutex_unlock(&config_write_mutex);
+	g_async_queue_push(config_write_queue, config_write_queue);
+}
+
+
+/* Loads @configfile into @config, preferring a queued but not yet written
+ * snapshot over the (then stale) on-disk contents. */
+static void load_config_file(GKeyFile *config, const gchar *configfile)
+{
+	gboolean loaded = FALSE;
+
+	g_static_mutex_lock(&config_write_mutex);
+	if (pending_config != NULL && utils_str_equal(pending_configfile, configfile))
+	{
+		gchar *file_data = g_key_file_to_data(pending_config, NULL, NULL);
+
+		loaded = g_key_file_load_from_data(config, file_data, -1, G_KEY_FILE_NONE, NULL);
+		g_free(file_data);
+	}
+	g_static_mutex_unlock(&config_write_mutex);
+
+	if (! loaded)
+		g_key_file_load_from_file(config, configfile, G_KEY_FILE_NONE, NULL);
+}
+
+
 void configuration_save(void)
 {
 	GKeyFile *config = g_key_file_new();
 	gchar *configfile = g_build_filename(app->configdir, "geany.conf", NULL);
-	gchar *data;
 
-	g_key_file_load_from_file(config, configfile, G_KEY_FILE_NONE, NULL);
+	load_config_file(config, configfile);
 
 	/* this signal can be used e.g. to prepare any settings before Stash code reads them below */
 	g_signal_emit_by_name(geany_object, "save-settings", config);
@@ -604,7 +908,10 @@ void configuration_save(void)
 	save_recent_files(config, ui_prefs.recent_projects_queue, "recent_projects");
 
 	if (cl_options.load_session)
+	{
 		configuration_save_session_files(config);
+		session_journal_reset();
+	}
 #ifdef HAVE_VTE
 	else if (vte_info.have_vte)
 	{
@@ -613,13 +920,9 @@ void configuration_save(void)
 	}
 #endif
 
-	/* write the file */
-	data = g_key_file_to_data(config, NULL, NULL);
-	utils_write_file(configfile, data);
-	g_free(data);
-
-	g_key_file_free(config);
-	g_free(configfile);
+	/* the worker thread serializes and writes the file, and takes ownership
+	 * of config and configfile */
+	write_config_file_async(configfile, config);
 }
 
 
@@ -682,6 +985,8 @@ void configuration_load_session_files(GKeyFile *config, gboolean read_recent_fil
 		i++;
 	}
 
+	navqueue_load_from_config(config);
+
 #ifdef HAVE_VTE
 	/* BUG: after loading project at startup, closing project doesn't restore old VTE path */
 	if (vte_info.have_vte)
@@ -1032,42 +1337,38 @@ static void load_ui_prefs(GKeyFile *config)
 void configuration_save_default_session(void)
 {
 	gchar *configfile = g_build_filename(app->configdir, "geany.conf", NULL);
-	gchar *data;
 	GKeyFile *config = g_key_file_new();
 
-	g_key_file_load_from_file(config, configfile, G_KEY_FILE_NONE, NULL);
+	load_config_file(config, configfile);
 
 	if (cl_options.load_session)
+	{
+		/* the journal also carries MRU updates, so write the lists out
+		 * before the reset discards those records */
+		save_recent_files(config, ui_prefs.recent_queue, "recent_files");
+		save_recent_files(config, ui_prefs.recent_projects_queue, "recent_projects");
 		configuration_save_session_files(config);
+		session_journal_reset();
+	}
 
-	/* write the file */
-	data = g_key_file_to_data(config, NULL, NULL);
-	utils_write_file(configfile, data);
-	g_free(data);
-
-	g_key_file_free(config);
-	g_free(configfile);
+	write_config_file_async(configfile, config);
 }
 
 
 void configuration_clear_default_session(void)
 {
 	gchar *configfile = g_build_filename(app->configdir, "geany.conf", NULL);
-	gchar *data;
 	GKeyFile *config = g_key_file_new();
 
-	g_key_file_load_from_file(config, configfile, G_KEY_FILE_NONE, NULL);
+	load_config_file(config, configfile);
 
 	if (cl_options.load_session)
+	{
 		remove_session_files(config);
+		session_journal_reset();
+	}
 
-	/* write the file */
-	data = g_key_file_to_data(config, NULL, NULL);
-	utils_write_file(configfile, data);
-	g_free(data);
-
-	g_key_file_free(config);
-	g_free(configfile);
+	write_config_file_async(configfile, config);
 }
 
 
@@ -1079,7 +1380,7 @@ void configuration_reload_default_session(void)
 	gchar *configfile = g_build_filename(app->configdir, "geany.conf", NULL);
 	GKeyFile *config = g_key_file_new();
 
-	g_key_file_load_from_file(config, configfile, G_KEY_FILE_NONE, NULL);
+	load_config_file(config, configfile);
 	g_free(configfile);
 
 	configuration_load_session_files(config, FALSE);
@@ -1106,6 +1407,8 @@ gboolean configuration_load(void)
 	load_ui_prefs(config);
 	project_load_prefs(config);
 	configuration_load_session_files(config, TRUE);
+	if (cl_options.load_session)
+		session_journal_replay();
 
 	/* this signal can be used e.g. to delay building UI elements until settings have been read */
 	g_signal_emit_by_name(geany_object, "load-settings", config);
@@ -1190,6 +1493,9 @@ void configuration_open_files(void)
 	/* necessary to set it to TRUE for project session support */
 	main_status.opening_session_files = TRUE;
 
+	/* announce the whole session to plugins in one "documents-opened" emission */
+	document_open_batch_begin();
+
 	i = file_prefs.tab_order_ltr ? 0 : (session_files->len - 1);
 	while (TRUE)
 	{
@@ -1220,6 +1526,8 @@ void configuration_open_files(void)
 	g_ptr_array_free(session_files, TRUE);
 	session_files = NULL;
 
+	document_open_batch_end();
+
 	if (failure)
 		ui_set_statusbar(TRUE, _("Failed to load one or more session files."));
 	else
@@ -1290,6 +1598,13 @@ void configuration_finalize(void)
 	guint i;
 	StashGroup *group;
 
+	if (config_write_thread != NULL)
+	{	/* flush any outstanding config write before shutting down */
+		g_async_queue_push(config_write_queue, &config_write_quit);
+		g_thread_join(config_write_thread);
+		config_write_thread = NULL;
+	}
+
 	foreach_ptr_array(group, i, keyfile_groups)
 		stash_group_free(group);
 
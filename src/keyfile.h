@@ -56,6 +56,14 @@ void configuration_load_session_files(GKeyFile *config, gboolean read_recent_fil
 
 void configuration_save_session_files(GKeyFile *config);
 
+struct GeanyDocument;
+
+void configuration_journal_document_open(struct GeanyDocument *doc);
+
+void configuration_journal_document_close(struct GeanyDocument *doc);
+
+void configuration_journal_recent_file(const gchar *utf8_filename, gboolean project);
+
 /* set some settings which are already read from the config file, but need other things, like the
  * realisation of the main window */
 void configuration_apply_settings(void);
@@ -47,9 +47,12 @@
 #include "navqueue.h"
 #include "notebook.h"
 #include "plugins.h"
+#include "pluginutils.h"
 #include "prefs.h"
 #include "printing.h"
+#include "respack.h"
 #include "sidebar.h"
+#include "stats.h"
 #ifdef HAVE_SOCKET
 # include "socket.h"
 #endif
@@ -58,10 +61,12 @@
 #include "templates.h"
 #include "toolbar.h"
 #include "tools.h"
+#include "trace.h"
 #include "ui_utils.h"
 #include "utils.h"
 #include "vte.h"
 #include "win32.h"
+#include "worker.h"
 
 #include "gtkcompat.h"
 
@@ -70,6 +75,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -110,6 +116,54 @@ static gboolean print_prefix = FALSE;
 static gboolean no_plugins = FALSE;
 #endif
 static gboolean dummy = FALSE;
+static gboolean profile_startup = FALSE;
+
+/* --profile-startup phase timers */
+static GTimer *startup_timer = NULL;
+static GString *startup_phase_report = NULL;
+
+
+/* Records the end of a startup phase; the elapsed time since the previous
+ * mark is attributed to @a name. Does nothing unless --profile-startup was
+ * given. */
+static void profile_phase(const gchar *name)
+{
+	static gdouble last = 0.0;
+	gdouble now;
+
+	if (! profile_startup || startup_timer == NULL)
+		return;
+
+	if (startup_phase_report == NULL)
+		startup_phase_report = g_string_new(NULL);
+
+	now = g_timer_elapsed(startup_timer, NULL);
+	g_string_append_printf(startup_phase_report, "  %-36s %8.1f ms\n",
+		name, (now - last) * 1000.0);
+	last = now;
+}
+
+
+/* Prints the phase breakdown collected by profile_phase(). Called from an
+ * idle handler so the total includes everything up to the point where the
+ * main loop first becomes idle, i.e. the perceived startup time. */
+static void profile_report(void)
+{
+	if (! profile_startup || startup_timer == NULL)
+		return;
+
+	g_print(_("Startup phase breakdown:\n"));
+	if (startup_phase_report != NULL)
+	{
+		g_print("%s", startup_phase_report->str);
+		g_string_free(startup_phase_report, TRUE);
+		startup_phase_report = NULL;
+	}
+	g_print("  %-36s %8.1f ms\n", _("total (to first idle)"),
+		g_timer_elapsed(startup_timer, NULL) * 1000.0);
+	g_timer_destroy(startup_timer);
+	startup_timer = NULL;
+}
 
 /* in alphabetical order of short options */
 static GOptionEntry entries[] =
@@ -131,6 +185,7 @@ static GOptionEntry entries[] =
 	{ "no-plugins", 'p', 0, G_OPTION_ARG_NONE, &no_plugins, N_("Don't load plugins"), NULL },
 #endif
 	{ "print-prefix", 0, 0, G_OPTION_ARG_NONE, &print_prefix, N_("Print Geany's installation prefix"), NULL },
+	{ "profile-startup", 0, 0, G_OPTION_ARG_NONE, &profile_startup, N_("Print a timing breakdown of the startup phases"), NULL },
 	{ "read-only", 'r', 0, G_OPTION_ARG_NONE, &cl_options.readonly, N_("Open all FILES in read-only mode (see documention)"), NULL },
 	{ "no-session", 's', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &cl_options.load_session, N_("Don't load the previous session's files"), NULL },
 #ifdef HAVE_VTE
@@ -970,6 +1025,7 @@ static void load_startup_files(gint argc, gchar **argv)
 static gboolean send_startup_complete(gpointer data)
 {
 	g_signal_emit_by_name(geany_object, "geany-startup-complete");
+	profile_report();
 	return FALSE;
 }
 
@@ -1036,11 +1092,22 @@ gint main(gint argc, gchar **argv)
 	gint config_dir_result;
 	const gchar *locale;
 
+#ifdef HAVE_PLUGINS
+	/* replaces the GLib allocator, so nothing may allocate before this */
+	plugin_memory_init();
+#endif
+
 #if ! GLIB_CHECK_VERSION(2, 36, 0)
 	g_type_init();
 #endif
 
 	log_handlers_init();
+	stats_init();
+	trace_init();
+
+	/* started unconditionally as --profile-startup is only known after option
+	 * parsing; a single unused GTimer is cheap */
+	startup_timer = g_timer_new();
 
 	app = g_new0(GeanyApp, 1);
 	memset(&main_status, 0, sizeof(GeanyStatus));
@@ -1070,6 +1137,9 @@ gint main(gint argc, gchar **argv)
 		g_thread_init(NULL);
 #endif
 
+	/* needs the thread system, so cannot happen any earlier */
+	worker_init();
+
 	/* removed as signal handling was wrong, see signal_cb()
 	signal(SIGTERM, signal_cb); */
 
@@ -1125,11 +1195,18 @@ gint main(gint argc, gchar **argv)
 	geany_debug("System data dir: %s", app->datadir);
 	geany_debug("User config dir: %s", app->configdir);
 
+	/* map the bundled resource pack, if installed, before anything reads
+	 * from the system data dir */
+	respack_init(app->datadir);
+
+	profile_phase("early setup (locale, config dir, socket)");
+
 	/* create the object so Geany signals can be connected in init() functions */
 	geany_object = geany_object_new();
 
 	/* inits */
 	main_init();
+	profile_phase("main_init (main window construction)");
 
 	encodings_init();
 	editor_init();
@@ -1143,7 +1220,9 @@ gint main(gint argc, gchar **argv)
 	plugins_init();
 #endif
 	sidebar_init();
+	profile_phase("stash groups and component init");
 	load_settings();	/* load keyfile */
+	profile_phase("configuration load");
 
 	msgwin_init();
 	build_init();
@@ -1162,6 +1241,7 @@ gint main(gint argc, gchar **argv)
 	vte_init();
 #endif
 	ui_create_recent_menus();
+	profile_phase("filetypes, templates and UI setup");
 
 	ui_set_statusbar(TRUE, _("This is Geany %s."), main_get_version_string());
 	if (config_dir_result != 0)
@@ -1170,15 +1250,37 @@ gint main(gint argc, gchar **argv)
 
 	/* apply all configuration options */
 	apply_settings();
+	profile_phase("apply_settings");
+
+	ui_sidebar_show_hide();
+
+#ifdef G_OS_WIN32
+	/* Manually realise the main window to be able to set the position but don't show it.
+	 * We don't set the position after showing the window to avoid flickering. */
+	gtk_widget_realize(main_widgets.window);
+#endif
+	setup_window_position();
+
+	/* the window is fully constructed and configured now, so show and paint
+	 * it before the remaining expensive phases (plugins, session files): the
+	 * first paint is what the user perceives as startup */
+	gtk_widget_show(main_widgets.window);
+	main_status.main_window_realized = TRUE;
+
+	configuration_apply_settings();
+
+	/* drain the pending map and draw events so the window really appears */
+	while (gtk_events_pending())
+		gtk_main_iteration();
+	profile_phase("window setup, show and first paint");
 
 #ifdef HAVE_PLUGINS
 	/* load any enabled plugins before we open any documents */
 	if (want_plugins)
 		plugins_load_active();
+	profile_phase("plugins_load_active");
 #endif
 
-	ui_sidebar_show_hide();
-
 	/* set the active sidebar page after plugins have been loaded */
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(main_widgets.sidebar_notebook), ui_prefs.sidebar_page);
 
@@ -1193,6 +1295,7 @@ gint main(gint argc, gchar **argv)
 	main_status.opening_session_files = TRUE;
 	load_startup_files(argc, argv);
 	main_status.opening_session_files = FALSE;
+	profile_phase("session and command line files");
 
 	/* open a new file if no other file was opened */
 	document_new_file_if_non_open();
@@ -1204,20 +1307,7 @@ gint main(gint argc, gchar **argv)
 	sidebar_select_openfiles_item(doc);
 	build_menu_update(doc);
 	sidebar_update_tag_list(doc, FALSE);
-
-#ifdef G_OS_WIN32
-	/* Manually realise the main window to be able to set the position but don't show it.
-	 * We don't set the position after showing the window to avoid flickering. */
-	gtk_widget_realize(main_widgets.window);
-#endif
-	setup_window_position();
-
-	/* finally show the window */
 	document_grab_focus(doc);
-	gtk_widget_show(main_widgets.window);
-	main_status.main_window_realized = TRUE;
-
-	configuration_apply_settings();
 
 #ifdef HAVE_SOCKET
 	/* register the callback of socket input */
@@ -1258,6 +1348,9 @@ static void do_main_quit(void)
 		project_close(FALSE);   /* save project session files */
 
 	document_close_all();
+	/* saves queued to the worker pool must reach the disk before the main
+	 * loop stops */
+	document_wait_for_saves();
 
 	main_status.quitting = TRUE;
 
@@ -1269,6 +1362,10 @@ static void do_main_quit(void)
 	plugins_finalize();
 #endif
 
+	/* stop the background scheduler before tearing down the state its work
+	 * functions may still reference */
+	worker_finalize();
+
 	navqueue_free();
 	keybindings_free();
 	notebook_free();
@@ -1288,6 +1385,9 @@ static void do_main_quit(void)
 	configuration_finalize();
 	filetypes_free_types();
 	log_finalize();
+	stats_finalize();
+	trace_finalize();
+	respack_finalize();
 
 	tm_workspace_free();
 	g_free(app->configdir);
@@ -1394,12 +1494,105 @@ gboolean main_quit(void)
 	return FALSE;
 }
 
+
+/* Change detection for main_reload_configuration(): each rebuild step hashes
+ * the configuration sources it reads, so repeated reloads (e.g. triggered by
+ * dotfile sync tools) only rebuild the artifacts whose sources changed and
+ * the common nothing-changed reload stays well under the UI hiccup
+ * threshold. */
+enum
+{
+	CONFIG_HASH_TEMPLATES,
+	CONFIG_HASH_SNIPPETS,
+	CONFIG_HASH_FILETYPES,
+	CONFIG_HASH_IGNORE_TAGS,
+	CONFIG_HASH_COUNT
+};
+
+static gchar *config_hashes[CONFIG_HASH_COUNT] = { NULL };
+
+
+static void config_checksum_add_file(GChecksum *sum, const gchar *path)
+{
+	gchar *contents = NULL;
+	gsize length = 0;
+
+	/* include the path so content moving between files is a change too */
+	g_checksum_update(sum, (const guchar *) path, (gssize) strlen(path) + 1);
+	if (g_file_get_contents(path, &contents, &length, NULL))
+	{
+		g_checksum_update(sum, (const guchar *) contents, (gssize) length);
+		g_free(contents);
+	}
+}
+
+
+static void config_checksum_add_dir(GChecksum *sum, const gchar *path)
+{
+	GDir *dir = g_dir_open(path, 0, NULL);
+	GSList *names = NULL, *item;
+	const gchar *name;
+
+	if (dir == NULL)
+		return;
+	while ((name = g_dir_read_name(dir)) != NULL)
+		names = g_slist_prepend(names, g_strdup(name));
+	g_dir_close(dir);
+	/* the filesystem's read order is not stable, the checksum must be */
+	names = g_slist_sort(names, (GCompareFunc) strcmp);
+	foreach_slist(item, names)
+	{
+		gchar *file = g_build_filename(path, item->data, NULL);
+
+		if (g_file_test(file, G_FILE_TEST_IS_REGULAR))
+			config_checksum_add_file(sum, file);
+		g_free(file);
+		g_free(item->data);
+	}
+	g_slist_free(names);
+}
+
+
+/* Checksums the given NULL-terminated list of files and directories
+ * (directories contribute the files directly inside them) and returns whether
+ * the result differs from the last reload of this section, remembering it. */
+static gboolean config_section_changed(guint section, ...)
+{
+	GChecksum *sum = g_checksum_new(G_CHECKSUM_MD5);
+	va_list args;
+	const gchar *path;
+	gchar *result;
+	gboolean changed;
+
+	va_start(args, section);
+	while ((path = va_arg(args, const gchar *)) != NULL)
+	{
+		if (g_file_test(path, G_FILE_TEST_IS_DIR))
+			config_checksum_add_dir(sum, path);
+		else
+			config_checksum_add_file(sum, path);
+	}
+	va_end(args);
+	result = g_strdup(g_checksum_get_string(sum));
+	g_checksum_free(sum);
+
+	changed = g_strcmp0(result, config_hashes[section]) != 0;
+	if (changed)
+		SETPTR(config_hashes[section], result);
+	else
+		g_free(result);
+	return changed;
+}
+
+
 /**
  *  Reloads most of Geany's configuration files without restarting. Currently the following
  *  files are reloaded: all template files, also new file templates and the 'New (with template)'
  *  menus will be updated, Snippets (snippets.conf), filetype extensions (filetype_extensions.conf),
  *  and 'settings' and 'build_settings' sections of the filetype definition files.
  *
+ *  Only the parts whose files actually changed since the last reload are rebuilt.
+ *
  *  Plugins may call this function if they changed any of these files (e.g. a configuration file
  *  editor plugin).
  *
@@ -1407,19 +1600,56 @@ gboolean main_quit(void)
  **/
 void main_reload_configuration(void)
 {
-	/* reload templates */
-	templates_free_templates();
-	templates_init();
+	gchar *sys_templates = g_build_filename(app->datadir, GEANY_TEMPLATES_SUBDIR, NULL);
+	gchar *user_templates = g_build_filename(app->configdir, GEANY_TEMPLATES_SUBDIR, NULL);
+	gchar *sys_file_templates = g_build_filename(sys_templates, "files", NULL);
+	gchar *user_file_templates = g_build_filename(user_templates, "files", NULL);
+	gchar *sys_snippets = g_build_filename(app->datadir, "snippets.conf", NULL);
+	gchar *user_snippets = g_build_filename(app->configdir, "snippets.conf", NULL);
+	gchar *sys_extensions = g_build_filename(app->datadir, "filetype_extensions.conf", NULL);
+	gchar *user_extensions = g_build_filename(app->configdir, "filetype_extensions.conf", NULL);
+	gchar *sys_filedefs = g_build_filename(app->datadir, GEANY_FILEDEFS_SUBDIR, NULL);
+	gchar *user_filedefs = g_build_filename(app->configdir, GEANY_FILEDEFS_SUBDIR, NULL);
+	gchar *ignore_tags = g_build_filename(app->configdir, "ignore.tags", NULL);
+
+	if (config_section_changed(CONFIG_HASH_TEMPLATES, sys_templates, user_templates,
+			sys_file_templates, user_file_templates, NULL))
+	{
+		templates_free_templates();
+		templates_init();
+	}
 
-	/* reload snippets */
-	editor_snippets_free();
-	editor_snippets_init();
+	if (config_section_changed(CONFIG_HASH_SNIPPETS, sys_snippets, user_snippets, NULL))
+	{
+		editor_snippets_free();
+		editor_snippets_init();
+	}
 
-	filetypes_reload_extensions();
-	filetypes_reload();
+	if (config_section_changed(CONFIG_HASH_FILETYPES, sys_extensions, user_extensions,
+			sys_filedefs, user_filedefs, NULL))
+	{
+		filetypes_reload_extensions();
+		/* definition files may have been edited, so compiled style sets cannot
+		 * be reused */
+		highlighting_invalidate_compiled_schemes();
+		filetypes_reload();
+	}
 
 	/* C tag names to ignore */
-	symbols_reload_config_files();
+	if (config_section_changed(CONFIG_HASH_IGNORE_TAGS, ignore_tags, NULL))
+		symbols_reload_config_files();
+
+	g_free(sys_templates);
+	g_free(user_templates);
+	g_free(sys_file_templates);
+	g_free(user_file_templates);
+	g_free(sys_snippets);
+	g_free(user_snippets);
+	g_free(sys_extensions);
+	g_free(user_extensions);
+	g_free(sys_filedefs);
+	g_free(user_filedefs);
+	g_free(ignore_tags);
 
 	ui_set_statusbar(TRUE, _("Configuration files reloaded."));
 }
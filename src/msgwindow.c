@@ -90,6 +90,9 @@ static GtkWidget *create_message_popup_menu(gint type);
 static gboolean on_msgwin_button_press_event(GtkWidget *widget, GdkEventButton *event,
 																			gpointer user_data);
 static void on_scribble_populate(GtkTextView *textview, GtkMenu *arg1, gpointer user_data);
+static void msgwin_update_model_attachment(gint visible_tab);
+static void on_msgwin_notebook_switch_page(GtkNotebook *notebook,
+		gpointer page, guint page_num, gpointer user_data);
 
 
 void msgwin_show_hide_tabs(void)
@@ -123,6 +126,13 @@ void msgwin_init(void)
 	prepare_status_tree_view();
 	prepare_msg_tree_view();
 	prepare_compiler_tree_view();
+	/* hidden tabs keep their models detached so rows streaming into them
+	 * (e.g. compiler output during a background build) are plain list store
+	 * appends without any tree view signal processing */
+	g_signal_connect(msgwindow.notebook, "switch-page",
+		G_CALLBACK(on_msgwin_notebook_switch_page), NULL);
+	msgwin_update_model_attachment(
+		gtk_notebook_get_current_page(GTK_NOTEBOOK(msgwindow.notebook)));
 	msgwindow.popup_status_menu = create_message_popup_menu(MSG_STATUS);
 	msgwindow.popup_msg_menu = create_message_popup_menu(MSG_MESSAGE);
 	msgwindow.popup_compiler_menu = create_message_popup_menu(MSG_COMPILER);
@@ -135,6 +145,97 @@ void msgwin_init(void)
 void msgwin_finalize(void)
 {
 	g_free(msgwindow.messages_dir);
+	g_object_unref(msgwindow.store_status);
+	g_object_unref(msgwindow.store_msg);
+	g_object_unref(msgwindow.store_compiler);
+}
+
+
+static GtkTreeView *msgwin_tab_tree_view(gint tabnum)
+{
+	switch (tabnum)
+	{
+		case MSG_STATUS: return GTK_TREE_VIEW(msgwindow.tree_status);
+		case MSG_COMPILER: return GTK_TREE_VIEW(msgwindow.tree_compiler);
+		case MSG_MESSAGE: return GTK_TREE_VIEW(msgwindow.tree_msg);
+	}
+	return NULL;
+}
+
+
+static GtkTreeModel *msgwin_tab_model(gint tabnum)
+{
+	switch (tabnum)
+	{
+		case MSG_STATUS: return GTK_TREE_MODEL(msgwindow.store_status);
+		case MSG_COMPILER: return GTK_TREE_MODEL(msgwindow.store_compiler);
+		case MSG_MESSAGE: return GTK_TREE_MODEL(msgwindow.store_msg);
+	}
+	return NULL;
+}
+
+
+static void msgwin_scroll_to_end(GtkTreeView *view, GtkTreeModel *model)
+{
+	gint n = gtk_tree_model_iter_n_children(model, NULL);
+
+	if (n > 0)
+	{
+		GtkTreePath *path = gtk_tree_path_new_from_indices(n - 1, -1);
+
+		gtk_tree_view_scroll_to_cell(view, path, NULL, TRUE, 0.5, 0.5);
+		gtk_tree_path_free(path);
+	}
+}
+
+
+/* Attaches the model of the visible tab to its tree view and detaches the
+ * models of the hidden tabs.  With the model detached, filling a hidden tab
+ * never triggers row rendering or size negotiation; the rows appear when the
+ * user switches to the tab. */
+static void msgwin_update_model_attachment(gint visible_tab)
+{
+	gint tab;
+
+	for (tab = MSG_STATUS; tab <= MSG_MESSAGE; tab++)
+	{
+		GtkTreeView *view = msgwin_tab_tree_view(tab);
+
+		if (tab == visible_tab)
+		{
+			if (gtk_tree_view_get_model(view) == NULL)
+			{
+				GtkTreeModel *model = msgwin_tab_model(tab);
+
+				gtk_tree_view_set_model(view, model);
+				/* jump to the rows appended while the tab was hidden */
+				if (tab == MSG_STATUS ||
+					(tab == MSG_COMPILER && interface_prefs.compiler_tab_autoscroll))
+					msgwin_scroll_to_end(view, model);
+			}
+		}
+		else
+			gtk_tree_view_set_model(view, NULL);
+	}
+}
+
+
+static void on_msgwin_notebook_switch_page(GtkNotebook *notebook,
+		gpointer page, guint page_num, gpointer user_data)
+{
+	msgwin_update_model_attachment((gint) page_num);
+}
+
+
+/* Makes sure the tab's model is attached to its tree view, for callers that
+ * navigate a tab's rows without switching to it first (e.g. Next Error).
+ * The next page switch restores the one-attached-model state. */
+void msgwin_attach_tab_model(gint tabnum)
+{
+	GtkTreeView *view = msgwin_tab_tree_view(tabnum);
+
+	if (view != NULL && gtk_tree_view_get_model(view) == NULL)
+		gtk_tree_view_set_model(view, msgwin_tab_model(tabnum));
 }
 
 
@@ -168,9 +269,10 @@ static void prepare_status_tree_view(void)
 	GtkCellRenderer *renderer;
 	GtkTreeViewColumn *column;
 
+	/* msgwindow keeps its own reference: the model is detached from the view
+	 * whenever the tab is hidden, see msgwin_update_model_attachment() */
 	msgwindow.store_status = gtk_list_store_new(1, G_TYPE_STRING);
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_status), GTK_TREE_MODEL(msgwindow.store_status));
-	g_object_unref(msgwindow.store_status);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(_("Status messages"), renderer, "text", 0, NULL);
@@ -197,7 +299,6 @@ static void prepare_msg_tree_view(void)
 	msgwindow.store_msg = gtk_list_store_new(MSG_COL_COUNT, G_TYPE_INT, G_TYPE_UINT,
 		GDK_TYPE_COLOR, G_TYPE_STRING);
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_msg), GTK_TREE_MODEL(msgwindow.store_msg));
-	g_object_unref(msgwindow.store_msg);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
@@ -234,7 +335,6 @@ static void prepare_compiler_tree_view(void)
 
 	msgwindow.store_compiler = gtk_list_store_new(COMPILER_COL_COUNT, GDK_TYPE_COLOR, G_TYPE_STRING);
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_compiler), GTK_TREE_MODEL(msgwindow.store_compiler));
-	g_object_unref(msgwindow.store_compiler);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
@@ -315,10 +415,12 @@ void msgwin_compiler_add_string(gint msg_color, const gchar *msg)
 	gtk_list_store_set(msgwindow.store_compiler, &iter,
 		COMPILER_COL_COLOR, color, COMPILER_COL_STRING, utf8_msg, -1);
 
-	if (ui_prefs.msgwindow_visible && interface_prefs.compiler_tab_autoscroll)
+	/* no model is attached while the tab is hidden; scrolling happens when
+	 * the user switches to it */
+	if (ui_prefs.msgwindow_visible && interface_prefs.compiler_tab_autoscroll &&
+		gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_compiler)) != NULL)
 	{
-		path = gtk_tree_model_get_path(
-			gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_compiler)), &iter);
+		path = gtk_tree_model_get_path(GTK_TREE_MODEL(msgwindow.store_compiler), &iter);
 		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(msgwindow.tree_compiler), path, NULL, TRUE, 0.5, 0.5);
 		gtk_tree_path_free(path);
 	}
@@ -373,6 +475,114 @@ void msgwin_msg_add(gint msg_color, gint line, GeanyDocument *doc, const gchar *
 }
 
 
+/* Batched message appending: while a batch is open, rows are queued instead
+ * of being appended to the list store directly, and an idle handler inserts
+ * them in chunks with the model detached from the view. This avoids running
+ * the view's row-inserted machinery for every single row, which dominates
+ * the cost of e.g. Find Usage with tens of thousands of matches, and keeps
+ * the UI responsive while huge result sets stream in. */
+
+#define MSG_BATCH_CHUNK_SIZE 1000
+
+typedef struct
+{
+	gint line;
+	guint doc_id;
+	const GdkColor *color; /* points at a static color from get_color() */
+	gchar *msg;
+} MsgRow;
+
+static GQueue pending_msg_rows = G_QUEUE_INIT;
+static guint pending_msg_idle_id = 0;
+static guint msg_batch_depth = 0;
+static guint msg_batch_total = 0;
+
+
+static void msg_row_free(MsgRow *row)
+{
+	g_free(row->msg);
+	g_slice_free(MsgRow, row);
+}
+
+
+static gboolean flush_pending_msg_rows(gpointer data)
+{
+	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_msg));
+	GtkTreeIter iter;
+	MsgRow *row;
+	guint n = 0;
+
+	/* detach the model so the view does not process a row-inserted signal
+	 * per appended row; it is already detached when the tab is hidden */
+	if (model != NULL)
+	{
+		g_object_ref(model);
+		gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_msg), NULL);
+	}
+	while (n < MSG_BATCH_CHUNK_SIZE &&
+		(row = g_queue_pop_head(&pending_msg_rows)) != NULL)
+	{
+		gtk_list_store_append(msgwindow.store_msg, &iter);
+		gtk_list_store_set(msgwindow.store_msg, &iter,
+			MSG_COL_LINE, row->line, MSG_COL_DOC_ID, row->doc_id,
+			MSG_COL_COLOR, row->color, MSG_COL_STRING, row->msg, -1);
+		msg_row_free(row);
+		n++;
+	}
+	if (model != NULL)
+	{
+		gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_msg), model);
+		g_object_unref(model);
+	}
+
+	if (g_queue_is_empty(&pending_msg_rows))
+	{
+		pending_msg_idle_id = 0;
+		msg_batch_total = 0;
+		return FALSE;
+	}
+	/* show a live count while the remaining rows stream in */
+	ui_set_statusbar(FALSE, _("Adding messages (%u of %u)..."),
+		msg_batch_total - g_queue_get_length(&pending_msg_rows), msg_batch_total);
+	return TRUE;
+}
+
+
+static void drop_pending_msg_rows(void)
+{
+	MsgRow *row;
+
+	while ((row = g_queue_pop_head(&pending_msg_rows)) != NULL)
+		msg_row_free(row);
+	if (pending_msg_idle_id > 0)
+	{
+		g_source_remove(pending_msg_idle_id);
+		pending_msg_idle_id = 0;
+	}
+	msg_batch_total = 0;
+}
+
+
+/* Opens a message batch: subsequent msgwin_msg_add() calls are queued and
+ * inserted into the view incrementally from an idle handler. Batches may be
+ * nested; the queue is flushed when the outermost batch is closed. */
+void msgwin_msg_batch_begin(void)
+{
+	msg_batch_depth++;
+}
+
+
+void msgwin_msg_batch_end(void)
+{
+	g_return_if_fail(msg_batch_depth > 0);
+
+	msg_batch_depth--;
+	if (msg_batch_depth == 0 && ! g_queue_is_empty(&pending_msg_rows) &&
+		pending_msg_idle_id == 0)
+		pending_msg_idle_id = g_idle_add(flush_pending_msg_rows, NULL);
+}
+
+
 /* adds string to the msg treeview */
 void msgwin_msg_add_string(gint msg_color, gint line, GeanyDocument *doc, const gchar *string)
 {
@@ -399,6 +609,27 @@ void msgwin_msg_add_string(gint msg_color, gint line, GeanyDocument *doc, const
 	else
 		utf8_msg = tmp;
 
+	if (msg_batch_depth > 0 || pending_msg_idle_id > 0)
+	{
+		/* queue the row; appending directly while older rows are still
+		 * pending would reorder the messages */
+		MsgRow *row = g_slice_new(MsgRow);
+
+		row->line = line;
+		row->doc_id = doc ? doc->id : 0;
+		row->color = color;
+		if (utf8_msg == tmp)
+			row->msg = tmp;
+		else
+		{
+			row->msg = utf8_msg;
+			g_free(tmp);
+		}
+		g_queue_push_tail(&pending_msg_rows, row);
+		msg_batch_total++;
+		return;
+	}
+
 	gtk_list_store_append(msgwindow.store_msg, &iter);
 	gtk_list_store_set(msgwindow.store_msg, &iter,
 		MSG_COL_LINE, line, MSG_COL_DOC_ID, doc ? doc->id : 0, MSG_COL_COLOR,
@@ -441,12 +672,17 @@ void msgwin_status_add(const gchar *format, ...)
 
 	if (G_LIKELY(main_status.main_window_realized))
 	{
-		GtkTreePath *path = gtk_tree_model_get_path(gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_status)), &iter);
+		if (gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_status)) != NULL)
+		{
+			GtkTreePath *path = gtk_tree_model_get_path(
+				GTK_TREE_MODEL(msgwindow.store_status), &iter);
 
-		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(msgwindow.tree_status), path, NULL, FALSE, 0.0, 0.0);
+			gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(msgwindow.tree_status), path, NULL, FALSE, 0.0, 0.0);
+			gtk_tree_path_free(path);
+		}
+		/* switching the page attaches the model and scrolls to the end */
 		if (prefs.switch_to_status)
 			gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_STATUS);
-		gtk_tree_path_free(path);
 	}
 }
 
@@ -996,6 +1232,31 @@ static void parse_compiler_error_line(const gchar *string,
 }
 
 
+/* Cheap prefilter for parse_compiler_error_line(): every format parsed there
+ * requires a line number field, which always appears as a digit run either
+ * starting the line or directly following one of the field separator characters
+ * (strtol() also skips leading whitespace within a field). Returns FALSE when no
+ * such digit run exists, so the splitting and copying above can be skipped for
+ * the vast majority of build output lines. */
+static gboolean maybe_error_line(const gchar *string)
+{
+	const gchar *p;
+
+	for (p = string; *p != '\0'; p++)
+	{
+		if (g_ascii_isdigit(*p))
+		{
+			if (p == string || strchr(":( ,'\"\t", p[-1]) != NULL)
+				return TRUE;
+			/* the first digit decided for this run, skip the rest of it */
+			while (g_ascii_isdigit(p[1]))
+				p++;
+		}
+	}
+	return FALSE;
+}
+
+
 /* try to parse the file and line number where the error occured described in string
  * and when something useful is found, it stores the line number in *line and the
  * relevant file with the error in *filename.
@@ -1013,6 +1274,12 @@ void msgwin_parse_compiler_error_line(const gchar *string, const gchar *dir,
 	if (G_UNLIKELY(string == NULL))
 		return;
 
+	/* neither parser below can report an error without extracting a decimal line
+	 * number, so lines without any digit are rejected before copying the string
+	 * or touching a regex */
+	if (strpbrk(string, "0123456789") == NULL)
+		return;
+
 	if (dir == NULL)
 		dir = build_info.dir;
 	g_return_if_fail(dir != NULL);
@@ -1026,7 +1293,8 @@ void msgwin_parse_compiler_error_line(const gchar *string, const gchar *dir,
 	if (!filetypes_parse_error_message(ft, trimmed_string, filename, line))
 	{
 		/* fallback to default old-style parsing */
-		parse_compiler_error_line(trimmed_string, filename, line);
+		if (maybe_error_line(trimmed_string))
+			parse_compiler_error_line(trimmed_string, filename, line);
 	}
 	make_absolute(filename, dir);
 	g_free(trimmed_string);
@@ -1240,6 +1508,8 @@ void msgwin_clear_tab(gint tabnum)
 	switch (tabnum)
 	{
 		case MSG_MESSAGE:
+			/* rows still queued for this tab must not survive the clear */
+			drop_pending_msg_rows();
 			store = msgwindow.store_msg;
 			break;
 
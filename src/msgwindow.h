@@ -95,10 +95,16 @@ void msgwin_show_hide(gboolean show);
 
 void msgwin_msg_add_string(gint msg_color, gint line, GeanyDocument *doc, const gchar *string);
 
+void msgwin_msg_batch_begin(void);
+
+void msgwin_msg_batch_end(void);
+
 void msgwin_compiler_add_string(gint msg_color, const gchar *msg);
 
 void msgwin_show_hide_tabs(void);
 
+void msgwin_attach_tab_model(gint tabnum);
+
 
 void msgwin_menu_add_common_items(GtkMenu *menu);
 
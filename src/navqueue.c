@@ -38,26 +38,40 @@
 
 #include "gtkcompat.h"
 
+#include <stdlib.h>
+#include <string.h>
 
-/* for the navigation history queue */
+
+/* capacity of the navigation history; old positions are evicted when full */
+#define NAV_QUEUE_SIZE 64
+
+/* for the navigation history ring */
 typedef struct
 {
-	const gchar *file;	/* This is the document's filename, in UTF-8 */
+	const gchar *file;	/* the document's filename in UTF-8, interned (never freed) */
 	gint pos;
 } filepos;
 
-static GQueue *navigation_queue;
-static guint nav_queue_pos;
+/* Fixed-capacity ring buffer; the newest entry lives at nav_ring_start and
+ * older entries follow at increasing offsets. Since the filenames are
+ * interned strings, neither adding nor evicting an entry allocates. */
+static filepos nav_ring[NAV_QUEUE_SIZE];
+static guint nav_ring_start;	/* ring index of the newest entry */
+static guint nav_ring_len;
+static guint nav_queue_pos;		/* offset of the current position from the newest entry */
 
 static GtkAction *navigation_buttons[2];
 
 
+/* returns the entry n steps back from the newest one; n must be < nav_ring_len */
+static filepos *nav_ring_nth(guint n)
+{
+	return &nav_ring[(nav_ring_start + n) % NAV_QUEUE_SIZE];
+}
+
 
 void navqueue_init(void)
 {
-	navigation_queue = g_queue_new();
-	nav_queue_pos = 0;
-
 	navigation_buttons[0] = toolbar_get_action_by_name("NavBack");
 	navigation_buttons[1] = toolbar_get_action_by_name("NavFor");
 
@@ -68,17 +82,14 @@ void navqueue_init(void)
 
 void navqueue_free(void)
 {
-	while (! g_queue_is_empty(navigation_queue))
-	{
-		g_free(g_queue_pop_tail(navigation_queue));
-	}
-	g_queue_free(navigation_queue);
+	nav_ring_len = 0;
+	nav_queue_pos = 0;
 }
 
 
 static void adjust_buttons(void)
 {
-	if (g_queue_get_length(navigation_queue) < 2)
+	if (nav_ring_len < 2)
 	{
 		gtk_action_set_sensitive(navigation_buttons[0], FALSE);
 		gtk_action_set_sensitive(navigation_buttons[1], FALSE);
@@ -94,7 +105,7 @@ static void adjust_buttons(void)
 	gtk_action_set_sensitive(navigation_buttons[1], TRUE);
 
 	/* back should be sensitive if there's a place to go back to */
-	(nav_queue_pos < g_queue_get_length(navigation_queue) - 1) ?
+	(nav_queue_pos < nav_ring_len - 1) ?
 		gtk_action_set_sensitive(navigation_buttons[0], TRUE) :
 			gtk_action_set_sensitive(navigation_buttons[0], FALSE);
 }
@@ -103,38 +114,65 @@ static void adjust_buttons(void)
 static gboolean
 queue_pos_matches(guint queue_pos, const gchar *fname, gint pos)
 {
-	if (queue_pos < g_queue_get_length(navigation_queue))
+	if (queue_pos < nav_ring_len)
 	{
-		filepos *fpos = g_queue_peek_nth(navigation_queue, queue_pos);
+		filepos *fpos = nav_ring_nth(queue_pos);
 
-		return (utils_str_equal(fpos->file, fname) && fpos->pos == pos);
+		/* fname is interned by the caller, so pointer comparison suffices */
+		return (fpos->file == fname && fpos->pos == pos);
 	}
 	return FALSE;
 }
 
 
+/* returns TRUE if the two positions are on the same line of the same (open) file,
+ * so consecutive jumps within a line collapse into one history entry */
+static gboolean pos_matches_line(const filepos *fpos, const gchar *fname, gint pos)
+{
+	GeanyDocument *doc;
+	ScintillaObject *sci;
+
+	if (fpos->file != fname)
+		return FALSE;
+	if (fpos->pos == pos)
+		return TRUE;
+
+	doc = document_find_by_filename(fname);
+	if (doc == NULL)
+		return FALSE;
+	sci = doc->editor->sci;
+	return sci_get_line_from_position(sci, fpos->pos) == sci_get_line_from_position(sci, pos);
+}
+
+
 static void add_new_position(const gchar *utf8_filename, gint pos)
 {
-	filepos *npos;
-	guint i;
+	const gchar *fname = g_intern_string(utf8_filename);
 
-	if (queue_pos_matches(nav_queue_pos, utf8_filename, pos))
+	if (queue_pos_matches(nav_queue_pos, fname, pos))
 		return;	/* prevent duplicates */
 
-	npos = g_new0(filepos, 1);
-	npos->file = utf8_filename;
-	npos->pos = pos;
-
-	/* if we've jumped to a new position from inside the queue rather than going forward */
+	/* if we've jumped to a new position from inside the queue rather than going forward,
+	 * drop the entries in front of the current one (just a start/length adjustment) */
 	if (nav_queue_pos > 0)
 	{
-		for (i = 0; i < nav_queue_pos; i++)
-		{
-			g_free(g_queue_pop_head(navigation_queue));
-		}
+		nav_ring_start = (nav_ring_start + nav_queue_pos) % NAV_QUEUE_SIZE;
+		nav_ring_len -= nav_queue_pos;
 		nav_queue_pos = 0;
 	}
-	g_queue_push_head(navigation_queue, npos);
+	/* coalesce adjacent positions on the same line instead of growing the history */
+	if (nav_ring_len > 0 && pos_matches_line(nav_ring_nth(0), fname, pos))
+	{
+		nav_ring_nth(0)->pos = pos;
+	}
+	else
+	{
+		nav_ring_start = (nav_ring_start + NAV_QUEUE_SIZE - 1) % NAV_QUEUE_SIZE;
+		nav_ring[nav_ring_start].file = fname;
+		nav_ring[nav_ring_start].pos = pos;
+		if (nav_ring_len < NAV_QUEUE_SIZE)
+			nav_ring_len++;	/* otherwise the oldest entry was just overwritten */
+	}
 	adjust_buttons();
 }
 
@@ -188,17 +226,28 @@ static gboolean goto_file_pos(const gchar *file, gint pos)
 }
 
 
+/* removes the entry n steps back from the newest one by closing the gap */
+static void nav_ring_remove(guint n)
+{
+	guint i;
+
+	for (i = n; i > 0; i--)
+		*nav_ring_nth(i) = *nav_ring_nth(i - 1);
+	nav_ring_start = (nav_ring_start + 1) % NAV_QUEUE_SIZE;
+	nav_ring_len--;
+}
+
+
 void navqueue_go_back(void)
 {
 	filepos *fprev;
 
 	/* return if theres no place to go back to */
-	if (g_queue_is_empty(navigation_queue) ||
-		nav_queue_pos >= g_queue_get_length(navigation_queue) - 1)
+	if (nav_ring_len == 0 || nav_queue_pos >= nav_ring_len - 1)
 		return;
 
 	/* jump back */
-	fprev = g_queue_peek_nth(navigation_queue, nav_queue_pos + 1);
+	fprev = nav_ring_nth(nav_queue_pos + 1);
 	if (goto_file_pos(fprev->file, fprev->pos))
 	{
 		nav_queue_pos++;
@@ -206,7 +255,7 @@ void navqueue_go_back(void)
 	else
 	{
 		/** TODO: add option to re open the file */
-		g_free(g_queue_pop_nth(navigation_queue, nav_queue_pos + 1));
+		nav_ring_remove(nav_queue_pos + 1);
 	}
 	adjust_buttons();
 }
@@ -216,12 +265,11 @@ void navqueue_go_forward(void)
 {
 	filepos *fnext;
 
-	if (nav_queue_pos < 1 ||
-		nav_queue_pos >= g_queue_get_length(navigation_queue))
+	if (nav_queue_pos < 1 || nav_queue_pos >= nav_ring_len)
 		return;
 
 	/* jump forward */
-	fnext = g_queue_peek_nth(navigation_queue, nav_queue_pos - 1);
+	fnext = nav_ring_nth(nav_queue_pos - 1);
 	if (goto_file_pos(fnext->file, fnext->pos))
 	{
 		nav_queue_pos--;
@@ -229,35 +277,105 @@ void navqueue_go_forward(void)
 	else
 	{
 		/** TODO: add option to re open the file */
-		g_free(g_queue_pop_nth(navigation_queue, nav_queue_pos - 1));
+		nav_ring_remove(nav_queue_pos - 1);
+		nav_queue_pos--;
 	}
 
 	adjust_buttons();
 }
 
 
-static gint find_by_filename(gconstpointer a, gconstpointer b)
-{
-	if (utils_str_equal(((const filepos*)a)->file, (const gchar*) b))
-		return 0;
-	else
-		return 1;
-}
-
-
 /* Remove all elements with the given filename */
 void navqueue_remove_file(const gchar *filename)
 {
-	GList *match;
+	const gchar *fname;
+	guint r, w;
 
 	if (filename == NULL)
 		return;
 
-	while ((match = g_queue_find_custom(navigation_queue, filename, find_by_filename)))
+	/* compact the ring in place; the capacity bounds the work done here */
+	fname = g_intern_string(filename);
+	for (r = 0, w = 0; r < nav_ring_len; r++)
 	{
-		g_free(match->data);
-		g_queue_delete_link(navigation_queue, match);
+		filepos fpos = *nav_ring_nth(r);
+
+		if (fpos.file == fname)
+		{
+			if (r < nav_queue_pos)
+				nav_queue_pos--;
+		}
+		else
+			*nav_ring_nth(w++) = fpos;
 	}
+	nav_ring_len = w;
+	if (nav_queue_pos >= nav_ring_len && nav_ring_len > 0)
+		nav_queue_pos = nav_ring_len - 1;
 
 	adjust_buttons();
 }
+
+
+/* Stores the navigation history in config so it survives restarts; written into
+ * the session part of the project file resp. the default session. */
+void navqueue_save_to_config(GKeyFile *config)
+{
+	gchar **entries = g_new0(gchar*, nav_ring_len + 1);
+	guint i;
+
+	/* oldest first so loading can simply push in order */
+	for (i = 0; i < nav_ring_len; i++)
+	{
+		filepos *fpos = nav_ring_nth(nav_ring_len - 1 - i);
+		gchar *escaped_filename = g_uri_escape_string(fpos->file, NULL, TRUE);
+
+		entries[i] = g_strdup_printf("%d;%s", fpos->pos, escaped_filename);
+		g_free(escaped_filename);
+	}
+	g_key_file_set_string_list(config, "files", "navigation_queue",
+		(const gchar**) entries, nav_ring_len);
+	g_key_file_set_integer(config, "files", "navigation_position", nav_queue_pos);
+	g_strfreev(entries);
+}
+
+
+/* Restores the history saved by navqueue_save_to_config(), replacing the
+ * current one (e.g. when switching projects). */
+void navqueue_load_from_config(GKeyFile *config)
+{
+	gchar **entries, **entry;
+	gint stored_pos;
+
+	nav_ring_len = 0;
+	nav_queue_pos = 0;
+
+	entries = g_key_file_get_string_list(config, "files", "navigation_queue", NULL, NULL);
+	foreach_strv(entry, entries)
+	{
+		gchar *sep = strchr(*entry, ';');
+		gchar *filename;
+
+		if (sep == NULL)
+			continue;	/* malformed entry */
+
+		filename = g_uri_unescape_string(sep + 1, NULL);
+		if (filename != NULL)
+		{
+			nav_ring_start = (nav_ring_start + NAV_QUEUE_SIZE - 1) % NAV_QUEUE_SIZE;
+			nav_ring[nav_ring_start].file = g_intern_string(filename);
+			nav_ring[nav_ring_start].pos = atoi(*entry);
+			if (nav_ring_len < NAV_QUEUE_SIZE)
+				nav_ring_len++;
+			g_free(filename);
+		}
+	}
+	g_strfreev(entries);
+
+	stored_pos = utils_get_setting_integer(config, "files", "navigation_position", 0);
+	if (stored_pos > 0 && (guint) stored_pos < nav_ring_len)
+		nav_queue_pos = (guint) stored_pos;
+
+	/* on startup the session is read before the toolbar actions exist */
+	if (navigation_buttons[0] != NULL)
+		adjust_buttons();
+}
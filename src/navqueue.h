@@ -50,6 +50,10 @@ void navqueue_go_back(void);
 
 void navqueue_go_forward(void);
 
+void navqueue_save_to_config(GKeyFile *config);
+
+void navqueue_load_from_config(GKeyFile *config);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -58,7 +58,7 @@ G_BEGIN_DECLS
  * @warning You should not test for values below 200 as previously
  * @c GEANY_API_VERSION was defined as an enum value, not a macro.
  */
-#define GEANY_API_VERSION 221
+#define GEANY_API_VERSION 224
 
 /* hack to have a different ABI when built with GTK3 because loading GTK2-linked plugins
  * with GTK3-linked Geany leads to crash */
@@ -421,6 +421,10 @@ SciFuncs;
 typedef struct TemplateFuncs
 {
 	gchar*		(*templates_get_template_fileheader) (gint filetype_idx, const gchar *fname);
+	void		(*templates_replace_valist) (GString *text,
+				 const gchar *first_wildcard, ...) G_GNUC_NULL_TERMINATED;
+	void		(*templates_replace_common) (GString *tmpl, const gchar *fname,
+				 struct GeanyFiletype *ft, const gchar *func_name);
 }
 TemplateFuncs;
 
@@ -662,6 +666,12 @@ EditorFuncs;
 /* avoid including keybindings.h */
 typedef gboolean (*_GeanyKeyGroupCallback) (guint key_id);
 
+/* avoid including pluginutils.h */
+typedef gpointer (*_GeanyWorkerFunc) (gpointer user_data, gint *cancelled);
+typedef void (*_GeanyWorkerDoneFunc) (gpointer result, gpointer user_data, gboolean cancelled);
+struct GeanyDocModification;
+typedef void (*_GeanyDocModificationFunc) (const struct GeanyDocModification *mod, gpointer user_data);
+
 /* See pluginutils.c */
 typedef struct PluginFuncs
 {
@@ -679,6 +689,13 @@ typedef struct PluginFuncs
 		GSourceFunc function, gpointer data);
 	guint	(*plugin_idle_add) (GeanyPlugin *plugin, GSourceFunc function, gpointer data);
 	void	(*plugin_builder_connect_signals) (GeanyPlugin *plugin, GtkBuilder *builder, gpointer user_data);
+	guint	(*plugin_work_queue_push) (GeanyPlugin *plugin, gint priority,
+		_GeanyWorkerFunc work_func, _GeanyWorkerDoneFunc done_func, gpointer user_data);
+	void	(*plugin_work_queue_cancel) (GeanyPlugin *plugin, guint task_id);
+	guint	(*plugin_doc_journal_subscribe) (GeanyPlugin *plugin);
+	void	(*plugin_doc_journal_unsubscribe) (GeanyPlugin *plugin, guint id);
+	gboolean	(*plugin_doc_journal_read) (GeanyPlugin *plugin, guint id,
+		_GeanyDocModificationFunc func, gpointer user_data);
 }
 PluginFuncs;
 
@@ -85,7 +85,12 @@ static PluginFuncs plugin_funcs = {
 	&plugin_timeout_add,
 	&plugin_timeout_add_seconds,
 	&plugin_idle_add,
-	&plugin_builder_connect_signals
+	&plugin_builder_connect_signals,
+	&plugin_work_queue_push,
+	&plugin_work_queue_cancel,
+	&plugin_doc_journal_subscribe,
+	&plugin_doc_journal_unsubscribe,
+	&plugin_doc_journal_read
 };
 
 static DocumentFuncs doc_funcs = {
@@ -198,7 +203,9 @@ static SciFuncs sci_funcs = {
 };
 
 static TemplateFuncs template_funcs = {
-	&templates_get_template_fileheader
+	&templates_get_template_fileheader,
+	&templates_replace_valist,
+	&templates_replace_common
 };
 
 static UtilsFuncs utils_funcs = {
@@ -610,7 +617,9 @@ plugin_load(Plugin *plugin)
 
 	/* start the plugin */
 	g_return_if_fail(plugin->init);
+	plugin_memory_push_context(&plugin->public);
 	plugin->init(&geany_data);
+	plugin_memory_pop_context();
 
 	/* store some function pointers for later use */
 	g_module_symbol(plugin->module, "plugin_configure", (void *) &plugin->configure);
@@ -852,10 +861,17 @@ plugin_cleanup(Plugin *plugin)
 	GtkWidget *widget;
 
 	if (plugin->cleanup)
+	{
+		plugin_memory_push_context(&plugin->public);
 		plugin->cleanup();
+		plugin_memory_pop_context();
+	}
 
 	remove_callbacks(plugin);
 	remove_sources(plugin);
+	plugin_work_queue_detach(&plugin->public);
+	plugin_doc_journal_detach(&plugin->public);
+	plugin_memory_detach(&plugin->public);
 
 	if (plugin->key_group)
 		keybindings_free_group(plugin->key_group);
@@ -944,6 +960,57 @@ static gboolean check_plugin_path(const gchar *fname)
 }
 
 
+/* filenames of active plugins still waiting to be loaded from the startup
+ * idle trickle */
+static GSList *pending_plugins_list = NULL;
+static guint pending_plugins_idle_id = 0;
+
+
+/* loads (and removes) the first entry of pending_plugins_list */
+static void
+load_one_pending_plugin(void)
+{
+	gchar *fname = pending_plugins_list->data;
+
+	pending_plugins_list = g_slist_delete_link(pending_plugins_list, pending_plugins_list);
+
+	if (!check_plugin_path(fname) || plugin_new(fname, TRUE, FALSE) == NULL)
+		failed_plugins_list = g_list_prepend(failed_plugins_list, fname);
+	else
+		g_free(fname);
+}
+
+
+static gboolean
+load_pending_plugin_idle(gpointer data)
+{
+	if (pending_plugins_list != NULL)
+		load_one_pending_plugin();
+
+	if (pending_plugins_list == NULL)
+	{
+		pending_plugins_idle_id = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Immediately loads any startup plugins still waiting in the idle trickle,
+ * for code that needs the full set loaded now (e.g. the plugin manager). */
+static void
+load_pending_plugins(void)
+{
+	if (pending_plugins_idle_id > 0)
+	{
+		g_source_remove(pending_plugins_idle_id);
+		pending_plugins_idle_id = 0;
+	}
+	while (pending_plugins_list != NULL)
+		load_one_pending_plugin();
+}
+
+
 /* load active plugins at startup */
 static void
 load_active_plugins(void)
@@ -958,11 +1025,19 @@ load_active_plugins(void)
 		const gchar *fname = active_plugins_pref[i];
 
 		if (!EMPTY(fname) && g_file_test(fname, G_FILE_TEST_EXISTS))
-		{
-			if (!check_plugin_path(fname) || plugin_new(fname, TRUE, FALSE) == NULL)
-				failed_plugins_list = g_list_prepend(failed_plugins_list, g_strdup(fname));
-		}
+			pending_plugins_list = g_slist_append(pending_plugins_list, g_strdup(fname));
 	}
+
+	/* Trickle-load the plugins one per main loop iteration instead of
+	 * dlopening and initializing all of them before the window can appear.
+	 * The priority is below the redraw priority, so the window is mapped and
+	 * drawn first, but above G_PRIORITY_LOW, so every plugin is loaded before
+	 * main() emits "geany-startup-complete" from its G_PRIORITY_LOW idle.
+	 * For the plugins this is no different from being enabled through the
+	 * plugin manager with documents already open. */
+	if (pending_plugins_list != NULL)
+		pending_plugins_idle_id = g_idle_add_full(G_PRIORITY_LOW - 10,
+			load_pending_plugin_idle, NULL, NULL);
 }
 
 
@@ -1102,7 +1177,8 @@ static void update_active_plugins_pref(void)
 	if (!want_plugins)
 		return;
 
-	count = g_list_length(active_plugin_list) + g_list_length(failed_plugins_list);
+	count = g_list_length(active_plugin_list) + g_list_length(failed_plugins_list) +
+		g_slist_length(pending_plugins_list);
 
 	g_strfreev(active_plugins_pref);
 
@@ -1128,6 +1204,17 @@ static void update_active_plugins_pref(void)
 		active_plugins_pref[i] = g_strdup(fname);
 		i++;
 	}
+	{
+		/* plugins still waiting in the startup trickle stay active for the
+		 * next run even though they were never loaded in this one */
+		GSList *node;
+
+		for (node = pending_plugins_list; node != NULL; node = node->next)
+		{
+			active_plugins_pref[i] = g_strdup(node->data);
+			i++;
+		}
+	}
 	active_plugins_pref[i] = NULL;
 }
 
@@ -1158,6 +1245,19 @@ void plugins_init(void)
 /* called even if plugin support is disabled */
 void plugins_finalize(void)
 {
+	if (pending_plugins_idle_id > 0)
+	{
+		g_source_remove(pending_plugins_idle_id);
+		pending_plugins_idle_id = 0;
+	}
+	if (pending_plugins_list != NULL)
+	{
+		/* never loaded, nothing to tear down - the names were already saved
+		 * back to the active plugins pref */
+		g_slist_foreach(pending_plugins_list, (GFunc) g_free, NULL);
+		g_slist_free(pending_plugins_list);
+		pending_plugins_list = NULL;
+	}
 	if (failed_plugins_list != NULL)
 	{
 		g_list_foreach(failed_plugins_list, (GFunc) g_free,	NULL);
@@ -1449,7 +1549,11 @@ static void pm_on_plugin_button_clicked(GtkButton *button, gpointer user_data)
 			if (GPOINTER_TO_INT(user_data) == PM_BUTTON_CONFIGURE)
 				plugin_show_configure(&p->public);
 			else if (GPOINTER_TO_INT(user_data) == PM_BUTTON_HELP && p->help != NULL)
+			{
+				plugin_memory_push_context(&p->public);
 				p->help();
+				plugin_memory_pop_context();
+			}
 			else if (GPOINTER_TO_INT(user_data) == PM_BUTTON_KEYBINDINGS && p->key_group && p->key_group->plugin_key_count > 0)
 				keybindings_dialog_show_prefs_scroll(p->info.name);
 		}
@@ -1491,6 +1595,10 @@ static void pm_show_dialog(GtkMenuItem *menuitem, gpointer user_data)
 {
 	GtkWidget *vbox, *vbox2, *hbox, *swin, *label;
 
+	/* finish any startup plugin loads still pending so the dialog reflects
+	 * the real set of active plugins */
+	load_pending_plugins();
+
 	/* before showing the dialog, we need to create the list of available plugins */
 	load_all_plugins();
 
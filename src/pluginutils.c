@@ -40,6 +40,343 @@
 #include "toolbar.h"
 #include "ui_utils.h"
 #include "utils.h"
+#include "worker.h"
+
+#include <string.h>
+
+#ifdef HAVE_PLUGIN_MEM_STATS
+# include "stats.h"
+# include <stdlib.h>
+#endif
+
+
+#ifdef HAVE_PLUGIN_MEM_STATS
+
+/* Per-plugin allocation accounting (--enable-plugin-mem-stats).
+ *
+ * The GLib allocator is replaced with a thin wrapper that charges every
+ * allocation made while plugin code is on the stack to that plugin. A call
+ * site cannot tell which plugin asked for memory -- plugins reach the core
+ * API through the geany_functions tables -- so instead the known entry
+ * points into plugin code (plugin_init()/plugin_cleanup(), the configure and
+ * help hooks, and the callbacks of plugin-registered GSources and work queue
+ * tasks) bracket themselves with a context, and the wrapper attributes
+ * whatever is allocated in between. Frees are matched against the live block
+ * table no matter who frees, so blocks still alive when a plugin is unloaded
+ * are its suspected leaks. The per-plugin totals are appended to the
+ * performance counter dump (see stats.c), i.e. visible via SIGUSR2 in the
+ * Help->Debug Messages window.
+ *
+ * Handlers connected with plugin_signal_connect() cannot be bracketed
+ * generically on this GLib version, so allocations made directly in signal
+ * handlers stay unattributed. g_slice is redirected through g_malloc() so
+ * slice allocations are seen as well.
+ *
+ * All internal tables use the C library allocator directly, so the
+ * bookkeeping neither recurses into the hooks nor shows up in the numbers.
+ */
+
+typedef struct PluginMemAccount
+{
+	struct PluginMemAccount *next;
+	Plugin	*plugin;			/* NULL once the plugin was unloaded */
+	gchar	name[64];
+	gsize	live_blocks;		/* currently allocated blocks and bytes */
+	gsize	live_bytes;
+	gsize	total_allocs;		/* lifetime allocation count and volume */
+	gsize	total_bytes;
+} PluginMemAccount;
+
+typedef struct
+{
+	gpointer			ptr;	/* NULL empty, PLUGIN_MEM_TOMBSTONE deleted */
+	gsize				size;
+	PluginMemAccount	*account;
+} PluginMemBlock;
+
+#define PLUGIN_MEM_TOMBSTONE GSIZE_TO_POINTER(1)
+#define PLUGIN_MEM_CONTEXT_DEPTH 16
+
+static GStaticMutex mem_mutex = G_STATIC_MUTEX_INIT;
+static PluginMemAccount *mem_accounts = NULL;
+/* pointer-keyed open addressing table of all tracked live blocks */
+static PluginMemBlock *mem_blocks = NULL;
+static gsize mem_blocks_mask = 0;	/* capacity - 1, capacity is a power of two */
+static gsize mem_blocks_used = 0;	/* live entries */
+static gsize mem_blocks_filled = 0;	/* live entries plus tombstones */
+static PluginMemAccount *mem_context[PLUGIN_MEM_CONTEXT_DEPTH];
+static gint mem_context_depth = 0;
+
+
+static gsize mem_blocks_hash(gconstpointer ptr)
+{
+	/* the low bits are dead due to allocator alignment */
+	return (GPOINTER_TO_SIZE(ptr) >> 4) * 2654435761UL;
+}
+
+
+/* returns the entry for @a ptr, or the slot where it would be inserted */
+static PluginMemBlock *mem_blocks_slot(PluginMemBlock *table, gsize mask, gpointer ptr)
+{
+	gsize i = mem_blocks_hash(ptr) & mask;
+	PluginMemBlock *tombstone = NULL;
+
+	while (table[i].ptr != NULL)
+	{
+		if (table[i].ptr == ptr)
+			return &table[i];
+		if (table[i].ptr == PLUGIN_MEM_TOMBSTONE && tombstone == NULL)
+			tombstone = &table[i];
+		i = (i + 1) & mask;
+	}
+	return tombstone != NULL ? tombstone : &table[i];
+}
+
+
+/* caller holds mem_mutex; also run at the current size to clear tombstones */
+static void mem_blocks_rehash(gsize new_mask)
+{
+	PluginMemBlock *new_table = calloc(new_mask + 1, sizeof *new_table);
+	gsize i;
+
+	if (new_table == NULL)
+		return;	/* keep the old table, lookups still work */
+	for (i = 0; i <= mem_blocks_mask; i++)
+	{
+		if (mem_blocks[i].ptr != NULL && mem_blocks[i].ptr != PLUGIN_MEM_TOMBSTONE)
+			*mem_blocks_slot(new_table, new_mask, mem_blocks[i].ptr) = mem_blocks[i];
+	}
+	free(mem_blocks);
+	mem_blocks = new_table;
+	mem_blocks_mask = new_mask;
+	mem_blocks_filled = mem_blocks_used;
+}
+
+
+/* caller holds mem_mutex */
+static void mem_track_alloc_to(gpointer ptr, gsize size, PluginMemAccount *account)
+{
+	PluginMemBlock *slot;
+
+	if ((mem_blocks_filled + 1) * 4 > (mem_blocks_mask + 1) * 3)
+	{
+		gsize new_mask = mem_blocks_mask;
+
+		while ((mem_blocks_used + 1) * 2 > (new_mask + 1))
+			new_mask = new_mask * 2 + 1;
+		mem_blocks_rehash(new_mask);
+	}
+	slot = mem_blocks_slot(mem_blocks, mem_blocks_mask, ptr);
+	if (slot->ptr == NULL)
+		mem_blocks_filled++;
+	slot->ptr = ptr;
+	slot->size = size;
+	slot->account = account;
+	mem_blocks_used++;
+	account->live_blocks++;
+	account->live_bytes += size;
+	account->total_allocs++;
+	account->total_bytes += size;
+}
+
+
+/* caller holds mem_mutex */
+static void mem_track_alloc(gpointer ptr, gsize size)
+{
+	if (mem_context_depth > 0 && mem_blocks != NULL)
+		mem_track_alloc_to(ptr, size, mem_context[mem_context_depth - 1]);
+}
+
+
+/* caller holds mem_mutex; returns the account the block was charged to */
+static PluginMemAccount *mem_track_free(gpointer ptr)
+{
+	PluginMemBlock *slot;
+	PluginMemAccount *account;
+
+	if (ptr == NULL || mem_blocks == NULL)
+		return NULL;
+	slot = mem_blocks_slot(mem_blocks, mem_blocks_mask, ptr);
+	if (slot->ptr != ptr)
+		return NULL;
+	account = slot->account;
+	account->live_blocks--;
+	account->live_bytes -= slot->size;
+	slot->ptr = PLUGIN_MEM_TOMBSTONE;
+	slot->account = NULL;
+	mem_blocks_used--;
+	return account;
+}
+
+
+static gpointer plugin_mem_malloc(gsize n_bytes)
+{
+	gpointer ptr = malloc(n_bytes);
+
+	if (ptr != NULL)
+	{
+		g_static_mutex_lock(&mem_mutex);
+		mem_track_alloc(ptr, n_bytes);
+		g_static_mutex_unlock(&mem_mutex);
+	}
+	return ptr;
+}
+
+
+static gpointer plugin_mem_realloc(gpointer mem, gsize n_bytes)
+{
+	gpointer ptr = realloc(mem, n_bytes);
+
+	if (ptr == NULL && n_bytes > 0)
+		return NULL;	/* the old block is untouched */
+
+	g_static_mutex_lock(&mem_mutex);
+	if (mem != NULL)
+	{
+		/* a resized block stays charged to whoever allocated it, so leaks
+		 * of grown buffers do not silently change hands */
+		PluginMemAccount *account = mem_track_free(mem);
+
+		if (account != NULL && ptr != NULL && n_bytes > 0)
+			mem_track_alloc_to(ptr, n_bytes, account);
+	}
+	else if (ptr != NULL && n_bytes > 0)
+		mem_track_alloc(ptr, n_bytes);
+	g_static_mutex_unlock(&mem_mutex);
+	return ptr;
+}
+
+
+static void plugin_mem_free(gpointer mem)
+{
+	g_static_mutex_lock(&mem_mutex);
+	mem_track_free(mem);
+	g_static_mutex_unlock(&mem_mutex);
+	free(mem);
+}
+
+
+static GMemVTable plugin_mem_vtable =
+{
+	plugin_mem_malloc,
+	plugin_mem_realloc,
+	plugin_mem_free,
+	NULL,	/* GLib emulates calloc and the try_ variants */
+	NULL,
+	NULL
+};
+
+
+/* stats.c dump provider: one line per plugin account. The snapshot is taken
+ * under the lock with the C allocator and formatted afterwards, as GString
+ * would recurse into the allocator hooks while the lock is held. */
+static gchar *plugin_memory_report(void)
+{
+	GString *out = g_string_new(NULL);
+	PluginMemAccount *snapshot = NULL, *account;
+	gsize count = 0, i = 0;
+
+	g_static_mutex_lock(&mem_mutex);
+	for (account = mem_accounts; account != NULL; account = account->next)
+		count++;
+	if (count > 0)
+		snapshot = malloc(count * sizeof *snapshot);
+	if (snapshot != NULL)
+	{
+		for (account = mem_accounts; account != NULL; account = account->next)
+			snapshot[i++] = *account;
+	}
+	g_static_mutex_unlock(&mem_mutex);
+
+	for (i = 0; snapshot != NULL && i < count; i++)
+	{
+		g_string_append_printf(out,
+			"plugin.mem %s%s: %lu blocks / %lu bytes live, %lu allocations / %lu bytes total\n",
+			snapshot[i].name, snapshot[i].plugin == NULL ? " (unloaded)" : "",
+			(gulong) snapshot[i].live_blocks, (gulong) snapshot[i].live_bytes,
+			(gulong) snapshot[i].total_allocs, (gulong) snapshot[i].total_bytes);
+	}
+	free(snapshot);
+	return g_string_free(out, FALSE);
+}
+
+
+/* Installs the accounting allocator. Must run before anything else allocates
+ * through GLib, i.e. first thing in main(): g_mem_set_vtable() refuses to
+ * replace the allocator once it has been used. */
+void plugin_memory_init(void)
+{
+#ifdef G_OS_UNIX
+	/* route g_slice through g_malloc() so slice allocations are seen too;
+	 * the raw setenv() as g_setenv() would be GLib's first allocation */
+	setenv("G_SLICE", "always-malloc", FALSE);
+#endif
+	g_mem_set_vtable(&plugin_mem_vtable);
+
+	mem_blocks_mask = 1024 - 1;
+	mem_blocks = calloc(mem_blocks_mask + 1, sizeof *mem_blocks);
+
+	stats_add_provider(plugin_memory_report);
+}
+
+
+/* Brackets an entry into @a plugin's code: until the matching pop, new
+ * allocations are charged to its account. Nesting is fine (a plugin entered
+ * from another plugin's context is charged, not the outer one). */
+void plugin_memory_push_context(GeanyPlugin *plugin)
+{
+	PluginMemAccount *account;
+
+	g_static_mutex_lock(&mem_mutex);
+	for (account = mem_accounts; account != NULL; account = account->next)
+	{
+		if (account->plugin == plugin->priv)
+			break;
+	}
+	if (account == NULL)
+	{
+		account = calloc(1, sizeof *account);
+		if (account != NULL)
+		{
+			g_strlcpy(account->name, plugin->priv->info.name != NULL ?
+				plugin->priv->info.name : "unknown", sizeof account->name);
+			account->plugin = plugin->priv;
+			account->next = mem_accounts;
+			mem_accounts = account;
+		}
+	}
+	if (account != NULL && mem_context_depth < PLUGIN_MEM_CONTEXT_DEPTH)
+		mem_context[mem_context_depth++] = account;
+	g_static_mutex_unlock(&mem_mutex);
+}
+
+
+void plugin_memory_pop_context(void)
+{
+	g_static_mutex_lock(&mem_mutex);
+	if (mem_context_depth > 0)
+		mem_context_depth--;
+	g_static_mutex_unlock(&mem_mutex);
+}
+
+
+/* Called by plugin_cleanup(): the plugin is gone, but its account and the
+ * blocks it still holds stay around so the dump can point at leaked memory.
+ * Reloading the plugin starts a fresh account. */
+void plugin_memory_detach(GeanyPlugin *plugin)
+{
+	PluginMemAccount *account;
+
+	g_static_mutex_lock(&mem_mutex);
+	for (account = mem_accounts; account != NULL; account = account->next)
+	{
+		if (account->plugin == plugin->priv)
+			account->plugin = NULL;
+	}
+	g_static_mutex_unlock(&mem_mutex);
+}
+
+#endif /* HAVE_PLUGIN_MEM_STATS */
 
 
 /** Inserts a toolbar item before the Quit button, or after the previous plugin toolbar item.
@@ -200,8 +537,12 @@ static void on_plugin_source_destroy(gpointer data)
 static gboolean on_plugin_source_callback(gpointer data)
 {
 	PluginSourceData *psd = data;
+	gboolean ret;
 
-	return psd->function(psd->user_data);
+	plugin_memory_push_context(&psd->plugin->public);
+	ret = psd->function(psd->user_data);
+	plugin_memory_pop_context();
+	return ret;
 }
 
 
@@ -303,7 +644,9 @@ GeanyKeyGroup *plugin_set_key_group(GeanyPlugin *plugin,
 
 static void on_pref_btn_clicked(gpointer btn, Plugin *p)
 {
+	plugin_memory_push_context(&p->public);
 	p->configure_single(main_widgets.window);
+	plugin_memory_pop_context();
 }
 
 
@@ -313,7 +656,9 @@ static GtkWidget *create_pref_page(Plugin *p, GtkWidget *dialog)
 
 	if (p->configure)
 	{
+		plugin_memory_push_context(&p->public);
 		page = p->configure(GTK_DIALOG(dialog));
+		plugin_memory_pop_context();
 
 		if (! GTK_IS_WIDGET(page))
 		{
@@ -418,7 +763,9 @@ void plugin_show_configure(GeanyPlugin *plugin)
 	else
 	{
 		g_return_if_fail(p->configure_single);
+		plugin_memory_push_context(&p->public);
 		p->configure_single(main_widgets.window);
+		plugin_memory_pop_context();
 	}
 }
 
@@ -505,4 +852,388 @@ void plugin_builder_connect_signals(GeanyPlugin *plugin,
 }
 
 
+/* One task submitted to the plugin work queue. The heavy lifting (pool,
+ * priorities, cancellation) lives in the core scheduler (worker.c); this
+ * struct only tracks the owning plugin so its callback can be dropped when
+ * the plugin is unloaded while the task is in flight. It stays alive until
+ * the delivery handler has run. */
+typedef struct
+{
+	GeanyPlugin *plugin;	/* NULL when the plugin was unloaded first */
+	GeanyWorkerFunc work_func;
+	GeanyWorkerDoneFunc done_func;
+	gpointer user_data;
+	guint id;				/* the task's ID in the core scheduler */
+} PluginWorkTask;
+
+/* tasks submitted but not yet delivered; only ever touched from the main
+ * thread (API calls and the scheduler's main-loop delivery) */
+static GSList *work_tasks = NULL;
+
+
+/* unwraps the plugin's own user data for its work function */
+static gpointer work_task_run(gpointer user_data, gint *cancelled)
+{
+	PluginWorkTask *task = user_data;
+
+	return task->work_func(task->user_data, cancelled);
+}
+
+
+/* the scheduler's main-loop delivery; hands the result to the plugin unless
+ * the task was orphaned by unloading the plugin while it was in flight */
+static void work_task_deliver(gpointer result, gpointer user_data, gboolean cancelled)
+{
+	PluginWorkTask *task = user_data;
+
+	work_tasks = g_slist_remove(work_tasks, task);
+
+	if (task->plugin != NULL && task->done_func != NULL)
+	{
+		plugin_memory_push_context(task->plugin);
+		task->done_func(result, task->user_data, cancelled);
+		plugin_memory_pop_context();
+	}
+
+	g_free(task);
+}
+
+
+/** Runs a function in a worker thread of Geany's shared background scheduler.
+ *
+ * @a work_func is executed in a worker thread and must not touch the UI or
+ * other non-threadsafe Geany API. Its return value is afterwards passed to
+ * @a done_func in the main thread, where the full API may be used again, so
+ * no manual locking or marshalling is needed for the common
+ * compute-then-display pattern.
+ *
+ * Tasks still pending when the plugin is unloaded are cancelled and their
+ * @a done_func is not called; unloading waits for a task whose @a work_func
+ * is already executing, so the work function should poll its cancellation
+ * token regularly when it runs for a long time.
+ *
+ * @param plugin Must be @ref geany_plugin.
+ * @param priority Scheduling priority of the task; tasks with numerically
+ *        lower values are picked from the queue first. Use 0 unless some of
+ *        your tasks should jump ahead of others. 0 corresponds to the
+ *        scheduler's parsing class; stay within -99..99 to avoid outranking
+ *        Geany's own interactive tasks.
+ * @param work_func The function to execute in a worker thread.
+ * @param done_func The function called in the main thread with the result of
+ *        @a work_func, or @c NULL. Also called, with the cancelled flag set,
+ *        when the task was cancelled after the work function ran.
+ * @param user_data User data passed to both functions.
+ * @return the ID of the task, for use with plugin_work_queue_cancel().
+ *
+ * @since 1.25, plugin API 222.
+ */
+guint plugin_work_queue_push(GeanyPlugin *plugin, gint priority,
+		GeanyWorkerFunc work_func, GeanyWorkerDoneFunc done_func, gpointer user_data)
+{
+	PluginWorkTask *task;
+
+	g_return_val_if_fail(plugin != NULL, 0);
+	g_return_val_if_fail(work_func != NULL, 0);
+
+	task = g_new0(PluginWorkTask, 1);
+	task->plugin = plugin;
+	task->work_func = work_func;
+	task->done_func = done_func;
+	task->user_data = user_data;
+	task->id = worker_push(priority, work_task_run, work_task_deliver, task);
+	work_tasks = g_slist_prepend(work_tasks, task);
+	return task->id;
+}
+
+
+/** Cancels a task submitted with plugin_work_queue_push().
+ *
+ * A task whose work function has not started yet will not run it at all; a
+ * work function already executing keeps running but can notice the
+ * cancellation through its token. In both cases @a done_func still gets
+ * called (with the cancelled flag set) so resources held by the task can be
+ * released.
+ *
+ * @param plugin Must be @ref geany_plugin.
+ * @param task_id The ID returned by plugin_work_queue_push(). IDs of
+ *        already delivered tasks are ignored.
+ *
+ * @since 1.25, plugin API 222.
+ */
+void plugin_work_queue_cancel(GeanyPlugin *plugin, guint task_id)
+{
+	GSList *node;
+
+	g_return_if_fail(plugin != NULL);
+
+	foreach_slist(node, work_tasks)
+	{
+		PluginWorkTask *task = node->data;
+
+		if (task->id == task_id && task->plugin == plugin)
+		{
+			worker_cancel(task->id);
+			break;
+		}
+	}
+}
+
+
+/* Cancels and orphans all work-queue tasks of @a plugin before it is
+ * unloaded, blocking until none of its work functions is executing any more,
+ * as their code lives in the module about to be closed. Called by
+ * plugin_cleanup(). */
+void plugin_work_queue_detach(GeanyPlugin *plugin)
+{
+	GSList *node;
+
+	foreach_slist(node, work_tasks)
+	{
+		PluginWorkTask *task = node->data;
+
+		if (task->plugin == plugin)
+		{
+			worker_cancel(task->id);
+			task->plugin = NULL;	/* drops the done callback on delivery */
+		}
+	}
+	/* wait until none of the plugin's work functions is executing any more,
+	 * as their code lives in the module about to be closed; a separate pass
+	 * so all tasks are already cancelled before the first wait blocks.
+	 * worker_wait() does not run main-loop deliveries, so the list cannot
+	 * change under the iteration */
+	foreach_slist(node, work_tasks)
+	{
+		PluginWorkTask *task = node->data;
+
+		if (task->plugin == NULL)
+			worker_wait(task->id);
+	}
+}
+
+
+/* Document modification journal: buffer changes reported by Scintilla are
+ * recorded with a sequence number and plugins read them through a cursor of
+ * their own, so each subscriber sees every change exactly once and can keep
+ * incremental state instead of re-reading whole buffers. Nothing is recorded
+ * while there are no subscribers. */
+
+typedef struct
+{
+	GeanyPlugin *plugin;
+	guint id;
+	guint64 cursor;		/* sequence number of the next record to deliver */
+}
+JournalSubscriber;
+
+/* journal records in arrival order; the head record has sequence
+ * journal_first_seq, the next appended record gets journal_next_seq */
+static GQueue journal_records = G_QUEUE_INIT;
+static guint64 journal_first_seq = 0;
+static guint64 journal_next_seq = 0;
+static GList *journal_subscribers = NULL;
+static guint journal_next_subscriber_id = 1;
+
+/* upper bound on retained records; a subscriber lagging further behind is
+ * told to resync instead of holding arbitrary amounts of text alive */
+#define JOURNAL_MAX_RECORDS 4096
+
+
+static void journal_record_free(GeanyDocModification *rec)
+{
+	g_free((gchar *) rec->text);
+	g_free(rec);
+}
+
+
+/* drops records every subscriber has consumed and enforces the size cap */
+static void journal_trim(void)
+{
+	guint64 min_cursor = journal_next_seq;
+	GList *node;
+
+	foreach_list(node, journal_subscribers)
+	{
+		JournalSubscriber *sub = node->data;
+
+		min_cursor = MIN(min_cursor, sub->cursor);
+	}
+	while (journal_records.length > 0 &&
+		(journal_first_seq < min_cursor || journal_records.length > JOURNAL_MAX_RECORDS))
+	{
+		journal_record_free(g_queue_pop_head(&journal_records));
+		journal_first_seq++;
+	}
+}
+
+
+static JournalSubscriber *journal_find_subscriber(GeanyPlugin *plugin, guint id)
+{
+	GList *node;
+
+	foreach_list(node, journal_subscribers)
+	{
+		JournalSubscriber *sub = node->data;
+
+		if (sub->id == id && sub->plugin == plugin)
+			return sub;
+	}
+	return NULL;
+}
+
+
+/* Appends one Scintilla modification to the journal; called from the editor's
+ * SCN_MODIFIED handler. Does nothing while nobody subscribed, so documents
+ * edited without consumers cost neither memory nor copies. */
+void plugin_doc_journal_record(GeanyDocument *doc, gint position, gint length,
+		gint modification_type, const gchar *text)
+{
+	GeanyDocModification *rec;
+	gchar *copy = NULL;
+
+	if (journal_subscribers == NULL)
+		return;
+
+	if (text != NULL && length > 0)
+	{	/* nt->text is not NUL terminated and may contain NULs */
+		copy = g_malloc((gsize) length + 1);
+		memcpy(copy, text, (gsize) length);
+		copy[length] = '\0';
+	}
+	rec = g_new0(GeanyDocModification, 1);
+	rec->doc_id = doc->id;
+	rec->position = position;
+	rec->length = length;
+	rec->modification_type = modification_type;
+	rec->text = copy;
+	g_queue_push_tail(&journal_records, rec);
+	journal_next_seq++;
+	journal_trim();
+}
+
+
+/** Subscribes to the document modification journal.
+ *
+ * Once subscribed, every text insertion and deletion in any document is
+ * recorded and can be fetched with plugin_doc_journal_read(). The cursor of
+ * a new subscription starts at the present, earlier changes are not
+ * replayed.
+ *
+ * @param plugin Must be @ref geany_plugin.
+ * @return the subscription ID to read with, or 0 on error.
+ *
+ * @since 1.25, plugin API 224.
+ */
+guint plugin_doc_journal_subscribe(GeanyPlugin *plugin)
+{
+	JournalSubscriber *sub;
+
+	g_return_val_if_fail(plugin != NULL, 0);
+
+	sub = g_new0(JournalSubscriber, 1);
+	sub->plugin = plugin;
+	sub->id = journal_next_subscriber_id++;
+	sub->cursor = journal_next_seq;
+	journal_subscribers = g_list_prepend(journal_subscribers, sub);
+	return sub->id;
+}
+
+
+/** Ends a subscription made with plugin_doc_journal_subscribe().
+ *
+ * @param plugin Must be @ref geany_plugin.
+ * @param id The subscription ID. Unknown IDs are ignored.
+ *
+ * @since 1.25, plugin API 224.
+ */
+void plugin_doc_journal_unsubscribe(GeanyPlugin *plugin, guint id)
+{
+	JournalSubscriber *sub;
+
+	g_return_if_fail(plugin != NULL);
+
+	sub = journal_find_subscriber(plugin, id);
+	if (sub != NULL)
+	{
+		journal_subscribers = g_list_remove(journal_subscribers, sub);
+		g_free(sub);
+		journal_trim();
+	}
+}
+
+
+/** Delivers all modification records since the last read of this
+ * subscription.
+ *
+ * @a func is called once per record, in the order the changes happened, and
+ * the subscription's cursor advances past them; records written during the
+ * delivery (e.g. because @a func itself edits a document) are left for the
+ * next read. The record and its text belong to Geany and are only valid
+ * during the callback.
+ *
+ * @param plugin Must be @ref geany_plugin.
+ * @param id The subscription ID from plugin_doc_journal_subscribe().
+ * @param func Callback receiving the records.
+ * @param user_data User data passed to @a func.
+ * @return @c TRUE when the subscriber is in sync afterwards; @c FALSE when
+ *         the journal overflowed past this subscription's cursor, in which
+ *         case no records are delivered, the cursor is moved to the present
+ *         and the plugin must rebuild its state from the documents.
+ *
+ * @since 1.25, plugin API 224.
+ */
+gboolean plugin_doc_journal_read(GeanyPlugin *plugin, guint id,
+		GeanyDocModificationFunc func, gpointer user_data)
+{
+	JournalSubscriber *sub;
+	guint64 end_seq;
+	GList *node;
+
+	g_return_val_if_fail(plugin != NULL, FALSE);
+	g_return_val_if_fail(func != NULL, FALSE);
+
+	sub = journal_find_subscriber(plugin, id);
+	g_return_val_if_fail(sub != NULL, FALSE);
+
+	if (sub->cursor < journal_first_seq)
+	{	/* overflowed: the missed records are gone, the plugin must resync */
+		sub->cursor = journal_next_seq;
+		journal_trim();
+		return FALSE;
+	}
+
+	end_seq = journal_next_seq;
+	node = g_queue_peek_nth_link(&journal_records,
+		(guint) (sub->cursor - journal_first_seq));
+	for (; node != NULL && sub->cursor < end_seq; node = node->next)
+	{
+		func(node->data, user_data);
+		sub->cursor++;
+	}
+	journal_trim();
+	return TRUE;
+}
+
+
+/* Drops all journal subscriptions of @a plugin before it is unloaded.
+ * Called by plugin_cleanup(). */
+void plugin_doc_journal_detach(GeanyPlugin *plugin)
+{
+	GList *node, *next;
+
+	for (node = journal_subscribers; node != NULL; node = next)
+	{
+		JournalSubscriber *sub = node->data;
+
+		next = node->next;
+		if (sub->plugin == plugin)
+		{
+			journal_subscribers = g_list_delete_link(journal_subscribers, node);
+			g_free(sub);
+		}
+	}
+	journal_trim();
+}
+
+
 #endif
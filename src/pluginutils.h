@@ -51,6 +51,86 @@ guint plugin_timeout_add_seconds(struct GeanyPlugin *plugin, guint interval, GSo
 
 guint plugin_idle_add(struct GeanyPlugin *plugin, GSourceFunc function, gpointer data);
 
+/** Function executed in a worker thread of the plugin work queue.
+ * @a cancelled points to the cancellation token of the task; long-running
+ * work should poll it with @c g_atomic_int_get() and return early when it
+ * becomes non-zero. The returned pointer is passed on to the task's
+ * @ref GeanyWorkerDoneFunc.
+ * @since 1.25, plugin API 222. */
+typedef gpointer (*GeanyWorkerFunc)(gpointer user_data, gint *cancelled);
+
+/** Function called in the main thread with the result of a worker function.
+ * @a cancelled is @c TRUE when the task was cancelled; the result must be
+ * released here in either case.
+ * @since 1.25, plugin API 222. */
+typedef void (*GeanyWorkerDoneFunc)(gpointer result, gpointer user_data, gboolean cancelled);
+
+guint plugin_work_queue_push(struct GeanyPlugin *plugin, gint priority,
+		GeanyWorkerFunc work_func, GeanyWorkerDoneFunc done_func, gpointer user_data);
+
+void plugin_work_queue_cancel(struct GeanyPlugin *plugin, guint task_id);
+
+/** One recorded modification of a document buffer.
+ * @since 1.25, plugin API 224. */
+typedef struct GeanyDocModification
+{
+	/** ID of the modified document, resolve with @c document_find_by_id().
+	 * The document may have been closed since the record was written. */
+	guint doc_id;
+	gint position;	/**< Byte position of the change in the buffer. */
+	gint length;	/**< Length of the inserted or deleted text in bytes. */
+	/** The Scintilla modification flags of the change, containing either
+	 * @c SC_MOD_INSERTTEXT or @c SC_MOD_DELETETEXT. */
+	gint modification_type;
+	/** The inserted or deleted text, @ref length bytes plus a trailing NUL.
+	 * Owned by Geany and only valid during the delivery callback. */
+	const gchar *text;
+}
+GeanyDocModification;
+
+/** Function receiving document modification records from
+ * plugin_doc_journal_read().
+ * @since 1.25, plugin API 224. */
+typedef void (*GeanyDocModificationFunc)(const GeanyDocModification *mod, gpointer user_data);
+
+guint plugin_doc_journal_subscribe(struct GeanyPlugin *plugin);
+
+void plugin_doc_journal_unsubscribe(struct GeanyPlugin *plugin, guint id);
+
+gboolean plugin_doc_journal_read(struct GeanyPlugin *plugin, guint id,
+		GeanyDocModificationFunc func, gpointer user_data);
+
+#ifdef GEANY_PRIVATE
+
+void plugin_work_queue_detach(struct GeanyPlugin *plugin);
+
+struct GeanyDocument;
+
+void plugin_doc_journal_record(struct GeanyDocument *doc, gint position, gint length,
+		gint modification_type, const gchar *text);
+
+void plugin_doc_journal_detach(struct GeanyPlugin *plugin);
+
+#ifdef HAVE_PLUGIN_MEM_STATS
+
+void plugin_memory_init(void);
+
+void plugin_memory_push_context(struct GeanyPlugin *plugin);
+
+void plugin_memory_pop_context(void);
+
+void plugin_memory_detach(struct GeanyPlugin *plugin);
+
+#else
+/* no-op stubs so the entry points into plugin code need no conditionals */
+# define plugin_memory_init()
+# define plugin_memory_push_context(plugin)
+# define plugin_memory_pop_context()
+# define plugin_memory_detach(plugin)
+#endif
+
+#endif /* GEANY_PRIVATE */
+
 struct GeanyKeyGroup *plugin_set_key_group(struct GeanyPlugin *plugin,
 		const gchar *section_name, gsize count, GeanyKeyGroupCallback callback);
 
@@ -44,12 +44,15 @@
 #include "support.h"
 #include "ui_utils.h"
 #include "utils.h"
+#include "utils_fs.h"
 #include "win32.h"
 
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
 
+#include <glib/gstdio.h>
+
 
 ProjectPrefs project_prefs = { NULL, FALSE, FALSE };
 
@@ -90,6 +93,8 @@ static void on_radio_long_line_custom_toggled(GtkToggleButton *radio, GtkWidget
 static void apply_editor_prefs(void);
 static void init_stash_prefs(void);
 static void destroy_project(gboolean open_default);
+static void file_manifest_open(void);
+static void file_manifest_close(void);
 
 
 #define SHOW_ERR(args) dialogs_show_msgbox(GTK_MESSAGE_ERROR, args)
@@ -425,6 +430,8 @@ static void destroy_project(gboolean open_default)
 
 	g_return_if_fail(app->project != NULL);
 
+	file_manifest_close();
+
 	/* remove project filetypes build entries */
 	if (app->project->priv->build_filetypes_list != NULL)
 	{
@@ -440,6 +447,7 @@ static void destroy_project(gboolean open_default)
 	g_free(app->project->description);
 	g_free(app->project->file_name);
 	g_free(app->project->base_path);
+	g_strfreev(app->project->ignore_patterns);
 
 	g_free(app->project);
 	app->project = NULL;
@@ -450,6 +458,7 @@ static void destroy_project(gboolean open_default)
 	g_slist_free(stash_groups);
 	stash_groups = NULL;
 
+	editor_completion_stats_reset();
 	apply_editor_prefs(); /* ensure that global settings are restored */
 
 	if (project_prefs.project_session)
@@ -678,6 +687,9 @@ static GeanyProject *create_project(void)
 	init_stash_prefs();
 
 	project->file_patterns = NULL;
+	/* sensible pruning defaults; overridden by the "ignore_patterns" key when the
+	 * project file carries one */
+	project->ignore_patterns = g_strsplit(".git .svn .hg CVS", " ", -1);
 
 	project->priv->long_line_behaviour = 1 /* use global settings */;
 	project->priv->long_line_column = editor_prefs.long_line_column;
@@ -859,6 +871,9 @@ static gboolean update_config(const PropertyDialogElements *e, gboolean new_proj
 		g_free(tmp);
 	}
 
+	if (new_project)
+		file_manifest_open();
+
 	update_ui();
 
 	return TRUE;
@@ -1055,6 +1070,16 @@ static gboolean load_config(const gchar *filename)
 	p->file_name = utils_get_utf8_from_locale(filename);
 	p->base_path = utils_get_setting_string(config, "project", "base_path", "");
 	p->file_patterns = g_key_file_get_string_list(config, "project", "file_patterns", NULL, NULL);
+	{
+		gchar **ignores = g_key_file_get_string_list(config, "project",
+			"ignore_patterns", NULL, NULL);
+
+		if (ignores != NULL)
+		{	/* keep the create_project() defaults when the file has no key */
+			g_strfreev(p->ignore_patterns);
+			p->ignore_patterns = ignores;
+		}
+	}
 
 	p->priv->long_line_behaviour = utils_get_setting_integer(config, "long line marker",
 		"long_line_behaviour", 1 /* follow global */);
@@ -1063,6 +1088,7 @@ static gboolean load_config(const gchar *filename)
 	apply_editor_prefs();
 
 	build_load_menu(config, GEANY_BCS_PROJ, (gpointer)p);
+	editor_completion_stats_load(config);
 	if (project_prefs.project_session)
 	{
 		/* save current (non-project) session (it could have been changed since program startup) */
@@ -1072,6 +1098,7 @@ static gboolean load_config(const gchar *filename)
 		/* read session files so they can be opened with configuration_open_files() */
 		configuration_load_session_files(config, FALSE);
 	}
+	file_manifest_open();
 	g_signal_emit_by_name(geany_object, "project-open", config);
 	g_key_file_free(config);
 
@@ -1123,6 +1150,9 @@ static gboolean write_config(gboolean emit_signal)
 	if (p->file_patterns)
 		g_key_file_set_string_list(config, "project", "file_patterns",
 			(const gchar**) p->file_patterns, g_strv_length(p->file_patterns));
+	if (p->ignore_patterns)
+		g_key_file_set_string_list(config, "project", "ignore_patterns",
+			(const gchar**) p->ignore_patterns, g_strv_length(p->ignore_patterns));
 
 	// editor settings
 	g_key_file_set_integer(config, "long line marker", "long_line_behaviour", p->priv->long_line_behaviour);
@@ -1132,6 +1162,7 @@ static gboolean write_config(gboolean emit_signal)
 	if (project_prefs.project_session)
 		configuration_save_session_files(config);
 	build_save_menu(config, (gpointer)p, GEANY_BCS_PROJ);
+	editor_completion_stats_save(config);
 	if (emit_signal)
 	{
 		g_signal_emit_by_name(geany_object, "project-save", config);
@@ -1148,7 +1179,454 @@ static gboolean write_config(gboolean emit_signal)
 }
 
 
-/** Forces the project file rewrite and emission of the project-save signal. Plugins 
+/* The tag cache stores the parsed tags of project files on disk, next to the
+ * project file, so reopening a project does not have to run the ctags parsers
+ * over files which did not change since the last session. Entries are keyed
+ * by the source file path and validated against the file's size, mtime and a
+ * content checksum before being used. */
+
+#define PROJECT_TAG_CACHE_DIR ".geany-tag-cache"
+
+/* returns the locale encoded path of the cache entry for locale_filename */
+static gchar *get_tag_cache_path(const gchar *locale_filename)
+{
+	gchar *locale_project_file = utils_get_locale_from_utf8(app->project->file_name);
+	gchar *project_dir = g_path_get_dirname(locale_project_file);
+	gchar *key = g_compute_checksum_for_string(G_CHECKSUM_MD5, locale_filename, -1);
+	gchar *path = g_strconcat(project_dir, G_DIR_SEPARATOR_S PROJECT_TAG_CACHE_DIR
+		G_DIR_SEPARATOR_S, key, ".tags", NULL);
+
+	g_free(key);
+	g_free(project_dir);
+	g_free(locale_project_file);
+	return path;
+}
+
+/* computes the checksum over the current on-disk content of locale_filename,
+ * or returns NULL if the file cannot be read */
+static gchar *get_file_checksum(const gchar *locale_filename)
+{
+	gchar *contents;
+	gsize len;
+	gchar *checksum;
+
+	if (! g_file_get_contents(locale_filename, &contents, &len, NULL))
+		return NULL;
+	checksum = g_compute_checksum_for_data(G_CHECKSUM_MD5, (guchar *) contents, len);
+	g_free(contents);
+	return checksum;
+}
+
+/* Tries to fill the tags array of source_file from the project tag cache.
+ * Returns TRUE when a cache entry exists and still describes the on-disk file,
+ * in which case the stored tags were deserialized and no parse is needed.
+ * Entries whose size or mtime changed are re-validated with a content checksum
+ * so e.g. checkouts which restore an old mtime still hit the cache. */
+gboolean project_load_cached_tags(TMSourceFile *source_file, const gchar *locale_filename)
+{
+	struct stat s;
+	gchar *path;
+	gchar header[256];
+	guint64 csize, cmtime;
+	gchar checksum[64];
+	gboolean valid;
+	FILE *fp;
+
+	if (app->project == NULL || source_file == NULL)
+		return FALSE;
+	if (g_stat(locale_filename, &s) != 0)
+		return FALSE;
+
+	path = get_tag_cache_path(locale_filename);
+	fp = g_fopen(path, "r");
+	g_free(path);
+	if (fp == NULL)
+		return FALSE;
+
+	if (fgets(header, sizeof header, fp) == NULL ||
+		sscanf(header, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %63s",
+			&csize, &cmtime, checksum) != 3)
+	{
+		fclose(fp);
+		return FALSE;
+	}
+
+	valid = (csize == (guint64) s.st_size);
+	if (valid && cmtime != (guint64) s.st_mtime)
+	{
+		gchar *file_checksum = get_file_checksum(locale_filename);
+
+		valid = file_checksum != NULL && strcmp(file_checksum, checksum) == 0;
+		g_free(file_checksum);
+	}
+	if (valid)
+		valid = tm_source_file_read_tags(source_file, fp);
+
+	fclose(fp);
+	return valid;
+}
+
+/* Stores the tags of source_file in the project tag cache. Should only be
+ * called when the tags describe the current on-disk content of the file,
+ * i.e. when the document is unmodified. */
+void project_save_cached_tags(TMSourceFile *source_file, const gchar *locale_filename)
+{
+	struct stat s;
+	gchar *checksum;
+	gchar *path, *dir;
+	FILE *fp;
+
+	if (app->project == NULL || source_file == NULL)
+		return;
+	if (g_stat(locale_filename, &s) != 0)
+		return;
+
+	checksum = get_file_checksum(locale_filename);
+	if (checksum == NULL)
+		return;
+
+	path = get_tag_cache_path(locale_filename);
+	dir = g_path_get_dirname(path);
+	if (utils_mkdir(dir, TRUE) == 0)
+	{
+		fp = g_fopen(path, "w");
+		if (fp != NULL)
+		{
+			fprintf(fp, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %s\n",
+				(guint64) s.st_size, (guint64) s.st_mtime, checksum);
+			tm_source_file_write_tags(source_file, fp);
+			fclose(fp);
+		}
+	}
+	g_free(dir);
+	g_free(path);
+	g_free(checksum);
+}
+
+
+/* Project file manifest: a persisted list of the files below the project base
+ * path with their size and mtime, stored next to the tag cache. Loading it on
+ * project open gives consumers like Find in Files the file list without walking
+ * the tree; a background walk reconciles it with the disk once per session and
+ * saving or deleting documents keeps it current in between. */
+
+typedef struct
+{
+	guint64 size;
+	guint64 mtime;
+}
+ManifestEntry;
+
+typedef struct
+{
+	gchar *base_path;			/* project base path, locale encoding */
+	GSList *ignore_patterns;	/* GPatternSpec list, matching names are pruned */
+	GHashTable *files;			/* the file list built by the walk */
+	volatile gint cancelled;
+}
+ManifestRefresh;
+
+/* maps absolute locale file path to its ManifestEntry */
+static GHashTable *file_manifest = NULL;
+static gboolean file_manifest_dirty = FALSE;
+/* whether the background walk reconciled the manifest with the disk, i.e.
+ * whether it can be trusted to be complete for this session */
+static gboolean file_manifest_synced = FALSE;
+static ManifestRefresh *file_manifest_refresh = NULL;
+
+
+static gchar *get_manifest_path(void)
+{
+	gchar *locale_project_file = utils_get_locale_from_utf8(app->project->file_name);
+	gchar *project_dir = g_path_get_dirname(locale_project_file);
+	gchar *path = g_strconcat(project_dir, G_DIR_SEPARATOR_S PROJECT_TAG_CACHE_DIR
+		G_DIR_SEPARATOR_S "manifest", NULL);
+
+	g_free(project_dir);
+	g_free(locale_project_file);
+	return path;
+}
+
+
+static void manifest_insert(GHashTable *files, const gchar *locale_filename,
+	guint64 size, guint64 mtime)
+{
+	ManifestEntry *entry = g_new(ManifestEntry, 1);
+
+	entry->size = size;
+	entry->mtime = mtime;
+	g_hash_table_replace(files, g_strdup(locale_filename), entry);
+}
+
+
+static void file_manifest_load(void)
+{
+	gchar *path = get_manifest_path();
+	gchar *contents = NULL;
+
+	file_manifest = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	file_manifest_dirty = FALSE;
+	file_manifest_synced = FALSE;
+
+	if (g_file_get_contents(path, &contents, NULL, NULL))
+	{
+		gchar **lines = g_strsplit(contents, "\n", -1);
+		gchar **line;
+
+		foreach_strv(line, lines)
+		{
+			gchar **fields = g_strsplit(*line, "\t", 3);
+
+			if (g_strv_length(fields) == 3 && !EMPTY(fields[2]))
+				manifest_insert(file_manifest, fields[2],
+					g_ascii_strtoull(fields[0], NULL, 10),
+					g_ascii_strtoull(fields[1], NULL, 10));
+			g_strfreev(fields);
+		}
+		g_strfreev(lines);
+		g_free(contents);
+	}
+	g_free(path);
+}
+
+
+static void manifest_save_entry(gpointer key, gpointer value, gpointer user_data)
+{
+	ManifestEntry *entry = value;
+
+	fprintf((FILE *) user_data, "%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%s\n",
+		entry->size, entry->mtime, (gchar *) key);
+}
+
+
+static void file_manifest_save(void)
+{
+	gchar *path, *dir;
+	FILE *fp;
+
+	if (app->project == NULL || file_manifest == NULL || ! file_manifest_dirty)
+		return;
+
+	path = get_manifest_path();
+	dir = g_path_get_dirname(path);
+	if (utils_mkdir(dir, TRUE) == 0)
+	{
+		fp = g_fopen(path, "w");
+		if (fp != NULL)
+		{
+			g_hash_table_foreach(file_manifest, manifest_save_entry, fp);
+			fclose(fp);
+			file_manifest_dirty = FALSE;
+		}
+	}
+	g_free(dir);
+	g_free(path);
+}
+
+
+static gboolean manifest_name_ignored(ManifestRefresh *mr, const gchar *name)
+{
+	GSList *item;
+
+	foreach_slist(item, mr->ignore_patterns)
+	{
+		if (g_pattern_match_string(item->data, name))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static gboolean manifest_walk_cb(const gchar *dir, const gchar *name,
+	UtilsFSType type, guint64 size, guint64 mtime, gpointer user_data)
+{
+	ManifestRefresh *mr = user_data;
+
+	if (manifest_name_ignored(mr, name))
+		return FALSE;
+
+	if (type == UTILS_FS_FILE)
+	{
+		gchar *path = g_build_filename(dir, name, NULL);
+
+		manifest_insert(mr->files, path, size, mtime);
+		g_free(path);
+	}
+	return TRUE;
+}
+
+
+static void manifest_refresh_free(ManifestRefresh *mr)
+{
+	GSList *item;
+
+	foreach_slist(item, mr->ignore_patterns)
+		g_pattern_spec_free(item->data);
+	g_slist_free(mr->ignore_patterns);
+	if (mr->files != NULL)
+		g_hash_table_destroy(mr->files);
+	g_free(mr->base_path);
+	g_free(mr);
+}
+
+
+/* main thread: adopt the file list built by the background walk, unless the
+ * project was closed or reopened in the meantime */
+static gboolean manifest_refresh_done(gpointer data)
+{
+	ManifestRefresh *mr = data;
+
+	if (mr == file_manifest_refresh)
+	{
+		file_manifest_refresh = NULL;
+		g_hash_table_destroy(file_manifest);
+		file_manifest = mr->files;
+		mr->files = NULL;
+		file_manifest_synced = TRUE;
+		file_manifest_dirty = TRUE;
+		file_manifest_save();
+	}
+	manifest_refresh_free(mr);
+	return FALSE;
+}
+
+
+static gpointer manifest_refresh_thread(gpointer data)
+{
+	ManifestRefresh *mr = data;
+
+	utils_fs_walk(mr->base_path, TRUE, manifest_walk_cb, mr, &mr->cancelled);
+	g_idle_add(manifest_refresh_done, mr);
+	return NULL;
+}
+
+
+/* loads the persisted manifest and starts the background walk reconciling it */
+static void file_manifest_open(void)
+{
+	ManifestRefresh *mr;
+	gchar *utf8_base = project_get_base_path();
+
+	if (file_manifest == NULL)
+		file_manifest_load();
+
+	if (utf8_base == NULL)
+		return;
+
+	if (file_manifest_refresh != NULL)
+	{
+		g_atomic_int_set(&file_manifest_refresh->cancelled, TRUE);
+		file_manifest_refresh = NULL;
+	}
+	mr = g_new0(ManifestRefresh, 1);
+	mr->base_path = utils_get_locale_from_utf8(utf8_base);
+	if (app->project->ignore_patterns != NULL)
+	{
+		gchar **pat;
+
+		foreach_strv(pat, app->project->ignore_patterns)
+		{
+			if (! EMPTY(*pat))
+				mr->ignore_patterns = g_slist_prepend(mr->ignore_patterns,
+					g_pattern_spec_new(*pat));
+		}
+	}
+	mr->files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	file_manifest_refresh = mr;
+	g_thread_create(manifest_refresh_thread, mr, FALSE, NULL);
+	g_free(utf8_base);
+}
+
+
+static void file_manifest_close(void)
+{
+	if (file_manifest_refresh != NULL)
+	{
+		g_atomic_int_set(&file_manifest_refresh->cancelled, TRUE);
+		file_manifest_refresh = NULL;
+	}
+	if (file_manifest != NULL)
+	{
+		file_manifest_save();
+		g_hash_table_destroy(file_manifest);
+		file_manifest = NULL;
+	}
+	file_manifest_synced = FALSE;
+}
+
+
+/* Records in the manifest that locale_filename was written or removed; called
+ * from the document save and file monitor layers. */
+void project_update_file_manifest(const gchar *locale_filename)
+{
+	struct stat s;
+	gchar *utf8_base, *locale_base;
+	gboolean tracked;
+	gsize len;
+
+	if (app->project == NULL || file_manifest == NULL || locale_filename == NULL)
+		return;
+
+	utf8_base = project_get_base_path();
+	if (utf8_base == NULL)
+		return;
+	locale_base = utils_get_locale_from_utf8(utf8_base);
+	len = strlen(locale_base);
+	while (len > 0 && locale_base[len - 1] == G_DIR_SEPARATOR)
+		len--;
+	tracked = strncmp(locale_filename, locale_base, len) == 0 &&
+		locale_filename[len] == G_DIR_SEPARATOR;
+	g_free(locale_base);
+	g_free(utf8_base);
+	if (! tracked)
+		return;
+
+	if (g_stat(locale_filename, &s) == 0 && ! S_ISDIR(s.st_mode))
+		manifest_insert(file_manifest, locale_filename, (guint64) s.st_size, (guint64) s.st_mtime);
+	else if (! g_hash_table_remove(file_manifest, locale_filename))
+		return;
+	file_manifest_dirty = TRUE;
+}
+
+
+/* Returns the file paths below locale_root recorded in the project file
+ * manifest, relative to locale_root, or NULL when no manifest is available or
+ * it has not been reconciled with the disk yet. The paths and the array are
+ * owned by the caller. */
+GPtrArray *project_get_file_list(const gchar *locale_root)
+{
+	GPtrArray *list;
+	GHashTableIter iter;
+	gpointer key;
+	gsize len;
+
+	if (app->project == NULL || file_manifest == NULL || ! file_manifest_synced ||
+		locale_root == NULL)
+		return NULL;
+
+	len = strlen(locale_root);
+	while (len > 0 && locale_root[len - 1] == G_DIR_SEPARATOR)
+		len--;
+
+	list = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, file_manifest);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		const gchar *path = key;
+
+		if (strncmp(path, locale_root, len) == 0 && path[len] == G_DIR_SEPARATOR)
+			g_ptr_array_add(list, g_strdup(path + len + 1));
+	}
+	if (list->len == 0)
+	{
+		g_ptr_array_free(list, TRUE);
+		return NULL;
+	}
+	return list;
+}
+
+
+/** Forces the project file rewrite and emission of the project-save signal. Plugins
  * can use this function to save additional project data outside the project dialog.
  *
  *  @since 1.25
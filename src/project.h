@@ -41,6 +41,9 @@ typedef struct GeanyProject
 	 * by a plugin. */
 	gint type;
 	gchar **file_patterns;	/**< Array of filename extension patterns. */
+	/** Array of glob patterns for path components to skip when walking the project
+	 * tree, e.g. VCS and build directories ("ignore_patterns" in the project file). */
+	gchar **ignore_patterns;
 
 	struct GeanyProjectPrivate	*priv;	/* must be last, append fields before this item */
 }
@@ -52,6 +55,8 @@ void project_write_config(void);
 
 #ifdef GEANY_PRIVATE
 
+#include "tm_source_file.h"
+
 typedef struct ProjectPrefs
 {
 	gchar *session_file;
@@ -86,6 +91,14 @@ gboolean project_load_file_with_session(const gchar *locale_file_name);
 
 gchar *project_get_base_path(void);
 
+gboolean project_load_cached_tags(TMSourceFile *source_file, const gchar *locale_filename);
+
+void project_save_cached_tags(TMSourceFile *source_file, const gchar *locale_filename);
+
+void project_update_file_manifest(const gchar *locale_filename);
+
+GPtrArray *project_get_file_list(const gchar *locale_root);
+
 
 const struct GeanyFilePrefs *project_get_file_prefs(void);
 
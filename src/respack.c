@@ -0,0 +1,195 @@
+/*
+ *      respack.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Bundled resource pack for the system data directory.
+ *
+ * Cold starts used to open several hundred small files below app->datadir
+ * (filetype definitions, templates, snippets, colorschemes); on network home
+ * or data directories every open is a metadata round trip.  At build time
+ * scripts/create-respack.py concatenates those files into a single archive,
+ * geany.pack, which is mmap()ed once here.  respack_lookup() then serves file
+ * contents straight out of the mapping, and respack_load_key_file() is a
+ * drop-in replacement for g_key_file_load_from_file() that tries the pack
+ * first.  When the pack is missing or does not contain a file, everything
+ * falls back to reading from disk, so an unpacked installation keeps working
+ * unchanged. */
+
+#include "respack.h"
+
+#include "geany.h"
+
+#include <string.h>
+
+
+/* see scripts/create-respack.py for the writer side of this format */
+#define RESPACK_MAGIC		"GnyPack1"
+#define RESPACK_MAGIC_LEN	8
+#define RESPACK_FILENAME	"geany.pack"
+
+typedef struct
+{
+	gsize offset;
+	gsize size;
+}
+RespackEntry;
+
+static GMappedFile *pack_map = NULL;
+static GHashTable *pack_entries = NULL;	/* relative path -> RespackEntry */
+static gchar *pack_datadir = NULL;
+
+
+static guint32 read_u32(const guchar *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+
+/* Parses the entry table; returns FALSE if the file is truncated or not a
+ * pack, in which case no entries are kept and lookups fall back to disk. */
+static gboolean respack_parse(const gchar *data, gsize size)
+{
+	const guchar *p = (const guchar *) data;
+	gsize pos = RESPACK_MAGIC_LEN;
+	guint32 count, i;
+
+	if (size < RESPACK_MAGIC_LEN + 4 ||
+		memcmp(data, RESPACK_MAGIC, RESPACK_MAGIC_LEN) != 0)
+		return FALSE;
+
+	count = read_u32(p + pos);
+	pos += 4;
+
+	for (i = 0; i < count; i++)
+	{
+		RespackEntry *entry;
+		guint path_len;
+		gchar *path;
+
+		if (pos + 2 > size)
+			return FALSE;
+		path_len = p[pos] | (p[pos + 1] << 8);
+		pos += 2;
+
+		if (pos + path_len + 8 > size)
+			return FALSE;
+		path = g_strndup(data + pos, path_len);
+		pos += path_len;
+
+		entry = g_new(RespackEntry, 1);
+		entry->offset = read_u32(p + pos);
+		entry->size = read_u32(p + pos + 4);
+		pos += 8;
+
+		if (entry->offset + entry->size > size)
+		{
+			g_free(path);
+			g_free(entry);
+			return FALSE;
+		}
+		g_hash_table_insert(pack_entries, path, entry);
+	}
+	return TRUE;
+}
+
+
+/* Maps the resource pack for the passed system data directory, if one was
+ * installed.  A missing pack is not an error. */
+void respack_init(const gchar *datadir)
+{
+	gchar *filename = g_build_filename(datadir, RESPACK_FILENAME, NULL);
+
+	pack_map = g_mapped_file_new(filename, FALSE, NULL);
+	if (pack_map != NULL)
+	{
+		pack_entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		if (respack_parse(g_mapped_file_get_contents(pack_map),
+				g_mapped_file_get_length(pack_map)))
+		{
+			pack_datadir = g_strdup(datadir);
+			geany_debug("Using resource pack %s (%u files).",
+				filename, g_hash_table_size(pack_entries));
+		}
+		else
+		{
+			g_warning("Ignoring malformed resource pack %s.", filename);
+			respack_finalize();
+		}
+	}
+	g_free(filename);
+}
+
+
+void respack_finalize(void)
+{
+	if (pack_entries != NULL)
+	{
+		g_hash_table_destroy(pack_entries);
+		pack_entries = NULL;
+	}
+	if (pack_map != NULL)
+	{
+		g_mapped_file_free(pack_map);
+		pack_map = NULL;
+	}
+	g_free(pack_datadir);
+	pack_datadir = NULL;
+}
+
+
+/* Returns the contents of filename from the resource pack, or NULL if the
+ * file is not bundled (also when no pack is loaded or the path lies outside
+ * the system data directory).  The returned pointer is into the mapping and
+ * stays valid until respack_finalize(); it is not NUL-terminated, use the
+ * returned length. */
+const gchar *respack_lookup(const gchar *filename, gsize *length)
+{
+	const gchar *rel;
+	RespackEntry *entry;
+
+	if (pack_datadir == NULL || ! g_str_has_prefix(filename, pack_datadir))
+		return NULL;
+
+	rel = filename + strlen(pack_datadir);
+	while (*rel == G_DIR_SEPARATOR)
+		rel++;
+
+	entry = g_hash_table_lookup(pack_entries, rel);
+	if (entry == NULL)
+		return NULL;
+
+	if (length != NULL)
+		*length = entry->size;
+	return g_mapped_file_get_contents(pack_map) + entry->offset;
+}
+
+
+/* Like g_key_file_load_from_file(), but serves the contents from the resource
+ * pack when the file is bundled in it. */
+gboolean respack_load_key_file(GKeyFile *key_file, const gchar *filename,
+		GKeyFileFlags flags, GError **error)
+{
+	gsize length;
+	const gchar *data = respack_lookup(filename, &length);
+
+	if (data != NULL)
+		return g_key_file_load_from_data(key_file, data, length, flags, error);
+
+	return g_key_file_load_from_file(key_file, filename, flags, error);
+}
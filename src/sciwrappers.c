@@ -178,6 +178,16 @@ void sci_add_text(ScintillaObject *sci, const gchar *text)
 }
 
 
+/* appends text at the end of the buffer without changing the selection */
+void sci_append_text(ScintillaObject *sci, const gchar *text, gsize len)
+{
+	if (text != NULL)
+	{ /* if null text is passed scintilla will segfault */
+		SSM(sci, SCI_APPENDTEXT, (uptr_t) len, (sptr_t) text);
+	}
+}
+
+
 /** Sets all text.
  * @param sci Scintilla widget.
  * @param text Text. */
@@ -956,6 +966,26 @@ gchar *sci_get_contents_range(ScintillaObject *sci, gint start, gint end)
 }
 
 
+/* Returns a pointer into Scintilla's own buffer covering the whole document.
+ * Zero-copy, but forces the gap to the end of the document; for reading a
+ * bounded range prefer sci_get_range_pointer(). The pointer is only valid
+ * until the next modifying SCI message. */
+const gchar *sci_get_character_pointer(ScintillaObject *sci)
+{
+	return (const gchar *) SSM(sci, SCI_GETCHARACTERPOINTER, 0, 0);
+}
+
+
+/* Returns a pointer into Scintilla's own buffer covering [start, start + len).
+ * Zero-copy and only moves the gap when the range straddles it. The text is
+ * not NUL-terminated and the pointer is only valid until the next modifying
+ * SCI message. */
+const gchar *sci_get_range_pointer(ScintillaObject *sci, gint start, gint len)
+{
+	return (const gchar *) SSM(sci, SCI_GETRANGEPOINTER, (uptr_t) start, (sptr_t) len);
+}
+
+
 void sci_line_duplicate(ScintillaObject *sci)
 {
 	SSM(sci, SCI_LINEDUPLICATE, 0, 0);
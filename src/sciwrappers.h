@@ -77,6 +77,8 @@ void				sci_goto_line				(ScintillaObject *sci, gint line, gboolean unfold);
 gint				sci_get_style_at			(ScintillaObject *sci, gint position);
 void				sci_get_text_range			(ScintillaObject *sci, gint start, gint end, gchar *text);
 gchar*				sci_get_contents_range		(ScintillaObject *sci, gint start, gint end);
+const gchar*		sci_get_character_pointer	(ScintillaObject *sci);
+const gchar*		sci_get_range_pointer		(ScintillaObject *sci, gint start, gint len);
 void				sci_insert_text				(ScintillaObject *sci, gint pos, const gchar *text);
 
 void				sci_set_target_start		(ScintillaObject *sci, gint start);
@@ -104,6 +106,7 @@ void 				sci_set_line_numbers		(ScintillaObject *sci,  gboolean set);
 void				sci_set_mark_long_lines		(ScintillaObject *sci,	gint type, gint column, const gchar *color);
 
 void 				sci_add_text				(ScintillaObject *sci,  const gchar *text);
+void				sci_append_text				(ScintillaObject *sci,  const gchar *text, gsize len);
 gboolean			sci_can_redo				(ScintillaObject *sci);
 gboolean			sci_can_undo				(ScintillaObject *sci);
 void 				sci_undo					(ScintillaObject *sci);
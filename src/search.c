@@ -31,23 +31,29 @@
 #include "search.h"
 
 #include "app.h"
+#include "dialogs.h"
 #include "document.h"
+#include "documentprivate.h"
 #include "encodings.h"
 #include "keyfile.h"
 #include "msgwindow.h"
 #include "prefs.h"
+#include "project.h"
 #include "sciwrappers.h"
 #include "stash.h"
+#include "stats.h"
 #include "support.h"
 #include "toolbar.h"
 #include "ui_utils.h"
 #include "utils.h"
+#include "utils_fs.h"
 
 #include "gtkcompat.h"
 
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <glib/gstdio.h>
 
 #ifdef G_OS_UNIX
 # include <sys/types.h>
@@ -88,8 +94,11 @@ static struct
 	gboolean fif_regexp;
 	gboolean fif_case_sensitive;
 	gboolean fif_match_whole_word;
+	gboolean fif_multi_pattern;
 	gboolean fif_invert_results;
 	gboolean fif_recursive;
+	gboolean fif_native_engine;
+	gboolean fif_open_docs;
 	gboolean fif_use_extra_options;
 	gchar *fif_extra_options;
 	gint fif_files_mode;
@@ -156,6 +165,8 @@ static void search_close_pid(GPid child_pid, gint status, gpointer user_data);
 
 static gchar **search_get_argv(const gchar **argv_prefix, const gchar *dir);
 
+static gboolean pattern_list_match(GSList *patterns, const gchar *str);
+
 static GRegex *compile_regex(const gchar *str, GeanyFindFlags sflags);
 
 
@@ -221,10 +232,16 @@ static void init_prefs(void)
 		"fif_case_sensitive", TRUE, "check_case");
 	stash_group_add_toggle_button(group, &settings.fif_match_whole_word,
 		"fif_match_whole_word", FALSE, "check_wholeword");
+	stash_group_add_toggle_button(group, &settings.fif_multi_pattern,
+		"fif_multi_pattern", FALSE, "check_multi_pattern");
 	stash_group_add_toggle_button(group, &settings.fif_invert_results,
 		"fif_invert_results", FALSE, "check_invert");
 	stash_group_add_toggle_button(group, &settings.fif_recursive,
 		"fif_recursive", FALSE, "check_recursive");
+	stash_group_add_toggle_button(group, &settings.fif_native_engine,
+		"fif_native_engine", FALSE, "check_native_engine");
+	stash_group_add_toggle_button(group, &settings.fif_open_docs,
+		"fif_open_docs", FALSE, "check_open_docs");
 	stash_group_add_entry(group, &settings.fif_extra_options,
 		"fif_extra_options", "", "entry_extra");
 	stash_group_add_toggle_button(group, &settings.fif_use_extra_options,
@@ -274,6 +291,203 @@ static void init_prefs(void)
 }
 
 
+/* Shared, persistent MRU history for the search dialogs. The Find, Replace and
+ * Find in Files dialogs fill their drop down lists from these queues, so a term
+ * used in one dialog is offered by the others as well. The history is persisted
+ * to an append-only journal in the configuration directory: recording an entry
+ * appends a single line instead of rewriting the whole history, and the journal
+ * is compacted once it has grown well past the number of live items. */
+enum
+{
+	SEARCH_HISTORY_FIND,	/* search terms, shared by all three dialogs */
+	SEARCH_HISTORY_REPLACE,
+	SEARCH_HISTORY_FILES,
+	SEARCH_HISTORY_DIR,
+	SEARCH_HISTORY_KIND_COUNT
+};
+
+/* matches the default list length of ui_combo_box_add_to_history() */
+#define SEARCH_HISTORY_LEN 10
+/* journal size (in lines) at which it is rewritten with just the live items */
+#define SEARCH_HISTORY_COMPACT_LIMIT (SEARCH_HISTORY_KIND_COUNT * SEARCH_HISTORY_LEN * 4)
+
+static GQueue *search_history[SEARCH_HISTORY_KIND_COUNT] = { NULL };
+static guint search_history_journal_lines = 0;
+
+
+static gchar *search_history_filename(void)
+{
+	return g_build_filename(app->configdir, "search_history", NULL);
+}
+
+
+/* Moves @text to the front of the bounded queue; the journal is not touched. */
+static void search_history_remember(gint kind, const gchar *text)
+{
+	GQueue *queue = search_history[kind];
+	GList *node;
+
+	foreach_list(node, queue->head)
+	{
+		if (utils_str_equal(node->data, text))
+		{
+			g_free(node->data);
+			g_queue_delete_link(queue, node);
+			break;
+		}
+	}
+	g_queue_push_head(queue, g_strdup(text));
+	while (queue->length > SEARCH_HISTORY_LEN)
+		g_free(g_queue_pop_tail(queue));
+}
+
+
+static void search_history_load(void)
+{
+	guint i;
+	gchar *filename, *contents = NULL;
+	gchar **lines, **line;
+
+	if (search_history[0] != NULL)
+		return;
+
+	for (i = 0; i < SEARCH_HISTORY_KIND_COUNT; i++)
+		search_history[i] = g_queue_new();
+
+	filename = search_history_filename();
+	g_file_get_contents(filename, &contents, NULL, NULL);
+	g_free(filename);
+	if (contents == NULL)
+		return;
+
+	lines = g_strsplit(contents, "\n", -1);
+	for (line = lines; *line != NULL; line++)
+	{
+		gchar *tab = strchr(*line, '\t');
+		gint kind;
+
+		if (tab == NULL)	/* skip blank or truncated lines */
+			continue;
+		kind = atoi(*line);
+		if (kind < 0 || kind >= SEARCH_HISTORY_KIND_COUNT || EMPTY(tab + 1))
+			continue;
+		/* replaying the journal in order leaves the most recent use in front */
+		search_history_remember(kind, tab + 1);
+		search_history_journal_lines++;
+	}
+	g_strfreev(lines);
+	g_free(contents);
+}
+
+
+/* rewrites the journal with just the live items, oldest first so that
+ * replaying it on load restores the MRU order */
+static void search_history_compact(void)
+{
+	GString *buffer = g_string_new(NULL);
+	gchar *filename = search_history_filename();
+	guint kind;
+
+	search_history_journal_lines = 0;
+	for (kind = 0; kind < SEARCH_HISTORY_KIND_COUNT; kind++)
+	{
+		GList *node;
+
+		for (node = search_history[kind]->tail; node != NULL; node = node->prev)
+		{
+			g_string_append_printf(buffer, "%u\t%s\n", kind, (gchar *) node->data);
+			search_history_journal_lines++;
+		}
+	}
+	g_file_set_contents(filename, buffer->str, buffer->len, NULL);
+	g_free(filename);
+	g_string_free(buffer, TRUE);
+}
+
+
+static void search_history_append_journal(gint kind, const gchar *text)
+{
+	if (search_history_journal_lines >= SEARCH_HISTORY_COMPACT_LIMIT)
+		search_history_compact();
+	else
+	{
+		gchar *filename = search_history_filename();
+		FILE *fp = g_fopen(filename, "ab");
+
+		if (fp != NULL)
+		{
+			fprintf(fp, "%d\t%s\n", kind, text);
+			fclose(fp);
+			search_history_journal_lines++;
+		}
+		g_free(filename);
+	}
+}
+
+
+/* prepends @text to every existing combo showing histories of @kind, so the
+ * dialogs stay in sync without re-filling their models */
+static void search_history_update_combos(gint kind, const gchar *text)
+{
+	GtkWidget *combos[3] = { NULL, NULL, NULL };
+	guint i;
+
+	switch (kind)
+	{
+		case SEARCH_HISTORY_FIND:
+			if (find_dlg.dialog != NULL)
+				combos[0] = gtk_widget_get_parent(find_dlg.entry);
+			if (replace_dlg.dialog != NULL)
+				combos[1] = gtk_widget_get_parent(replace_dlg.find_entry);
+			if (fif_dlg.dialog != NULL)
+				combos[2] = fif_dlg.search_combo;
+			break;
+		case SEARCH_HISTORY_REPLACE:
+			if (replace_dlg.dialog != NULL)
+				combos[0] = gtk_widget_get_parent(replace_dlg.replace_entry);
+			break;
+		case SEARCH_HISTORY_FILES:
+			if (fif_dlg.dialog != NULL)
+				combos[0] = fif_dlg.files_combo;
+			break;
+		case SEARCH_HISTORY_DIR:
+			if (fif_dlg.dialog != NULL)
+				combos[0] = fif_dlg.dir_combo;
+			break;
+	}
+	for (i = 0; i < G_N_ELEMENTS(combos); i++)
+	{
+		if (combos[i] != NULL)
+			ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(combos[i]), text, 0);
+	}
+}
+
+
+static void search_history_add(gint kind, const gchar *text)
+{
+	if (EMPTY(text))
+		return;
+	search_history_load();
+	search_history_remember(kind, text);
+	/* entries come from single-line entry widgets, but be safe against
+	 * embedded newlines which would corrupt the journal */
+	if (strchr(text, '\n') == NULL)
+		search_history_append_journal(kind, text);
+	search_history_update_combos(kind, text);
+}
+
+
+/* fills a freshly created combo from the history, newest item first */
+static void search_history_fill_combo(gint kind, GtkWidget *combo)
+{
+	GList *node;
+
+	search_history_load();
+	foreach_list(node, search_history[kind]->head)
+		gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), node->data);
+}
+
+
 void search_init(void)
 {
 	search_data.text = NULL;
@@ -287,11 +501,23 @@ void search_init(void)
 
 void search_finalize(void)
 {
+	guint i;
+
 	FREE_WIDGET(find_dlg.dialog);
 	FREE_WIDGET(replace_dlg.dialog);
 	FREE_WIDGET(fif_dlg.dialog);
 	g_free(search_data.text);
 	g_free(search_data.original_text);
+
+	for (i = 0; i < SEARCH_HISTORY_KIND_COUNT; i++)
+	{
+		if (search_history[i] != NULL)
+		{
+			g_queue_foreach(search_history[i], (GFunc) g_free, NULL);
+			g_queue_free(search_history[i]);
+			search_history[i] = NULL;
+		}
+	}
 }
 
 
@@ -488,6 +714,7 @@ static void create_find_dialog(void)
 	gtk_label_set_mnemonic_widget(GTK_LABEL(label), entry);
 	gtk_entry_set_width_chars(GTK_ENTRY(gtk_bin_get_child(GTK_BIN(entry))), 50);
 	find_dlg.entry = gtk_bin_get_child(GTK_BIN(entry));
+	search_history_fill_combo(SEARCH_HISTORY_FIND, entry);
 
 	g_signal_connect(gtk_bin_get_child(GTK_BIN(entry)), "activate",
 			G_CALLBACK(on_find_entry_activate), entry);
@@ -650,6 +877,7 @@ static void create_replace_dialog(void)
 	gtk_entry_set_width_chars(GTK_ENTRY(gtk_bin_get_child(GTK_BIN(entry_find))), 50);
 	ui_hookup_widget(replace_dlg.dialog, entry_find, "entry_find");
 	replace_dlg.find_entry = gtk_bin_get_child(GTK_BIN(entry_find));
+	search_history_fill_combo(SEARCH_HISTORY_FIND, entry_find);
 
 	entry_replace = gtk_combo_box_text_new_with_entry();
 	ui_entry_add_clear_icon(GTK_ENTRY(gtk_bin_get_child(GTK_BIN(entry_replace))));
@@ -657,6 +885,7 @@ static void create_replace_dialog(void)
 	gtk_entry_set_width_chars(GTK_ENTRY(gtk_bin_get_child(GTK_BIN(entry_replace))), 50);
 	ui_hookup_widget(replace_dlg.dialog, entry_replace, "entry_replace");
 	replace_dlg.replace_entry = gtk_bin_get_child(GTK_BIN(entry_replace));
+	search_history_fill_combo(SEARCH_HISTORY_REPLACE, entry_replace);
 
 	/* tab from find to the replace entry */
 	g_signal_connect(gtk_bin_get_child(GTK_BIN(entry_find)),
@@ -862,7 +1091,8 @@ static void create_fif_dialog(void)
 {
 	GtkWidget *dir_combo, *combo, *fcombo, *e_combo, *entry;
 	GtkWidget *label, *label1, *label2, *label3, *checkbox1, *checkbox2, *check_wholeword,
-		*check_recursive, *check_extra, *entry_extra, *check_regexp, *combo_files_mode;
+		*check_recursive, *check_native, *check_open_docs, *check_multi, *check_extra, *entry_extra,
+		*check_regexp, *combo_files_mode;
 	GtkWidget *dbox, *sbox, *lbox, *rbox, *hbox, *vbox, *ebox;
 	GtkSizeGroup *size_group;
 
@@ -887,6 +1117,7 @@ static void create_fif_dialog(void)
 	gtk_entry_set_width_chars(GTK_ENTRY(entry), 50);
 	gtk_entry_set_activates_default(GTK_ENTRY(entry), TRUE);
 	fif_dlg.search_combo = combo;
+	search_history_fill_combo(SEARCH_HISTORY_FIND, combo);
 
 	sbox = gtk_hbox_new(FALSE, 6);
 	gtk_box_pack_start(GTK_BOX(sbox), label, FALSE, FALSE, 0);
@@ -911,6 +1142,7 @@ static void create_fif_dialog(void)
 	gtk_widget_set_tooltip_text(entry, _("File patterns, e.g. *.c *.h"));
 	ui_hookup_widget(fif_dlg.dialog, entry, "entry_files");
 	fif_dlg.files_combo = fcombo;
+	search_history_fill_combo(SEARCH_HISTORY_FILES, fcombo);
 
 	/* update the entry when selection is changed */
 	g_signal_connect(combo_files_mode, "changed", G_CALLBACK(update_file_patterns), fcombo);
@@ -930,6 +1162,7 @@ static void create_fif_dialog(void)
 	gtk_label_set_mnemonic_widget(GTK_LABEL(label1), entry);
 	gtk_entry_set_width_chars(GTK_ENTRY(entry), 50);
 	fif_dlg.dir_combo = dir_combo;
+	search_history_fill_combo(SEARCH_HISTORY_DIR, dir_combo);
 
 	/* tab from files to the dir entry */
 	g_signal_connect(gtk_bin_get_child(GTK_BIN(fcombo)), "key-press-event",
@@ -989,10 +1222,32 @@ static void create_fif_dialog(void)
 	gtk_container_add(GTK_CONTAINER(lbox), checkbox2);
 	gtk_container_add(GTK_CONTAINER(lbox), check_recursive);
 
+	check_native = gtk_check_button_new_with_mnemonic(_("Use _built-in search engine"));
+	ui_hookup_widget(fif_dlg.dialog, check_native, "check_native_engine");
+	gtk_button_set_focus_on_click(GTK_BUTTON(check_native), FALSE);
+	gtk_widget_set_tooltip_text(check_native,
+			_("Search in-process with multiple threads instead of spawning the Grep tool"));
+
+	check_open_docs = gtk_check_button_new_with_mnemonic(_("Open _documents only"));
+	ui_hookup_widget(fif_dlg.dialog, check_open_docs, "check_open_docs");
+	gtk_button_set_focus_on_click(GTK_BUTTON(check_open_docs), FALSE);
+	gtk_widget_set_tooltip_text(check_open_docs,
+			_("Search the open documents including unsaved changes instead of "
+			  "files on disk (requires the built-in search engine)"));
+
+	check_multi = gtk_check_button_new_with_mnemonic(_("Multiple _patterns"));
+	ui_hookup_widget(fif_dlg.dialog, check_multi, "check_multi_pattern");
+	gtk_button_set_focus_on_click(GTK_BUTTON(check_multi), FALSE);
+	gtk_widget_set_tooltip_text(check_multi,
+			_("Treat the search text as a space-separated list of patterns and "
+			  "find lines matching any of them in a single pass"));
+
 	rbox = gtk_vbox_new(FALSE, 0);
 	gtk_container_add(GTK_CONTAINER(rbox), checkbox1);
 	gtk_container_add(GTK_CONTAINER(rbox), check_wholeword);
-	gtk_container_add(GTK_CONTAINER(rbox), gtk_label_new(NULL));
+	gtk_container_add(GTK_CONTAINER(rbox), check_multi);
+	gtk_container_add(GTK_CONTAINER(rbox), check_native);
+	gtk_container_add(GTK_CONTAINER(lbox), check_open_docs);
 
 	hbox = gtk_hbox_new(FALSE, 6);
 	gtk_container_add(GTK_CONTAINER(hbox), lbox);
@@ -1093,7 +1348,7 @@ void search_show_find_in_files_dialog_full(const gchar *text, const gchar *dir)
 			if (doc == last_doc && cur_dir && utils_str_equal(cur_dir, last_cur_dir))
 			{
 				/* in case the user now wants the current directory, add it to history */
-				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(fif_dlg.dir_combo), cur_dir, 0);
+				search_history_add(SEARCH_HISTORY_DIR, cur_dir);
 				SETPTR(cur_dir, NULL);
 			}
 			else
@@ -1186,20 +1441,134 @@ void geany_match_info_free(GeanyMatchInfo *info)
 }
 
 
-/* find all in the given range.
- * Returns a list of allocated GeanyMatchInfo, should be freed using:
- *
- * 	foreach_slist(node, matches)
- * 		geany_match_info_free(node->data);
- * 	g_slist_free(matches); */
-static GSList *find_range(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_TextToFind *ttf)
+/* fills a GeanyMatchInfo from a GMatchInfo, mirroring what find_regex() does.
+ * offset is added to the match positions (e.g. the position of the line start when
+ * matching against a single line) */
+static GeanyMatchInfo *match_info_new_from_regex(GeanyFindFlags flags, GMatchInfo *minfo, gint offset)
+{
+	GeanyMatchInfo *info = match_info_new(flags, 0, 0);
+	guint i;
+
+	SETPTR(info->match_text, g_match_info_fetch(minfo, 0));
+
+	foreach_range(i, G_N_ELEMENTS(info->matches))
+	{
+		gint start = -1, end = -1;
+
+		g_match_info_fetch_pos(minfo, (gint)i, &start, &end);
+		info->matches[i].start = offset + start;
+		info->matches[i].end = offset + end;
+	}
+	info->start = info->matches[0].start;
+	info->end = info->matches[0].end;
+
+	return info;
+}
+
+
+/* Callback for find_range_foreach(). Receives ownership of @info, so it has to
+ * free it with geany_match_info_free() if it doesn't keep it. Return FALSE to
+ * stop the search early.
+ * Warning: the callback must not modify the document and must not use gap-moving
+ * messages like SCI_GETRANGEPOINTER or SCI_GETCHARACTERPOINTER, because the
+ * search holds pointers into the buffer across calls. */
+typedef gboolean (*FindRangeFunc)(ScintillaObject *sci, GeanyMatchInfo *info, gpointer user_data);
+
+/* Batched regex version of find_range_foreach(): the pattern is compiled once and all
+ * matches are found by walking the match info, instead of restarting the search - and
+ * recompiling the pattern - once per match as search_find_text() does. */
+static void find_range_regex_foreach(ScintillaObject *sci, GeanyFindFlags flags,
+		struct Sci_TextToFind *ttf, FindRangeFunc func, gpointer user_data)
+{
+	GRegex *regex;
+	GMatchInfo *minfo;
+	gboolean done = FALSE;
+	const gchar *text;
+
+	regex = compile_regex(ttf->lpstrText, flags);
+	if (! regex)
+		return;
+
+	if (flags & GEANY_FIND_MULTILINE)
+	{
+		/* Warning: any SCI calls will invalidate 'text' after calling SCI_GETCHARACTERPOINTER */
+		text = sci_get_character_pointer(sci);
+		g_regex_match_full(regex, text, -1, ttf->chrg.cpMin, 0, &minfo, NULL);
+		while (g_match_info_matches(minfo))
+		{
+			GeanyMatchInfo *info = match_info_new_from_regex(flags, minfo, 0);
+
+			if (info->start >= ttf->chrg.cpMax || info->end > ttf->chrg.cpMax)
+			{	/* found text is (partially) out of range */
+				geany_match_info_free(info);
+				break;
+			}
+			if (! func(sci, info, user_data))
+				break;
+			if (! g_match_info_next(minfo, NULL))
+				break;
+		}
+		g_match_info_free(minfo);
+	}
+	else /* single-line mode, manually match against each line */
+	{
+		gint line = sci_get_line_from_position(sci, ttf->chrg.cpMin);
+		gint line_count = sci_get_line_count(sci);
+
+		for (; line < line_count && ! done; line++)
+		{
+			gint start = sci_get_position_from_line(sci, line);
+			gint end = sci_get_line_end_position(sci, line);
+			gint offset = MAX(start, (gint)ttf->chrg.cpMin) - start;
+
+			if (start >= ttf->chrg.cpMax)
+				break;
+
+			text = sci_get_range_pointer(sci, start, end - start);
+			g_regex_match_full(regex, text, end - start, offset, 0, &minfo, NULL);
+			while (g_match_info_matches(minfo))
+			{
+				GeanyMatchInfo *info = match_info_new_from_regex(flags, minfo, start);
+
+				if (info->start >= ttf->chrg.cpMax || info->end > ttf->chrg.cpMax)
+				{	/* found text is (partially) out of range */
+					geany_match_info_free(info);
+					done = TRUE;
+					break;
+				}
+				if (! func(sci, info, user_data))
+				{
+					done = TRUE;
+					break;
+				}
+				if (! g_match_info_next(minfo, NULL))
+					break;
+			}
+			g_match_info_free(minfo);
+		}
+	}
+
+	g_regex_unref(regex);
+}
+
+
+/* find all in the given range, streaming each match to @func as it is found
+ * instead of collecting everything in memory first.  See FindRangeFunc for
+ * the ownership rules and the restrictions on what the callback may do. */
+static void find_range_foreach(ScintillaObject *sci, GeanyFindFlags flags,
+		struct Sci_TextToFind *ttf, FindRangeFunc func, gpointer user_data)
 {
-	GSList *matches = NULL;
 	GeanyMatchInfo *info;
 
-	g_return_val_if_fail(sci != NULL && ttf->lpstrText != NULL, NULL);
+	g_return_if_fail(sci != NULL && ttf->lpstrText != NULL);
 	if (! *ttf->lpstrText)
-		return NULL;
+		return;
+
+	if (flags & GEANY_FIND_REGEXP)
+	{
+		find_range_regex_foreach(sci, flags, ttf, func, user_data);
+		return;
+	}
 
 	while (search_find_text(sci, flags, ttf, &info) != -1)
 	{
@@ -1210,7 +1579,6 @@ static GSList *find_range(ScintillaObject *sci, GeanyFindFlags flags, struct Sci
 			break;
 		}
 
-		matches = g_slist_prepend(matches, info);
 		ttf->chrg.cpMin = ttf->chrgText.cpMax;
 
 		/* avoid rematching with empty matches like "(?=[a-z])" or "^$".
@@ -1218,30 +1586,77 @@ static GSList *find_range(ScintillaObject *sci, GeanyFindFlags flags, struct Sci
 		 * matches like "a?(?=b)" will sometimes be empty and sometimes not */
 		if (ttf->chrgText.cpMax == ttf->chrgText.cpMin)
 			ttf->chrg.cpMin ++;
+
+		if (! func(sci, info, user_data))
+			break;
 	}
+}
+
+
+static gboolean find_range_collect(ScintillaObject *sci, GeanyMatchInfo *info, gpointer user_data)
+{
+	GSList **matches = user_data;
+
+	*matches = g_slist_prepend(*matches, info);
+	return TRUE;
+}
+
+
+/* find all in the given range.
+ * Returns a list of allocated GeanyMatchInfo, should be freed using:
+ *
+ * 	foreach_slist(node, matches)
+ * 		geany_match_info_free(node->data);
+ * 	g_slist_free(matches); */
+static GSList *find_range(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_TextToFind *ttf)
+{
+	GSList *matches = NULL;
+
+	find_range_foreach(sci, flags, ttf, find_range_collect, &matches);
 
 	return g_slist_reverse(matches);
 }
 
 
-/* Clears markers if text is null/empty.
- * @return Number of matches marked. */
-gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
+/* Records a buffer modification so the next search_mark_all() call for the same
+ * query can re-mark just the edited region instead of the whole document.
+ * Called from the SCN_MODIFIED handler in editor.c. */
+void search_mark_all_modified(GeanyDocument *doc, gint pos, gint len, gboolean insert)
 {
-	gint count = 0;
-	struct Sci_TextToFind ttf;
-	GSList *match, *matches;
+	GeanyDocumentPrivate *priv = doc->priv;
+	gint delta = insert ? len : -len;
+	gint end = insert ? pos + len : pos;
 
-	g_return_val_if_fail(DOC_VALID(doc), 0);
+	if (priv->mark_all_text == NULL)
+		return;
 
-	/* clear previous search indicators */
-	editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
+	if (priv->mark_all_dmin < 0)
+	{
+		priv->mark_all_dmin = pos;
+		priv->mark_all_dmax = end;
+		return;
+	}
+	/* keep the recorded range aligned with the shifting text */
+	if (priv->mark_all_dmin > pos)
+		priv->mark_all_dmin = MAX(pos, priv->mark_all_dmin + delta);
+	if (priv->mark_all_dmax > pos)
+		priv->mark_all_dmax = MAX(pos, priv->mark_all_dmax + delta);
 
-	if (G_UNLIKELY(EMPTY(search_text)))
-		return 0;
+	priv->mark_all_dmin = MIN(priv->mark_all_dmin, pos);
+	priv->mark_all_dmax = MAX(priv->mark_all_dmax, end);
+}
 
-	ttf.chrg.cpMin = 0;
-	ttf.chrg.cpMax = sci_get_length(doc->editor->sci);
+
+/* Marks all matches in the given range and returns their count */
+static gint mark_all_in_range(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags,
+		gint start, gint end)
+{
+	gint count = 0;
+	struct Sci_TextToFind ttf;
+	GSList *match, *matches;
+
+	ttf.chrg.cpMin = start;
+	ttf.chrg.cpMax = end;
 	ttf.lpstrText = (gchar *)search_text;
 
 	matches = find_range(doc->editor->sci, flags, &ttf);
@@ -1261,6 +1676,88 @@ gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlag
 }
 
 
+/* Clears markers if text is null/empty.
+ * @return Number of matches marked. */
+gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
+{
+	GeanyDocumentPrivate *priv;
+	ScintillaObject *sci;
+	gint count;
+
+	g_return_val_if_fail(DOC_VALID(doc), 0);
+
+	priv = doc->priv;
+	sci = doc->editor->sci;
+
+	if (G_UNLIKELY(EMPTY(search_text)))
+	{
+		editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
+		SETPTR(priv->mark_all_text, NULL);
+		priv->mark_all_count = 0;
+		priv->mark_all_dmin = -1;
+		return 0;
+	}
+
+	if (priv->mark_all_text != NULL && utils_str_equal(priv->mark_all_text, search_text) &&
+		priv->mark_all_flags == (gint) flags)
+	{
+		/* unchanged query on an unchanged buffer: everything is still marked */
+		if (priv->mark_all_dmin < 0)
+			return priv->mark_all_count;
+
+		/* for verbatim queries matches cannot span further than the pattern length
+		 * beyond the damaged range, so only that window needs re-marking */
+		if (! (flags & GEANY_FIND_REGEXP))
+		{
+			gint pat_len = (gint) strlen(search_text);
+			gint start = MAX(0, priv->mark_all_dmin - pat_len);
+			gint end = MIN(sci_get_length(sci), priv->mark_all_dmax + pat_len);
+
+			/* widen to whole indicator runs so partially covered matches are
+			 * removed entirely, then count the matches we are about to drop
+			 * (matches never overlap, so each occupies pat_len bytes of a run) */
+			count = priv->mark_all_count;
+			if (scintilla_send_message(sci, SCI_INDICATORVALUEAT, GEANY_INDICATOR_SEARCH, start))
+				start = (gint) scintilla_send_message(sci, SCI_INDICATORSTART, GEANY_INDICATOR_SEARCH, start);
+			if (end > 0 && scintilla_send_message(sci, SCI_INDICATORVALUEAT, GEANY_INDICATOR_SEARCH, end - 1))
+				end = (gint) scintilla_send_message(sci, SCI_INDICATOREND, GEANY_INDICATOR_SEARCH, end - 1);
+			{
+				gint pos = start;
+
+				while (pos < end)
+				{
+					gint run_end = (gint) scintilla_send_message(sci, SCI_INDICATOREND, GEANY_INDICATOR_SEARCH, pos);
+
+					if (run_end <= pos)
+						break;
+					if (scintilla_send_message(sci, SCI_INDICATORVALUEAT, GEANY_INDICATOR_SEARCH, pos))
+						count -= (MIN(run_end, end) - pos) / pat_len;
+					pos = run_end;
+				}
+			}
+
+			sci_indicator_set(sci, GEANY_INDICATOR_SEARCH);
+			sci_indicator_clear(sci, start, end - start);
+			count += mark_all_in_range(doc, search_text, flags, start, end);
+			priv->mark_all_count = count;
+			priv->mark_all_dmin = -1;
+			return count;
+		}
+	}
+
+	/* different query or a regex: full pass over the document */
+	editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
+	count = mark_all_in_range(doc, search_text, flags, 0, sci_get_length(sci));
+
+	SETPTR(priv->mark_all_text, g_strdup(search_text));
+	priv->mark_all_flags = (gint) flags;
+	priv->mark_all_count = count;
+	priv->mark_all_dmin = -1;
+
+	return count;
+}
+
+
 static void
 on_find_entry_activate(GtkEntry *entry, gpointer user_data)
 {
@@ -1339,7 +1836,7 @@ on_find_dialog_response(GtkDialog *dialog, gint response, gpointer user_data)
 			if (! utils_str_replace_escape(search_data.text, FALSE))
 				goto fail;
 		}
-		ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(user_data), search_data.original_text, 0);
+		search_history_add(SEARCH_HISTORY_FIND, search_data.original_text);
 
 		switch (response)
 		{
@@ -1396,25 +1893,91 @@ on_replace_entry_activate(GtkEntry *entry, gpointer user_data)
 }
 
 
+/* counts the matches in one document without modifying it, using the same
+ * matcher document_replace_all() uses so the counts are exact */
+static guint count_document_matches(GeanyDocument *doc, const gchar *search_text,
+		GeanyFindFlags flags)
+{
+	struct Sci_TextToFind ttf;
+	GSList *match, *matches;
+	guint count = 0;
+
+	g_return_val_if_fail(DOC_VALID(doc), 0);
+
+	ttf.chrg.cpMin = 0;
+	ttf.chrg.cpMax = sci_get_length(doc->editor->sci);
+	ttf.lpstrText = (gchar *) search_text;
+
+	matches = find_range(doc->editor->sci, flags, &ttf);
+	foreach_slist (match, matches)
+	{
+		geany_match_info_free(match->data);
+		count++;
+	}
+	g_slist_free(matches);
+	return count;
+}
+
+
 static void replace_in_session(GeanyDocument *doc,
 		GeanyFindFlags search_flags_re, gboolean search_replace_escape_re,
 		const gchar *find, const gchar *replace,
 		const gchar *original_find, const gchar *original_replace)
 {
-	guint n, page_count, rep_count = 0, file_count = 0;
+	guint n, page_count, rep_count = 0, file_count = 0, match_count = 0, hit_files = 0;
+	GArray *counts;
 
-	/* replace in all documents following notebook tab order */
+	/* counting pass first: report the per-document match counts and ask for
+	 * confirmation before any buffer is touched, then run the actual
+	 * replacement only in the documents that have matches */
 	page_count = gtk_notebook_get_n_pages(GTK_NOTEBOOK(main_widgets.notebook));
+	counts = g_array_sized_new(FALSE, TRUE, sizeof(guint), page_count);
 	for (n = 0; n < page_count; n++)
 	{
 		GeanyDocument *tmp_doc = document_get_from_page(n);
-		gint reps = 0;
+		guint count = count_document_matches(tmp_doc, find, search_flags_re);
 
-		reps = document_replace_all(tmp_doc, find, replace, original_find, original_replace, search_flags_re);
-		rep_count += reps;
-		if (reps)
-			file_count++;
-	}
+		g_array_append_val(counts, count);
+		match_count += count;
+		if (count > 0)
+		{
+			hit_files++;
+			msgwin_status_add(_("%s: %u matches for \"%s\"."),
+				DOC_FILENAME(tmp_doc), count, original_find);
+		}
+	}
+	if (hit_files == 0)
+	{
+		utils_beep();
+		ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), original_find);
+		g_array_free(counts, TRUE);
+		return;
+	}
+	/* show the per-file counts listed above and offer to cancel */
+	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_STATUS);
+	if (! dialogs_show_question(
+			_("Replace %u matches of \"%s\" in %u of %u open documents?"),
+			match_count, original_find, hit_files, page_count))
+	{
+		g_array_free(counts, TRUE);
+		return;
+	}
+
+	/* replace in the matching documents following notebook tab order */
+	for (n = 0; n < page_count; n++)
+	{
+		GeanyDocument *tmp_doc;
+		gint reps = 0;
+
+		if (g_array_index(counts, guint, n) == 0)
+			continue;
+		tmp_doc = document_get_from_page(n);
+		reps = document_replace_all(tmp_doc, find, replace, original_find, original_replace, search_flags_re);
+		rep_count += reps;
+		if (reps)
+			file_count++;
+	}
+	g_array_free(counts, TRUE);
 	if (file_count == 0)
 	{
 		utils_beep();
@@ -1485,10 +2048,8 @@ on_replace_dialog_response(GtkDialog *dialog, gint response, gpointer user_data)
 			goto fail;
 	}
 
-	ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(
-		gtk_widget_get_parent(replace_dlg.find_entry)), original_find, 0);
-	ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(
-		gtk_widget_get_parent(replace_dlg.replace_entry)), original_replace, 0);
+	search_history_add(SEARCH_HISTORY_FIND, original_find);
+	search_history_add(SEARCH_HISTORY_REPLACE, original_replace);
 
 	switch (response)
 	{
@@ -1550,6 +2111,699 @@ fail:
 }
 
 
+/* --- native Find in Files engine ---
+ *
+ * Walks the search directory on a dedicated thread, hands candidate files to
+ * a worker-thread pool which memory-maps and scans them, and streams batches
+ * of formatted result lines back to the message window via the main loop.
+ * Used instead of spawning the Grep tool when the user enables the built-in
+ * engine in the dialog; the Grep spawn below remains as the default path. */
+
+typedef struct
+{
+	gchar *dir;				/* root directory, locale encoding */
+	gchar *query;			/* search text, converted to the target encoding */
+	gsize query_len;
+	const gchar *enc;		/* target encoding, NULL for UTF-8 */
+	GRegex *regex;			/* compiled pattern, NULL for literal searches */
+	gboolean case_sensitive;
+	gboolean whole_word;
+	gboolean invert;
+	gboolean recursive;
+	/* Aho-Corasick automaton for the multi-pattern mode, [0] is the root;
+	 * NULL when searching for a single literal or a regex */
+	GPtrArray *ac_nodes;
+	GSList *patterns;		/* GPatternSpec list built from the Files field */
+	/* GPatternSpec list from the project's ignore patterns; matching path
+	 * components are pruned before any I/O on them */
+	GSList *ignore_patterns;
+	/* file paths relative to dir from the project file manifest; when non-NULL
+	 * they are scanned instead of walking the directory tree */
+	GPtrArray *manifest_files;
+	GThreadPool *pool;
+	volatile gint cancelled;
+	/* participant count: 1 for the producer (walker thread or the main-thread
+	 * queueing loop) plus 1 per queued but not yet scanned file; the thread
+	 * dropping the last participant schedules the freeing finish callback */
+	volatile gint outstanding;
+	volatile gint match_count;
+}
+FifSearch;
+
+/* the currently running native search, if any; owned by the main thread */
+static FifSearch *fif_current = NULL;
+
+/* Aho-Corasick automaton used by the multi-pattern mode. It is compiled once
+ * per query from the space-separated patterns and shared read-only by all
+ * worker threads; the goto function is completed into a DFA so scanning costs
+ * one table lookup per byte no matter how many patterns are searched. */
+typedef struct FifAcNode
+{
+	struct FifAcNode	*next[256];	/* goto function, completed into a DFA */
+	struct FifAcNode	*fail;
+	GSList				*out;		/* lengths of the patterns ending here */
+}
+FifAcNode;
+
+static FifAcNode *fif_ac_add_node(GPtrArray *nodes)
+{
+	FifAcNode *node = g_new0(FifAcNode, 1);
+
+	g_ptr_array_add(nodes, node);
+	return node;
+}
+
+
+static GPtrArray *fif_ac_build(gchar **patterns, gboolean case_sensitive)
+{
+	GPtrArray *nodes = g_ptr_array_new();
+	FifAcNode *root = fif_ac_add_node(nodes);
+	GQueue queue = G_QUEUE_INIT;
+	gchar **pattern;
+	guint c;
+
+	foreach_strv(pattern, patterns)
+	{
+		FifAcNode *node = root;
+		const gchar *p;
+
+		if (EMPTY(*pattern))
+			continue;
+		for (p = *pattern; *p != '\0'; p++)
+		{
+			c = (guchar) (case_sensitive ? *p : g_ascii_tolower(*p));
+			if (node->next[c] == NULL)
+				node->next[c] = fif_ac_add_node(nodes);
+			node = node->next[c];
+		}
+		node->out = g_slist_prepend(node->out, GSIZE_TO_POINTER(strlen(*pattern)));
+	}
+	/* breadth-first pass computing the failure links; missing transitions are
+	 * filled in from the failure target, which turns the trie into a DFA */
+	for (c = 0; c < 256; c++)
+	{
+		if (root->next[c] != NULL)
+		{
+			root->next[c]->fail = root;
+			g_queue_push_tail(&queue, root->next[c]);
+		}
+		else
+			root->next[c] = root;
+	}
+	while (! g_queue_is_empty(&queue))
+	{
+		FifAcNode *node = g_queue_pop_head(&queue);
+
+		/* whatever matches at the failure target also matches here */
+		node->out = g_slist_concat(node->out, g_slist_copy(node->fail->out));
+		for (c = 0; c < 256; c++)
+		{
+			if (node->next[c] != NULL)
+			{
+				node->next[c]->fail = node->fail->next[c];
+				g_queue_push_tail(&queue, node->next[c]);
+			}
+			else
+				node->next[c] = node->fail->next[c];
+		}
+	}
+	return nodes;
+}
+
+
+static void fif_ac_free(GPtrArray *nodes)
+{
+	FifAcNode *node;
+	guint i;
+
+	foreach_ptr_array(node, i, nodes)
+	{
+		g_slist_free(node->out);
+		g_free(node);
+	}
+	g_ptr_array_free(nodes, TRUE);
+}
+
+
+static void fif_search_free(FifSearch *fif)
+{
+	GSList *item;
+
+	g_thread_pool_free(fif->pool, FALSE, TRUE);
+	if (fif->ac_nodes != NULL)
+		fif_ac_free(fif->ac_nodes);
+	foreach_slist(item, fif->patterns)
+		g_pattern_spec_free(item->data);
+	g_slist_free(fif->patterns);
+	foreach_slist(item, fif->ignore_patterns)
+		g_pattern_spec_free(item->data);
+	g_slist_free(fif->ignore_patterns);
+	if (fif->manifest_files != NULL)
+	{
+		g_ptr_array_foreach(fif->manifest_files, (GFunc) g_free, NULL);
+		g_ptr_array_free(fif->manifest_files, TRUE);
+	}
+	if (fif->regex)
+		g_regex_unref(fif->regex);
+	g_free(fif->query);
+	g_free(fif->dir);
+	g_free(fif);
+}
+
+
+static gboolean fif_deliver_finish(gpointer data)
+{
+	FifSearch *fif = data;
+
+	if (! g_atomic_int_get(&fif->cancelled))
+	{
+		gint count = g_atomic_int_get(&fif->match_count);
+
+		if (count > 0)
+		{
+			gchar *text = ngettext(
+						"Search completed with %d match.",
+						"Search completed with %d matches.", count);
+
+			msgwin_msg_add(COLOR_BLUE, -1, NULL, text, count);
+			ui_set_statusbar(FALSE, text, count);
+		}
+		else
+		{
+			msgwin_msg_add_string(COLOR_BLUE, -1, NULL, _("No matches found."));
+			ui_set_statusbar(FALSE, "%s", _("No matches found."));
+		}
+		utils_beep();
+		ui_progress_bar_stop();
+	}
+	if (fif == fif_current)
+		fif_current = NULL;
+	fif_search_free(fif);
+	return FALSE;
+}
+
+
+typedef struct
+{
+	FifSearch *fif;
+	GPtrArray *lines;
+}
+FifBatch;
+
+static gboolean fif_deliver_batch(gpointer data)
+{
+	FifBatch *batch = data;
+	gchar *msg;
+	guint i;
+
+	/* adding to the GtkListStore must happen on the main thread; one idle
+	 * callback per scanned file keeps the loop responsive. Idle callbacks run
+	 * in queue order, so all batches are delivered before fif_deliver_finish
+	 * frees the search. */
+	foreach_ptr_array(msg, i, batch->lines)
+	{
+		if (! g_atomic_int_get(&batch->fif->cancelled))
+			msgwin_msg_add_string(COLOR_BLACK, -1, NULL, msg);
+		g_free(msg);
+	}
+	g_ptr_array_free(batch->lines, TRUE);
+	g_free(batch);
+	return FALSE;
+}
+
+
+/* Drops one participant. Only the thread whose decrement reaches zero arms
+ * the freeing finish callback, and by then every other participant has
+ * already returned from its own final access to fif, so no thread can read
+ * the structure once the delivery (and the free) is scheduled. */
+static void fif_unref(FifSearch *fif)
+{
+	if (g_atomic_int_dec_and_test(&fif->outstanding))
+		g_idle_add(fif_deliver_finish, fif);
+}
+
+
+/* case-aware memmem() over a possibly unterminated line */
+static const gchar *fif_find_literal(const gchar *hay, gsize hay_len,
+		const gchar *needle, gsize needle_len, gboolean case_sensitive)
+{
+	const gchar *end;
+
+	if (needle_len == 0 || hay_len < needle_len)
+		return NULL;
+	end = hay + hay_len - needle_len;
+	for (; hay <= end; hay++)
+	{
+		if (case_sensitive ?
+			(*hay == *needle && memcmp(hay, needle, needle_len) == 0) :
+			(g_ascii_tolower(*hay) == g_ascii_tolower(*needle) &&
+				g_ascii_strncasecmp(hay, needle, needle_len) == 0))
+			return hay;
+	}
+	return NULL;
+}
+
+
+static gboolean fif_is_word_char(gchar c)
+{
+	return g_ascii_isalnum(c) || c == '_';
+}
+
+
+/* runs the automaton over one line; a match ending at byte i started at
+ * i + 1 - pattern_length, which is all the word boundary check needs */
+static gboolean fif_ac_match_line(FifSearch *fif, const gchar *line, gsize len)
+{
+	FifAcNode *node = g_ptr_array_index(fif->ac_nodes, 0);
+	gsize i;
+
+	for (i = 0; i < len; i++)
+	{
+		guchar c = line[i];
+		GSList *item;
+
+		if (! fif->case_sensitive)
+			c = g_ascii_tolower(c);
+		node = node->next[c];
+		foreach_slist(item, node->out)
+		{
+			gsize plen = GPOINTER_TO_SIZE(item->data);
+
+			if (! fif->whole_word ||
+				((i + 1 == plen || ! fif_is_word_char(line[i - plen])) &&
+				 (i + 1 == len || ! fif_is_word_char(line[i + 1]))))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+static gboolean fif_match_line(FifSearch *fif, const gchar *line, gsize len)
+{
+	gboolean matched;
+
+	if (fif->ac_nodes != NULL)
+		matched = fif_ac_match_line(fif, line, len);
+	else if (fif->regex)
+	{
+		GMatchInfo *minfo = NULL;
+
+		matched = g_regex_match_full(fif->regex, line, len, 0, 0, &minfo, NULL);
+		if (matched && fif->whole_word)
+		{	/* post-filter on word boundaries like the literal path, which is
+			 * also what grep -w does for regexes */
+			matched = FALSE;
+			while (g_match_info_matches(minfo))
+			{
+				gint start, end;
+
+				if (g_match_info_fetch_pos(minfo, 0, &start, &end) &&
+					(start == 0 || ! fif_is_word_char(line[start - 1])) &&
+					((gsize) end == len || ! fif_is_word_char(line[end])))
+				{
+					matched = TRUE;
+					break;
+				}
+				g_match_info_next(minfo, NULL);
+			}
+		}
+		g_match_info_free(minfo);
+	}
+	else
+	{
+		const gchar *pos = line;
+		gsize left = len;
+
+		matched = FALSE;
+		while ((pos = fif_find_literal(pos, left, fif->query, fif->query_len,
+				fif->case_sensitive)) != NULL)
+		{
+			if (! fif->whole_word ||
+				((pos == line || ! fif_is_word_char(pos[-1])) &&
+				 (pos + fif->query_len == line + len ||
+					! fif_is_word_char(pos[fif->query_len]))))
+			{
+				matched = TRUE;
+				break;
+			}
+			pos++;
+			left = len - (pos - line);
+		}
+	}
+	return fif->invert ? ! matched : matched;
+}
+
+
+/* grep-like binary detection: a NUL byte early in the file */
+static gboolean fif_is_binary(const gchar *contents, gsize len)
+{
+	return memchr(contents, '\0', MIN(len, 4096)) != NULL;
+}
+
+
+static void fif_add_match(FifSearch *fif, GPtrArray *results, const gchar *rel_path,
+		guint line_nr, const gchar *line, gsize len)
+{
+	gchar *text = g_strndup(line, len);
+	gchar *utf8_text = NULL;
+	gchar *msg;
+
+	g_strstrip(text);
+	/* enc is NULL when encoding is set to UTF-8, so we can skip any conversion */
+	if (fif->enc != NULL && ! g_utf8_validate(text, -1, NULL))
+		utf8_text = g_convert(text, -1, "UTF-8", fif->enc, NULL, NULL, NULL);
+
+	msg = g_strdup_printf("%s:%u: %s", rel_path, line_nr, utf8_text ? utf8_text : text);
+	g_ptr_array_add(results, msg);
+	g_atomic_int_inc(&fif->match_count);
+	g_free(utf8_text);
+	g_free(text);
+}
+
+
+/* the match kernel shared by both scopes: runs the line loop over one buffer
+ * and queues any matches for main-loop delivery, labelled with display_path */
+static void fif_scan_buffer(FifSearch *fif, const gchar *display_path,
+		const gchar *contents, gsize len)
+{
+	GPtrArray *results;
+	const gchar *line = contents;
+	const gchar *end = contents + len;
+	guint line_nr = 1;
+
+	if (len == 0 || fif_is_binary(contents, len))
+		return;
+
+	results = g_ptr_array_new();
+	while (line < end)
+	{
+		const gchar *eol = memchr(line, '\n', end - line);
+		gsize line_len = (eol != NULL) ? (gsize) (eol - line) : (gsize) (end - line);
+
+		if (fif_match_line(fif, line, line_len))
+			fif_add_match(fif, results, display_path, line_nr, line, line_len);
+		if (eol == NULL)
+			break;
+		line = eol + 1;
+		line_nr++;
+	}
+	if (results->len > 0)
+	{
+		FifBatch *batch = g_new(FifBatch, 1);
+
+		batch->fif = fif;
+		batch->lines = results;
+		g_idle_add(fif_deliver_batch, batch);
+	}
+	else
+		g_ptr_array_free(results, TRUE);
+}
+
+
+/* worker-pool entry point: scan one file, rel_path is owned by us */
+static void fif_scan_file(gpointer data, gpointer user_data)
+{
+	gchar *rel_path = data;
+	FifSearch *fif = user_data;
+
+	if (! g_atomic_int_get(&fif->cancelled))
+	{
+		gchar *path = g_build_filename(fif->dir, rel_path, NULL);
+		GMappedFile *mf = g_mapped_file_new(path, FALSE, NULL);
+
+		if (mf != NULL)
+		{
+			fif_scan_buffer(fif, rel_path, g_mapped_file_get_contents(mf),
+				g_mapped_file_get_length(mf));
+			g_mapped_file_free(mf);
+		}
+		g_free(path);
+	}
+	g_free(rel_path);
+	fif_unref(fif);
+}
+
+
+/* one open document's buffer for the open-documents scope; the copy is taken
+ * on the main thread so workers never touch a live Scintilla buffer */
+typedef struct
+{
+	gchar *name;	/* document file name for the result lines, UTF-8 */
+	gchar *text;
+	gsize len;
+}
+FifDocSnapshot;
+
+
+/* worker-pool entry point for the open-documents scope */
+static void fif_scan_snapshot(gpointer data, gpointer user_data)
+{
+	FifDocSnapshot *snap = data;
+	FifSearch *fif = user_data;
+
+	if (! g_atomic_int_get(&fif->cancelled))
+		fif_scan_buffer(fif, snap->name, snap->text, snap->len);
+	g_free(snap->name);
+	g_free(snap->text);
+	g_free(snap);
+	fif_unref(fif);
+}
+
+
+static gboolean fif_walk_cb(const gchar *dir, const gchar *name,
+	UtilsFSType type, guint64 size, guint64 mtime, gpointer user_data)
+{
+	FifSearch *fif = user_data;
+
+	/* prune ignored names (VCS and build directories) before any I/O on them */
+	if (fif->ignore_patterns != NULL && pattern_list_match(fif->ignore_patterns, name))
+		return FALSE;
+
+	if (type == UTILS_FS_DIR)
+		return fif->recursive;
+
+	if (fif->patterns == NULL || pattern_list_match(fif->patterns, name))
+	{
+		/* queue the path relative to the search root, as the manifest path does */
+		const gchar *rel = dir + strlen(fif->dir);
+		gchar *rel_path;
+
+		while (*rel == G_DIR_SEPARATOR)
+			rel++;
+		rel_path = EMPTY(rel) ? g_strdup(name) : g_build_filename(rel, name, NULL);
+		g_atomic_int_inc(&fif->outstanding);
+		g_thread_pool_push(fif->pool, rel_path, NULL);
+	}
+	return TRUE;
+}
+
+
+static gpointer fif_walk_thread(gpointer data)
+{
+	FifSearch *fif = data;
+
+	if (fif->manifest_files != NULL)
+	{
+		guint i;
+
+		for (i = 0; ! g_atomic_int_get(&fif->cancelled) && i < fif->manifest_files->len; i++)
+		{
+			const gchar *rel_path = g_ptr_array_index(fif->manifest_files, i);
+			const gchar *name = strrchr(rel_path, G_DIR_SEPARATOR);
+
+			name = (name != NULL) ? name + 1 : rel_path;
+			if (fif->patterns == NULL || pattern_list_match(fif->patterns, name))
+			{
+				g_atomic_int_inc(&fif->outstanding);
+				g_thread_pool_push(fif->pool, g_strdup(rel_path), NULL);
+			}
+		}
+	}
+	else
+		utils_fs_walk(fif->dir, FALSE, fif_walk_cb, fif, &fif->cancelled);
+	/* drop the producer's own participant reference */
+	fif_unref(fif);
+	return NULL;
+}
+
+
+static gint fif_get_worker_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	gint count = (gint) sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (count > 0)
+		return count;
+#endif
+	return 2;
+}
+
+
+static GSList *fif_get_file_patterns(void)
+{
+	GSList *patterns = NULL;
+	gchar **pats, **pat;
+
+	g_strstrip(settings.fif_files);
+	if (settings.fif_files_mode == FILES_MODE_ALL || EMPTY(settings.fif_files))
+		return NULL;
+
+	pats = g_strsplit(settings.fif_files, " ", -1);
+	foreach_strv(pat, pats)
+	{
+		if (! EMPTY(*pat))
+			patterns = g_slist_prepend(patterns, g_pattern_spec_new(*pat));
+	}
+	g_strfreev(pats);
+	return patterns;
+}
+
+
+static GSList *fif_get_ignore_patterns(void)
+{
+	GSList *patterns = NULL;
+	gchar **pat;
+
+	if (app->project == NULL || app->project->ignore_patterns == NULL)
+		return NULL;
+
+	foreach_strv(pat, app->project->ignore_patterns)
+	{
+		if (! EMPTY(*pat))
+			patterns = g_slist_prepend(patterns, g_pattern_spec_new(*pat));
+	}
+	return patterns;
+}
+
+
+static gboolean
+search_find_in_files_native(const gchar *utf8_search_text, const gchar *dir, const gchar *enc)
+{
+	FifSearch *fif;
+	gchar *search_text = NULL;
+	gchar *utf8_dir, *str;
+	gssize utf8_text_len;
+
+	if (EMPTY(utf8_search_text) || ! dir)
+		return TRUE;
+
+	/* supersede a still running search */
+	if (fif_current != NULL)
+		g_atomic_int_set(&fif_current->cancelled, TRUE);
+
+	fif = g_new0(FifSearch, 1);
+	/* the producer's own participant reference, dropped when queueing ends */
+	fif->outstanding = 1;
+
+	if (settings.fif_regexp)
+	{
+		gint rflags = G_REGEX_RAW;
+		GError *error = NULL;
+
+		if (! settings.fif_case_sensitive)
+			rflags |= G_REGEX_CASELESS;
+		fif->regex = g_regex_new(utf8_search_text, rflags, 0, &error);
+		if (fif->regex == NULL)
+		{
+			ui_set_statusbar(FALSE, _("Bad regex: %s"), error->message);
+			g_error_free(error);
+			g_free(fif);
+			return FALSE;
+		}
+	}
+
+	/* the open-documents scope searches Scintilla buffers, which are always
+	 * UTF-8 internally, so no encoding conversion applies there */
+	if (settings.fif_open_docs)
+		enc = NULL;
+
+	/* convert the search text in the preferred encoding (if the text is not valid UTF-8. assume
+	 * it is already in the preferred encoding) */
+	utf8_text_len = strlen(utf8_search_text);
+	if (enc != NULL && g_utf8_validate(utf8_search_text, utf8_text_len, NULL))
+		search_text = g_convert(utf8_search_text, utf8_text_len, enc, "UTF-8", NULL, NULL, NULL);
+	if (search_text == NULL)
+		search_text = g_strdup(utf8_search_text);
+
+	fif->dir = g_strdup(dir);
+	fif->query = search_text;
+	fif->query_len = strlen(search_text);
+	if (settings.fif_multi_pattern && ! settings.fif_regexp)
+	{
+		/* each space-separated token becomes one pattern of the automaton;
+		 * with regexes enabled, alternation already covers this */
+		gchar **tokens = g_strsplit(search_text, " ", -1);
+
+		fif->ac_nodes = fif_ac_build(tokens, settings.fif_case_sensitive);
+		g_strfreev(tokens);
+	}
+	fif->enc = enc;	/* global const string, outlives the search */
+	fif->case_sensitive = settings.fif_case_sensitive;
+	fif->whole_word = settings.fif_match_whole_word;
+	fif->invert = settings.fif_invert_results;
+	fif->recursive = settings.fif_recursive;
+
+	if (settings.fif_open_docs)
+	{	/* open-documents scope: snapshot every buffer on the main thread and
+		 * fan the snapshots out over the pool; no walking, no disk I/O, and
+		 * unsaved changes are searched */
+		guint i;
+
+		fif->pool = g_thread_pool_new(fif_scan_snapshot, fif, fif_get_worker_count(), FALSE, NULL);
+		fif_current = fif;
+
+		gtk_list_store_clear(msgwindow.store_msg);
+		gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
+		ui_progress_bar_start(_("Searching..."));
+
+		str = g_strdup_printf(_("Searching for \"%s\" (in open documents)"),
+			utf8_search_text);
+		msgwin_msg_add_string(COLOR_BLUE, -1, NULL, str);
+		g_free(str);
+
+		foreach_document(i)
+		{
+			GeanyDocument *doc = documents[i];
+			FifDocSnapshot *snap = g_new0(FifDocSnapshot, 1);
+
+			snap->name = g_strdup(DOC_FILENAME(doc));
+			snap->text = sci_get_contents(doc->editor->sci, -1);
+			snap->len = (gsize) sci_get_length(doc->editor->sci);
+			g_atomic_int_inc(&fif->outstanding);
+			g_thread_pool_push(fif->pool, snap, NULL);
+		}
+		/* drop the producer's own participant reference */
+		fif_unref(fif);
+		return TRUE;
+	}
+
+	fif->patterns = fif_get_file_patterns();
+	fif->ignore_patterns = fif_get_ignore_patterns();
+	/* for recursive searches, the project file manifest replaces re-enumerating
+	 * the tree from disk; the ignore patterns were already applied when it was
+	 * built */
+	if (fif->recursive)
+		fif->manifest_files = project_get_file_list(fif->dir);
+	fif->pool = g_thread_pool_new(fif_scan_file, fif, fif_get_worker_count(), FALSE, NULL);
+	fif_current = fif;
+
+	gtk_list_store_clear(msgwindow.store_msg);
+	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
+	msgwin_set_messages_dir(dir);
+	ui_progress_bar_start(_("Searching..."));
+
+	utf8_dir = utils_get_utf8_from_locale(dir);
+	str = g_strdup_printf(_("Searching for \"%s\" (in directory: %s)"),
+		utf8_search_text, utf8_dir);
+	msgwin_msg_add_string(COLOR_BLUE, -1, NULL, str);
+	utils_free_pointers(2, str, utf8_dir, NULL);
+
+	g_thread_create(fif_walk_thread, fif, FALSE, NULL);
+	return TRUE;
+}
+
+
 static GString *get_grep_options(void)
 {
 	GString *gstr = g_string_new("-nHI");	/* line numbers, filenames, ignore binaries */
@@ -1614,7 +2868,8 @@ on_find_in_files_dialog_response(GtkDialog *dialog, gint response,
 		GeanyEncodingIndex enc_idx =
 			ui_encodings_combo_box_get_active_encoding(GTK_COMBO_BOX(fif_dlg.encoding_combo));
 
-		if (G_UNLIKELY(EMPTY(utf8_dir)))
+		if (G_UNLIKELY(EMPTY(utf8_dir)) &&
+			! (settings.fif_native_engine && settings.fif_open_docs))
 			ui_set_statusbar(FALSE, _("Invalid directory for find in files."));
 		else if (!EMPTY(search_text))
 		{
@@ -1622,14 +2877,20 @@ on_find_in_files_dialog_response(GtkDialog *dialog, gint response,
 			GString *opts = get_grep_options();
 			const gchar *enc = (enc_idx == GEANY_ENCODING_UTF_8) ? NULL :
 				encodings_get_charset_from_index(enc_idx);
+			gboolean ret;
 
 			locale_dir = utils_get_locale_from_utf8(utf8_dir);
 
-			if (search_find_in_files(search_text, locale_dir, opts->str, enc))
+			if (settings.fif_native_engine)
+				ret = search_find_in_files_native(search_text, locale_dir, enc);
+			else
+				ret = search_find_in_files(search_text, locale_dir, opts->str, enc);
+			if (ret)
 			{
-				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(search_combo), search_text, 0);
-				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(fif_dlg.files_combo), NULL, 0);
-				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(dir_combo), utf8_dir, 0);
+				search_history_add(SEARCH_HISTORY_FIND, search_text);
+				search_history_add(SEARCH_HISTORY_FILES, gtk_entry_get_text(GTK_ENTRY(
+					gtk_bin_get_child(GTK_BIN(fif_dlg.files_combo)))));
+				search_history_add(SEARCH_HISTORY_DIR, utf8_dir);
 				gtk_widget_hide(fif_dlg.dialog);
 			}
 			g_free(locale_dir);
@@ -1686,6 +2947,10 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *dir, const gcha
 	if (search_text == NULL)
 		search_text = g_strdup(utf8_search_text);
 
+	/* Grep treats each line of the pattern argument as a separate pattern */
+	if (settings.fif_multi_pattern && ! settings.fif_regexp)
+		g_strdelimit(search_text, " ", '\n');
+
 	/* set grep command and options */
 	argv_prefix = g_new0(gchar*, 1 + opts_argv_len + 3 + 1);	/* last +1 for recursive arg */
 
@@ -1841,6 +3106,11 @@ static gboolean read_fif_io(GIOChannel *source, GIOCondition condition, gchar *e
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
 		gchar *msg, *utf8_msg;
+		GTimeVal start;
+
+		/* each dispatch drains the pipe and blocks the main loop meanwhile,
+		 * so its duration is worth a timer (and a slice on the trace timeline) */
+		g_get_current_time(&start);
 
 		while (g_io_channel_read_line(source, &msg, NULL, NULL, NULL) && msg)
 		{
@@ -1861,11 +3131,13 @@ static gboolean read_fif_io(GIOChannel *source, GIOCondition condition, gchar *e
 				utf8_msg = msg;
 
 			msgwin_msg_add_string(msg_color, -1, NULL, utf8_msg);
+			stats_count("search.fif-lines", 1);
 
 			if (utf8_msg != msg)
 				g_free(utf8_msg);
 			g_free(msg);
 		}
+		stats_time_since("search.fif-io", &start);
 	}
 	if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL))
 		return FALSE;
@@ -1936,7 +3208,8 @@ static GRegex *compile_regex(const gchar *str, GeanyFindFlags sflags)
 {
 	GRegex *regex;
 	GError *error = NULL;
-	gint rflags = 0;
+	/* OPTIMIZE studies the pattern, which pays off when it is matched repeatedly */
+	gint rflags = G_REGEX_OPTIMIZE;
 
 	if (sflags & GEANY_FIND_MULTILINE)
 		rflags |= G_REGEX_MULTILINE;
@@ -1983,7 +3256,7 @@ static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean
 	if (multiline)
 	{
 		/* Warning: any SCI calls will invalidate 'text' after calling SCI_GETCHARACTERPOINTER */
-		text = (void*)scintilla_send_message(sci, SCI_GETCHARACTERPOINTER, 0, 0);
+		text = sci_get_character_pointer(sci);
 		g_regex_match_full(regex, text, -1, pos, 0, &minfo, NULL);
 	}
 	else /* single-line mode, manually match against each line */
@@ -1995,7 +3268,7 @@ static gint find_regex(ScintillaObject *sci, guint pos, GRegex *regex, gboolean
 			gint start = sci_get_position_from_line(sci, line);
 			gint end = sci_get_line_end_position(sci, line);
 
-			text = (void*)scintilla_send_message(sci, SCI_GETRANGEPOINTER, start, end - start);
+			text = sci_get_range_pointer(sci, start, end - start);
 			if (g_regex_match_full(regex, text, end - start, pos - start, 0, &minfo, NULL))
 			{
 				offset = start;
@@ -2101,17 +3374,16 @@ gint search_find_next(ScintillaObject *sci, const gchar *str, GeanyFindFlags fla
 }
 
 
-gint search_replace_match(ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text)
+/* expands backreference escapes in replace_text against match, returning a
+ * newly allocated string (or NULL for non-regex matches, where replace_text
+ * is used verbatim) */
+static gchar *expand_replace_text(const GeanyMatchInfo *match, const gchar *replace_text)
 {
 	GString *str;
-	gint ret = 0;
 	gint i = 0;
 
-	sci_set_target_start(sci, match->start);
-	sci_set_target_end(sci, match->end);
-
 	if (! (match->flags & GEANY_FIND_REGEXP))
-		return sci_replace_target(sci, replace_text, FALSE);
+		return NULL;
 
 	str = g_string_new(replace_text);
 	while (str->str[i])
@@ -2141,8 +3413,21 @@ gint search_replace_match(ScintillaObject *sci, const GeanyMatchInfo *match, con
 		i += strlen(grp);
 		g_free(grp);
 	}
-	ret = sci_replace_target(sci, str->str, FALSE);
-	g_string_free(str, TRUE);
+	return g_string_free(str, FALSE);
+}
+
+
+gint search_replace_match(ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text)
+{
+	gchar *expanded;
+	gint ret;
+
+	sci_set_target_start(sci, match->start);
+	sci_set_target_end(sci, match->end);
+
+	expanded = expand_replace_text(match, replace_text);
+	ret = sci_replace_target(sci, FALLBACK(expanded, replace_text), FALSE);
+	g_free(expanded);
 	return ret;
 }
 
@@ -2186,43 +3471,56 @@ gint search_find_text(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_Tex
 }
 
 
+typedef struct
+{
+	GeanyDocument *doc;
+	gchar *short_file_name;
+	gint prev_line;
+	gint count;
+} DocumentUsage;
+
+/* streams matches to the Messages window as they are found, so only the current
+ * line copy is ever held in memory instead of the whole match list.
+ * note: sci_get_line() copies out of the buffer without moving the gap, so it is
+ * safe to call from a find_range_foreach() callback. */
+static gboolean find_document_usage_cb(ScintillaObject *sci, GeanyMatchInfo *info, gpointer user_data)
+{
+	DocumentUsage *usage = user_data;
+	gint line = sci_get_line_from_position(sci, info->start);
+
+	if (line != usage->prev_line)
+	{
+		gchar *buffer = sci_get_line(sci, line);
+
+		msgwin_msg_add(COLOR_BLACK, line + 1, usage->doc,
+			"%s:%d: %s", usage->short_file_name, line + 1, g_strstrip(buffer));
+		g_free(buffer);
+		usage->prev_line = line;
+	}
+	usage->count++;
+
+	geany_match_info_free(info);
+	return TRUE;
+}
+
+
 static gint find_document_usage(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
 {
-	gchar *buffer, *short_file_name;
 	struct Sci_TextToFind ttf;
-	gint count = 0;
-	gint prev_line = -1;
-	GSList *match, *matches;
+	DocumentUsage usage = { doc, NULL, -1, 0 };
 
 	g_return_val_if_fail(DOC_VALID(doc), 0);
 
-	short_file_name = g_path_get_basename(DOC_FILENAME(doc));
+	usage.short_file_name = g_path_get_basename(DOC_FILENAME(doc));
 
 	ttf.chrg.cpMin = 0;
 	ttf.chrg.cpMax = sci_get_length(doc->editor->sci);
 	ttf.lpstrText = (gchar *)search_text;
 
-	matches = find_range(doc->editor->sci, flags, &ttf);
-	foreach_slist (match, matches)
-	{
-		GeanyMatchInfo *info = match->data;
-		gint line = sci_get_line_from_position(doc->editor->sci, info->start);
-
-		if (line != prev_line)
-		{
-			buffer = sci_get_line(doc->editor->sci, line);
-			msgwin_msg_add(COLOR_BLACK, line + 1, doc,
-				"%s:%d: %s", short_file_name, line + 1, g_strstrip(buffer));
-			g_free(buffer);
-			prev_line = line;
-		}
-		count++;
+	find_range_foreach(doc->editor->sci, flags, &ttf, find_document_usage_cb, &usage);
 
-		geany_match_info_free(info);
-	}
-	g_slist_free(matches);
-	g_free(short_file_name);
-	return count;
+	g_free(usage.short_file_name);
+	return usage.count;
 }
 
 
@@ -2244,6 +3542,9 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
 	gtk_list_store_clear(msgwindow.store_msg);
 
+	/* batch the result rows so large result sets don't stall the UI while
+	 * they are appended to the messages list */
+	msgwin_msg_batch_begin();
 	if (! in_session)
 	{	/* use current document */
 		count = find_document_usage(doc, search_text, flags);
@@ -2274,6 +3575,7 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
 			count, original_search_text);
 	}
+	msgwin_msg_batch_end();
 }
 
 
@@ -2284,36 +3586,137 @@ guint search_replace_range(ScintillaObject *sci, struct Sci_TextToFind *ttf,
 		GeanyFindFlags flags, const gchar *replace_text)
 {
 	gint count = 0;
-	gint offset = 0; /* difference between search pos and replace pos */
 	GSList *match, *matches;
+	GString *text;
+	gint first_start, last_end;
+	gint last_match_start = 0;
 
 	g_return_val_if_fail(sci != NULL && ttf->lpstrText != NULL && replace_text != NULL, 0);
 	if (! *ttf->lpstrText)
 		return 0;
 
 	matches = find_range(sci, flags, ttf);
+	if (matches == NULL)
+		return 0;
+
+	/* Build the new contents of the span covering all matches in a single pass,
+	 * then swap it in with one target replacement.  This performs one buffer
+	 * edit (with one undo entry, marker/fold adjustment and modification
+	 * notification) no matter how many sites are replaced, instead of one per
+	 * match, which matters enormously for replace-alls with many matches. */
+	first_start = ((GeanyMatchInfo *) matches->data)->start;
+	last_end = first_start;
+	text = g_string_new(NULL);
 	foreach_slist (match, matches)
 	{
 		GeanyMatchInfo *info = match->data;
-		gint replace_len;
+		gchar *expanded;
 
-		info->start += offset;
-		info->end += offset;
+		/* intervening text between the previous match and this one, unchanged */
+		g_string_append_len(text,
+			sci_get_range_pointer(sci, last_end, info->start - last_end),
+			info->start - last_end);
+		/* start of this replacement, in post-replacement coordinates */
+		last_match_start = first_start + (gint) text->len;
 
-		replace_len = search_replace_match(sci, info, replace_text);
-		offset += replace_len - (info->end - info->start);
+		expanded = expand_replace_text(info, replace_text);
+		g_string_append(text, FALLBACK(expanded, replace_text));
+		g_free(expanded);
+
+		last_end = info->end;
 		count ++;
 
-		/* on last match, update the last match/new range end */
-		if (! match->next)
+		geany_match_info_free(info);
+	}
+	g_slist_free(matches);
+
+	sci_set_target_start(sci, first_start);
+	sci_set_target_end(sci, last_end);
+	sci_replace_target(sci, text->str, FALSE);
+
+	/* update the last match position and the new range end, as before */
+	ttf->chrg.cpMin = last_match_start;
+	ttf->chrg.cpMax += (first_start + (gint) text->len) - last_end;
+	g_string_free(text, TRUE);
+
+	return count;
+}
+
+
+/* Like search_replace_range() but over several non-overlapping ranges given in
+ * ascending order, e.g. the per-line spans of a rectangular selection.  All
+ * ranges are matched against the unmodified buffer first, then every
+ * replacement is applied with one target replacement covering the whole span,
+ * so the cost is one buffer edit regardless of the number of ranges.
+ * If not NULL, new_ends[i] receives the end of range i in post-replacement
+ * coordinates, or -1 if nothing was replaced in it.
+ * Note: Normally you would call sci_start/end_undo_action() around this call. */
+guint search_replace_in_ranges(ScintillaObject *sci, GeanyFindFlags flags,
+		const gchar *find_text, const gchar *replace_text,
+		const gint *starts, const gint *ends, guint n_ranges, gint *new_ends)
+{
+	guint count = 0, r;
+	GString *text = NULL;
+	gint first_start = -1, last_end = 0, delta = 0;
+
+	g_return_val_if_fail(sci != NULL && find_text != NULL && replace_text != NULL, 0);
+	if (! *find_text)
+		return 0;
+
+	for (r = 0; r < n_ranges; r++)
+	{
+		struct Sci_TextToFind ttf;
+		GSList *match, *matches;
+		guint range_count = 0;
+
+		ttf.chrg.cpMin = starts[r];
+		ttf.chrg.cpMax = ends[r];
+		ttf.lpstrText = (gchar*)find_text;
+
+		matches = find_range(sci, flags, &ttf);
+		foreach_slist (match, matches)
 		{
-			ttf->chrg.cpMin = info->start;
-			ttf->chrg.cpMax += offset;
+			GeanyMatchInfo *info = match->data;
+			gsize len_before;
+			gchar *expanded;
+
+			if (first_start < 0)
+			{
+				first_start = info->start;
+				last_end = info->start;
+				text = g_string_new(NULL);
+			}
+			/* intervening text between the previous match and this one, unchanged */
+			g_string_append_len(text,
+				sci_get_range_pointer(sci, last_end, info->start - last_end),
+				info->start - last_end);
+
+			len_before = text->len;
+			expanded = expand_replace_text(info, replace_text);
+			g_string_append(text, FALLBACK(expanded, replace_text));
+			g_free(expanded);
+			delta += (gint) (text->len - len_before) - (info->end - info->start);
+
+			last_end = info->end;
+			range_count++;
+
+			geany_match_info_free(info);
 		}
+		g_slist_free(matches);
 
-		geany_match_info_free(info);
+		if (new_ends != NULL)
+			new_ends[r] = range_count > 0 ? ends[r] + delta : -1;
+		count += range_count;
 	}
-	g_slist_free(matches);
+
+	if (count > 0)
+	{
+		sci_set_target_start(sci, first_start);
+		sci_set_target_end(sci, last_end);
+		sci_replace_target(sci, text->str, FALSE);
+	}
+	if (text != NULL)
+		g_string_free(text, TRUE);
 
 	return count;
 }
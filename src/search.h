@@ -132,11 +132,17 @@ void search_find_selection(struct GeanyDocument *doc, gboolean search_backwards)
 
 gint search_mark_all(struct GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags);
 
+void search_mark_all_modified(struct GeanyDocument *doc, gint pos, gint len, gboolean insert);
+
 gint search_replace_match(struct _ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text);
 
 guint search_replace_range(struct _ScintillaObject *sci, struct Sci_TextToFind *ttf,
 		GeanyFindFlags flags, const gchar *replace_text);
 
+guint search_replace_in_ranges(struct _ScintillaObject *sci, GeanyFindFlags flags,
+		const gchar *find_text, const gchar *replace_text,
+		const gint *starts, const gint *ends, guint n_ranges, gint *new_ends);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -104,6 +104,66 @@ static void sidebar_tabs_show_hide(GtkNotebook *notebook, GtkWidget *child,
 								   guint page_num, gpointer data);
 
 
+/* Resolves row icons lazily: tag rows carry no icon of their own but inherit the
+ * child icon stored on their top-level group row, so populating the tree does not
+ * have to look up and set a pixbuf for every tag */
+static void taglist_icon_cell_data_func(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+		GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	GdkPixbuf *icon = NULL;
+	GtkTreeIter child, parent;
+
+	gtk_tree_model_get(model, iter, SYMBOLS_COLUMN_ICON, &icon, -1);
+	if (icon == NULL && gtk_tree_model_iter_parent(model, &parent, iter))
+	{
+		do
+			child = parent;
+		while (gtk_tree_model_iter_parent(model, &parent, &child));
+		gtk_tree_model_get(model, &child, SYMBOLS_COLUMN_CHILD_ICON, &icon, -1);
+	}
+	g_object_set(renderer, "pixbuf", icon, NULL);
+	if (icon != NULL)
+		g_object_unref(icon);
+}
+
+
+/* Computes tag tooltips on demand for the row under the pointer instead of
+ * storing a pre-rendered tooltip string per row at insertion time */
+static gboolean taglist_query_tooltip_cb(GtkWidget *widget, gint x, gint y,
+		gboolean keyboard_mode, GtkTooltip *tooltip, gpointer user_data)
+{
+	GtkTreeView *tree = GTK_TREE_VIEW(widget);
+	GeanyDocument *doc = document_get_current();
+	GtkTreeModel *model;
+	GtkTreePath *path;
+	GtkTreeIter iter;
+	TMTag *tag;
+	gboolean ret = FALSE;
+
+	if (doc == NULL || doc->priv->tag_tree != widget)
+		return FALSE;
+	if (! gtk_tree_view_get_tooltip_context(tree, &x, &y, keyboard_mode, &model, &path, &iter))
+		return FALSE;
+
+	gtk_tree_model_get(model, &iter, SYMBOLS_COLUMN_TAG, &tag, -1);
+	if (tag != NULL)
+	{
+		gchar *text = symbols_get_tag_tooltip(doc, tag);
+
+		if (text != NULL)
+		{
+			gtk_tooltip_set_markup(tooltip, text);
+			gtk_tree_view_set_tooltip_row(tree, tooltip, path);
+			ret = TRUE;
+			g_free(text);
+		}
+		tm_tag_unref(tag);
+	}
+	gtk_tree_path_free(path);
+	return ret;
+}
+
+
 /* the prepare_* functions are document-related, but I think they fit better here than in document.c */
 static void prepare_taglist(GtkWidget *tree, GtkTreeStore *store)
 {
@@ -116,7 +176,8 @@ static void prepare_taglist(GtkWidget *tree, GtkTreeStore *store)
 	column = gtk_tree_view_column_new();
 
 	gtk_tree_view_column_pack_start(column, icon_renderer, FALSE);
-  	gtk_tree_view_column_set_attributes(column, icon_renderer, "pixbuf", SYMBOLS_COLUMN_ICON, NULL);
+  	gtk_tree_view_column_set_cell_data_func(column, icon_renderer,
+  		taglist_icon_cell_data_func, NULL, NULL);
   	g_object_set(icon_renderer, "xalign", 0.0, NULL);
 
   	gtk_tree_view_column_pack_start(column, text_renderer, TRUE);
@@ -141,7 +202,8 @@ static void prepare_taglist(GtkWidget *tree, GtkTreeStore *store)
 	if (! interface_prefs.show_symbol_list_expanders)
 		gtk_tree_view_set_level_indentation(GTK_TREE_VIEW(tree), 10);
 	/* Tooltips */
-	gtk_tree_view_set_tooltip_column(GTK_TREE_VIEW(tree), SYMBOLS_COLUMN_TOOLTIP);
+	gtk_widget_set_has_tooltip(tree, TRUE);
+	g_signal_connect(tree, "query-tooltip", G_CALLBACK(taglist_query_tooltip_cb), NULL);
 
 	/* selection handling */
 	selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(tree));
@@ -219,7 +281,7 @@ void sidebar_update_tag_list(GeanyDocument *doc, gboolean update)
 		if (doc->priv->tag_tree == NULL)
 		{
 			doc->priv->tag_store = gtk_tree_store_new(
-				SYMBOLS_N_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING, TM_TYPE_TAG, G_TYPE_STRING);
+				SYMBOLS_N_COLUMNS, GDK_TYPE_PIXBUF, G_TYPE_STRING, TM_TYPE_TAG, GDK_TYPE_PIXBUF);
 			doc->priv->tag_tree = gtk_tree_view_new();
 			prepare_taglist(doc->priv->tag_tree, doc->priv->tag_store);
 			gtk_widget_show(doc->priv->tag_tree);
@@ -325,28 +387,6 @@ static void prepare_openfiles(void)
 }
 
 
-/* iter should be toplevel */
-static gboolean find_tree_iter_dir(GtkTreeIter *iter, const gchar *dir)
-{
-	GeanyDocument *doc;
-	gchar *name;
-	gboolean result;
-
-	if (utils_str_equal(dir, "."))
-		dir = GEANY_STRING_UNTITLED;
-
-	gtk_tree_model_get(GTK_TREE_MODEL(store_openfiles), iter, DOCUMENTS_DOCUMENT, &doc, -1);
-	g_return_val_if_fail(!doc, FALSE);
-
-	gtk_tree_model_get(GTK_TREE_MODEL(store_openfiles), iter, DOCUMENTS_SHORTNAME, &name, -1);
-
-	result = utils_filenamecmp(name, dir) == 0;
-	g_free(name);
-
-	return result;
-}
-
-
 static gboolean utils_filename_has_prefix(const gchar *str, const gchar *prefix)
 {
 	gchar *head = g_strndup(str, strlen(prefix));
@@ -409,32 +449,129 @@ static gchar *get_doc_folder(const gchar *path)
 }
 
 
+/* Sorted index of the top-level folder rows, so adding a document finds (or
+ * creates) its folder row with a binary search instead of walking every
+ * top-level row and fetching its name from the tree store. The index order is
+ * internal; the displayed order still comes from the tree sortable. Tree store
+ * iters stay valid while their row exists, so caching them here is safe. */
+typedef struct
+{
+	gchar *dirname;		/* display name of the folder row (SHORTNAME column) */
+	GtkTreeIter iter;
+}
+ParentIndexEntry;
+
+static GPtrArray *parent_index = NULL;
+
+/* returns the position of @a dirname in the index, or the position it should
+ * be inserted at when it is not found */
+static guint parent_index_find(const gchar *dirname, gboolean *found)
+{
+	guint low = 0, high = (parent_index != NULL) ? parent_index->len : 0;
+
+	*found = FALSE;
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+		ParentIndexEntry *entry = g_ptr_array_index(parent_index, mid);
+		gint cmp = utils_filenamecmp(dirname, entry->dirname);
+
+		if (cmp == 0)
+		{
+			*found = TRUE;
+			return mid;
+		}
+		if (cmp < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return low;
+}
+
+
+static void parent_index_insert(guint pos, ParentIndexEntry *entry)
+{
+	guint i;
+
+	if (parent_index == NULL)
+		parent_index = g_ptr_array_new();
+	/* open up a slot at pos (no g_ptr_array_insert() in our GLib baseline) */
+	g_ptr_array_add(parent_index, NULL);
+	for (i = parent_index->len - 1; i > pos; i--)
+		parent_index->pdata[i] = parent_index->pdata[i - 1];
+	parent_index->pdata[pos] = entry;
+}
+
+
+/* drops the index entry of a folder row that is about to be removed */
+static void parent_index_remove(GtkTreeIter *parent_iter)
+{
+	gchar *name;
+	gboolean found;
+	guint pos;
+
+	if (parent_index == NULL)
+		return;
+	gtk_tree_model_get(GTK_TREE_MODEL(store_openfiles), parent_iter,
+		DOCUMENTS_SHORTNAME, &name, -1);
+	pos = parent_index_find(name, &found);
+	if (found)
+	{
+		ParentIndexEntry *entry = g_ptr_array_index(parent_index, pos);
+
+		g_free(entry->dirname);
+		g_free(entry);
+		g_ptr_array_remove_index(parent_index, pos);
+	}
+	g_free(name);
+}
+
+
+static void parent_index_clear(void)
+{
+	guint i;
+
+	if (parent_index == NULL)
+		return;
+	for (i = 0; i < parent_index->len; i++)
+	{
+		ParentIndexEntry *entry = g_ptr_array_index(parent_index, i);
+
+		g_free(entry->dirname);
+		g_free(entry);
+	}
+	g_ptr_array_set_size(parent_index, 0);
+}
+
+
 static GtkTreeIter *get_doc_parent(GeanyDocument *doc)
 {
 	gchar *path;
 	gchar *dirname = NULL;
 	static GtkTreeIter parent;
-	GtkTreeModel *model = GTK_TREE_MODEL(store_openfiles);
 	static GIcon *dir_icon = NULL;
+	ParentIndexEntry *entry;
+	gboolean found;
+	guint pos;
 
 	if (!documents_show_paths)
 		return NULL;
 
 	path = g_path_get_dirname(DOC_FILENAME(doc));
 	dirname = get_doc_folder(path);
+	/* the folder row of untitled documents shows the untitled label */
+	if (utils_str_equal(dirname, "."))
+		SETPTR(dirname, g_strdup(GEANY_STRING_UNTITLED));
 
-	if (gtk_tree_model_get_iter_first(model, &parent))
+	pos = parent_index_find(dirname, &found);
+	if (found)
 	{
-		do
-		{
-			if (find_tree_iter_dir(&parent, dirname))
-			{
-				g_free(dirname);
-				g_free(path);
-				return &parent;
-			}
-		}
-		while (gtk_tree_model_iter_next(model, &parent));
+		entry = g_ptr_array_index(parent_index, pos);
+		parent = entry->iter;
+		g_free(dirname);
+		g_free(path);
+		return &parent;
 	}
 	/* no match, add dir parent */
 	if (!dir_icon)
@@ -443,9 +580,13 @@ static GtkTreeIter *get_doc_parent(GeanyDocument *doc)
 	gtk_tree_store_append(store_openfiles, &parent, NULL);
 	gtk_tree_store_set(store_openfiles, &parent, DOCUMENTS_ICON, dir_icon,
 		DOCUMENTS_FILENAME, path,
-		DOCUMENTS_SHORTNAME, doc->file_name ? dirname : GEANY_STRING_UNTITLED, -1);
+		DOCUMENTS_SHORTNAME, dirname, -1);
+
+	entry = g_new0(ParentIndexEntry, 1);
+	entry->dirname = dirname;
+	entry->iter = parent;
+	parent_index_insert(pos, entry);
 
-	g_free(dirname);
 	g_free(path);
 	return &parent;
 }
@@ -492,7 +633,10 @@ static void openfiles_remove(GeanyDocument *doc)
 
 	if (gtk_tree_model_iter_parent(GTK_TREE_MODEL(store_openfiles), &parent, iter) &&
 		gtk_tree_model_iter_n_children(GTK_TREE_MODEL(store_openfiles), &parent) == 1)
+	{
+		parent_index_remove(&parent);
 		gtk_tree_store_remove(store_openfiles, &parent);
+	}
 	else
 		gtk_tree_store_remove(store_openfiles, iter);
 }
@@ -537,6 +681,7 @@ void sidebar_openfiles_update_all(void)
 {
 	guint i;
 
+	parent_index_clear();
 	gtk_tree_store_clear(store_openfiles);
 	foreach_document (i)
 	{
@@ -1108,6 +1253,12 @@ void sidebar_init(void)
 
 void sidebar_finalize(void)
 {
+	parent_index_clear();
+	if (parent_index != NULL)
+	{
+		g_ptr_array_free(parent_index, TRUE);
+		parent_index = NULL;
+	}
 	if (WIDGET(tv.default_tag_tree))
 	{
 		gtk_widget_destroy(tv.default_tag_tree); /* make GTK release its references, if any... */
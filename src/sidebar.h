@@ -45,7 +45,9 @@ enum
 	SYMBOLS_COLUMN_ICON,
 	SYMBOLS_COLUMN_NAME,
 	SYMBOLS_COLUMN_TAG,
-	SYMBOLS_COLUMN_TOOLTIP,
+	/* icon for child rows, set on top-level group rows only; tag rows carry no
+	 * icon of their own but inherit this one through the icon cell data func */
+	SYMBOLS_COLUMN_CHILD_ICON,
 	SYMBOLS_N_COLUMNS
 };
 
@@ -42,6 +42,18 @@
  *
  * At the moment the commands window, doclist, open, openro, line and column are available.
  *
+ * Additionally a small remote control command set is understood so that scripts can drive a
+ * running instance without spawning a new process:
+ * goto - each data line is a filename in the same filename:line:column syntax as the command
+ *        line; the file is opened (or its open document focused) and the caret moved there.
+ *        Replies "ok" or "error" per line, then ETX after the closing '.'.
+ * reload - each data line names an already open document to reload from disk, replies like goto.
+ * search - each data line is a search text which is looked up in all open documents; results
+ *          appear in the Messages window of the running instance. Replies "ok" per line and
+ *          ETX at the end.
+ * stats - takes no data and immediately writes back the performance counter dump and a
+ *         per-document memory breakdown followed by ETX.
+ *
  * About the socket files on Unix-like systems:
  * Geany creates a socket in /tmp (or any other directory returned by g_get_tmp_dir()) and
  * a symlink in the current configuration to the created socket file. The symlink is named
@@ -64,6 +76,8 @@
 #include "document.h"
 #include "encodings.h"
 #include "main.h"
+#include "search.h"
+#include "stats.h"
 #include "support.h"
 #include "utils.h"
 #include "win32.h"
@@ -88,6 +102,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #ifdef GDK_WINDOWING_X11
 #include <gdk/gdkx.h>
@@ -117,44 +132,34 @@ static gint socket_fd_open_unix		(const gchar *path);
 
 static gint socket_fd_write			(gint sock, const gchar *buf, gint len);
 static gint socket_fd_write_all		(gint sock, const gchar *buf, gint len);
-static gint socket_fd_gets			(gint sock, gchar *buf, gint len);
 static gint socket_fd_check_io		(gint fd, GIOCondition cond);
 static gint socket_fd_read			(gint sock, gchar *buf, gint len);
-static gint socket_fd_recv			(gint fd, gchar *buf, gint len, gint flags);
 static gint socket_fd_close			(gint sock);
 
 
 
 static void send_open_command(gint sock, gint argc, gchar **argv)
 {
+	GString *command = g_string_new(NULL);
 	gint i;
 	gchar *filename;
 
 	g_return_if_fail(argc > 1);
 	geany_debug("using running instance of Geany");
 
+	/* assemble the whole command block and send it with a single write per
+	 * invocation, so thousands of files from the command line arrive at the
+	 * running instance as one batch instead of one small write per file */
 	if (cl_options.goto_line >= 0)
-	{
-		gchar *line = g_strdup_printf("%d\n", cl_options.goto_line);
-		socket_fd_write_all(sock, "line\n", 5);
-		socket_fd_write_all(sock, line, strlen(line));
-		socket_fd_write_all(sock, ".\n", 2);
-		g_free(line);
-	}
+		g_string_append_printf(command, "line\n%d\n.\n", cl_options.goto_line);
 
 	if (cl_options.goto_column >= 0)
-	{
-		gchar *col = g_strdup_printf("%d\n", cl_options.goto_column);
-		socket_fd_write_all(sock, "column\n", 7);
-		socket_fd_write_all(sock, col, strlen(col));
-		socket_fd_write_all(sock, ".\n", 2);
-		g_free(col);
-	}
+		g_string_append_printf(command, "column\n%d\n.\n", cl_options.goto_column);
 
 	if (cl_options.readonly) /* append "ro" to denote readonly status for new docs */
-		socket_fd_write_all(sock, "openro\n", 7);
+		g_string_append(command, "openro\n");
 	else
-		socket_fd_write_all(sock, "open\n", 5);
+		g_string_append(command, "open\n");
 
 	for (i = 1; i < argc && argv[i] != NULL; i++)
 	{
@@ -163,8 +168,8 @@ static void send_open_command(gint sock, gint argc, gchar **argv)
 		/* if the filename is valid or if a new file should be opened is check on the other side */
 		if (filename != NULL)
 		{
-			socket_fd_write_all(sock, filename, strlen(filename));
-			socket_fd_write_all(sock, "\n", 1);
+			g_string_append(command, filename);
+			g_string_append_c(command, '\n');
 		}
 		else
 		{
@@ -173,7 +178,10 @@ static void send_open_command(gint sock, gint argc, gchar **argv)
 		}
 		g_free(filename);
 	}
-	socket_fd_write_all(sock, ".\n", 2);
+	g_string_append(command, ".\n");
+
+	socket_fd_write_all(sock, command->str, command->len);
+	g_string_free(command, TRUE);
 }
 
 
@@ -560,16 +568,20 @@ static void socket_init_win32(void)
 #endif
 
 
+/* we never know how the input is encoded, so do the best auto detection we can */
+static gchar *input_filename_to_utf8(const gchar *buf)
+{
+	if (! g_utf8_validate(buf, -1, NULL))
+		return encodings_convert_to_utf8(buf, -1, NULL);
+	return g_strdup(buf);
+}
+
+
 static void handle_input_filename(const gchar *buf)
 {
 	gchar *utf8_filename, *locale_filename;
 
-	/* we never know how the input is encoded, so do the best auto detection we can */
-	if (! g_utf8_validate(buf, -1, NULL))
-		utf8_filename = encodings_convert_to_utf8(buf, -1, NULL);
-	else
-		utf8_filename = g_strdup(buf);
-
+	utf8_filename = input_filename_to_utf8(buf);
 	locale_filename = utils_get_locale_from_utf8(utf8_filename);
 	if (locale_filename)
 	{
@@ -602,135 +614,288 @@ static gchar *build_document_list(void)
 }
 
 
-gboolean socket_lock_input_cb(GIOChannel *source, GIOCondition condition, gpointer data)
+/* one client connection accepted from the lock socket; read and processed
+ * incrementally so a slow or hostile writer never stalls the main loop */
+typedef struct
 {
-	gint fd, sock;
-	gchar buf[BUFFER_LENGTH];
-	struct sockaddr_in caddr;
-	socklen_t caddr_len = sizeof(caddr);
-	GtkWidget *window = data;
-	gboolean popup = FALSE;
+	gint sock;
+	GString *buffer;	/* bytes received but not yet processed */
+	gchar *command;		/* command whose data lines are currently read, or NULL */
+	gboolean popup;		/* whether to present the main window when done */
+	GtkWidget *window;
+} SocketClient;
 
-	fd = g_io_channel_unix_get_fd(source);
-	sock = accept(fd, (struct sockaddr *)&caddr, &caddr_len);
+/* upper bound on buffered unprocessed input per connection; a writer which
+ * floods us without ever completing a line is disconnected */
+#define SOCKET_MAX_PENDING_BYTES (1024 * 1024)
 
-	/* first get the command */
-	while (socket_fd_gets(sock, buf, sizeof(buf)) != -1)
-	{
+static void socket_present_window(GtkWidget *window);
+
+
+static gboolean socket_fd_set_nonblocking(gint fd)
+{
+#ifdef G_OS_WIN32
+	u_long mode = 1;
+
+	return ioctlsocket(fd, FIONBIO, &mode) == 0;
+#else
+	gint flags = fcntl(fd, F_GETFL, 0);
+
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+
+/* processes one received line (without its trailing newline) according to the
+ * little protocol described at the top of this file */
+static void socket_client_process_line(SocketClient *client, gchar *buf)
+{
+	if (client->command == NULL)
+	{	/* first line of a command block names the command */
 		if (strncmp(buf, "open", 4) == 0)
 		{
 			cl_options.readonly = strncmp(buf+4, "ro", 2) == 0; /* open in readonly? */
-			while (socket_fd_gets(sock, buf, sizeof(buf)) != -1 && *buf != '.')
-			{
-				gsize buf_len = strlen(buf);
-
-				/* remove trailing newline */
-				if (buf_len > 0 && buf[buf_len - 1] == '\n')
-					buf[buf_len - 1] = '\0';
-
-				handle_input_filename(buf);
-			}
-			popup = TRUE;
+			client->command = g_strdup("open");
 		}
 		else if (strncmp(buf, "doclist", 7) == 0)
 		{
 			gchar *doc_list = build_document_list();
 			if (!EMPTY(doc_list))
-				socket_fd_write_all(sock, doc_list, strlen(doc_list));
+				socket_fd_write_all(client->sock, doc_list, strlen(doc_list));
 			/* send ETX (end-of-text) so reader knows to stop reading */
-			socket_fd_write_all(sock, "\3", 1);
+			socket_fd_write_all(client->sock, "\3", 1);
 			g_free(doc_list);
 		}
 		else if (strncmp(buf, "line", 4) == 0)
-		{
-			while (socket_fd_gets(sock, buf, sizeof(buf)) != -1 && *buf != '.')
-			{
-				g_strstrip(buf); /* remove \n char */
-				/* on any error we get 0 which should be safe enough as fallback */
-				cl_options.goto_line = atoi(buf);
-			}
-		}
+			client->command = g_strdup("line");
 		else if (strncmp(buf, "column", 6) == 0)
+			client->command = g_strdup("column");
+		else if (strncmp(buf, "goto", 4) == 0)
+			client->command = g_strdup("goto");
+		else if (strncmp(buf, "reload", 6) == 0)
+			client->command = g_strdup("reload");
+		else if (strncmp(buf, "search", 6) == 0)
+			client->command = g_strdup("search");
+		else if (strncmp(buf, "stats", 5) == 0)
 		{
-			while (socket_fd_gets(sock, buf, sizeof(buf)) != -1 && *buf != '.')
-			{
-				g_strstrip(buf); /* remove \n char */
-				/* on any error we get 0 which should be safe enough as fallback */
-				cl_options.goto_column = atoi(buf);
-			}
+			gchar *dump = stats_dump_string();
+			gchar *mem_report = document_memory_report();
+			if (! EMPTY(dump))
+				socket_fd_write_all(client->sock, dump, strlen(dump));
+			if (! EMPTY(mem_report))
+				socket_fd_write_all(client->sock, mem_report, strlen(mem_report));
+			socket_fd_write_all(client->sock, "\3", 1);
+			g_free(dump);
+			g_free(mem_report);
 		}
 #ifdef G_OS_WIN32
 		else if (strncmp(buf, "window", 6) == 0)
 		{
 #	if GTK_CHECK_VERSION(3, 0, 0)
-			HWND hwnd = (HWND) gdk_win32_window_get_handle(gtk_widget_get_window(window));
+			HWND hwnd = (HWND) gdk_win32_window_get_handle(gtk_widget_get_window(client->window));
 #	else
 			HWND hwnd = (HWND) gdk_win32_drawable_get_handle(
-				GDK_DRAWABLE(gtk_widget_get_window(window)));
+				GDK_DRAWABLE(gtk_widget_get_window(client->window)));
 #	endif
-			socket_fd_write(sock, (gchar *)&hwnd, sizeof(hwnd));
+			socket_fd_write(client->sock, (gchar *)&hwnd, sizeof(hwnd));
 		}
 #endif
+		/* unknown commands are silently ignored */
 	}
+	else if (strcmp(buf, ".") == 0)
+	{	/* end of the data of the current command */
+		if (strcmp(client->command, "open") == 0)
+			client->popup = TRUE;
+		else if (strcmp(client->command, "goto") == 0)
+		{
+			client->popup = TRUE;
+			socket_fd_write_all(client->sock, "\3", 1);
+		}
+		else if (strcmp(client->command, "reload") == 0 ||
+				 strcmp(client->command, "search") == 0)
+			socket_fd_write_all(client->sock, "\3", 1);
+		SETPTR(client->command, NULL);
+	}
+	else
+	{	/* data line belonging to the current command */
+		if (strcmp(client->command, "open") == 0)
+			handle_input_filename(buf);
+		else if (strcmp(client->command, "line") == 0)
+			/* on any error we get 0 which should be safe enough as fallback */
+			cl_options.goto_line = atoi(g_strstrip(buf));
+		else if (strcmp(client->command, "column") == 0)
+			cl_options.goto_column = atoi(g_strstrip(buf));
+		else if (strcmp(client->command, "goto") == 0)
+		{
+			/* same filename:line:column syntax as on the command line */
+			gchar *utf8_filename = input_filename_to_utf8(buf);
+			gchar *locale_filename = utils_get_locale_from_utf8(utf8_filename);
+			gboolean ok = locale_filename != NULL && main_handle_filename(locale_filename);
+
+			socket_fd_write_all(client->sock, ok ? "ok\n" : "error\n", ok ? 3 : 6);
+			g_free(utf8_filename);
+			g_free(locale_filename);
+		}
+		else if (strcmp(client->command, "reload") == 0)
+		{
+			gchar *utf8_filename = input_filename_to_utf8(buf);
+			GeanyDocument *doc = document_find_by_filename(utf8_filename);
+			gboolean ok = doc != NULL && document_reload_force(doc, doc->encoding);
 
-	if (popup)
-	{
-#ifdef GDK_WINDOWING_X11
-		GdkWindow *x11_window = gtk_widget_get_window(window);
-
-		/* Set the proper interaction time on the window. This seems necessary to make
-		 * gtk_window_present() really bring the main window into the foreground on some
-		 * window managers like Gnome's metacity.
-		 * Code taken from Gedit. */
-#	if GTK_CHECK_VERSION(3, 0, 0)
-		if (GDK_IS_X11_WINDOW(x11_window))
-#	endif
+			socket_fd_write_all(client->sock, ok ? "ok\n" : "error\n", ok ? 3 : 6);
+			g_free(utf8_filename);
+		}
+		else if (strcmp(client->command, "search") == 0)
 		{
-			gdk_x11_window_set_user_time(x11_window, gdk_x11_get_server_time(x11_window));
+			/* results go to the Messages window of the running instance */
+			search_find_usage(buf, buf, 0, TRUE);
+			socket_fd_write_all(client->sock, "ok\n", 3);
 		}
-#endif
-		gtk_window_present(GTK_WINDOW(window));
+	}
+}
+
+
+static void socket_client_free(SocketClient *client)
+{
+	if (client->popup)
+		socket_present_window(client->window);
+
+	socket_fd_close(client->sock);
+	g_string_free(client->buffer, TRUE);
+	g_free(client->command);
+	g_free(client);
+}
+
+
+/* watch callback for one accepted connection; never blocks, all received
+ * bytes are buffered and complete lines processed as they arrive */
+static gboolean socket_client_input_cb(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	SocketClient *client = data;
+	gchar buf[BUFFER_LENGTH];
+	gboolean finished = FALSE;
+	gchar *newline;
+
+	if (condition & (G_IO_IN | G_IO_PRI))
+	{
+		for (;;)
+		{
+			gint n = recv(client->sock, buf, sizeof(buf), 0);
+
+			if (n > 0)
+			{
+				g_string_append_len(client->buffer, buf, n);
+				if (client->buffer->len > SOCKET_MAX_PENDING_BYTES)
+				{	/* not speaking our protocol - drop the connection */
+					geany_debug("Socket client exceeded the input limit, disconnecting");
+					socket_client_free(client);
+					return FALSE;
+				}
+			}
+			else if (n == 0)
+			{	/* client closed the connection */
+				finished = TRUE;
+				break;
+			}
+			else
+			{
 #ifdef G_OS_WIN32
-		gdk_window_show(gtk_widget_get_window(window));
+				if (WSAGetLastError() == WSAEWOULDBLOCK)
+					break;
+#else
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
 #endif
-	}
+				finished = TRUE;
+				break;
+			}
+		}
 
-	socket_fd_close(sock);
+		/* process all complete lines received so far */
+		while ((newline = memchr(client->buffer->str, '\n', client->buffer->len)) != NULL)
+		{
+			gsize line_len = (gsize) (newline - client->buffer->str);
+
+			*newline = '\0';
+			/* strip a \r but no other whitespace - filenames may contain it */
+			if (line_len > 0 && client->buffer->str[line_len - 1] == '\r')
+				client->buffer->str[line_len - 1] = '\0';
+			socket_client_process_line(client, client->buffer->str);
+			g_string_erase(client->buffer, 0, line_len + 1);
+		}
+	}
 
+	if (finished || (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)))
+	{
+		socket_client_free(client);
+		return FALSE;
+	}
 	return TRUE;
 }
 
 
-static gint socket_fd_gets(gint fd, gchar *buf, gint len)
+gboolean socket_lock_input_cb(GIOChannel *source, GIOCondition condition, gpointer data)
 {
-	gchar *newline, *bp = buf;
-	gint n;
+	gint fd, sock;
+	struct sockaddr_in caddr;
+	socklen_t caddr_len = sizeof(caddr);
+	GtkWidget *window = data;
+	SocketClient *client;
+	GIOChannel *ioc;
 
-	if (--len < 1)
-		return -1;
-	do
+	fd = g_io_channel_unix_get_fd(source);
+	sock = accept(fd, (struct sockaddr *)&caddr, &caddr_len);
+	if (! SOCKET_IS_VALID(sock))
+		return TRUE;
+
+	if (! socket_fd_set_nonblocking(sock))
 	{
-		if ((n = socket_fd_recv(fd, bp, len, MSG_PEEK)) <= 0)
-			return -1;
-		if ((newline = memchr(bp, '\n', n)) != NULL)
-			n = newline - bp + 1;
-		if ((n = socket_fd_read(fd, bp, n)) < 0)
-			return -1;
-		bp += n;
-		len -= n;
-	} while (! newline && len);
+		socket_fd_close(sock);
+		return TRUE;
+	}
+
+	client = g_new0(SocketClient, 1);
+	client->sock = sock;
+	client->buffer = g_string_sized_new(BUFFER_LENGTH);
+	client->window = window;
+
+#ifdef G_OS_WIN32
+	ioc = g_io_channel_win32_new_socket(sock);
+#else
+	ioc = g_io_channel_unix_new(sock);
+#endif
+	g_io_add_watch(ioc, G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+		socket_client_input_cb, client);
+	g_io_channel_unref(ioc);
 
-	*bp = '\0';
-	return bp - buf;
+	return TRUE;
 }
 
 
-static gint socket_fd_recv(gint fd, gchar *buf, gint len, gint flags)
+/* brings the main window into the foreground, used after a second instance
+ * asked us to open files */
+static void socket_present_window(GtkWidget *window)
 {
-	if (socket_fd_check_io(fd, G_IO_IN) < 0)
-		return -1;
+#ifdef GDK_WINDOWING_X11
+		GdkWindow *x11_window = gtk_widget_get_window(window);
 
-	return recv(fd, buf, len, flags);
+		/* Set the proper interaction time on the window. This seems necessary to make
+		 * gtk_window_present() really bring the main window into the foreground on some
+		 * window managers like Gnome's metacity.
+		 * Code taken from Gedit. */
+#	if GTK_CHECK_VERSION(3, 0, 0)
+		if (GDK_IS_X11_WINDOW(x11_window))
+#	endif
+	{
+		gdk_x11_window_set_user_time(x11_window, gdk_x11_get_server_time(x11_window));
+	}
+#endif
+	gtk_window_present(GTK_WINDOW(window));
+#ifdef G_OS_WIN32
+	gdk_window_show(gtk_widget_get_window(window));
+#endif
 }
 
 
@@ -112,6 +112,12 @@ struct StashPref
 	gpointer default_value;		/* Default value, e.g. (gpointer)1 */
 	GType widget_type;			/* e.g. GTK_TYPE_TOGGLE_BUTTON */
 	StashWidgetID widget_id;	/* (GtkWidget*) or (gchar*) */
+	/* Memoized result of the name-based widget lookup, valid while the widget
+	 * is alive (cleared by a weak pointer) and the owner is unchanged. Widget
+	 * lookup walks the owner's whole GObject data list per name, which made
+	 * displaying/updating a dialog with hundreds of prefs quadratic. */
+	GtkWidget *widget_cache;
+	GtkWidget *owner_cache;
 	union
 	{
 		struct EnumWidget *radio_buttons;
@@ -125,6 +131,7 @@ struct StashGroup
 {
 	const gchar *name;			/* group name to use in the keyfile */
 	GPtrArray *entries;			/* array of (StashPref*) */
+	GHashTable *entry_index;	/* key_name -> StashPref, for O(1) by-key lookup */
 	gboolean various;		/* mark group for display/edit in stash treeview */
 	gboolean use_defaults;		/* use default values if there's no keyfile entry */
 };
@@ -133,6 +140,8 @@ typedef struct EnumWidget
 {
 	StashWidgetID widget_id;
 	gint enum_id;
+	GtkWidget *widget_cache;	/* see StashPref::widget_cache */
+	GtkWidget *owner_cache;
 }
 EnumWidget;
 
@@ -352,6 +361,7 @@ StashGroup *stash_group_new(const gchar *name)
 
 	group->name = name;
 	group->entries = g_ptr_array_new();
+	group->entry_index = g_hash_table_new(g_str_hash, g_str_equal);
 	group->use_defaults = TRUE;
 	return group;
 }
@@ -391,11 +401,23 @@ void stash_group_free(StashGroup *group)
 	{
 		if (entry->widget_type == GTK_TYPE_RADIO_BUTTON)
 		{
+			EnumWidget *field;
+
+			for (field = entry->extra.radio_buttons; field->widget_id != NULL; field++)
+			{
+				if (field->widget_cache != NULL)
+					g_object_remove_weak_pointer(G_OBJECT(field->widget_cache),
+						(gpointer *) &field->widget_cache);
+			}
 			g_free(entry->extra.radio_buttons);
 		}
+		if (entry->widget_cache != NULL)
+			g_object_remove_weak_pointer(G_OBJECT(entry->widget_cache),
+				(gpointer *) &entry->widget_cache);
 		g_slice_free(StashPref, entry);
 	}
 	g_ptr_array_free(group->entries, TRUE);
+	g_hash_table_destroy(group->entry_index);
 	g_free(group);
 }
 
@@ -421,7 +443,8 @@ static StashPref *
 add_pref(StashGroup *group, GType type, gpointer setting,
 		const gchar *key_name, gpointer default_value)
 {
-	StashPref init = {type, setting, key_name, default_value, G_TYPE_NONE, NULL, {NULL}};
+	StashPref init = {type, setting, key_name, default_value, G_TYPE_NONE, NULL,
+		NULL, NULL, {NULL}};
 	StashPref *entry = g_slice_new(StashPref);
 
 	*entry = init;
@@ -432,6 +455,10 @@ add_pref(StashGroup *group, GType type, gpointer setting,
 		if (group->use_defaults)
 			*(gpointer**)setting = NULL;
 
+	if (g_hash_table_lookup(group->entry_index, key_name) != NULL)
+		g_warning("Duplicate key %s::%s in %s()!", group->name, key_name, G_STRFUNC);
+	g_hash_table_insert(group->entry_index, (gpointer) key_name, entry);
+
 	g_ptr_array_add(group->entries, entry);
 	return entry;
 }
@@ -597,11 +624,18 @@ lookup_widget(GtkWidget *widget, const gchar *widget_name)
 }
 
 
+/* widget_cache/owner_cache memoize the name lookup across calls; the cached
+ * widget is trusted while it is alive (a weak pointer clears it on destroy)
+ * and the lookup would start from the same owner */
 static GtkWidget *
-get_widget(GtkWidget *owner, StashWidgetID widget_id)
+get_widget(GtkWidget *owner, StashWidgetID widget_id,
+		GtkWidget **widget_cache, GtkWidget **owner_cache)
 {
 	GtkWidget *widget;
 
+	if (owner != NULL && *widget_cache != NULL && *owner_cache == owner)
+		return *widget_cache;
+
 	if (owner)
 		widget = lookup_widget(owner, (const gchar *)widget_id);
 	else
@@ -612,6 +646,14 @@ get_widget(GtkWidget *owner, StashWidgetID widget_id)
 		g_warning("Unknown widget in %s()!", G_STRFUNC);
 		return NULL;
 	}
+	if (owner != NULL)
+	{
+		if (*widget_cache != NULL)
+			g_object_remove_weak_pointer(G_OBJECT(*widget_cache), (gpointer *) widget_cache);
+		*widget_cache = widget;
+		*owner_cache = owner;
+		g_object_add_weak_pointer(G_OBJECT(widget), (gpointer *) widget_cache);
+	}
 	return widget;
 }
 
@@ -642,7 +684,8 @@ static void handle_radio_buttons(GtkWidget *owner, StashPref *entry,
 
 	while (1)
 	{
-		widget = get_widget(owner, field->widget_id);
+		widget = get_widget(owner, field->widget_id,
+			&field->widget_cache, &field->owner_cache);
 
 		if (!widget)
 			continue;
@@ -700,7 +743,8 @@ static void pref_action(PrefAction action, StashGroup *group, GtkWidget *owner)
 			continue;
 		}
 
-		widget = get_widget(owner, entry->widget_id);
+		widget = get_widget(owner, entry->widget_id,
+			&entry->widget_cache, &entry->owner_cache);
 		if (!widget)
 		{
 			g_warning("Unknown widget for %s::%s in %s()!", group->name, entry->key_name,
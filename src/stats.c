@@ -0,0 +1,283 @@
+/*
+ *      stats.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Lightweight runtime performance counters for the core subsystems.
+ *
+ * Hot paths publish named counters and timers with stats_count() and
+ * stats_time_since(); the accumulated numbers can be inspected while Geany is
+ * running by sending SIGUSR2, which dumps them through geany_debug() and thus
+ * into the Help->Debug Messages window and onto stdout with -v. The names are
+ * dotted "<subsystem>.<event>" strings and must be string literals, they are
+ * stored without copying.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "stats.h"
+
+#include "geany.h" /* geany_debug() */
+#include "trace.h"
+#include "utils.h"
+
+#include <string.h>
+
+#ifdef G_OS_UNIX
+# include <signal.h>
+# include <unistd.h>
+#endif
+
+
+typedef struct
+{
+	gsize	count;		/* number of events or timed calls */
+	gdouble	total;		/* accumulated seconds, 0 for plain counters */
+	gdouble	max;		/* longest single timed call in seconds */
+} StatsEntry;
+
+/* a plain mutex, not a per-thread arena: the probes sit on paths that run at
+ * user interaction rate (keystrokes, parse completions, search output), so
+ * contention is not measurable and the bookkeeping stays trivial */
+static GStaticMutex stats_mutex = G_STATIC_MUTEX_INIT;
+static GHashTable *stats_table = NULL;
+
+/* extra dump sections from other subsystems; only touched from the main
+ * thread (registration at startup, iteration from the dump) */
+static GSList *stats_providers = NULL;
+
+#ifdef G_OS_UNIX
+/* self-pipe: the signal handler may only do async-signal-safe work, so it
+ * pokes a byte into the pipe and the dump runs from the main loop watch */
+static gint stats_signal_pipe[2] = { -1, -1 };
+static guint stats_signal_watch = 0;
+#endif
+
+
+static StatsEntry *get_entry(const gchar *name)
+{
+	StatsEntry *entry;
+
+	if (stats_table == NULL)
+		return NULL;
+
+	entry = g_hash_table_lookup(stats_table, name);
+	if (entry == NULL)
+	{
+		entry = g_new0(StatsEntry, 1);
+		g_hash_table_insert(stats_table, (gpointer) name, entry);
+	}
+	return entry;
+}
+
+
+/* Adds @a amount events to the counter @a name. @a name must be a string literal. */
+void stats_count(const gchar *name, gsize amount)
+{
+	StatsEntry *entry;
+
+	g_static_mutex_lock(&stats_mutex);
+	entry = get_entry(name);
+	if (entry != NULL)
+		entry->count += amount;
+	g_static_mutex_unlock(&stats_mutex);
+}
+
+
+/* Accumulates the time elapsed since @a start into the timer @a name.
+ * @a name must be a string literal. */
+void stats_time_since(const gchar *name, const GTimeVal *start)
+{
+	GTimeVal now;
+	gdouble elapsed;
+	StatsEntry *entry;
+
+	g_get_current_time(&now);
+	elapsed = (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+
+	/* every timed probe is also a slice on the trace timeline */
+	trace_add(name, start);
+
+	g_static_mutex_lock(&stats_mutex);
+	entry = get_entry(name);
+	if (entry != NULL)
+	{
+		entry->count++;
+		entry->total += elapsed;
+		if (elapsed > entry->max)
+			entry->max = elapsed;
+	}
+	g_static_mutex_unlock(&stats_mutex);
+}
+
+
+static gint compare_names(gconstpointer a, gconstpointer b)
+{
+	return strcmp(a, b);
+}
+
+
+/* Registers @a provider to contribute extra lines to the dump. Providers
+ * cannot be unregistered, so they must stay callable for the rest of the
+ * process. */
+void stats_add_provider(StatsProviderFunc provider)
+{
+	stats_providers = g_slist_append(stats_providers, (gpointer) provider);
+}
+
+
+/* Builds the counter dump as one newline separated string; the caller frees
+ * the result. Used for the geany_debug() dump and for remote queries over
+ * the single instance socket. */
+gchar *stats_dump_string(void)
+{
+	GString *out = g_string_new(NULL);
+	GList *names, *node;
+	GSList *pnode;
+
+	if (stats_table == NULL)
+		return g_string_free(out, FALSE);
+
+	g_static_mutex_lock(&stats_mutex);
+	names = g_list_sort(g_hash_table_get_keys(stats_table), compare_names);
+	foreach_list(node, names)
+	{
+		const gchar *name = node->data;
+		StatsEntry *entry = g_hash_table_lookup(stats_table, name);
+
+		if (entry->total > 0.0 || entry->max > 0.0)
+		{
+			g_string_append_printf(out, "%s: %lu calls, %.1f ms total, %.3f ms mean, %.3f ms max\n",
+				name, (gulong) entry->count, entry->total * 1000.0,
+				entry->count > 0 ? entry->total * 1000.0 / (gdouble) entry->count : 0.0,
+				entry->max * 1000.0);
+		}
+		else
+			g_string_append_printf(out, "%s: %lu\n", name, (gulong) entry->count);
+	}
+	g_static_mutex_unlock(&stats_mutex);
+	g_list_free(names);
+
+	foreach_slist(pnode, stats_providers)
+	{
+		StatsProviderFunc provider = (StatsProviderFunc) pnode->data;
+		gchar *extra = provider();
+
+		g_string_append(out, extra);
+		g_free(extra);
+	}
+	return g_string_free(out, FALSE);
+}
+
+
+/* Writes all counters through geany_debug(), one per line */
+void stats_dump(void)
+{
+	gchar *dump = stats_dump_string();
+	gchar **lines = g_strsplit(dump, "\n", 0);
+	gchar **line;
+
+	geany_debug("performance counters:");
+	for (line = lines; *line != NULL; line++)
+	{
+		if (! EMPTY(*line))
+			geany_debug("  %s", *line);
+	}
+	g_strfreev(lines);
+	g_free(dump);
+}
+
+
+#ifdef G_OS_UNIX
+static void sigusr2_handler(gint sig)
+{
+	gchar byte = 1;
+
+	if (write(stats_signal_pipe[1], &byte, 1) < 0)
+		return;	/* pipe full: a dump is already pending */
+}
+
+
+static gboolean on_signal_pipe_ready(GIOChannel *source, GIOCondition condition,
+	gpointer user_data)
+{
+	gchar buf[16];
+	gsize unused;
+	gchar *trace_file;
+
+	g_io_channel_read_chars(source, buf, sizeof buf, &unused, NULL);
+	stats_dump();
+	trace_file = trace_dump();
+	if (trace_file != NULL)
+	{
+		geany_debug("trace written to %s", trace_file);
+		g_free(trace_file);
+	}
+	return TRUE;
+}
+#endif
+
+
+void stats_init(void)
+{
+	/* the name strings are literals and the entries are owned by the table */
+	stats_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+
+#ifdef G_OS_UNIX
+	if (pipe(stats_signal_pipe) == 0)
+	{
+		GIOChannel *channel = g_io_channel_unix_new(stats_signal_pipe[0]);
+
+		g_io_channel_set_encoding(channel, NULL, NULL);
+		g_io_channel_set_buffered(channel, FALSE);
+		stats_signal_watch = g_io_add_watch(channel, G_IO_IN, on_signal_pipe_ready, NULL);
+		g_io_channel_unref(channel);
+		signal(SIGUSR2, sigusr2_handler);
+	}
+#endif
+}
+
+
+void stats_finalize(void)
+{
+#ifdef G_OS_UNIX
+	if (stats_signal_watch != 0)
+	{
+		signal(SIGUSR2, SIG_DFL);
+		g_source_remove(stats_signal_watch);
+		stats_signal_watch = 0;
+		close(stats_signal_pipe[0]);
+		close(stats_signal_pipe[1]);
+		stats_signal_pipe[0] = stats_signal_pipe[1] = -1;
+	}
+#endif
+
+	g_static_mutex_lock(&stats_mutex);
+	if (stats_table != NULL)
+	{
+		g_hash_table_destroy(stats_table);
+		stats_table = NULL;
+	}
+	g_static_mutex_unlock(&stats_mutex);
+
+	g_slist_free(stats_providers);
+	stats_providers = NULL;
+}
@@ -0,0 +1,48 @@
+/*
+ *      stats.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_STATS_H
+#define GEANY_STATS_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void stats_init(void);
+
+void stats_finalize(void);
+
+void stats_count(const gchar *name, gsize amount);
+
+void stats_time_since(const gchar *name, const GTimeVal *start);
+
+/* contributes extra lines to the dump; returns a newly allocated, newline
+ * terminated block of lines, which the caller frees */
+typedef gchar *(*StatsProviderFunc)(void);
+
+void stats_add_provider(StatsProviderFunc provider);
+
+void stats_dump(void);
+
+gchar *stats_dump_string(void);
+
+G_END_DECLS
+
+#endif /* GEANY_STATS_H */
@@ -49,6 +49,7 @@
 #include "navqueue.h"
 #include "sciwrappers.h"
 #include "sidebar.h"
+#include "stats.h"
 #include "support.h"
 #include "tm_parser.h"
 #include "tm_tag.h"
@@ -412,21 +413,24 @@ static TMTag *find_source_file_tag(GPtrArray *tags_array,
 
 static TMTag *find_workspace_tag(const gchar *tag_name, guint type)
 {
+	const GPtrArray *tags;
 	guint j;
-	const GPtrArray *source_files = NULL;
 
-	if (app->tm_workspace != NULL)
-		source_files = app->tm_workspace->source_files;
+	if (app->tm_workspace == NULL)
+		return NULL;
 
-	if (source_files != NULL)
+	/* The workspace maintains one name-sorted tag array which the tag manager
+	 * updates incrementally on every (re)parse, so the lookup is a binary
+	 * search rather than a walk over the tags of every source file. */
+	tags = tm_workspace_find(tag_name, type, NULL, FALSE, -1);
+	if (tags != NULL)
 	{
-		for (j = 0; j < source_files->len; j++)
+		for (j = 0; j < tags->len; j++)
 		{
-			TMSourceFile *srcfile = source_files->pdata[j];
-			TMTag *tmtag;
+			TMTag *tmtag = TM_TAG(tags->pdata[j]);
 
-			tmtag = find_source_file_tag(srcfile->tags_array, tag_name, type);
-			if (tmtag != NULL)
+			/* skip global tags - they have no workspace file to jump to */
+			if (tmtag->file != NULL)
 				return tmtag;
 		}
 	}
@@ -557,15 +561,24 @@ static void init_tag_iters(void)
 static GdkPixbuf *get_tag_icon(const gchar *icon_name)
 {
 	static GtkIconTheme *icon_theme = NULL;
+	static GHashTable *icon_cache = NULL;
 	static gint x = -1;
+	gpointer icon;
 
 	if (G_UNLIKELY(x < 0))
 	{
 		gint dummy;
 		icon_theme = gtk_icon_theme_get_default();
 		gtk_icon_size_lookup(GTK_ICON_SIZE_MENU, &x, &dummy);
+		icon_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
+	/* memoize theme lookups, the same few icon names are requested over and over */
+	if (! g_hash_table_lookup_extended(icon_cache, icon_name, NULL, &icon))
+	{
+		icon = gtk_icon_theme_load_icon(icon_theme, icon_name, x, 0, NULL);
+		g_hash_table_insert(icon_cache, g_strdup(icon_name), icon);
 	}
-	return gtk_icon_theme_load_icon(icon_theme, icon_name, x, 0, NULL);
+	return icon != NULL ? g_object_ref(icon) : NULL;
 }
 
 
@@ -612,11 +625,18 @@ tag_list_add_groups(GtkTreeStore *tree_store, ...)
 		gchar *title = va_arg(args, gchar*);
 		gchar *icon_name = va_arg(args, gchar *);
 		GdkPixbuf *icon = NULL;
+		GdkPixbuf *child_icon;
 
 		if (icon_name)
 		{
 			icon = get_tag_icon(icon_name);
 		}
+		/* child rows pick their icon up from the group row when drawn, so tags in
+		 * "Other" show a variable icon rather than the group's own icon */
+		if (iter == &tv_iters.tag_other)
+			child_icon = get_tag_icon("classviewer-var");
+		else
+			child_icon = icon != NULL ? g_object_ref(icon) : NULL;
 
 		g_assert(title != NULL);
 		g_ptr_array_add(top_level_iter_names, title);
@@ -629,6 +649,11 @@ tag_list_add_groups(GtkTreeStore *tree_store, ...)
 			gtk_tree_store_set(tree_store, iter, SYMBOLS_COLUMN_ICON, icon, -1);
 			g_object_unref(icon);
 		}
+		if (G_IS_OBJECT(child_icon))
+		{
+			gtk_tree_store_set(tree_store, iter, SYMBOLS_COLUMN_CHILD_ICON, child_icon, -1);
+			g_object_unref(child_icon);
+		}
 		gtk_tree_store_set(tree_store, iter, SYMBOLS_COLUMN_NAME, title, -1);
 	}
 	va_end(args);
@@ -1082,15 +1107,27 @@ static const gchar *get_symbol_name(GeanyDocument *doc, const TMTag *tag, gboole
 	if (! doc_is_utf8)
 		g_free(utf8_name);
 
-	g_string_append_printf(buffer, " [%lu]", tag->line);
+	g_string_append_printf(buffer, " [%u]", tag->line);
 
 	return buffer->str;
 }
 
 
-static gchar *get_symbol_tooltip(GeanyDocument *doc, const TMTag *tag)
+/* Computes the UTF-8 markup tooltip for a symbol tree row. Called from the tag
+ * tree's query-tooltip handler rather than at row insertion, so only the row
+ * under the pointer ever pays for the calltip text and encoding conversion.
+ * A single-entry cache covers GTK querying the same row repeatedly on motion. */
+gchar *symbols_get_tag_tooltip(GeanyDocument *doc, const TMTag *tag)
 {
-	gchar *utf8_name = editor_get_calltip_text(doc->editor, tag);
+	static TMTag *cached_tag = NULL;	/* referenced so the pointer cannot be reused */
+	static GeanyDocument *cached_doc = NULL;
+	static gchar *cached_tooltip = NULL;
+	gchar *utf8_name;
+
+	if (tag == cached_tag && doc == cached_doc)
+		return g_strdup(cached_tooltip);
+
+	utf8_name = editor_get_calltip_text(doc->editor, tag);
 
 	/* encodings_convert_to_utf8_from_charset() fails with charset "None", so skip conversion
 	 * for None at this point completely */
@@ -1105,6 +1142,12 @@ static gchar *get_symbol_tooltip(GeanyDocument *doc, const TMTag *tag)
 	if (utf8_name != NULL)
 		SETPTR(utf8_name, g_markup_escape_text(utf8_name, -1));
 
+	if (cached_tag != NULL)
+		tm_tag_unref(cached_tag);
+	cached_tag = tm_tag_ref((TMTag *) tag);
+	cached_doc = doc;
+	SETPTR(cached_tooltip, g_strdup(utf8_name));
+
 	return utf8_name;
 }
 
@@ -1209,21 +1252,6 @@ static GtkTreeIter *get_tag_type_iter(TMTagType tag_type, filetype_id ft_id)
 }
 
 
-static GdkPixbuf *get_child_icon(GtkTreeStore *tree_store, GtkTreeIter *parent)
-{
-	GdkPixbuf *icon = NULL;
-
-	if (parent == &tv_iters.tag_other)
-	{
-		return get_tag_icon("classviewer-var");
-	}
-	/* copy parent icon */
-	gtk_tree_model_get(GTK_TREE_MODEL(tree_store), parent,
-		SYMBOLS_COLUMN_ICON, &icon, -1);
-	return icon;
-}
-
-
 static gboolean tag_equal(gconstpointer v1, gconstpointer v2)
 {
 	const TMTag *t1 = v1;
@@ -1521,8 +1549,6 @@ static void update_tree_tags(GeanyDocument *doc, GList **tags)
 			gboolean expand;
 			const gchar *name;
 			const gchar *parent_name;
-			gchar *tooltip;
-			GdkPixbuf *icon = get_child_icon(store, parent);
 
 			parent_name = get_parent_name(tag, doc->file_type->id);
 			if (parent_name)
@@ -1566,19 +1592,14 @@ static void update_tree_tags(GeanyDocument *doc, GList **tags)
 			 * folding as it was before (already expanded, or closed by the user) */
 			expand = ! gtk_tree_model_iter_has_child(model, parent);
 
-			/* insert the new element */
+			/* insert the new element; its icon and tooltip are resolved on demand
+			 * when the row is drawn or hovered, see prepare_taglist() in sidebar.c */
 			gtk_tree_store_append(store, &iter, parent);
 			name = get_symbol_name(doc, tag, parent_name != NULL);
-			tooltip = get_symbol_tooltip(doc, tag);
 			gtk_tree_store_set(store, &iter,
 					SYMBOLS_COLUMN_NAME, name,
-					SYMBOLS_COLUMN_TOOLTIP, tooltip,
-					SYMBOLS_COLUMN_ICON, icon,
 					SYMBOLS_COLUMN_TAG, tag,
 					-1);
-			g_free(tooltip);
-			if (G_LIKELY(icon))
-				g_object_unref(icon);
 
 			update_parents_table(parents_table, tag, parent_name, &iter);
 
@@ -1628,7 +1649,8 @@ static gboolean tag_has_missing_parent(const TMTag *tag, GtkTreeStore *store,
 static gint tree_sort_func(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 		gpointer user_data)
 {
-	gboolean sort_by_name = GPOINTER_TO_INT(user_data);
+	GeanyDocument *doc = user_data;
+	gboolean sort_by_name = doc->priv->symbol_list_sort_mode == SYMBOLS_SORT_BY_NAME;
 	TMTag *tag_a, *tag_b;
 	gint cmp;
 
@@ -1640,8 +1662,19 @@ static gint tree_sort_func(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 	if (tag_a && !tag_has_missing_parent(tag_a, GTK_TREE_STORE(model), a) &&
 		tag_b && !tag_has_missing_parent(tag_b, GTK_TREE_STORE(model), b))
 	{
-		cmp = sort_by_name ? compare_symbol(tag_a, tag_b) :
-			compare_symbol_lines(tag_a, tag_b);
+		GHashTable *ranks = sort_by_name ?
+			doc->priv->sort_rank_name : doc->priv->sort_rank_appearance;
+		gpointer rank_a, rank_b;
+
+		/* compare by the ranks cached per parse result where possible; the
+		 * direct comparison remains for tags not covered by them */
+		if (ranks != NULL &&
+			g_hash_table_lookup_extended(ranks, tag_a, NULL, &rank_a) &&
+			g_hash_table_lookup_extended(ranks, tag_b, NULL, &rank_b))
+			cmp = GPOINTER_TO_INT(rank_a) - GPOINTER_TO_INT(rank_b);
+		else
+			cmp = sort_by_name ? compare_symbol(tag_a, tag_b) :
+				compare_symbol_lines(tag_a, tag_b);
 	}
 	else
 	{
@@ -1684,18 +1717,109 @@ static gint tree_sort_func(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 }
 
 
-static void sort_tree(GtkTreeStore *store, gboolean sort_by_name)
+static void sort_tree(GeanyDocument *doc)
 {
+	GtkTreeStore *store = doc->priv->tag_store;
+
 	gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, tree_sort_func,
-		GINT_TO_POINTER(sort_by_name), NULL);
+		doc, NULL);
 
 	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store), SYMBOLS_COLUMN_NAME, GTK_SORT_ASCENDING);
 }
 
 
+/* compares the fields of two tags which influence the symbol tree display */
+static gboolean tag_equal_for_tree(const TMTag *a, const TMTag *b)
+{
+	return a->type == b->type && a->line == b->line &&
+		utils_str_equal(a->name, b->name) &&
+		utils_str_equal(a->scope, b->scope) &&
+		utils_str_equal(a->arglist, b->arglist);
+}
+
+
+/* returns TRUE if @tags is equivalent to the snapshot of the tags currently
+ * shown in the symbol tree, in which case the tree needs no update at all */
+static gboolean tag_list_unchanged(GeanyDocument *doc, GList *tags)
+{
+	GPtrArray *displayed = doc->priv->displayed_tags;
+	GList *item;
+	guint i = 0;
+
+	if (displayed == NULL)
+		return FALSE;
+	foreach_list(item, tags)
+	{
+		if (i >= displayed->len ||
+			! tag_equal_for_tree(TM_TAG(displayed->pdata[i]), TM_TAG(item->data)))
+			return FALSE;
+		i++;
+	}
+	return i == displayed->len;
+}
+
+
+static void update_displayed_tags(GeanyDocument *doc, GList *tags)
+{
+	GList *item;
+
+	if (doc->priv->displayed_tags != NULL)
+		tm_tags_array_free(doc->priv->displayed_tags, TRUE);
+	doc->priv->displayed_tags = g_ptr_array_new();
+	foreach_list(item, tags)
+		g_ptr_array_add(doc->priv->displayed_tags, tm_tag_ref(item->data));
+}
+
+
+static gint compare_symbol_ptrs(gconstpointer a, gconstpointer b)
+{
+	return compare_symbol(*(TMTag * const *) a, *(TMTag * const *) b);
+}
+
+
+static gint compare_symbol_lines_ptrs(gconstpointer a, gconstpointer b)
+{
+	return compare_symbol_lines(*(TMTag * const *) a, *(TMTag * const *) b);
+}
+
+
+/* computes both sort orders of the displayed tags as tag-to-rank tables once
+ * per parse result, so resorting the tree - especially the sidebar sort
+ * toggle - only compares cached ranks in tree_sort_func() */
+static void update_sort_ranks(GeanyDocument *doc)
+{
+	GPtrArray *displayed = doc->priv->displayed_tags;
+	GPtrArray *sorted = g_ptr_array_sized_new(displayed->len);
+	guint i;
+
+	if (doc->priv->sort_rank_name != NULL)
+		g_hash_table_destroy(doc->priv->sort_rank_name);
+	if (doc->priv->sort_rank_appearance != NULL)
+		g_hash_table_destroy(doc->priv->sort_rank_appearance);
+	doc->priv->sort_rank_name = g_hash_table_new(NULL, NULL);
+	doc->priv->sort_rank_appearance = g_hash_table_new(NULL, NULL);
+
+	for (i = 0; i < displayed->len; i++)
+		g_ptr_array_add(sorted, displayed->pdata[i]);
+
+	g_ptr_array_sort(sorted, compare_symbol_ptrs);
+	for (i = 0; i < sorted->len; i++)
+		g_hash_table_insert(doc->priv->sort_rank_name,
+			sorted->pdata[i], GUINT_TO_POINTER(i));
+
+	g_ptr_array_sort(sorted, compare_symbol_lines_ptrs);
+	for (i = 0; i < sorted->len; i++)
+		g_hash_table_insert(doc->priv->sort_rank_appearance,
+			sorted->pdata[i], GUINT_TO_POINTER(i));
+
+	g_ptr_array_free(sorted, TRUE);
+}
+
+
 gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode)
 {
 	GList *tags;
+	GTimeVal start;
 
 	g_return_val_if_fail(DOC_VALID(doc), FALSE);
 
@@ -1703,6 +1827,28 @@ gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode)
 	if (tags == NULL)
 		return FALSE;
 
+	if (sort_mode == SYMBOLS_SORT_USE_PREVIOUS)
+		sort_mode = doc->priv->symbol_list_sort_mode;
+
+	/* most reparses during typing produce an identical tag list - skip the
+	 * whole store update and resort, keeping the tree (and its expansion
+	 * state) exactly as it is */
+	if (tag_list_unchanged(doc, tags))
+	{
+		g_list_free(tags);
+		/* only the sort order changed (sidebar sort toggle): reorder the
+		 * existing rows by the cached ranks instead of rebuilding the tree */
+		if (sort_mode != doc->priv->symbol_list_sort_mode)
+		{
+			doc->priv->symbol_list_sort_mode = sort_mode;
+			sort_tree(doc);
+		}
+		return TRUE;
+	}
+	g_get_current_time(&start);
+	update_displayed_tags(doc, tags);
+	update_sort_ranks(doc);
+
 	/* FIXME: Not sure why we detached the model here? */
 
 	/* disable sorting during update because the code doesn't support correctly
@@ -1717,12 +1863,10 @@ gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode)
 
 	hide_empty_rows(doc->priv->tag_store);
 
-	if (sort_mode == SYMBOLS_SORT_USE_PREVIOUS)
-		sort_mode = doc->priv->symbol_list_sort_mode;
-
-	sort_tree(doc->priv->tag_store, sort_mode == SYMBOLS_SORT_BY_NAME);
 	doc->priv->symbol_list_sort_mode = sort_mode;
+	sort_tree(doc);
 
+	stats_time_since("symbols.list-rebuild", &start);
 	return TRUE;
 }
 
@@ -1995,6 +2139,374 @@ gboolean symbols_goto_tag(const gchar *name, gboolean definition)
 }
 
 
+/* --- workspace "Go to Symbol" dialog --- */
+
+#define GOTO_SYMBOL_MAX_RESULTS 100
+#define GOTO_SYMBOL_MRU_LENGTH 20
+
+enum
+{
+	GOTO_SYMBOL_COLUMN_NAME,
+	GOTO_SYMBOL_COLUMN_LOCATION,
+	GOTO_SYMBOL_COLUMN_FILENAME,
+	GOTO_SYMBOL_COLUMN_LINE,
+	GOTO_SYMBOL_COLUMNS
+};
+
+typedef struct
+{
+	TMTag *tag;
+	gint score;
+} GotoSymbolMatch;
+
+static struct
+{
+	GtkWidget *dialog;
+	GtkWidget *entry;
+	GtkWidget *view;
+	GtkListStore *store;
+	TMWorkspaceSnapshot *snapshot;	/* keeps the searched tags alive while shown */
+	gchar *filter;		/* the query the current matches were computed for */
+	GPtrArray *matches;	/* tags matching filter, borrowed from the snapshot */
+	GQueue *mru;		/* names of recently activated symbols */
+} goto_symbol = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+
+/* Scores name against query as a case-insensitive subsequence match. Runs of
+ * consecutive matches and matches on word boundaries (name start, after an
+ * underscore or scope separator, camelCase hump) score higher. Returns -1 when
+ * query is not a subsequence of name. */
+static gint goto_symbol_match_score(const gchar *name, const gchar *query)
+{
+	const gchar *q = query;
+	gint score = 0;
+	gint run = 0;
+	gboolean boundary = TRUE;
+	gchar prev = '\0';
+
+	for (; *name != '\0' && *q != '\0'; prev = *name, name++)
+	{
+		if (g_ascii_tolower(*name) == g_ascii_tolower(*q))
+		{
+			score += 1 + 2 * run;
+			if (boundary || (g_ascii_isupper(*name) && g_ascii_islower(prev)))
+				score += 4;
+			run++;
+			q++;
+		}
+		else
+			run = 0;
+		boundary = (*name == '_' || *name == ':' || *name == '.' || *name == '-');
+	}
+	if (*q != '\0')
+		return -1;
+	/* penalize unmatched tail characters so tighter matches rank first */
+	return score - (gint) strlen(name) / 4;
+}
+
+
+/* Recently activated symbols get a bonus proportional to how recently they
+ * were used, so repeat jumps stay at the top of the list. */
+static gint goto_symbol_mru_bonus(const gchar *name)
+{
+	GList *node;
+	gint bonus = 2 * GOTO_SYMBOL_MRU_LENGTH;
+
+	if (goto_symbol.mru == NULL)
+		return 0;
+	for (node = goto_symbol.mru->head; node != NULL; node = node->next, bonus -= 2)
+	{
+		if (strcmp(node->data, name) == 0)
+			return bonus;
+	}
+	return 0;
+}
+
+
+static gint goto_symbol_match_compare(gconstpointer a, gconstpointer b)
+{
+	const GotoSymbolMatch *ma = a;
+	const GotoSymbolMatch *mb = b;
+
+	if (ma->score != mb->score)
+		return mb->score - ma->score;
+	return strcmp(ma->tag->name, mb->tag->name);
+}
+
+
+static void goto_symbol_remember(const gchar *name)
+{
+	GList *node;
+
+	if (goto_symbol.mru == NULL)
+		goto_symbol.mru = g_queue_new();
+	for (node = goto_symbol.mru->head; node != NULL; node = node->next)
+	{
+		if (strcmp(node->data, name) == 0)
+		{
+			g_free(node->data);
+			g_queue_delete_link(goto_symbol.mru, node);
+			break;
+		}
+	}
+	g_queue_push_head(goto_symbol.mru, g_strdup(name));
+	while (g_queue_get_length(goto_symbol.mru) > GOTO_SYMBOL_MRU_LENGTH)
+		g_free(g_queue_pop_tail(goto_symbol.mru));
+}
+
+
+static void goto_symbol_fill_store(GArray *ranked)
+{
+	guint i, count;
+
+	gtk_list_store_clear(goto_symbol.store);
+	count = MIN(ranked->len, GOTO_SYMBOL_MAX_RESULTS);
+	for (i = 0; i < count; i++)
+	{
+		GotoSymbolMatch *match = &g_array_index(ranked, GotoSymbolMatch, i);
+		TMTag *tag = match->tag;
+		const gchar *file_name = (tag->file != NULL) ? tag->file->file_name : "";
+		gchar *location = g_strdup_printf("%s:%u", file_name, tag->line);
+		GtkTreeIter iter;
+
+		gtk_list_store_append(goto_symbol.store, &iter);
+		gtk_list_store_set(goto_symbol.store, &iter,
+			GOTO_SYMBOL_COLUMN_NAME, tag->name,
+			GOTO_SYMBOL_COLUMN_LOCATION, location,
+			GOTO_SYMBOL_COLUMN_FILENAME, file_name,
+			GOTO_SYMBOL_COLUMN_LINE, (gint) tag->line,
+			-1);
+		g_free(location);
+	}
+	if (count > 0)
+	{	/* preselect the best match so Enter jumps straight to it */
+		GtkTreeIter iter;
+
+		gtk_tree_model_get_iter_first(GTK_TREE_MODEL(goto_symbol.store), &iter);
+		gtk_tree_selection_select_iter(
+			gtk_tree_view_get_selection(GTK_TREE_VIEW(goto_symbol.view)), &iter);
+	}
+}
+
+
+static void goto_symbol_refilter(void)
+{
+	const gchar *query;
+	GPtrArray *source;
+	GPtrArray *matches;
+	GArray *ranked;
+	guint i;
+
+	if (goto_symbol.snapshot == NULL)
+		return;
+
+	query = gtk_entry_get_text(GTK_ENTRY(goto_symbol.entry));
+	if (EMPTY(query))
+	{
+		gtk_list_store_clear(goto_symbol.store);
+		if (goto_symbol.matches != NULL)
+			g_ptr_array_free(goto_symbol.matches, TRUE);
+		goto_symbol.matches = NULL;
+		SETPTR(goto_symbol.filter, NULL);
+		return;
+	}
+
+	/* extending the query can only narrow the result set, so rescan just the
+	 * previous matches instead of the whole workspace */
+	if (goto_symbol.matches != NULL && !EMPTY(goto_symbol.filter) &&
+		g_str_has_prefix(query, goto_symbol.filter))
+		source = goto_symbol.matches;
+	else
+		source = goto_symbol.snapshot->tags_array;
+
+	matches = g_ptr_array_sized_new(1024);
+	ranked = g_array_sized_new(FALSE, FALSE, sizeof(GotoSymbolMatch), 1024);
+	for (i = 0; i < source->len; i++)
+	{
+		GotoSymbolMatch match;
+
+		match.tag = TM_TAG(source->pdata[i]);
+		match.score = goto_symbol_match_score(match.tag->name, query);
+		if (match.score < 0)
+			continue;
+		g_ptr_array_add(matches, match.tag);
+		match.score += goto_symbol_mru_bonus(match.tag->name);
+		g_array_append_val(ranked, match);
+	}
+	g_array_sort(ranked, goto_symbol_match_compare);
+	goto_symbol_fill_store(ranked);
+	g_array_free(ranked, TRUE);
+
+	if (goto_symbol.matches != NULL)
+		g_ptr_array_free(goto_symbol.matches, TRUE);
+	goto_symbol.matches = matches;
+	SETPTR(goto_symbol.filter, g_strdup(query));
+}
+
+
+static void goto_symbol_activate_selection(void)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(goto_symbol.store);
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(goto_symbol.view));
+	GtkTreeIter iter;
+	gchar *name, *file_name;
+	gint line;
+	GeanyDocument *old_doc, *new_doc;
+
+	if (! gtk_tree_selection_get_selected(selection, NULL, &iter) &&
+		! gtk_tree_model_get_iter_first(model, &iter))
+		return;
+
+	gtk_tree_model_get(model, &iter,
+		GOTO_SYMBOL_COLUMN_NAME, &name,
+		GOTO_SYMBOL_COLUMN_FILENAME, &file_name,
+		GOTO_SYMBOL_COLUMN_LINE, &line, -1);
+
+	old_doc = document_get_current();
+	new_doc = document_find_by_real_path(file_name);
+	if (new_doc == NULL)
+		new_doc = document_open_file(file_name, FALSE, NULL, NULL);
+
+	if (new_doc != NULL && navqueue_goto_line(old_doc, new_doc, line))
+	{
+		goto_symbol_remember(name);
+		gtk_widget_hide(goto_symbol.dialog);
+	}
+	else
+		utils_beep();
+
+	g_free(name);
+	g_free(file_name);
+}
+
+
+static void on_goto_symbol_entry_changed(G_GNUC_UNUSED GtkEditable *editable,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_symbol_refilter();
+}
+
+
+static void on_goto_symbol_entry_activate(G_GNUC_UNUSED GtkEntry *entry,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_symbol_activate_selection();
+}
+
+
+static void on_goto_symbol_row_activated(G_GNUC_UNUSED GtkTreeView *view,
+		G_GNUC_UNUSED GtkTreePath *path, G_GNUC_UNUSED GtkTreeViewColumn *column,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	goto_symbol_activate_selection();
+}
+
+
+static void on_goto_symbol_response(GtkWidget *dialog, gint response,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	if (response == GTK_RESPONSE_ACCEPT)
+		goto_symbol_activate_selection();
+	else
+		gtk_widget_hide(dialog);
+}
+
+
+/* drop the snapshot when the dialog goes away so the tags it references can
+ * be released; a fresh one is taken on every show */
+static void on_goto_symbol_hide(G_GNUC_UNUSED GtkWidget *widget,
+		G_GNUC_UNUSED gpointer user_data)
+{
+	if (goto_symbol.matches != NULL)
+	{
+		g_ptr_array_free(goto_symbol.matches, TRUE);
+		goto_symbol.matches = NULL;
+	}
+	if (goto_symbol.snapshot != NULL)
+	{
+		tm_workspace_snapshot_unref(goto_symbol.snapshot);
+		goto_symbol.snapshot = NULL;
+	}
+	gtk_list_store_clear(goto_symbol.store);
+}
+
+
+static void create_goto_symbol_dialog(void)
+{
+	GtkWidget *vbox, *scrolled;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	goto_symbol.dialog = gtk_dialog_new_with_buttons(_("Go to Symbol"),
+		GTK_WINDOW(main_widgets.window), GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE,
+		GTK_STOCK_JUMP_TO, GTK_RESPONSE_ACCEPT, NULL);
+	gtk_widget_set_name(goto_symbol.dialog, "GeanyDialog");
+	gtk_window_set_default_size(GTK_WINDOW(goto_symbol.dialog), 500, 350);
+	gtk_dialog_set_default_response(GTK_DIALOG(goto_symbol.dialog), GTK_RESPONSE_ACCEPT);
+
+	vbox = ui_dialog_vbox_new(GTK_DIALOG(goto_symbol.dialog));
+
+	goto_symbol.entry = gtk_entry_new();
+	gtk_box_pack_start(GTK_BOX(vbox), goto_symbol.entry, FALSE, FALSE, 0);
+
+	goto_symbol.store = gtk_list_store_new(GOTO_SYMBOL_COLUMNS,
+		G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT);
+	goto_symbol.view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(goto_symbol.store));
+	g_object_unref(goto_symbol.store);
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(goto_symbol.view), FALSE);
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("Symbol"), renderer,
+		"text", GOTO_SYMBOL_COLUMN_NAME, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_symbol.view), column);
+
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_START, NULL);
+	column = gtk_tree_view_column_new_with_attributes(_("Location"), renderer,
+		"text", GOTO_SYMBOL_COLUMN_LOCATION, NULL);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_symbol.view), column);
+
+	scrolled = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+		GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_container_add(GTK_CONTAINER(scrolled), goto_symbol.view);
+	gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+
+	g_signal_connect(goto_symbol.entry, "changed",
+		G_CALLBACK(on_goto_symbol_entry_changed), NULL);
+	g_signal_connect(goto_symbol.entry, "activate",
+		G_CALLBACK(on_goto_symbol_entry_activate), NULL);
+	g_signal_connect(goto_symbol.view, "row-activated",
+		G_CALLBACK(on_goto_symbol_row_activated), NULL);
+	g_signal_connect(goto_symbol.dialog, "response",
+		G_CALLBACK(on_goto_symbol_response), NULL);
+	g_signal_connect(goto_symbol.dialog, "hide",
+		G_CALLBACK(on_goto_symbol_hide), NULL);
+	g_signal_connect(goto_symbol.dialog, "delete-event",
+		G_CALLBACK(gtk_widget_hide_on_delete), NULL);
+}
+
+
+void symbols_show_goto_symbol_dialog(void)
+{
+	if (goto_symbol.dialog == NULL)
+		create_goto_symbol_dialog();
+
+	if (goto_symbol.snapshot != NULL)
+		tm_workspace_snapshot_unref(goto_symbol.snapshot);
+	goto_symbol.snapshot = tm_workspace_snapshot();
+	SETPTR(goto_symbol.filter, NULL);
+
+	gtk_entry_set_text(GTK_ENTRY(goto_symbol.entry), "");
+	gtk_list_store_clear(goto_symbol.store);
+	gtk_widget_show_all(goto_symbol.dialog);
+	gtk_widget_grab_focus(goto_symbol.entry);
+	gtk_window_present(GTK_WINDOW(goto_symbol.dialog));
+}
+
+
 /* This could perhaps be improved to check for #if, class etc. */
 static gint get_function_fold_number(GeanyDocument *doc)
 {
@@ -2419,6 +2931,17 @@ static void on_document_save(G_GNUC_UNUSED GObject *object, GeanyDocument *doc)
 }
 
 
+/* Another instance may have regenerated a shared compiled global tags file while
+ * we were in the background; recheck the file mtimes when the window regains
+ * focus so all instances pick up the new tags (and drop their stale mapping). */
+static gboolean on_window_focus_in(GtkWidget *widget, GdkEventFocus *event, gpointer user_data)
+{
+	if (tm_workspace_refresh_global_tags())
+		geany_debug("Reloaded regenerated global tags file(s).");
+	return FALSE;
+}
+
+
 void symbols_init(void)
 {
 	gchar *f;
@@ -2430,6 +2953,8 @@ void symbols_init(void)
 	g_free(f);
 
 	g_signal_connect(geany_object, "document-save", G_CALLBACK(on_document_save), NULL);
+	g_signal_connect(main_widgets.window, "focus-in-event",
+		G_CALLBACK(on_window_focus_in), NULL);
 }
 
 
@@ -2437,4 +2962,15 @@ void symbols_finalize(void)
 {
 	g_strfreev(html_entities);
 	g_strfreev(c_tags_ignore);
+
+	if (goto_symbol.matches != NULL)
+		g_ptr_array_free(goto_symbol.matches, TRUE);
+	if (goto_symbol.snapshot != NULL)
+		tm_workspace_snapshot_unref(goto_symbol.snapshot);
+	if (goto_symbol.mru != NULL)
+	{
+		g_queue_foreach(goto_symbol.mru, (GFunc) g_free, NULL);
+		g_queue_free(goto_symbol.mru);
+	}
+	g_free(goto_symbol.filter);
 }
@@ -24,6 +24,7 @@
 #define GEANY_SYMBOLS_H 1
 
 #include "document.h"
+#include "tm_tag.h" /* for TMTag */
 
 #include <glib.h>
 
@@ -54,6 +55,8 @@ GString *symbols_find_typenames_as_string(gint lang, gboolean global);
 
 const GList *symbols_get_tag_list(GeanyDocument *doc, guint tag_types);
 
+gchar *symbols_get_tag_tooltip(GeanyDocument *doc, const TMTag *tag);
+
 GString *symbols_get_macro_list(gint lang);
 
 const gchar **symbols_get_html_entities(void);
@@ -64,6 +67,8 @@ gint symbols_generate_global_tags(gint argc, gchar **argv, gboolean want_preproc
 
 void symbols_show_load_tags_dialog(void);
 
+void symbols_show_goto_symbol_dialog(void);
+
 gboolean symbols_goto_tag(const gchar *name, gboolean definition);
 
 gint symbols_get_current_function(GeanyDocument *doc, const gchar **tagname);
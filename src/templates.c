@@ -554,15 +554,63 @@ void templates_free_templates(void)
 }
 
 
+/* Replaces all {wildcard} occurrences found in the wildcard -> value table in a single
+ * left to right walk over the template instead of one utils_string_replace_all() scan per
+ * wildcard. Tokens not in the table are left untouched so later passes (e.g. {command:...}
+ * and the final {ob}/{cb} escape) and literal braces in template text still work, and
+ * replacement values are never rescanned. */
+static void templates_replace_from_table(GString *text, GHashTable *values)
+{
+	gint pos = 0;
+	gchar *open;
+
+	while ((open = strchr(text->str + pos, '{')) != NULL)
+	{
+		gchar *close = strchr(open + 1, '}');
+		gchar *next_open = strchr(open + 1, '{');
+		gchar *key;
+		gpointer value;
+
+		pos = (gint) (open - text->str);
+		if (close == NULL)
+			break;
+		if (next_open != NULL && next_open < close)
+		{	/* a lone brace, e.g. in code templates; the wildcard starts later */
+			pos = (gint) (next_open - text->str);
+			continue;
+		}
+
+		key = g_strndup(open, (gsize) (close - open + 1));
+		if (g_hash_table_lookup_extended(values, key, NULL, &value))
+			pos = utils_string_replace(text, pos, (gint) (close - open + 1), value);
+		else
+			pos = (gint) (close - text->str) + 1;
+		g_free(key);
+	}
+}
+
+
+/* static template wildcards (version, mail, company, name, ...); the table does not own
+ * the keys or the values */
+static void add_static_values(GHashTable *values)
+{
+	g_hash_table_insert(values, (gpointer) "{version}", template_prefs.version);
+	g_hash_table_insert(values, (gpointer) "{initial}", template_prefs.initials);
+	g_hash_table_insert(values, (gpointer) "{developer}", template_prefs.developer);
+	g_hash_table_insert(values, (gpointer) "{mail}", template_prefs.mail);
+	g_hash_table_insert(values, (gpointer) "{company}", template_prefs.company);
+	g_hash_table_insert(values, (gpointer) "{untitled}", (gpointer) GEANY_STRING_UNTITLED);
+	g_hash_table_insert(values, (gpointer) "{geanyversion}", (gpointer) "Geany " VERSION);
+}
+
+
 static void replace_static_values(GString *text)
 {
-	utils_string_replace_all(text, "{version}", template_prefs.version);
-	utils_string_replace_all(text, "{initial}", template_prefs.initials);
-	utils_string_replace_all(text, "{developer}", template_prefs.developer);
-	utils_string_replace_all(text, "{mail}", template_prefs.mail);
-	utils_string_replace_all(text, "{company}", template_prefs.company);
-	utils_string_replace_all(text, "{untitled}", GEANY_STRING_UNTITLED);
-	utils_string_replace_all(text, "{geanyversion}", "Geany " VERSION);
+	GHashTable *values = g_hash_table_new(g_str_hash, g_str_equal);
+
+	add_static_values(values);
+	templates_replace_from_table(text, values);
+	g_hash_table_destroy(values);
 }
 
 
@@ -577,26 +625,26 @@ void templates_replace_valist(GString *text, const gchar *first_wildcard, ...)
 {
 	va_list args;
 	const gchar *key, *value;
+	GHashTable *values;
 
 	g_return_if_fail(text != NULL);
 
-	va_start(args, first_wildcard);
+	values = g_hash_table_new(g_str_hash, g_str_equal);
 
+	va_start(args, first_wildcard);
 	key = first_wildcard;
-	value = va_arg(args, gchar*);
-
 	while (key != NULL)
 	{
-		utils_string_replace_all(text, key, value);
-
-		key = va_arg(args, gchar*);
-		if (key == NULL || text == NULL)
-			break;
 		value = va_arg(args, gchar*);
+		g_hash_table_insert(values, (gpointer) key, (gpointer) value);
+		key = va_arg(args, gchar*);
 	}
 	va_end(args);
 
-	replace_static_values(text);
+	add_static_values(values);
+	/* passed wildcards and static values are substituted in one pass over the text */
+	templates_replace_from_table(text, values);
+	g_hash_table_destroy(values);
 }
 
 
@@ -1040,3 +1040,120 @@ void tools_color_chooser(const gchar *color)
 	/* We make sure the dialog is visible. */
 	gtk_window_present(GTK_WINDOW(ui_widgets.open_colorsel));
 }
+
+
+/* --- symbol index rebuild ---
+ *
+ * Queues a fresh background parse for every open document, a few documents
+ * per main loop iteration so taking the buffer snapshots does not freeze the
+ * UI. The parses themselves run on the tag manager's worker thread, and the
+ * tag manager publishes the rebuilt workspace arrays once per burst of
+ * results (see tm_workspace.c), so index readers never see a half-rebuilt
+ * workspace. */
+
+typedef struct
+{
+	GtkWidget *dialog;
+	GtkWidget *progress;
+	GPtrArray *docs;	/* documents still waiting to be queued */
+	guint next;
+	guint source;		/* idle source driving the time slices */
+} ReindexData;
+
+static ReindexData *reindex = NULL;
+
+
+static void reindex_free(void)
+{
+	ReindexData *data = reindex;
+
+	/* clear the global first: destroying the dialog below must not re-enter
+	 * through the response handler */
+	reindex = NULL;
+	if (data->source != 0)
+		g_source_remove(data->source);
+	gtk_widget_destroy(data->dialog);
+	g_ptr_array_free(data->docs, TRUE);
+	g_free(data);
+}
+
+
+static gboolean reindex_idle(gpointer data)
+{
+	GTimeVal start, now;
+
+	g_get_current_time(&start);
+	while (reindex->next < reindex->docs->len)
+	{
+		GeanyDocument *doc = g_ptr_array_index(reindex->docs, reindex->next);
+		gchar *text;
+		glong elapsed;
+
+		reindex->next++;
+		/* the document may have been closed since the rebuild started */
+		if (DOC_VALID(doc))
+			document_update_tags(doc);
+
+		text = g_strdup_printf(_("%u of %u files"), reindex->next, reindex->docs->len);
+		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(reindex->progress),
+			(gdouble) reindex->next / reindex->docs->len);
+		gtk_progress_bar_set_text(GTK_PROGRESS_BAR(reindex->progress), text);
+		g_free(text);
+
+		g_get_current_time(&now);
+		elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_usec - start.tv_usec) / 1000;
+		if (elapsed >= 10)
+			return TRUE;
+	}
+
+	ui_set_statusbar(FALSE, _("Symbol index rebuild: %u files queued for reparsing."),
+		reindex->next);
+	reindex->source = 0;
+	reindex_free();
+	return FALSE;
+}
+
+
+static void on_reindex_response(GtkDialog *dialog, gint response, gpointer user_data)
+{
+	if (reindex == NULL)
+		return;
+	ui_set_statusbar(FALSE, _("Symbol index rebuild cancelled."));
+	reindex_free();
+}
+
+
+void tools_rebuild_symbol_index(void)
+{
+	GtkWidget *vbox, *label;
+	guint i;
+
+	if (reindex != NULL)
+	{
+		gtk_window_present(GTK_WINDOW(reindex->dialog));
+		return;
+	}
+
+	reindex = g_new0(ReindexData, 1);
+	reindex->docs = g_ptr_array_new();
+	foreach_document(i)
+		g_ptr_array_add(reindex->docs, documents[i]);
+
+	reindex->dialog = gtk_dialog_new_with_buttons(_("Rebuild Symbol Index"),
+		GTK_WINDOW(main_widgets.window), GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL, NULL);
+	gtk_widget_set_name(reindex->dialog, "GeanyDialog");
+	vbox = ui_dialog_vbox_new(GTK_DIALOG(reindex->dialog));
+
+	label = gtk_label_new(_("Reparsing the symbols of all open files..."));
+	gtk_misc_set_alignment(GTK_MISC(label), 0, 0.5);
+	gtk_box_pack_start(GTK_BOX(vbox), label, FALSE, FALSE, 0);
+
+	reindex->progress = gtk_progress_bar_new();
+	gtk_box_pack_start(GTK_BOX(vbox), reindex->progress, FALSE, FALSE, 0);
+
+	g_signal_connect(reindex->dialog, "response", G_CALLBACK(on_reindex_response), NULL);
+	gtk_widget_show_all(reindex->dialog);
+
+	reindex->source = g_idle_add(reindex_idle, NULL);
+}
@@ -37,6 +37,8 @@ void tools_word_count(void);
 
 void tools_color_chooser(const gchar *color);
 
+void tools_rebuild_symbol_index(void);
+
 G_END_DECLS
 
 #endif /* GEANY_TOOLS_H */
@@ -0,0 +1,242 @@
+/*
+ *      trace.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Ring-buffered trace events for stall forensics.
+ *
+ * Every timed probe that goes through stats_time_since() is also recorded
+ * here as a scoped event, so the existing counters double as a timeline of
+ * what the process was doing. The ring keeps the most recent events only;
+ * trace_dump() writes them out in the Chrome trace-event JSON format
+ * (chrome://tracing, or any trace-event viewer), which turns a "Geany froze
+ * for 3 seconds" report into a profile of those 3 seconds.
+ *
+ * A dump is triggered together with the counter dump on SIGUSR2 (see
+ * stats.c), and automatically by the main loop watchdog below: a heartbeat
+ * timeout measures its own lateness, and when it fires more than
+ * TRACE_STALL_LIMIT_MS after the previous beat, the main loop was blocked
+ * for that long and the buffer is written out while the culprit events are
+ * still in it. (A system suspend also delays the heartbeat and then causes
+ * one spurious dump on resume; that is harmless and not worth detecting.)
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "trace.h"
+
+#include "app.h"
+#include "geany.h" /* geany_debug() */
+
+#include <string.h>
+
+
+/* about 8k events; at the probe density of the core modules this covers
+ * minutes of normal use, or comfortably more than one UI stall */
+#define TRACE_RING_SIZE 8192
+
+/* heartbeat interval of the main loop watchdog and the lateness above which
+ * the heartbeat treats itself as having been stalled */
+#define TRACE_HEARTBEAT_MS 100
+#define TRACE_STALL_LIMIT_MS 500
+
+typedef struct
+{
+	const gchar	*name;		/* string literal, not copied */
+	gint64		start;		/* microseconds since trace_init() */
+	gint64		duration;	/* microseconds */
+	gpointer	thread;		/* g_thread_self() of the emitting thread */
+} TraceEvent;
+
+/* same locking rationale as stats.c: the probes run at user interaction
+ * rate, so a plain mutex is never contended for measurable time */
+static GStaticMutex trace_mutex = G_STATIC_MUTEX_INIT;
+static TraceEvent *trace_ring = NULL;
+static guint trace_next = 0;		/* next slot to overwrite */
+static gboolean trace_wrapped = FALSE;
+static GTimeVal trace_epoch;
+
+static guint heartbeat_source = 0;
+static gint64 heartbeat_usec = 0;	/* time of the previous beat, main thread only */
+
+
+/* microseconds since trace_init() */
+static gint64 trace_now(void)
+{
+	GTimeVal now;
+
+	g_get_current_time(&now);
+	return (now.tv_sec - trace_epoch.tv_sec) * G_GINT64_CONSTANT(1000000) +
+		(now.tv_usec - trace_epoch.tv_usec);
+}
+
+
+void trace_add(const gchar *name, const GTimeVal *start)
+{
+	gint64 start_usec, duration;
+	TraceEvent *event;
+
+	if (trace_ring == NULL)
+		return;
+
+	start_usec = (start->tv_sec - trace_epoch.tv_sec) * G_GINT64_CONSTANT(1000000) +
+		(start->tv_usec - trace_epoch.tv_usec);
+	duration = trace_now() - start_usec;
+	if (duration < 0)
+		duration = 0;
+
+	g_static_mutex_lock(&trace_mutex);
+	if (trace_ring == NULL)	/* finalized since the check above (worker thread) */
+	{
+		g_static_mutex_unlock(&trace_mutex);
+		return;
+	}
+	event = &trace_ring[trace_next];
+	event->name = name;
+	event->start = start_usec;
+	event->duration = duration;
+	event->thread = g_thread_self();
+	trace_next++;
+	if (trace_next == TRACE_RING_SIZE)
+	{
+		trace_next = 0;
+		trace_wrapped = TRUE;
+	}
+	g_static_mutex_unlock(&trace_mutex);
+}
+
+
+gchar *trace_dump(void)
+{
+	TraceEvent *events;
+	guint count, first, i;
+	GString *out;
+	GPtrArray *threads;
+	gchar *filename;
+
+	if (trace_ring == NULL)
+		return NULL;
+
+	/* snapshot under the lock, format afterwards */
+	events = g_new(TraceEvent, TRACE_RING_SIZE);
+	g_static_mutex_lock(&trace_mutex);
+	memcpy(events, trace_ring, TRACE_RING_SIZE * sizeof(TraceEvent));
+	count = trace_wrapped ? TRACE_RING_SIZE : trace_next;
+	first = trace_wrapped ? trace_next : 0;
+	g_static_mutex_unlock(&trace_mutex);
+
+	if (count == 0)
+	{
+		g_free(events);
+		return NULL;
+	}
+
+	/* threads are numbered in order of first appearance */
+	threads = g_ptr_array_new();
+	out = g_string_sized_new(count * 64);
+	g_string_append(out, "{\"traceEvents\":[\n");
+	for (i = 0; i < count; i++)
+	{
+		TraceEvent *event = &events[(first + i) % TRACE_RING_SIZE];
+		guint tid;
+
+		for (tid = 0; tid < threads->len; tid++)
+		{
+			if (g_ptr_array_index(threads, tid) == event->thread)
+				break;
+		}
+		if (tid == threads->len)
+			g_ptr_array_add(threads, event->thread);
+
+		g_string_append_printf(out,
+			"{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+			",\"dur\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%u}%s\n",
+			event->name, event->start, event->duration, tid + 1,
+			i + 1 < count ? "," : "");
+	}
+	g_string_append(out, "]}\n");
+	g_ptr_array_free(threads, TRUE);
+	g_free(events);
+
+	/* a fixed name, overwritten by each dump: after a freeze the newest
+	 * profile is the one that matters */
+	filename = g_build_filename(app->configdir, "trace.json", NULL);
+	if (! g_file_set_contents(filename, out->str, out->len, NULL))
+	{
+		g_free(filename);
+		filename = NULL;
+	}
+	g_string_free(out, TRUE);
+	return filename;
+}
+
+
+/* The heartbeat measures its own lateness: a 100ms timeout that fires
+ * seconds late means the main loop was blocked in between, and the events
+ * of the blocking work have just been added to the ring. */
+static gboolean trace_heartbeat(gpointer data)
+{
+	gint64 now = trace_now();
+	gint64 gap = now - heartbeat_usec;
+
+	if (heartbeat_usec > 0 && gap > TRACE_STALL_LIMIT_MS * G_GINT64_CONSTANT(1000))
+	{
+		GTimeVal stall_start = trace_epoch;
+		gchar *filename;
+
+		/* record the stall itself so it shows up in the timeline */
+		stall_start.tv_sec += (glong) (heartbeat_usec / G_GINT64_CONSTANT(1000000));
+		stall_start.tv_usec += (glong) (heartbeat_usec % G_GINT64_CONSTANT(1000000));
+		trace_add("main-loop.stall", &stall_start);
+
+		filename = trace_dump();
+		if (filename != NULL)
+		{
+			geany_debug("main loop stalled for %ld ms, trace written to %s",
+				(glong) (gap / 1000), filename);
+			g_free(filename);
+		}
+	}
+	heartbeat_usec = now;
+	return TRUE;
+}
+
+
+void trace_init(void)
+{
+	g_get_current_time(&trace_epoch);
+	trace_ring = g_new0(TraceEvent, TRACE_RING_SIZE);
+	heartbeat_source = g_timeout_add(TRACE_HEARTBEAT_MS, trace_heartbeat, NULL);
+}
+
+
+void trace_finalize(void)
+{
+	if (heartbeat_source != 0)
+	{
+		g_source_remove(heartbeat_source);
+		heartbeat_source = 0;
+	}
+	g_static_mutex_lock(&trace_mutex);
+	g_free(trace_ring);
+	trace_ring = NULL;
+	g_static_mutex_unlock(&trace_mutex);
+}
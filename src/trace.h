@@ -0,0 +1,44 @@
+/*
+ *      trace.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_TRACE_H
+#define GEANY_TRACE_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void trace_init(void);
+
+void trace_finalize(void);
+
+/* Records a trace event named @a name covering the time from @a start until
+ * now. @a name must be a string literal (it is stored without copying) and
+ * must not contain characters that need JSON escaping. */
+void trace_add(const gchar *name, const GTimeVal *start);
+
+/* Writes the buffered events as Chrome trace-event JSON and returns the
+ * newly allocated path of the written file, or NULL when there is nothing
+ * to dump or the file cannot be written. */
+gchar *trace_dump(void);
+
+G_END_DECLS
+
+#endif /* GEANY_TRACE_H */
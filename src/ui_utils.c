@@ -111,6 +111,7 @@ typedef struct
 	GtkWidget *menubar;
 	GtkWidget *toolbar;
 	void (*activate_cb)(GtkMenuItem *, gpointer);
+	gboolean dirty;	/* the menus no longer match recent_queue */
 } GeanyRecentFiles;
 
 
@@ -166,25 +167,27 @@ static void set_statusbar(const gchar *text, gboolean allow_override)
  * @param format A @c printf -style string. */
 void ui_set_statusbar(gboolean log, const gchar *format, ...)
 {
-	gchar *string;
+	GString *string = utils_scratch_string_acquire();
 	va_list args;
 
 	va_start(args, format);
-	string = g_strdup_vprintf(format, args);
+	g_string_vprintf(string, format, args);
 	va_end(args);
 
 	if (! prefs.suppress_status_messages)
-		set_statusbar(string, FALSE);
+		set_statusbar(string->str, FALSE);
 
 	if (log || prefs.suppress_status_messages)
-		msgwin_status_add("%s", string);
+		msgwin_status_add("%s", string->str);
 
-	g_free(string);
+	utils_scratch_string_release(string);
 }
 
 
+/* the returned string comes from the scratch pool and must be released by the
+ * caller with utils_scratch_string_release() */
 /* note: some comments below are for translators */
-static gchar *create_statusbar_statistics(GeanyDocument *doc,
+static GString *create_statusbar_statistics(GeanyDocument *doc,
 	guint line, guint col, guint pos)
 {
 	const gchar *cur_tag;
@@ -199,7 +202,7 @@ static gchar *create_statusbar_statistics(GeanyDocument *doc,
 	else
 		fmt = _(DEFAULT_STATUSBAR_TEMPLATE);
 
-	stats_str = g_string_sized_new(120);
+	stats_str = utils_scratch_string_acquire();
 
 	while ((expos = strchr(fmt, '%')) != NULL)
 	{
@@ -311,25 +314,34 @@ static gchar *create_statusbar_statistics(GeanyDocument *doc,
 	/* add any remaining text */
 	g_string_append(stats_str, fmt);
 
-	return g_string_free(stats_str, FALSE);
+	return stats_str;
 }
 
 
-/* updates the status bar document statistics */
-void ui_update_statusbar(GeanyDocument *doc, gint pos)
+/* ~30Hz is enough for the eye and far below the rate of caret move
+ * notifications during fast scrolling */
+#define STATUSBAR_UPDATE_INTERVAL 33
+
+static guint statusbar_timeout_id = 0;
+static GeanyDocument *statusbar_doc = NULL;
+static gint statusbar_pos = -1;
+
+
+static gboolean statusbar_update_timeout(G_GNUC_UNUSED gpointer data)
 {
-	g_return_if_fail(doc == NULL || doc->is_valid);
+	static gchar *last_stats_str = NULL;
+	GeanyDocument *doc = statusbar_doc;
+	gint pos = statusbar_pos;
 
-	if (! interface_prefs.statusbar_visible)
-		return; /* just do nothing if statusbar is not visible */
+	statusbar_timeout_id = 0;
 
-	if (doc == NULL)
+	if (doc == NULL || ! doc->is_valid)
 		doc = document_get_current();
 
 	if (doc != NULL)
 	{
 		guint line, col;
-		gchar *stats_str;
+		GString *stats_str;
 
 		if (pos == -1)
 			pos = sci_get_current_position(doc->editor->sci);
@@ -345,14 +357,40 @@ void ui_update_statusbar(GeanyDocument *doc, gint pos)
 
 		stats_str = create_statusbar_statistics(doc, line, col, pos);
 
-		/* can be overridden by status messages */
-		set_statusbar(stats_str, TRUE);
-		g_free(stats_str);
+		/* skip the pop/push and the Pango relayout it triggers when nothing
+		 * in the computed string actually changed */
+		if (! utils_str_equal(stats_str->str, last_stats_str))
+		{
+			/* can be overridden by status messages */
+			set_statusbar(stats_str->str, TRUE);
+			SETPTR(last_stats_str, g_strdup(stats_str->str));
+		}
+		utils_scratch_string_release(stats_str);
 	}
 	else	/* no documents */
 	{
 		set_statusbar("", TRUE);	/* can be overridden by status messages */
+		SETPTR(last_stats_str, g_strdup(""));
 	}
+	return FALSE;
+}
+
+
+/* updates the status bar document statistics */
+void ui_update_statusbar(GeanyDocument *doc, gint pos)
+{
+	g_return_if_fail(doc == NULL || doc->is_valid);
+
+	if (! interface_prefs.statusbar_visible)
+		return; /* just do nothing if statusbar is not visible */
+
+	/* coalesce bursts of updates (one arrives per caret move notification)
+	 * into a single rebuild on a short timer */
+	statusbar_doc = doc;
+	statusbar_pos = pos;
+	if (statusbar_timeout_id == 0)
+		statusbar_timeout_id = g_timeout_add(STATUSBAR_UPDATE_INTERVAL,
+			statusbar_update_timeout, NULL);
 }
 
 
@@ -367,7 +405,7 @@ void ui_set_window_title(GeanyDocument *doc)
 	if (doc == NULL)
 		doc = document_get_current();
 
-	str = g_string_new(NULL);
+	str = utils_scratch_string_acquire();
 
 	if (doc != NULL)
 	{
@@ -400,7 +438,7 @@ void ui_set_window_title(GeanyDocument *doc)
 		g_string_append(str, _(" (new instance)"));
 	}
 	gtk_window_set_title(GTK_WINDOW(main_widgets.window), str->str);
-	g_string_free(str, TRUE);
+	utils_scratch_string_release(str);
 }
 
 
@@ -418,12 +456,17 @@ void ui_set_editor_font(const gchar *font_name)
 	g_free(interface_prefs.editor_font);
 	interface_prefs.editor_font = g_strdup(font_name);
 
-	/* We copy the current style, and update the font in all open tabs. */
+	/* Update the current document immediately; background tabs only get
+	 * flagged and pick the font up right before their next draw, so changing
+	 * the font does not restyle and re-measure every open tab at once. */
 	for (i = 0; i < documents_array->len; i++)
 	{
 		if (documents[i]->editor)
 		{
-			editor_set_font(documents[i]->editor, interface_prefs.editor_font);
+			if (documents[i] == document_get_current())
+				editor_set_font(documents[i]->editor, interface_prefs.editor_font);
+			else
+				documents[i]->priv->font_needed = TRUE;
 		}
 	}
 
@@ -1095,36 +1138,77 @@ void ui_set_search_entry_background(GtkWidget *widget, gboolean success)
 }
 
 
-static void recent_create_menu(GeanyRecentFiles *grf)
+/* Brings one menu in line with the queue, reusing the already created menu
+ * items as a pool: existing items are relabelled in place and only the
+ * difference in length is created or destroyed. */
+static void recent_sync_menu(GeanyRecentFiles *grf, GtkWidget *menu)
 {
-	GtkWidget *tmp;
+	GList *children, *child;
 	guint i, len;
-	gchar *filename;
 
 	len = MIN(file_prefs.mru_length, g_queue_get_length(grf->recent_queue));
+	children = gtk_container_get_children(GTK_CONTAINER(menu));
+	child = children;
 	for (i = 0; i < len; i++)
 	{
-		filename = g_queue_peek_nth(grf->recent_queue, i);
-		/* create menu item for the recent files menu in the menu bar */
-		tmp = gtk_menu_item_new_with_label(filename);
-		gtk_widget_show(tmp);
-		gtk_container_add(GTK_CONTAINER(grf->menubar), tmp);
-		g_signal_connect(tmp, "activate", G_CALLBACK(grf->activate_cb), NULL);
-		/* create menu item for the recent files menu in the toolbar */
-		if (grf->toolbar != NULL)
+		const gchar *filename = g_queue_peek_nth(grf->recent_queue, i);
+
+		if (child != NULL)
 		{
-			tmp = gtk_menu_item_new_with_label(filename);
+			gtk_menu_item_set_label(GTK_MENU_ITEM(child->data), filename);
+			gtk_widget_set_sensitive(child->data, TRUE);
+			child = child->next;
+		}
+		else
+		{
+			GtkWidget *tmp = gtk_menu_item_new_with_label(filename);
+
 			gtk_widget_show(tmp);
-			gtk_container_add(GTK_CONTAINER(grf->toolbar), tmp);
+			/* gtk_container_add() rather than gtk_menu_shell_append() for the
+			 * toolbar menu: GeanyMenubuttonAction needs GtkContainer's "add"
+			 * signal, which the menu shell functions do not emit */
+			gtk_container_add(GTK_CONTAINER(menu), tmp);
 			g_signal_connect(tmp, "activate", G_CALLBACK(grf->activate_cb), NULL);
 		}
 	}
+	/* pooled items beyond the queue, e.g. after shrinking the MRU length */
+	for (; child != NULL; child = child->next)
+		gtk_widget_destroy(child->data);
+	g_list_free(children);
+}
+
+
+/* builds the menus only when one is about to be shown, so MRU changes from
+ * opening and closing files just flag them stale */
+static void on_recent_menu_show(GtkWidget *menu, gpointer user_data)
+{
+	GeanyRecentFiles *grf = user_data;
+
+	if (grf->dirty)
+	{
+		if (grf->menubar != NULL)
+			recent_sync_menu(grf, grf->menubar);
+		if (grf->toolbar != NULL)
+			recent_sync_menu(grf, grf->toolbar);
+		grf->dirty = FALSE;
+		if (grf->type == RECENT_FILE_PROJECT)
+			ui_update_recent_project_menu();
+	}
+}
+
+
+static void recent_create_menu(GeanyRecentFiles *grf)
+{
+	if (grf->menubar != NULL)
+		g_signal_connect(grf->menubar, "show", G_CALLBACK(on_recent_menu_show), grf);
+	if (grf->toolbar != NULL)
+		g_signal_connect(grf->toolbar, "show", G_CALLBACK(on_recent_menu_show), grf);
 }
 
 
 static GeanyRecentFiles *recent_get_recent_files(void)
 {
-	static GeanyRecentFiles grf = { RECENT_FILE_FILE, NULL, NULL, NULL, NULL };
+	static GeanyRecentFiles grf = { RECENT_FILE_FILE, NULL, NULL, NULL, NULL, TRUE };
 
 	if (G_UNLIKELY(grf.recent_queue == NULL))
 	{
@@ -1140,7 +1224,7 @@ static GeanyRecentFiles *recent_get_recent_files(void)
 
 static GeanyRecentFiles *recent_get_recent_projects(void)
 {
-	static GeanyRecentFiles grf = { RECENT_FILE_PROJECT, NULL, NULL, NULL, NULL };
+	static GeanyRecentFiles grf = { RECENT_FILE_PROJECT, NULL, NULL, NULL, NULL, TRUE };
 
 	if (G_UNLIKELY(grf.recent_queue == NULL))
 	{
@@ -1208,6 +1292,7 @@ static void add_recent_file(const gchar *utf8_filename, GeanyRecentFiles *grf,
 		{
 			g_free(g_queue_pop_tail(grf->recent_queue));
 		}
+		configuration_journal_recent_file(utf8_filename, grf->type == RECENT_FILE_PROJECT);
 		update_recent_menu(grf);
 	}
 	/* filename already in recent list */
@@ -1264,21 +1349,6 @@ gchar *ui_menu_item_get_text(GtkMenuItem *menu_item)
 }
 
 
-static gint find_recent_file_item(gconstpointer list_data, gconstpointer user_data)
-{
-	gchar *menu_text = ui_menu_item_get_text(GTK_MENU_ITEM(list_data));
-	gint result;
-
-	if (utils_str_equal(menu_text, user_data))
-		result = 0;
-	else
-		result = 1;
-
-	g_free(menu_text);
-	return result;
-}
-
-
 /* update the project menu item's sensitivity */
 void ui_update_recent_project_menu(void)
 {
@@ -1302,92 +1372,26 @@ void ui_update_recent_project_menu(void)
 }
 
 
-static void add_recent_file_menu_item(const gchar *utf8_filename, GeanyRecentFiles *grf, GtkWidget *menu)
-{
-	GtkWidget *child = gtk_menu_item_new_with_label(utf8_filename);
-
-	gtk_widget_show(child);
-	if (menu != grf->toolbar)
-		gtk_menu_shell_prepend(GTK_MENU_SHELL(menu), child);
-	else
-	{
-		/* this is a bit ugly, but we need to use gtk_container_add(). Using
-		 * gtk_menu_shell_prepend() doesn't emit GtkContainer's "add" signal
-		 * which we need in GeanyMenubuttonAction */
-		gtk_container_add(GTK_CONTAINER(menu), child);
-		gtk_menu_reorder_child(GTK_MENU(menu), child, 0);
-	}
-	g_signal_connect(child, "activate", G_CALLBACK(grf->activate_cb), NULL);
-}
-
-
 static void recent_file_loaded(const gchar *utf8_filename, GeanyRecentFiles *grf)
 {
 	GList *item;
-	GtkWidget *parents[] = { grf->menubar, grf->toolbar };
-	guint i;
 
-	/* first reorder the queue */
+	/* reorder the queue; the menus follow when they are next shown */
 	item = g_queue_find_custom(grf->recent_queue, utf8_filename, (GCompareFunc) strcmp);
 	g_return_if_fail(item != NULL);
 
 	g_queue_unlink(grf->recent_queue, item);
 	g_queue_push_head_link(grf->recent_queue, item);
 
-	for (i = 0; i < G_N_ELEMENTS(parents); i++)
-	{
-		GList *children;
-
-		if (! parents[i])
-			continue;
-
-		children = gtk_container_get_children(GTK_CONTAINER(parents[i]));
-		item = g_list_find_custom(children, utf8_filename, (GCompareFunc) find_recent_file_item);
-		/* either reorder or prepend a new one */
-		if (item)
-			gtk_menu_reorder_child(GTK_MENU(parents[i]), item->data, 0);
-		else
-			add_recent_file_menu_item(utf8_filename, grf, parents[i]);
-		g_list_free(children);
-	}
-
-	if (grf->type == RECENT_FILE_PROJECT)
-		ui_update_recent_project_menu();
+	configuration_journal_recent_file(utf8_filename, grf->type == RECENT_FILE_PROJECT);
+	update_recent_menu(grf);
 }
 
 
 static void update_recent_menu(GeanyRecentFiles *grf)
 {
-	gchar *filename;
-	GtkWidget *parents[] = { grf->menubar, grf->toolbar };
-	guint i;
-
-	filename = g_queue_peek_head(grf->recent_queue);
-
-	for (i = 0; i < G_N_ELEMENTS(parents); i++)
-	{
-		GList *children;
-
-		if (! parents[i])
-			continue;
-
-		/* clean the MRU list before adding an item */
-		children = gtk_container_get_children(GTK_CONTAINER(parents[i]));
-		if (g_list_length(children) > file_prefs.mru_length - 1)
-		{
-			GList *item = g_list_nth(children, file_prefs.mru_length - 1);
-			while (item != NULL)
-			{
-				if (GTK_IS_MENU_ITEM(item->data))
-					gtk_widget_destroy(GTK_WIDGET(item->data));
-				item = g_list_next(item);
-			}
-		}
-		g_list_free(children);
-
-		/* create the new item */
-		add_recent_file_menu_item(filename, grf, parents[i]);
-	}
+	/* the menus are rebuilt when they are next shown */
+	grf->dirty = TRUE;
 
 	if (grf->type == RECENT_FILE_PROJECT)
 		ui_update_recent_project_menu();
@@ -2987,6 +2991,7 @@ GtkWidget *ui_create_encodings_combo_box(gboolean has_detect, gint default_enc)
 	gtk_combo_box_set_model(GTK_COMBO_BOX(combo), GTK_TREE_MODEL(store));
 	if (encodings_encoding_store_get_iter(store, &iter, default_enc))
 		gtk_combo_box_set_active_iter(GTK_COMBO_BOX(combo), &iter);
+	g_object_unref(store);	/* the combo box holds its own reference */
 	renderer = gtk_cell_renderer_text_new();
 	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(combo), renderer, TRUE);
 	gtk_cell_layout_set_cell_data_func(GTK_CELL_LAYOUT(combo), renderer,
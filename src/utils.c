@@ -57,6 +57,10 @@
 #include <glib/gstdio.h>
 #include <gio/gio.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 
 /**
  *  Tries to open the given URI in a browser.
@@ -102,45 +106,126 @@ void utils_open_browser(const gchar *uri)
 }
 
 
-/* taken from anjuta, to determine the EOL mode of the file */
-gint utils_get_line_endings(const gchar* buffer, gsize size)
+/* a word with the lowest bit of each byte set, and one with the highest bit of each
+ * byte set, regardless of the word width */
+#define UTILS_LOW_ONES ((gsize) -1 / 0xff)
+#define UTILS_HIGH_BITS (UTILS_LOW_ONES * 0x80)
+#define UTILS_LOW_BITS (UTILS_LOW_ONES * 0x7f)
+
+/* Counts the occurrences of @a byte in @a buffer a word at a time, considerably
+ * faster than a byte loop on large buffers. */
+gsize utils_count_byte(const gchar *buffer, gsize size, gchar byte)
 {
-	gsize i;
-	guint cr, lf, crlf, max_mode;
-	gint mode;
+	const gchar *p = buffer;
+	const gchar *end = buffer + size;
+	const gsize pattern = UTILS_LOW_ONES * (guchar) byte;
+	gsize count = 0;
 
-	cr = lf = crlf = 0;
+	/* catch up to a word boundary */
+	while (p < end && ((gsize) p % sizeof(gsize)) != 0)
+		count += (*p++ == byte);
+	while (p + sizeof(gsize) <= end)
+	{
+		const gsize w = *(const gsize *) p ^ pattern;
+		/* 0x80 in each byte of w which matched @a byte, 0 elsewhere; unlike the
+		 * usual "has a zero byte" test this form is carry-free, so it is exact
+		 * per byte and safe to count with */
+		const gsize hits = ~(((w & UTILS_LOW_BITS) + UTILS_LOW_BITS) | w | UTILS_LOW_BITS);
+
+		if (hits)	/* sum the byte-wise hits into the top byte and extract it */
+			count += ((hits >> 7) * UTILS_LOW_ONES) >> (8 * (sizeof(gsize) - 1));
+		p += sizeof(gsize);
+	}
+	while (p < end)
+		count += (*p++ == byte);
+	return count;
+}
+
+
+/* Validates UTF-8 like g_utf8_validate() but considerably faster on mostly-ASCII data:
+ * plain ASCII is skipped 16 bytes at a time with SSE2 where available, a word at a time
+ * otherwise, and only non-ASCII sequences are decoded one character at a time. Embedded
+ * nul bytes are treated as invalid, matching g_utf8_validate(). If @a end is not NULL it
+ * receives the end of the longest valid prefix, whether or not validation succeeded. */
+gboolean utils_utf8_validate(const gchar *buf, gssize len, const gchar **end)
+{
+	const gchar *p = buf;
+	const gchar *stop;
 
-	for (i = 0; i < size ; i++)
+	if (len < 0)
+		len = strlen(buf);
+	stop = buf + len;
+
+	while (p < stop)
 	{
-		if (buffer[i] == 0x0a)
-		{
-			/* LF */
-			lf++;
-		}
-		else if (buffer[i] == 0x0d)
+		if (G_UNLIKELY(*p == '\0'))
+			break;	/* embedded nul, like g_utf8_validate() */
+		else if ((guchar) *p < 0x80)
 		{
-			if (i >= (size - 1))
+			p++;
+#ifdef __SSE2__
+			/* fast path: skip 16-byte blocks of plain ASCII without nul bytes */
+			while (p + 16 <= stop)
 			{
-				/* Last char, CR */
-				cr++;
+				const __m128i w = _mm_loadu_si128((const __m128i *) p);
+
+				if (_mm_movemask_epi8(w) ||
+					_mm_movemask_epi8(_mm_cmpeq_epi8(w, _mm_setzero_si128())))
+					break;
+				p += 16;
 			}
-			else
+#else
+			/* fast path: once aligned, skip word-sized blocks of plain ASCII */
+			if ((gsize) p % sizeof(gsize) == 0)
 			{
-				if (buffer[i + 1] != 0x0a)
+				while (p + sizeof(gsize) <= stop)
 				{
-					/* CR */
-					cr++;
-				}
-				else
-				{
-					/* CRLF */
-					crlf++;
+					const gsize w = *(const gsize *) p;
+
+					/* stop on a byte with the high bit set or a nul byte */
+					if ((w & UTILS_HIGH_BITS) ||
+						((w - UTILS_LOW_ONES) & ~w & UTILS_HIGH_BITS))
+						break;
+					p += sizeof(gsize);
 				}
-				i++;
 			}
+#endif
+		}
+		else
+		{
+			gunichar c = g_utf8_get_char_validated(p, stop - p);
+
+			if (c == (gunichar) -1 || c == (gunichar) -2)
+				break;
+			p = g_utf8_next_char(p);
 		}
 	}
+	if (end != NULL)
+		*end = p;
+	return p == stop;
+}
+
+
+/* taken from anjuta, to determine the EOL mode of the file */
+gint utils_get_line_endings(const gchar* buffer, gsize size)
+{
+	guint cr, lf, crlf, max_mode;
+	gint mode;
+	const gchar *p = buffer;
+	const gchar *end = buffer + size;
+
+	/* jump between CR bytes to tell CR and CRLF apart, and take pure LF from the
+	 * total newline count, scanning a word at a time instead of per byte */
+	cr = crlf = 0;
+	while (p < end && (p = memchr(p, 0x0d, end - p)) != NULL)
+	{
+		if (p + 1 < end && p[1] == 0x0a)
+			crlf++;
+		else
+			cr++;
+		p += 2;
+	}
+	lf = (guint) utils_count_byte(buffer, size, 0x0a) - crlf;
 
 	/* Vote for the maximum */
 	mode = SC_EOL_LF;
@@ -1243,9 +1328,14 @@ gchar *utils_get_locale_from_utf8(const gchar *utf8_text)
 	return g_strdup(utf8_text);
 #else
 	gchar *locale_text;
+	const gchar *charset;
 
 	if (! utf8_text)
 		return NULL;
+	/* on UTF-8 locales (virtually all modern systems) the conversion is the
+	 * identity, skip the converter round-trip. g_get_charset() caches. */
+	if (g_get_charset(&charset))
+		return g_strdup(utf8_text);
 	locale_text = g_locale_from_utf8(utf8_text, -1, NULL, NULL, NULL);
 	if (locale_text == NULL)
 		locale_text = g_strdup(utf8_text);
@@ -1271,9 +1361,13 @@ gchar *utils_get_utf8_from_locale(const gchar *locale_text)
 	return g_strdup(locale_text);
 #else
 	gchar *utf8_text;
+	const gchar *charset;
 
 	if (! locale_text)
 		return NULL;
+	/* see utils_get_locale_from_utf8() */
+	if (g_get_charset(&charset))
+		return g_strdup(locale_text);
 	utf8_text = g_locale_to_utf8(locale_text, -1, NULL, NULL, NULL);
 	if (utf8_text == NULL)
 		utf8_text = g_strdup(locale_text);
@@ -1493,6 +1587,47 @@ gint utils_string_find(GString *haystack, gint start, gint end, const gchar *nee
 }
 
 
+/* --- scratch GString pool ---
+ *
+ * Several UI paths build one short-lived string per event (statusbar
+ * statistics, window title, formatted status messages); recycling the buffers
+ * through a small pool removes a malloc/free pair plus the growth
+ * reallocations from each of these events. Strings are handed out with
+ * utils_scratch_string_acquire() and must be returned with
+ * utils_scratch_string_release() before control returns to the main loop.
+ * Main thread only. */
+
+#define SCRATCH_POOL_MAX_STRINGS 8
+/* don't keep buffers a single oversized message blew up */
+#define SCRATCH_POOL_MAX_LEN 4096
+
+static GPtrArray *scratch_pool = NULL;
+
+GString *utils_scratch_string_acquire(void)
+{
+	if (scratch_pool != NULL && scratch_pool->len > 0)
+		return g_ptr_array_remove_index_fast(scratch_pool, scratch_pool->len - 1);
+	return g_string_sized_new(120);
+}
+
+
+void utils_scratch_string_release(GString *str)
+{
+	g_return_if_fail(str != NULL);
+
+	if (scratch_pool == NULL)
+		scratch_pool = g_ptr_array_new();
+	if (scratch_pool->len >= SCRATCH_POOL_MAX_STRINGS ||
+		str->allocated_len > SCRATCH_POOL_MAX_LEN)
+		g_string_free(str, TRUE);
+	else
+	{
+		g_string_truncate(str, 0);
+		g_ptr_array_add(scratch_pool, str);
+	}
+}
+
+
 /* Replaces @len characters from offset @a pos.
  * len can be -1 to replace the remainder of @a str.
  * returns: pos + strlen(replace). */
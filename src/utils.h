@@ -200,6 +200,10 @@ const gchar *utils_find_open_xml_tag_pos(const gchar sel[], gint size);
 
 #ifdef GEANY_PRIVATE
 
+gsize utils_count_byte(const gchar *buffer, gsize size, gchar byte);
+
+gboolean utils_utf8_validate(const gchar *buf, gssize len, const gchar **end);
+
 gint utils_get_line_endings(const gchar* buffer, gsize size);
 
 gboolean utils_isbrace(gchar c, gboolean include_angles);
@@ -237,6 +241,10 @@ void utils_str_replace_all(gchar **haystack, const gchar *needle, const gchar *r
 
 gint utils_strpos(const gchar* haystack, const gchar *needle);
 
+GString *utils_scratch_string_acquire(void);
+
+void utils_scratch_string_release(GString *str);
+
 gchar *utils_get_initials(const gchar *name);
 
 gchar *utils_get_hex_from_color(GdkColor *color);
@@ -0,0 +1,235 @@
+/*
+ *      utils_fs.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Fast recursive filesystem walker for project scans (file manifest, native
+ * Find in Files). On Linux it reads directories with raw getdents64 batches
+ * and uses the entry type from the kernel, so regular files cost no stat at
+ * all unless the caller asked for sizes, and traversal descends with openat
+ * relative to the parent directory. Elsewhere it falls back to GDir.
+ *
+ * Symbolic links are never followed, matching the previous GDir-based
+ * walkers which skipped them to avoid walking in circles. Entries that are
+ * neither regular files nor directories are ignored.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "utils_fs.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/syscall.h>
+#else
+# include <glib/gstdio.h>
+#endif
+
+
+#ifdef __linux__
+
+/* layout of the records returned by getdents64, see getdents(2) */
+struct walk_dirent64
+{
+	guint64 d_ino;
+	gint64 d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/* one syscall typically returns hundreds of entries with a buffer this size */
+#define WALK_BUFFER_SIZE 65536
+
+
+/* returns FALSE when the walk was cancelled and should unwind completely */
+static gboolean walk_directory_fd(gint dirfd, const gchar *dir_path, gboolean want_stat,
+	UtilsFSWalkFunc func, gpointer user_data, volatile gint *cancelled)
+{
+	gchar *buf = g_malloc(WALK_BUFFER_SIZE);
+	gboolean keep_going = TRUE;
+	gssize nread;
+
+	while (keep_going &&
+		(nread = syscall(SYS_getdents64, dirfd, buf, WALK_BUFFER_SIZE)) > 0)
+	{
+		gssize pos = 0;
+
+		while (pos < nread)
+		{
+			const struct walk_dirent64 *ent = (const struct walk_dirent64 *) (buf + pos);
+			const gchar *name = ent->d_name;
+			unsigned char d_type = ent->d_type;
+			guint64 size = 0, mtime = 0;
+			gboolean is_dir;
+
+			pos += ent->d_reclen;
+			if (cancelled != NULL && g_atomic_int_get(cancelled))
+			{
+				keep_going = FALSE;
+				break;
+			}
+			if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+				continue;
+
+			if (d_type == DT_DIR)
+				is_dir = TRUE;
+			else if (d_type == DT_REG && ! want_stat)
+				is_dir = FALSE;
+			else if (d_type != DT_REG && d_type != DT_UNKNOWN)
+				continue;	/* symlinks, sockets, devices, fifos */
+			else
+			{	/* regular file whose size we need, or a filesystem
+				 * without d_type support */
+				struct stat s;
+
+				if (fstatat(dirfd, name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+					continue;
+				if (S_ISDIR(s.st_mode))
+					is_dir = TRUE;
+				else if (S_ISREG(s.st_mode))
+				{
+					is_dir = FALSE;
+					size = (guint64) s.st_size;
+					mtime = (guint64) s.st_mtime;
+				}
+				else
+					continue;
+			}
+
+			if (is_dir)
+			{
+				if (func(dir_path, name, UTILS_FS_DIR, 0, 0, user_data))
+				{
+					/* O_NOFOLLOW keeps symlinked directories out without
+					 * needing a separate check */
+					gint child = openat(dirfd, name,
+						O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+					if (child >= 0)
+					{
+						gchar *child_path = g_build_filename(dir_path, name, NULL);
+
+						keep_going = walk_directory_fd(child, child_path,
+							want_stat, func, user_data, cancelled);
+						g_free(child_path);
+						close(child);
+						if (! keep_going)
+							break;
+					}
+				}
+			}
+			else
+				func(dir_path, name, UTILS_FS_FILE, size, mtime, user_data);
+		}
+	}
+	g_free(buf);
+	return keep_going;
+}
+
+#else /* ! __linux__ */
+
+static gboolean walk_directory_gdir(const gchar *dir_path, gboolean want_stat,
+	UtilsFSWalkFunc func, gpointer user_data, volatile gint *cancelled)
+{
+	GDir *gdir = g_dir_open(dir_path, 0, NULL);
+	const gchar *name;
+	gboolean keep_going = TRUE;
+
+	if (gdir == NULL)
+		return TRUE;
+
+	while (keep_going && (name = g_dir_read_name(gdir)) != NULL)
+	{
+		gchar *path;
+
+		if (cancelled != NULL && g_atomic_int_get(cancelled))
+		{
+			keep_going = FALSE;
+			break;
+		}
+
+		path = g_build_filename(dir_path, name, NULL);
+		if (g_file_test(path, G_FILE_TEST_IS_SYMLINK))
+			;	/* never follow symlinks */
+		else if (g_file_test(path, G_FILE_TEST_IS_DIR))
+		{
+			if (func(dir_path, name, UTILS_FS_DIR, 0, 0, user_data))
+				keep_going = walk_directory_gdir(path, want_stat, func,
+					user_data, cancelled);
+		}
+		else
+		{
+			guint64 size = 0, mtime = 0;
+			gboolean is_file = TRUE;
+
+			if (want_stat)
+			{
+				struct stat s;
+
+				if (g_stat(path, &s) == 0)
+				{
+					size = (guint64) s.st_size;
+					mtime = (guint64) s.st_mtime;
+				}
+				else
+					is_file = FALSE;
+			}
+			if (is_file)
+				func(dir_path, name, UTILS_FS_FILE, size, mtime, user_data);
+		}
+		g_free(path);
+	}
+	g_dir_close(gdir);
+	return keep_going;
+}
+
+#endif /* ! __linux__ */
+
+
+/* Walks the directory tree below base, reporting every regular file and
+ * directory through func; see UtilsFSWalkFunc for the contract. cancelled
+ * may be NULL, otherwise it is polled per entry and a non-zero value stops
+ * the walk, so the walker can run on a background thread. */
+void utils_fs_walk(const gchar *base, gboolean want_stat, UtilsFSWalkFunc func,
+	gpointer user_data, volatile gint *cancelled)
+{
+	g_return_if_fail(base != NULL);
+	g_return_if_fail(func != NULL);
+
+#ifdef __linux__
+	{
+		gint dirfd = open(base, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+		if (dirfd >= 0)
+		{
+			walk_directory_fd(dirfd, base, want_stat, func, user_data, cancelled);
+			close(dirfd);
+		}
+	}
+#else
+	walk_directory_gdir(base, want_stat, func, user_data, cancelled);
+#endif
+}
@@ -0,0 +1,48 @@
+/*
+ *      utils_fs.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_UTILS_FS_H
+#define GEANY_UTILS_FS_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	UTILS_FS_FILE,
+	UTILS_FS_DIR
+}
+UtilsFSType;
+
+/* Called for every entry found by utils_fs_walk(). dir is the directory
+ * containing the entry and name the entry's name, both in locale encoding.
+ * For UTILS_FS_DIR entries the return value decides whether the walk descends
+ * into the directory; for files it is ignored. size and mtime are filled for
+ * files only and only when want_stat was passed as TRUE. */
+typedef gboolean (*UtilsFSWalkFunc)(const gchar *dir, const gchar *name,
+	UtilsFSType type, guint64 size, guint64 mtime, gpointer user_data);
+
+void utils_fs_walk(const gchar *base, gboolean want_stat, UtilsFSWalkFunc func,
+	gpointer user_data, volatile gint *cancelled);
+
+G_END_DECLS
+
+#endif /* GEANY_UTILS_FS_H */
@@ -66,6 +66,12 @@ static gchar *gtk_menu_key_accel = NULL;
 /* use vte wordchars to select paths */
 static const gchar VTE_WORDCHARS[] = "-A-Za-z0-9,./?%&#:_";
 
+/* upper bound on the configured scrollback history, matching the limit of the
+ * prefs dialog. The value from the config file is not otherwise validated and
+ * a huge history ring makes the terminal slow and memory hungry when
+ * long-running jobs produce a lot of output. */
+#define VTE_MAX_SCROLLBACK_LINES 5000
+
 
 /* Incomplete VteTerminal struct from vte/vte.h. */
 typedef struct _VteTerminal VteTerminal;
@@ -482,7 +488,8 @@ void vte_apply_user_settings(void)
 	if (! ui_prefs.msgwindow_visible)
 		return;
 
-	vf->vte_terminal_set_scrollback_lines(VTE_TERMINAL(vc->vte), vc->scrollback_lines);
+	vf->vte_terminal_set_scrollback_lines(VTE_TERMINAL(vc->vte),
+		MIN(vc->scrollback_lines, VTE_MAX_SCROLLBACK_LINES));
 	vf->vte_terminal_set_scroll_on_keystroke(VTE_TERMINAL(vc->vte), vc->scroll_on_key);
 	vf->vte_terminal_set_scroll_on_output(VTE_TERMINAL(vc->vte), vc->scroll_on_out);
 	vf->vte_terminal_set_emulation(VTE_TERMINAL(vc->vte), vc->emulation);
@@ -0,0 +1,339 @@
+/*
+ *      worker.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The shared background task scheduler.
+ *
+ * All core and plugin background work goes through one thread pool sized to
+ * the number of processors, so the individual features cannot oversubscribe
+ * the machine by each spawning their own threads. Tasks are queued with a
+ * priority class (interactive before parsing before indexing) and run FIFO
+ * within a class; results are delivered back in the main loop, so callers
+ * get the compute-then-display pattern without their own marshalling.
+ *
+ * On Linux the pool additionally watches the power supply and halves its
+ * concurrency while running on battery, trading background throughput for
+ * power.  Queue wait and execution times are published through the
+ * "worker.*" performance counters (see stats.c).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "worker.h"
+
+#include "geany.h" /* geany_debug() */
+#include "stats.h"
+#include "utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef G_OS_UNIX
+# include <unistd.h>	/* for sysconf() */
+#endif
+
+
+/* One task in the scheduler. The struct stays alive until the main-thread
+ * delivery handler has run. */
+typedef struct
+{
+	guint id;
+	gint priority;
+	guint seq;			/* submission order, the FIFO tie-break within a class */
+	WorkerFunc work_func;
+	WorkerDoneFunc done_func;
+	gpointer user_data;
+	gpointer result;
+	gint cancelled;		/* the cancellation token, accessed atomically */
+	gboolean running;	/* whether work_func is currently executing */
+	gboolean finished;	/* whether the worker thread is done with the task */
+	GTimeVal queued_at;
+}
+WorkerTask;
+
+static GThreadPool *worker_pool = NULL;
+static GStaticMutex worker_mutex = G_STATIC_MUTEX_INIT;
+static GCond *worker_finished_cond = NULL;	/* signalled when a work function returns */
+static GSList *worker_tasks = NULL;			/* tasks submitted but not yet delivered */
+static guint worker_next_id = 1;
+static guint worker_next_seq = 1;
+static gint worker_full_threads = 1;		/* pool size when not throttled */
+
+#ifdef __linux__
+static guint worker_power_source_id = 0;
+static gboolean worker_throttled = FALSE;
+#endif
+
+
+static gint worker_thread_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	gint count = (gint) sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (count > 0)
+		return count;
+#endif
+	return 2;
+}
+
+
+static gint worker_task_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const WorkerTask *ta = a;
+	const WorkerTask *tb = b;
+
+	if (ta->priority != tb->priority)
+		return ta->priority - tb->priority;
+	/* same class: first come, first served */
+	return (gint) ta->seq - (gint) tb->seq;
+}
+
+
+static WorkerTask *worker_find_task(guint task_id)
+{
+	GSList *node;
+
+	foreach_slist(node, worker_tasks)
+	{
+		WorkerTask *task = node->data;
+
+		if (task->id == task_id)
+			return task;
+	}
+	return NULL;
+}
+
+
+/* runs in the main loop */
+static gboolean worker_task_deliver(gpointer data)
+{
+	WorkerTask *task = data;
+
+	g_static_mutex_lock(&worker_mutex);
+	worker_tasks = g_slist_remove(worker_tasks, task);
+	g_static_mutex_unlock(&worker_mutex);
+
+	if (task->done_func != NULL)
+		task->done_func(task->result, task->user_data,
+			g_atomic_int_get(&task->cancelled) != 0);
+
+	g_free(task);
+	return FALSE;
+}
+
+
+static void worker_task_run(gpointer data, gpointer pool_data)
+{
+	WorkerTask *task = data;
+
+	g_static_mutex_lock(&worker_mutex);
+	task->running = ! g_atomic_int_get(&task->cancelled);
+	g_static_mutex_unlock(&worker_mutex);
+
+	stats_time_since("worker.queue-wait", &task->queued_at);
+	if (task->running)
+	{
+		GTimeVal start;
+
+		g_get_current_time(&start);
+		task->result = task->work_func(task->user_data, &task->cancelled);
+		stats_time_since("worker.run", &start);
+	}
+
+	g_static_mutex_lock(&worker_mutex);
+	task->running = FALSE;
+	task->finished = TRUE;
+	g_cond_broadcast(worker_finished_cond);
+	g_static_mutex_unlock(&worker_mutex);
+
+	g_idle_add(worker_task_deliver, task);
+}
+
+
+#ifdef __linux__
+/* TRUE when a mains supply is known and reports offline; when in doubt
+ * (desktops without a power supply entry) assume mains power */
+static gboolean worker_on_battery(void)
+{
+	const gchar *base = "/sys/class/power_supply";
+	GDir *dir = g_dir_open(base, 0, NULL);
+	const gchar *name;
+	gboolean found_mains = FALSE;
+	gboolean online = FALSE;
+
+	if (dir == NULL)
+		return FALSE;
+
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		gchar *path = g_build_filename(base, name, "type", NULL);
+		gchar *type = NULL;
+
+		if (g_file_get_contents(path, &type, NULL, NULL) &&
+			strcmp(g_strstrip(type), "Mains") == 0)
+		{
+			gchar *online_path = g_build_filename(base, name, "online", NULL);
+			gchar *value = NULL;
+
+			found_mains = TRUE;
+			if (g_file_get_contents(online_path, &value, NULL, NULL) && atoi(value) != 0)
+				online = TRUE;
+			g_free(value);
+			g_free(online_path);
+		}
+		g_free(type);
+		g_free(path);
+	}
+	g_dir_close(dir);
+
+	return found_mains && ! online;
+}
+
+
+/* shrinks the pool to half its size while on battery so background work burns
+ * less power, and restores it when mains power returns */
+static gboolean worker_power_check(gpointer data)
+{
+	gboolean throttle = worker_on_battery();
+
+	if (throttle != worker_throttled)
+	{
+		gint max_threads = throttle ? MAX(1, worker_full_threads / 2) : worker_full_threads;
+
+		g_thread_pool_set_max_threads(worker_pool, max_threads, NULL);
+		geany_debug("Worker pool %s (%d thread(s))",
+			throttle ? "throttled on battery power" : "restored to full size", max_threads);
+		worker_throttled = throttle;
+	}
+	return TRUE;
+}
+#endif
+
+
+void worker_init(void)
+{
+	worker_full_threads = worker_thread_count();
+	worker_pool = g_thread_pool_new(worker_task_run, NULL, worker_full_threads, FALSE, NULL);
+	g_thread_pool_set_sort_function(worker_pool, worker_task_compare, NULL);
+	worker_finished_cond = g_cond_new();
+
+#ifdef __linux__
+	worker_power_check(NULL);
+	worker_power_source_id = g_timeout_add_seconds(60, worker_power_check, NULL);
+#endif
+}
+
+
+void worker_finalize(void)
+{
+	GSList *node;
+
+	if (worker_pool == NULL)
+		return;
+
+#ifdef __linux__
+	if (worker_power_source_id > 0)
+	{
+		g_source_remove(worker_power_source_id);
+		worker_power_source_id = 0;
+	}
+#endif
+
+	/* cancel everything still queued, then wait for the work functions that
+	 * already run - they may reference state other finalizers tear down */
+	g_static_mutex_lock(&worker_mutex);
+	foreach_slist(node, worker_tasks)
+		g_atomic_int_set(&((WorkerTask *) node->data)->cancelled, 1);
+	g_static_mutex_unlock(&worker_mutex);
+
+	g_thread_pool_free(worker_pool, TRUE, TRUE);
+	worker_pool = NULL;
+	/* task records still waiting for their (now dead) idle delivery are
+	 * reclaimed by the OS, the process is about to exit */
+}
+
+
+/* Queues @a work_func on the shared pool; it runs in a worker thread and its
+ * result is afterwards handed to @a done_func in the main loop. @a priority
+ * is normally one of WorkerPriority. Returns the ID of the task, for
+ * worker_cancel()/worker_wait(). */
+guint worker_push(gint priority, WorkerFunc work_func, WorkerDoneFunc done_func,
+		gpointer user_data)
+{
+	WorkerTask *task;
+
+	g_return_val_if_fail(worker_pool != NULL, 0);
+	g_return_val_if_fail(work_func != NULL, 0);
+
+	task = g_new0(WorkerTask, 1);
+	task->priority = priority;
+	task->work_func = work_func;
+	task->done_func = done_func;
+	task->user_data = user_data;
+	g_get_current_time(&task->queued_at);
+
+	g_static_mutex_lock(&worker_mutex);
+	task->id = worker_next_id++;
+	task->seq = worker_next_seq++;
+	worker_tasks = g_slist_prepend(worker_tasks, task);
+	g_static_mutex_unlock(&worker_mutex);
+
+	stats_count("worker.tasks", 1);
+	g_thread_pool_push(worker_pool, task, NULL);
+	return task->id;
+}
+
+
+/* Cancels a queued task: a work function that has not started is skipped, an
+ * executing one keeps running but can see the cancellation through its token.
+ * Either way @a done_func is still delivered with the cancelled flag set.
+ * IDs of already delivered tasks are ignored. */
+void worker_cancel(guint task_id)
+{
+	WorkerTask *task;
+
+	g_static_mutex_lock(&worker_mutex);
+	task = worker_find_task(task_id);
+	if (task != NULL)
+		g_atomic_int_set(&task->cancelled, 1);
+	g_static_mutex_unlock(&worker_mutex);
+}
+
+
+/* Blocks until the task's work function is not (and will not start)
+ * executing; used before unloading code the work function lives in. Waiting
+ * for an uncancelled pending task waits until the pool has run it. Does not
+ * wait for the main-loop delivery of the result. */
+void worker_wait(guint task_id)
+{
+	g_static_mutex_lock(&worker_mutex);
+	while (TRUE)
+	{
+		WorkerTask *task = worker_find_task(task_id);
+
+		if (task == NULL || task->finished)
+			break;	/* worker thread is done with it (or it was delivered) */
+		if (! task->running && g_atomic_int_get(&task->cancelled))
+			break;	/* never going to run its work function */
+		g_cond_wait(worker_finished_cond, g_static_mutex_get_mutex(&worker_mutex));
+	}
+	g_static_mutex_unlock(&worker_mutex);
+}
@@ -0,0 +1,62 @@
+/*
+ *      worker.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_WORKER_H
+#define GEANY_WORKER_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Scheduling classes for worker_push(). Numerically lower values are picked
+ * from the queue first; the classes are spaced out so callers can nudge a
+ * task within its class with small offsets without crossing into the next. */
+typedef enum
+{
+	WORKER_PRIORITY_INTERACTIVE	= -100,	/* the user is waiting for the result */
+	WORKER_PRIORITY_PARSE		= 0,	/* parsing, loading, search */
+	WORKER_PRIORITY_INDEX		= 100	/* index building, prefetching */
+}
+WorkerPriority;
+
+/* Runs in a worker thread; must not touch the UI or other non-threadsafe
+ * state. @cancelled is the task's cancellation token, to be polled with
+ * g_atomic_int_get() by long-running work functions. */
+typedef gpointer (*WorkerFunc) (gpointer user_data, gint *cancelled);
+
+/* Runs in the main loop with the work function's result after it returned,
+ * or with @cancelled set when the task was cancelled. */
+typedef void (*WorkerDoneFunc) (gpointer result, gpointer user_data, gboolean cancelled);
+
+
+void worker_init(void);
+
+void worker_finalize(void);
+
+guint worker_push(gint priority, WorkerFunc work_func, WorkerDoneFunc done_func,
+		gpointer user_data);
+
+void worker_cancel(guint task_id);
+
+void worker_wait(guint task_id);
+
+G_END_DECLS
+
+#endif /* GEANY_WORKER_H */
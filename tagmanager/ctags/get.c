@@ -92,6 +92,29 @@ static cppState Cpp = {
 	}  /* directive */
 };
 
+/*  Marks characters which cppGetc() may return directly when no directive
+ *  is being processed. Characters needing preprocessor state changes (white
+ *  space, quotes, comments, directives, trigraphs, line continuations) are
+ *  FALSE and take the full path through the state machine.
+ */
+static boolean CppPassThrough [256];
+static boolean CppPassThroughInitialized = FALSE;
+
+/*  Caches the stripped declaration text last read by getArglistFromFilePos().
+ *  Qualified and unqualified tags emitted for the same statement request the
+ *  same file region, so the re-read and comment stripping can be skipped.
+ */
+static struct sArglistCache {
+	long pos1, pos2;
+	char *stripped;
+} ArglistCache = { -1, -1, NULL };
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+static void stripCodeBuffer(char *buf);
+static char *findArglistInStr(char *buf, const char *name);
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -128,6 +151,29 @@ extern void cppInit (const boolean state, const boolean hasAtLiteralStrings)
 		Cpp.directive.name = vStringNew ();
 	else
 		vStringClear (Cpp.directive.name);
+
+	g_free (ArglistCache.stripped);
+	ArglistCache.stripped = NULL;
+	ArglistCache.pos1 = ArglistCache.pos2 = -1;
+
+	if (! CppPassThroughInitialized)
+	{
+		int i;
+
+		for (i = 0  ;  i < 256  ;  ++i)
+			CppPassThrough [i] = TRUE;
+		CppPassThrough [TAB] = FALSE;
+		CppPassThrough [SPACE] = FALSE;
+		CppPassThrough [NEWLINE] = FALSE;
+		CppPassThrough [DOUBLE_QUOTE] = FALSE;
+		CppPassThrough [SINGLE_QUOTE] = FALSE;
+		CppPassThrough [BACKSLASH] = FALSE;
+		CppPassThrough ['#'] = FALSE;
+		CppPassThrough ['/'] = FALSE;
+		CppPassThrough ['?'] = FALSE;
+		CppPassThrough ['@'] = FALSE;
+		CppPassThroughInitialized = TRUE;
+	}
 }
 
 extern void cppTerminate (void)
@@ -137,6 +183,9 @@ extern void cppTerminate (void)
 		vStringDelete (Cpp.directive.name);
 		Cpp.directive.name = NULL;
 	}
+	g_free (ArglistCache.stripped);
+	ArglistCache.stripped = NULL;
+	ArglistCache.pos1 = ArglistCache.pos2 = -1;
 }
 
 extern void cppBeginStatement (void)
@@ -586,6 +635,14 @@ extern int cppGetc (void)
 	else do
 	{
 		c = fileGetc ();
+		if (! directive  &&  ! ignore  &&
+			c >= 0  &&  c < 256  &&  CppPassThrough [c])
+		{
+			/* the common case - an ordinary character in a directive-free
+			 * region needs no preprocessor processing at all */
+			Cpp.directive.accept = FALSE;
+			break;
+		}
 process:
 		switch (c)
 		{
@@ -724,12 +781,33 @@ extern char *getArglistFromFilePos(MIOPos startPosition, const char *tokenName)
 	{
 		size_t len = pos2 - pos1;
 
-		result = (char *) g_malloc(len + 1);
-		if (result != NULL && (len = mio_read(File.mio, result, 1, len)) > 0)
+		if (pos1 == ArglistCache.pos1 && pos2 == ArglistCache.pos2 &&
+			ArglistCache.stripped != NULL)
 		{
-			result[len] = '\0';
-			arglist = getArglistFromStr(result, tokenName);
+			/* same region as the previous call (e.g. the qualified variant
+			 * of the tag just emitted) - reuse the stripped text */
+			result = g_strdup(ArglistCache.stripped);
 		}
+		else
+		{
+			result = (char *) g_malloc(len + 1);
+			if (result != NULL && (len = mio_read(File.mio, result, 1, len)) > 0)
+			{
+				result[len] = '\0';
+				stripCodeBuffer(result);
+				g_free(ArglistCache.stripped);
+				ArglistCache.stripped = g_strdup(result);
+				ArglistCache.pos1 = pos1;
+				ArglistCache.pos2 = pos2;
+			}
+			else
+			{
+				g_free(result);
+				result = NULL;
+			}
+		}
+		if (result != NULL && tokenName != NULL && tokenName[0] != '\0')
+			arglist = findArglistInStr(result, tokenName);
 		g_free(result);
 	}
 	mio_setpos(File.mio, &originalPosition);
@@ -824,13 +902,13 @@ static void stripCodeBuffer(char *buf)
 	return;
 }
 
-extern char *getArglistFromStr(char *buf, const char *name)
+/*  Extracts the parenthesized argument list following the first occurrence
+ *  of name in buf, which must already have been through stripCodeBuffer().
+ */
+static char *findArglistInStr(char *buf, const char *name)
 {
 	char *start, *end;
 	int level;
-	if ((NULL == buf) || (NULL == name) || ('\0' == name[0]))
-		return NULL;
-	stripCodeBuffer(buf);
 	if (NULL == (start = strstr(buf, name)))
 		return NULL;
 	if (NULL == (start = strchr(start, '(')))
@@ -848,4 +926,12 @@ extern char *getArglistFromStr(char *buf, const char *name)
 	return strdup(start);
 }
 
+extern char *getArglistFromStr(char *buf, const char *name)
+{
+	if ((NULL == buf) || (NULL == name) || ('\0' == name[0]))
+		return NULL;
+	stripCodeBuffer(buf);
+	return findArglistInStr(buf, name);
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
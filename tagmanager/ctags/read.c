@@ -30,12 +30,19 @@
 inputFile File;			/* globally read through macros */
 static MIOPos StartOfLine;	/* holds deferred position of start of line */
 
+/*  Optional caller-owned cancellation flag, polled once per input line.
+ *  Once it becomes non-zero the reader reports EOF, so the running parse
+ *  winds down quickly instead of processing the rest of the file.
+ */
+static volatile gint *CancelFlag = NULL;
+static boolean Cancelled = FALSE;
+
 
 
 /* Read a character choosing automatically between file or buffer, depending
  * on which mode we are.
  */
-#define readNextChar() (mio_getc (File.mio))
+#define readNextChar() (mio_getc_fast (File.mio))
 
 /* Replaces ungetc() for file. In case of buffer we'll perform the same action:
  * fpBufferPosition-- and write of the param char into the buf.
@@ -266,7 +273,11 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 	File.mio = NULL;
     }
 
-    File.mio = mio_new_file_full (fileName, openMode, g_fopen, fclose);
+    /* map the file into memory when possible so the parsers read raw memory
+     * instead of going through stdio for every character */
+    File.mio = mio_new_mmap (fileName);
+    if (File.mio == NULL)
+	File.mio = mio_new_file_full (fileName, openMode, g_fopen, fclose);
     if (File.mio == NULL)
 	error (WARNING | PERROR, "cannot open \"%s\"", fileName);
     else
@@ -280,6 +291,7 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 	File.lineNumber   = 0L;
 	File.eof          = FALSE;
 	File.newLine      = TRUE;
+	Cancelled         = FALSE;
 
 	if (File.line != NULL)
 	    vStringClear (File.line);
@@ -326,6 +338,7 @@ extern boolean bufferOpen (unsigned char *buffer, size_t buffer_size,
     File.lineNumber   = 0L;
     File.eof          = FALSE;
     File.newLine      = TRUE;
+    Cancelled         = FALSE;
 
     if (File.line != NULL)
 	vStringClear (File.line);
@@ -361,6 +374,21 @@ extern boolean fileEOF (void)
     return File.eof;
 }
 
+/*  Installs (or, with NULL, removes) a flag that lets the caller abandon the
+ *  parse in progress; pass NULL when the parse has finished so a stale
+ *  pointer is never polled.
+ */
+extern void fileSetCancelFlag (volatile gint *flag)
+{
+    CancelFlag = flag;
+    Cancelled = FALSE;
+}
+
+extern boolean fileCancelled (void)
+{
+    return Cancelled;
+}
+
 /*  Action to take for each encountered source newline.
  */
 static void fileNewline (void)
@@ -369,6 +397,8 @@ static void fileNewline (void)
     File.newLine = FALSE;
     File.lineNumber++;
     File.source.lineNumber++;
+    if (CancelFlag != NULL  &&  g_atomic_int_get (CancelFlag))
+	Cancelled = TRUE;
     DebugStatement ( if (Option.breakLine == File.lineNumber) lineBreak (); )
     DebugStatement ( debugPrintf (DEBUG_RAW, "%6ld: ", File.lineNumber); )
 }
@@ -379,6 +409,12 @@ static void fileNewline (void)
 static int iFileGetc (void)
 {
     int	c;
+
+    if (Cancelled)
+    {
+	File.eof = TRUE;
+	return EOF;
+    }
 readnext:
     c = readNextChar ();
 
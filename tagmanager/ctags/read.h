@@ -103,6 +103,8 @@ extern void fileClose (void);
 extern int fileGetc (void);
 extern int fileSkipToCharacter (int c);
 extern void fileUngetc (int c);
+extern void fileSetCancelFlag (volatile gint *flag);
+extern boolean fileCancelled (void);
 extern const unsigned char *fileReadLine (void);
 extern char *readLine (vString *const vLine, MIO *const mio);
 extern char *readSourceLine (vString *const vLine, MIOPos location, long *const pSeekValue);
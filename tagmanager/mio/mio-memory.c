@@ -58,7 +58,10 @@
 static void
 mem_free (MIO *mio)
 {
-  if (mio->impl.mem.free_func) {
+  if (mio->impl.mem.map) {
+    g_mapped_file_free (mio->impl.mem.map);
+    mio->impl.mem.map = NULL;
+  } else if (mio->impl.mem.free_func) {
     mio->impl.mem.free_func (mio->impl.mem.buf);
   }
   mio->impl.mem.buf = NULL;
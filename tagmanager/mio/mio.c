@@ -37,6 +37,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#ifdef G_OS_UNIX
+# include <sys/mman.h>
+#endif
 
 
 
@@ -233,6 +236,7 @@ mio_new_memory (guchar         *data,
     mio->impl.mem.allocated_size = size;
     mio->impl.mem.realloc_func = realloc_func;
     mio->impl.mem.free_func = free_func;
+    mio->impl.mem.map = NULL;
     mio->impl.mem.eof = FALSE;
     mio->impl.mem.error = FALSE;
     /* function table filling */
@@ -242,6 +246,58 @@ mio_new_memory (guchar         *data,
   return mio;
 }
 
+/**
+ * mio_new_mmap:
+ * @filename: Filename to open, same as the fopen()'s first argument
+ *
+ * Creates a new in-memory #MIO object reading a file through a memory
+ * mapping, avoiding both the copy of the file content into an allocated
+ * buffer and any per-read I/O overhead. The resulting stream is not
+ * growable and must not be written to.
+ *
+ * Mapping can legitimately fail, e.g. on filesystems without mmap()
+ * support, in which case the caller should fall back to mio_new_file().
+ *
+ * Free-function: mio_free()
+ *
+ * Returns: A new #MIO on success, or %NULL on failure.
+ */
+MIO *
+mio_new_mmap (const gchar *filename)
+{
+  GMappedFile *map;
+  MIO         *mio;
+
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  if (! map) {
+    return NULL;
+  }
+
+  mio = mio_new_memory ((guchar *) g_mapped_file_get_contents (map),
+                        g_mapped_file_get_length (map), NULL, NULL);
+  if (! mio) {
+    g_mapped_file_free (map);
+  } else {
+    /* the mapping is dropped by mem_free() when the object is destroyed */
+    mio->impl.mem.map = map;
+#if defined (G_OS_UNIX) && defined (POSIX_MADV_SEQUENTIAL) && defined (POSIX_MADV_WILLNEED)
+    /* Parsers consume the stream from start to end, so ask the kernel for
+     * aggressive sequential read-ahead: it then fetches pages asynchronously
+     * ahead of the read cursor, hiding most of the per-page fault latency of
+     * slow or remote filesystems (NFS, SSHFS) behind parse CPU time. Purely
+     * advisory, failures are deliberately ignored. */
+    if (g_mapped_file_get_length (map) > 0) {
+      posix_madvise (g_mapped_file_get_contents (map),
+                     g_mapped_file_get_length (map), POSIX_MADV_SEQUENTIAL);
+      posix_madvise (g_mapped_file_get_contents (map),
+                     g_mapped_file_get_length (map), POSIX_MADV_WILLNEED);
+    }
+#endif
+  }
+
+  return mio;
+}
+
 /**
  * mio_file_get_fp:
  * @mio: A #MIO object
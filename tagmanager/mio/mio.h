@@ -119,6 +119,7 @@ struct _MIO {
       gsize           allocated_size;
       MIOReallocFunc  realloc_func;
       GDestroyNotify  free_func;
+      GMappedFile    *map; /* non-%NULL if the buffer is a file mapping */
       gboolean        error;
       gboolean        eof;
     } mem;
@@ -173,6 +174,7 @@ MIO        *mio_new_memory          (guchar        *data,
                                      gsize          size,
                                      MIOReallocFunc realloc_func,
                                      GDestroyNotify free_func);
+MIO        *mio_new_mmap            (const gchar *filename);
 void        mio_free                (MIO *mio);
 FILE       *mio_file_get_fp         (MIO *mio);
 guchar     *mio_memory_get_data     (MIO   *mio,
@@ -216,6 +218,27 @@ gint        mio_getpos              (MIO     *mio,
 gint        mio_setpos              (MIO     *mio,
                                      MIOPos  *pos);
 
+/**
+ * mio_getc_fast:
+ * @mio: A #MIO object
+ *
+ * Alternative to mio_getc() which reads in-memory streams with a simple
+ * inline buffer advance, falling back to mio_getc() in every other case.
+ * Useful in per-character read loops such as parsers, where the call
+ * overhead of mio_getc() is measurable.
+ *
+ * <warning><para>@mio is evaluated more than once, so it must be an
+ * expression without side effects.</para></warning>
+ *
+ * Returns: The read character as a #gint, or %EOF on error.
+ */
+#define mio_getc_fast(mio)                                                    \
+  (((mio)->type == MIO_TYPE_MEMORY &&                                         \
+    (mio)->impl.mem.ungetch == EOF &&                                         \
+    (mio)->impl.mem.pos < (mio)->impl.mem.size)                               \
+     ? (gint) (mio)->impl.mem.buf[(mio)->impl.mem.pos++]                      \
+     : mio_getc (mio))
+
 
 
 #endif /* guard */
@@ -0,0 +1,456 @@
+/*
+*
+*   Copyright 2025 The Geany contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   Performance harness for the tag manager. Parses a corpus of source files
+*   and reports parser throughput plus timings of the workspace tag array
+*   operations at several workspace sizes. Not built by default - use
+*   "make benchmark" in tagmanager/src which runs it over the checked-in
+*   ctags test corpus.
+*
+*   Output is machine readable, one tab-separated record per line:
+*     parse <lang> <files> <tags> <seconds> <tags_per_sec> <rate_stddev>
+*     op <name> <workspace_tags> <iterations> <seconds> <ops_per_sec>
+*
+*   With --write-baseline FILE the per-language parse throughput is saved,
+*   and with --check FILE it is compared against such a baseline: languages
+*   more than 10% slower fail the run. Baselines are machine specific and
+*   meant to be regenerated locally before a change (see "make
+*   benchmark-baseline" / "make benchmark-check" in tagmanager/src).
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tm_tagmanager.h"
+
+/* mirrors workspace_tags_sort_attrs in tm_workspace.c */
+static TMTagAttrType benchmark_sort_attrs[] =
+{
+	tm_tag_attr_name_t, tm_tag_attr_file_t, tm_tag_attr_line_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+/* per-language parse statistics; the per-file throughput samples feed the
+ * variance column so noisy runs are recognizable as such */
+typedef struct
+{
+	guint files;
+	guint tags;
+	gdouble seconds;
+	gdouble rate_sum;
+	gdouble rate_sumsq;
+} ParseStats;
+
+/* a language must lose more than this fraction of its baseline throughput
+ * before --check fails the run */
+#define BENCHMARK_REGRESSION_THRESHOLD 0.10
+
+/* minimum measured time per record so short operations are repeated until
+ * the numbers are stable */
+#define BENCHMARK_MIN_SECONDS 0.2
+
+
+static void record(const char *kind, const char *name, guint size, guint iterations,
+	gdouble seconds, gdouble rate)
+{
+	printf("%s\t%s\t%u\t%u\t%.6f\t%.1f\n", kind, name, size, iterations, seconds, rate);
+}
+
+
+static GPtrArray *copy_tags_array(const GPtrArray *tags_array)
+{
+	GPtrArray *copy = g_ptr_array_sized_new(tags_array->len);
+	guint i;
+
+	for (i = 0; i < tags_array->len; i++)
+		g_ptr_array_add(copy, tags_array->pdata[i]);
+	return copy;
+}
+
+
+static void shuffle_tags_array(GPtrArray *tags_array, GRand *rand)
+{
+	guint i;
+
+	for (i = tags_array->len; i > 1; i--)
+	{
+		guint j = g_rand_int_range(rand, 0, i);
+		gpointer tmp = tags_array->pdata[i - 1];
+
+		tags_array->pdata[i - 1] = tags_array->pdata[j];
+		tags_array->pdata[j] = tmp;
+	}
+}
+
+
+/* parses every file repeatedly until BENCHMARK_MIN_SECONDS is spent on it and
+ * accumulates tags/sec per detected language; an untimed warmup parse per
+ * file keeps the first cold run (page cache, allocator) out of the numbers.
+ * Returns the per-language statistics keyed by language name. */
+static GHashTable *benchmark_parsers(GPtrArray *source_files)
+{
+	GHashTable *stats_by_lang = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, g_free);
+	GTimer *timer = g_timer_new();
+	guint i;
+
+	for (i = 0; i < source_files->len; i++)
+	{
+		TMSourceFile *source_file = source_files->pdata[i];
+		const gchar *lang_name;
+		ParseStats *stats;
+		gdouble seconds = 0.0;
+		gdouble rate;
+		guint runs = 0;
+
+		if (! tm_source_file_parse(source_file, NULL, 0, FALSE))	/* warmup */
+			continue;
+
+		while (seconds < BENCHMARK_MIN_SECONDS)
+		{
+			g_timer_start(timer);
+			if (! tm_source_file_parse(source_file, NULL, 0, FALSE))
+				break;
+			seconds += g_timer_elapsed(timer, NULL);
+			runs++;
+		}
+		if (runs == 0 || seconds <= 0.0)
+			continue;
+
+		lang_name = FALLBACK(tm_source_file_get_lang_name(source_file->lang), "unknown");
+		stats = g_hash_table_lookup(stats_by_lang, lang_name);
+		if (stats == NULL)
+		{
+			stats = g_new0(ParseStats, 1);
+			g_hash_table_insert(stats_by_lang, g_strdup(lang_name), stats);
+		}
+		stats->files++;
+		stats->tags += source_file->tags_array->len * runs;
+		stats->seconds += seconds;
+		rate = (source_file->tags_array->len * runs) / seconds;
+		stats->rate_sum += rate;
+		stats->rate_sumsq += rate * rate;
+	}
+	g_timer_destroy(timer);
+	return stats_by_lang;
+}
+
+
+/* spread of the per-file throughput samples of one language */
+static gdouble parse_stats_stddev(const ParseStats *stats)
+{
+	gdouble mean, var;
+
+	if (stats->files < 2)
+		return 0.0;
+	mean = stats->rate_sum / stats->files;
+	var = stats->rate_sumsq / stats->files - mean * mean;
+	return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+
+static gdouble parse_stats_rate(const ParseStats *stats)
+{
+	return stats->seconds > 0.0 ? stats->tags / stats->seconds : 0.0;
+}
+
+
+static void report_parse_stats(GHashTable *stats_by_lang)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, stats_by_lang);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		ParseStats *stats = value;
+
+		printf("parse\t%s\t%u\t%u\t%.6f\t%.1f\t%.1f\n", (const gchar *) key,
+			stats->files, stats->tags, stats->seconds,
+			parse_stats_rate(stats), parse_stats_stddev(stats));
+	}
+}
+
+
+static gboolean write_baseline_file(const gchar *filename, GHashTable *stats_by_lang)
+{
+	GString *contents = g_string_new(NULL);
+	GHashTableIter iter;
+	gpointer key, value;
+	gboolean ok;
+
+	g_hash_table_iter_init(&iter, stats_by_lang);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		g_string_append_printf(contents, "%s\t%.1f\n", (const gchar *) key,
+			parse_stats_rate(value));
+	}
+	ok = g_file_set_contents(filename, contents->str, contents->len, NULL);
+	if (! ok)
+		fprintf(stderr, "cannot write baseline file %s\n", filename);
+	g_string_free(contents, TRUE);
+	return ok;
+}
+
+
+/* compares the measured per-language throughput against a baseline written
+ * by --write-baseline; returns the number of regressed languages */
+static guint check_against_baseline(const gchar *filename, GHashTable *stats_by_lang)
+{
+	gchar *contents = NULL;
+	gchar **lines, **line;
+	GHashTable *baseline = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	GHashTableIter iter;
+	gpointer key, value;
+	guint regressions = 0;
+
+	if (! g_file_get_contents(filename, &contents, NULL, NULL))
+	{
+		fprintf(stderr, "cannot read baseline file %s\n", filename);
+		g_hash_table_destroy(baseline);
+		return 1;
+	}
+	lines = g_strsplit(contents, "\n", 0);
+	for (line = lines; *line != NULL; line++)
+	{
+		gchar *sep = strchr(*line, '\t');
+
+		if (sep != NULL)
+		{
+			gdouble *rate = g_new(gdouble, 1);
+
+			*rate = g_ascii_strtod(sep + 1, NULL);
+			g_hash_table_insert(baseline, g_strndup(*line, sep - *line), rate);
+		}
+	}
+	g_strfreev(lines);
+	g_free(contents);
+
+	g_hash_table_iter_init(&iter, stats_by_lang);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const gdouble *base = g_hash_table_lookup(baseline, key);
+		gdouble rate = parse_stats_rate(value);
+
+		if (base == NULL)
+			fprintf(stderr, "%s: no baseline, skipped\n", (const gchar *) key);
+		else if (rate < *base * (1.0 - BENCHMARK_REGRESSION_THRESHOLD))
+		{
+			fprintf(stderr, "%s: REGRESSED %.1f -> %.1f tags/sec (-%.0f%%, stddev %.1f)\n",
+				(const gchar *) key, *base, rate, 100.0 * (1.0 - rate / *base),
+				parse_stats_stddev(value));
+			regressions++;
+		}
+	}
+	g_hash_table_destroy(baseline);
+	return regressions;
+}
+
+
+/* times sort/dedup/merge/find against the current workspace tag array */
+static void benchmark_workspace_ops(GRand *rand)
+{
+	const TMWorkspace *workspace = tm_get_workspace();
+	const GPtrArray *tags = workspace->tags_array;
+	GTimer *timer = g_timer_new();
+	GPtrArray *small = NULL;
+	gdouble seconds;
+	guint iterations;
+	guint i;
+
+	if (tags->len == 0)
+		return;
+
+	/* sort a shuffled copy */
+	seconds = 0.0;
+	iterations = 0;
+	while (seconds < BENCHMARK_MIN_SECONDS)
+	{
+		GPtrArray *copy = copy_tags_array(tags);
+
+		shuffle_tags_array(copy, rand);
+		g_timer_start(timer);
+		tm_tags_sort(copy, benchmark_sort_attrs, FALSE, FALSE);
+		seconds += g_timer_elapsed(timer, NULL);
+		iterations++;
+		g_ptr_array_free(copy, TRUE);
+	}
+	record("op", "tm_tags_sort", tags->len, iterations, seconds, iterations / seconds);
+
+	/* deduplicate an already sorted copy */
+	seconds = 0.0;
+	iterations = 0;
+	while (seconds < BENCHMARK_MIN_SECONDS)
+	{
+		GPtrArray *copy = copy_tags_array(tags);
+
+		g_timer_start(timer);
+		tm_tags_dedup(copy, benchmark_sort_attrs, FALSE);
+		seconds += g_timer_elapsed(timer, NULL);
+		iterations++;
+		g_ptr_array_free(copy, TRUE);
+	}
+	record("op", "tm_tags_dedup", tags->len, iterations, seconds, iterations / seconds);
+
+	/* merge the tags of the biggest file back into a copy of the workspace,
+	 * the same shape of work tm_workspace_update() does per reparse */
+	for (i = 0; i < workspace->source_files->len; i++)
+	{
+		TMSourceFile *source_file = workspace->source_files->pdata[i];
+
+		if (small == NULL || source_file->tags_array->len > small->len)
+			small = source_file->tags_array;
+	}
+	if (small != NULL && small->len > 0)
+	{
+		seconds = 0.0;
+		iterations = 0;
+		while (seconds < BENCHMARK_MIN_SECONDS)
+		{
+			GPtrArray *copy = copy_tags_array(tags);
+			GPtrArray *merged;
+
+			g_timer_start(timer);
+			merged = tm_tags_merge(copy, small, benchmark_sort_attrs, FALSE);
+			seconds += g_timer_elapsed(timer, NULL);
+			iterations++;
+			g_ptr_array_free(merged, TRUE);
+			g_ptr_array_free(copy, TRUE);
+		}
+		record("op", "tm_tags_merge", tags->len, iterations, seconds, iterations / seconds);
+	}
+
+	/* look up sampled existing tag names, exact and by prefix */
+	seconds = 0.0;
+	iterations = 0;
+	while (seconds < BENCHMARK_MIN_SECONDS)
+	{
+		const TMTag *tag = TM_TAG(tags->pdata[g_rand_int_range(rand, 0, tags->len)]);
+
+		g_timer_start(timer);
+		tm_workspace_find(tag->name, tm_tag_max_t, NULL, FALSE, -1);
+		seconds += g_timer_elapsed(timer, NULL);
+		iterations++;
+	}
+	record("op", "tm_workspace_find", tags->len, iterations, seconds, iterations / seconds);
+
+	seconds = 0.0;
+	iterations = 0;
+	while (seconds < BENCHMARK_MIN_SECONDS)
+	{
+		const TMTag *tag = TM_TAG(tags->pdata[g_rand_int_range(rand, 0, tags->len)]);
+
+		g_timer_start(timer);
+		tm_workspace_find(tag->name, tm_tag_max_t, NULL, TRUE, -1);
+		seconds += g_timer_elapsed(timer, NULL);
+		iterations++;
+	}
+	record("op", "tm_workspace_find_partial", tags->len, iterations, seconds,
+		iterations / seconds);
+
+	g_timer_destroy(timer);
+}
+
+
+int main(int argc, char **argv)
+{
+	GPtrArray *source_files;
+	GHashTable *stats_by_lang;
+	GRand *rand = g_rand_new_with_seed(42);
+	const gchar *write_baseline = NULL;
+	const gchar *check_baseline = NULL;
+	guint batch, batches = 4;
+	guint added = 0;
+	guint regressions = 0;
+	gint i = 1;
+
+	while (i < argc && argv[i][0] == '-')
+	{
+		if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc)
+			write_baseline = argv[++i];
+		else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+			check_baseline = argv[++i];
+		else
+		{
+			fprintf(stderr,
+				"Usage: %s [--write-baseline FILE | --check FILE] source-file...\n",
+				argv[0]);
+			return 1;
+		}
+		i++;
+	}
+	if (i >= argc)
+	{
+		fprintf(stderr,
+			"Usage: %s [--write-baseline FILE | --check FILE] source-file...\n",
+			argv[0]);
+		return 1;
+	}
+
+	source_files = g_ptr_array_new();
+	for (; i < argc; i++)
+	{
+		TMSourceFile *source_file = tm_source_file_new(argv[i], NULL);
+
+		if (source_file != NULL)
+			g_ptr_array_add(source_files, source_file);
+	}
+	if (source_files->len == 0)
+	{
+		fprintf(stderr, "%s: no readable source files\n", argv[0]);
+		return 1;
+	}
+
+	printf("# parse\tlang\tfiles\ttags\tseconds\ttags_per_sec\trate_stddev\n");
+	printf("# op\tname\tworkspace_tags\titerations\tseconds\tops_per_sec\n");
+
+	stats_by_lang = benchmark_parsers(source_files);
+	report_parse_stats(stats_by_lang);
+
+	if (write_baseline != NULL && ! write_baseline_file(write_baseline, stats_by_lang))
+		regressions = 1;
+	if (check_baseline != NULL)
+		regressions = check_against_baseline(check_baseline, stats_by_lang);
+	g_hash_table_destroy(stats_by_lang);
+
+	/* the workspace operation timings are not part of the regression gate,
+	 * so skip them in the baseline modes to keep those runs short */
+	if (write_baseline == NULL && check_baseline == NULL)
+	{
+		/* grow the workspace in batches and measure the array operations at
+		 * each size so scaling behaviour shows up in the numbers */
+		for (batch = 1; batch <= batches; batch++)
+		{
+			guint limit = source_files->len * batch / batches;
+			GPtrArray *to_add = g_ptr_array_new();
+
+			for (; added < limit; added++)
+				g_ptr_array_add(to_add, source_files->pdata[added]);
+			tm_workspace_add_source_files(to_add);
+			g_ptr_array_free(to_add, TRUE);
+
+			benchmark_workspace_ops(rand);
+		}
+
+		/* all source files were added to the workspace, which owns them now */
+		tm_workspace_free();
+	}
+	else
+	{
+		guint j;
+
+		for (j = 0; j < source_files->len; j++)
+			tm_source_file_free(source_files->pdata[j]);
+	}
+	g_ptr_array_free(source_files, TRUE);
+	g_rand_free(rand);
+	return regressions > 0 ? 3 : 0;
+}
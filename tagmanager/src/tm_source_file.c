@@ -38,6 +38,9 @@
 
 static TMSourceFile *current_source_file = NULL;
 
+/* serializes parses - the ctags parsers are full of global state */
+static GStaticMutex parse_mutex = G_STATIC_MUTEX_INIT;
+
 static int get_path_max(const char *path)
 {
 #ifdef PATH_MAX
@@ -234,16 +237,14 @@ void tm_source_file_free(TMSourceFile *source_file)
 	}
 }
 
-/* Parses the text-buffer or source file and regenarates the tags.
- @param source_file The source file to parse
- @param text_buf The text buffer to parse
- @param buf_size The size of text_buf.
- @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
- TRUE to parse the buffer and ignore the file content.
- @return TRUE on success, FALSE on failure
+/* Like tm_source_file_parse(), but polls the given flag once per input line
+ and abandons the parse when it becomes non-zero, e.g. because a newer buffer
+ superseded the one being parsed. A cancelled parse leaves the tag array
+ empty and returns FALSE.
+ @param cancel Cancellation flag read with g_atomic_int_get(), or NULL.
 */
-gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
-	gboolean use_buffer)
+gboolean tm_source_file_parse_cancellable(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, gboolean use_buffer, volatile gint *cancel)
 {
 	const char *file_name;
 	gboolean retry = TRUE;
@@ -291,6 +292,11 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 		return TRUE;
 	}
 
+	/* the ctags parsers use global state, so only one parse may run at a time;
+	 * this allows calling tm_source_file_parse() from a worker thread as long
+	 * as nobody else touches the source file meanwhile */
+	g_static_mutex_lock(&parse_mutex);
+	fileSetCancelFlag(cancel);
 	if (NULL == LanguageTable)
 	{
 		initializeParsing();
@@ -318,7 +324,7 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	else
 	{
 		guint passCount = 0;
-		while (retry && passCount < 3)
+		while (retry && passCount < 3 && ! fileCancelled())
 		{
 			tm_tags_array_free(source_file->tags_array, FALSE);
 			if (parse_file && fileOpen (file_name, source_file->lang))
@@ -350,17 +356,41 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 			else
 			{
 				g_warning("Unable to open %s", file_name);
+				fileSetCancelFlag(NULL);
+				g_static_mutex_unlock(&parse_mutex);
 				return FALSE;
 			}
 			++ passCount;
 		}
 	}
-	
+	if (fileCancelled())
+	{
+		/* partial results from an abandoned parse are useless */
+		tm_tags_array_free(source_file->tags_array, FALSE);
+		retry = TRUE;
+	}
+	fileSetCancelFlag(NULL);
+	g_static_mutex_unlock(&parse_mutex);
+
 	if (free_buf)
 		g_free(text_buf);
 	return !retry;
 }
 
+/* Parses the text-buffer or source file and regenarates the tags.
+ @param source_file The source file to parse
+ @param text_buf The text buffer to parse
+ @param buf_size The size of text_buf.
+ @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
+ TRUE to parse the buffer and ignore the file content.
+ @return TRUE on success, FALSE on failure
+*/
+gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
+	gboolean use_buffer)
+{
+	return tm_source_file_parse_cancellable(source_file, text_buf, buf_size, use_buffer, NULL);
+}
+
 /* Gets the name associated with the language index.
  @param lang The language index.
  @return The language name, or NULL.
@@ -397,37 +427,47 @@ gint tm_source_file_get_named_lang(const gchar *name)
 	return getNamedLanguage(name);
 }
 
-#if 0
 /*
- Writes all tags of a source file (including the file tag itself) to the passed
- file pointer.
- @param source_file The source file to write.
+ Writes all tags of a source file to the passed file pointer in tagmanager
+ format, suitable for reading back with tm_source_file_read_tags(). Used for
+ caching parse results between sessions.
+ @param source_file The source file whose tags are written.
  @param fp The file pointer to write to.
- @param attrs The attributes to write.
  @return TRUE on success, FALSE on failure.
 */
-static gboolean tm_source_file_write(TMSourceFile *source_file, FILE *fp, guint attrs)
+gboolean tm_source_file_write_tags(TMSourceFile *source_file, FILE *fp)
 {
-	TMTag *tag;
 	guint i;
 
-	if (NULL != source_file)
+	if (NULL == source_file || NULL == source_file->tags_array)
+		return FALSE;
+	for (i = 0; i < source_file->tags_array->len; ++i)
 	{
-		if (NULL != (tag = tm_tag_new(source_file, NULL)))
-		{
-			tm_tag_write(tag, fp, tm_tag_attr_max_t);
-			tm_tag_unref(tag);
-			if (NULL != source_file->tags_array)
-			{
-				for (i=0; i < source_file->tags_array->len; ++i)
-				{
-					tag = TM_TAG(source_file->tags_array->pdata[i]);
-					if (TRUE != tm_tag_write(tag, fp, attrs))
-						return FALSE;
-				}
-			}
-		}
+		if (TRUE != tm_tag_write(TM_TAG(source_file->tags_array->pdata[i]), fp,
+			tm_tag_attr_max_t))
+			return FALSE;
 	}
 	return TRUE;
 }
-#endif
+
+/*
+ Replaces the tags of a source file with tags read from the passed file
+ pointer, as written by tm_source_file_write_tags(). The caller is responsible
+ for making sure the stored tags still describe the current file content and
+ for merging the tags into the workspace if needed.
+ @param source_file The source file whose tags are replaced.
+ @param fp The file pointer to read from.
+ @return TRUE on success, FALSE on failure.
+*/
+gboolean tm_source_file_read_tags(TMSourceFile *source_file, FILE *fp)
+{
+	TMTag *tag;
+
+	if (NULL == source_file || NULL == source_file->tags_array)
+		return FALSE;
+	tm_tags_array_free(source_file->tags_array, FALSE);
+	while (NULL != (tag = tm_tag_new_from_file(source_file, fp, source_file->lang,
+		TM_FILE_FORMAT_TAGMANAGER)))
+		g_ptr_array_add(source_file->tags_array, tag);
+	return TRUE;
+}
@@ -60,6 +60,13 @@ gint tm_source_file_get_named_lang(const gchar *name);
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
 	gboolean use_buffer);
 
+gboolean tm_source_file_parse_cancellable(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, gboolean use_buffer, volatile gint *cancel);
+
+gboolean tm_source_file_write_tags(TMSourceFile *source_file, FILE *fp);
+
+gboolean tm_source_file_read_tags(TMSourceFile *source_file, FILE *fp);
+
 #endif /* GEANY_PRIVATE */
 
 #ifdef __cplusplus
@@ -198,6 +198,28 @@ static char get_tag_impl(const char *impl)
 	return TAG_IMPL_UNKNOWN;
 }
 
+/* Tag names and scopes repeat massively across a workspace (every member of a
+ * class carries the same scope string), so they are stored once in a shared
+ * intern pool instead of being g_strdup'ed per tag. Interned strings are
+ * never freed; the pool grows with the identifier vocabulary only. The lock
+ * makes interning safe from the background parse thread. */
+static GStringChunk *intern_pool = NULL;
+static GStaticMutex intern_mutex = G_STATIC_MUTEX_INIT;
+
+static char *tm_tag_intern(const char *str)
+{
+	char *result;
+
+	if (str == NULL)
+		return NULL;
+	g_static_mutex_lock(&intern_mutex);
+	if (intern_pool == NULL)
+		intern_pool = g_string_chunk_new(32768);
+	result = g_string_chunk_insert_const(intern_pool, str);
+	g_static_mutex_unlock(&intern_mutex);
+	return result;
+}
+
 static char get_tag_access(const char *access)
 {
 	if (0 == strcmp("public", access))
@@ -236,7 +258,7 @@ static gboolean tm_tag_init(TMTag *tag, TMSourceFile *file, const tagEntryInfo *
 	/* This is a normal tag entry */
 	if (NULL == tag_entry->name)
 		return FALSE;
-	tag->name = g_strdup(tag_entry->name);
+	tag->name = tm_tag_intern(tag_entry->name);
 	tag->type = get_tag_type(tag_entry->kindName);
 	tag->local = tag_entry->isFileScope;
 	tag->pointerOrder = 0;	/* backward compatibility (use var_type instead) */
@@ -247,7 +269,7 @@ static gboolean tm_tag_init(TMTag *tag, TMSourceFile *file, const tagEntryInfo *
 		(isalpha(tag_entry->extensionFields.scope[1][0]) ||
 		 tag_entry->extensionFields.scope[1][0] == '_' ||
 		 tag_entry->extensionFields.scope[1][0] == '$'))
-		tag->scope = g_strdup(tag_entry->extensionFields.scope[1]);
+		tag->scope = tm_tag_intern(tag_entry->extensionFields.scope[1]);
 	if (tag_entry->extensionFields.inheritance != NULL)
 		tag->inheritance = g_strdup(tag_entry->extensionFields.inheritance);
 	if (tag_entry->extensionFields.varType != NULL)
@@ -314,7 +336,7 @@ static gboolean tm_tag_init_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 			if (!isprint(*start))
 				return FALSE;
 			else
-				tag->name = g_strdup((gchar*)start);
+				tag->name = tm_tag_intern((gchar*)start);
 		}
 		else
 		{
@@ -333,7 +355,7 @@ static gboolean tm_tag_init_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 					tag->arglist = g_strdup((gchar*)start + 1);
 					break;
 				case TA_SCOPE:
-					tag->scope = g_strdup((gchar*)start + 1);
+					tag->scope = tm_tag_intern((gchar*)start + 1);
 					break;
 				case TA_POINTER:
 					tag->pointerOrder = atoi((gchar*)start + 1);
@@ -400,7 +422,7 @@ static gboolean tm_tag_init_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *
 			fields = g_strsplit((gchar*)start, "|", -1);
 			field_len = g_strv_length(fields);
 
-			if (field_len >= 1) tag->name = g_strdup(fields[0]);
+			if (field_len >= 1) tag->name = tm_tag_intern(fields[0]);
 			else tag->name = NULL;
 			if (field_len >= 2 && fields[1] != NULL) tag->var_type = g_strdup(fields[1]);
 			if (field_len >= 3 && fields[2] != NULL) tag->arglist = g_strdup(fields[2]);
@@ -438,13 +460,14 @@ static gboolean tm_tag_init_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE
 	/* tag name */
 	if (! (tab = strchr(p, '\t')) || p == tab)
 		return FALSE;
-	tag->name = g_strndup(p, (gsize)(tab - p));
+	*tab = '\0';
+	tag->name = tm_tag_intern(p);
+	*tab = '\t';
 	p = tab + 1;
 
 	/* tagfile, unused */
 	if (! (tab = strchr(p, '\t')))
 	{
-		g_free(tag->name);
 		tag->name = NULL;
 		return FALSE;
 	}
@@ -542,8 +565,7 @@ static gboolean tm_tag_init_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE
 					 0 == strcmp(key, "struct") ||
 					 0 == strcmp(key, "union")) /* Name of the class/enum/function/struct/union in which this tag is a member */
 			{
-				g_free(tag->scope);
-				tag->scope = g_strdup(value);
+				tag->scope = tm_tag_intern(value);
 			}
 			else if (0 == strcmp(key, "file")) /* static (local) tag */
 				tag->local = TRUE;
@@ -592,6 +614,22 @@ TMTag *tm_tag_new_from_file(TMSourceFile *file, FILE *fp, gint mode, TMFileForma
 	return tag;
 }
 
+/*
+ Creates an empty tag whose string members will point into a memory-mapped
+ tags image owned by the caller. tm_tag_destroy() leaves the strings of such
+ tags alone; the caller must keep the image mapped as long as the tag lives.
+ @return the new TMTag structure.
+*/
+TMTag *tm_tag_new_mapped(void)
+{
+	TMTag *tag;
+
+	TAG_NEW(tag);
+	tag->refcount = 1;
+	tag->mapped = TRUE;
+	return tag;
+}
+
 /*
  Writes tag information to the given FILE *.
  @param tag The tag information to write.
@@ -607,7 +645,7 @@ gboolean tm_tag_write(TMTag *tag, FILE *fp, TMTagAttrType attrs)
 	if ((attrs & tm_tag_attr_arglist_t) && (NULL != tag->arglist))
 		fprintf(fp, "%c%s", TA_ARGLIST, tag->arglist);
 	if (attrs & tm_tag_attr_line_t)
-		fprintf(fp, "%c%ld", TA_LINE, tag->line);
+		fprintf(fp, "%c%u", TA_LINE, tag->line);
 	if (attrs & tm_tag_attr_local_t)
 		fprintf(fp, "%c%d", TA_LOCAL, tag->local);
 	if ((attrs & tm_tag_attr_scope_t) && (NULL != tag->scope))
@@ -636,9 +674,10 @@ gboolean tm_tag_write(TMTag *tag, FILE *fp, TMTagAttrType attrs)
 */
 static void tm_tag_destroy(TMTag *tag)
 {
-	g_free(tag->name);
+	if (tag->mapped)
+		return;	/* strings live in a mapped tags image which outlives the tag */
+	/* name and scope are interned and owned by the intern pool */
 	g_free(tag->arglist);
-	g_free(tag->scope);
 	g_free(tag->inheritance);
 	g_free(tag->var_type);
 }
@@ -782,6 +821,76 @@ gboolean tm_tags_dedup(GPtrArray *tags_array, TMTagAttrType *sort_attributes, gb
 	return TRUE;
 }
 
+/* Returns the byte of the tag name at the given depth, 0 past the end of the
+ * name. NULL tags sort like an empty name and end up in a run which is ordered
+ * by tm_tag_compare() so they get the usual warning there. */
+static guchar tm_tag_name_byte(const TMTag *tag, guint depth)
+{
+	return (guchar) (tag ? FALLBACK(tag->name, "")[depth] : '\0');
+}
+
+/* Multi-key (three-way radix) quicksort on tag names after Bentley & Sedgewick.
+ * Unlike qsort() with tm_tag_compare(), which re-runs strcmp() from the first
+ * character for every comparison, this inspects each name byte only once per
+ * partitioning pass, which is considerably faster on large workspace arrays
+ * where many names share common prefixes. Runs of equal names are handed to
+ * tm_tag_compare() to order the remaining sort attributes. */
+static void tm_tags_sort_by_name(TMTag **tags, guint len, guint depth,
+	TMSortOptions *sort_options)
+{
+	while (len > 1)
+	{
+		guint lt, gt, i;
+		guchar pivot;
+
+		if (len < 16)
+		{
+			/* small runs: the generic comparator is cheap enough */
+			g_qsort_with_data(tags, len, sizeof(TMTag *), tm_tag_compare, sort_options);
+			return;
+		}
+
+		pivot = tm_tag_name_byte(tags[len / 2], depth);
+
+		/* three-way partition on the name byte at the current depth */
+		lt = 0;
+		gt = len;
+		i = 0;
+		while (i < gt)
+		{
+			guchar c = tm_tag_name_byte(tags[i], depth);
+
+			if (c < pivot)
+			{
+				TMTag *tmp = tags[lt];
+				tags[lt++] = tags[i];
+				tags[i++] = tmp;
+			}
+			else if (c > pivot)
+			{
+				TMTag *tmp = tags[--gt];
+				tags[gt] = tags[i];
+				tags[i] = tmp;
+			}
+			else
+				i++;
+		}
+
+		tm_tags_sort_by_name(tags, lt, depth, sort_options);
+		if (pivot != '\0')
+			tm_tags_sort_by_name(tags + lt, gt - lt, depth + 1, sort_options);
+		else if (gt - lt > 1)
+		{
+			/* the names in this run are all equal - order on the other attributes */
+			g_qsort_with_data(tags + lt, gt - lt, sizeof(TMTag *), tm_tag_compare,
+				sort_options);
+		}
+		/* iterate instead of recursing on the "greater than" partition */
+		tags += gt;
+		len -= gt;
+	}
+}
+
 /*
  Sort an array of tags on the specified attribuites using the inbuilt comparison
  function.
@@ -790,16 +899,22 @@ gboolean tm_tags_dedup(GPtrArray *tags_array, TMTagAttrType *sort_attributes, gb
  @param dedup Whether to deduplicate the sorted array
  @return TRUE on success, FALSE on failure
 */
-gboolean tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes, 
+gboolean tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates)
 {
 	TMSortOptions sort_options;
-	
+
 	if ((!tags_array) || (!tags_array->len))
 		return TRUE;
 	sort_options.sort_attrs = sort_attributes;
 	sort_options.partial = FALSE;
-	g_ptr_array_sort_with_data(tags_array, tm_tag_compare, &sort_options);
+	/* sorts keyed on the name first can use the radix sort; other orderings
+	 * fall back to the generic comparison sort */
+	if (NULL == sort_attributes || tm_tag_attr_name_t == sort_attributes[0])
+		tm_tags_sort_by_name((TMTag **) tags_array->pdata, tags_array->len, 0,
+			&sort_options);
+	else
+		g_ptr_array_sort_with_data(tags_array, tm_tag_compare, &sort_options);
 	if (dedup)
 		tm_tags_dedup(tags_array, sort_attributes, unref_duplicates);
 	return TRUE;
@@ -1275,7 +1390,7 @@ void tm_tag_print(TMTag *tag, FILE *fp)
 	if (tag->inheritance)
 		fprintf(fp, " : from %s", tag->inheritance);
 	if ((tag->file) && (tag->line > 0))
-		fprintf(fp, "[%s:%ld]", tag->file->file_name
+		fprintf(fp, "[%s:%u]", tag->file->file_name
 		  , tag->line);
 	fprintf(fp, "\n");
 }
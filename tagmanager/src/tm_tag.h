@@ -118,26 +118,26 @@ typedef enum
  pseudo tag. It should always be created indirectly with one of the tag
  creation functions such as tm_source_file_parse() or tm_tag_new_from_file().
  Once created, they can be sorted, deduped, etc. using functions such as
- tm_tags_sort() or tm_tags_dedup()
+ tm_tags_sort() or tm_tags_dedup(). Fields are ordered and sized to minimize
+ padding - a workspace can easily hold several hundred thousand tags.
 */
 typedef struct _TMTag
 {
 	char *name; /**< Name of tag */
-	TMTagType type; /**< Tag Type */
-	gint refcount; /* the reference count of the tag */
-	
-	/** These are tag attributes */
 	TMSourceFile *file; /**< File in which the tag occurs; NULL for global tags */
-	gulong line; /**< Line number of the tag */
-	gboolean local; /**< Is the tag of local scope */
-	guint pointerOrder;
 	char *arglist; /**< Argument list (functions/prototypes/macros) */
 	char *scope; /**< Scope of tag */
 	char *inheritance; /**< Parent classes */
 	char *var_type; /**< Variable type (maps to struct for typedefs) */
+	TMTagType type; /**< Tag Type */
+	gint refcount; /* the reference count of the tag */
+	guint32 line; /**< Line number of the tag */
+	langType lang; /**< Programming language of the file */
+	guint16 pointerOrder;
+	guint8 mapped; /* string members point into a mapped tags image - do not free them */
+	guint8 local; /**< Is the tag of local scope */
 	char access; /**< Access type (public/protected/private/etc.) */
 	char impl; /**< Implementation (e.g. virtual) */
-	langType lang; /**< Programming language of the file */
 } TMTag;
 
 
@@ -162,6 +162,8 @@ TMTag *tm_tag_new(TMSourceFile *file, const tagEntryInfo *tag_entry);
 
 TMTag *tm_tag_new_from_file(TMSourceFile *file, FILE *fp, gint mode, TMFileFormat format);
 
+TMTag *tm_tag_new_mapped(void);
+
 gboolean tm_tag_write(TMTag *tag, FILE *file, guint attrs);
 
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array);
@@ -29,6 +29,10 @@
 # include <glob.h>
 #endif
 #include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+# include <fcntl.h>
+# include <sys/mman.h>
+#endif
 
 #include "tm_workspace.h"
 #include "tm_tag.h"
@@ -58,6 +62,115 @@ static TMTagAttrType global_tags_sort_attrs[] =
 
 static TMWorkspace *theWorkspace = NULL;
 
+/* Image backing one mapped compiled global tags file, kept until the workspace
+ is freed: tag strings point straight into the mapping. On POSIX systems the
+ file is mapped MAP_SHARED so that several instances loading the same compiled
+ tags file share one set of physical pages. */
+typedef struct
+{
+	gchar *tags_file;	/* path of the mapped file */
+	time_t mtime;	/* file mtime when mapped, for cross-instance invalidation */
+	gint mode;	/* language the file was loaded for, to reload it when stale */
+	gchar *contents;
+	gsize len;
+#ifdef G_OS_UNIX
+	gboolean shared;	/* contents come from mmap(MAP_SHARED), not GMappedFile */
+#endif
+	GMappedFile *fallback;	/* used where shared mappings are unavailable */
+} CompiledTagsImage;
+
+static GSList *compiled_tags_images = NULL;
+/* images whose file was regenerated on disk and reloaded; the old mappings must
+ stay alive because previously created tags and snapshots still point into them */
+static GSList *retired_tags_images = NULL;
+
+/* Scope member lookups repeat heavily during completion (every '.' or '->'
+ * keystroke on the same type), so resolved member arrays are memoized per
+ * lookup key. The generation counter is bumped whenever workspace tags
+ * change, which lazily invalidates all cached entries; stale entries are
+ * never dereferenced, only overwritten on the next lookup for their key. */
+typedef struct
+{
+	GPtrArray *tags; /* cached result; tag pointers are owned by the source files */
+	guint generation;
+} TMScopeCacheEntry;
+
+static GHashTable *scope_member_cache = NULL;
+static guint workspace_generation = 0;
+
+/* The published snapshot of the workspace tag arrays, see tm_workspace_snapshot().
+ * Built lazily: a burst of reparses bumps the generation many times but pays for a
+ * single rebuild on the next snapshot request. Only the main thread builds and swaps
+ * the pointer; readers that received a reference may use and drop it on any thread. */
+static TMWorkspaceSnapshot *current_snapshot = NULL;
+
+static void compiled_tags_image_free(CompiledTagsImage *image)
+{
+#ifdef G_OS_UNIX
+	if (image->shared)
+		munmap(image->contents, image->len);
+#endif
+	if (image->fallback)
+		g_mapped_file_free(image->fallback);
+	g_free(image->tags_file);
+	g_free(image);
+}
+
+/* Maps tags_file read-only for use in place. A MAP_SHARED mapping is preferred
+ so that all instances mapping the same compiled tags file share one set of
+ physical pages; a GMappedFile is the portable fallback. */
+static CompiledTagsImage *compiled_tags_image_new(const char *tags_file)
+{
+	CompiledTagsImage *image = g_new0(CompiledTagsImage, 1);
+	struct stat buf;
+
+	if (g_stat(tags_file, &buf) != 0)
+	{
+		g_free(image);
+		return NULL;
+	}
+	image->tags_file = g_strdup(tags_file);
+	image->mtime = buf.st_mtime;
+#ifdef G_OS_UNIX
+	if (buf.st_size > 0)
+	{
+		gint fd = g_open(tags_file, O_RDONLY, 0);
+
+		if (fd >= 0)
+		{
+			gpointer addr = mmap(NULL, (size_t) buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+			close(fd);
+			if (addr != MAP_FAILED)
+			{
+				image->contents = addr;
+				image->len = (gsize) buf.st_size;
+				image->shared = TRUE;
+				return image;
+			}
+		}
+	}
+#endif
+	image->fallback = g_mapped_file_new(tags_file, FALSE, NULL);
+	if (image->fallback == NULL)
+	{
+		g_free(image->tags_file);
+		g_free(image);
+		return NULL;
+	}
+	image->contents = g_mapped_file_get_contents(image->fallback);
+	image->len = g_mapped_file_get_length(image->fallback);
+	return image;
+}
+
+static void scope_cache_entry_free(gpointer data)
+{
+	TMScopeCacheEntry *entry = data;
+
+	g_ptr_array_free(entry->tags, TRUE);
+	g_free(entry);
+}
+
 
 static gboolean tm_create_workspace(void)
 {
@@ -90,6 +203,26 @@ void tm_workspace_free(void)
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	g_free(theWorkspace);
 	theWorkspace = NULL;
+
+	if (scope_member_cache)
+	{
+		g_hash_table_destroy(scope_member_cache);
+		scope_member_cache = NULL;
+	}
+
+	if (current_snapshot != NULL)
+	{
+		tm_workspace_snapshot_unref(current_snapshot);
+		current_snapshot = NULL;
+	}
+
+	/* mapped tags images can only go away once no tag references them anymore */
+	g_slist_foreach(compiled_tags_images, (GFunc) compiled_tags_image_free, NULL);
+	g_slist_free(compiled_tags_images);
+	compiled_tags_images = NULL;
+	g_slist_foreach(retired_tags_images, (GFunc) compiled_tags_image_free, NULL);
+	g_slist_free(retired_tags_images);
+	retired_tags_images = NULL;
 }
 
 
@@ -107,12 +240,69 @@ const TMWorkspace *tm_get_workspace(void)
 }
 
 
+static GPtrArray *snapshot_copy_tags(GPtrArray *tags)
+{
+	GPtrArray *copy = g_ptr_array_sized_new(tags->len);
+	guint i;
+
+	for (i = 0; i < tags->len; ++i)
+		g_ptr_array_add(copy, tm_tag_ref(tags->pdata[i]));
+	return copy;
+}
+
+
+/* Returns a reference to a snapshot of the current workspace tags. Must be called on
+ the main thread (it may build and publish a new snapshot), but the returned snapshot
+ can be handed to a worker thread and released there with
+ tm_workspace_snapshot_unref() when the lookup is done.
+*/
+TMWorkspaceSnapshot *tm_workspace_snapshot(void)
+{
+	TMWorkspaceSnapshot *snapshot = current_snapshot;
+
+	if (NULL == theWorkspace)
+		tm_create_workspace();
+
+	if (snapshot == NULL || snapshot->generation != workspace_generation)
+	{
+		snapshot = g_new(TMWorkspaceSnapshot, 1);
+		snapshot->tags_array = snapshot_copy_tags(theWorkspace->tags_array);
+		snapshot->typename_array = snapshot_copy_tags(theWorkspace->typename_array);
+		snapshot->global_tags = snapshot_copy_tags(theWorkspace->global_tags);
+		snapshot->generation = workspace_generation;
+		snapshot->refcount = 1;	/* the published reference */
+
+		if (current_snapshot != NULL)
+			tm_workspace_snapshot_unref(current_snapshot);
+		g_atomic_pointer_set(&current_snapshot, snapshot);
+	}
+	g_atomic_int_inc(&snapshot->refcount);
+	return snapshot;
+}
+
+
+/* Drops a snapshot reference; the last reference frees the arrays and releases the
+ tag references. Safe to call from any thread.
+*/
+void tm_workspace_snapshot_unref(TMWorkspaceSnapshot *snapshot)
+{
+	if (snapshot != NULL && g_atomic_int_dec_and_test(&snapshot->refcount))
+	{
+		tm_tags_array_free(snapshot->tags_array, TRUE);
+		tm_tags_array_free(snapshot->typename_array, TRUE);
+		tm_tags_array_free(snapshot->global_tags, TRUE);
+		g_free(snapshot);
+	}
+}
+
+
 static void tm_workspace_merge_tags(GPtrArray **big_array, GPtrArray *small_array)
 {
 	GPtrArray *new_tags = tm_tags_merge(*big_array, small_array, workspace_tags_sort_attrs, FALSE);
 	/* tags owned by TMSourceFile - free just the pointer array */
 	g_ptr_array_free(*big_array, TRUE);
 	*big_array = new_tags;
+	workspace_generation++;
 }
 
 
@@ -173,6 +363,25 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file)
 	g_ptr_array_add(theWorkspace->source_files, source_file);
 }
 
+/* Merges the tags a source file already carries into the workspace without
+ reparsing it. Used for files added with tm_workspace_add_source_file_noupdate()
+ whose tags were obtained elsewhere, e.g. deserialized from a cache.
+ @param source_file The source file whose tags are merged.
+*/
+void tm_workspace_merge_file_tags(TMSourceFile *source_file)
+{
+	GPtrArray *sf_typedefs;
+
+	g_return_if_fail(source_file != NULL);
+
+	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+	tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
+
+	sf_typedefs = tm_tags_extract(source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+	tm_workspace_merge_tags(&theWorkspace->typename_array, sf_typedefs);
+	g_ptr_array_free(sf_typedefs, TRUE);
+}
+
 
 /* Updates the source file by reparsing the text-buffer passed as parameter.
  Ctags will use a parsing based on buffer instead of on files.
@@ -194,8 +403,216 @@ void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* t
 }
 
 
+/* --- asynchronous buffer parsing ---
+ *
+ * A single worker thread runs the ctags parsers on buffer snapshots (the
+ * parsers use global state, so there is no point in more than one). The
+ * worker parses into a detached dummy TMSourceFile and never touches the
+ * real one; the finished tag array is handed back to the main loop which
+ * retargets the tags and merges them into the workspace. Requests for a
+ * source file are superseded by newer requests for the same file. */
+
+typedef struct
+{
+	TMSourceFile *source_file;	/* only dereferenced on the main thread after a validity check */
+	char *file_name;			/* copies for the worker thread */
+	langType lang;
+	guchar *text_buf;
+	gsize buf_size;
+	volatile gint cancelled;
+	GPtrArray *tags_array;		/* the parse result, tags not yet retargeted */
+	langType detected_lang;
+	TMSourceFileParsedFunc parsed_func;
+	gpointer user_data;
+} TMParseRequest;
+
+static GAsyncQueue *parse_request_queue = NULL;
+/* requests queued or being parsed; accessed from the main thread only */
+static GPtrArray *pending_parse_requests = NULL;
+/* scheduled coalesced workspace publish, see tm_workspace_publish_idle() */
+static guint workspace_publish_source = 0;
+
+
+static void tm_workspace_update(void);
+
+
+/* Rebuilds and sorts the workspace tag arrays once for a whole burst of
+ parse results (e.g. a session load), instead of paying a full-array merge
+ for every single file. */
+static gboolean tm_workspace_publish_idle(gpointer data)
+{
+	workspace_publish_source = 0;
+	g_ptr_array_free(theWorkspace->typename_array, TRUE);
+	tm_workspace_update();
+	return FALSE;
+}
+
+
+static void tm_parse_request_free(TMParseRequest *request)
+{
+	if (request->tags_array != NULL)
+		tm_tags_array_free(request->tags_array, TRUE);
+	g_free(request->text_buf);
+	g_free(request->file_name);
+	g_free(request);
+}
+
+
+/* checks on the main thread that the source file was not removed from the
+ workspace (and possibly freed) while the request was in flight */
+static gboolean tm_workspace_contains_source_file(TMSourceFile *source_file)
+{
+	guint i;
+
+	for (i = 0; i < theWorkspace->source_files->len; ++i)
+	{
+		if (theWorkspace->source_files->pdata[i] == source_file)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static gboolean tm_workspace_deliver_parse_request(gpointer data)
+{
+	TMParseRequest *request = data;
+	TMSourceFile *source_file = request->source_file;
+
+	g_ptr_array_remove_fast(pending_parse_requests, request);
+
+	if (! g_atomic_int_get(&request->cancelled) && request->tags_array != NULL &&
+		tm_workspace_contains_source_file(source_file))
+	{
+		GPtrArray *tags_array = request->tags_array;
+		guint i;
+
+		/* the tags were created against the worker's dummy source file */
+		for (i = 0; i < tags_array->len; ++i)
+			TM_TAG(tags_array->pdata[i])->file = source_file;
+		if (source_file->lang == LANG_AUTO)
+			source_file->lang = request->detected_lang;
+
+		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
+		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+		tm_tags_array_free(source_file->tags_array, TRUE);
+		source_file->tags_array = tags_array;
+		request->tags_array = NULL;	/* ownership transferred */
+
+		tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+
+		if (pending_parse_requests->len > 0)
+		{
+			/* more parse results are on their way (bulk session/project
+			 * load) - publish the whole workspace once at the end of the
+			 * burst instead of merging the full arrays for every file */
+			if (workspace_publish_source == 0)
+				workspace_publish_source = g_idle_add_full(G_PRIORITY_LOW,
+					tm_workspace_publish_idle, NULL, NULL);
+		}
+		else if (workspace_publish_source != 0)
+		{
+			/* last result of a burst - publish right now so the callback
+			 * below sees a fully up-to-date workspace */
+			g_source_remove(workspace_publish_source);
+			tm_workspace_publish_idle(NULL);
+		}
+		else
+		{
+			GPtrArray *sf_typedefs;
+
+			tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
+			sf_typedefs = tm_tags_extract(source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+			tm_workspace_merge_tags(&theWorkspace->typename_array, sf_typedefs);
+			g_ptr_array_free(sf_typedefs, TRUE);
+		}
+
+		if (request->parsed_func != NULL)
+			request->parsed_func(source_file, request->user_data);
+	}
+	tm_parse_request_free(request);
+	return FALSE;
+}
+
+
+static gpointer tm_workspace_parse_thread(gpointer data)
+{
+	GAsyncQueue *queue = data;
+	TMParseRequest *request;
+
+	while (NULL != (request = g_async_queue_pop(queue)))
+	{
+		if (! g_atomic_int_get(&request->cancelled))
+		{
+			TMSourceFile *dummy;
+
+			dummy = tm_source_file_new(request->file_name, NULL);
+			if (dummy != NULL)
+			{
+				dummy->lang = request->lang;
+				/* the flag is polled once per input line, so a parse of a huge
+				 * generated file stops quickly when a newer buffer supersedes it */
+				tm_source_file_parse_cancellable(dummy, request->text_buf,
+					request->buf_size, TRUE, &request->cancelled);
+				request->detected_lang = dummy->lang;
+				/* steal the parsed tags - they are retargeted on delivery */
+				request->tags_array = dummy->tags_array;
+				dummy->tags_array = g_ptr_array_new();
+				tm_source_file_free(dummy);
+			}
+		}
+		g_idle_add(tm_workspace_deliver_parse_request, request);
+	}
+	return NULL;
+}
+
+
+/* Like tm_workspace_update_source_file_buffer(), but runs the parser on a
+ worker thread so the caller is not blocked. Takes ownership of text_buf,
+ which must be a private snapshot of the buffer. A newer request for the same
+ source file supersedes older unfinished ones. parsed_func (optional) is
+ called on the main loop once the workspace has been updated.
+ @param source_file The source file to update with a buffer.
+ @param text_buf A text buffer, owned by the tag manager from now on.
+ @param buf_size The size of text_buf.
+*/
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file, guchar *text_buf,
+	gsize buf_size, TMSourceFileParsedFunc parsed_func, gpointer user_data)
+{
+	TMParseRequest *request;
+	guint i;
+
+	g_return_if_fail(source_file != NULL);
+
+	if (parse_request_queue == NULL)
+	{
+		parse_request_queue = g_async_queue_new();
+		pending_parse_requests = g_ptr_array_new();
+		g_thread_create(tm_workspace_parse_thread, parse_request_queue, FALSE, NULL);
+	}
+
+	/* supersede older requests for the same file */
+	for (i = 0; i < pending_parse_requests->len; ++i)
+	{
+		request = pending_parse_requests->pdata[i];
+		if (request->source_file == source_file)
+			g_atomic_int_set(&request->cancelled, TRUE);
+	}
+
+	request = g_new0(TMParseRequest, 1);
+	request->source_file = source_file;
+	request->file_name = g_strdup(source_file->file_name);
+	request->lang = source_file->lang;
+	request->text_buf = text_buf;
+	request->buf_size = buf_size;
+	request->parsed_func = parsed_func;
+	request->user_data = user_data;
+	g_ptr_array_add(pending_parse_requests, request);
+	g_async_queue_push(parse_request_queue, request);
+}
+
+
 /** Removes a source file from the workspace if it exists. This function also removes
- the tags belonging to this file from the workspace. To completely free the TMSourceFile 
+ the tags belonging to this file from the workspace. To completely free the TMSourceFile
  pointer call tm_source_file_free() on it.
  @param source_file Pointer to the source file to be removed.
 */
@@ -212,6 +629,7 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
 			g_ptr_array_remove_index_fast(theWorkspace->source_files, i);
+			workspace_generation++;
 			return;
 		}
 	}
@@ -256,8 +674,9 @@ static void tm_workspace_update(void)
 	g_message("Total: %d tags", theWorkspace->tags_array->len);
 #endif
 	tm_tags_sort(theWorkspace->tags_array, workspace_tags_sort_attrs, TRUE, FALSE);
-	
+
 	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
+	workspace_generation++;
 }
 
 
@@ -315,26 +734,23 @@ void tm_workspace_remove_source_files(GPtrArray *source_files)
 }
 
 
-/* Loads the global tag list from the specified file. The global tag list should
- have been first created using tm_workspace_create_global_tags().
- @param tags_file The file containing global tags.
- @return TRUE on success, FALSE on failure.
- @see tm_workspace_create_global_tags()
-*/
-gboolean tm_workspace_load_global_tags(const char *tags_file, gint mode)
+/* Reads the tags of a textual global tags file into an unsorted pointer array.
+ Performs the format auto-detection previously done in tm_workspace_load_global_tags().
+ @return the array of tags, or NULL on failure. */
+static GPtrArray *tm_workspace_read_text_tags(const char *tags_file, gint mode)
 {
 	guchar buf[BUFSIZ];
 	FILE *fp;
-	GPtrArray *file_tags, *new_tags;
+	GPtrArray *file_tags;
 	TMTag *tag;
 	TMFileFormat format = TM_FILE_FORMAT_TAGMANAGER;
 
 	if (NULL == (fp = g_fopen(tags_file, "r")))
-		return FALSE;
+		return NULL;
 	if ((NULL == fgets((gchar*) buf, BUFSIZ, fp)) || ('\0' == *buf))
 	{
 		fclose(fp);
-		return FALSE; /* early out on error */
+		return NULL; /* early out on error */
 	}
 	else
 	{	/* We read the first line for the format specification. */
@@ -365,20 +781,329 @@ gboolean tm_workspace_load_global_tags(const char *tags_file, gint mode)
 		}
 		rewind(fp); /* reset the file pointer, to start reading again from the beginning */
 	}
-	
+
 	file_tags = g_ptr_array_new();
 	while (NULL != (tag = tm_tag_new_from_file(NULL, fp, mode, format)))
 		g_ptr_array_add(file_tags, tag);
 	fclose(fp);
-	
+
+	return file_tags;
+}
+
+
+/* Compiled global tags format: a binary image designed to be memory-mapped and
+ searched in place. After the header follows one fixed-size record per tag and
+ a single string table holding all strings NUL-terminated; records reference
+ strings by offset into the table, offset 0 meaning "not set". The records are
+ written sorted and deduplicated with the global tags sort criteria, so a
+ loaded file can be merged into the workspace without re-sorting. The format
+ uses native byte order and is meant as a per-machine cache, not for
+ distribution. */
+
+#define TM_TAGS_COMPILED_MAGIC 0x47544147 /* "GTAG" */
+#define TM_TAGS_COMPILED_VERSION 1
+
+typedef struct
+{
+	guint32 magic;
+	guint32 version;
+	guint32 tag_count;
+	guint32 strings_offset;	/* from the start of the file */
+	guint32 strings_size;
+} TMCompiledHeader;
+
+typedef struct
+{
+	guint32 name;			/* string table offsets */
+	guint32 scope;
+	guint32 arglist;
+	guint32 inheritance;
+	guint32 var_type;
+	guint32 type;			/* TMTagType */
+	guint32 lang;
+	guint8 access;
+	guint8 impl;
+	guint16 pointer_order;
+} TMCompiledTag;
+
+static guint32 compiled_tags_intern(GString *strings, GHashTable *interned, const char *str)
+{
+	gpointer offset;
+
+	if (str == NULL || *str == '\0')
+		return 0;
+	offset = g_hash_table_lookup(interned, str);
+	if (offset == NULL)
+	{
+		offset = GUINT_TO_POINTER(strings->len);
+		g_string_append_len(strings, str, strlen(str) + 1);	/* include the NUL */
+		g_hash_table_insert(interned, g_strdup(str), offset);
+	}
+	return (guint32) GPOINTER_TO_UINT(offset);
+}
+
+
+/* Converts a textual global tags file into the compiled binary format.
+ @param tags_file The textual tags file to convert.
+ @param compiled_file The file to write the compiled image to.
+ @param mode langType to use for the tags.
+ @return TRUE on success, FALSE on failure.
+ @see tm_workspace_load_global_tags()
+*/
+gboolean tm_workspace_compile_global_tags(const char *tags_file, const char *compiled_file,
+	gint mode)
+{
+	GPtrArray *file_tags;
+	GString *strings;
+	GHashTable *interned;
+	TMCompiledHeader header;
+	FILE *fp;
+	guint i;
+	gboolean ret = TRUE;
+
+	file_tags = tm_workspace_read_text_tags(tags_file, mode);
+	if (file_tags == NULL)
+		return FALSE;
 	tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
 
+	if (NULL == (fp = g_fopen(compiled_file, "wb")))
+	{
+		tm_tags_array_free(file_tags, TRUE);
+		return FALSE;
+	}
+
+	strings = g_string_new(NULL);
+	g_string_append_c(strings, '\0');	/* reserve offset 0 for "not set" */
+	interned = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	header.magic = TM_TAGS_COMPILED_MAGIC;
+	header.version = TM_TAGS_COMPILED_VERSION;
+	header.tag_count = file_tags->len;
+	header.strings_offset = sizeof(header) + file_tags->len * sizeof(TMCompiledTag);
+	header.strings_size = 0;	/* known only after interning, rewritten below */
+
+	ret = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+	for (i = 0; ret && i < file_tags->len; ++i)
+	{
+		TMTag *tag = TM_TAG(file_tags->pdata[i]);
+		TMCompiledTag record;
+
+		record.name = compiled_tags_intern(strings, interned, tag->name);
+		record.scope = compiled_tags_intern(strings, interned, tag->scope);
+		record.arglist = compiled_tags_intern(strings, interned, tag->arglist);
+		record.inheritance = compiled_tags_intern(strings, interned, tag->inheritance);
+		record.var_type = compiled_tags_intern(strings, interned, tag->var_type);
+		record.type = (guint32) tag->type;
+		record.lang = (guint32) tag->lang;
+		record.access = (guint8) tag->access;
+		record.impl = (guint8) tag->impl;
+		record.pointer_order = (guint16) tag->pointerOrder;
+		if (fwrite(&record, sizeof(record), 1, fp) != 1)
+		{
+			ret = FALSE;
+			break;
+		}
+	}
+
+	header.strings_size = strings->len;
+	if (ret)
+	{
+		/* the string table, then the header with the now known sizes */
+		ret = fwrite(strings->str, strings->len, 1, fp) == 1;
+		rewind(fp);
+		ret = ret && fwrite(&header, sizeof(header), 1, fp) == 1;
+	}
+	fclose(fp);
+
+	g_hash_table_destroy(interned);
+	g_string_free(strings, TRUE);
+	tm_tags_array_free(file_tags, TRUE);
+	if (! ret)
+		g_unlink(compiled_file);
+	return ret;
+}
+
+
+/* Maps a compiled global tags file and creates tags whose strings point
+ directly into the mapped image, avoiding any per-string allocation.
+ @return the array of tags sorted with the global tags sort criteria,
+ or NULL on failure. */
+static GPtrArray *tm_workspace_read_compiled_tags(const char *tags_file, gint mode)
+{
+	CompiledTagsImage *image;
+	GPtrArray *file_tags;
+	const TMCompiledHeader *header;
+	const TMCompiledTag *records;
+	const char *contents, *strings;
+	gsize len;
+	guint i;
+
+	image = compiled_tags_image_new(tags_file);
+	if (image == NULL)
+		return NULL;
+	image->mode = mode;
+	contents = image->contents;
+	len = image->len;
+
+	header = (const TMCompiledHeader *) contents;
+	if (len < sizeof(*header) ||
+		header->magic != TM_TAGS_COMPILED_MAGIC ||
+		header->version != TM_TAGS_COMPILED_VERSION ||
+		header->strings_offset != sizeof(*header) + header->tag_count * sizeof(TMCompiledTag) ||
+		(gsize) header->strings_offset + header->strings_size != len ||
+		header->strings_size == 0 ||
+		contents[len - 1] != '\0')	/* guarantees string termination */
+	{
+		compiled_tags_image_free(image);
+		return NULL;
+	}
+
+	records = (const TMCompiledTag *) (contents + sizeof(*header));
+	strings = contents + header->strings_offset;
+	file_tags = g_ptr_array_sized_new(header->tag_count);
+
+	for (i = 0; i < header->tag_count; ++i)
+	{
+		const TMCompiledTag *record = &records[i];
+		TMTag *tag;
+
+		if (record->name == 0 || record->name >= header->strings_size ||
+			record->scope >= header->strings_size ||
+			record->arglist >= header->strings_size ||
+			record->inheritance >= header->strings_size ||
+			record->var_type >= header->strings_size)
+			continue;	/* corrupted record */
+
+		tag = tm_tag_new_mapped();
+		tag->name = (char *) strings + record->name;
+		tag->scope = record->scope ? (char *) strings + record->scope : NULL;
+		tag->arglist = record->arglist ? (char *) strings + record->arglist : NULL;
+		tag->inheritance = record->inheritance ? (char *) strings + record->inheritance : NULL;
+		tag->var_type = record->var_type ? (char *) strings + record->var_type : NULL;
+		tag->type = (TMTagType) record->type;
+		tag->lang = (langType) record->lang;
+		tag->access = (char) record->access;
+		tag->impl = (char) record->impl;
+		tag->pointerOrder = record->pointer_order;
+		g_ptr_array_add(file_tags, tag);
+	}
+
+	compiled_tags_images = g_slist_prepend(compiled_tags_images, image);
+	return file_tags;
+}
+
+
+/* Loads the global tag list from the specified file. The global tag list should
+ have been first created using tm_workspace_create_global_tags(). Both the
+ textual formats and the compiled format written by
+ tm_workspace_compile_global_tags() are recognized; compiled files are
+ memory-mapped and used in place.
+ @param tags_file The file containing global tags.
+ @return TRUE on success, FALSE on failure.
+ @see tm_workspace_create_global_tags()
+*/
+gboolean tm_workspace_load_global_tags(const char *tags_file, gint mode)
+{
+	GPtrArray *file_tags, *new_tags;
+	guint32 magic = 0;
+	FILE *fp;
+
+	/* sniff the magic to tell compiled images from textual tags files */
+	if (NULL == (fp = g_fopen(tags_file, "rb")))
+		return FALSE;
+	if (fread(&magic, sizeof(magic), 1, fp) != 1)
+	{
+		fclose(fp);
+		return FALSE;
+	}
+	fclose(fp);
+
+	if (magic == TM_TAGS_COMPILED_MAGIC)
+	{
+		/* written pre-sorted and deduplicated, no need to sort again */
+		file_tags = tm_workspace_read_compiled_tags(tags_file, mode);
+	}
+	else
+	{
+		file_tags = tm_workspace_read_text_tags(tags_file, mode);
+		if (file_tags != NULL)
+			tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+	}
+	if (file_tags == NULL)
+		return FALSE;
+
 	/* reorder the whole array, because tm_tags_find expects a sorted array */
-	new_tags = tm_tags_merge(theWorkspace->global_tags, 
+	new_tags = tm_tags_merge(theWorkspace->global_tags,
 		file_tags, global_tags_sort_attrs, TRUE);
 	g_ptr_array_free(theWorkspace->global_tags, TRUE);
 	g_ptr_array_free(file_tags, TRUE);
 	theWorkspace->global_tags = new_tags;
+	workspace_generation++;
+
+	return TRUE;
+}
+
+
+/* Rechecks the mtime of every mapped compiled global tags file and, when one was
+ regenerated on disk - typically by another instance recompiling shared tags -
+ drops its tags from the global tag list and loads the new file in its place.
+ The old mapping is kept alive until exit because tags already handed out (and
+ snapshots holding them) may still point into it.
+ @return TRUE when at least one stale file was reloaded.
+*/
+gboolean tm_workspace_refresh_global_tags(void)
+{
+	GSList *stale = NULL, *node;
+	GPtrArray *kept;
+	guint i;
+
+	if (theWorkspace == NULL)
+		return FALSE;
+
+	for (node = compiled_tags_images; node != NULL; node = node->next)
+	{
+		CompiledTagsImage *image = node->data;
+		struct stat buf;
+
+		if (g_stat(image->tags_file, &buf) == 0 && buf.st_mtime != image->mtime)
+			stale = g_slist_prepend(stale, image);
+	}
+	if (stale == NULL)
+		return FALSE;
+
+	/* drop tags pointing into a stale image: their names lie inside its mapping */
+	kept = g_ptr_array_sized_new(theWorkspace->global_tags->len);
+	for (i = 0; i < theWorkspace->global_tags->len; ++i)
+	{
+		TMTag *tag = TM_TAG(theWorkspace->global_tags->pdata[i]);
+		gboolean in_stale = FALSE;
+
+		for (node = stale; node != NULL && ! in_stale; node = node->next)
+		{
+			CompiledTagsImage *image = node->data;
+
+			in_stale = tag->name >= image->contents &&
+				tag->name < image->contents + image->len;
+		}
+		if (in_stale)
+			tm_tag_unref(tag);
+		else
+			g_ptr_array_add(kept, tag);
+	}
+	g_ptr_array_free(theWorkspace->global_tags, TRUE);
+	theWorkspace->global_tags = kept;
+	workspace_generation++;
+
+	for (node = stale; node != NULL; node = node->next)
+	{
+		CompiledTagsImage *image = node->data;
+
+		compiled_tags_images = g_slist_remove(compiled_tags_images, image);
+		retired_tags_images = g_slist_prepend(retired_tags_images, image);
+		tm_workspace_load_global_tags(image->tags_file, image->mode);
+	}
+	g_slist_free(stale);
 
 	return TRUE;
 }
@@ -776,6 +1501,82 @@ static gboolean match_langs(gint lang, const TMTag *tag)
 }
 
 
+/* whether a tag is visible for a language, including the "C global tags
+ * also serve C++" special case used for global tags */
+static gboolean prefix_match_lang(const TMTag *tag, langType lang)
+{
+	langType tag_lang = tag->file ? tag->file->lang : tag->lang;
+
+	/* lang = 1 is C++, lang = 0 is C; C global tags are also used for C++ */
+	return lang == -1 || tag_lang == lang ||
+		(tag->file == NULL && tag_lang == 0 && lang == 1);
+}
+
+
+/* Returns tags whose names start with the given prefix, for autocompletion.
+ The workspace and global tags arrays are kept sorted by name, so they act as
+ the prefix index: the first match is located by binary search and the two
+ runs of matches are merged name-sorted and deduplicated until max_num tags
+ have been collected, giving O(log n + k) instead of collecting and sorting
+ every match.
+ @param prefix The prefix to match.
+ @param lang The language to use, or -1 for all.
+ @param max_num The maximum number of tags to return.
+ @return Array of matching tags, valid until the next call to this function.
+*/
+const GPtrArray *tm_workspace_find_prefix(const char *prefix, langType lang, guint max_num)
+{
+	static GPtrArray *tags = NULL;
+	TMTag **ws_match, **gl_match;
+	guint ws_count = 0, gl_count = 0;
+	size_t len;
+
+	if (!prefix)
+		return NULL;
+	len = strlen(prefix);
+	if (!len)
+		return NULL;
+	if (tags)
+		g_ptr_array_set_size(tags, 0);
+	else
+		tags = g_ptr_array_new();
+
+	ws_match = tm_tags_find(theWorkspace->tags_array, prefix, TRUE, TRUE, &ws_count);
+	gl_match = tm_tags_find(theWorkspace->global_tags, prefix, TRUE, TRUE, &gl_count);
+
+	while (tags->len < max_num && (ws_count > 0 || gl_count > 0))
+	{
+		TMTag **next;
+
+		/* merge the two name-sorted runs */
+		if (ws_count > 0 && gl_count > 0)
+			next = (strcmp((*ws_match)->name, (*gl_match)->name) <= 0) ? ws_match : gl_match;
+		else
+			next = (ws_count > 0) ? ws_match : gl_match;
+
+		if (next == ws_match)
+		{
+			ws_match++;
+			ws_count--;
+		}
+		else
+		{
+			gl_match++;
+			gl_count--;
+		}
+
+		if (! prefix_match_lang(*next, lang))
+			continue;
+		/* deduplicate by name - the merge emits equal names adjacently */
+		if (tags->len > 0 &&
+			strcmp(TM_TAG(tags->pdata[tags->len - 1])->name, (*next)->name) == 0)
+			continue;
+		g_ptr_array_add(tags, *next);
+	}
+	return tags;
+}
+
+
 /* scope can be NULL.
  * lang can be -1 */
 static guint
@@ -962,13 +1763,11 @@ find_scope_members_tags (const GPtrArray * all, GPtrArray * tags,
 }
 
 
-/* Returns all matching members tags found in given struct/union/class name.
- @param name Name of the struct/union/class.
- @param file_tags A GPtrArray of edited file TMTag pointers (for search speedup, can be NULL).
- @return A GPtrArray of TMTag pointers to struct/union/class members */
-const GPtrArray *
-tm_workspace_find_scope_members (const GPtrArray * file_tags, const char *name,
-								 gboolean search_global, gboolean no_definitions)
+/* Does the real work of tm_workspace_find_scope_members(): resolves the
+ typename and collects its member tags by scanning the tag arrays. */
+static const GPtrArray *
+find_scope_members (const GPtrArray * file_tags, const char *name,
+					gboolean search_global, gboolean no_definitions)
 {
 	static GPtrArray *tags = NULL;
 	GPtrArray *local = NULL;
@@ -1104,6 +1903,64 @@ tm_workspace_find_scope_members (const GPtrArray * file_tags, const char *name,
 }
 
 
+/* Returns all matching members tags found in given struct/union/class name.
+ Results are memoized per lookup key and reused until the workspace tags
+ change, so repeated member completion on the same type is a hash lookup.
+ @param name Name of the struct/union/class.
+ @param file_tags A GPtrArray of edited file TMTag pointers (for search speedup, can be NULL).
+ @return A GPtrArray of TMTag pointers to struct/union/class members. The
+ array is owned by the workspace and only valid until the next call. */
+const GPtrArray *
+tm_workspace_find_scope_members (const GPtrArray * file_tags, const char *name,
+								 gboolean search_global, gboolean no_definitions)
+{
+	TMScopeCacheEntry *entry;
+	const GPtrArray *result;
+	gchar *key;
+	guint i;
+
+	g_return_val_if_fail ((theWorkspace && name && name[0] != '\0'), NULL);
+
+	if (!scope_member_cache)
+		scope_member_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+			g_free, scope_cache_entry_free);
+
+	/* file_tags points at the (stable) tag array of the edited file; its
+	 * content changes bump the generation, so the pointer is a safe key part */
+	key = g_strdup_printf ("%p|%d%d|%s", (gconstpointer) file_tags,
+		search_global != FALSE, no_definitions != FALSE, name);
+	entry = g_hash_table_lookup (scope_member_cache, key);
+	if (entry && entry->generation == workspace_generation)
+	{
+		g_free (key);
+		return entry->tags->len > 0 ? entry->tags : NULL;
+	}
+
+	result = find_scope_members (file_tags, name, search_global, no_definitions);
+
+	if (entry == NULL)
+	{
+		entry = g_new0 (TMScopeCacheEntry, 1);
+		entry->tags = g_ptr_array_new ();
+		g_hash_table_insert (scope_member_cache, key, entry);
+	}
+	else
+	{
+		/* refresh the stale entry in place */
+		g_free (key);
+		g_ptr_array_set_size (entry->tags, 0);
+	}
+	entry->generation = workspace_generation;
+	if (result)
+	{
+		for (i = 0; i < result->len; ++i)
+			g_ptr_array_add (entry->tags, result->pdata[i]);
+	}
+
+	return result;
+}
+
+
 #ifdef TM_DEBUG
 
 /* Dumps the workspace tree - useful for debugging */
@@ -49,14 +49,38 @@ void tm_workspace_remove_source_files(GPtrArray *source_files);
 
 const TMWorkspace *tm_get_workspace(void);
 
+/* An immutable, refcounted copy of the workspace tag arrays. The workspace mutates
+ its arrays in place on the main thread, so worker threads must read tags through a
+ snapshot instead. Each array entry holds a tag reference, keeping the snapshot
+ valid even when the files owning the tags are reparsed or removed meanwhile. */
+typedef struct
+{
+	GPtrArray *tags_array; /* sorted tags from all source files */
+	GPtrArray *typename_array; /* typename tags for syntax highlighting */
+	GPtrArray *global_tags; /* global tags */
+	guint generation; /* workspace generation the snapshot was taken at */
+	volatile gint refcount;
+} TMWorkspaceSnapshot;
+
+TMWorkspaceSnapshot *tm_workspace_snapshot(void);
+
+void tm_workspace_snapshot_unref(TMWorkspaceSnapshot *snapshot);
+
 gboolean tm_workspace_load_global_tags(const char *tags_file, gint mode);
 
+gboolean tm_workspace_refresh_global_tags(void);
+
+gboolean tm_workspace_compile_global_tags(const char *tags_file, const char *compiled_file,
+	gint mode);
+
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
 	int includes_count, const char *tags_file, int lang);
 
 const GPtrArray *tm_workspace_find(const char *name, TMTagType type, TMTagAttrType *attrs,
 	gboolean partial, langType lang);
 
+const GPtrArray *tm_workspace_find_prefix(const char *prefix, langType lang, guint max_num);
+
 const GPtrArray *
 tm_workspace_find_scoped (const char *name, const char *scope, TMTagType type,
 	TMTagAttrType *attrs, gboolean partial, langType lang, gboolean global_search);
@@ -68,9 +92,16 @@ const GPtrArray *tm_workspace_find_scope_members(const GPtrArray *file_tags,
 
 void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file);
 
+void tm_workspace_merge_file_tags(TMSourceFile *source_file);
+
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size);
 
+typedef void (*TMSourceFileParsedFunc) (TMSourceFile *source_file, gpointer user_data);
+
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file, guchar *text_buf,
+	gsize buf_size, TMSourceFileParsedFunc parsed_func, gpointer user_data);
+
 void tm_workspace_free(void);
 
 